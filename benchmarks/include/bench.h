@@ -0,0 +1,68 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * @file bench.h
+ * @brief Benchmarks entry points and result reporting.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/fatal.h>
+
+#include <astarte_device_sdk/result.h>
+
+#define CHECK_HALT(expr, ...)                                                                      \
+    if (expr) {                                                                                    \
+        LOG_ERR(__VA_ARGS__); /* NOLINT */                                                         \
+        k_fatal_halt(-1);                                                                          \
+    }
+
+#define CHECK_ASTARTE_OK_HALT(expr, ...) CHECK_HALT(expr != ASTARTE_RESULT_OK, __VA_ARGS__)
+
+/**
+ * @brief Report the rate of a throughput benchmark.
+ *
+ * @details Prints a single line prefixed by BENCHMARK_RESULT and followed by a JSON object, parsed
+ * by the pytest harness.
+ *
+ * @param[in] name Name of the benchmark.
+ * @param[in] messages Number of messages transmitted or received.
+ * @param[in] elapsed_us Time taken by the benchmark in microseconds.
+ */
+void bench_report_rate(const char *name, size_t messages, uint64_t elapsed_us);
+
+/**
+ * @brief Report the distribution of the samples of a latency benchmark.
+ *
+ * @details Prints a single line prefixed by BENCHMARK_RESULT and followed by a JSON object, parsed
+ * by the pytest harness. The samples are sorted in place.
+ *
+ * @param[in] name Name of the benchmark.
+ * @param[in] unit Unit of measure of the samples.
+ * @param[inout] samples Array of samples.
+ * @param[in] samples_len Number of elements of @p samples.
+ */
+void bench_report_latency(
+    const char *name, const char *unit, uint32_t *samples, size_t samples_len);
+
+/** @brief Measure the send rate of individuals, objects and properties at each QoS. */
+void bench_tx_run(void);
+
+/** @brief Measure the dispatch rate of the server datastreams published by the broker stand-in. */
+void bench_rx_run(void);
+
+/** @brief Measure the handshake time without and with cached device properties. */
+void bench_handshake_run(void);
+
+/** @brief Measure the latency of the key-value storage operations. */
+void bench_kv_run(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,55 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BENCH_DEVICE_H
+#define BENCH_DEVICE_H
+
+/**
+ * @file bench_device.h
+ * @brief Astarte device shared by the benchmarks.
+ */
+
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+#include <astarte_device_sdk/device.h>
+
+/**
+ * @brief Create a device with a new random device ID, connect it and poll it from a dedicated
+ * thread.
+ *
+ * @details Each device performs the full Astarte handshake, as the broker stand-in never has a
+ * session for a new device ID. Only one device can be started at a time.
+ *
+ * @param[in] individual_cbk Callback for the server individual datastreams, can be NULL.
+ * @param[out] connect_us Time from the connection request to the connection callback.
+ * @return The handle to the connected device.
+ */
+astarte_device_handle_t bench_device_start(
+    astarte_device_datastream_individual_cbk_t individual_cbk, uint64_t *connect_us);
+
+/**
+ * @brief Get the device ID of the started device.
+ *
+ * @return The device ID, valid until the device is stopped.
+ */
+const char *bench_device_get_id(void);
+
+/**
+ * @brief Wait until at most @p max MQTT messages are waiting for an acknowledgment.
+ *
+ * @param[in] max Maximum number of in flight messages.
+ * @param[in] timeout Maximum time to wait, the benchmarks halt when it expires.
+ */
+void bench_device_wait_in_flight(int32_t max, k_timeout_t timeout);
+
+/**
+ * @brief Stop polling, disconnect and destroy the started device.
+ */
+void bench_device_stop(void);
+
+#endif /* BENCH_DEVICE_H */
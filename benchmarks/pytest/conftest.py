@@ -0,0 +1,25 @@
+# (C) Copyright 2024, SECO Mind Srl
+#
+# SPDX-License-Identifier: Apache-2.0
+
+from cfgvalues import CfgValues
+from standin import BrokerStandIn
+
+import pytest
+from twister_harness import DeviceAdapter
+
+
+@pytest.fixture(scope="session")
+def benchmark_cfg(unlaunched_dut: DeviceAdapter):
+    # Load kconfig configured settings from the build directory
+    CONFIG_FILE = unlaunched_dut.device_config.build_dir.joinpath("zephyr", ".config")
+
+    return CfgValues(CONFIG_FILE)
+
+
+@pytest.fixture(scope="session")
+def broker_standin(benchmark_cfg: CfgValues):
+    standin = BrokerStandIn(realm=benchmark_cfg.realm, host=benchmark_cfg.hostname)
+    standin.start()
+    yield standin
+    standin.stop()
@@ -0,0 +1,212 @@
+# (C) Copyright 2024, SECO Mind Srl
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""
+Local stand-in for the Astarte pairing APIs and MQTT broker.
+
+The pairing APIs are served over plain HTTP, the device certificates are signed by a throwaway
+certification authority and the MQTT broker is a mosquitto instance requiring the signed client
+certificates, as done by Astarte.
+"""
+
+import datetime
+import json
+import shutil
+import subprocess
+import tempfile
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+
+from cryptography import x509
+from cryptography.hazmat.primitives import hashes, serialization
+from cryptography.hazmat.primitives.asymmetric import ec
+from cryptography.x509.oid import NameOID
+from west import log
+
+CERT_VALIDITY = datetime.timedelta(days=1)
+
+
+class Certificates:
+    """Throwaway certification authority signing the broker and the devices certificates."""
+
+    def __init__(self, host: str) -> None:
+        self.ca_key = ec.generate_private_key(ec.SECP256R1())
+        ca_name = x509.Name([x509.NameAttribute(NameOID.COMMON_NAME, "Benchmark stand-in CA")])
+        self.ca_cert = self._sign(
+            x509.CertificateBuilder()
+            .subject_name(ca_name)
+            .public_key(self.ca_key.public_key())
+            .add_extension(x509.BasicConstraints(ca=True, path_length=None), critical=True)
+        )
+
+        self.server_key = ec.generate_private_key(ec.SECP256R1())
+        self.server_cert = self._sign(
+            x509.CertificateBuilder()
+            .subject_name(x509.Name([x509.NameAttribute(NameOID.COMMON_NAME, host)]))
+            .public_key(self.server_key.public_key())
+        )
+
+    def sign_csr(self, csr_pem: str, common_name: str) -> str:
+        csr = x509.load_pem_x509_csr(csr_pem.encode())
+        cert = self._sign(
+            x509.CertificateBuilder()
+            .subject_name(x509.Name([x509.NameAttribute(NameOID.COMMON_NAME, common_name)]))
+            .public_key(csr.public_key())
+        )
+        return cert.public_bytes(serialization.Encoding.PEM).decode()
+
+    def write(self, directory: Path) -> None:
+        (directory / "ca.crt").write_bytes(self.ca_cert.public_bytes(serialization.Encoding.PEM))
+        (directory / "server.crt").write_bytes(
+            self.server_cert.public_bytes(serialization.Encoding.PEM)
+        )
+        (directory / "server.key").write_bytes(
+            self.server_key.private_bytes(
+                serialization.Encoding.PEM,
+                serialization.PrivateFormat.TraditionalOpenSSL,
+                serialization.NoEncryption(),
+            )
+        )
+
+    def _sign(self, builder: x509.CertificateBuilder) -> x509.Certificate:
+        now = datetime.datetime.now(datetime.timezone.utc)
+        issuer = x509.Name([x509.NameAttribute(NameOID.COMMON_NAME, "Benchmark stand-in CA")])
+        return (
+            builder.issuer_name(issuer)
+            .serial_number(x509.random_serial_number())
+            .not_valid_before(now - datetime.timedelta(minutes=5))
+            .not_valid_after(now + CERT_VALIDITY)
+            .sign(self.ca_key, hashes.SHA256())
+        )
+
+
+def _pairing_handler(realm: str, broker_url: str, certificates: Certificates):
+    prefix = f"/pairing/v1/{realm}/devices/"
+    credentials_suffix = "/protocols/astarte_mqtt_v1/credentials"
+    verify_suffix = credentials_suffix + "/verify"
+
+    class PairingHandler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            if not self.path.startswith(prefix):
+                return self._reply(404, {"errors": {"detail": "Not found"}})
+            protocols = {"astarte_mqtt_v1": {"broker_url": broker_url}}
+            return self._reply(200, {"data": {"protocols": protocols}})
+
+        def do_POST(self):
+            if not self.path.startswith(prefix):
+                return self._reply(404, {"errors": {"detail": "Not found"}})
+            device_id = self.path[len(prefix) :].split("/")[0]
+            body = json.loads(self.rfile.read(int(self.headers.get("Content-Length", 0))))
+
+            if self.path.endswith(verify_suffix):
+                now = datetime.datetime.now(datetime.timezone.utc)
+                return self._reply(
+                    200,
+                    {
+                        "data": {
+                            "valid": True,
+                            "timestamp": now.isoformat(),
+                            "until": (now + CERT_VALIDITY).isoformat(),
+                        }
+                    },
+                )
+            if self.path.endswith(credentials_suffix):
+                client_crt = certificates.sign_csr(body["data"]["csr"], f"{realm}/{device_id}")
+                return self._reply(201, {"data": {"client_crt": client_crt}})
+            return self._reply(404, {"errors": {"detail": "Not found"}})
+
+        def log_message(self, format, *args):
+            # Keep the test output readable, the device logs the failed requests
+            pass
+
+        def _reply(self, status: int, payload: dict):
+            # The device parses the responses with fixed size buffers, keep them compact
+            body = json.dumps(payload, separators=(",", ":")).encode()
+            self.send_response(status)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+    return PairingHandler
+
+
+class BrokerStandIn:
+    """
+    Pairing APIs and MQTT broker stand-in, listening on the host side of the native_sim ethernet
+    interface set up by the Zephyr net-setup script.
+    """
+
+    def __init__(
+        self,
+        realm: str,
+        host: str,
+        http_port: int = 80,
+        mqtts_port: int = 8883,
+        local_mqtt_port: int = 1883,
+    ) -> None:
+        self.realm = realm
+        self.host = host
+        self.http_port = http_port
+        self.mqtts_port = mqtts_port
+        self.local_mqtt_port = local_mqtt_port
+        self._tmpdir = None
+        self._mosquitto = None
+        self._http_server = None
+        self._http_thread = None
+
+    def start(self) -> None:
+        mosquitto = shutil.which("mosquitto")
+        if mosquitto is None:
+            raise RuntimeError("The benchmarks require the mosquitto broker in the PATH")
+
+        self._tmpdir = tempfile.TemporaryDirectory(prefix="astarte-benchmark-")
+        directory = Path(self._tmpdir.name)
+        certificates = Certificates(self.host)
+        certificates.write(directory)
+
+        config = directory / "mosquitto.conf"
+        config.write_text(
+            "\n".join(
+                [
+                    "per_listener_settings true",
+                    # Plain listener used by the harness to publish the server data
+                    f"listener {self.local_mqtt_port} 127.0.0.1",
+                    "allow_anonymous true",
+                    # Listener used by the device, authenticated with its client certificate
+                    f"listener {self.mqtts_port} {self.host}",
+                    "allow_anonymous true",
+                    f"cafile {directory / 'ca.crt'}",
+                    f"certfile {directory / 'server.crt'}",
+                    f"keyfile {directory / 'server.key'}",
+                    "require_certificate true",
+                    "max_inflight_messages 0",
+                    "max_queued_messages 0",
+                    "",
+                ]
+            )
+        )
+        log.inf(f"Starting mosquitto on {self.host}:{self.mqtts_port}")
+        self._mosquitto = subprocess.Popen(
+            [mosquitto, "-c", str(config)], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+        )
+
+        broker_url = f"mqtts://{self.host}:{self.mqtts_port}/"
+        handler = _pairing_handler(self.realm, broker_url, certificates)
+        log.inf(f"Starting the pairing APIs on {self.host}:{self.http_port}")
+        self._http_server = ThreadingHTTPServer((self.host, self.http_port), handler)
+        self._http_thread = threading.Thread(target=self._http_server.serve_forever, daemon=True)
+        self._http_thread.start()
+
+    def stop(self) -> None:
+        if self._http_server is not None:
+            self._http_server.shutdown()
+            self._http_server.server_close()
+            self._http_thread.join()
+        if self._mosquitto is not None:
+            self._mosquitto.terminate()
+            self._mosquitto.wait(timeout=10)
+        if self._tmpdir is not None:
+            self._tmpdir.cleanup()
@@ -0,0 +1,63 @@
+# (C) Copyright 2024, SECO Mind Srl
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import json
+import re
+
+import bson
+import paho.mqtt.publish as publish
+from west import log
+from twister_harness import DeviceAdapter
+
+from cfgvalues import CfgValues
+from standin import BrokerStandIn
+
+RESULT_PREFIX = "BENCHMARK_RESULT "
+RX_READY_REGEX = r"Benchmark RX ready \(device (?P<device_id>\S+)\)"
+RX_INTERFACE = "org.astarte-platform.zephyr.benchmark.ServerDatastream"
+RESULTS_FILE = "benchmark_results.json"
+STAGE_TIMEOUT_S = 300
+
+
+def collect_results(lines: list[str], results: list[dict]):
+    for line in lines:
+        index = line.find(RESULT_PREFIX)
+        if index >= 0:
+            result = json.loads(line[index + len(RESULT_PREFIX) :])
+            log.inf(f"Benchmark result: {result}")
+            results.append(result)
+
+
+def publish_rx_messages(standin: BrokerStandIn, cfg: CfgValues, device_id: str):
+    topic = f"{cfg.realm}/{device_id}/{RX_INTERFACE}/sensor/value"
+    messages = [
+        {"topic": topic, "payload": bson.dumps({"v": float(i)}), "qos": 0}
+        for i in range(cfg.rx_messages)
+    ]
+    log.inf(f"Publishing {len(messages)} messages on {topic}")
+    publish.multiple(messages, hostname="127.0.0.1", port=standin.local_mqtt_port)
+
+
+def test_benchmarks(
+    unlaunched_dut: DeviceAdapter, benchmark_cfg: CfgValues, broker_standin: BrokerStandIn
+):
+    results: list[dict] = []
+
+    log.inf("Launching the benchmarks")
+    unlaunched_dut.launch()
+
+    lines = unlaunched_dut.readlines_until(regex=RX_READY_REGEX, timeout=STAGE_TIMEOUT_S)
+    collect_results(lines, results)
+    match = re.search(RX_READY_REGEX, lines[-1])
+    assert match is not None, "Missing device ID of the reception benchmark"
+    publish_rx_messages(broker_standin, benchmark_cfg, match.group("device_id"))
+
+    lines = unlaunched_dut.readlines_until(regex="Benchmarks completed", timeout=STAGE_TIMEOUT_S)
+    collect_results(lines, results)
+
+    results_path = unlaunched_dut.device_config.build_dir.joinpath(RESULTS_FILE)
+    results_path.write_text(json.dumps({"results": results}, indent=2))
+    log.inf(f"Benchmark results written to {results_path}")
+
+    assert results, "No benchmark result received from the device"
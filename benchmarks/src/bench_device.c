@@ -0,0 +1,163 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench_device.h"
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include <astarte_device_sdk/device_id.h>
+#include <astarte_device_sdk/metrics.h>
+
+#include "bench.h"
+#include "host_clock.h"
+
+#include "astarte_generated_interfaces.h"
+
+LOG_MODULE_REGISTER(bench_device, CONFIG_BENCHMARK_LOG_LEVEL); // NOLINT
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+#define CONNECTION_TIMEOUT K_SECONDS(30)
+#define IN_FLIGHT_POLL_PERIOD K_USEC(100)
+
+K_THREAD_STACK_DEFINE(device_thread_stack_area, CONFIG_DEVICE_THREAD_STACK_SIZE);
+static struct k_thread device_thread_data;
+
+enum bench_thread_flags
+{
+    THREAD_TERMINATION_FLAG = 0,
+};
+static atomic_t device_thread_flags;
+
+static K_SEM_DEFINE(connection_sem, 0, 1);
+static uint64_t connect_start_us;
+static uint64_t connect_end_us;
+
+static const astarte_interface_t *interfaces[] = {
+    &org_astarte_platform_zephyr_benchmark_DeviceAggregateQos0,
+    &org_astarte_platform_zephyr_benchmark_DeviceAggregateQos1,
+    &org_astarte_platform_zephyr_benchmark_DeviceAggregateQos2,
+    &org_astarte_platform_zephyr_benchmark_DeviceDatastreamQos0,
+    &org_astarte_platform_zephyr_benchmark_DeviceDatastreamQos1,
+    &org_astarte_platform_zephyr_benchmark_DeviceDatastreamQos2,
+    &org_astarte_platform_zephyr_benchmark_DeviceProperty,
+    &org_astarte_platform_zephyr_benchmark_ServerDatastream,
+};
+
+static char device_id[ASTARTE_DEVICE_ID_LEN + 1];
+static astarte_device_handle_t device_handle;
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static void device_thread_entry_point(void *device_handle, void *unused1, void *unused2);
+static void connection_callback(astarte_device_connection_event_t event);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+astarte_device_handle_t bench_device_start(
+    astarte_device_datastream_individual_cbk_t individual_cbk, uint64_t *connect_us)
+{
+    CHECK_HALT(device_handle, "A benchmark device is already running.");
+    CHECK_ASTARTE_OK_HALT(
+        astarte_device_id_generate_random(device_id), "Device ID generation failure.");
+
+    astarte_device_config_t config = {
+        .http_timeout_ms = CONFIG_HTTP_TIMEOUT_MS,
+        .mqtt_connection_timeout_ms = CONFIG_MQTT_CONNECTION_TIMEOUT_MS,
+        .mqtt_poll_timeout_ms = CONFIG_MQTT_POLL_TIMEOUT_MS,
+        .cred_secr = CONFIG_CREDENTIAL_SECRET,
+        .connection_cbk = connection_callback,
+        .datastream_individual_cbk = individual_cbk,
+        .interfaces = interfaces,
+        .interfaces_size = ARRAY_SIZE(interfaces),
+    };
+    memcpy(config.device_id, device_id, sizeof(device_id));
+
+    CHECK_ASTARTE_OK_HALT(
+        astarte_device_new(&config, &device_handle), "Astarte device creation failure.");
+
+    LOG_INF("Connecting device %s.", device_id); // NOLINT
+    k_sem_reset(&connection_sem);
+    atomic_clear_bit(&device_thread_flags, THREAD_TERMINATION_FLAG);
+    k_thread_create(&device_thread_data, device_thread_stack_area,
+        K_THREAD_STACK_SIZEOF(device_thread_stack_area), device_thread_entry_point, device_handle,
+        NULL, NULL, CONFIG_DEVICE_THREAD_PRIORITY, 0, K_NO_WAIT);
+
+    CHECK_HALT(k_sem_take(&connection_sem, CONNECTION_TIMEOUT) != 0,
+        "Timed out while waiting for the device connection.");
+    if (connect_us) {
+        *connect_us = connect_end_us - connect_start_us;
+    }
+    return device_handle;
+}
+
+const char *bench_device_get_id(void)
+{
+    return device_id;
+}
+
+void bench_device_wait_in_flight(int32_t max, k_timeout_t timeout)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(timeout);
+    while (astarte_metrics_get_gauge(ASTARTE_METRICS_GAUGE_IN_FLIGHT) > max) {
+        CHECK_HALT(sys_timepoint_expired(timepoint),
+            "Timed out while waiting for the in flight messages to be acknowledged.");
+        k_sleep(IN_FLIGHT_POLL_PERIOD);
+    }
+}
+
+void bench_device_stop(void)
+{
+    atomic_set_bit(&device_thread_flags, THREAD_TERMINATION_FLAG);
+    CHECK_HALT(k_thread_join(&device_thread_data, K_FOREVER) != 0,
+        "Failed while waiting for the device polling thread to terminate.");
+    CHECK_ASTARTE_OK_HALT(
+        astarte_device_destroy(device_handle), "Astarte device destruction failure.");
+    device_handle = NULL;
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static void device_thread_entry_point(void *device_handle, void *unused1, void *unused2)
+{
+    ARG_UNUSED(unused1);
+    ARG_UNUSED(unused2);
+
+    astarte_device_handle_t device = (astarte_device_handle_t) device_handle;
+
+    connect_start_us = astarte_host_clock_get_us();
+    CHECK_ASTARTE_OK_HALT(astarte_device_connect(device), "Astarte device connection failure.");
+
+    // The poll blocks on the socket for at most CONFIG_MQTT_POLL_TIMEOUT_MS, no sleep is needed
+    while (!atomic_test_bit(&device_thread_flags, THREAD_TERMINATION_FLAG)) {
+        astarte_result_t res = astarte_device_poll(device);
+        CHECK_HALT(res != ASTARTE_RESULT_TIMEOUT && res != ASTARTE_RESULT_OK,
+            "Astarte device poll failure.");
+    }
+
+    CHECK_ASTARTE_OK_HALT(
+        astarte_device_disconnect(device, K_SECONDS(10)), "Astarte device disconnection failure.");
+}
+
+static void connection_callback(astarte_device_connection_event_t event)
+{
+    ARG_UNUSED(event);
+    connect_end_us = astarte_host_clock_get_us();
+    k_sem_give(&connection_sem);
+}
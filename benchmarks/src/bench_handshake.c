@@ -0,0 +1,107 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <astarte_device_sdk/data.h>
+#include <astarte_device_sdk/device.h>
+
+#include "bench_device.h"
+#include "host_clock.h"
+
+#include "astarte_generated_interfaces.h"
+
+LOG_MODULE_REGISTER(bench_handshake, CONFIG_BENCHMARK_LOG_LEVEL); // NOLINT
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+#define ACK_TIMEOUT K_SECONDS(60)
+#define PROPERTY_PATH_FORMAT "/sensor%d/value"
+#define PROPERTY_PATH_SIZE 32
+#define BENCHMARK_NAME_SIZE 64
+
+static uint32_t connect_samples[CONFIG_BENCHMARK_HANDSHAKE_ITERATIONS];
+static uint32_t sync_samples[CONFIG_BENCHMARK_HANDSHAKE_ITERATIONS];
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static void run_handshakes(int properties);
+static void set_properties(bool set);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+void bench_handshake_run(void)
+{
+    run_handshakes(0);
+
+    set_properties(true);
+    run_handshakes(CONFIG_BENCHMARK_HANDSHAKE_PROPERTIES);
+    set_properties(false);
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static void run_handshakes(int properties)
+{
+    LOG_INF("Running handshakes with %d cached properties.", properties); // NOLINT
+
+    for (size_t i = 0; i < CONFIG_BENCHMARK_HANDSHAKE_ITERATIONS; i++) {
+        uint64_t connect_us = 0;
+        uint64_t start = astarte_host_clock_get_us();
+        bench_device_start(NULL, &connect_us);
+        // The cached properties are resent in background after the connection callback
+        bench_device_wait_in_flight(0, ACK_TIMEOUT);
+        uint64_t sync_us = astarte_host_clock_get_us() - start;
+        bench_device_stop();
+
+        connect_samples[i] = (uint32_t) (connect_us / USEC_PER_MSEC);
+        sync_samples[i] = (uint32_t) (sync_us / USEC_PER_MSEC);
+    }
+
+    char name[BENCHMARK_NAME_SIZE] = { 0 };
+    snprintf(name, sizeof(name), "handshake_connect_%d_properties", properties);
+    bench_report_latency(name, "ms", connect_samples, ARRAY_SIZE(connect_samples));
+    snprintf(name, sizeof(name), "handshake_sync_%d_properties", properties);
+    bench_report_latency(name, "ms", sync_samples, ARRAY_SIZE(sync_samples));
+}
+
+static void set_properties(bool set)
+{
+    // Properties are cached in the permanent storage independently of the device ID
+    astarte_device_handle_t device = bench_device_start(NULL, NULL);
+    const char *interface_name = org_astarte_platform_zephyr_benchmark_DeviceProperty.name;
+
+    for (int i = 0; i < CONFIG_BENCHMARK_HANDSHAKE_PROPERTIES; i++) {
+        char path[PROPERTY_PATH_SIZE] = { 0 };
+        snprintf(path, sizeof(path), PROPERTY_PATH_FORMAT, i);
+
+        bench_device_wait_in_flight(CONFIG_BENCHMARK_TX_WINDOW - 1, ACK_TIMEOUT);
+        if (set) {
+            CHECK_ASTARTE_OK_HALT(astarte_device_set_property(
+                                      device, interface_name, path, astarte_data_from_integer(i)),
+                "Property set failure.");
+        } else {
+            CHECK_ASTARTE_OK_HALT(astarte_device_unset_property(device, interface_name, path),
+                "Property unset failure.");
+        }
+    }
+    bench_device_wait_in_flight(0, ACK_TIMEOUT);
+
+    bench_device_stop();
+}
@@ -0,0 +1,120 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+
+#include <zephyr/drivers/flash.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/storage/flash_map.h>
+
+#include "host_clock.h"
+#include "kv_storage.h"
+
+LOG_MODULE_REGISTER(bench_kv, CONFIG_BENCHMARK_LOG_LEVEL); // NOLINT
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+#define NVS_PARTITION benchmark_partition
+#define NVS_PARTITION_DEVICE FIXED_PARTITION_DEVICE(NVS_PARTITION)
+#define NVS_PARTITION_OFFSET FIXED_PARTITION_OFFSET(NVS_PARTITION)
+#define NVS_PARTITION_SIZE FIXED_PARTITION_SIZE(NVS_PARTITION)
+
+#define KV_NAMESPACE "benchmark"
+#define KEY_FORMAT "key%d"
+#define KEY_SIZE 16
+
+enum bench_kv_operation
+{
+    KV_INSERT = 0,
+    KV_UPDATE,
+    KV_FIND,
+    KV_DELETE,
+    KV_OPERATION_COUNT,
+};
+
+static const char *const operation_names[KV_OPERATION_COUNT] = {
+    [KV_INSERT] = "kv_insert",
+    [KV_UPDATE] = "kv_update",
+    [KV_FIND] = "kv_find",
+    [KV_DELETE] = "kv_delete",
+};
+
+static uint32_t samples[KV_OPERATION_COUNT][CONFIG_BENCHMARK_KV_OPERATIONS];
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static astarte_result_t run_operation(
+    astarte_kv_storage_t *kv_storage, enum bench_kv_operation operation, int index);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+void bench_kv_run(void)
+{
+    struct flash_pages_info fp_info = { 0 };
+    CHECK_HALT(!device_is_ready(NVS_PARTITION_DEVICE), "Flash device is not ready.");
+    CHECK_HALT(flash_get_page_info_by_offs(NVS_PARTITION_DEVICE, NVS_PARTITION_OFFSET, &fp_info),
+        "Can't get the flash page info.");
+
+    astarte_kv_storage_cfg_t config = {
+        .flash_device = NVS_PARTITION_DEVICE,
+        .flash_offset = NVS_PARTITION_OFFSET,
+        .flash_sector_size = fp_info.size,
+        .flash_sector_count = NVS_PARTITION_SIZE / fp_info.size,
+    };
+    astarte_kv_storage_t kv_storage = { 0 };
+    CHECK_ASTARTE_OK_HALT(astarte_kv_storage_new(config, KV_NAMESPACE, &kv_storage),
+        "Key-value storage creation failure.");
+
+    // Each operation runs on all the keys before the next one, as they depend on each other
+    for (int operation = 0; operation < KV_OPERATION_COUNT; operation++) {
+        LOG_INF("Running %s.", operation_names[operation]); // NOLINT
+        for (int i = 0; i < CONFIG_BENCHMARK_KV_OPERATIONS; i++) {
+            uint64_t start = astarte_host_clock_get_us();
+            astarte_result_t ares = run_operation(&kv_storage, operation, i);
+            uint64_t elapsed_us = astarte_host_clock_get_us() - start;
+            CHECK_ASTARTE_OK_HALT(ares, "Failure in %s.", operation_names[operation]);
+            samples[operation][i] = (uint32_t) elapsed_us;
+        }
+        bench_report_latency(
+            operation_names[operation], "us", samples[operation], ARRAY_SIZE(samples[operation]));
+    }
+
+    astarte_kv_storage_destroy(kv_storage);
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static astarte_result_t run_operation(
+    astarte_kv_storage_t *kv_storage, enum bench_kv_operation operation, int index)
+{
+    char key[KEY_SIZE] = { 0 };
+    snprintf(key, sizeof(key), KEY_FORMAT, index);
+    uint32_t value = (operation == KV_UPDATE) ? ~index : index;
+    size_t value_size = sizeof(value);
+
+    switch (operation) {
+        case KV_INSERT:
+        case KV_UPDATE:
+            return astarte_kv_storage_insert(kv_storage, key, &value, value_size);
+        case KV_FIND:
+            return astarte_kv_storage_find(kv_storage, key, &value, &value_size);
+        case KV_DELETE:
+            return astarte_kv_storage_delete(kv_storage, key);
+        default:
+            return ASTARTE_RESULT_INTERNAL_ERROR;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include <zephyr/sys/printk.h>
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+#define RESULT_PREFIX "BENCHMARK_RESULT "
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static int compare_samples(const void *left, const void *right);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+void bench_report_rate(const char *name, size_t messages, uint64_t elapsed_us)
+{
+    uint64_t rate = (elapsed_us == 0) ? 0 : (messages * USEC_PER_SEC) / elapsed_us;
+    // Printed with printk to not be dropped or reordered by the deferred logging
+    printk(RESULT_PREFIX "{\"name\":\"%s\",\"type\":\"rate\",\"messages\":%zu,"
+                         "\"elapsed_us\":%llu,\"messages_per_s\":%llu}\n",
+        name, messages, (unsigned long long) elapsed_us, (unsigned long long) rate);
+}
+
+void bench_report_latency(
+    const char *name, const char *unit, uint32_t *samples, size_t samples_len)
+{
+    if (samples_len == 0) {
+        return;
+    }
+
+    qsort(samples, samples_len, sizeof(uint32_t), compare_samples);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < samples_len; i++) {
+        sum += samples[i];
+    }
+
+    printk(RESULT_PREFIX "{\"name\":\"%s\",\"type\":\"latency\",\"unit\":\"%s\",\"samples\":%zu,"
+                         "\"min\":%u,\"avg\":%llu,\"p50\":%u,\"p99\":%u,\"max\":%u}\n",
+        name, unit, samples_len, samples[0], (unsigned long long) (sum / samples_len),
+        samples[samples_len / 2], samples[(samples_len * 99) / 100], samples[samples_len - 1]);
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static int compare_samples(const void *left, const void *right)
+{
+    uint32_t left_sample = *(const uint32_t *) left;
+    uint32_t right_sample = *(const uint32_t *) right;
+    return (left_sample > right_sample) - (left_sample < right_sample);
+}
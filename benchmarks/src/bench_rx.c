@@ -0,0 +1,78 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#include <astarte_device_sdk/device.h>
+
+#include "bench_device.h"
+#include "host_clock.h"
+
+LOG_MODULE_REGISTER(bench_rx, CONFIG_BENCHMARK_LOG_LEVEL); // NOLINT
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+static K_SEM_DEFINE(rx_completed_sem, 0, 1);
+// Only accessed from the device polling thread until the semaphore is given
+static size_t rx_count;
+static uint64_t rx_first_us;
+static uint64_t rx_last_us;
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static void individual_callback(astarte_device_datastream_individual_event_t event);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+void bench_rx_run(void)
+{
+    rx_count = 0;
+    k_sem_reset(&rx_completed_sem);
+
+    bench_device_start(individual_callback, NULL);
+
+    // The pytest harness starts publishing when this line is printed
+    printk("Benchmark RX ready (device %s)\n", bench_device_get_id());
+
+    CHECK_HALT(k_sem_take(&rx_completed_sem, K_MSEC(CONFIG_BENCHMARK_RX_TIMEOUT_MS)) != 0,
+        "Timed out with %zu of %d messages received.", rx_count, CONFIG_BENCHMARK_RX_MESSAGES);
+
+    // Measured from the first to the last message, to exclude the startup of the publisher
+    uint64_t elapsed_us = rx_last_us - rx_first_us;
+    bench_report_rate("rx_individual", CONFIG_BENCHMARK_RX_MESSAGES - 1, elapsed_us);
+
+    bench_device_stop();
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static void individual_callback(astarte_device_datastream_individual_event_t event)
+{
+    ARG_UNUSED(event);
+
+    uint64_t now = astarte_host_clock_get_us();
+    if (rx_count == 0) {
+        rx_first_us = now;
+    }
+    rx_last_us = now;
+
+    rx_count++;
+    if (rx_count == CONFIG_BENCHMARK_RX_MESSAGES) {
+        k_sem_give(&rx_completed_sem);
+    }
+}
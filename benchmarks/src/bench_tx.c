@@ -0,0 +1,139 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+#include <astarte_device_sdk/data.h>
+#include <astarte_device_sdk/device.h>
+#include <astarte_device_sdk/object.h>
+
+#include "bench_device.h"
+#include "host_clock.h"
+
+#include "astarte_generated_interfaces.h"
+
+LOG_MODULE_REGISTER(bench_tx, CONFIG_BENCHMARK_LOG_LEVEL); // NOLINT
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+#define ACK_TIMEOUT K_SECONDS(30)
+#define SENSOR_PATH "/sensor"
+#define VALUE_PATH SENSOR_PATH "/value"
+
+typedef astarte_result_t (*bench_tx_send_t)(
+    astarte_device_handle_t device, const astarte_interface_t *interface, size_t index);
+
+typedef struct
+{
+    const char *name;
+    const astarte_interface_t *interface;
+    bench_tx_send_t send;
+} bench_tx_case_t;
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static astarte_result_t send_individual(
+    astarte_device_handle_t device, const astarte_interface_t *interface, size_t index);
+static astarte_result_t send_object(
+    astarte_device_handle_t device, const astarte_interface_t *interface, size_t index);
+static astarte_result_t set_property(
+    astarte_device_handle_t device, const astarte_interface_t *interface, size_t index);
+static void run_case(astarte_device_handle_t device, const bench_tx_case_t *bench_case);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+void bench_tx_run(void)
+{
+    const bench_tx_case_t cases[] = {
+        { "tx_individual_qos0", &org_astarte_platform_zephyr_benchmark_DeviceDatastreamQos0,
+            send_individual },
+        { "tx_individual_qos1", &org_astarte_platform_zephyr_benchmark_DeviceDatastreamQos1,
+            send_individual },
+        { "tx_individual_qos2", &org_astarte_platform_zephyr_benchmark_DeviceDatastreamQos2,
+            send_individual },
+        { "tx_object_qos0", &org_astarte_platform_zephyr_benchmark_DeviceAggregateQos0,
+            send_object },
+        { "tx_object_qos1", &org_astarte_platform_zephyr_benchmark_DeviceAggregateQos1,
+            send_object },
+        { "tx_object_qos2", &org_astarte_platform_zephyr_benchmark_DeviceAggregateQos2,
+            send_object },
+        { "tx_property", &org_astarte_platform_zephyr_benchmark_DeviceProperty, set_property },
+    };
+
+    astarte_device_handle_t device = bench_device_start(NULL, NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        run_case(device, &cases[i]);
+    }
+
+    // Do not leave the property in the cache, it would be sent during the handshake benchmark
+    const char *property_interface_name = org_astarte_platform_zephyr_benchmark_DeviceProperty.name;
+    CHECK_ASTARTE_OK_HALT(
+        astarte_device_unset_property(device, property_interface_name, VALUE_PATH),
+        "Property unset failure.");
+    bench_device_wait_in_flight(0, ACK_TIMEOUT);
+
+    bench_device_stop();
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static void run_case(astarte_device_handle_t device, const bench_tx_case_t *bench_case)
+{
+    LOG_INF("Running %s.", bench_case->name); // NOLINT
+
+    uint64_t start = astarte_host_clock_get_us();
+    for (size_t i = 0; i < CONFIG_BENCHMARK_TX_MESSAGES; i++) {
+        // QoS 1 and 2 messages are cached until acknowledged, keep the cache from filling up
+        bench_device_wait_in_flight(CONFIG_BENCHMARK_TX_WINDOW - 1, ACK_TIMEOUT);
+        CHECK_ASTARTE_OK_HALT(bench_case->send(device, bench_case->interface, i),
+            "Transmission failure in %s.", bench_case->name);
+    }
+    // The rate accounts for the acknowledgment of the last messages
+    bench_device_wait_in_flight(0, ACK_TIMEOUT);
+    uint64_t elapsed_us = astarte_host_clock_get_us() - start;
+
+    bench_report_rate(bench_case->name, CONFIG_BENCHMARK_TX_MESSAGES, elapsed_us);
+}
+
+static astarte_result_t send_individual(
+    astarte_device_handle_t device, const astarte_interface_t *interface, size_t index)
+{
+    return astarte_device_send_individual(
+        device, interface->name, VALUE_PATH, astarte_data_from_double((double) index), NULL);
+}
+
+static astarte_result_t send_object(
+    astarte_device_handle_t device, const astarte_interface_t *interface, size_t index)
+{
+    astarte_object_entry_t entries[] = {
+        astarte_object_entry_new("temperature", astarte_data_from_double((double) index)),
+        astarte_object_entry_new("humidity", astarte_data_from_double((double) index / 2)),
+        astarte_object_entry_new("label", astarte_data_from_string("benchmark")),
+    };
+    return astarte_device_send_object(
+        device, interface->name, SENSOR_PATH, entries, ARRAY_SIZE(entries), NULL);
+}
+
+static astarte_result_t set_property(
+    astarte_device_handle_t device, const astarte_interface_t *interface, size_t index)
+{
+    // Each value differs from the previous one, so that every set reaches the broker
+    return astarte_device_set_property(
+        device, interface->name, VALUE_PATH, astarte_data_from_integer((int32_t) index));
+}
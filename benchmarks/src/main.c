@@ -0,0 +1,107 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys_clock.h>
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <nsi_main.h>
+#endif
+
+#include <astarte_device_sdk/pairing.h>
+
+#include "eth.h"
+
+#include "bench.h"
+
+LOG_MODULE_REGISTER(main, CONFIG_APP_LOG_LEVEL); // NOLINT
+
+/************************************************
+ *       Checks over configuration values       *
+ ***********************************************/
+
+BUILD_ASSERT(CONFIG_ARCH_POSIX == 1, "The benchmarks need to run on the native_sim board");
+BUILD_ASSERT(sizeof(CONFIG_CREDENTIAL_SECRET) == ASTARTE_PAIRING_CRED_SECR_LEN + 1,
+    "Invalid credential secret for the benchmarks");
+BUILD_ASSERT(IS_ENABLED(CONFIG_ASTARTE_DEVICE_SDK_METRICS),
+    "The benchmarks track the in flight messages with the SDK metrics");
+BUILD_ASSERT(
+    CONFIG_BENCHMARK_TX_WINDOW <= CONFIG_ASTARTE_DEVICE_SDK_ADVANCED_MQTT_CACHING_HASMAPS_SIZE,
+    "The transmission window must fit in the MQTT messages cache");
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+K_THREAD_STACK_DEFINE(eth_thread_stack_area, 1024);
+static struct k_thread eth_thread_data;
+
+enum bench_thread_flags
+{
+    ETH_THREAD_TERMINATION_FLAG = 0,
+};
+static atomic_t eth_thread_flags;
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static void eth_thread_entry_point(void *unused1, void *unused2, void *unused3);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+int main(void)
+{
+    LOG_INF("Astarte device benchmarks"); // NOLINT
+
+    // Initialize Ethernet driver
+    LOG_INF("Initializing Ethernet driver."); // NOLINT
+    if (eth_connect() != 0) {
+        LOG_ERR("Connectivity intialization failed!"); // NOLINT
+        return -1;
+    }
+
+    k_thread_create(&eth_thread_data, eth_thread_stack_area,
+        K_THREAD_STACK_SIZEOF(eth_thread_stack_area), eth_thread_entry_point, NULL, NULL, NULL,
+        CONFIG_DEVICE_THREAD_PRIORITY, 0, K_NO_WAIT);
+
+    bench_kv_run();
+    bench_handshake_run();
+    bench_tx_run();
+    bench_rx_run();
+
+    atomic_set_bit(&eth_thread_flags, ETH_THREAD_TERMINATION_FLAG);
+    CHECK_HALT(k_thread_join(&eth_thread_data, K_FOREVER) != 0,
+        "Failed while waiting for the eth polling thread to terminate.");
+
+    // The pytest harness waits for this line
+    printk("Benchmarks completed\n");
+
+    // we know we are running on POSIX because it is checked at build time (view BUILD_ASSERT)
+    nsi_exit(0);
+    return 0;
+}
+
+static void eth_thread_entry_point(void *unused1, void *unused2, void *unused3)
+{
+    ARG_UNUSED(unused1);
+    ARG_UNUSED(unused2);
+    ARG_UNUSED(unused3);
+
+    while (!atomic_test_bit(&eth_thread_flags, ETH_THREAD_TERMINATION_FLAG)) {
+        k_timepoint_t timepoint = sys_timepoint_calc(K_MSEC(CONFIG_ETH_POLL_PERIOD_MS));
+
+        eth_poll();
+
+        k_sleep(sys_timepoint_timeout(timepoint));
+    }
+}
@@ -102,6 +102,19 @@ typedef void (*astarte_device_property_set_cbk_t)(astarte_device_property_set_ev
 /** @brief Function pointer for property unset events. */
 typedef void (*astarte_device_property_unset_cbk_t)(astarte_device_data_event_t event);
 
+/** @brief Context for a single chunk of a data message exceeding the maximum MQTT message size. */
+typedef struct
+{
+    astarte_device_data_event_t base_event; /**< Generic data event context */
+    size_t offset; /**< Offset of this chunk in the raw BSON payload of the message */
+    const void *chunk; /**< Chunk of the raw BSON payload of the message */
+    size_t chunk_len; /**< Size in bytes of this chunk */
+    size_t total_len; /**< Size in bytes of the complete raw BSON payload of the message */
+} astarte_device_data_chunk_event_t;
+
+/** @brief Function pointer for data chunk events. */
+typedef void (*astarte_device_data_chunk_cbk_t)(astarte_device_data_chunk_event_t event);
+
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
 /** @brief Context for a single property load event. */
 typedef struct
@@ -151,6 +164,13 @@ typedef struct
     astarte_device_property_set_cbk_t property_set_cbk;
     /** @brief Optional callback for a unset property event. */
     astarte_device_property_unset_cbk_t property_unset_cbk;
+    /** @brief Optional callback for data messages exceeding the maximum MQTT message size.
+     *
+     * @details When set, data messages with a payload larger than
+     * CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE are not discarded but delivered in order as
+     * chunks of raw BSON, without being validated or stored.
+     */
+    astarte_device_data_chunk_cbk_t data_chunk_cbk;
     /** @brief User data passed to each callback function. */
     void *cbk_user_data;
     /** @brief Array of interfaces to be added to the device. */
@@ -171,6 +191,9 @@ extern "C" {
  *
  * @note A device can be instantiated and connected to Astarte only if it has been previously
  * registered on Astarte.
+ * @note With CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION the instance is taken from a static pool
+ * of CONFIG_ASTARTE_DEVICE_SDK_STATIC_DEVICE_COUNT devices, ASTARTE_RESULT_OUT_OF_MEMORY is
+ * returned when all of them are in use.
  *
  * @param[in] cfg Configuration struct.
  * @param[out] device Device instance initialized.
@@ -248,6 +271,50 @@ astarte_result_t astarte_device_force_disconnect(astarte_device_handle_t device)
  */
 astarte_result_t astarte_device_poll(astarte_device_handle_t device);
 
+/**
+ * @brief Get the time left before the device has to be polled.
+ *
+ * @details Takes into account the connection and handshake state, the MQTT keep alive and the
+ * retransmission of pending messages. Incoming data on the device socket is not included, use
+ * #astarte_device_get_socket to wait for it.
+ * This function can be used to wait for device events together with other application events
+ * instead of calling #astarte_device_poll in a loop with a fixed timeout.
+ *
+ * @param[in] device Device instance to use for the operation.
+ * @return The time left before the next deadline, K_FOREVER if no deadline is present.
+ */
+k_timeout_t astarte_device_get_next_deadline(astarte_device_handle_t device);
+
+/**
+ * @brief Get the socket used by the device connection.
+ *
+ * @details The socket can be used with zsock_poll to wait for incoming data, #astarte_device_poll
+ * should be called when the socket is readable.
+ *
+ * @warning The socket should only be used for polling, never read from or write to it.
+ *
+ * @param[in] device Device instance to use for the operation.
+ * @return The socket file descriptor, or -1 if the device has no open connection.
+ */
+int astarte_device_get_socket(astarte_device_handle_t device);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+/**
+ * @brief Get the poll signal of the device.
+ *
+ * @details The signal is raised when the device requires to be polled, either because a
+ * connection or disconnection has been requested or because the next device deadline has expired.
+ * The signal is reset at each call to #astarte_device_poll.
+ * It can be used in a k_poll event of type K_POLL_TYPE_SIGNAL.
+ *
+ * @note Requires CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL.
+ *
+ * @param[in] device Device instance to use for the operation.
+ * @return The poll signal of the device, NULL if the device is invalid.
+ */
+struct k_poll_signal *astarte_device_get_poll_signal(astarte_device_handle_t device);
+#endif
+
 /**
  * @brief Send a value through the device connection.
  *
@@ -276,6 +343,25 @@ astarte_result_t astarte_device_send_object(astarte_device_handle_t device,
     const char *interface_name, const char *path, astarte_object_entry_t *entries,
     size_t entries_len, const int64_t *timestamp);
 
+/**
+ * @brief Send an aggregated object stored in the order of the interface mappings.
+ *
+ * @details Each value is serialized with the key of the mapping with the same index, no path is
+ * resolved against the interface mappings. This function is used by the typed send functions
+ * emitted by the `generate-interfaces` west command.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] interface Interface where to publish data, the same definition should have been
+ * added to the device introspection.
+ * @param[in] path Path where to publish data.
+ * @param[in] values The object values, one for each mapping of the @p interface.
+ * @param[in] timestamp Timestamp of the message, ignored if set to NULL.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_send_object_values(astarte_device_handle_t device,
+    const astarte_interface_t *interface, const char *path, const astarte_data_t *values,
+    const int64_t *timestamp);
+
 /**
  * @brief Set a device property to the provided value.
  *
@@ -299,6 +385,26 @@ astarte_result_t astarte_device_set_property(astarte_device_handle_t device,
 astarte_result_t astarte_device_unset_property(
     astarte_device_handle_t device, const char *interface_name, const char *path);
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+/**
+ * @brief Set the filter for the values sent on an individual datastream mapping.
+ *
+ * @details Replaces the filter of the mapping definition for this device. The filter applies to
+ * the values sent after this call, the state of each filtered path is kept.
+ *
+ * @note Requires CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] interface_name Name of an individual device owned datastream in the introspection.
+ * @param[in] endpoint Endpoint of the mapping, as in the interface definition.
+ * @param[in] filter Filter to set, copied by the device. NULL restores the filter of the mapping
+ * definition, while a zero initialized filter disables the filtering.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_set_mapping_filter(astarte_device_handle_t device,
+    const char *interface_name, const char *endpoint, const astarte_mapping_filter_t *filter);
+#endif
+
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
 /**
  * @brief Get a property value.
@@ -0,0 +1,160 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ASTARTE_DEVICE_SDK_HEAP_H
+#define ASTARTE_DEVICE_SDK_HEAP_H
+
+/**
+ * @file heap.h
+ * @brief Memory allocator and heap accounting for the Astarte device SDK.
+ */
+
+/**
+ * @defgroup heap Heap
+ * @brief Memory allocator and heap accounting for the Astarte device SDK.
+ * @details All the dynamic allocations performed by the SDK are routed through a single allocator.
+ * By default the allocator is backed by a dedicated heap of size
+ * CONFIG_ASTARTE_DEVICE_SDK_HEAP_SIZE, so that the SDK does not fragment the application heap and
+ * its memory usage is bounded. With CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION the allocator is
+ * instead backed by statically sized pools of fixed size blocks. The allocator can be replaced
+ * with a custom one using #astarte_heap_set_allocator.
+ * @ingroup astarte_device_sdk
+ * @{
+ */
+
+#include "astarte_device_sdk/astarte.h"
+#include "astarte_device_sdk/result.h"
+
+/** @brief SDK modules to which the allocated memory is attributed. */
+typedef enum
+{
+    /** @brief BSON serializer and deserializer */
+    ASTARTE_HEAP_MODULE_BSON = 0,
+    /** @brief Astarte data and deserialized data */
+    ASTARTE_HEAP_MODULE_DATA,
+    /** @brief Device instances */
+    ASTARTE_HEAP_MODULE_DEVICE,
+    /** @brief Device caching of properties and introspection */
+    ASTARTE_HEAP_MODULE_DEVICE_CACHING,
+    /** @brief Device client certificates */
+    ASTARTE_HEAP_MODULE_DEVICE_CLIENT_CRT,
+    /** @brief Device connection and handshake */
+    ASTARTE_HEAP_MODULE_DEVICE_CONNECTION,
+    /** @brief Device reception */
+    ASTARTE_HEAP_MODULE_DEVICE_RX,
+    /** @brief Device transmission */
+    ASTARTE_HEAP_MODULE_DEVICE_TX,
+    /** @brief Interfaces */
+    ASTARTE_HEAP_MODULE_INTERFACE,
+    /** @brief Device introspection */
+    ASTARTE_HEAP_MODULE_INTROSPECTION,
+    /** @brief Key-value storage */
+    ASTARTE_HEAP_MODULE_KV_STORAGE,
+    /** @brief MQTT client */
+    ASTARTE_HEAP_MODULE_MQTT,
+    /** @brief MQTT caching of in flight messages */
+    ASTARTE_HEAP_MODULE_MQTT_CACHING,
+    /** @brief Astarte objects */
+    ASTARTE_HEAP_MODULE_OBJECT,
+    /** @brief Filters of the individual datastreams */
+    ASTARTE_HEAP_MODULE_STREAM_FILTER,
+    /** @brief Compression and decompression of the purge properties messages */
+    ASTARTE_HEAP_MODULE_ZLIB,
+    /** @brief Number of modules, not a valid module */
+    ASTARTE_HEAP_MODULE_COUNT,
+} astarte_heap_module_t;
+
+/** @brief Memory usage of a single SDK module. */
+typedef struct
+{
+    /** @brief Bytes currently allocated by the module */
+    size_t live_bytes;
+    /** @brief Maximum value reached by @p live_bytes since the last reset */
+    size_t peak_bytes;
+} astarte_heap_module_stats_t;
+
+/**
+ * @brief Memory usage of the SDK.
+ *
+ * @details Byte counters account for the sizes requested by the SDK, excluding the bookkeeping
+ * overhead of the allocator.
+ */
+typedef struct
+{
+    /** @brief Bytes currently allocated by the SDK */
+    size_t live_bytes;
+    /** @brief Maximum value reached by @p live_bytes since the last reset */
+    size_t peak_bytes;
+    /** @brief Number of blocks currently allocated by the SDK */
+    size_t live_blocks;
+    /** @brief Number of allocations that failed because the allocator was out of memory */
+    size_t failed_allocations;
+    /** @brief Memory usage of each SDK module, indexed by #astarte_heap_module_t */
+    astarte_heap_module_stats_t modules[ASTARTE_HEAP_MODULE_COUNT];
+} astarte_heap_stats_t;
+
+/**
+ * @brief Custom allocator for the SDK.
+ *
+ * @details The allocation function should return NULL when it runs out of memory. Returned blocks
+ * should be aligned as the ones returned by malloc.
+ */
+typedef struct
+{
+    /** @brief Allocate a block of @p size bytes, returns NULL on failure */
+    void *(*alloc)(size_t size, void *user_data);
+    /** @brief Free a block previously returned by @p alloc */
+    void (*free)(void *ptr, void *user_data);
+    /** @brief User data passed to both @p alloc and @p free */
+    void *user_data;
+} astarte_heap_allocator_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Replace the allocator used by the SDK.
+ *
+ * @note The allocator can only be replaced while no memory is allocated by the SDK, usually
+ * before creating any device.
+ *
+ * @param[in] allocator Custom allocator to use, or NULL to restore the default one. The pointed
+ * struct is copied.
+ * @return ASTARTE_RESULT_OK on success, ASTARTE_RESULT_INVALID_PARAM if one of the allocator
+ * functions is missing, ASTARTE_RESULT_INVALID_CONFIGURATION if some memory is still allocated.
+ */
+astarte_result_t astarte_heap_set_allocator(const astarte_heap_allocator_t *allocator);
+
+/**
+ * @brief Get the memory usage of the SDK.
+ *
+ * @param[out] stats Memory usage statistics to fill.
+ */
+void astarte_heap_get_stats(astarte_heap_stats_t *stats);
+
+/**
+ * @brief Reset the peak counters to the current memory usage.
+ */
+void astarte_heap_reset_peak(void);
+
+/**
+ * @brief Get the name of an SDK module.
+ *
+ * @param[in] module Module for which to get the name.
+ * @return A string with the module name, "UNKNOWN" for invalid modules.
+ */
+const char *astarte_heap_module_to_name(astarte_heap_module_t module);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ASTARTE_DEVICE_SDK_HEAP_H */
@@ -79,6 +79,32 @@ typedef enum
     ASTARTE_MAPPING_RELIABILITY_UNIQUE = 2,
 } astarte_mapping_reliability_t;
 
+/**
+ * @brief Filter for the values sent on an individual datastream mapping.
+ *
+ * @details Each filter is disabled when set to zero. The filters are evaluated separately for each
+ * path matching the mapping, comparing the new value with the last one sent on the same path:
+ * - values within the deadbands from the last sent value are dropped, deadbands only apply to the
+ *   integer, longinteger and double types;
+ * - values received earlier than the minimum interval after the last sent value are dropped;
+ * - values exceeding the maximum rate are held, and the last held value is sent once the rate
+ *   allows it.
+ *
+ * @note Filters are only evaluated when CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS is enabled, and
+ * only for scalar mappings: binaryblob, string and array types are never filtered.
+ */
+typedef struct
+{
+    /** @brief Absolute deadband, values not differing more than this are dropped. */
+    double deadband_absolute;
+    /** @brief Relative deadband, as a fraction of the magnitude of the last sent value. */
+    double deadband_relative;
+    /** @brief Minimum interval in milliseconds between two sent values. */
+    uint32_t min_interval_ms;
+    /** @brief Maximum rate in values per second, the last value exceeding it is held. */
+    double max_rate;
+} astarte_mapping_filter_t;
+
 /**
  * @brief interface mapping definition
  *
@@ -105,6 +131,27 @@ typedef struct
     bool explicit_timestamp;
     /** @brief Allow unset flag */
     bool allow_unset;
+    /**
+     * @brief Number of segments in the mapping endpoint.
+     *
+     * @details Precomputed by the interfaces generator, zero when not available. Mappings with a
+     * different number of segments than a path are discarded without parsing the endpoint.
+     */
+    uint8_t endpoint_segments;
+    /**
+     * @brief Mask of the parametric segments of the mapping endpoint.
+     *
+     * @details Bit N is set when the segment N of the endpoint is a parameter. Precomputed by the
+     * interfaces generator, only meaningful when @ref endpoint_segments is not zero.
+     */
+    uint32_t endpoint_parameters;
+    /**
+     * @brief Filter for the values sent on the mapping, NULL to send all of them.
+     *
+     * @details Can be generated from the `x-zephyr-filter` field of the mapping in the interface
+     * JSON, and replaced at runtime with #astarte_device_set_mapping_filter.
+     */
+    const astarte_mapping_filter_t *filter;
 } astarte_mapping_t;
 
 /**
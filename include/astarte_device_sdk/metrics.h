@@ -0,0 +1,218 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ASTARTE_DEVICE_SDK_METRICS_H
+#define ASTARTE_DEVICE_SDK_METRICS_H
+
+/**
+ * @file metrics.h
+ * @brief Runtime metrics of the Astarte device SDK.
+ */
+
+/**
+ * @defgroup metrics Metrics
+ * @brief Runtime metrics of the Astarte device SDK.
+ * @details Counters, gauges and latency histograms collected by the SDK while running. Metrics
+ * are global to the SDK, when multiple devices are instantiated their values are aggregated.
+ * All the values are updated with atomic operations and wrap around on overflow.
+ * @note Requires CONFIG_ASTARTE_DEVICE_SDK_METRICS, when disabled the collection of the metrics
+ * is compiled out.
+ * @ingroup astarte_device_sdk
+ * @{
+ */
+
+#include "astarte_device_sdk/astarte.h"
+
+/** @brief Number of buckets of each latency histogram. */
+#define ASTARTE_METRICS_HISTOGRAM_BUCKETS 32
+
+/** @brief Monotonic counters collected by the SDK. */
+typedef enum
+{
+    /** @brief Data messages transmitted to Astarte */
+    ASTARTE_METRICS_COUNTER_MESSAGES_SENT = 0,
+    /** @brief Payload bytes of the data messages transmitted to Astarte */
+    ASTARTE_METRICS_COUNTER_BYTES_SENT,
+    /** @brief Data messages received from Astarte */
+    ASTARTE_METRICS_COUNTER_MESSAGES_RECEIVED,
+    /** @brief Payload bytes of the data messages received from Astarte */
+    ASTARTE_METRICS_COUNTER_BYTES_RECEIVED,
+    /** @brief MQTT publishes transmitted with QoS 0 */
+    ASTARTE_METRICS_COUNTER_PUBLISH_QOS0,
+    /** @brief MQTT publishes transmitted with QoS 1 */
+    ASTARTE_METRICS_COUNTER_PUBLISH_QOS1,
+    /** @brief MQTT publishes transmitted with QoS 2 */
+    ASTARTE_METRICS_COUNTER_PUBLISH_QOS2,
+    /** @brief MQTT messages retransmitted after their acknowledgment timed out */
+    ASTARTE_METRICS_COUNTER_RETRANSMISSIONS,
+    /** @brief MQTT messages dropped, either incoming discarded or outgoing lost */
+    ASTARTE_METRICS_COUNTER_DROPS,
+    /** @brief MQTT reconnection attempts after an unexpected disconnection */
+    ASTARTE_METRICS_COUNTER_RECONNECTS,
+    /** @brief Read operations on the key-value storage */
+    ASTARTE_METRICS_COUNTER_KV_STORAGE_READS,
+    /** @brief Write operations on the key-value storage */
+    ASTARTE_METRICS_COUNTER_KV_STORAGE_WRITES,
+    /** @brief Delete operations on the key-value storage */
+    ASTARTE_METRICS_COUNTER_KV_STORAGE_DELETES,
+    /** @brief Device property updates skipped as the property value was unchanged */
+    ASTARTE_METRICS_COUNTER_PROPERTIES_SUPPRESSED,
+    /** @brief Individual datastream values dropped by the mapping filters */
+    ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED,
+    /** @brief Number of counters, not a valid counter */
+    ASTARTE_METRICS_COUNTER_COUNT,
+} astarte_metrics_counter_t;
+
+/** @brief Gauges collected by the SDK. */
+typedef enum
+{
+    /** @brief MQTT messages, in both directions, waiting for an acknowledgment */
+    ASTARTE_METRICS_GAUGE_IN_FLIGHT = 0,
+    /** @brief Number of gauges, not a valid gauge */
+    ASTARTE_METRICS_GAUGE_COUNT,
+} astarte_metrics_gauge_t;
+
+/** @brief Latency histograms collected by the SDK. */
+typedef enum
+{
+    /** @brief Duration of the Astarte handshake, from the MQTT CONNACK to the device connection */
+    ASTARTE_METRICS_HISTOGRAM_HANDSHAKE = 0,
+    /** @brief Time spent in the MQTT poll, excluding the wait on the socket */
+    ASTARTE_METRICS_HISTOGRAM_MQTT_POLL,
+    /** @brief Duration of the key-value storage operations */
+    ASTARTE_METRICS_HISTOGRAM_KV_STORAGE,
+    /** @brief Duration of the BSON encoding of the transmitted data */
+    ASTARTE_METRICS_HISTOGRAM_BSON_ENCODE,
+    /** @brief Duration of the BSON decoding of the received data */
+    ASTARTE_METRICS_HISTOGRAM_BSON_DECODE,
+    /** @brief Number of histograms, not a valid histogram */
+    ASTARTE_METRICS_HISTOGRAM_COUNT,
+} astarte_metrics_histogram_t;
+
+/**
+ * @brief Snapshot of a latency histogram.
+ *
+ * @details Samples are in microseconds. Bucket zero counts the samples shorter than one
+ * microsecond, while bucket N counts the samples in the range [2^(N-1), 2^N) microseconds. The
+ * last bucket also counts all the longer samples.
+ */
+typedef struct
+{
+    /** @brief Number of recorded samples */
+    uint32_t count;
+    /** @brief Sum of the recorded samples in microseconds */
+    uint32_t sum_us;
+    /** @brief Longest recorded sample in microseconds */
+    uint32_t max_us;
+    /** @brief Number of samples in each bucket */
+    uint32_t buckets[ASTARTE_METRICS_HISTOGRAM_BUCKETS];
+} astarte_metrics_histogram_data_t;
+
+/** @brief Snapshot of the traffic of a single interface. */
+typedef struct
+{
+    /** @brief Interface name */
+    const char *name;
+    /** @brief Data messages transmitted on the interface */
+    uint32_t messages_sent;
+    /** @brief Payload bytes transmitted on the interface */
+    uint32_t bytes_sent;
+    /** @brief Data messages received on the interface */
+    uint32_t messages_received;
+    /** @brief Payload bytes received on the interface */
+    uint32_t bytes_received;
+} astarte_metrics_interface_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS)
+
+/**
+ * @brief Get the value of a counter.
+ *
+ * @param[in] counter Counter to read.
+ * @return The counter value, zero for invalid counters.
+ */
+uint32_t astarte_metrics_get_counter(astarte_metrics_counter_t counter);
+
+/**
+ * @brief Get the value of a gauge.
+ *
+ * @param[in] gauge Gauge to read.
+ * @return The gauge value, zero for invalid gauges.
+ */
+int32_t astarte_metrics_get_gauge(astarte_metrics_gauge_t gauge);
+
+/**
+ * @brief Get a snapshot of a latency histogram.
+ *
+ * @note The snapshot is not atomic, samples recorded while reading may be partially accounted.
+ *
+ * @param[in] histogram Histogram to read.
+ * @param[out] data Snapshot to fill, zeroed for invalid histograms.
+ */
+void astarte_metrics_get_histogram(
+    astarte_metrics_histogram_t histogram, astarte_metrics_histogram_data_t *data);
+
+/**
+ * @brief Get a snapshot of the traffic of each interface.
+ *
+ * @details Interfaces are tracked the first time a message is transmitted or received on them,
+ * up to CONFIG_ASTARTE_DEVICE_SDK_METRICS_MAX_INTERFACES interfaces. The traffic of the interfaces
+ * exceeding the limit is only accounted in the global counters.
+ *
+ * @param[out] interfaces Array to fill, the names point to SDK owned memory.
+ * @param[in] interfaces_len Number of elements of @p interfaces.
+ * @return The number of tracked interfaces, which can be larger than @p interfaces_len.
+ */
+size_t astarte_metrics_get_interfaces(
+    astarte_metrics_interface_t *interfaces, size_t interfaces_len);
+
+/**
+ * @brief Reset all the counters and histograms to zero.
+ *
+ * @note Gauges reflect the current state of the SDK and are not reset. Tracked interfaces are
+ * kept, only their traffic is reset.
+ */
+void astarte_metrics_reset(void);
+
+/**
+ * @brief Get the name of a counter.
+ *
+ * @param[in] counter Counter for which to get the name.
+ * @return A string with the counter name, "UNKNOWN" for invalid counters.
+ */
+const char *astarte_metrics_counter_to_name(astarte_metrics_counter_t counter);
+
+/**
+ * @brief Get the name of a gauge.
+ *
+ * @param[in] gauge Gauge for which to get the name.
+ * @return A string with the gauge name, "UNKNOWN" for invalid gauges.
+ */
+const char *astarte_metrics_gauge_to_name(astarte_metrics_gauge_t gauge);
+
+/**
+ * @brief Get the name of a histogram.
+ *
+ * @param[in] histogram Histogram for which to get the name.
+ * @return A string with the histogram name, "UNKNOWN" for invalid histograms.
+ */
+const char *astarte_metrics_histogram_to_name(astarte_metrics_histogram_t histogram);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ASTARTE_DEVICE_SDK_METRICS_H */
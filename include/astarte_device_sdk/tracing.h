@@ -0,0 +1,120 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ASTARTE_DEVICE_SDK_TRACING_H
+#define ASTARTE_DEVICE_SDK_TRACING_H
+
+/**
+ * @file tracing.h
+ * @brief Tracing of the hot paths of the Astarte device SDK.
+ */
+
+/**
+ * @defgroup tracing Tracing
+ * @brief Tracing of the hot paths of the Astarte device SDK.
+ * @details The SDK emits a begin and an end trace point at the boundaries of each stage of the
+ * transmission and reception paths. Trace points are either forwarded to the Zephyr tracing
+ * subsystem as named events, and can be collected with any of its backends such as CTF, or
+ * stored in a ring buffer that can be read with the functions in this file.
+ * @note Requires CONFIG_ASTARTE_DEVICE_SDK_TRACING, when disabled the trace points are compiled
+ * out.
+ * @ingroup astarte_device_sdk
+ * @{
+ */
+
+#include "astarte_device_sdk/astarte.h"
+
+/** @brief Stages of the SDK hot paths delimited by trace points. */
+typedef enum
+{
+    /** @brief Transmission of a message, from the call to the public send function */
+    ASTARTE_TRACE_STAGE_TX_SEND = 0,
+    /** @brief Validation of the transmitted data against the interface */
+    ASTARTE_TRACE_STAGE_TX_VALIDATION,
+    /** @brief BSON encoding of the transmitted data */
+    ASTARTE_TRACE_STAGE_TX_BSON_ENCODE,
+    /** @brief MQTT publish of the encoded message, including the caching of QoS 1 and 2 */
+    ASTARTE_TRACE_STAGE_TX_MQTT_PUBLISH,
+    /** @brief Write of the MQTT publish packet on the socket */
+    ASTARTE_TRACE_STAGE_TX_SOCKET_WRITE,
+    /** @brief Processing of the incoming data available on the MQTT socket */
+    ASTARTE_TRACE_STAGE_RX_MQTT_INPUT,
+    /** @brief Handling of a single incoming MQTT publish */
+    ASTARTE_TRACE_STAGE_RX_PUBLISH_EVENT,
+    /** @brief Decoding and dispatch of an incoming data message */
+    ASTARTE_TRACE_STAGE_RX_DATA_MESSAGE,
+    /** @brief Execution of the user callback receiving the data */
+    ASTARTE_TRACE_STAGE_RX_USER_CALLBACK,
+    /** @brief Number of stages, not a valid stage */
+    ASTARTE_TRACE_STAGE_COUNT,
+} astarte_trace_stage_t;
+
+/** @brief Single trace point, as stored in the ring buffer. */
+typedef struct
+{
+    /** @brief Monotonic time in microseconds when the trace point was emitted */
+    uint64_t timestamp_us;
+    /** @brief Address of the thread that emitted the trace point */
+    uintptr_t thread_id;
+    /** @brief Stage delimited by the trace point */
+    astarte_trace_stage_t stage;
+    /** @brief True for the beginning of the stage, false for its end */
+    bool begin;
+} astarte_trace_event_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING)
+
+/**
+ * @brief Get the name of a stage.
+ *
+ * @param[in] stage Stage for which to get the name.
+ * @return A string with the stage name, "UNKNOWN" for invalid stages.
+ */
+const char *astarte_trace_stage_to_name(astarte_trace_stage_t stage);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER)
+
+/**
+ * @brief Read and remove the oldest trace points from the ring buffer.
+ *
+ * @details When the ring buffer is full the oldest trace points are overwritten. A stage that
+ * failed emits its begin trace point without the matching end trace point.
+ *
+ * @param[out] events Array to fill with the trace points, from the oldest to the newest.
+ * @param[in] events_len Number of elements of @p events.
+ * @return The number of trace points written in @p events.
+ */
+size_t astarte_trace_read(astarte_trace_event_t *events, size_t events_len);
+
+/**
+ * @brief Get the number of trace points overwritten since the last clear.
+ *
+ * @return The number of trace points lost because the ring buffer was full.
+ */
+uint32_t astarte_trace_get_overwritten(void);
+
+/**
+ * @brief Remove all the trace points from the ring buffer and reset the overwritten count.
+ */
+void astarte_trace_clear(void);
+
+#endif
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ASTARTE_DEVICE_SDK_TRACING_H */
@@ -5,6 +5,58 @@
  */
 #include "astarte_zlib.h"
 
+#include <zephyr/sys/util.h>
+
+#include "heap_private.h"
+
+/************************************************
+ *       Checks over configuration values       *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)                                           \
+    && defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+// The purge properties message is decompressed with the default window size
+BUILD_ASSERT(CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_LARGE_BLOCK_SIZE >= (1U << MAX_WBITS),
+    "The large static pool blocks must fit the zlib inflate window");
+#endif
+
+/************************************************
+ *        Defines, constants and typedef        *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+#define ZLIB_ALLOC_FUNC zlib_alloc
+#define ZLIB_FREE_FUNC zlib_free
+#else
+// The inflate window does not fit the default SDK heap, zlib uses the system heap
+#define ZLIB_ALLOC_FUNC ((alloc_func) 0)
+#define ZLIB_FREE_FUNC ((free_func) 0)
+#endif
+
+/************************************************
+ *         Static functions declaration         *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+/**
+ * @brief Allocation function for zlib, using the SDK allocator.
+ *
+ * @param[in] opaque Unused.
+ * @param[in] items Number of items to allocate.
+ * @param[in] size Size of each item.
+ * @return The allocated memory, Z_NULL if out of memory.
+ */
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size);
+
+/**
+ * @brief Free function for zlib, using the SDK allocator.
+ *
+ * @param[in] opaque Unused.
+ * @param[in] address Memory to free.
+ */
+static void zlib_free(voidpf opaque, voidpf address);
+#endif
+
 /************************************************
  *         Global functions definitions         *
  ***********************************************/
@@ -21,8 +73,8 @@ int ZEXPORT astarte_zlib_compress(
     left = *destLen;
     *destLen = 0;
 
-    stream.zalloc = (alloc_func) 0;
-    stream.zfree = (free_func) 0;
+    stream.zalloc = ZLIB_ALLOC_FUNC;
+    stream.zfree = ZLIB_FREE_FUNC;
     stream.opaque = (voidpf) 0;
 
     int windowBits = 9; // Smallest possible window
@@ -53,4 +105,78 @@ int ZEXPORT astarte_zlib_compress(
     deflateEnd(&stream);
     return err == Z_STREAM_END ? Z_OK : err;
 }
+
+int ZEXPORT astarte_zlib_uncompress(
+    Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourceLen)
+{
+    z_stream stream;
+    int err;
+    const uInt max = (uInt) -1;
+    uLong len, left;
+    Byte buf[1]; /* for detection of incomplete stream when *destLen == 0 */
+
+    len = sourceLen;
+    if (*destLen) {
+        left = *destLen;
+        *destLen = 0;
+    } else {
+        left = 1;
+        dest = buf;
+    }
+
+    stream.next_in = (z_const Bytef *) source;
+    stream.avail_in = 0;
+    stream.zalloc = ZLIB_ALLOC_FUNC;
+    stream.zfree = ZLIB_FREE_FUNC;
+    stream.opaque = (voidpf) 0;
+
+    err = inflateInit(&stream);
+    if (err != Z_OK)
+        return err;
+
+    stream.next_out = dest;
+    stream.avail_out = 0;
+
+    do {
+        if (stream.avail_out == 0) {
+            stream.avail_out = left > (uLong) max ? max : (uInt) left;
+            left -= stream.avail_out;
+        }
+        if (stream.avail_in == 0) {
+            stream.avail_in = len > (uLong) max ? max : (uInt) len;
+            len -= stream.avail_in;
+        }
+        err = inflate(&stream, Z_NO_FLUSH);
+    } while (err == Z_OK);
+
+    if (dest != buf)
+        *destLen = stream.total_out;
+    else if (stream.total_out && err == Z_BUF_ERROR)
+        left = 1;
+
+    inflateEnd(&stream);
+    return err == Z_STREAM_END                           ? Z_OK
+        : err == Z_NEED_DICT                             ? Z_DATA_ERROR
+        : err == Z_BUF_ERROR && left + stream.avail_out ? Z_DATA_ERROR
+                                                         : err;
+}
 // NOLINTEND
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+    ARG_UNUSED(opaque);
+    void *ptr = astarte_heap_calloc(ASTARTE_HEAP_MODULE_ZLIB, items, size);
+    return (ptr) ? ptr : Z_NULL;
+}
+
+static void zlib_free(voidpf opaque, voidpf address)
+{
+    ARG_UNUSED(opaque);
+    astarte_heap_free(address);
+}
+#endif
@@ -9,12 +9,14 @@
 #include <stdio.h>
 
 #include <zephyr/net/socket.h>
+#include <zephyr/sys/timeutil.h>
 
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/ecp.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/oid.h>
 #include <mbedtls/pk.h>
+#include <mbedtls/platform_time.h>
 #include <mbedtls/x509_crt.h>
 #include <mbedtls/x509_csr.h>
 
@@ -38,6 +40,14 @@ ASTARTE_LOG_MODULE_REGISTER(astarte_crypto, CONFIG_ASTARTE_DEVICE_SDK_CRYPTO_LOG
  *         Static functions declaration         *
  ***********************************************/
 
+/**
+ * @brief Convert an X.509 time to seconds since the Unix epoch.
+ *
+ * @param[in] x509_time X.509 time to convert.
+ * @return Seconds since the Unix epoch.
+ */
+static int64_t x509_time_to_epoch(const mbedtls_x509_time *x509_time);
+
 /************************************************
  *         Global functions definitions         *
  ***********************************************/
@@ -214,6 +224,59 @@ exit:
 
     return ares;
 }
+
+astarte_result_t astarte_crypto_get_certificate_validity(
+    const char *cert_pem, int64_t *not_before, int64_t *not_after)
+{
+    astarte_result_t ares = ASTARTE_RESULT_MBEDTLS_ERROR;
+    mbedtls_x509_crt crt = { 0 };
+    mbedtls_x509_crt_init(&crt);
+
+    size_t cert_length = strlen(cert_pem) + 1; // + 1 for NULL terminator, as per documentation
+    int ret = mbedtls_x509_crt_parse(&crt, (unsigned char *) cert_pem, cert_length);
+    if (ret < 0) {
+        ASTARTE_LOG_ERR("mbedtls_x509_crt_parse returned %d", ret);
+        goto exit;
+    }
+
+    *not_before = x509_time_to_epoch(&crt.valid_from);
+    *not_after = x509_time_to_epoch(&crt.valid_to);
+    ares = ASTARTE_RESULT_OK;
+
+exit:
+    mbedtls_x509_crt_free(&crt);
+
+    return ares;
+}
+
+astarte_result_t astarte_crypto_get_current_time(int64_t *now)
+{
+#if defined(MBEDTLS_HAVE_TIME_DATE)
+    mbedtls_time_t time = mbedtls_time(NULL);
+    if (time <= 0) {
+        return ASTARTE_RESULT_NOT_FOUND;
+    }
+    *now = (int64_t) time;
+    return ASTARTE_RESULT_OK;
+#else
+    ARG_UNUSED(now);
+    return ASTARTE_RESULT_NOT_FOUND;
+#endif
+}
+
 /************************************************
  *         Static functions definitions         *
  ***********************************************/
+
+static int64_t x509_time_to_epoch(const mbedtls_x509_time *x509_time)
+{
+    struct tm time = {
+        .tm_year = x509_time->year - 1900,
+        .tm_mon = x509_time->mon - 1,
+        .tm_mday = x509_time->day,
+        .tm_hour = x509_time->hour,
+        .tm_min = x509_time->min,
+        .tm_sec = x509_time->sec,
+    };
+    return timeutil_timegm64(&time);
+}
@@ -91,6 +91,49 @@ astarte_result_t data_validation_aggregated_datastream(const astarte_interface_t
     return ASTARTE_RESULT_OK;
 }
 
+astarte_result_t data_validation_object_values(const astarte_interface_t *interface,
+    const char *path, const astarte_data_t *values, const int64_t *timestamp)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+
+    if ((interface->aggregation != ASTARTE_INTERFACE_AGGREGATION_OBJECT)
+        || (interface->mappings_length == 0)) {
+        ASTARTE_LOG_ERR("Interface %s is not an object interface.", interface->name);
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+
+    // All the mappings of an object share the same object path
+    ares = astarte_mapping_check_object_path(interface->mappings[0], path);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Path %s is not an object path of interface %s.", path, interface->name);
+        return ASTARTE_RESULT_MAPPING_NOT_IN_INTERFACE;
+    }
+
+    for (size_t i = 0; i < interface->mappings_length; i++) {
+        const astarte_mapping_t *mapping = &interface->mappings[i];
+        ares = astarte_mapping_check_data(mapping, values[i]);
+        if (ares != ASTARTE_RESULT_OK) {
+            ASTARTE_LOG_ERR("Object validation failed, interface/path (%s/%s/%s).",
+                interface->name, path, astarte_mapping_get_object_key(*mapping));
+            return ares;
+        }
+
+        if (mapping->explicit_timestamp && !timestamp) {
+            ASTARTE_LOG_ERR(
+                "Explicit timestamp required for interface %s, path %s.", interface->name, path);
+            return ASTARTE_RESULT_MAPPING_EXPLICIT_TIMESTAMP_REQUIRED;
+        }
+
+        if (!mapping->explicit_timestamp && timestamp) {
+            ASTARTE_LOG_ERR("Explicit timestamp not supported for interface %s, path %s.",
+                interface->name, path);
+            return ASTARTE_RESULT_MAPPING_EXPLICIT_TIMESTAMP_NOT_SUPPORTED;
+        }
+    }
+
+    return ASTARTE_RESULT_OK;
+}
+
 astarte_result_t data_validation_set_property(
     const astarte_interface_t *interface, const char *path, astarte_data_t data)
 {
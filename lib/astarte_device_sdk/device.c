@@ -8,6 +8,7 @@
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
 #include "device_caching.h"
 #endif
+#include "device_client_crt.h"
 #include "device_connection.h"
 #include "device_private.h"
 #include "device_rx.h"
@@ -15,13 +16,41 @@
 #include "pairing_private.h"
 #include "tls_credentials.h"
 
+#include "heap_private.h"
 #include "log.h"
+#include "tracing_private.h"
 ASTARTE_LOG_MODULE_REGISTER(astarte_device, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_DEVICE);
+
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+K_MEM_SLAB_DEFINE_STATIC(device_slab, sizeof(struct astarte_device),
+    CONFIG_ASTARTE_DEVICE_SDK_STATIC_DEVICE_COUNT, __alignof__(struct astarte_device));
+#endif
 
 /************************************************
  *         Static functions declaration         *
  ***********************************************/
 
+/**
+ * @brief Allocate a zero initialized device instance.
+ *
+ * @details With CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION the instance is taken from the static
+ * devices pool, otherwise it is allocated with the SDK allocator.
+ *
+ * @return The device instance, NULL if out of memory.
+ */
+static astarte_device_handle_t device_alloc(void);
+/**
+ * @brief Free a device instance allocated with #device_alloc.
+ *
+ * @param[in] device Handle to the device instance, can be NULL.
+ */
+static void device_free(astarte_device_handle_t device);
+
 /**
  * @brief Initialize the device introspection.
  *
@@ -33,59 +62,31 @@ ASTARTE_LOG_MODULE_REGISTER(astarte_device, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_LOG
 static astarte_result_t initialize_introspection(
     astarte_device_handle_t device, const astarte_interface_t **interfaces, size_t interfaces_size);
 /**
- * @brief Initialize MQTT topics.
+ * @brief Initialize MQTT topics, including the topic filters for the subscriptions.
  *
  * @param[in] device Handle to the device instance.
  * @return ASTARTE_RESULT_OK on success, an error code otherwise.
  */
 static astarte_result_t initialize_mqtt_topics(astarte_device_handle_t device);
+/**
+ * @brief Get the MQTT broker hostname and port.
+ *
+ * @details When the credentials are stored in permanent storage the stored broker information
+ * is used, the pairing APIs are only called when no broker information has been stored yet.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[out] hostname Buffer where to store the broker hostname.
+ * @param[out] port Buffer where to store the broker port.
+ * @return ASTARTE_RESULT_OK on success, an error code otherwise.
+ */
+static astarte_result_t get_broker_hostname_and_port(astarte_device_handle_t device,
+    char hostname[static ASTARTE_MQTT_MAX_BROKER_HOSTNAME_LEN + 1],
+    char port[static ASTARTE_MQTT_MAX_BROKER_PORT_LEN + 1]);
 
 /************************************************
  *       Callbacks declaration/definition       *
  ***********************************************/
 
-static astarte_result_t refresh_client_cert_handler(astarte_mqtt_t *astarte_mqtt)
-{
-    astarte_result_t ares = ASTARTE_RESULT_OK;
-    struct astarte_device *device = CONTAINER_OF(astarte_mqtt, struct astarte_device, astarte_mqtt);
-    astarte_tls_credentials_client_crt_t *client_crt = &device->client_crt;
-
-    if (strlen(client_crt->crt_pem) != 0) {
-        ares = astarte_pairing_verify_client_certificate(
-            device->http_timeout_ms, device->device_id, device->cred_secr, client_crt->crt_pem);
-        if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_CLIENT_CERT_INVALID)) {
-            ASTARTE_LOG_ERR("Verify client certificate failed: %s.", astarte_result_to_name(ares));
-            return ares;
-        }
-        if (ares == ASTARTE_RESULT_OK) {
-            // Certificate is valid, exit
-            return ares;
-        }
-        ares = astarte_tls_credential_delete();
-        if (ares != ASTARTE_RESULT_OK) {
-            ASTARTE_LOG_ERR("Can't delete the client TLS cert: %s.", astarte_result_to_name(ares));
-            return ares;
-        }
-    }
-
-    ares = astarte_pairing_get_client_certificate(
-        device->http_timeout_ms, device->device_id, device->cred_secr, client_crt);
-    if (ares != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_ERR("Failed getting the client TLS cert: %s.", astarte_result_to_name(ares));
-        memset(client_crt->privkey_pem, 0, ARRAY_SIZE(client_crt->privkey_pem));
-        memset(client_crt->crt_pem, 0, ARRAY_SIZE(client_crt->crt_pem));
-        return ares;
-    }
-
-    ares = astarte_tls_credential_add(client_crt);
-    if (ares != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_ERR("Failed adding the client TLS cert: %s.", astarte_result_to_name(ares));
-        return ares;
-    }
-
-    return ares;
-}
-
 /************************************************
  *         Global functions definitions         *
  ***********************************************/
@@ -101,7 +102,7 @@ astarte_result_t astarte_device_new(astarte_device_config_t *cfg, astarte_device
         goto failure;
     }
 
-    handle = calloc(1, sizeof(struct astarte_device));
+    handle = device_alloc();
     if (!handle) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -117,7 +118,17 @@ astarte_result_t astarte_device_new(astarte_device_config_t *cfg, astarte_device
     handle->datastream_object_cbk = cfg->datastream_object_cbk;
     handle->property_set_cbk = cfg->property_set_cbk;
     handle->property_unset_cbk = cfg->property_unset_cbk;
+    handle->data_chunk_cbk = cfg->data_chunk_cbk;
     handle->cbk_user_data = cfg->cbk_user_data;
+    astarte_device_connection_init_poll_signal(handle);
+    astarte_device_connection_init_handshake(handle);
+    astarte_device_client_crt_init(handle);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+    astarte_device_tx_init_property_digests(handle);
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+    astarte_stream_filter_init(&handle->stream_filter);
+#endif
 
     // Initializing the connection hashmap and status flags
     handle->synchronization_completed = false;
@@ -149,16 +160,24 @@ astarte_result_t astarte_device_new(astarte_device_config_t *cfg, astarte_device
     astarte_mqtt_config.clean_session = false;
     astarte_mqtt_config.connection_timeout_ms = cfg->mqtt_connection_timeout_ms;
     astarte_mqtt_config.poll_timeout_ms = cfg->mqtt_poll_timeout_ms;
-    astarte_mqtt_config.refresh_client_cert_cbk = refresh_client_cert_handler;
+    astarte_mqtt_config.refresh_client_cert_cbk = astarte_device_client_crt_refresh_handler;
     astarte_mqtt_config.on_subscribed_cbk = astarte_device_connection_on_subscribed_handler;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_mqtt_config.on_delivered_cbk = astarte_device_connection_on_delivered_handler;
+#endif
     astarte_mqtt_config.on_connected_cbk = astarte_device_connection_on_connected_handler;
     astarte_mqtt_config.on_disconnected_cbk = astarte_device_connection_on_disconnected_handler;
     astarte_mqtt_config.on_incoming_cbk = astarte_device_rx_on_incoming_handler;
+    if (cfg->data_chunk_cbk) {
+        astarte_mqtt_config.on_incoming_chunk_cbk = astarte_device_rx_on_incoming_chunk_handler;
+    }
 
     ASTARTE_LOG_DBG("Getting MQTT broker hostname and port");
-    ares = astarte_pairing_get_mqtt_broker_hostname_and_port(handle->http_timeout_ms,
-        handle->device_id, handle->cred_secr, astarte_mqtt_config.broker_hostname,
-        astarte_mqtt_config.broker_port);
+    // Keep a single HTTP connection to the pairing APIs until the first MQTT connection
+    astarte_pairing_session_begin();
+    handle->pairing_session_active = true;
+    ares = get_broker_hostname_and_port(
+        handle, astarte_mqtt_config.broker_hostname, astarte_mqtt_config.broker_port);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Failed in parsing the MQTT broker URL");
         goto failure;
@@ -181,6 +200,8 @@ astarte_result_t astarte_device_new(astarte_device_config_t *cfg, astarte_device
     // Initialize the handle data to be used during the handshake with Astarte
     handle->mqtt_session_present_flag = 0;
     handle->reconnection_timepoint = sys_timepoint_calc(K_NO_WAIT);
+    handle->client_crt_expiry_timepoint = sys_timepoint_calc(K_FOREVER);
+    handle->client_crt_renewal_timepoint = sys_timepoint_calc(K_FOREVER);
     backoff_context_init(&handle->backoff_ctx,
         CONFIG_ASTARTE_DEVICE_SDK_RECONNECTION_ASTARTE_BACKOFF_INITIAL_MS,
         CONFIG_ASTARTE_DEVICE_SDK_RECONNECTION_ASTARTE_BACKOFF_MAX_MS, true);
@@ -191,9 +212,17 @@ astarte_result_t astarte_device_new(astarte_device_config_t *cfg, astarte_device
 
 failure:
     if (handle) {
+        if (handle->pairing_session_active) {
+            astarte_pairing_session_end();
+        }
+        astarte_device_connection_deinit_handshake(handle);
+        astarte_device_client_crt_deinit(handle);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+        astarte_stream_filter_destroy(&handle->stream_filter);
+#endif
         introspection_free(handle->introspection);
     }
-    free(handle);
+    device_free(handle);
     return ares;
 }
 
@@ -212,7 +241,12 @@ astarte_result_t astarte_device_destroy(astarte_device_handle_t device)
         }
     }
 
-    astarte_mqtt_clear_all_pending(&device->astarte_mqtt);
+    astarte_mqtt_destroy(&device->astarte_mqtt);
+
+    if (device->pairing_session_active) {
+        astarte_pairing_session_end();
+        device->pairing_session_active = false;
+    }
 
     ares = astarte_tls_credential_delete();
     if (ares != ASTARTE_RESULT_OK) {
@@ -220,8 +254,14 @@ astarte_result_t astarte_device_destroy(astarte_device_handle_t device)
         return ares;
     }
 
+    astarte_device_connection_deinit_poll_signal(device);
+    astarte_device_connection_deinit_handshake(device);
+    astarte_device_client_crt_deinit(device);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+    astarte_stream_filter_destroy(&device->stream_filter);
+#endif
     introspection_free(device->introspection);
-    free(device);
+    device_free(device);
     return ASTARTE_RESULT_OK;
 }
 
@@ -241,7 +281,11 @@ astarte_result_t astarte_device_connect(astarte_device_handle_t device)
         ASTARTE_LOG_ERR("Received NULL reference for device handle");
         return ASTARTE_RESULT_INVALID_PARAM;
     }
-    return astarte_device_connection_connect(device);
+    astarte_result_t ares = astarte_device_connection_connect(device);
+    if (ares == ASTARTE_RESULT_OK) {
+        astarte_device_connection_raise_poll_signal(device);
+    }
+    return ares;
 }
 
 astarte_result_t astarte_device_disconnect(astarte_device_handle_t device, k_timeout_t timeout)
@@ -250,7 +294,11 @@ astarte_result_t astarte_device_disconnect(astarte_device_handle_t device, k_tim
         ASTARTE_LOG_ERR("Received NULL reference for device handle");
         return ASTARTE_RESULT_INVALID_PARAM;
     }
-    return astarte_device_connection_disconnect(device, timeout, false);
+    astarte_result_t ares = astarte_device_connection_disconnect(device, timeout, false);
+    if (ares == ASTARTE_RESULT_OK) {
+        astarte_device_connection_raise_poll_signal(device);
+    }
+    return ares;
 }
 
 astarte_result_t astarte_device_force_disconnect(astarte_device_handle_t device)
@@ -259,7 +307,11 @@ astarte_result_t astarte_device_force_disconnect(astarte_device_handle_t device)
         ASTARTE_LOG_ERR("Received NULL reference for device handle");
         return ASTARTE_RESULT_INVALID_PARAM;
     }
-    return astarte_device_connection_disconnect(device, K_NO_WAIT, true);
+    astarte_result_t ares = astarte_device_connection_disconnect(device, K_NO_WAIT, true);
+    if (ares == ASTARTE_RESULT_OK) {
+        astarte_device_connection_raise_poll_signal(device);
+    }
+    return ares;
 }
 
 astarte_result_t astarte_device_poll(astarte_device_handle_t device)
@@ -271,6 +323,35 @@ astarte_result_t astarte_device_poll(astarte_device_handle_t device)
     return astarte_device_connection_poll(device);
 }
 
+k_timeout_t astarte_device_get_next_deadline(astarte_device_handle_t device)
+{
+    if (!device) {
+        ASTARTE_LOG_ERR("Received NULL reference for device handle");
+        return K_FOREVER;
+    }
+    return astarte_device_connection_get_next_deadline(device);
+}
+
+int astarte_device_get_socket(astarte_device_handle_t device)
+{
+    if (!device) {
+        ASTARTE_LOG_ERR("Received NULL reference for device handle");
+        return -1;
+    }
+    return astarte_mqtt_get_socket(&device->astarte_mqtt);
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+struct k_poll_signal *astarte_device_get_poll_signal(astarte_device_handle_t device)
+{
+    if (!device) {
+        ASTARTE_LOG_ERR("Received NULL reference for device handle");
+        return NULL;
+    }
+    return &device->poll_signal;
+}
+#endif
+
 astarte_result_t astarte_device_send_individual(astarte_device_handle_t device,
     const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp)
 {
@@ -283,7 +364,11 @@ astarte_result_t astarte_device_send_individual(astarte_device_handle_t device,
         return ASTARTE_RESULT_DEVICE_NOT_READY;
     }
 
-    return astarte_device_tx_stream_individual(device, interface_name, path, data, timestamp);
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_SEND);
+    astarte_result_t ares = astarte_device_tx_stream_individual(
+        device, interface_name, path, data, timestamp, NULL);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_SEND);
+    return ares;
 }
 
 astarte_result_t astarte_device_send_object(astarte_device_handle_t device,
@@ -299,8 +384,31 @@ astarte_result_t astarte_device_send_object(astarte_device_handle_t device,
         return ASTARTE_RESULT_DEVICE_NOT_READY;
     }
 
-    return astarte_device_tx_stream_aggregated(
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_SEND);
+    astarte_result_t ares = astarte_device_tx_stream_aggregated(
         device, interface_name, path, entries, entries_len, timestamp);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_SEND);
+    return ares;
+}
+
+astarte_result_t astarte_device_send_object_values(astarte_device_handle_t device,
+    const astarte_interface_t *interface, const char *path, const astarte_data_t *values,
+    const int64_t *timestamp)
+{
+    if (!device || !interface || !path || !values) {
+        ASTARTE_LOG_ERR("Received a NULL reference for a required input parameter.");
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+    if (device->connection_state != DEVICE_CONNECTED) {
+        ASTARTE_LOG_ERR("Called stream aggregated function when the device is not connected.");
+        return ASTARTE_RESULT_DEVICE_NOT_READY;
+    }
+
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_SEND);
+    astarte_result_t ares
+        = astarte_device_tx_stream_object_values(device, interface, path, values, timestamp);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_SEND);
+    return ares;
 }
 
 astarte_result_t astarte_device_set_property(astarte_device_handle_t device,
@@ -315,7 +423,10 @@ astarte_result_t astarte_device_set_property(astarte_device_handle_t device,
         return ASTARTE_RESULT_DEVICE_NOT_READY;
     }
 
-    return astarte_device_tx_set_property(device, interface_name, path, data);
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_SEND);
+    astarte_result_t ares = astarte_device_tx_set_property(device, interface_name, path, data);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_SEND);
+    return ares;
 }
 
 astarte_result_t astarte_device_unset_property(
@@ -330,7 +441,10 @@ astarte_result_t astarte_device_unset_property(
         return ASTARTE_RESULT_DEVICE_NOT_READY;
     }
 
-    return astarte_device_tx_unset_property(device, interface_name, path);
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_SEND);
+    astarte_result_t ares = astarte_device_tx_unset_property(device, interface_name, path);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_SEND);
+    return ares;
 }
 
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
@@ -342,6 +456,10 @@ astarte_result_t astarte_device_get_property(astarte_device_handle_t device,
         ASTARTE_LOG_ERR("Received a NULL reference for a required input parameter.");
         return ASTARTE_RESULT_INVALID_PARAM;
     }
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    // Buffered server properties are written first, not to return stale values
+    astarte_device_rx_commit_properties(device);
+#endif
     astarte_result_t ares = ASTARTE_RESULT_OK;
     astarte_data_t data = { 0 };
     uint32_t out_major = 0U;
@@ -365,10 +483,54 @@ astarte_result_t astarte_device_get_property(astarte_device_handle_t device,
 }
 #endif
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+astarte_result_t astarte_device_set_mapping_filter(astarte_device_handle_t device,
+    const char *interface_name, const char *endpoint, const astarte_mapping_filter_t *filter)
+{
+    if (!device || !interface_name || !endpoint) {
+        ASTARTE_LOG_ERR("Received a NULL reference for a required input parameter.");
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+
+    const astarte_interface_t *interface = introspection_get(
+        &device->introspection, interface_name);
+    if (!interface) {
+        ASTARTE_LOG_ERR("Couldn't find interface in device introspection (%s).", interface_name);
+        return ASTARTE_RESULT_INTERFACE_NOT_FOUND;
+    }
+    return astarte_stream_filter_set(&device->stream_filter, interface, endpoint, filter);
+}
+#endif
+
 /************************************************
  *         Static functions definitions         *
  ***********************************************/
 
+static astarte_device_handle_t device_alloc(void)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+    void *block = NULL;
+    if (k_mem_slab_alloc(&device_slab, &block, K_NO_WAIT) != 0) {
+        return NULL;
+    }
+    memset(block, 0, sizeof(struct astarte_device));
+    return block;
+#else
+    return astarte_calloc(1, sizeof(struct astarte_device));
+#endif
+}
+
+static void device_free(astarte_device_handle_t device)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+    if (device) {
+        k_mem_slab_free(&device_slab, device);
+    }
+#else
+    astarte_free(device);
+#endif
+}
+
 static astarte_result_t initialize_introspection(
     astarte_device_handle_t device, const astarte_interface_t **interfaces, size_t interfaces_size)
 {
@@ -424,5 +586,40 @@ static astarte_result_t initialize_mqtt_topics(astarte_device_handle_t device)
         ASTARTE_LOG_ERR("Error encoding device purge properties topic.");
         return ASTARTE_RESULT_INTERNAL_ERROR;
     }
-    return ASTARTE_RESULT_OK;
+    return astarte_device_connection_update_subscription_topics(device);
+}
+
+static astarte_result_t get_broker_hostname_and_port(astarte_device_handle_t device,
+    char hostname[static ASTARTE_MQTT_MAX_BROKER_HOSTNAME_LEN + 1],
+    char port[static ASTARTE_MQTT_MAX_BROKER_PORT_LEN + 1])
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+    ares = astarte_device_caching_broker_load(device->device_id, hostname,
+        ASTARTE_MQTT_MAX_BROKER_HOSTNAME_LEN + 1, port, ASTARTE_MQTT_MAX_BROKER_PORT_LEN + 1);
+    if (ares == ASTARTE_RESULT_OK) {
+        return ares;
+    }
+    if (ares != ASTARTE_RESULT_NOT_FOUND) {
+        ASTARTE_LOG_WRN("Failed loading the stored broker: %s.", astarte_result_to_name(ares));
+    }
+#endif
+
+    ares = astarte_pairing_get_mqtt_broker_hostname_and_port(
+        device->http_timeout_ms, device->device_id, device->cred_secr, hostname, port);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+    // A failure in storing the broker information only impacts the following boots
+    astarte_result_t store_ares
+        = astarte_device_caching_broker_store(device->device_id, hostname, port);
+    if (store_ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_WRN("Failed storing the broker: %s.", astarte_result_to_name(store_ares));
+    }
+#endif
+
+    return ares;
 }
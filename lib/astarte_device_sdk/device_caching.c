@@ -6,16 +6,21 @@
 #include "device_caching.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <zephyr/drivers/flash.h>
 #include <zephyr/fs/nvs.h>
 #include <zephyr/kernel.h>
 #include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/byteorder.h>
 
+#include "astarte_device_sdk/device_id.h"
 #include "data_private.h"
 
+#include "heap_private.h"
 #include "log.h"
 ASTARTE_LOG_MODULE_REGISTER(device_caching, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_CACHING_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_DEVICE_CACHING);
 
 /************************************************
  *        Defines, constants and typedef        *
@@ -32,8 +37,17 @@ ASTARTE_LOG_MODULE_REGISTER(device_caching, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_CAC
 #define SYNCHRONIZATION_NAMESPACE "synchronization_namespace"
 #define SYNCHRONIZATION_KEY "synchronization_status"
 #define INTROSPECTION_NAMESPACE "introspection_namespace"
-#define INTROSPECTION_KEY "introspection_string"
+#define INTROSPECTION_KEY "introspection_digest"
 #define PROPERTIES_NAMESPACE "properties_namespace"
+// Status byte stored after the BSON document of each property
+#define PROPERTY_STATUS_UNACKED 0x00U
+#define PROPERTY_STATUS_ACKED 0x01U
+#define CREDENTIALS_NAMESPACE "credentials_namespace"
+#define CREDENTIALS_DEVICE_ID_KEY "device_id"
+#define CREDENTIALS_BROKER_HOSTNAME_KEY "broker_hostname"
+#define CREDENTIALS_BROKER_PORT_KEY "broker_port"
+#define CREDENTIALS_CLIENT_CRT_KEY "client_crt"
+#define CREDENTIALS_CLIENT_PRIVKEY_KEY "client_privkey"
 
 /************************************************
  *         Static functions declaration         *
@@ -47,6 +61,16 @@ ASTARTE_LOG_MODULE_REGISTER(device_caching, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_CAC
  * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
  */
 static astarte_result_t open_kv_storage(const char *namespace, astarte_kv_storage_t *kv_storage);
+/**
+ * @brief Build the key-value storage key of a property, in the format interface_name + ';' + path.
+ *
+ * @param[in] interface_name Interface name for the property.
+ * @param[in] path Path for the property.
+ * @param[out] key Will be set to the newly allocated key, to be freed with astarte_free.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t build_property_key(
+    const char *interface_name, const char *path, char **key);
 /**
  * @brief Parse BSON file used to store a property
  *
@@ -59,6 +83,14 @@ static astarte_result_t open_kv_storage(const char *namespace, astarte_kv_storag
  */
 static astarte_result_t parse_property_bson(
     const char *value, uint32_t *out_major, astarte_data_t *data);
+/**
+ * @brief Get the status byte stored after the BSON document of a property.
+ *
+ * @param[in] value Stored value for the property.
+ * @param[in] value_len Length of @p value.
+ * @return The status byte, #PROPERTY_STATUS_UNACKED if missing.
+ */
+static uint8_t property_status(const uint8_t *value, size_t value_len);
 /**
  * @brief Append a property to the end of the string.
  *
@@ -75,6 +107,39 @@ static astarte_result_t parse_property_bson(
  */
 static astarte_result_t append_property_to_string(introspection_t *introspection,
     char *interface_name, char *path, size_t *str_size, char *str_buff, size_t str_buff_size);
+/**
+ * @brief Open the credentials namespace, checking that its content belongs to the device.
+ *
+ * @param[in] device_id Device ID owning the credentials.
+ * @param[out] kv_storage Uninitialized key-value storage handle.
+ * @return ASTARTE_RESULT_OK if successful, ASTARTE_RESULT_NOT_FOUND if the stored credentials
+ * belong to another device, otherwise an error code.
+ */
+static astarte_result_t open_credentials_storage(
+    const char *device_id, astarte_kv_storage_t *kv_storage);
+/**
+ * @brief Store the device ID owning the content of the credentials namespace.
+ *
+ * @details If the stored device ID differs from the new one, the credentials of the previous
+ * device are deleted.
+ *
+ * @param[in] device_id Device ID owning the credentials.
+ * @param[inout] kv_storage Key-value storage handle for the credentials namespace.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t store_credentials_owner(
+    const char *device_id, astarte_kv_storage_t *kv_storage);
+/**
+ * @brief Load a null terminated string from the key-value storage.
+ *
+ * @param[inout] kv_storage Key-value storage handle.
+ * @param[in] key Key of the string to load.
+ * @param[out] buffer Buffer where to store the string.
+ * @param[in] buffer_size Size of the @p buffer.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t load_string(
+    astarte_kv_storage_t *kv_storage, const char *key, char *buffer, size_t buffer_size);
 
 /************************************************
  *         Global functions definitions         *
@@ -141,12 +206,13 @@ astarte_result_t astarte_device_caching_synchronization_set(bool sync)
     return ares;
 }
 
-astarte_result_t astarte_device_caching_introspection_store(const char *intr, size_t intr_size)
+astarte_result_t astarte_device_caching_introspection_store(
+    const uint8_t digest[static INTROSPECTION_DIGEST_SIZE])
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     astarte_kv_storage_t kv_storage = { 0 };
 
-    ASTARTE_LOG_DBG("Storing introspection in key-value storage: '%s' (%d).", intr, intr_size);
+    ASTARTE_LOG_DBG("Storing introspection digest in key-value storage.");
 
     ares = open_kv_storage(INTROSPECTION_NAMESPACE, &kv_storage);
     if (ares != ASTARTE_RESULT_OK) {
@@ -155,7 +221,8 @@ astarte_result_t astarte_device_caching_introspection_store(const char *intr, si
     }
 
     ASTARTE_LOG_DBG("Inserting pair in storage. Key: %s", INTROSPECTION_KEY);
-    ares = astarte_kv_storage_insert(&kv_storage, INTROSPECTION_KEY, intr, intr_size);
+    ares = astarte_kv_storage_insert(
+        &kv_storage, INTROSPECTION_KEY, digest, INTROSPECTION_DIGEST_SIZE);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Error caching introspection: %s.", astarte_result_to_name(ares));
     }
@@ -165,14 +232,15 @@ astarte_result_t astarte_device_caching_introspection_store(const char *intr, si
     return ares;
 }
 
-astarte_result_t astarte_device_caching_introspection_check(const char *intr, size_t intr_size)
+astarte_result_t astarte_device_caching_introspection_check(
+    const uint8_t digest[static INTROSPECTION_DIGEST_SIZE])
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     astarte_kv_storage_t kv_storage = { 0 };
-    char *read_intr = NULL;
-    size_t read_intr_size = 0;
+    uint8_t read_digest[INTROSPECTION_DIGEST_SIZE] = { 0 };
+    size_t read_digest_size = sizeof(read_digest);
 
-    ASTARTE_LOG_DBG("Checking stored introspection against new one: '%s' (%d).", intr, intr_size);
+    ASTARTE_LOG_DBG("Checking stored introspection digest against new one.");
 
     ares = open_kv_storage(INTROSPECTION_NAMESPACE, &kv_storage);
     if (ares != ASTARTE_RESULT_OK) {
@@ -181,7 +249,7 @@ astarte_result_t astarte_device_caching_introspection_check(const char *intr, si
     }
 
     ASTARTE_LOG_DBG("Searching for pair in storage. Key: '%s'", INTROSPECTION_KEY);
-    ares = astarte_kv_storage_find(&kv_storage, INTROSPECTION_KEY, NULL, &read_intr_size);
+    ares = astarte_kv_storage_find(&kv_storage, INTROSPECTION_KEY, read_digest, &read_digest_size);
     if (ares == ASTARTE_RESULT_NOT_FOUND) {
         ares = ASTARTE_RESULT_DEVICE_CACHING_OUTDATED_INTROSPECTION;
         goto exit;
@@ -191,48 +259,232 @@ astarte_result_t astarte_device_caching_introspection_check(const char *intr, si
         goto exit;
     }
 
-    if (read_intr_size != intr_size) {
+    if ((read_digest_size != INTROSPECTION_DIGEST_SIZE)
+        || (memcmp(digest, read_digest, INTROSPECTION_DIGEST_SIZE) != 0)) {
+        ASTARTE_LOG_INF("Found outdated introspection.");
         ares = ASTARTE_RESULT_DEVICE_CACHING_OUTDATED_INTROSPECTION;
         goto exit;
     }
 
-    read_intr = calloc(read_intr_size, sizeof(char));
-    if (!read_intr) {
-        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+exit:
+    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
+    astarte_kv_storage_destroy(kv_storage);
+
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_broker_store(
+    const char *device_id, const char *hostname, const char *port)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_kv_storage_t kv_storage = { 0 };
+
+    ASTARTE_LOG_DBG("Storing broker information: '%s:%s'.", hostname, port);
+
+    ares = open_kv_storage(CREDENTIALS_NAMESPACE, &kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Init error for credentials cache: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+
+    ares = store_credentials_owner(device_id, &kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
         goto exit;
     }
 
-    ASTARTE_LOG_DBG("Searching for pair in storage. Key: '%s'", INTROSPECTION_KEY);
-    ares = astarte_kv_storage_find(&kv_storage, INTROSPECTION_KEY, read_intr, &read_intr_size);
+    ASTARTE_LOG_DBG("Inserting pair in storage. Key: %s", CREDENTIALS_BROKER_HOSTNAME_KEY);
+    ares = astarte_kv_storage_insert(
+        &kv_storage, CREDENTIALS_BROKER_HOSTNAME_KEY, hostname, strlen(hostname) + 1);
     if (ares != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_ERR("Fetch error for cached introspection: %s.", astarte_result_to_name(ares));
+        ASTARTE_LOG_ERR("Error caching broker hostname: %s.", astarte_result_to_name(ares));
         goto exit;
     }
 
-    if (memcmp(intr, read_intr, MIN(read_intr_size, intr_size)) != 0) {
-        ASTARTE_LOG_INF("Found outdated introspection: '%s' (%d).", read_intr, read_intr_size);
-        ares = ASTARTE_RESULT_DEVICE_CACHING_OUTDATED_INTROSPECTION;
+    ASTARTE_LOG_DBG("Inserting pair in storage. Key: %s", CREDENTIALS_BROKER_PORT_KEY);
+    ares = astarte_kv_storage_insert(
+        &kv_storage, CREDENTIALS_BROKER_PORT_KEY, port, strlen(port) + 1);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Error caching broker port: %s.", astarte_result_to_name(ares));
+    }
+
+exit:
+    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
+    astarte_kv_storage_destroy(kv_storage);
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_broker_load(
+    const char *device_id, char *hostname, size_t hostname_size, char *port, size_t port_size)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_kv_storage_t kv_storage = { 0 };
+
+    ares = open_credentials_storage(device_id, &kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ares = load_string(&kv_storage, CREDENTIALS_BROKER_HOSTNAME_KEY, hostname, hostname_size);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ares = load_string(&kv_storage, CREDENTIALS_BROKER_PORT_KEY, port, port_size);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ASTARTE_LOG_DBG("Loaded broker information: '%s:%s'.", hostname, port);
+
+exit:
+    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
+    astarte_kv_storage_destroy(kv_storage);
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_client_crt_store(
+    const char *device_id, const astarte_tls_credentials_client_crt_t *client_crt)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_kv_storage_t kv_storage = { 0 };
+
+    ASTARTE_LOG_DBG("Storing client certificate.");
+
+    ares = open_kv_storage(CREDENTIALS_NAMESPACE, &kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Init error for credentials cache: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+
+    ares = store_credentials_owner(device_id, &kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ASTARTE_LOG_DBG("Inserting pair in storage. Key: %s", CREDENTIALS_CLIENT_PRIVKEY_KEY);
+    ares = astarte_kv_storage_insert(&kv_storage, CREDENTIALS_CLIENT_PRIVKEY_KEY,
+        client_crt->privkey_pem, strlen(client_crt->privkey_pem) + 1);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Error caching client private key: %s.", astarte_result_to_name(ares));
+        goto exit;
+    }
+
+    ASTARTE_LOG_DBG("Inserting pair in storage. Key: %s", CREDENTIALS_CLIENT_CRT_KEY);
+    ares = astarte_kv_storage_insert(&kv_storage, CREDENTIALS_CLIENT_CRT_KEY, client_crt->crt_pem,
+        strlen(client_crt->crt_pem) + 1);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Error caching client certificate: %s.", astarte_result_to_name(ares));
+    }
+
+exit:
+    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
+    astarte_kv_storage_destroy(kv_storage);
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_client_crt_load(
+    const char *device_id, astarte_tls_credentials_client_crt_t *client_crt)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_kv_storage_t kv_storage = { 0 };
+
+    ares = open_credentials_storage(device_id, &kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ares = load_string(&kv_storage, CREDENTIALS_CLIENT_PRIVKEY_KEY, client_crt->privkey_pem,
+        ARRAY_SIZE(client_crt->privkey_pem));
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ares = load_string(&kv_storage, CREDENTIALS_CLIENT_CRT_KEY, client_crt->crt_pem,
+        ARRAY_SIZE(client_crt->crt_pem));
+    if (ares != ASTARTE_RESULT_OK) {
         goto exit;
     }
 
+    ASTARTE_LOG_DBG("Loaded client certificate.");
+
 exit:
+    if (ares != ASTARTE_RESULT_OK) {
+        memset(client_crt->privkey_pem, 0, ARRAY_SIZE(client_crt->privkey_pem));
+        memset(client_crt->crt_pem, 0, ARRAY_SIZE(client_crt->crt_pem));
+    }
     ASTARTE_LOG_DBG("Destroying the key value storage instance.");
     astarte_kv_storage_destroy(kv_storage);
-    free(read_intr);
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_client_crt_delete(void)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_kv_storage_t kv_storage = { 0 };
+
+    ASTARTE_LOG_DBG("Deleting stored client certificate.");
+
+    ares = open_kv_storage(CREDENTIALS_NAMESPACE, &kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Init error for credentials cache: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+
+    const char *keys[] = { CREDENTIALS_CLIENT_CRT_KEY, CREDENTIALS_CLIENT_PRIVKEY_KEY };
+    for (size_t i = 0; i < ARRAY_SIZE(keys); i++) {
+        ASTARTE_LOG_DBG("Deleting pair from storage. Key: %s", keys[i]);
+        ares = astarte_kv_storage_delete(&kv_storage, keys[i]);
+        if (ares == ASTARTE_RESULT_NOT_FOUND) {
+            ares = ASTARTE_RESULT_OK;
+        }
+        if (ares != ASTARTE_RESULT_OK) {
+            ASTARTE_LOG_ERR("Error deleting client certificate: %s.", astarte_result_to_name(ares));
+            break;
+        }
+    }
 
+    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
+    astarte_kv_storage_destroy(kv_storage);
     return ares;
 }
 
 astarte_result_t astarte_device_caching_property_store(
     const char *interface_name, const char *path, uint32_t major, astarte_data_t data)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_device_caching_property_batch_t batch = { 0 };
+    uint8_t *value = NULL;
+    size_t value_len = 0;
+
+    ASTARTE_LOG_DBG("Caching property ('%s' - '%s').", interface_name, path);
+
+    ares = astarte_device_caching_property_encode(major, data, &value, &value_len);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ares = astarte_device_caching_property_batch_begin(&batch);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+    ares = astarte_device_caching_property_batch_store(
+        &batch, interface_name, path, value, value_len);
+    astarte_device_caching_property_batch_end(batch);
+
+exit:
+    astarte_free(value);
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_property_load(
+    const char *interface_name, const char *path, uint32_t *out_major, astarte_data_t *data)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     astarte_kv_storage_t kv_storage = { 0 };
     char *key = NULL;
-    astarte_bson_serializer_t bson = { 0 };
+    char *value = NULL;
 
-    ASTARTE_LOG_DBG("Caching property ('%s' - '%s').", interface_name, path);
+    ASTARTE_LOG_DBG("Loading cached property ('%s' - '%s').", interface_name, path);
 
     ares = open_kv_storage(PROPERTIES_NAMESPACE, &kv_storage);
     if (ares != ASTARTE_RESULT_OK) {
@@ -240,21 +492,74 @@ astarte_result_t astarte_device_caching_property_store(
         goto exit;
     }
 
-    // Get the full key interface_name + ';' + path
-    size_t key_len = strlen(interface_name) + 1 + strlen(path) + 1;
-    key = calloc(key_len, sizeof(char));
-    if (!key) {
+    ares = build_property_key(interface_name, path, &key);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ASTARTE_LOG_DBG("Searching for pair in storage. Key: '%s'", key);
+    size_t value_len = 0;
+    ares = astarte_kv_storage_find(&kv_storage, key, NULL, &value_len);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    // Allocate memory for BSON file to read
+    value = astarte_calloc(value_len, sizeof(char));
+    if (!value) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
         goto exit;
     }
-    int snprintf_rc = snprintf(key, key_len, "%s;%s", interface_name, path);
-    if (snprintf_rc != key_len - 1) {
-        ASTARTE_LOG_ERR("Could not create the property key-value storage key.");
-        ares = ASTARTE_RESULT_INTERNAL_ERROR;
+
+    // Get the data from NVS
+    ASTARTE_LOG_DBG("Searching for pair in storage. Key: '%s'", key);
+    ares = astarte_kv_storage_find(&kv_storage, key, value, &value_len);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Could not get property from storage: %s.", astarte_result_to_name(ares));
         goto exit;
     }
 
+    ares = parse_property_bson(value, out_major, data);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Could not parse data from stroage: %s.", astarte_result_to_name(ares));
+    }
+
+exit:
+    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
+    astarte_kv_storage_destroy(kv_storage);
+    astarte_free(key);
+    astarte_free(value);
+    return ares;
+}
+
+void astarte_device_caching_property_destroy_loaded(astarte_data_t data)
+{
+    astarte_data_destroy_deserialized(data);
+}
+
+astarte_result_t astarte_device_caching_property_delete(
+    const char *interface_name, const char *path)
+{
+    astarte_device_caching_property_batch_t batch = { 0 };
+
+    ASTARTE_LOG_DBG("Deleting cached property ('%s' - '%s').", interface_name, path);
+
+    astarte_result_t ares = astarte_device_caching_property_batch_begin(&batch);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+    ares = astarte_device_caching_property_batch_delete(&batch, interface_name, path);
+    astarte_device_caching_property_batch_end(batch);
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_property_encode(
+    uint32_t major, astarte_data_t data, uint8_t **value, size_t *value_len)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_bson_serializer_t bson = { 0 };
+
     // Serialize the Astarte data
     ares = astarte_bson_serializer_init(&bson);
     if (ares != ASTARTE_RESULT_OK) {
@@ -282,29 +587,90 @@ astarte_result_t astarte_device_caching_property_store(
         goto exit;
     }
 
+    // The new value has not been acknowledged by Astarte yet
+    *value = astarte_calloc(data_ser_len + 1, sizeof(uint8_t));
+    if (!*value) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+        goto exit;
+    }
+    memcpy(*value, data_ser, data_ser_len);
+    (*value)[data_ser_len] = PROPERTY_STATUS_UNACKED;
+    *value_len = data_ser_len + 1;
+
+exit:
+    astarte_bson_serializer_destroy(&bson);
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_property_batch_begin(
+    astarte_device_caching_property_batch_t *batch)
+{
+    astarte_result_t ares = open_kv_storage(PROPERTIES_NAMESPACE, &batch->kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Init error for property cache: %s.", astarte_result_to_name(ares));
+    }
+    return ares;
+}
+
+astarte_result_t astarte_device_caching_property_batch_store(
+    astarte_device_caching_property_batch_t *batch, const char *interface_name, const char *path,
+    const uint8_t *value, size_t value_len)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    char *key = NULL;
+
+    ares = build_property_key(interface_name, path, &key);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
     ASTARTE_LOG_DBG("Inserting pair in storage. Key: %s", key);
-    ares = astarte_kv_storage_insert(&kv_storage, key, data_ser, data_ser_len);
+    ares = astarte_kv_storage_insert(&batch->kv_storage, key, value, value_len);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Error caching property: %s.", astarte_result_to_name(ares));
     }
 
 exit:
-    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
-    astarte_kv_storage_destroy(kv_storage);
-    free(key);
-    astarte_bson_serializer_destroy(&bson);
+    astarte_free(key);
     return ares;
 }
 
-astarte_result_t astarte_device_caching_property_load(
-    const char *interface_name, const char *path, uint32_t *out_major, astarte_data_t *data)
+astarte_result_t astarte_device_caching_property_batch_delete(
+    astarte_device_caching_property_batch_t *batch, const char *interface_name, const char *path)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
-    astarte_kv_storage_t kv_storage = { 0 };
     char *key = NULL;
-    char *value = NULL;
 
-    ASTARTE_LOG_DBG("Loading cached property ('%s' - '%s').", interface_name, path);
+    ares = build_property_key(interface_name, path, &key);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ASTARTE_LOG_DBG("Deleting pair from storage. Key: %s", key);
+    ares = astarte_kv_storage_delete(&batch->kv_storage, key);
+    if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
+        ASTARTE_LOG_ERR("Error deleting cached property: %s.", astarte_result_to_name(ares));
+    }
+
+exit:
+    astarte_free(key);
+    return ares;
+}
+
+void astarte_device_caching_property_batch_end(astarte_device_caching_property_batch_t batch)
+{
+    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
+    astarte_kv_storage_destroy(batch.kv_storage);
+}
+
+astarte_result_t astarte_device_caching_property_is_acked(
+    const char *interface_name, const char *path, bool *acked)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_kv_storage_t kv_storage = { 0 };
+    char *key = NULL;
+    uint8_t *value = NULL;
 
     ares = open_kv_storage(PROPERTIES_NAMESPACE, &kv_storage);
     if (ares != ASTARTE_RESULT_OK) {
@@ -312,70 +678,46 @@ astarte_result_t astarte_device_caching_property_load(
         goto exit;
     }
 
-    // Get the full key interface_name + ';' + path
-    size_t key_len = strlen(interface_name) + 1 + strlen(path) + 1;
-    key = calloc(key_len, sizeof(char));
-    if (!key) {
-        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
-        goto exit;
-    }
-    int snprintf_rc = snprintf(key, key_len, "%s;%s", interface_name, path);
-    if (snprintf_rc != key_len - 1) {
-        ASTARTE_LOG_ERR("Could not create the property key-value storage key.");
-        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+    ares = build_property_key(interface_name, path, &key);
+    if (ares != ASTARTE_RESULT_OK) {
         goto exit;
     }
 
-    ASTARTE_LOG_DBG("Searching for pair in storage. Key: '%s'", key);
     size_t value_len = 0;
     ares = astarte_kv_storage_find(&kv_storage, key, NULL, &value_len);
     if (ares != ASTARTE_RESULT_OK) {
         goto exit;
     }
-
-    // Allocate memory for BSON file to read
-    value = calloc(value_len, sizeof(char));
+    value = astarte_calloc(value_len, sizeof(uint8_t));
     if (!value) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
         goto exit;
     }
-
-    // Get the data from NVS
-    ASTARTE_LOG_DBG("Searching for pair in storage. Key: '%s'", key);
     ares = astarte_kv_storage_find(&kv_storage, key, value, &value_len);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Could not get property from storage: %s.", astarte_result_to_name(ares));
         goto exit;
     }
 
-    ares = parse_property_bson(value, out_major, data);
-    if (ares != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_ERR("Could not parse data from stroage: %s.", astarte_result_to_name(ares));
-    }
+    *acked = (property_status(value, value_len) == PROPERTY_STATUS_ACKED);
 
 exit:
-    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
     astarte_kv_storage_destroy(kv_storage);
-    free(key);
-    free(value);
+    astarte_free(key);
+    astarte_free(value);
     return ares;
 }
 
-void astarte_device_caching_property_destroy_loaded(astarte_data_t data)
-{
-    astarte_data_destroy_deserialized(data);
-}
-
-astarte_result_t astarte_device_caching_property_delete(
+astarte_result_t astarte_device_caching_property_set_acked(
     const char *interface_name, const char *path)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     astarte_kv_storage_t kv_storage = { 0 };
     char *key = NULL;
+    uint8_t *value = NULL;
 
-    ASTARTE_LOG_DBG("Deleting cached property ('%s' - '%s').", interface_name, path);
+    ASTARTE_LOG_DBG("Marking cached property as acked ('%s' - '%s').", interface_name, path);
 
     ares = open_kv_storage(PROPERTIES_NAMESPACE, &kv_storage);
     if (ares != ASTARTE_RESULT_OK) {
@@ -383,31 +725,49 @@ astarte_result_t astarte_device_caching_property_delete(
         goto exit;
     }
 
-    // Get the full key interface_name + path
-    size_t key_len = strlen(interface_name) + 1 + strlen(path) + 1;
-    key = calloc(key_len, sizeof(char));
-    if (!key) {
+    ares = build_property_key(interface_name, path, &key);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    size_t value_len = 0;
+    ares = astarte_kv_storage_find(&kv_storage, key, NULL, &value_len);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+    // Values stored by previous versions of the SDK have no status byte
+    value = astarte_calloc(value_len + 1, sizeof(uint8_t));
+    if (!value) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
         goto exit;
     }
-    int snprintf_rc = snprintf(key, key_len, "%s;%s", interface_name, path);
-    if (snprintf_rc != key_len - 1) {
-        ASTARTE_LOG_ERR("Could not create the property key-value storage key.");
-        ares = ASTARTE_RESULT_INTERNAL_ERROR;
+    ares = astarte_kv_storage_find(&kv_storage, key, value, &value_len);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Could not get property from storage: %s.", astarte_result_to_name(ares));
         goto exit;
     }
 
-    ASTARTE_LOG_DBG("Deleting pair from storage. Key: %s", key);
-    ares = astarte_kv_storage_delete(&kv_storage, key);
-    if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
-        ASTARTE_LOG_ERR("Error deleting cached property: %s.", astarte_result_to_name(ares));
+    if (property_status(value, value_len) == PROPERTY_STATUS_ACKED) {
+        goto exit;
+    }
+
+    size_t doc_len = (value_len < sizeof(uint32_t)) ? SIZE_MAX : sys_get_le32(value);
+    if (doc_len > value_len) {
+        ASTARTE_LOG_ERR("Malformed cached property ('%s' - '%s').", interface_name, path);
+        ares = ASTARTE_RESULT_INTERNAL_ERROR;
+        goto exit;
+    }
+    value[doc_len] = PROPERTY_STATUS_ACKED;
+    ares = astarte_kv_storage_insert(&kv_storage, key, value, doc_len + 1);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Error updating cached property: %s.", astarte_result_to_name(ares));
     }
 
 exit:
-    ASTARTE_LOG_DBG("Destroying the key value storage instance.");
     astarte_kv_storage_destroy(kv_storage);
-    free(key);
+    astarte_free(key);
+    astarte_free(value);
     return ares;
 }
 
@@ -451,6 +811,25 @@ astarte_result_t astarte_device_caching_property_iterator_next(
     return ares;
 }
 
+astarte_result_t astarte_device_caching_property_iterator_realign(
+    astarte_device_caching_property_iter_t *iter, const char *interface_name, const char *path)
+{
+    char *key = NULL;
+    astarte_result_t ares = build_property_key(interface_name, path, &key);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+
+    ASTARTE_LOG_DBG("Realigning iterator for key value storage.");
+    ares = astarte_kv_storage_iterator_realign(&iter->kv_iter, key);
+    if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
+        ASTARTE_LOG_ERR("Key-value storage iterator error: %s.", astarte_result_to_name(ares));
+    }
+
+    astarte_free(key);
+    return ares;
+}
+
 astarte_result_t astarte_device_caching_property_iterator_get(
     astarte_device_caching_property_iter_t *iter, char *interface_name, size_t *interface_name_size,
     char *path, size_t *path_size)
@@ -479,7 +858,7 @@ astarte_result_t astarte_device_caching_property_iterator_get(
         goto exit;
     }
 
-    key = calloc(key_size, sizeof(char));
+    key = astarte_calloc(key_size, sizeof(char));
     if (!key) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -529,7 +908,7 @@ astarte_result_t astarte_device_caching_property_iterator_get(
     }
 
 exit:
-    free(key);
+    astarte_free(key);
     return ares;
 }
 
@@ -562,8 +941,8 @@ astarte_result_t astarte_device_caching_property_get_device_string(
             goto error;
         }
 
-        interface_name = calloc(interface_name_size, sizeof(char));
-        path = calloc(path_size, sizeof(char));
+        interface_name = astarte_calloc(interface_name_size, sizeof(char));
+        path = astarte_calloc(path_size, sizeof(char));
         if (!interface_name || !path) {
             ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
             goto error;
@@ -584,9 +963,9 @@ astarte_result_t astarte_device_caching_property_get_device_string(
             goto error;
         }
 
-        free(interface_name);
+        astarte_free(interface_name);
         interface_name = NULL;
-        free(path);
+        astarte_free(path);
         path = NULL;
 
         ares = astarte_device_caching_property_iterator_next(&iter);
@@ -603,8 +982,8 @@ astarte_result_t astarte_device_caching_property_get_device_string(
 
 error:
     astarte_device_caching_property_iterator_destroy(iter);
-    free(interface_name);
-    free(path);
+    astarte_free(interface_name);
+    astarte_free(path);
     return ares;
 }
 
@@ -645,6 +1024,25 @@ static astarte_result_t open_kv_storage(const char *namespace, astarte_kv_storag
     return ASTARTE_RESULT_OK;
 }
 
+static astarte_result_t build_property_key(
+    const char *interface_name, const char *path, char **key)
+{
+    size_t key_len = strlen(interface_name) + 1 + strlen(path) + 1;
+    char *buffer = astarte_calloc(key_len, sizeof(char));
+    if (!buffer) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return ASTARTE_RESULT_OUT_OF_MEMORY;
+    }
+    int snprintf_rc = snprintf(buffer, key_len, "%s;%s", interface_name, path);
+    if (snprintf_rc != key_len - 1) {
+        ASTARTE_LOG_ERR("Could not create the property key-value storage key.");
+        astarte_free(buffer);
+        return ASTARTE_RESULT_INTERNAL_ERROR;
+    }
+    *key = buffer;
+    return ASTARTE_RESULT_OK;
+}
+
 static astarte_result_t parse_property_bson(
     const char *value, uint32_t *out_major, astarte_data_t *data)
 {
@@ -685,6 +1083,15 @@ static astarte_result_t parse_property_bson(
     return ares;
 }
 
+static uint8_t property_status(const uint8_t *value, size_t value_len)
+{
+    if (value_len < sizeof(uint32_t)) {
+        return PROPERTY_STATUS_UNACKED;
+    }
+    size_t doc_len = sys_get_le32(value);
+    return (value_len > doc_len) ? value[doc_len] : PROPERTY_STATUS_UNACKED;
+}
+
 static astarte_result_t append_property_to_string(introspection_t *introspection,
     char *interface_name, char *path, size_t *str_size, char *str_buff, size_t str_buff_size)
 {
@@ -739,3 +1146,86 @@ static astarte_result_t append_property_to_string(introspection_t *introspection
 
     return ares;
 }
+static astarte_result_t open_credentials_storage(
+    const char *device_id, astarte_kv_storage_t *kv_storage)
+{
+    char stored_device_id[ASTARTE_DEVICE_ID_LEN + 1] = { 0 };
+
+    astarte_result_t ares = open_kv_storage(CREDENTIALS_NAMESPACE, kv_storage);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Init error for credentials cache: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+
+    ares = load_string(kv_storage, CREDENTIALS_DEVICE_ID_KEY, stored_device_id,
+        ARRAY_SIZE(stored_device_id));
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+
+    if (strcmp(stored_device_id, device_id) != 0) {
+        ASTARTE_LOG_INF("Stored credentials belong to a different device.");
+        return ASTARTE_RESULT_NOT_FOUND;
+    }
+
+    return ASTARTE_RESULT_OK;
+}
+
+static astarte_result_t store_credentials_owner(
+    const char *device_id, astarte_kv_storage_t *kv_storage)
+{
+    char stored_device_id[ASTARTE_DEVICE_ID_LEN + 1] = { 0 };
+
+    astarte_result_t ares = load_string(
+        kv_storage, CREDENTIALS_DEVICE_ID_KEY, stored_device_id, ARRAY_SIZE(stored_device_id));
+    if ((ares == ASTARTE_RESULT_OK) && (strcmp(stored_device_id, device_id) == 0)) {
+        return ASTARTE_RESULT_OK;
+    }
+    if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
+        return ares;
+    }
+
+    // Credentials of a different device should not be mixed with the new ones
+    const char *keys[] = { CREDENTIALS_BROKER_HOSTNAME_KEY, CREDENTIALS_BROKER_PORT_KEY,
+        CREDENTIALS_CLIENT_CRT_KEY, CREDENTIALS_CLIENT_PRIVKEY_KEY };
+    for (size_t i = 0; i < ARRAY_SIZE(keys); i++) {
+        ares = astarte_kv_storage_delete(kv_storage, keys[i]);
+        if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
+            ASTARTE_LOG_ERR("Error deleting stale credentials: %s.", astarte_result_to_name(ares));
+            return ares;
+        }
+    }
+
+    ASTARTE_LOG_DBG("Inserting pair in storage. Key: %s", CREDENTIALS_DEVICE_ID_KEY);
+    ares = astarte_kv_storage_insert(
+        kv_storage, CREDENTIALS_DEVICE_ID_KEY, device_id, strlen(device_id) + 1);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Error caching credentials owner: %s.", astarte_result_to_name(ares));
+    }
+    return ares;
+}
+
+static astarte_result_t load_string(
+    astarte_kv_storage_t *kv_storage, const char *key, char *buffer, size_t buffer_size)
+{
+    size_t value_size = 0;
+
+    ASTARTE_LOG_DBG("Searching for pair in storage. Key: '%s'", key);
+    astarte_result_t ares = astarte_kv_storage_find(kv_storage, key, NULL, &value_size);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+    if (value_size > buffer_size) {
+        ASTARTE_LOG_ERR("Stored value for '%s' does not fit the buffer (%zu).", key, value_size);
+        return ASTARTE_RESULT_INTERNAL_ERROR;
+    }
+
+    ares = astarte_kv_storage_find(kv_storage, key, buffer, &value_size);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Fetch error for '%s': %s.", key, astarte_result_to_name(ares));
+        return ares;
+    }
+    // Values are stored with their null terminator, ensure it is present
+    buffer[buffer_size - 1] = '\0';
+    return ASTARTE_RESULT_OK;
+}
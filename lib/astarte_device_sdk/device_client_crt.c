@@ -0,0 +1,581 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "device_client_crt.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/mutex.h>
+
+#include "crypto.h"
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+#include "device_caching.h"
+#endif
+#include "pairing_private.h"
+#include "tls_credentials.h"
+
+#include "heap_private.h"
+#include "log.h"
+ASTARTE_LOG_MODULE_REGISTER(
+    device_client_crt, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_CLIENT_CRT_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_DEVICE_CLIENT_CRT);
+
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+/** @brief Stack for the work queue pre-generating the client certificates keys. */
+static K_THREAD_STACK_DEFINE(
+    pregen_work_q_stack, CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION_STACK_SIZE);
+/** @brief Low priority work queue pre-generating the client certificates keys. */
+static struct k_work_q pregen_work_q;
+/** @brief Protects the lazy start of #pregen_work_q. */
+static SYS_MUTEX_DEFINE(pregen_work_q_mutex);
+/** @brief Set once #pregen_work_q has been started. */
+static bool pregen_work_q_started;
+#endif
+
+/************************************************
+ *         Static functions declaration         *
+ ***********************************************/
+
+/**
+ * @brief Refresh the device client certificate, verifying or requesting it when required.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] tls_rejected True when the previous connection attempt failed the TLS handshake.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t refresh_client_crt(astarte_device_handle_t device, bool tls_rejected);
+/**
+ * @brief Compute the expiry and renewal timepoints for the device client certificate.
+ *
+ * @details The certificate is parsed only once, the resulting timepoints are cached in the device.
+ * When no wall clock is available a freshly issued certificate is assumed to start its validity
+ * now, while the expiry of a previously issued certificate is unknown and left to the broker.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] fresh True if the certificate has just been issued by Astarte.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t update_timepoints(astarte_device_handle_t device, bool fresh);
+/**
+ * @brief Compute a timepoint from a number of seconds starting from now.
+ *
+ * @param[in] seconds Seconds from now, negative values result in an elapsed timepoint.
+ * @return The computed timepoint.
+ */
+static k_timepoint_t timepoint_from_seconds(int64_t seconds);
+/**
+ * @brief Discard the device client certificate from the TLS credentials and permanent storage.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t discard_client_crt(astarte_device_handle_t device);
+/**
+ * @brief Request a new client certificate to Astarte and install it.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t obtain_client_crt(astarte_device_handle_t device);
+/**
+ * @brief Swap the content of two client certificates, without any intermediate copy.
+ *
+ * @param[inout] first First client certificate.
+ * @param[inout] second Second client certificate.
+ */
+static void swap_client_crt(
+    astarte_tls_credentials_client_crt_t *first, astarte_tls_credentials_client_crt_t *second);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+/**
+ * @brief Load and install the stored client certificate.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return ASTARTE_RESULT_OK if a certificate has been loaded, ASTARTE_RESULT_NOT_FOUND
+ * if no usable certificate is stored, an error code otherwise.
+ */
+static astarte_result_t load_stored_client_crt(astarte_device_handle_t device);
+#endif
+/**
+ * @brief Request a new client certificate to Astarte, without installing it.
+ *
+ * @details A pre-generated key and CSR are used when available, otherwise they are generated now.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[out] client_crt Resulting client private key and certificate.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t request_client_crt(
+    astarte_device_handle_t device, astarte_tls_credentials_client_crt_t *client_crt);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+/**
+ * @brief Start the work queue for the pre-generation of the client certificates keys, if not
+ * already started.
+ *
+ * @details The work queue thread is only started for the applications actually renewing a
+ * client certificate.
+ */
+static void pregen_work_q_start(void);
+/**
+ * @brief Work handler generating the key and CSR for the next client certificate.
+ *
+ * @param[in] work Work item, embedded in the device instance.
+ */
+static void pregen_work_handler(struct k_work *work);
+/**
+ * @brief Take the pre-generated key and CSR, if ready and not being generated.
+ *
+ * @details The pre-generated key material is wiped from the device, a key is never used twice.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[out] privkey_pem Output buffer for the private key, of size
+ * #ASTARTE_CRYPTO_PRIVKEY_BUFFER_SIZE.
+ * @param[out] csr_pem Output buffer for the CSR, of size #ASTARTE_CRYPTO_CSR_BUFFER_SIZE.
+ * @return True if the key and CSR have been taken, false otherwise.
+ */
+static bool take_pregen(astarte_device_handle_t device, char *privkey_pem, unsigned char *csr_pem);
+#endif
+/**
+ * @brief Schedule the pre-generation of the key and CSR ahead of the client certificate renewal.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] timeout Timeout after which the pre-generation should start.
+ */
+static void schedule_pregen(astarte_device_handle_t device, k_timeout_t timeout);
+
+/************************************************
+ *         Global functions definitions         *
+ ***********************************************/
+
+void astarte_device_client_crt_init(astarte_device_handle_t device)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+    k_work_init_delayable(&device->client_crt_pregen_work, pregen_work_handler);
+    sys_mutex_init(&device->client_crt_pregen_mutex);
+    device->client_crt_pregen_ready = false;
+#else
+    (void) device;
+#endif
+}
+
+void astarte_device_client_crt_deinit(astarte_device_handle_t device)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+    struct k_work_sync sync = { 0 };
+    (void) k_work_cancel_delayable_sync(&device->client_crt_pregen_work, &sync);
+    device->client_crt_pregen_ready = false;
+    memset(device->client_crt_pregen_privkey_pem, 0, sizeof(device->client_crt_pregen_privkey_pem));
+    memset(device->client_crt_pregen_csr_pem, 0, sizeof(device->client_crt_pregen_csr_pem));
+#else
+    (void) device;
+#endif
+}
+
+astarte_result_t astarte_device_client_crt_refresh_handler(
+    astarte_mqtt_t *astarte_mqtt, bool tls_rejected)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    struct astarte_device *device = CONTAINER_OF(astarte_mqtt, struct astarte_device, astarte_mqtt);
+    astarte_tls_credentials_client_crt_t *client_crt = &device->client_crt;
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+    if (strlen(client_crt->crt_pem) == 0) {
+        ares = load_stored_client_crt(device);
+        if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
+            return ares;
+        }
+    }
+#endif
+
+    // Verification and request of a new certificate share the same HTTP connection
+    astarte_pairing_session_begin();
+    ares = refresh_client_crt(device, tls_rejected);
+    astarte_pairing_session_end();
+    return ares;
+}
+
+void astarte_device_client_crt_renew(astarte_device_handle_t device)
+{
+    astarte_tls_credentials_client_crt_t *client_crt = &device->client_crt;
+
+    if ((strlen(client_crt->crt_pem) == 0)
+        || !sys_timepoint_expired(device->client_crt_renewal_timepoint)) {
+        return;
+    }
+
+    ASTARTE_LOG_INF("Renewing the client certificate.");
+    astarte_tls_credentials_client_crt_t *renewed_crt
+        = astarte_calloc(1, sizeof(astarte_tls_credentials_client_crt_t));
+    if (!renewed_crt) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return;
+    }
+
+    astarte_result_t ares = request_client_crt(device, renewed_crt);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_WRN("Client certificate renewal failed: %s.", astarte_result_to_name(ares));
+        goto retry;
+    }
+
+    // The active TLS session holds its own copy of the credentials, they can be safely replaced
+    ares = astarte_tls_credential_delete();
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Can't delete the client TLS cert: %s.", astarte_result_to_name(ares));
+        goto retry;
+    }
+    // The previous certificate is kept in the renewed one until the new credential is installed
+    swap_client_crt(client_crt, renewed_crt);
+    ares = astarte_tls_credential_add(client_crt);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Failed adding the client TLS cert: %s.", astarte_result_to_name(ares));
+        swap_client_crt(client_crt, renewed_crt);
+        // On failure the certificate is wiped, a new one is then obtained on the next connection
+        ares = astarte_tls_credential_add(client_crt);
+        if (ares != ASTARTE_RESULT_OK) {
+            ASTARTE_LOG_ERR("Failed restoring the previous client TLS cert: %s.",
+                astarte_result_to_name(ares));
+        }
+        goto retry;
+    }
+
+    (void) update_timepoints(device, true);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+    ares = astarte_device_caching_client_crt_store(device->device_id, client_crt);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_WRN("Failed storing the client cert: %s.", astarte_result_to_name(ares));
+    }
+#endif
+    goto exit;
+
+retry:
+    device->client_crt_renewal_timepoint
+        = sys_timepoint_calc(K_MSEC(CONFIG_ASTARTE_DEVICE_SDK_RECONNECTION_ASTARTE_BACKOFF_MAX_MS));
+    // Prepare a fresh key for the next attempt
+    schedule_pregen(device, K_NO_WAIT);
+
+exit:
+    memset(renewed_crt, 0, sizeof(astarte_tls_credentials_client_crt_t));
+    astarte_free(renewed_crt);
+}
+
+k_timeout_t astarte_device_client_crt_get_renewal_deadline(astarte_device_handle_t device)
+{
+    if (strlen(device->client_crt.crt_pem) == 0) {
+        return K_FOREVER;
+    }
+    return sys_timepoint_timeout(device->client_crt_renewal_timepoint);
+}
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+static astarte_result_t refresh_client_crt(astarte_device_handle_t device, bool tls_rejected)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_tls_credentials_client_crt_t *client_crt = &device->client_crt;
+
+    if (strlen(client_crt->crt_pem) != 0) {
+        if (!tls_rejected && !sys_timepoint_expired(device->client_crt_expiry_timepoint)) {
+            // Certificate is valid according to its cached validity window, exit
+            return ASTARTE_RESULT_OK;
+        }
+
+        if (tls_rejected) {
+            ares = astarte_pairing_verify_client_certificate(
+                device->http_timeout_ms, device->device_id, device->cred_secr, client_crt->crt_pem);
+            if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_CLIENT_CERT_INVALID)) {
+                ASTARTE_LOG_ERR(
+                    "Verify client certificate failed: %s.", astarte_result_to_name(ares));
+                return ares;
+            }
+            if (ares == ASTARTE_RESULT_OK) {
+                // Certificate is valid, the handshake failed for other reasons, exit
+                return ares;
+            }
+        } else {
+            ASTARTE_LOG_INF("Client certificate is expired.");
+        }
+
+        ares = discard_client_crt(device);
+        if (ares != ASTARTE_RESULT_OK) {
+            return ares;
+        }
+    }
+
+    return obtain_client_crt(device);
+}
+
+static astarte_result_t update_timepoints(astarte_device_handle_t device, bool fresh)
+{
+    int64_t not_before = 0;
+    int64_t not_after = 0;
+    int64_t now = 0;
+
+    device->client_crt_expiry_timepoint = sys_timepoint_calc(K_FOREVER);
+    device->client_crt_renewal_timepoint = sys_timepoint_calc(K_FOREVER);
+
+    astarte_result_t ares = astarte_crypto_get_certificate_validity(
+        device->client_crt.crt_pem, &not_before, &not_after);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Client cert can't be parsed: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+
+    int64_t lifetime = not_after - not_before;
+    int64_t renewal = lifetime * CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_RENEWAL_PERCENT / 100;
+
+    // A wall clock earlier than the certificate issue date has not been synchronized yet
+    if ((astarte_crypto_get_current_time(&now) == ASTARTE_RESULT_OK) && (now >= not_before)) {
+        device->client_crt_expiry_timepoint = timepoint_from_seconds(not_after - now);
+        device->client_crt_renewal_timepoint = timepoint_from_seconds(not_before + renewal - now);
+    } else if (fresh) {
+        device->client_crt_expiry_timepoint = timepoint_from_seconds(lifetime);
+        device->client_crt_renewal_timepoint = timepoint_from_seconds(renewal);
+    }
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+    k_timeout_t renewal_timeout = sys_timepoint_timeout(device->client_crt_renewal_timepoint);
+    if (!K_TIMEOUT_EQ(renewal_timeout, K_FOREVER)) {
+        k_ticks_t lead_ticks
+            = k_sec_to_ticks_ceil64(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION_LEAD_S);
+        schedule_pregen(device,
+            (renewal_timeout.ticks > lead_ticks) ? K_TICKS(renewal_timeout.ticks - lead_ticks)
+                                                 : K_NO_WAIT);
+    }
+#endif
+
+    return ASTARTE_RESULT_OK;
+}
+
+static k_timepoint_t timepoint_from_seconds(int64_t seconds)
+{
+    if (seconds <= 0) {
+        return sys_timepoint_calc(K_NO_WAIT);
+    }
+    return sys_timepoint_calc(K_SECONDS(seconds));
+}
+
+static astarte_result_t discard_client_crt(astarte_device_handle_t device)
+{
+    astarte_tls_credentials_client_crt_t *client_crt = &device->client_crt;
+
+    astarte_result_t ares = astarte_tls_credential_delete();
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Can't delete the client TLS cert: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+    ares = astarte_device_caching_client_crt_delete();
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Can't delete the stored client cert: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+#endif
+    memset(client_crt->privkey_pem, 0, ARRAY_SIZE(client_crt->privkey_pem));
+    memset(client_crt->crt_pem, 0, ARRAY_SIZE(client_crt->crt_pem));
+    device->client_crt_expiry_timepoint = sys_timepoint_calc(K_FOREVER);
+    device->client_crt_renewal_timepoint = sys_timepoint_calc(K_FOREVER);
+    return ASTARTE_RESULT_OK;
+}
+
+static astarte_result_t obtain_client_crt(astarte_device_handle_t device)
+{
+    astarte_tls_credentials_client_crt_t *client_crt = &device->client_crt;
+
+    astarte_result_t ares = request_client_crt(device, client_crt);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Failed getting the client TLS cert: %s.", astarte_result_to_name(ares));
+        memset(client_crt->privkey_pem, 0, ARRAY_SIZE(client_crt->privkey_pem));
+        memset(client_crt->crt_pem, 0, ARRAY_SIZE(client_crt->crt_pem));
+        return ares;
+    }
+
+    ares = astarte_tls_credential_add(client_crt);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Failed adding the client TLS cert: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+
+    // A certificate that can't be parsed locally is left for the broker to judge
+    (void) update_timepoints(device, true);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+    // A failure in storing the certificate only impacts the following boots
+    astarte_result_t store_ares
+        = astarte_device_caching_client_crt_store(device->device_id, client_crt);
+    if (store_ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_WRN("Failed storing the client cert: %s.", astarte_result_to_name(store_ares));
+    }
+#endif
+
+    return ares;
+}
+
+static void swap_client_crt(
+    astarte_tls_credentials_client_crt_t *first, astarte_tls_credentials_client_crt_t *second)
+{
+    uint8_t *first_bytes = (uint8_t *) first;
+    uint8_t *second_bytes = (uint8_t *) second;
+    for (size_t i = 0; i < sizeof(astarte_tls_credentials_client_crt_t); i++) {
+        uint8_t byte = first_bytes[i];
+        first_bytes[i] = second_bytes[i];
+        second_bytes[i] = byte;
+    }
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE_CREDENTIALS)
+static astarte_result_t load_stored_client_crt(astarte_device_handle_t device)
+{
+    astarte_tls_credentials_client_crt_t *client_crt = &device->client_crt;
+
+    astarte_result_t ares = astarte_device_caching_client_crt_load(device->device_id, client_crt);
+    if (ares != ASTARTE_RESULT_OK) {
+        if (ares != ASTARTE_RESULT_NOT_FOUND) {
+            ASTARTE_LOG_WRN(
+                "Failed loading the stored client cert: %s.", astarte_result_to_name(ares));
+        }
+        return ASTARTE_RESULT_NOT_FOUND;
+    }
+
+    // Without a wall clock (or before it has been synchronized) the TLS handshake is the judge
+    ares = update_timepoints(device, false);
+    if (ares != ASTARTE_RESULT_OK) {
+        memset(client_crt->privkey_pem, 0, ARRAY_SIZE(client_crt->privkey_pem));
+        memset(client_crt->crt_pem, 0, ARRAY_SIZE(client_crt->crt_pem));
+        ares = astarte_device_caching_client_crt_delete();
+        if (ares != ASTARTE_RESULT_OK) {
+            ASTARTE_LOG_WRN(
+                "Can't delete the stored client cert: %s.", astarte_result_to_name(ares));
+        }
+        return ASTARTE_RESULT_NOT_FOUND;
+    }
+
+    ares = astarte_tls_credential_add(client_crt);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Failed adding the client TLS cert: %s.", astarte_result_to_name(ares));
+        return ares;
+    }
+
+    ASTARTE_LOG_DBG("Using the stored client cert.");
+    return ASTARTE_RESULT_OK;
+}
+#endif
+
+static astarte_result_t request_client_crt(
+    astarte_device_handle_t device, astarte_tls_credentials_client_crt_t *client_crt)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+    unsigned char csr_pem[ASTARTE_CRYPTO_CSR_BUFFER_SIZE] = { 0 };
+    if (take_pregen(device, client_crt->privkey_pem, csr_pem)) {
+        ASTARTE_LOG_DBG("Using the pre-generated key for the client cert.");
+        astarte_result_t ares = astarte_pairing_request_client_certificate(
+            device->http_timeout_ms, device->device_id, device->cred_secr, csr_pem, client_crt);
+        memset(csr_pem, 0, sizeof(csr_pem));
+        return ares;
+    }
+#endif
+
+    return astarte_pairing_get_client_certificate(
+        device->http_timeout_ms, device->device_id, device->cred_secr, client_crt);
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+static void pregen_work_q_start(void)
+{
+    int mutex_rc = sys_mutex_lock(&pregen_work_q_mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+
+    if (!pregen_work_q_started) {
+        struct k_work_queue_config cfg = {
+            .name = "astarte_crt_pregen",
+            .no_yield = false,
+        };
+        k_work_queue_start(&pregen_work_q, pregen_work_q_stack,
+            K_THREAD_STACK_SIZEOF(pregen_work_q_stack), K_LOWEST_APPLICATION_THREAD_PRIO, &cfg);
+        pregen_work_q_started = true;
+    }
+
+    mutex_rc = sys_mutex_unlock(&pregen_work_q_mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+
+static void pregen_work_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct astarte_device *device
+        = CONTAINER_OF(dwork, struct astarte_device, client_crt_pregen_work);
+
+    int mutex_rc = sys_mutex_lock(&device->client_crt_pregen_mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+
+    device->client_crt_pregen_ready = false;
+    ASTARTE_LOG_DBG("Pre-generating the key for the next client cert.");
+    astarte_result_t ares = astarte_crypto_create_key(device->client_crt_pregen_privkey_pem,
+        ARRAY_SIZE(device->client_crt_pregen_privkey_pem));
+    if (ares == ASTARTE_RESULT_OK) {
+        ares = astarte_crypto_create_csr(device->client_crt_pregen_privkey_pem,
+            device->client_crt_pregen_csr_pem, ARRAY_SIZE(device->client_crt_pregen_csr_pem));
+    }
+    if (ares == ASTARTE_RESULT_OK) {
+        device->client_crt_pregen_ready = true;
+    } else {
+        // The key will be generated when requesting the certificate
+        ASTARTE_LOG_WRN("Key pre-generation failed: %s.", astarte_result_to_name(ares));
+        memset(device->client_crt_pregen_privkey_pem, 0,
+            sizeof(device->client_crt_pregen_privkey_pem));
+        memset(device->client_crt_pregen_csr_pem, 0, sizeof(device->client_crt_pregen_csr_pem));
+    }
+
+    mutex_rc = sys_mutex_unlock(&device->client_crt_pregen_mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+
+static bool take_pregen(astarte_device_handle_t device, char *privkey_pem, unsigned char *csr_pem)
+{
+    // Don't wait for an ongoing generation, the caller will generate the key by itself
+    if (sys_mutex_lock(&device->client_crt_pregen_mutex, K_NO_WAIT) != 0) {
+        return false;
+    }
+
+    bool taken = device->client_crt_pregen_ready;
+    if (taken) {
+        memcpy(privkey_pem, device->client_crt_pregen_privkey_pem,
+            sizeof(device->client_crt_pregen_privkey_pem));
+        memcpy(csr_pem, device->client_crt_pregen_csr_pem,
+            sizeof(device->client_crt_pregen_csr_pem));
+        device->client_crt_pregen_ready = false;
+        memset(device->client_crt_pregen_privkey_pem, 0,
+            sizeof(device->client_crt_pregen_privkey_pem));
+        memset(device->client_crt_pregen_csr_pem, 0, sizeof(device->client_crt_pregen_csr_pem));
+    }
+
+    int mutex_rc = sys_mutex_unlock(&device->client_crt_pregen_mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+    return taken;
+}
+#endif
+
+static void schedule_pregen(astarte_device_handle_t device, k_timeout_t timeout)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+    pregen_work_q_start();
+    (void) k_work_reschedule_for_queue(&pregen_work_q, &device->client_crt_pregen_work, timeout);
+#else
+    (void) device;
+    (void) timeout;
+#endif
+}
@@ -5,40 +5,127 @@
  */
 #include "device_connection.h"
 
+#include "device_client_crt.h"
+#include "device_tx.h"
+#include "pairing_private.h"
+
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
 #include "astarte_zlib.h"
 #include "device_caching.h"
-#include "device_tx.h"
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+#include "device_rx.h"
 #endif
 
+#include "heap_private.h"
 #include "log.h"
+#include "metrics_private.h"
 ASTARTE_LOG_MODULE_REGISTER(
     device_connection, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_CONNECTION_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_DEVICE_CONNECTION);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+/** @brief Struct used to track the transmitted device owned properties until acknowledged. */
+struct property_ack_node
+{
+    sys_snode_t node;
+    uint16_t message_id;
+    char *interface_name;
+    char *path;
+};
+#endif
 
 /************************************************
  *         Static functions declaration         *
  ***********************************************/
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+/**
+ * @brief Expiry function for the device deadline timer, raises the device poll signal.
+ *
+ * @param[in] timer Deadline timer of the device.
+ */
+static void deadline_timer_expiry(struct k_timer *timer);
+/**
+ * @brief Re-arm the deadline timer to the next device deadline.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void rearm_deadline_timer(astarte_device_handle_t device);
+#endif
+
+/**
+ * @brief Get the next deadline of the connection state machine.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return The timeout to the next deadline, K_FOREVER when none is pending.
+ */
+static k_timeout_t get_state_machine_deadline(astarte_device_handle_t device);
+
 /**
  * @brief Setup all the MQTT subscriptions for the device.
  *
+ * @details The message IDs of the subscriptions are tracked as the first handshake messages, and
+ * stored for each topic filter to map the SUBACK return codes.
+ *
  * @param[in] device Handle to the device instance.
- * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
  */
-static astarte_result_t setup_subscriptions(astarte_device_handle_t device);
+static void setup_subscriptions(astarte_device_handle_t device);
+/**
+ * @brief Check the SUBACK return codes received for each subscription topic filter.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return True if all the topic filters have been granted, false otherwise.
+ */
+static bool subscriptions_granted(astarte_device_handle_t device);
 /**
  * @brief Send the introspection for the device.
  *
  * @param[in] device Handle to the device instance.
  * @param[in] intr_str The stringified version of the introspection to transmit.
+ * @param[out] out_message_id Stores the MQTT message ID of the introspection.
  */
-static void send_introspection(astarte_device_handle_t device, char *intr_str);
+static void send_introspection(
+    astarte_device_handle_t device, char *intr_str, uint16_t *out_message_id);
 /**
  * @brief Send the emptycache message to Astarte.
  *
  * @param[in] device Handle to the device instance.
+ * @param[out] out_message_id Stores the MQTT message ID of the emptycache message.
+ */
+static void send_emptycache(astarte_device_handle_t device, uint16_t *out_message_id);
+/**
+ * @brief Track the message ID of a handshake message, to be acknowledged before connecting.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] message_id MQTT message ID to track, zero values are ignored.
+ */
+static void track_handshake_message(astarte_device_handle_t device, uint16_t message_id);
+/**
+ * @brief Check if all the tracked handshake messages have been acknowledged.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return True if no handshake message is pending, false otherwise.
+ */
+static bool handshake_messages_acked(astarte_device_handle_t device);
+/**
+ * @brief Release the tracked handshake messages and stop any ongoing properties resync.
+ *
+ * @param[in] device Handle to the device instance.
  */
-static void send_emptycache(astarte_device_handle_t device);
+static void reset_handshake(astarte_device_handle_t device);
+/**
+ * @brief Mark the synchronization with Astarte as completed and store the introspection digest.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void complete_synchronization(astarte_device_handle_t device);
+/**
+ * @brief Mark the synchronization with Astarte as not completed.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void invalidate_synchronization(astarte_device_handle_t device);
 /**
  * @brief State machine runner code for the state DEVICE_START_HANDSHAKE.
  *
@@ -68,9 +155,11 @@ static void state_machine_connected_run(astarte_device_handle_t device);
  * @brief Send the purge properties message for the device owned properties.
  *
  * @param[in] device Handle to the device instance.
+ * @param[out] out_message_id Stores the MQTT message ID of the purge properties message.
  * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
  */
-static astarte_result_t send_purge_device_properties(astarte_device_handle_t device);
+static astarte_result_t send_purge_device_properties(
+    astarte_device_handle_t device, uint16_t *out_message_id);
 /**
  * @brief Send a single property if present in introspection and if device owned.
  *
@@ -82,16 +171,69 @@ static astarte_result_t send_purge_device_properties(astarte_device_handle_t dev
  * @param[in] path Path for the property as retreived from cache.
  * @param[in] major Major version for the interface of the property as retreived from cache.
  * @param[in] data Data for the property as retreived from cache.
+ * @param[out] out_message_id Stores the MQTT message ID of the property, left untouched when the
+ * property is not sent.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
  */
-static void send_device_owned_property(astarte_device_handle_t device, const char *interface_name,
-    const char *path, uint32_t major, astarte_data_t data);
+static astarte_result_t send_device_owned_property(astarte_device_handle_t device,
+    const char *interface_name, const char *path, uint32_t major, astarte_data_t data,
+    uint16_t *out_message_id);
 /**
- * @brief Send the device owned properties to Astarte.
+ * @brief Load the interface name and path of the cached property pointed by the resync iterator.
  *
  * @param[in] device Handle to the device instance.
  * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
  */
-static astarte_result_t send_device_owned_properties(astarte_device_handle_t device);
+static astarte_result_t load_resync_property(astarte_device_handle_t device);
+/**
+ * @brief Send the cached property pointed by the resync iterator and advance the iterator.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[out] out_message_id Stores the MQTT message ID of the property, left untouched when the
+ * property is not sent.
+ * @return ASTARTE_RESULT_OK if successful, ASTARTE_RESULT_NOT_FOUND when all the properties have
+ * been sent, otherwise an error code.
+ */
+static astarte_result_t send_next_device_owned_property(
+    astarte_device_handle_t device, uint16_t *out_message_id);
+/**
+ * @brief Stop tracking the acknowledgment of all the transmitted device owned properties.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void clear_tracked_properties(astarte_device_handle_t device);
+/**
+ * @brief Start resending the cached device owned properties to Astarte.
+ *
+ * @details When the introspection is unchanged since the last synchronization, only the
+ * properties not acknowledged by Astarte are resent.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void properties_resync_start(astarte_device_handle_t device);
+/**
+ * @brief Stop the properties resync, releasing its iterator.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void properties_resync_stop(astarte_device_handle_t device);
+/**
+ * @brief Advance the properties resync, keeping at most
+ * CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_RESYNC_WINDOW properties waiting for an acknowledgment.
+ *
+ * @details Once all the properties have been sent and acknowledged the synchronization with
+ * Astarte is completed.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void properties_resync_run(astarte_device_handle_t device);
+/**
+ * @brief Check if the properties resync can make progress on the next poll.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return True if the resync can make progress, false otherwise.
+ */
+static bool properties_resync_has_work(astarte_device_handle_t device);
 #endif
 
 /************************************************
@@ -154,6 +296,14 @@ void astarte_device_connection_on_connected_handler(
 
     ASTARTE_LOG_DBG("Device connection state -> START_HANDSHAKE.");
     device->connection_state = DEVICE_START_HANDSHAKE;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS)
+    device->handshake_start_ticks = k_uptime_ticks();
+#endif
+
+    if (device->pairing_session_active) {
+        astarte_pairing_session_end();
+        device->pairing_session_active = false;
+    }
 
     device->mqtt_session_present_flag = connack_param.session_present_flag;
 }
@@ -164,6 +314,9 @@ void astarte_device_connection_on_disconnected_handler(astarte_mqtt_t *astarte_m
 
     ASTARTE_LOG_DBG("Device connection state -> DISCONNECTED.");
     device->connection_state = DEVICE_DISCONNECTED;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    astarte_device_rx_commit_properties(device);
+#endif
 
     if (device->disconnection_cbk) {
         astarte_device_disconnection_event_t event = {
@@ -174,12 +327,24 @@ void astarte_device_connection_on_disconnected_handler(astarte_mqtt_t *astarte_m
     }
 }
 
-void astarte_device_connection_on_subscribed_handler(
-    astarte_mqtt_t *astarte_mqtt, uint16_t message_id, enum mqtt_suback_return_code return_code)
+void astarte_device_connection_on_subscribed_handler(astarte_mqtt_t *astarte_mqtt,
+    uint16_t message_id, size_t topic_index, enum mqtt_suback_return_code return_code)
 {
-    (void) message_id;
     struct astarte_device *device = CONTAINER_OF(astarte_mqtt, struct astarte_device, astarte_mqtt);
 
+    // The filters of a SUBSCRIBE packet are contiguous, map the SUBACK to its topic filter
+    size_t filter = device->subscription_topics_count;
+    for (size_t i = 0; i < device->subscription_topics_count; i++) {
+        if (device->subscription_msg_ids[i] == message_id) {
+            filter = i + topic_index;
+            break;
+        }
+    }
+    if ((filter < device->subscription_topics_count)
+        && (device->subscription_msg_ids[filter] == message_id)) {
+        device->subscription_return_codes[filter] = return_code;
+    }
+
     switch (return_code) {
         case MQTT_SUBACK_SUCCESS_QoS_0:
         case MQTT_SUBACK_SUCCESS_QoS_1:
@@ -195,8 +360,91 @@ void astarte_device_connection_on_subscribed_handler(
     }
 }
 
+astarte_result_t astarte_device_connection_update_subscription_topics(
+    astarte_device_handle_t device)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    const introspection_table_t *table = introspection_acquire(&device->introspection);
+
+    if (device->subscription_topics
+        && (memcmp(device->subscription_topics_digest, table->digest, INTROSPECTION_DIGEST_SIZE)
+            == 0)) {
+        goto exit;
+    }
+
+    // The control topic is followed by one topic filter for each server owned interface
+    size_t control_topic_size = sizeof(device->control_consumer_prop_topic);
+    size_t topics_count = 1;
+    size_t strings_size = control_topic_size;
+    for (size_t i = 0; i < table->count; i++) {
+        const astarte_interface_t *interface = table->interfaces[i];
+        if (interface->ownership == ASTARTE_INTERFACE_OWNERSHIP_SERVER) {
+            topics_count++;
+            strings_size += strlen(CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "///#")
+                + ASTARTE_DEVICE_ID_LEN + strlen(interface->name) + 1;
+        }
+    }
+
+    // The pointers and the strings they point to are stored in a single allocation
+    const char **topics = astarte_calloc(1, topics_count * sizeof(char *) + strings_size);
+    uint8_t *return_codes = astarte_calloc(topics_count, sizeof(uint8_t));
+    uint16_t *msg_ids = astarte_calloc(topics_count, sizeof(uint16_t));
+    if (!topics || !return_codes || !msg_ids) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        astarte_free((void *) topics);
+        astarte_free(return_codes);
+        astarte_free(msg_ids);
+        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+        goto exit;
+    }
+
+    char *strings = (char *) &topics[topics_count];
+    memcpy(strings, device->control_consumer_prop_topic, control_topic_size);
+    topics[0] = strings;
+    strings += control_topic_size;
+
+    size_t topic_idx = 1;
+    for (size_t i = 0; i < table->count; i++) {
+        const astarte_interface_t *interface = table->interfaces[i];
+        if (interface->ownership != ASTARTE_INTERFACE_OWNERSHIP_SERVER) {
+            continue;
+        }
+        size_t topic_len = strlen(CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "///#")
+            + ASTARTE_DEVICE_ID_LEN + strlen(interface->name);
+        int ret = snprintf(strings, topic_len + 1, CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "/%s/%s/#",
+            device->device_id, interface->name);
+        if (ret != topic_len) {
+            ASTARTE_LOG_ERR("Error encoding MQTT topic.");
+            astarte_free((void *) topics);
+            astarte_free(return_codes);
+            astarte_free(msg_ids);
+            ares = ASTARTE_RESULT_INTERNAL_ERROR;
+            goto exit;
+        }
+        topics[topic_idx++] = strings;
+        strings += topic_len + 1;
+    }
+
+    astarte_free((void *) device->subscription_topics);
+    astarte_free(device->subscription_return_codes);
+    astarte_free(device->subscription_msg_ids);
+    device->subscription_topics = topics;
+    device->subscription_topics_count = topics_count;
+    device->subscription_return_codes = return_codes;
+    device->subscription_msg_ids = msg_ids;
+    memcpy(device->subscription_topics_digest, table->digest, INTROSPECTION_DIGEST_SIZE);
+
+exit:
+    introspection_release(table);
+    return ares;
+}
+
 astarte_result_t astarte_device_connection_poll(astarte_device_handle_t device)
 {
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    astarte_device_rx_commit_properties_if_due(device);
+#endif
+
     switch (device->connection_state) {
         case DEVICE_DISCONNECTED:
         case DEVICE_MQTT_CONNECTING:
@@ -217,82 +465,371 @@ astarte_result_t astarte_device_connection_poll(astarte_device_handle_t device)
             break;
     }
 
-    return astarte_mqtt_poll(&device->astarte_mqtt);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+    // The pending events are going to be processed by this poll
+    k_poll_signal_reset(&device->poll_signal);
+#endif
+
+    astarte_result_t ares = astarte_mqtt_poll(&device->astarte_mqtt);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+    rearm_deadline_timer(device);
+#endif
+
+    return ares;
+}
+
+k_timeout_t astarte_device_connection_get_next_deadline(astarte_device_handle_t device)
+{
+    k_timeout_t deadline = get_state_machine_deadline(device);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    k_timeout_t properties_deadline = astarte_device_rx_get_properties_deadline(device);
+    if (K_TIMEOUT_EQ(deadline, K_FOREVER)
+        || (!K_TIMEOUT_EQ(properties_deadline, K_FOREVER)
+            && (properties_deadline.ticks < deadline.ticks))) {
+        deadline = properties_deadline;
+    }
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+    // The held datastream values are only sent while connected
+    if (device->connection_state == DEVICE_CONNECTED) {
+        k_timeout_t filter_deadline = astarte_stream_filter_get_deadline(&device->stream_filter);
+        if (K_TIMEOUT_EQ(deadline, K_FOREVER)
+            || (!K_TIMEOUT_EQ(filter_deadline, K_FOREVER)
+                && (filter_deadline.ticks < deadline.ticks))) {
+            deadline = filter_deadline;
+        }
+    }
+#endif
+    return deadline;
+}
+
+void astarte_device_connection_init_handshake(astarte_device_handle_t device)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    sys_mutex_init(&device->prop_mutex);
+    sys_slist_init(&device->prop_acks);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    astarte_device_rx_init_properties_coalescing(device);
+#endif
+#else
+    (void) device;
+#endif
+}
+
+void astarte_device_connection_deinit_handshake(astarte_device_handle_t device)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    astarte_device_rx_commit_properties(device);
+#endif
+    reset_handshake(device);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_device_connection_lock_properties(device);
+    clear_tracked_properties(device);
+    astarte_device_connection_unlock_properties(device);
+#endif
+    astarte_free((void *) device->subscription_topics);
+    device->subscription_topics = NULL;
+    device->subscription_topics_count = 0;
+    astarte_free(device->subscription_return_codes);
+    device->subscription_return_codes = NULL;
+    astarte_free(device->subscription_msg_ids);
+    device->subscription_msg_ids = NULL;
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+void astarte_device_connection_lock_properties(astarte_device_handle_t device)
+{
+    int mutex_rc = sys_mutex_lock(&device->prop_mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+
+void astarte_device_connection_unlock_properties(astarte_device_handle_t device)
+{
+    int mutex_rc = sys_mutex_unlock(&device->prop_mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+
+void astarte_device_connection_track_property(astarte_device_handle_t device,
+    const char *interface_name, const char *path, uint16_t message_id)
+{
+    sys_snode_t *prev_node = NULL;
+    sys_snode_t *node = NULL;
+    sys_snode_t *safe_node = NULL;
+    SYS_SLIST_FOR_EACH_NODE_SAFE(&device->prop_acks, node, safe_node)
+    {
+        struct property_ack_node *ack_node = CONTAINER_OF(node, struct property_ack_node, node);
+        if ((strcmp(ack_node->interface_name, interface_name) == 0)
+            && (strcmp(ack_node->path, path) == 0)) {
+            sys_slist_remove(&device->prop_acks, prev_node, node);
+            astarte_free(ack_node);
+        } else {
+            prev_node = node;
+        }
+    }
+
+    if (message_id == 0U) {
+        return;
+    }
+
+    // The node and its strings are stored in a single allocation
+    size_t interface_name_size = strlen(interface_name) + 1;
+    size_t path_size = strlen(path) + 1;
+    struct property_ack_node *ack_node
+        = astarte_calloc(1, sizeof(struct property_ack_node) + interface_name_size + path_size);
+    if (!ack_node) {
+        // The property will be considered not acknowledged and resent on the next reconnection
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return;
+    }
+    ack_node->message_id = message_id;
+    ack_node->interface_name = (char *) &ack_node[1];
+    memcpy(ack_node->interface_name, interface_name, interface_name_size);
+    ack_node->path = ack_node->interface_name + interface_name_size;
+    memcpy(ack_node->path, path, path_size);
+    sys_slist_append(&device->prop_acks, &ack_node->node);
+}
+
+void astarte_device_connection_on_delivered_handler(
+    astarte_mqtt_t *astarte_mqtt, uint16_t message_id)
+{
+    struct astarte_device *device = CONTAINER_OF(astarte_mqtt, struct astarte_device, astarte_mqtt);
+
+    astarte_device_connection_lock_properties(device);
+
+    sys_snode_t *prev_node = NULL;
+    sys_snode_t *node = NULL;
+    SYS_SLIST_FOR_EACH_NODE(&device->prop_acks, node)
+    {
+        struct property_ack_node *ack_node = CONTAINER_OF(node, struct property_ack_node, node);
+        if (ack_node->message_id == message_id) {
+            sys_slist_remove(&device->prop_acks, prev_node, node);
+            astarte_result_t ares = astarte_device_caching_property_set_acked(
+                ack_node->interface_name, ack_node->path);
+            ASTARTE_LOG_COND_ERR((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND),
+                "Failed marking the cached property as acked: %s", astarte_result_to_name(ares));
+            astarte_free(ack_node);
+            break;
+        }
+        prev_node = node;
+    }
+
+    astarte_device_connection_unlock_properties(device);
+}
+
+void astarte_device_connection_on_property_deleted(astarte_device_handle_t device)
+{
+    if (!device->prop_resync_active || device->prop_resync_restart || device->prop_resync_sent) {
+        return;
+    }
+
+    // Deletions shift back the cached entries stored after the deleted one, the properties already
+    // resent are not queued again
+    astarte_result_t ares = astarte_device_caching_property_iterator_realign(
+        &device->prop_resync_iter, device->prop_resync_interface_name, device->prop_resync_path);
+    if (ares == ASTARTE_RESULT_OK) {
+        ares = load_resync_property(device);
+    }
+    if (ares == ASTARTE_RESULT_NOT_FOUND) {
+        device->prop_resync_sent = true;
+    } else if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR(
+            "Failed realigning the properties resync: %s", astarte_result_to_name(ares));
+        device->prop_resync_restart = true;
+    }
+}
+#endif
+
+void astarte_device_connection_init_poll_signal(astarte_device_handle_t device)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+    k_poll_signal_init(&device->poll_signal);
+    k_timer_init(&device->deadline_timer, deadline_timer_expiry, NULL);
+#else
+    (void) device;
+#endif
+}
+
+void astarte_device_connection_deinit_poll_signal(astarte_device_handle_t device)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+    k_timer_stop(&device->deadline_timer);
+#else
+    (void) device;
+#endif
+}
+
+void astarte_device_connection_raise_poll_signal(astarte_device_handle_t device)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+    k_poll_signal_raise(&device->poll_signal, 0);
+#else
+    (void) device;
+#endif
 }
 
 /************************************************
  *         Static functions definitions         *
  ***********************************************/
 
-static astarte_result_t setup_subscriptions(astarte_device_handle_t device)
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+static void deadline_timer_expiry(struct k_timer *timer)
 {
-    const char *topic = device->control_consumer_prop_topic;
-    ASTARTE_LOG_DBG("Subscribing to: %s", topic);
-    astarte_mqtt_subscribe(&device->astarte_mqtt, topic, 2, NULL);
+    struct astarte_device *device = CONTAINER_OF(timer, struct astarte_device, deadline_timer);
+    k_poll_signal_raise(&device->poll_signal, 0);
+}
 
-    for (introspection_node_t *iterator = introspection_iter(&device->introspection);
-        iterator != NULL; iterator = introspection_iter_next(&device->introspection, iterator)) {
-        const astarte_interface_t *interface = iterator->interface;
+static void rearm_deadline_timer(astarte_device_handle_t device)
+{
+    k_timeout_t deadline = astarte_device_connection_get_next_deadline(device);
+    if (K_TIMEOUT_EQ(deadline, K_FOREVER)) {
+        k_timer_stop(&device->deadline_timer);
+    } else {
+        k_timer_start(&device->deadline_timer, deadline, K_NO_WAIT);
+    }
+}
+#endif
 
-        if (interface->ownership == ASTARTE_INTERFACE_OWNERSHIP_SERVER) {
-            size_t topic_len = strlen(CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "///#")
-                + ASTARTE_DEVICE_ID_LEN + strlen(interface->name);
-            char *topic = calloc(topic_len + 1, sizeof(char));
-            if (!topic) {
-                ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-                return ASTARTE_RESULT_OUT_OF_MEMORY;
-            }
+static void setup_subscriptions(astarte_device_handle_t device)
+{
+    memset(device->subscription_return_codes, MQTT_SUBACK_FAILURE,
+        device->subscription_topics_count);
+    memset(device->subscription_msg_ids, 0, device->subscription_topics_count * sizeof(uint16_t));
 
-            int ret
-                = snprintf(topic, topic_len + 1, CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "/%s/%s/#",
-                    device->device_id, interface->name);
-            if (ret != topic_len) {
-                ASTARTE_LOG_ERR("Error encoding MQTT topic.");
-                free(topic);
-                return ASTARTE_RESULT_INTERNAL_ERROR;
-            }
+    size_t topic_idx = 0;
+    while (topic_idx < device->subscription_topics_count) {
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_MQTT_BATCH_SUBSCRIPTIONS)
+        // As many filters as fit in the MQTT TX buffer are sent in each packet
+        size_t batch_size = device->subscription_topics_count - topic_idx;
+#else
+        size_t batch_size = 1;
+#endif
+        uint16_t message_id = 0U;
+        size_t sent = astarte_mqtt_subscribe_multiple(&device->astarte_mqtt,
+            &device->subscription_topics[topic_idx], batch_size, 2, &message_id);
+        if (sent == 0) {
+            // The filters left are never granted, the handshake will fail
+            return;
+        }
+        ASTARTE_LOG_DBG("Subscribing to %zu topics, first: %s", sent,
+            device->subscription_topics[topic_idx]);
+        for (size_t i = topic_idx; i < topic_idx + sent; i++) {
+            device->subscription_msg_ids[i] = message_id;
+        }
+        track_handshake_message(device, message_id);
+        topic_idx += sent;
+    }
+}
 
-            ASTARTE_LOG_DBG("Subscribing to: %s", topic);
-            astarte_mqtt_subscribe(&device->astarte_mqtt, topic, 2, NULL);
-            free(topic);
+static bool subscriptions_granted(astarte_device_handle_t device)
+{
+    bool granted = true;
+    for (size_t i = 0; i < device->subscription_topics_count; i++) {
+        if (device->subscription_return_codes[i] == MQTT_SUBACK_FAILURE) {
+            ASTARTE_LOG_ERR("Subscription denied for: %s", device->subscription_topics[i]);
+            granted = false;
         }
     }
-    return ASTARTE_RESULT_OK;
+    return granted;
 }
 
-static void send_introspection(astarte_device_handle_t device, char *intr_str)
+static void send_introspection(
+    astarte_device_handle_t device, char *intr_str, uint16_t *out_message_id)
 {
     const char *topic = device->base_topic;
     ASTARTE_LOG_DBG("Publishing introspection: %s", intr_str);
-    astarte_mqtt_publish(&device->astarte_mqtt, topic, intr_str, strlen(intr_str), 2, NULL);
+    astarte_mqtt_publish(
+        &device->astarte_mqtt, topic, intr_str, strlen(intr_str), 2, out_message_id);
 }
 
-static void send_emptycache(astarte_device_handle_t device)
+static void send_emptycache(astarte_device_handle_t device, uint16_t *out_message_id)
 {
     const char *topic = device->control_empty_cache_topic;
     ASTARTE_LOG_DBG("Sending emptyCache to %s", topic);
-    astarte_mqtt_publish(&device->astarte_mqtt, topic, "1", strlen("1"), 2, NULL);
+    astarte_mqtt_publish(&device->astarte_mqtt, topic, "1", strlen("1"), 2, out_message_id);
+}
+
+static void track_handshake_message(astarte_device_handle_t device, uint16_t message_id)
+{
+    if ((message_id == 0U) || (device->handshake_msg_ids_len >= device->handshake_msg_ids_size)) {
+        return;
+    }
+    device->handshake_msg_ids[device->handshake_msg_ids_len++] = message_id;
+}
+
+static bool handshake_messages_acked(astarte_device_handle_t device)
+{
+    for (size_t i = 0; i < device->handshake_msg_ids_len; i++) {
+        if (astarte_mqtt_is_pending_outgoing(&device->astarte_mqtt, device->handshake_msg_ids[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void reset_handshake(astarte_device_handle_t device)
+{
+    astarte_free(device->handshake_msg_ids);
+    device->handshake_msg_ids = NULL;
+    device->handshake_msg_ids_len = 0;
+    device->handshake_msg_ids_size = 0;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    properties_resync_stop(device);
+#endif
+}
+
+static void complete_synchronization(astarte_device_handle_t device)
+{
+    ASTARTE_LOG_DBG("Device synchronization completed.");
+    device->synchronization_completed = true;
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_result_t ares = astarte_device_caching_synchronization_set(true);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Synchronization state set failure %s.", astarte_result_to_name(ares));
+    }
+
+    uint8_t intr_digest[INTROSPECTION_DIGEST_SIZE] = { 0 };
+    introspection_get_digest(&device->introspection, intr_digest);
+    ares = astarte_device_caching_introspection_check(intr_digest);
+    if (ares == ASTARTE_RESULT_DEVICE_CACHING_OUTDATED_INTROSPECTION) {
+        ASTARTE_LOG_DBG("Introspection requires updating.");
+        ares = astarte_device_caching_introspection_store(intr_digest);
+    }
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_DBG("Introspection update failed: %s", astarte_result_to_name(ares));
+    }
+#endif
+}
+
+static void invalidate_synchronization(astarte_device_handle_t device)
+{
+    if (!device->synchronization_completed) {
+        return;
+    }
+    device->synchronization_completed = false;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_result_t ares = astarte_device_caching_synchronization_set(false);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Synchronization state set failure %s.", astarte_result_to_name(ares));
+    }
+#endif
 }
 
 static void state_machine_start_handshake_run(astarte_device_handle_t device)
 {
     device->subscription_failure = false;
+    reset_handshake(device);
 
     char *intr_str = NULL;
-    size_t intr_str_size = introspection_get_string_size(&device->introspection);
-
-    intr_str = calloc(intr_str_size, sizeof(char));
-    if (!intr_str) {
-        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-        ASTARTE_LOG_DBG("Device connection state -> HANDSHAKE_ERROR.");
-        device->connection_state = DEVICE_HANDSHAKE_ERROR;
-        goto exit;
-    }
-    introspection_fill_string(&device->introspection, intr_str, intr_str_size);
 
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
     if ((device->mqtt_session_present_flag != 0) && device->synchronization_completed) {
-        astarte_result_t ares = astarte_device_caching_introspection_check(intr_str, intr_str_size);
+        uint8_t intr_digest[INTROSPECTION_DIGEST_SIZE] = { 0 };
+        introspection_get_digest(&device->introspection, intr_digest);
+        astarte_result_t ares = astarte_device_caching_introspection_check(intr_digest);
         if (ares == ASTARTE_RESULT_OK) {
             ASTARTE_LOG_DBG("Device connection state -> END_HANDSHAKE.");
             device->connection_state = DEVICE_END_HANDSHAKE;
@@ -307,97 +844,127 @@ static void state_machine_start_handshake_run(astarte_device_handle_t device)
     }
 #endif
 
-    if (setup_subscriptions(device) != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_DBG("Device connection state -> HANDSHAKE_ERROR.");
-        device->connection_state = DEVICE_HANDSHAKE_ERROR;
-        goto exit;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+    // Astarte might not hold the last values set, the full handshake sends all of them again
+    astarte_device_tx_clear_property_digests(device);
+#endif
+
+    // A full handshake is starting, an interrupted one should not be considered synchronized
+    invalidate_synchronization(device);
+
+    // Topic filters are only rebuilt if the introspection changed since the last handshake
+    if (astarte_device_connection_update_subscription_topics(device) != ASTARTE_RESULT_OK) {
+        goto error;
     }
-    send_introspection(device, intr_str);
-    send_emptycache(device);
-#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
-    if (send_purge_device_properties(device) != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_DBG("Device connection state -> HANDSHAKE_ERROR.");
-        device->connection_state = DEVICE_HANDSHAKE_ERROR;
-        goto exit;
+
+    // Subscriptions, introspection, emptyCache and purge properties
+    size_t msg_ids_size = device->subscription_topics_count + 3;
+    device->handshake_msg_ids = astarte_calloc(msg_ids_size, sizeof(uint16_t));
+    if (!device->handshake_msg_ids) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        goto error;
     }
-    if (send_device_owned_properties(device) != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_DBG("Device connection state -> HANDSHAKE_ERROR.");
-        device->connection_state = DEVICE_HANDSHAKE_ERROR;
-        goto exit;
+    device->handshake_msg_ids_size = msg_ids_size;
+
+    // The introspection string is only built when it has to be transmitted
+    size_t intr_str_size = introspection_get_string_size(&device->introspection);
+    intr_str = astarte_calloc(intr_str_size, sizeof(char));
+    if (!intr_str) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        goto error;
+    }
+    introspection_fill_string(&device->introspection, intr_str, intr_str_size);
+
+    setup_subscriptions(device);
+    uint16_t message_id = 0U;
+    send_introspection(device, intr_str, &message_id);
+    track_handshake_message(device, message_id);
+    message_id = 0U;
+    send_emptycache(device, &message_id);
+    track_handshake_message(device, message_id);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    message_id = 0U;
+    if (send_purge_device_properties(device, &message_id) != ASTARTE_RESULT_OK) {
+        goto error;
     }
+    track_handshake_message(device, message_id);
+    // The cached properties are resent while waiting for the handshake acknowledgments
+    properties_resync_start(device);
 #endif
     ASTARTE_LOG_DBG("Device connection state -> END_HANDSHAKE.");
     device->connection_state = DEVICE_END_HANDSHAKE;
+    goto exit;
+
+error:
+    ASTARTE_LOG_DBG("Device connection state -> HANDSHAKE_ERROR.");
+    device->connection_state = DEVICE_HANDSHAKE_ERROR;
 
 exit:
-    free(intr_str);
+    astarte_free(intr_str);
 }
 
 static void state_machine_end_handshake_run(astarte_device_handle_t device)
 {
-    char *intr_str = NULL;
     if (device->subscription_failure) {
         ASTARTE_LOG_ERR("Subscription request has been denied.");
         ASTARTE_LOG_DBG("Device connection state -> HANDSHAKE_ERROR.");
         device->connection_state = DEVICE_HANDSHAKE_ERROR;
-        goto exit;
+        return;
     }
-    if (!astarte_mqtt_has_pending_outgoing(&device->astarte_mqtt)) {
-        ASTARTE_LOG_DBG("Device synchronization completed.");
-        device->synchronization_completed = true;
-        ASTARTE_LOG_DBG("Device connection state -> CONNECTED.");
-        device->connection_state = DEVICE_CONNECTED;
 
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
-        astarte_result_t ares = astarte_device_caching_synchronization_set(true);
-        if (ares != ASTARTE_RESULT_OK) {
-            ASTARTE_LOG_ERR("Synchronization state set failure %s.", astarte_result_to_name(ares));
-        }
+    properties_resync_run(device);
+#endif
 
-        size_t intr_str_size = introspection_get_string_size(&device->introspection);
-        intr_str = calloc(intr_str_size, sizeof(char));
-        if (!intr_str) {
-            ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-            ASTARTE_LOG_DBG("Device connection state -> HANDSHAKE_ERROR.");
-            device->connection_state = DEVICE_HANDSHAKE_ERROR;
-            goto exit;
-        }
-        introspection_fill_string(&device->introspection, intr_str, intr_str_size);
+    if (!handshake_messages_acked(device)) {
+        return;
+    }
 
-        ares = astarte_device_caching_introspection_check(intr_str, intr_str_size);
-        if (ares == ASTARTE_RESULT_DEVICE_CACHING_OUTDATED_INTROSPECTION) {
-            ASTARTE_LOG_DBG("Introspection requires updating.");
-            ares = astarte_device_caching_introspection_store(intr_str, intr_str_size);
-        }
-        if (ares != ASTARTE_RESULT_OK) {
-            ASTARTE_LOG_DBG("Introspection update failed: %s", astarte_result_to_name(ares));
-        }
-#endif
+    // Handshake messages are only tracked when the subscriptions have been requested
+    if (device->handshake_msg_ids && !subscriptions_granted(device)) {
+        ASTARTE_LOG_DBG("Device connection state -> HANDSHAKE_ERROR.");
+        device->connection_state = DEVICE_HANDSHAKE_ERROR;
+        return;
+    }
 
-        if (device->connection_cbk) {
-            astarte_device_connection_event_t event = {
-                .device = device,
-                .user_data = device->cbk_user_data,
-            };
-            device->connection_cbk(event);
-        }
+    astarte_free(device->handshake_msg_ids);
+    device->handshake_msg_ids = NULL;
+    device->handshake_msg_ids_len = 0;
+    device->handshake_msg_ids_size = 0;
+
+    ASTARTE_LOG_DBG("Device connection state -> CONNECTED.");
+    device->connection_state = DEVICE_CONNECTED;
+    ASTARTE_METRICS_RECORD(ASTARTE_METRICS_HISTOGRAM_HANDSHAKE,
+        (uint32_t) k_ticks_to_us_floor64(k_uptime_ticks() - device->handshake_start_ticks));
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    // The synchronization is completed by the resync once all the properties have been acked
+    if (device->prop_resync_active) {
+        ASTARTE_LOG_DBG("Device properties resync continues in background.");
+    } else {
+        complete_synchronization(device);
     }
+#else
+    complete_synchronization(device);
+#endif
 
-exit:
-    free(intr_str);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    // The server properties received during the handshake are written in a single batch
+    astarte_device_rx_commit_properties(device);
+#endif
+
+    if (device->connection_cbk) {
+        astarte_device_connection_event_t event = {
+            .device = device,
+            .user_data = device->cbk_user_data,
+        };
+        device->connection_cbk(event);
+    }
 }
 
 static void state_machine_handshake_error_run(astarte_device_handle_t device)
 {
-    if (device->synchronization_completed) {
-        device->synchronization_completed = false;
-#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
-        astarte_result_t ares = astarte_device_caching_synchronization_set(false);
-        if (ares != ASTARTE_RESULT_OK) {
-            ASTARTE_LOG_ERR("Synchronization state set failure %s.", astarte_result_to_name(ares));
-        }
-#endif
-    }
+    invalidate_synchronization(device);
     if (K_TIMEOUT_EQ(sys_timepoint_timeout(device->reconnection_timepoint), K_NO_WAIT)) {
         // Repeat the handshake procedure
         device->connection_state = DEVICE_START_HANDSHAKE;
@@ -414,10 +981,21 @@ static void state_machine_connected_run(astarte_device_handle_t device)
     backoff_context_init(&device->backoff_ctx,
         CONFIG_ASTARTE_DEVICE_SDK_RECONNECTION_ASTARTE_BACKOFF_INITIAL_MS,
         CONFIG_ASTARTE_DEVICE_SDK_RECONNECTION_ASTARTE_BACKOFF_MAX_MS, true);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    properties_resync_run(device);
+#endif
+
+    astarte_device_client_crt_renew(device);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+    astarte_device_tx_flush_filtered(device);
+#endif
 }
 
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
-static astarte_result_t send_purge_device_properties(astarte_device_handle_t device)
+static astarte_result_t send_purge_device_properties(
+    astarte_device_handle_t device, uint16_t *out_message_id)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     char *intr_str = NULL;
@@ -431,7 +1009,7 @@ static astarte_result_t send_purge_device_properties(astarte_device_handle_t dev
         goto exit;
     }
     if (intr_str_size != 0) {
-        intr_str = calloc(intr_str_size, sizeof(char));
+        intr_str = astarte_calloc(intr_str_size, sizeof(char));
         if (!intr_str) {
             ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
             ares = ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -452,7 +1030,7 @@ static astarte_result_t send_purge_device_properties(astarte_device_handle_t dev
     uLongf compressed_len = compressBound(compression_input_len);
     // Allocate enough memory for the payload
     size_t payload_size = 4 + compressed_len;
-    payload = calloc(payload_size, sizeof(uint8_t));
+    payload = astarte_calloc(payload_size, sizeof(uint8_t));
     if (!payload) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -484,106 +1062,300 @@ static astarte_result_t send_purge_device_properties(astarte_device_handle_t dev
     const int qos = 2;
     ASTARTE_LOG_INF("Sending purge properties to: '%s', with uncompressed content: '%s'", topic,
         (compression_input) ? compression_input : "");
-    astarte_mqtt_publish(&device->astarte_mqtt, topic, payload, payload_size, qos, NULL);
+    // Hand the payload buffer over to a shared MQTT payload to avoid copying it
+    astarte_mqtt_payload_t *mqtt_payload = astarte_mqtt_payload_wrap(payload, payload_size);
+    if (!mqtt_payload) {
+        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+        goto exit;
+    }
+    payload = NULL;
+    astarte_mqtt_publish_payload(&device->astarte_mqtt, topic, mqtt_payload, qos, out_message_id);
+    astarte_mqtt_payload_unref(mqtt_payload);
 
 exit:
-    free(intr_str);
-    free(payload);
+    astarte_free(intr_str);
+    astarte_free(payload);
     return ares;
 }
 
-static void send_device_owned_property(astarte_device_handle_t device, const char *interface_name,
-    const char *path, uint32_t major, astarte_data_t data)
+static astarte_result_t send_device_owned_property(astarte_device_handle_t device,
+    const char *interface_name, const char *path, uint32_t major, astarte_data_t data,
+    uint16_t *out_message_id)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     const astarte_interface_t *interface = introspection_get(
         &device->introspection, interface_name);
     if ((!interface) || (interface->major_version != major)) {
         ASTARTE_LOG_DBG("Removing property from storage: '%s%s'", interface_name, path);
+        // The cache is iterated backwards, deleting the current entry keeps the iterator valid
         ares = astarte_device_caching_property_delete(interface_name, path);
-        if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
-            ASTARTE_LOG_COND_ERR(ares != ASTARTE_RESULT_OK,
-                "Failed deleting the cached property: %s", astarte_result_to_name(ares));
-        }
-        return;
+        ASTARTE_LOG_COND_ERR((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND),
+            "Failed deleting the cached property: %s", astarte_result_to_name(ares));
+        return ASTARTE_RESULT_OK;
     }
 
     if (interface->ownership == ASTARTE_INTERFACE_OWNERSHIP_DEVICE) {
-        ares = astarte_device_tx_stream_individual(device, interface_name, path, data, NULL);
-        ASTARTE_LOG_COND_ERR(ares != ASTARTE_RESULT_OK, "Failed sending cached property: %s",
-            astarte_result_to_name(ares));
+        if (device->prop_resync_delta) {
+            bool acked = false;
+            ares = astarte_device_caching_property_is_acked(interface_name, path, &acked);
+            if ((ares == ASTARTE_RESULT_OK) && acked) {
+                ASTARTE_LOG_DBG("Skipping acked property: '%s%s'", interface_name, path);
+                return ASTARTE_RESULT_OK;
+            }
+        }
+        uint16_t message_id = 0U;
+        ares = astarte_device_tx_stream_individual(
+            device, interface_name, path, data, NULL, &message_id);
+        if (ares != ASTARTE_RESULT_OK) {
+            ASTARTE_LOG_ERR("Failed sending cached property: %s", astarte_result_to_name(ares));
+            return ares;
+        }
+        astarte_device_connection_track_property(device, interface_name, path, message_id);
+        *out_message_id = message_id;
     }
+    return ASTARTE_RESULT_OK;
 }
 
-static astarte_result_t send_device_owned_properties(astarte_device_handle_t device)
+static astarte_result_t load_resync_property(astarte_device_handle_t device)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
-    astarte_device_caching_property_iter_t iter = { 0 };
-    char *interface_name = NULL;
-    char *path = NULL;
+
+    astarte_free(device->prop_resync_interface_name);
+    astarte_free(device->prop_resync_path);
+    device->prop_resync_interface_name = NULL;
+    device->prop_resync_path = NULL;
+
+    size_t interface_name_size = 0U;
+    size_t path_size = 0U;
+    ares = astarte_device_caching_property_iterator_get(
+        &device->prop_resync_iter, NULL, &interface_name_size, NULL, &path_size);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Properties iterator get error: %s", astarte_result_to_name(ares));
+        return ares;
+    }
+
+    // Allocate space for the name and path
+    device->prop_resync_interface_name = astarte_calloc(interface_name_size, sizeof(char));
+    device->prop_resync_path = astarte_calloc(path_size, sizeof(char));
+    if (!device->prop_resync_interface_name || !device->prop_resync_path) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return ASTARTE_RESULT_OUT_OF_MEMORY;
+    }
+
+    ares = astarte_device_caching_property_iterator_get(&device->prop_resync_iter,
+        device->prop_resync_interface_name, &interface_name_size, device->prop_resync_path,
+        &path_size);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Properties iterator get error: %s", astarte_result_to_name(ares));
+    }
+    return ares;
+}
+
+static astarte_result_t send_next_device_owned_property(
+    astarte_device_handle_t device, uint16_t *out_message_id)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    const char *interface_name = device->prop_resync_interface_name;
+    const char *path = device->prop_resync_path;
     astarte_data_t data = { 0 };
 
-    ares = astarte_device_caching_property_iterator_new(&iter);
-    if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
-        ASTARTE_LOG_ERR("Properties iterator init failed: %s", astarte_result_to_name(ares));
-        goto end;
+    uint32_t major = 0U;
+    ares = astarte_device_caching_property_load(interface_name, path, &major, &data);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Properties load property error: %s", astarte_result_to_name(ares));
+        goto exit;
     }
 
-    while (ares != ASTARTE_RESULT_NOT_FOUND) {
-        size_t interface_name_size = 0U;
-        size_t path_size = 0U;
-        ares = astarte_device_caching_property_iterator_get(
-            &iter, NULL, &interface_name_size, NULL, &path_size);
-        if (ares != ASTARTE_RESULT_OK) {
-            ASTARTE_LOG_ERR("Properties iterator get error: %s", astarte_result_to_name(ares));
-            goto end;
-        }
+    ares = send_device_owned_property(device, interface_name, path, major, data, out_message_id);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
 
-        // Allocate space for the name and path
-        interface_name = calloc(interface_name_size, sizeof(char));
-        path = calloc(path_size, sizeof(char));
-        if (!interface_name || !path) {
-            ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-            ares = ASTARTE_RESULT_OUT_OF_MEMORY;
-            goto end;
+    ares = astarte_device_caching_property_iterator_next(&device->prop_resync_iter);
+    if (ares == ASTARTE_RESULT_OK) {
+        ares = load_resync_property(device);
+    } else if (ares != ASTARTE_RESULT_NOT_FOUND) {
+        ASTARTE_LOG_ERR("Iterator next error: %s", astarte_result_to_name(ares));
+    }
+
+exit:
+    astarte_device_caching_property_destroy_loaded(data);
+    return ares;
+}
+
+static void clear_tracked_properties(astarte_device_handle_t device)
+{
+    sys_snode_t *node = NULL;
+    while ((node = sys_slist_get(&device->prop_acks)) != NULL) {
+        astarte_free(CONTAINER_OF(node, struct property_ack_node, node));
+    }
+}
+
+static void properties_resync_start(astarte_device_handle_t device)
+{
+    // Acknowledged values are still held by Astarte if the introspection did not change
+    uint8_t intr_digest[INTROSPECTION_DIGEST_SIZE] = { 0 };
+    introspection_get_digest(&device->introspection, intr_digest);
+    bool delta = (astarte_device_caching_introspection_check(intr_digest) == ASTARTE_RESULT_OK);
+
+    astarte_device_connection_lock_properties(device);
+    // Acknowledgments from the previous session are lost, unacked properties will be resent
+    clear_tracked_properties(device);
+    device->prop_resync_delta = delta;
+    device->prop_resync_active = true;
+    device->prop_resync_sent = false;
+    // The iterator is created on the first run
+    device->prop_resync_restart = true;
+    device->prop_resync_in_flight_len = 0;
+    astarte_device_connection_unlock_properties(device);
+}
+
+static void properties_resync_stop(astarte_device_handle_t device)
+{
+    astarte_device_connection_lock_properties(device);
+    astarte_device_caching_property_iterator_destroy(device->prop_resync_iter);
+    device->prop_resync_iter = (astarte_device_caching_property_iter_t) { 0 };
+    astarte_free(device->prop_resync_interface_name);
+    astarte_free(device->prop_resync_path);
+    device->prop_resync_interface_name = NULL;
+    device->prop_resync_path = NULL;
+    device->prop_resync_active = false;
+    device->prop_resync_sent = false;
+    device->prop_resync_restart = false;
+    device->prop_resync_in_flight_len = 0;
+    astarte_device_connection_unlock_properties(device);
+}
+
+static void properties_resync_run(astarte_device_handle_t device)
+{
+    if (!device->prop_resync_active) {
+        return;
+    }
+
+    // Forget the properties that have already been acknowledged
+    size_t in_flight_len = 0;
+    for (size_t i = 0; i < device->prop_resync_in_flight_len; i++) {
+        uint16_t message_id = device->prop_resync_in_flight[i];
+        if (astarte_mqtt_is_pending_outgoing(&device->astarte_mqtt, message_id)) {
+            device->prop_resync_in_flight[in_flight_len++] = message_id;
         }
+    }
+    device->prop_resync_in_flight_len = in_flight_len;
 
-        ares = astarte_device_caching_property_iterator_get(
-            &iter, interface_name, &interface_name_size, path, &path_size);
-        if (ares != ASTARTE_RESULT_OK) {
-            ASTARTE_LOG_ERR("Properties iterator get error: %s", astarte_result_to_name(ares));
-            goto end;
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_device_connection_lock_properties(device);
+
+    if (device->prop_resync_restart) {
+        ASTARTE_LOG_DBG("Starting the device properties resync.");
+        astarte_device_caching_property_iterator_destroy(device->prop_resync_iter);
+        device->prop_resync_iter = (astarte_device_caching_property_iter_t) { 0 };
+        device->prop_resync_restart = false;
+        device->prop_resync_sent = false;
+        ares = astarte_device_caching_property_iterator_new(&device->prop_resync_iter);
+        if (ares == ASTARTE_RESULT_OK) {
+            ares = load_resync_property(device);
+        }
+        if (ares == ASTARTE_RESULT_NOT_FOUND) {
+            device->prop_resync_sent = true;
+            ares = ASTARTE_RESULT_OK;
         }
+    }
 
-        uint32_t major = 0U;
-        ares = astarte_device_caching_property_load(interface_name, path, &major, &data);
-        if (ares != ASTARTE_RESULT_OK) {
-            ASTARTE_LOG_ERR("Properties load property error: %s", astarte_result_to_name(ares));
-            goto end;
+    while ((ares == ASTARTE_RESULT_OK) && !device->prop_resync_sent
+        && (device->prop_resync_in_flight_len < ARRAY_SIZE(device->prop_resync_in_flight))) {
+        uint16_t message_id = 0U;
+        ares = send_next_device_owned_property(device, &message_id);
+        if (message_id != 0U) {
+            device->prop_resync_in_flight[device->prop_resync_in_flight_len++] = message_id;
+        }
+        if (ares == ASTARTE_RESULT_NOT_FOUND) {
+            device->prop_resync_sent = true;
+            ares = ASTARTE_RESULT_OK;
         }
+    }
 
-        send_device_owned_property(device, interface_name, path, major, data);
+    astarte_device_connection_unlock_properties(device);
 
-        free(interface_name);
-        interface_name = NULL;
-        free(path);
-        path = NULL;
-        astarte_device_caching_property_destroy_loaded(data);
-        data = (astarte_data_t) { 0 };
+    if (ares != ASTARTE_RESULT_OK) {
+        // The synchronization stays incomplete, the next connection will perform a full handshake
+        ASTARTE_LOG_ERR("Device properties resync failed: %s", astarte_result_to_name(ares));
+        properties_resync_stop(device);
+        return;
+    }
 
-        ares = astarte_device_caching_property_iterator_next(&iter);
-        if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
-            ASTARTE_LOG_ERR("Iterator next error: %s", astarte_result_to_name(ares));
-            goto end;
+    if (device->prop_resync_sent && (device->prop_resync_in_flight_len == 0)) {
+        ASTARTE_LOG_DBG("Device properties resync completed.");
+        properties_resync_stop(device);
+        if (device->connection_state == DEVICE_CONNECTED) {
+            complete_synchronization(device);
         }
     }
+}
 
-end:
-    // Free all data
-    astarte_device_caching_property_iterator_destroy(iter);
-    free(interface_name);
-    free(path);
-    astarte_device_caching_property_destroy_loaded(data);
-    return (ares == ASTARTE_RESULT_NOT_FOUND) ? ASTARTE_RESULT_OK : ares;
+static bool properties_resync_has_work(astarte_device_handle_t device)
+{
+    if (!device->prop_resync_active) {
+        return false;
+    }
+    if (device->prop_resync_restart) {
+        return true;
+    }
+    if (!device->prop_resync_sent
+        && (device->prop_resync_in_flight_len < ARRAY_SIZE(device->prop_resync_in_flight))) {
+        return true;
+    }
+    if (device->prop_resync_in_flight_len == 0) {
+        return true;
+    }
+    for (size_t i = 0; i < device->prop_resync_in_flight_len; i++) {
+        if (!astarte_mqtt_is_pending_outgoing(
+                &device->astarte_mqtt, device->prop_resync_in_flight[i])) {
+            return true;
+        }
+    }
+    return false;
 }
 #endif
+
+static k_timeout_t get_state_machine_deadline(astarte_device_handle_t device)
+{
+    switch (device->connection_state) {
+        case DEVICE_START_HANDSHAKE:
+            return K_NO_WAIT;
+        case DEVICE_END_HANDSHAKE:
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+            if (properties_resync_has_work(device)) {
+                return K_NO_WAIT;
+            }
+#endif
+            if (handshake_messages_acked(device)) {
+                return K_NO_WAIT;
+            }
+            return astarte_mqtt_get_next_deadline(&device->astarte_mqtt);
+        case DEVICE_HANDSHAKE_ERROR: {
+            k_timeout_t mqtt_deadline = astarte_mqtt_get_next_deadline(&device->astarte_mqtt);
+            k_timeout_t reconnection = sys_timepoint_timeout(device->reconnection_timepoint);
+            if (K_TIMEOUT_EQ(mqtt_deadline, K_FOREVER)
+                || (reconnection.ticks < mqtt_deadline.ticks)) {
+                return reconnection;
+            }
+            return mqtt_deadline;
+        }
+        case DEVICE_CONNECTED: {
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+            if (properties_resync_has_work(device)) {
+                return K_NO_WAIT;
+            }
+#endif
+            k_timeout_t mqtt_deadline = astarte_mqtt_get_next_deadline(&device->astarte_mqtt);
+            k_timeout_t renewal = astarte_device_client_crt_get_renewal_deadline(device);
+            if (K_TIMEOUT_EQ(mqtt_deadline, K_FOREVER)
+                || (!K_TIMEOUT_EQ(renewal, K_FOREVER) && (renewal.ticks < mqtt_deadline.ticks))) {
+                return renewal;
+            }
+            return mqtt_deadline;
+        }
+        default:
+            return astarte_mqtt_get_next_deadline(&device->astarte_mqtt);
+    }
+}
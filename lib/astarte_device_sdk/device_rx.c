@@ -5,21 +5,23 @@
  */
 #include "device_rx.h"
 
-#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
-#include <zlib.h>
-#endif
-
 #include "bson_deserializer.h"
 #include "data_validation.h"
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+#include "astarte_zlib.h"
 #include "device_caching.h"
+#include "device_connection.h"
 #endif
 #include "data_private.h"
 #include "interface_private.h"
 #include "object_private.h"
 
+#include "heap_private.h"
 #include "log.h"
+#include "metrics_private.h"
+#include "tracing_private.h"
 ASTARTE_LOG_MODULE_REGISTER(device_reception, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_RX_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_DEVICE_RX);
 
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
 /** @brief Struct used when parsing the received purge properties string into a list. */
@@ -30,10 +32,35 @@ struct allow_node
 };
 #endif
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+/** @brief Struct used to buffer a received server property change until written to storage. */
+struct property_change_node
+{
+    sys_snode_t node;
+    char *interface_name;
+    char *path;
+    /** @brief Encoded property, NULL for an unset. */
+    uint8_t *value;
+    size_t value_len;
+};
+#endif
+
 /************************************************
  *         Static functions declaration         *
  ***********************************************/
 
+/**
+ * @brief Parse the topic of a data message into interface name and path.
+ *
+ * @param[in] topic The data message topic, NULL terminated.
+ * @param[in] topic_len Length of the topic.
+ * @param[out] interface_name Buffer where to store the interface name.
+ * @param[in] interface_name_size Size of the interface name buffer.
+ * @param[out] path Set to the start of the path within @p topic.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t parse_data_topic(const char *topic, size_t topic_len,
+    char *interface_name, size_t interface_name_size, const char **path);
 /**
  * @brief Handles an incoming generic control message.
  *
@@ -59,23 +86,27 @@ static void on_purge_properties(astarte_device_handle_t device, const char *data
  * @note All the properties that do not belong to an interface contained in the introspection will
  * be removed as well.
  *
- * @param[in] introspection Device's introspection to be used to check ownership of each property.
+ * @note Should be called with the properties locked.
+ *
+ * @param[in] device Handle to the device instance, its introspection is used to check the
+ * ownership of each property.
  * @param[in] allow_list Purge properties allow list.
  */
-static void purge_server_properties(introspection_t *introspection, sys_slist_t *allow_list);
+static void purge_server_properties(astarte_device_handle_t device, sys_slist_t *allow_list);
 /**
  * @brief Purge a single stored server owned property if not contained in the allow list.
  *
  * @note If the property does not belong to an interface contained in the introspection it will be
  * removed as well.
  *
- * @param[in] introspection Device's introspection to be used to check ownership of each property.
+ * @param[in] device Handle to the device instance, its introspection is used to check the
+ * ownership of the property.
  * @param[in] interface_name Interface name for the stored property to be removed.
  * @param[in] path Path for the stored property to be removed.
  * @param[in] allow_list Purge properties allow list.
  */
 static void purge_server_property(
-    introspection_t *introspection, char *interface_name, char *path, sys_slist_t *allow_list);
+    astarte_device_handle_t device, char *interface_name, char *path, sys_slist_t *allow_list);
 #endif
 /**
  * @brief Handles an incoming generic data message.
@@ -126,6 +157,31 @@ static void on_datastream_individual(
  */
 static void on_datastream_aggregated(astarte_device_handle_t device,
     astarte_device_data_event_t base_event, astarte_object_entry_t *entries, size_t entries_len);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+/**
+ * @brief Buffer a received server property change, replacing any buffered change for the same
+ * property.
+ *
+ * @details When the change can not be buffered it is written directly to the permanent storage.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] interface_name Interface name of the property.
+ * @param[in] path Path of the property.
+ * @param[in] value Property encoded with #astarte_device_caching_property_encode, NULL for an
+ * unset. Ownership is transferred to this function.
+ * @param[in] value_len Length of @p value.
+ */
+static void buffer_property_change(astarte_device_handle_t device, const char *interface_name,
+    const char *path, uint8_t *value, size_t value_len);
+/**
+ * @brief Write the buffered server properties changes to the permanent storage.
+ *
+ * @note Should be called with the properties locked.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void commit_pending_properties(astarte_device_handle_t device);
+#endif
 
 /************************************************
  *         Global functions definitions         *
@@ -150,34 +206,132 @@ void astarte_device_rx_on_incoming_handler(astarte_mqtt_t *astarte_mqtt, const c
     }
 
     // Data message
-    if ((topic_len < MQTT_BASE_TOPIC_LEN + strlen("/")) || (topic[MQTT_BASE_TOPIC_LEN] != '/')) {
-        ASTARTE_LOG_ERR("Missing '/' after base topic, can't find interface in topic: %s", topic);
+    char interface_name[ASTARTE_INTERFACE_NAME_MAX_SIZE] = { 0 };
+    const char *path = NULL;
+    if (parse_data_topic(topic, topic_len, interface_name, sizeof(interface_name), &path)
+        != ASTARTE_RESULT_OK) {
         return;
     }
 
-    const char *interface_name_start = topic + MQTT_BASE_TOPIC_LEN + strlen("/");
-    char *path_start = strchr(interface_name_start, '/');
-    if (!path_start) {
-        ASTARTE_LOG_ERR("Missing '/' after interface name, can't find path in topic: %s", topic);
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_RX_DATA_MESSAGE);
+    on_data_message(device, interface_name, path, data, data_len);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_RX_DATA_MESSAGE);
+}
+
+void astarte_device_rx_on_incoming_chunk_handler(astarte_mqtt_t *astarte_mqtt, const char *topic,
+    size_t topic_len, size_t offset, const char *chunk, size_t chunk_len, size_t total_len)
+{
+    struct astarte_device *device = CONTAINER_OF(astarte_mqtt, struct astarte_device, astarte_mqtt);
+
+    // Check if base topic is correct
+    if (strstr(topic, device->base_topic) != topic) {
+        ASTARTE_LOG_ERR("Incoming message topic doesn't begin with <REALM>/<DEVICE ID>: %s", topic);
+        return;
+    }
+
+    // Control messages are always processed as a whole
+    if (strstr(topic, device->control_topic)) {
+        ASTARTE_LOG_ERR("Control message exceeding the maximum message size discarded: %s", topic);
         return;
     }
 
-    size_t interface_name_len = path_start - interface_name_start;
     char interface_name[ASTARTE_INTERFACE_NAME_MAX_SIZE] = { 0 };
-    int ret = snprintf(interface_name, ASTARTE_INTERFACE_NAME_MAX_SIZE, "%.*s", interface_name_len,
-        interface_name_start);
-    if ((ret < 0) || (ret >= ASTARTE_INTERFACE_NAME_MAX_SIZE)) {
-        ASTARTE_LOG_ERR("Error encoding interface name");
+    const char *path = NULL;
+    if (parse_data_topic(topic, topic_len, interface_name, sizeof(interface_name), &path)
+        != ASTARTE_RESULT_OK) {
         return;
     }
 
-    on_data_message(device, interface_name, path_start, data, data_len);
+    if (!device->data_chunk_cbk) {
+        ASTARTE_LOG_ERR("Data chunk received without a data chunk callback: %s", topic);
+        return;
+    }
+
+    astarte_device_data_chunk_event_t event = {
+        .base_event = {
+            .device = device,
+            .interface_name = interface_name,
+            .path = path,
+            .user_data = device->cbk_user_data,
+        },
+        .offset = offset,
+        .chunk = chunk,
+        .chunk_len = chunk_len,
+        .total_len = total_len,
+    };
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
+    device->data_chunk_cbk(event);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
 }
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+void astarte_device_rx_init_properties_coalescing(astarte_device_handle_t device)
+{
+    sys_slist_init(&device->prop_pending);
+    device->prop_pending_count = 0;
+    device->prop_pending_timepoint = sys_timepoint_calc(K_FOREVER);
+    device->prop_pending_max_timepoint = sys_timepoint_calc(K_FOREVER);
+}
+
+void astarte_device_rx_commit_properties(astarte_device_handle_t device)
+{
+    astarte_device_connection_lock_properties(device);
+    commit_pending_properties(device);
+    astarte_device_connection_unlock_properties(device);
+}
+
+void astarte_device_rx_commit_properties_if_due(astarte_device_handle_t device)
+{
+    astarte_device_connection_lock_properties(device);
+    if ((device->prop_pending_count != 0)
+        && sys_timepoint_expired(device->prop_pending_timepoint)) {
+        commit_pending_properties(device);
+    }
+    astarte_device_connection_unlock_properties(device);
+}
+
+k_timeout_t astarte_device_rx_get_properties_deadline(astarte_device_handle_t device)
+{
+    astarte_device_connection_lock_properties(device);
+    k_timeout_t deadline = (device->prop_pending_count != 0)
+        ? sys_timepoint_timeout(device->prop_pending_timepoint)
+        : K_FOREVER;
+    astarte_device_connection_unlock_properties(device);
+    return deadline;
+}
+#endif
+
 /************************************************
  *         Static functions definitions         *
  ***********************************************/
 
+static astarte_result_t parse_data_topic(const char *topic, size_t topic_len,
+    char *interface_name, size_t interface_name_size, const char **path)
+{
+    if ((topic_len < MQTT_BASE_TOPIC_LEN + strlen("/")) || (topic[MQTT_BASE_TOPIC_LEN] != '/')) {
+        ASTARTE_LOG_ERR("Missing '/' after base topic, can't find interface in topic: %s", topic);
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+
+    const char *interface_name_start = topic + MQTT_BASE_TOPIC_LEN + strlen("/");
+    const char *path_start = strchr(interface_name_start, '/');
+    if (!path_start) {
+        ASTARTE_LOG_ERR("Missing '/' after interface name, can't find path in topic: %s", topic);
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+
+    size_t interface_name_len = path_start - interface_name_start;
+    int ret = snprintf(interface_name, interface_name_size, "%.*s", interface_name_len,
+        interface_name_start);
+    if ((ret < 0) || (ret >= interface_name_size)) {
+        ASTARTE_LOG_ERR("Error encoding interface name");
+        return ASTARTE_RESULT_INTERNAL_ERROR;
+    }
+
+    *path = path_start;
+    return ASTARTE_RESULT_OK;
+}
+
 static void on_control_message(
     astarte_device_handle_t device, const char *topic, const char *data, size_t data_len)
 {
@@ -203,15 +357,15 @@ static void on_purge_properties(astarte_device_handle_t device, const char *data
 
     uLongf decomp_data_len = __builtin_bswap32(*(uint32_t *) data);
 
-    decomp_data = calloc(decomp_data_len + 1, sizeof(char));
+    decomp_data = astarte_calloc(decomp_data_len + 1, sizeof(char));
     if (!decomp_data) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         goto exit;
     }
 
     if (decomp_data_len != 0) {
-        int uncompress_res = uncompress((char unsigned *) decomp_data, &decomp_data_len,
-            (char unsigned *) data + 4, data_len - 4);
+        int uncompress_res = astarte_zlib_uncompress((char unsigned *) decomp_data,
+            &decomp_data_len, (char unsigned *) data + 4, data_len - 4);
         if (uncompress_res != Z_OK) {
             ASTARTE_LOG_ERR("Decompression error %d.", uncompress_res);
             goto exit;
@@ -228,7 +382,7 @@ static void on_purge_properties(astarte_device_handle_t device, const char *data
             goto exit;
         }
         do {
-            struct allow_node *allow_node = calloc(1, sizeof(struct allow_node));
+            struct allow_node *allow_node = astarte_calloc(1, sizeof(struct allow_node));
             if (!allow_node) {
                 ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
                 goto exit;
@@ -239,8 +393,15 @@ static void on_purge_properties(astarte_device_handle_t device, const char *data
         } while (property);
     }
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    // The purge operates on the stored properties, write the buffered changes first
+    astarte_device_rx_commit_properties(device);
+#endif
+
     // Iterate over the stored properties and purge the ones not in the allow list
-    purge_server_properties(&device->introspection, &allow_list);
+    astarte_device_connection_lock_properties(device);
+    purge_server_properties(device, &allow_list);
+    astarte_device_connection_unlock_properties(device);
 
 exit:
     sys_snode_t *node = NULL;
@@ -248,12 +409,12 @@ exit:
     SYS_SLIST_FOR_EACH_NODE_SAFE(&allow_list, node, safe_node)
     {
         struct allow_node *allow_node = CONTAINER_OF(node, struct allow_node, node);
-        free(allow_node);
+        astarte_free(allow_node);
     }
-    free(decomp_data);
+    astarte_free(decomp_data);
 }
 
-static void purge_server_properties(introspection_t *introspection, sys_slist_t *allow_list)
+static void purge_server_properties(astarte_device_handle_t device, sys_slist_t *allow_list)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     astarte_device_caching_property_iter_t iter = { 0 };
@@ -277,8 +438,8 @@ static void purge_server_properties(introspection_t *introspection, sys_slist_t
         }
 
         // Allocate space for the name and path
-        interface_name = calloc(interface_name_size, sizeof(char));
-        path = calloc(path_size, sizeof(char));
+        interface_name = astarte_calloc(interface_name_size, sizeof(char));
+        path = astarte_calloc(path_size, sizeof(char));
         if (!interface_name || !path) {
             ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
             goto end;
@@ -292,11 +453,11 @@ static void purge_server_properties(introspection_t *introspection, sys_slist_t
         }
 
         // Purge the property if not in the allow list
-        purge_server_property(introspection, interface_name, path, allow_list);
+        purge_server_property(device, interface_name, path, allow_list);
 
-        free(interface_name);
+        astarte_free(interface_name);
         interface_name = NULL;
-        free(path);
+        astarte_free(path);
         path = NULL;
 
         ares = astarte_device_caching_property_iterator_next(&iter);
@@ -308,22 +469,25 @@ static void purge_server_properties(introspection_t *introspection, sys_slist_t
 
 end:
     astarte_device_caching_property_iterator_destroy(iter);
-    free(interface_name);
-    free(path);
+    astarte_free(interface_name);
+    astarte_free(path);
 }
 
 static void purge_server_property(
-    introspection_t *introspection, char *interface_name, char *path, sys_slist_t *allow_list)
+    astarte_device_handle_t device, char *interface_name, char *path, sys_slist_t *allow_list)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     char *property = NULL;
 
-    const astarte_interface_t *interface = introspection_get(introspection, interface_name);
+    const astarte_interface_t *interface
+        = introspection_get(&device->introspection, interface_name);
     if (!interface) {
         ASTARTE_LOG_DBG("Purging property from unknown interface: '%s%s'", interface_name, path);
         ares = astarte_device_caching_property_delete(interface_name, path);
-        if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
-            ASTARTE_LOG_COND_ERR(ares != ASTARTE_RESULT_OK,
+        if (ares == ASTARTE_RESULT_OK) {
+            astarte_device_connection_on_property_deleted(device);
+        } else if (ares != ASTARTE_RESULT_NOT_FOUND) {
+            ASTARTE_LOG_ERR(
                 "Failed deleting the cached property: %s", astarte_result_to_name(ares));
         }
         goto end;
@@ -334,7 +498,7 @@ static void purge_server_property(
     }
 
     // Concatenate the interface_name and path
-    property = calloc(strlen(interface_name) + strlen(path) + 1, sizeof(char));
+    property = astarte_calloc(strlen(interface_name) + strlen(path) + 1, sizeof(char));
     if (!property) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         goto end;
@@ -359,13 +523,14 @@ static void purge_server_property(
 
     ASTARTE_LOG_DBG("Purging property not in allow list: '%s%s'", interface_name, path);
     ares = astarte_device_caching_property_delete(interface_name, path);
-    if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
-        ASTARTE_LOG_COND_ERR(ares != ASTARTE_RESULT_OK, "Failed deleting the cached property: %s",
-            astarte_result_to_name(ares));
+    if (ares == ASTARTE_RESULT_OK) {
+        astarte_device_connection_on_property_deleted(device);
+    } else if (ares != ASTARTE_RESULT_NOT_FOUND) {
+        ASTARTE_LOG_ERR("Failed deleting the cached property: %s", astarte_result_to_name(ares));
     }
 
 end:
-    free(property);
+    astarte_free(property);
 }
 #endif
 
@@ -378,6 +543,7 @@ static void on_data_message(astarte_device_handle_t device, const char *interfac
         ASTARTE_LOG_ERR("Could not find interface in device introspection (%s).", interface_name);
         return;
     }
+    ASTARTE_METRICS_INTERFACE_RECEIVED(interface->name, data_len);
 
     astarte_device_data_event_t base_event = {
         .device = device,
@@ -391,6 +557,7 @@ static void on_data_message(astarte_device_handle_t device, const char *interfac
         return;
     }
 
+    ASTARTE_METRICS_TIMER_START(decode_timer);
     if (!astarte_bson_deserializer_check_validity(data, data_len)) {
         ASTARTE_LOG_ERR("Invalid BSON document in data");
         return;
@@ -418,6 +585,7 @@ static void on_data_message(astarte_device_handle_t device, const char *interfac
                 interface_name, path);
             return;
         }
+        ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_BSON_DECODE, decode_timer);
 
         if (interface->type == ASTARTE_INTERFACE_TYPE_PROPERTIES) {
             on_set_property(device, base_event, data_deserialized);
@@ -435,6 +603,7 @@ static void on_data_message(astarte_device_handle_t device, const char *interfac
                 interface_name, path);
             return;
         }
+        ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_BSON_DECODE, decode_timer);
         on_datastream_aggregated(device, base_event, entries, entries_length);
         astarte_object_entries_destroy_deserialized(entries, entries_length);
     }
@@ -456,15 +625,23 @@ static void on_unset_property(astarte_device_handle_t device, astarte_device_dat
         return;
     }
 
-#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    buffer_property_change(device, event.interface_name, event.path, NULL, 0);
+#elif defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_device_connection_lock_properties(device);
     ares = astarte_device_caching_property_delete(event.interface_name, event.path);
-    if (ares != ASTARTE_RESULT_OK) {
+    if (ares == ASTARTE_RESULT_OK) {
+        astarte_device_connection_on_property_deleted(device);
+    } else {
         ASTARTE_LOG_ERR("Failed deleting the stored server property.");
     }
+    astarte_device_connection_unlock_properties(device);
 #endif
 
     if (device->property_unset_cbk) {
+        ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
         device->property_unset_cbk(event);
+        ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
     } else {
         ASTARTE_LOG_ERR("Unset property received, but no callback configured.");
     }
@@ -487,7 +664,18 @@ static void on_set_property(
         return;
     }
 
-#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    uint8_t *value = NULL;
+    size_t value_len = 0;
+    ares = astarte_device_caching_property_encode(
+        interface->major_version, data, &value, &value_len);
+    if (ares == ASTARTE_RESULT_OK) {
+        buffer_property_change(
+            device, base_event.interface_name, base_event.path, value, value_len);
+    } else {
+        ASTARTE_LOG_ERR("Failed encoding the server property.");
+    }
+#elif defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
     ares = astarte_device_caching_property_store(
         base_event.interface_name, base_event.path, interface->major_version, data);
     if (ares != ASTARTE_RESULT_OK) {
@@ -500,7 +688,9 @@ static void on_set_property(
             .base_event = base_event,
             .data = data,
         };
+        ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
         device->property_set_cbk(set_event);
+        ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
     } else {
         ASTARTE_LOG_ERR("Set property received, but no callback configured.");
     }
@@ -533,7 +723,9 @@ static void on_datastream_individual(
             .base_event = base_event,
             .data = data,
         };
+        ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
         device->datastream_individual_cbk(event);
+        ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
     } else {
         ASTARTE_LOG_ERR("Datastream individual received, but no callback configured.");
     }
@@ -567,8 +759,147 @@ static void on_datastream_aggregated(astarte_device_handle_t device,
             .entries = entries,
             .entries_len = entries_len,
         };
+        ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
         device->datastream_object_cbk(event);
+        ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
     } else {
         ASTARTE_LOG_ERR("Datastream object received, but no callback configured.");
     }
 }
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+static void buffer_property_change(astarte_device_handle_t device, const char *interface_name,
+    const char *path, uint8_t *value, size_t value_len)
+{
+    astarte_device_connection_lock_properties(device);
+
+    struct property_change_node *change_node = NULL;
+    sys_snode_t *node = NULL;
+    SYS_SLIST_FOR_EACH_NODE(&device->prop_pending, node)
+    {
+        struct property_change_node *pending
+            = CONTAINER_OF(node, struct property_change_node, node);
+        if ((strcmp(pending->interface_name, interface_name) == 0)
+            && (strcmp(pending->path, path) == 0)) {
+            change_node = pending;
+            break;
+        }
+    }
+
+    if (!change_node) {
+        if (device->prop_pending_count
+            >= CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_MAX_ENTRIES) {
+            commit_pending_properties(device);
+        }
+
+        // The node and its strings are stored in a single allocation
+        size_t interface_name_size = strlen(interface_name) + 1;
+        size_t path_size = strlen(path) + 1;
+        change_node = astarte_calloc(
+            1, sizeof(struct property_change_node) + interface_name_size + path_size);
+        if (!change_node) {
+            // No change is buffered for this property, writing it directly keeps the ordering
+            ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+            astarte_device_caching_property_batch_t batch = { 0 };
+            astarte_result_t ares = astarte_device_caching_property_batch_begin(&batch);
+            if (ares == ASTARTE_RESULT_OK) {
+                ares = (value) ? astarte_device_caching_property_batch_store(
+                           &batch, interface_name, path, value, value_len)
+                               : astarte_device_caching_property_batch_delete(
+                                   &batch, interface_name, path);
+                astarte_device_caching_property_batch_end(batch);
+            }
+            if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
+                ASTARTE_LOG_ERR("Failed writing the server property: %s.",
+                    astarte_result_to_name(ares));
+            }
+            if (!value && (ares == ASTARTE_RESULT_OK)) {
+                astarte_device_connection_on_property_deleted(device);
+            }
+            astarte_free(value);
+            goto exit;
+        }
+        change_node->interface_name = (char *) &change_node[1];
+        memcpy(change_node->interface_name, interface_name, interface_name_size);
+        change_node->path = change_node->interface_name + interface_name_size;
+        memcpy(change_node->path, path, path_size);
+        sys_slist_append(&device->prop_pending, &change_node->node);
+        device->prop_pending_count++;
+    }
+
+    // Last writer wins, the previously buffered change is discarded
+    astarte_free(change_node->value);
+    change_node->value = value;
+    change_node->value_len = value_len;
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_QUIET_PERIOD)
+    if (device->prop_pending_count == 1) {
+        device->prop_pending_max_timepoint = sys_timepoint_calc(
+            K_MSEC(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_MAX_DELAY_MS));
+    }
+    k_timepoint_t quiet_timepoint = sys_timepoint_calc(
+        K_MSEC(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_QUIET_PERIOD_MS));
+    device->prop_pending_timepoint
+        = (sys_timepoint_cmp(quiet_timepoint, device->prop_pending_max_timepoint) < 0)
+        ? quiet_timepoint
+        : device->prop_pending_max_timepoint;
+#else
+    // Changes are only buffered during the handshake
+    if (device->connection_state == DEVICE_CONNECTED) {
+        commit_pending_properties(device);
+    }
+#endif
+
+exit:
+    astarte_device_connection_unlock_properties(device);
+}
+
+static void commit_pending_properties(astarte_device_handle_t device)
+{
+    if (device->prop_pending_count == 0) {
+        return;
+    }
+
+    ASTARTE_LOG_DBG("Writing %zu buffered server properties.", device->prop_pending_count);
+    astarte_device_caching_property_batch_t batch = { 0 };
+    astarte_result_t batch_ares = astarte_device_caching_property_batch_begin(&batch);
+
+    sys_snode_t *node = NULL;
+    sys_snode_t *safe_node = NULL;
+    SYS_SLIST_FOR_EACH_NODE_SAFE(&device->prop_pending, node, safe_node)
+    {
+        struct property_change_node *change_node
+            = CONTAINER_OF(node, struct property_change_node, node);
+        if (batch_ares == ASTARTE_RESULT_OK) {
+            astarte_result_t ares = ASTARTE_RESULT_OK;
+            if (change_node->value) {
+                ares = astarte_device_caching_property_batch_store(&batch,
+                    change_node->interface_name, change_node->path, change_node->value,
+                    change_node->value_len);
+            } else {
+                ares = astarte_device_caching_property_batch_delete(
+                    &batch, change_node->interface_name, change_node->path);
+                if (ares == ASTARTE_RESULT_OK) {
+                    astarte_device_connection_on_property_deleted(device);
+                }
+            }
+            if ((ares != ASTARTE_RESULT_OK) && (ares != ASTARTE_RESULT_NOT_FOUND)) {
+                ASTARTE_LOG_ERR("Failed writing the server property '%s%s'.",
+                    change_node->interface_name, change_node->path);
+            }
+        }
+        astarte_free(change_node->value);
+        astarte_free(change_node);
+    }
+
+    if (batch_ares == ASTARTE_RESULT_OK) {
+        astarte_device_caching_property_batch_end(batch);
+    } else {
+        ASTARTE_LOG_ERR("Discarded %zu buffered server properties.", device->prop_pending_count);
+    }
+    sys_slist_init(&device->prop_pending);
+    device->prop_pending_count = 0;
+    device->prop_pending_timepoint = sys_timepoint_calc(K_FOREVER);
+    device->prop_pending_max_timepoint = sys_timepoint_calc(K_FOREVER);
+}
+#endif
@@ -5,16 +5,35 @@
  */
 #include "device_tx.h"
 
+#include <string.h>
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/hash_function.h>
+#include <zephyr/sys/mutex.h>
+
+#include <mbedtls/sha256.h>
+#endif
+
 #include "bson_serializer.h"
 #include "data_validation.h"
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
 #include "device_caching.h"
 #endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)                                           \
+    || defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+#include "device_connection.h"
+#endif
 #include "data_private.h"
+#include "interface_private.h"
 #include "object_private.h"
 
+#include "heap_private.h"
 #include "log.h"
+#include "metrics_private.h"
+#include "tracing_private.h"
 ASTARTE_LOG_MODULE_REGISTER(device_transmission, CONFIG_ASTARTE_DEVICE_SDK_DEVICE_TX_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_DEVICE_TX);
 
 /************************************************
  *        Defines, constants and typedef        *
@@ -24,92 +43,157 @@ ASTARTE_LOG_MODULE_REGISTER(device_transmission, CONFIG_ASTARTE_DEVICE_SDK_DEVIC
  *         Static functions declaration         *
  ***********************************************/
 
+/**
+ * @brief Send an individual value, optionally checking it against the datastream filters.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] interface_name Interface where to publish data.
+ * @param[in] path Path where to publish data.
+ * @param[in] data Astarte data value to stream.
+ * @param[in] timestamp Timestamp of the message, ignored if set to NULL.
+ * @param[out] out_message_id Stores the MQTT message ID used for QoS 1 and 2, can be NULL.
+ * @param[in] filtered Set to check the value against the filters of its mapping.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t stream_individual(astarte_device_handle_t device,
+    const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp,
+    uint16_t *out_message_id, bool filtered);
+
+/**
+ * @brief Encode an individual value in a shared MQTT payload.
+ *
+ * @param[inout] bson Initialized by this function, to be destroyed by the caller.
+ * @param[in] interface_name Interface of the value, used for logging.
+ * @param[in] path Path of the value, used for logging.
+ * @param[in] data Value to encode.
+ * @param[in] timestamp Timestamp of the value, ignored if set to NULL.
+ * @param[out] payload Resulting payload, to be released with #astarte_mqtt_payload_unref.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t encode_individual(astarte_bson_serializer_t *bson,
+    const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp,
+    astarte_mqtt_payload_t **payload);
 /**
  * @brief Publish data.
  *
  * @param[in] device Handle to the device instance.
  * @param[in] interface_name Interface where to publish data.
  * @param[in] path Path where to publish data.
- * @param[in] data Data to publish.
- * @param[in] data_size Size of data to publish.
+ * @param[in] payload Shared payload to publish, NULL for an empty payload.
  * @param[in] qos Quality of service for MQTT publish.
+ * @param[out] out_message_id Stores the MQTT message ID used for QoS 1 and 2, can be NULL.
  * @return ASTARTE_RESULT_OK if publish has been successful, an error code otherwise.
  */
 static astarte_result_t publish_data(astarte_device_handle_t device, const char *interface_name,
-    const char *path, void *data, int data_size, int qos);
+    const char *path, astarte_mqtt_payload_t *payload, int qos, uint16_t *out_message_id);
+/**
+ * @brief Wrap a serialized object in the data document and publish it.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] interface_name Interface where to publish data.
+ * @param[in] path Path where to publish data.
+ * @param[inout] inner_bson Serializer containing the object entries, not yet terminated.
+ * @param[in] timestamp Timestamp of the message, ignored if set to NULL.
+ * @param[in] qos Quality of service for MQTT publish.
+ * @return ASTARTE_RESULT_OK if publish has been successful, an error code otherwise.
+ */
+static astarte_result_t publish_object(astarte_device_handle_t device, const char *interface_name,
+    const char *path, astarte_bson_serializer_t *inner_bson, const int64_t *timestamp, int qos);
+/**
+ * @brief Move a serialized BSON document into a shared MQTT payload.
+ *
+ * @details The serializer buffer is detached and used as the payload data without any copy.
+ *
+ * @param[inout] bson Serializer containing a terminated BSON document.
+ * @param[out] payload Resulting payload, to be released with #astarte_mqtt_payload_unref.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t payload_from_bson(
+    astarte_bson_serializer_t *bson, astarte_mqtt_payload_t **payload);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+/**
+ * @brief Compute the digest of a device property value.
+ *
+ * @param[in] interface_name Interface of the property.
+ * @param[in] path Path of the property.
+ * @param[in] major Major version of the interface.
+ * @param[in] data Value of the property.
+ * @param[out] digest Computed digest, marked as used when successful.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t compute_property_digest(const char *interface_name, const char *path,
+    uint32_t major, astarte_data_t data, astarte_device_property_digest_t *digest);
+/**
+ * @brief Compute the hash identifying a device property in the tracked digests.
+ *
+ * @param[in] interface_name Interface of the property.
+ * @param[in] path Path of the property.
+ * @return The hash of the property.
+ */
+static uint32_t compute_property_key_hash(const char *interface_name, const char *path);
+/**
+ * @brief Find the tracked digest of a device property.
+ *
+ * @note Should be called with the property digests locked.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] key_hash Hash of the property, as returned by #compute_property_key_hash.
+ * @return The tracked digest, NULL if the property is not tracked.
+ */
+static astarte_device_property_digest_t *find_property_digest(
+    astarte_device_handle_t device, uint32_t key_hash);
+/**
+ * @brief Track the digest of the value just set for a device property.
+ *
+ * @details When all the entries are used, the entries are replaced in round robin order.
+ *
+ * @note Should be called with the property digests locked.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] digest Digest of the property value.
+ */
+static void track_property_digest(
+    astarte_device_handle_t device, const astarte_device_property_digest_t *digest);
+/**
+ * @brief Stop tracking the digest of a device property, its next update is always sent.
+ *
+ * @note Should be called with the property digests locked.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] key_hash Hash of the property, as returned by #compute_property_key_hash.
+ */
+static void forget_property_digest(astarte_device_handle_t device, uint32_t key_hash);
+/**
+ * @brief Lock the digests of the device properties.
+ *
+ * @note When the properties are also locked, they should be locked first.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void lock_property_digests(astarte_device_handle_t device);
+/**
+ * @brief Unlock the digests locked with #lock_property_digests.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+static void unlock_property_digests(astarte_device_handle_t device);
+#endif
 
 /************************************************
  *         Global functions definitions         *
  ***********************************************/
 
 astarte_result_t astarte_device_tx_stream_individual(astarte_device_handle_t device,
-    const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp)
+    const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp,
+    uint16_t *out_message_id)
 {
-    astarte_bson_serializer_t bson = { 0 };
-    astarte_result_t ares = ASTARTE_RESULT_OK;
-
-    const astarte_interface_t *interface = introspection_get(
-        &device->introspection, interface_name);
-    if (!interface) {
-        ASTARTE_LOG_ERR("Couldn't find interface in device introspection (%s).", interface_name);
-        ares = ASTARTE_RESULT_INTERFACE_NOT_FOUND;
-        goto exit;
-    }
-
-    ares = data_validation_individual_datastream(interface, path, data, timestamp);
-    if (ares != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_ERR("Device individual data validation failed.");
-        goto exit;
-    }
-
-    int qos = 0;
-    ares = astarte_interface_get_qos(interface, path, &qos);
-    if (ares != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_ERR("Failed getting QoS for individual data streaming.");
-        goto exit;
-    }
-
-    ares = astarte_bson_serializer_init(&bson);
-    if (ares != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_ERR("Could not initialize the bson serializer");
-        goto exit;
-    }
-    ares = astarte_data_serialize(&bson, "v", data);
-    if (ares != ASTARTE_RESULT_OK) {
-        goto exit;
-    }
-
-    if (timestamp) {
-        astarte_bson_serializer_append_datetime(&bson, "t", *timestamp);
-    }
-    astarte_bson_serializer_append_end_of_document(&bson);
-
-    int data_ser_len = 0;
-    void *data_ser = (void *) astarte_bson_serializer_get_serialized(bson, &data_ser_len);
-    if (!data_ser) {
-        ASTARTE_LOG_ERR("Error during BSON serialization.");
-        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
-        goto exit;
-    }
-    if (data_ser_len < 0) {
-        ASTARTE_LOG_ERR("BSON document is too long for MQTT publish.");
-        ASTARTE_LOG_ERR("Interface: %s, path: %s", interface_name, path);
-        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
-        goto exit;
-    }
-
-    ares = publish_data(device, interface_name, path, data_ser, data_ser_len, qos);
-
-exit:
-    astarte_bson_serializer_destroy(&bson);
-    return ares;
+    return stream_individual(device, interface_name, path, data, timestamp, out_message_id, true);
 }
 
 astarte_result_t astarte_device_tx_stream_aggregated(astarte_device_handle_t device,
     const char *interface_name, const char *path, astarte_object_entry_t *entries,
     size_t entries_len, const int64_t *timestamp)
 {
-    astarte_bson_serializer_t outer_bson = { 0 };
     astarte_bson_serializer_t inner_bson = { 0 };
     astarte_result_t ares = ASTARTE_RESULT_OK;
 
@@ -129,7 +213,9 @@ astarte_result_t astarte_device_tx_stream_aggregated(astarte_device_handle_t dev
         goto exit;
     }
 
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_VALIDATION);
     ares = data_validation_aggregated_datastream(interface, path, entries, entries_len, timestamp);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_VALIDATION);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Device aggregated data validation failed.");
         goto exit;
@@ -142,62 +228,71 @@ astarte_result_t astarte_device_tx_stream_aggregated(astarte_device_handle_t dev
         goto exit;
     }
 
-    ares = astarte_bson_serializer_init(&outer_bson);
-    if (ares != ASTARTE_RESULT_OK) {
-        ASTARTE_LOG_ERR("Could not initialize the bson serializer");
-        goto exit;
-    }
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_BSON_ENCODE);
+    ASTARTE_METRICS_TIMER_START(encode_timer);
     ares = astarte_bson_serializer_init(&inner_bson);
-    if (ares != ASTARTE_RESULT_OK) {
+    if (ares == ASTARTE_RESULT_OK) {
+        ares = astarte_object_entries_serialize(&inner_bson, entries, entries_len);
+    } else {
         ASTARTE_LOG_ERR("Could not initialize the bson serializer");
-        goto exit;
     }
-    ares = astarte_object_entries_serialize(&inner_bson, entries, entries_len);
+    ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_BSON_ENCODE, encode_timer);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_BSON_ENCODE);
     if (ares != ASTARTE_RESULT_OK) {
         goto exit;
     }
-    astarte_bson_serializer_append_end_of_document(&inner_bson);
-    int inner_len = 0;
-    const void *inner_data = astarte_bson_serializer_get_serialized(inner_bson, &inner_len);
-    if (!inner_data) {
-        ASTARTE_LOG_ERR("Error during BSON serialization");
-        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
-        goto exit;
-    }
-    if (inner_len < 0) {
-        ASTARTE_LOG_ERR("BSON document is too long for MQTT publish.");
-        ASTARTE_LOG_ERR("Interface: %s, path: %s", interface_name, path);
 
-        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
-        goto exit;
-    }
+    ares = publish_object(device, interface_name, path, &inner_bson, timestamp, qos);
 
-    astarte_bson_serializer_append_document(&outer_bson, "v", inner_data);
+exit:
+    astarte_bson_serializer_destroy(&inner_bson);
 
-    if (timestamp) {
-        astarte_bson_serializer_append_datetime(&outer_bson, "t", *timestamp);
+    return ares;
+}
+
+astarte_result_t astarte_device_tx_stream_object_values(astarte_device_handle_t device,
+    const astarte_interface_t *interface, const char *path, const astarte_data_t *values,
+    const int64_t *timestamp)
+{
+    astarte_bson_serializer_t inner_bson = { 0 };
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+
+    // The values are matched to the mappings by index, the introspection should contain this same
+    // interface definition and not only an interface with the same name
+    if (introspection_get(&device->introspection, interface->name) != interface) {
+        ASTARTE_LOG_ERR("Couldn't find interface in device introspection (%s).", interface->name);
+        ares = ASTARTE_RESULT_INTERFACE_NOT_FOUND;
+        goto exit;
     }
-    astarte_bson_serializer_append_end_of_document(&outer_bson);
 
-    int len = 0;
-    const void *data = astarte_bson_serializer_get_serialized(outer_bson, &len);
-    if (!data) {
-        ASTARTE_LOG_ERR("Error during BSON serialization");
-        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_VALIDATION);
+    ares = data_validation_object_values(interface, path, values, timestamp);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_VALIDATION);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Device aggregated data validation failed.");
         goto exit;
     }
-    if (len < 0) {
-        ASTARTE_LOG_ERR("BSON document is too long for MQTT publish.");
-        ASTARTE_LOG_ERR("Interface: %s, path: %s", interface_name, path);
 
-        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+    // All the QoS are the same in an aggregated interface
+    int qos = interface->mappings[0].reliability;
+
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_BSON_ENCODE);
+    ASTARTE_METRICS_TIMER_START(encode_timer);
+    ares = astarte_bson_serializer_init(&inner_bson);
+    if (ares == ASTARTE_RESULT_OK) {
+        ares = astarte_object_values_serialize(&inner_bson, interface, values);
+    } else {
+        ASTARTE_LOG_ERR("Could not initialize the bson serializer");
+    }
+    ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_BSON_ENCODE, encode_timer);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_BSON_ENCODE);
+    if (ares != ASTARTE_RESULT_OK) {
         goto exit;
     }
 
-    ares = publish_data(device, interface_name, path, (void *) data, len, qos);
+    ares = publish_object(device, interface->name, path, &inner_bson, timestamp, qos);
 
 exit:
-    astarte_bson_serializer_destroy(&outer_bson);
     astarte_bson_serializer_destroy(&inner_bson);
 
     return ares;
@@ -213,21 +308,71 @@ astarte_result_t astarte_device_tx_set_property(astarte_device_handle_t device,
         return ASTARTE_RESULT_INTERFACE_NOT_FOUND;
     }
 
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_VALIDATION);
     astarte_result_t ares = data_validation_set_property(interface, path, data);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_VALIDATION);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Property data validation failed.");
         return ares;
     }
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+    astarte_device_property_digest_t digest = { 0 };
+    if (compute_property_digest(interface_name, path, interface->major_version, data, &digest)
+        != ASTARTE_RESULT_OK) {
+        // Without a digest the update is always sent
+        digest.key_hash = compute_property_key_hash(interface_name, path);
+    }
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_device_connection_lock_properties(device);
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+    // Held for the whole update, so that the tracked digest matches the last value sent
+    lock_property_digests(device);
+    const astarte_device_property_digest_t *tracked = find_property_digest(device, digest.key_hash);
+    if (digest.used && tracked
+        && (memcmp(tracked->digest, digest.digest, PROPERTY_DIGEST_SIZE) == 0)) {
+        ASTARTE_LOG_DBG("Property '%s%s' is unchanged, skipping its update.", interface_name, path);
+        ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_PROPERTIES_SUPPRESSED);
+        goto unlock;
+    }
+    bool stored = true;
+#endif
+
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
     ares = astarte_device_caching_property_store(
         interface_name, path, interface->major_version, data);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Failed storing the property.");
     }
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+    stored = (ares == ASTARTE_RESULT_OK);
+#endif
+    uint16_t message_id = 0U;
+    ares = astarte_device_tx_stream_individual(
+        device, interface_name, path, data, NULL, &message_id);
+    astarte_device_connection_track_property(device, interface_name, path, message_id);
+#else
+    ares = astarte_device_tx_stream_individual(device, interface_name, path, data, NULL, NULL);
 #endif
 
-    return astarte_device_tx_stream_individual(device, interface_name, path, data, NULL);
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+    // Only a completed update makes the tracked value match the stored and sent one
+    if (digest.used && stored && (ares == ASTARTE_RESULT_OK)) {
+        track_property_digest(device, &digest);
+    } else {
+        forget_property_digest(device, digest.key_hash);
+    }
+
+unlock:
+    unlock_property_digests(device);
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_device_connection_unlock_properties(device);
+#endif
+    return ares;
 }
 
 astarte_result_t astarte_device_tx_unset_property(
@@ -240,28 +385,181 @@ astarte_result_t astarte_device_tx_unset_property(
         return ASTARTE_RESULT_INTERFACE_NOT_FOUND;
     }
 
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_VALIDATION);
     astarte_result_t ares = data_validation_unset_property(interface, path);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_VALIDATION);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Device property unset failed.");
         return ares;
     }
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_device_connection_lock_properties(device);
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+    lock_property_digests(device);
+    forget_property_digest(device, compute_property_key_hash(interface_name, path));
+    unlock_property_digests(device);
+#endif
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
     ares = astarte_device_caching_property_delete(interface_name, path);
-    if (ares != ASTARTE_RESULT_OK) {
+    astarte_device_connection_track_property(device, interface_name, path, 0);
+    if (ares == ASTARTE_RESULT_OK) {
+        astarte_device_connection_on_property_deleted(device);
+    } else {
         ASTARTE_LOG_ERR("Failed deleting the stored property.");
     }
 #endif
 
-    return publish_data(device, interface_name, path, "", 0, 2);
+    ares = publish_data(device, interface_name, path, NULL, 2, NULL);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    astarte_device_connection_unlock_properties(device);
+#endif
+    return ares;
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+void astarte_device_tx_init_property_digests(astarte_device_handle_t device)
+{
+    sys_mutex_init(&device->prop_digests_mutex);
+    memset(device->prop_digests, 0, sizeof(device->prop_digests));
+    device->prop_digests_next = 0;
+}
+
+void astarte_device_tx_clear_property_digests(astarte_device_handle_t device)
+{
+    lock_property_digests(device);
+    memset(device->prop_digests, 0, sizeof(device->prop_digests));
+    device->prop_digests_next = 0;
+    unlock_property_digests(device);
+}
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+void astarte_device_tx_flush_filtered(astarte_device_handle_t device)
+{
+    astarte_stream_filter_sample_t sample = { 0 };
+    while (astarte_stream_filter_pop_due(&device->stream_filter, &sample) == ASTARTE_RESULT_OK) {
+        astarte_result_t ares = stream_individual(device, sample.interface_name, sample.path,
+            sample.value, (sample.has_timestamp) ? &sample.timestamp : NULL, NULL, false);
+        if (ares != ASTARTE_RESULT_OK) {
+            ASTARTE_LOG_ERR("Failed sending the held value for %s%s: %s.", sample.interface_name,
+                sample.path, astarte_result_to_name(ares));
+        }
+        astarte_stream_filter_sample_destroy(sample);
+    }
 }
+#endif
 
 /************************************************
  *         Static functions definitions         *
  ***********************************************/
 
+static astarte_result_t stream_individual(astarte_device_handle_t device,
+    const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp,
+    uint16_t *out_message_id, bool filtered)
+{
+    astarte_bson_serializer_t bson = { 0 };
+    astarte_mqtt_payload_t *payload = NULL;
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+
+    const astarte_interface_t *interface = introspection_get(
+        &device->introspection, interface_name);
+    if (!interface) {
+        ASTARTE_LOG_ERR("Couldn't find interface in device introspection (%s).", interface_name);
+        ares = ASTARTE_RESULT_INTERFACE_NOT_FOUND;
+        goto exit;
+    }
+
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_VALIDATION);
+    ares = data_validation_individual_datastream(interface, path, data, timestamp);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_VALIDATION);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Device individual data validation failed.");
+        goto exit;
+    }
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+    // Filtered values are dropped or held before paying for their encoding
+    if (filtered && (interface->type == ASTARTE_INTERFACE_TYPE_DATASTREAM)) {
+        const astarte_mapping_t *mapping = NULL;
+        ares = astarte_interface_get_mapping_from_path(interface, path, &mapping);
+        if (ares != ASTARTE_RESULT_OK) {
+            ASTARTE_LOG_ERR("Failed getting the mapping for individual data streaming.");
+            goto exit;
+        }
+        if (!astarte_stream_filter_check(
+                &device->stream_filter, interface, mapping, path, data, timestamp)) {
+            // The deadline of a held value might be earlier than the one the poll is waiting for
+            astarte_device_connection_raise_poll_signal(device);
+            goto exit;
+        }
+    }
+#else
+    (void) filtered;
+#endif
+
+    int qos = 0;
+    ares = astarte_interface_get_qos(interface, path, &qos);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Failed getting QoS for individual data streaming.");
+        goto exit;
+    }
+
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_BSON_ENCODE);
+    ASTARTE_METRICS_TIMER_START(encode_timer);
+    ares = encode_individual(&bson, interface_name, path, data, timestamp, &payload);
+    ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_BSON_ENCODE, encode_timer);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_BSON_ENCODE);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ares = publish_data(device, interface_name, path, payload, qos, out_message_id);
+
+exit:
+    astarte_mqtt_payload_unref(payload);
+    astarte_bson_serializer_destroy(&bson);
+    return ares;
+}
+
+static astarte_result_t encode_individual(astarte_bson_serializer_t *bson,
+    const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp,
+    astarte_mqtt_payload_t **payload)
+{
+    astarte_result_t ares = astarte_bson_serializer_init(bson);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Could not initialize the bson serializer");
+        return ares;
+    }
+    ares = astarte_data_serialize(bson, "v", data);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+
+    if (timestamp) {
+        astarte_bson_serializer_append_datetime(bson, "t", *timestamp);
+    }
+    astarte_bson_serializer_append_end_of_document(bson);
+
+    int data_ser_len = 0;
+    void *data_ser = (void *) astarte_bson_serializer_get_serialized(*bson, &data_ser_len);
+    if (!data_ser) {
+        ASTARTE_LOG_ERR("Error during BSON serialization.");
+        return ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+    }
+    if (data_ser_len < 0) {
+        ASTARTE_LOG_ERR("BSON document is too long for MQTT publish.");
+        ASTARTE_LOG_ERR("Interface: %s, path: %s", interface_name, path);
+        return ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+    }
+
+    return payload_from_bson(bson, payload);
+}
+
 static astarte_result_t publish_data(astarte_device_handle_t device, const char *interface_name,
-    const char *path, void *data, int data_size, int qos)
+    const char *path, astarte_mqtt_payload_t *payload, int qos, uint16_t *out_message_id)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     char *topic = NULL;
@@ -280,7 +578,7 @@ static astarte_result_t publish_data(astarte_device_handle_t device, const char
 
     size_t topic_len = strlen(CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "//") + ASTARTE_DEVICE_ID_LEN
         + strlen(interface_name) + strlen(path);
-    topic = calloc(topic_len + 1, sizeof(char));
+    topic = astarte_calloc(topic_len + 1, sizeof(char));
     if (!topic) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -295,9 +593,215 @@ static astarte_result_t publish_data(astarte_device_handle_t device, const char
         goto exit;
     }
 
-    astarte_mqtt_publish(&device->astarte_mqtt, topic, data, data_size, qos, NULL);
+    astarte_mqtt_publish_payload(&device->astarte_mqtt, topic, payload, qos, out_message_id);
+    ASTARTE_METRICS_INTERFACE_SENT(interface_name, (payload) ? payload->size : 0);
+
+exit:
+    astarte_free(topic);
+    return ares;
+}
+
+static astarte_result_t publish_object(astarte_device_handle_t device, const char *interface_name,
+    const char *path, astarte_bson_serializer_t *inner_bson, const int64_t *timestamp, int qos)
+{
+    astarte_bson_serializer_t outer_bson = { 0 };
+    astarte_mqtt_payload_t *payload = NULL;
+
+    astarte_result_t ares = astarte_bson_serializer_init(&outer_bson);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Could not initialize the bson serializer");
+        goto exit;
+    }
+    astarte_bson_serializer_append_end_of_document(inner_bson);
+    int inner_len = 0;
+    const void *inner_data = astarte_bson_serializer_get_serialized(*inner_bson, &inner_len);
+    if (!inner_data) {
+        ASTARTE_LOG_ERR("Error during BSON serialization");
+        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+        goto exit;
+    }
+    if (inner_len < 0) {
+        ASTARTE_LOG_ERR("BSON document is too long for MQTT publish.");
+        ASTARTE_LOG_ERR("Interface: %s, path: %s", interface_name, path);
+
+        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+        goto exit;
+    }
+
+    astarte_bson_serializer_append_document(&outer_bson, "v", inner_data);
+
+    if (timestamp) {
+        astarte_bson_serializer_append_datetime(&outer_bson, "t", *timestamp);
+    }
+    astarte_bson_serializer_append_end_of_document(&outer_bson);
+
+    int len = 0;
+    const void *data = astarte_bson_serializer_get_serialized(outer_bson, &len);
+    if (!data) {
+        ASTARTE_LOG_ERR("Error during BSON serialization");
+        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+        goto exit;
+    }
+    if (len < 0) {
+        ASTARTE_LOG_ERR("BSON document is too long for MQTT publish.");
+        ASTARTE_LOG_ERR("Interface: %s, path: %s", interface_name, path);
+
+        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+        goto exit;
+    }
+
+    ares = payload_from_bson(&outer_bson, &payload);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    ares = publish_data(device, interface_name, path, payload, qos, NULL);
 
 exit:
-    free(topic);
+    astarte_mqtt_payload_unref(payload);
+    astarte_bson_serializer_destroy(&outer_bson);
+
     return ares;
 }
+
+static astarte_result_t payload_from_bson(
+    astarte_bson_serializer_t *bson, astarte_mqtt_payload_t **payload)
+{
+    size_t data_size = 0;
+    void *data = astarte_bson_serializer_detach(bson, &data_size);
+    if (!data) {
+        ASTARTE_LOG_ERR("Error during BSON serialization.");
+        return ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+    }
+
+    *payload = astarte_mqtt_payload_wrap(data, data_size);
+    if (!*payload) {
+        astarte_free(data);
+        return ASTARTE_RESULT_OUT_OF_MEMORY;
+    }
+
+    return ASTARTE_RESULT_OK;
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+static astarte_result_t compute_property_digest(const char *interface_name, const char *path,
+    uint32_t major, astarte_data_t data, astarte_device_property_digest_t *digest)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_bson_serializer_t bson = { 0 };
+    mbedtls_sha256_context ctx = { 0 };
+    mbedtls_sha256_init(&ctx);
+
+    // The value is digested in the same encoding used by the permanent storage
+    ares = astarte_bson_serializer_init(&bson);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Could not initialize the bson serializer");
+        goto exit;
+    }
+    astarte_bson_serializer_append_int64(&bson, "type", (int64_t) data.tag);
+    ares = astarte_data_serialize(&bson, "data", data);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+    astarte_bson_serializer_append_end_of_document(&bson);
+
+    int data_ser_len = 0;
+    const void *data_ser = astarte_bson_serializer_get_serialized(bson, &data_ser_len);
+    if (!data_ser || (data_ser_len < 0)) {
+        ASTARTE_LOG_ERR("Error during BSON serialization.");
+        ares = ASTARTE_RESULT_BSON_SERIALIZER_ERROR;
+        goto exit;
+    }
+
+    // The string terminators separate the interface name, the path and the value
+    uint8_t major_be[sizeof(uint32_t)] = { 0 };
+    sys_put_be32(major, major_be);
+    int ret = mbedtls_sha256_starts(&ctx, 0);
+    if (ret == 0) {
+        ret = mbedtls_sha256_update(
+            &ctx, (const unsigned char *) interface_name, strlen(interface_name) + 1);
+    }
+    if (ret == 0) {
+        ret = mbedtls_sha256_update(&ctx, (const unsigned char *) path, strlen(path) + 1);
+    }
+    if (ret == 0) {
+        ret = mbedtls_sha256_update(&ctx, major_be, sizeof(major_be));
+    }
+    if (ret == 0) {
+        ret = mbedtls_sha256_update(&ctx, data_ser, data_ser_len);
+    }
+    if (ret == 0) {
+        ret = mbedtls_sha256_finish(&ctx, digest->digest);
+    }
+    if (ret != 0) {
+        ASTARTE_LOG_ERR("Property digest computation failed: %d", ret);
+        ares = ASTARTE_RESULT_MBEDTLS_ERROR;
+        goto exit;
+    }
+
+    digest->used = true;
+    digest->key_hash = compute_property_key_hash(interface_name, path);
+
+exit:
+    mbedtls_sha256_free(&ctx);
+    astarte_bson_serializer_destroy(&bson);
+    return ares;
+}
+
+static uint32_t compute_property_key_hash(const char *interface_name, const char *path)
+{
+    // Collisions only cost a tracked entry, the digest also covers the interface name and path
+    return (sys_hash32(interface_name, strlen(interface_name)) * 31U)
+        ^ sys_hash32(path, strlen(path));
+}
+
+static astarte_device_property_digest_t *find_property_digest(
+    astarte_device_handle_t device, uint32_t key_hash)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(device->prop_digests); i++) {
+        if (device->prop_digests[i].used && (device->prop_digests[i].key_hash == key_hash)) {
+            return &device->prop_digests[i];
+        }
+    }
+    return NULL;
+}
+
+static void track_property_digest(
+    astarte_device_handle_t device, const astarte_device_property_digest_t *digest)
+{
+    astarte_device_property_digest_t *entry = find_property_digest(device, digest->key_hash);
+    for (size_t i = 0; !entry && (i < ARRAY_SIZE(device->prop_digests)); i++) {
+        if (!device->prop_digests[i].used) {
+            entry = &device->prop_digests[i];
+        }
+    }
+    if (!entry) {
+        entry = &device->prop_digests[device->prop_digests_next];
+        device->prop_digests_next
+            = (device->prop_digests_next + 1) % ARRAY_SIZE(device->prop_digests);
+    }
+    *entry = *digest;
+}
+
+static void forget_property_digest(astarte_device_handle_t device, uint32_t key_hash)
+{
+    astarte_device_property_digest_t *entry = find_property_digest(device, key_hash);
+    if (entry) {
+        entry->used = false;
+    }
+}
+
+static void lock_property_digests(astarte_device_handle_t device)
+{
+    int mutex_rc = sys_mutex_lock(&device->prop_digests_mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+
+static void unlock_property_digests(astarte_device_handle_t device)
+{
+    int mutex_rc = sys_mutex_unlock(&device->prop_digests_mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+#endif
@@ -0,0 +1,334 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "astarte_device_sdk/heap.h"
+#include "heap_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK)
+#include <zephyr/kernel.h>
+#endif
+
+#include "log.h"
+
+ASTARTE_LOG_MODULE_REGISTER(astarte_heap, CONFIG_ASTARTE_DEVICE_SDK_HEAP_LOG_LEVEL);
+
+/************************************************
+ *        Defines, constants and typedef        *
+ ***********************************************/
+
+/** @brief Bookkeeping header prepended to each allocated block. */
+typedef union
+{
+    /** @brief Allocation information used for the accounting */
+    struct
+    {
+        /** @brief Size requested for the block */
+        size_t size;
+        /** @brief Module to which the block is attributed */
+        astarte_heap_module_t module;
+    } info;
+    /** @brief Keeps the memory following the header aligned as malloc would */
+    max_align_t align;
+} heap_header_t;
+
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_HEAP)
+K_HEAP_DEFINE(astarte_sdk_heap, CONFIG_ASTARTE_DEVICE_SDK_HEAP_SIZE);
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+// Blocks are multiples of the header size, keeping each block of a pool aligned
+#define POOL_BLOCK_SIZE(usable_size)                                                               \
+    ROUND_UP((usable_size) + sizeof(heap_header_t), sizeof(heap_header_t))
+
+#define POOL_SMALL_BLOCK_SIZE                                                                      \
+    POOL_BLOCK_SIZE(CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_SMALL_BLOCK_SIZE)
+#define POOL_MEDIUM_BLOCK_SIZE                                                                     \
+    POOL_BLOCK_SIZE(CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_MEDIUM_BLOCK_SIZE)
+#define POOL_LARGE_BLOCK_SIZE                                                                      \
+    POOL_BLOCK_SIZE(CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_LARGE_BLOCK_SIZE)
+
+BUILD_ASSERT((POOL_SMALL_BLOCK_SIZE < POOL_MEDIUM_BLOCK_SIZE)
+        && (POOL_MEDIUM_BLOCK_SIZE < POOL_LARGE_BLOCK_SIZE),
+    "The static pools should have increasing block sizes");
+
+K_MEM_SLAB_DEFINE_STATIC(pool_small, POOL_SMALL_BLOCK_SIZE,
+    CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_SMALL_BLOCK_COUNT, __alignof__(heap_header_t));
+K_MEM_SLAB_DEFINE_STATIC(pool_medium, POOL_MEDIUM_BLOCK_SIZE,
+    CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_MEDIUM_BLOCK_COUNT, __alignof__(heap_header_t));
+K_MEM_SLAB_DEFINE_STATIC(pool_large, POOL_LARGE_BLOCK_SIZE,
+    CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_LARGE_BLOCK_COUNT, __alignof__(heap_header_t));
+
+/** @brief A static pool and the size of its blocks, ordered by increasing block size. */
+static const struct
+{
+    struct k_mem_slab *slab;
+    size_t block_size;
+} pools[] = {
+    { &pool_small, POOL_SMALL_BLOCK_SIZE },
+    { &pool_medium, POOL_MEDIUM_BLOCK_SIZE },
+    { &pool_large, POOL_LARGE_BLOCK_SIZE },
+};
+#endif
+
+// Unit tests compile this file without the SDK Kconfig options and without a kernel
+#if defined(CONFIG_ASTARTE_DEVICE_SDK)
+static struct k_spinlock heap_lock;
+#define HEAP_LOCK() k_spinlock_key_t heap_lock_key = k_spin_lock(&heap_lock)
+#define HEAP_UNLOCK() k_spin_unlock(&heap_lock, heap_lock_key)
+#else
+#define HEAP_LOCK()
+#define HEAP_UNLOCK()
+#endif
+
+static astarte_heap_allocator_t custom_allocator;
+static astarte_heap_stats_t heap_stats;
+
+static const char *const module_names[ASTARTE_HEAP_MODULE_COUNT] = {
+    [ASTARTE_HEAP_MODULE_BSON] = "BSON",
+    [ASTARTE_HEAP_MODULE_DATA] = "DATA",
+    [ASTARTE_HEAP_MODULE_DEVICE] = "DEVICE",
+    [ASTARTE_HEAP_MODULE_DEVICE_CACHING] = "DEVICE_CACHING",
+    [ASTARTE_HEAP_MODULE_DEVICE_CLIENT_CRT] = "DEVICE_CLIENT_CRT",
+    [ASTARTE_HEAP_MODULE_DEVICE_CONNECTION] = "DEVICE_CONNECTION",
+    [ASTARTE_HEAP_MODULE_DEVICE_RX] = "DEVICE_RX",
+    [ASTARTE_HEAP_MODULE_DEVICE_TX] = "DEVICE_TX",
+    [ASTARTE_HEAP_MODULE_INTERFACE] = "INTERFACE",
+    [ASTARTE_HEAP_MODULE_INTROSPECTION] = "INTROSPECTION",
+    [ASTARTE_HEAP_MODULE_KV_STORAGE] = "KV_STORAGE",
+    [ASTARTE_HEAP_MODULE_MQTT] = "MQTT",
+    [ASTARTE_HEAP_MODULE_MQTT_CACHING] = "MQTT_CACHING",
+    [ASTARTE_HEAP_MODULE_OBJECT] = "OBJECT",
+    [ASTARTE_HEAP_MODULE_STREAM_FILTER] = "STREAM_FILTER",
+    [ASTARTE_HEAP_MODULE_ZLIB] = "ZLIB",
+};
+
+/************************************************
+ *         Static functions declaration         *
+ ***********************************************/
+
+/**
+ * @brief Allocate a raw block from the configured allocator.
+ *
+ * @param[in] size Size of the block, including the bookkeeping header.
+ * @return The allocated block, NULL if out of memory.
+ */
+static void *backend_alloc(size_t size);
+
+/**
+ * @brief Free a raw block allocated with #backend_alloc.
+ *
+ * @param[in] ptr Block to free.
+ * @param[in] size Size of the block, as passed to #backend_alloc.
+ */
+static void backend_free(void *ptr, size_t size);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+/**
+ * @brief Get the smallest static pool with blocks fitting a raw block.
+ *
+ * @param[in] size Size of the raw block, including the bookkeeping header.
+ * @return The pool slab, NULL if the block is larger than the blocks of every pool.
+ */
+static struct k_mem_slab *get_pool(size_t size);
+#endif
+
+/************************************************
+ *     Global public functions definitions      *
+ ***********************************************/
+
+astarte_result_t astarte_heap_set_allocator(const astarte_heap_allocator_t *allocator)
+{
+    if (allocator && (!allocator->alloc || !allocator->free)) {
+        ASTARTE_LOG_ERR("Custom allocators should provide both an alloc and a free function.");
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    HEAP_LOCK();
+    if (heap_stats.live_blocks != 0) {
+        ares = ASTARTE_RESULT_INVALID_CONFIGURATION;
+    } else {
+        custom_allocator = (allocator) ? *allocator : (astarte_heap_allocator_t) { 0 };
+    }
+    HEAP_UNLOCK();
+
+    ASTARTE_LOG_COND_ERR(ares != ASTARTE_RESULT_OK,
+        "The allocator can't be replaced while the SDK has allocated memory.");
+    return ares;
+}
+
+void astarte_heap_get_stats(astarte_heap_stats_t *stats)
+{
+    HEAP_LOCK();
+    *stats = heap_stats;
+    HEAP_UNLOCK();
+}
+
+void astarte_heap_reset_peak(void)
+{
+    HEAP_LOCK();
+    heap_stats.peak_bytes = heap_stats.live_bytes;
+    for (size_t i = 0; i < ASTARTE_HEAP_MODULE_COUNT; i++) {
+        heap_stats.modules[i].peak_bytes = heap_stats.modules[i].live_bytes;
+    }
+    HEAP_UNLOCK();
+}
+
+const char *astarte_heap_module_to_name(astarte_heap_module_t module)
+{
+    if ((unsigned int) module >= ASTARTE_HEAP_MODULE_COUNT) {
+        return "UNKNOWN";
+    }
+    return module_names[module];
+}
+
+/************************************************
+ *     Global private functions definitions     *
+ ***********************************************/
+
+void *astarte_heap_malloc(astarte_heap_module_t module, size_t size)
+{
+    size_t block_size = 0;
+    heap_header_t *header = NULL;
+    if (!size_add_overflow(size, sizeof(heap_header_t), &block_size)) {
+        header = backend_alloc(block_size);
+    }
+
+    HEAP_LOCK();
+    if (!header) {
+        heap_stats.failed_allocations++;
+    } else {
+        astarte_heap_module_stats_t *module_stats = &heap_stats.modules[module];
+        heap_stats.live_blocks++;
+        heap_stats.live_bytes += size;
+        heap_stats.peak_bytes = MAX(heap_stats.peak_bytes, heap_stats.live_bytes);
+        module_stats->live_bytes += size;
+        module_stats->peak_bytes = MAX(module_stats->peak_bytes, module_stats->live_bytes);
+    }
+    HEAP_UNLOCK();
+
+    if (!header) {
+        return NULL;
+    }
+    header->info.size = size;
+    header->info.module = module;
+    return header + 1;
+}
+
+void *astarte_heap_calloc(astarte_heap_module_t module, size_t num, size_t size)
+{
+    size_t total_size = 0;
+    if (size_mul_overflow(num, size, &total_size)) {
+        return NULL;
+    }
+
+    void *ptr = astarte_heap_malloc(module, total_size);
+    if (ptr) {
+        memset(ptr, 0, total_size);
+    }
+    return ptr;
+}
+
+void *astarte_heap_realloc(astarte_heap_module_t module, void *ptr, size_t size)
+{
+    if (!ptr) {
+        return astarte_heap_malloc(module, size);
+    }
+    if (size == 0) {
+        astarte_heap_free(ptr);
+        return NULL;
+    }
+
+    const heap_header_t *header = (const heap_header_t *) ptr - 1;
+    void *new_ptr = astarte_heap_malloc(module, size);
+    if (!new_ptr) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, MIN(size, header->info.size));
+    astarte_heap_free(ptr);
+    return new_ptr;
+}
+
+void astarte_heap_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    heap_header_t *header = (heap_header_t *) ptr - 1;
+    size_t size = header->info.size;
+    astarte_heap_module_t module = header->info.module;
+
+    HEAP_LOCK();
+    heap_stats.live_blocks--;
+    heap_stats.live_bytes -= size;
+    heap_stats.modules[module].live_bytes -= size;
+    HEAP_UNLOCK();
+
+    backend_free(header, size + sizeof(heap_header_t));
+}
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+static void *backend_alloc(size_t size)
+{
+    if (custom_allocator.alloc) {
+        return custom_allocator.alloc(size, custom_allocator.user_data);
+    }
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_HEAP)
+    return k_heap_aligned_alloc(&astarte_sdk_heap, __alignof__(heap_header_t), size, K_NO_WAIT);
+#elif defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+    struct k_mem_slab *pool = get_pool(size);
+    void *block = NULL;
+    if (!pool || (k_mem_slab_alloc(pool, &block, K_NO_WAIT) != 0)) {
+        return NULL;
+    }
+    return block;
+#else
+    return malloc(size);
+#endif
+}
+
+static void backend_free(void *ptr, size_t size)
+{
+    if (custom_allocator.free) {
+        custom_allocator.free(ptr, custom_allocator.user_data);
+        return;
+    }
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_HEAP)
+    ARG_UNUSED(size);
+    k_heap_free(&astarte_sdk_heap, ptr);
+#elif defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+    k_mem_slab_free(get_pool(size), ptr);
+#else
+    ARG_UNUSED(size);
+    free(ptr);
+#endif
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION)
+static struct k_mem_slab *get_pool(size_t size)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(pools); i++) {
+        if (size <= pools[i].block_size) {
+            return pools[i].slab;
+        }
+    }
+    return NULL;
+}
+#endif
@@ -0,0 +1,26 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Built by the native simulator with the host C library. The native_sim clock only advances while
+ * the CPU is idle, the host clock also accounts for the time spent running the measured code.
+ */
+
+#include "host_clock.h"
+
+#include <time.h>
+
+uint64_t astarte_host_clock_get_ns(void)
+{
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+uint64_t astarte_host_clock_get_us(void)
+{
+    return astarte_host_clock_get_ns() / 1000U;
+}
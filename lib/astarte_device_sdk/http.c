@@ -13,6 +13,8 @@
 
 #if !defined(CONFIG_ASTARTE_DEVICE_SDK_DEVELOP_USE_NON_TLS_HTTP)
 #include <zephyr/net/tls_credentials.h>
+
+#include "tls_credentials.h"
 #endif
 
 #include "log.h"
@@ -33,20 +35,35 @@ BUILD_ASSERT(sizeof(CONFIG_ASTARTE_DEVICE_SDK_HOSTNAME) != 1, "Missing hostname
  *       Callbacks declaration/definition       *
  ***********************************************/
 
+/** @brief Outcome of an HTTP request, filled by #http_response_cb. */
+struct http_request_outcome
+{
+    /** @brief Set when the status of the response has been received. */
+    bool responded;
+    /** @brief Cleared when the response is too long or reports a failure. */
+    bool ok;
+};
+
 static void http_response_cb(
     struct http_response *rsp, enum http_final_call final_data, void *user_data)
 {
-    bool *request_ok = (bool *) user_data;
+    struct http_request_outcome *outcome = (struct http_request_outcome *) user_data;
+    // A connection closed by the server before responding ends the request without a status
+    if (rsp->http_status_code == 0) {
+        outcome->ok = false;
+        return;
+    }
+    outcome->responded = true;
     if (final_data == HTTP_DATA_MORE) {
         ASTARTE_LOG_ERR("Partial data received (%zd bytes)", rsp->data_len);
         ASTARTE_LOG_ERR("HTTP reply is too long for rx buffer.");
-        *request_ok = false;
+        outcome->ok = false;
     } else if (final_data == HTTP_DATA_FINAL) {
         ASTARTE_LOG_DBG("All the data received (%zd bytes)", rsp->data_len);
         if ((rsp->http_status_code != HTTP_200_OK) && (rsp->http_status_code != HTTP_201_CREATED)) {
             ASTARTE_LOG_ERR("HTTP request failed, response code: %s %d", rsp->http_status,
                 rsp->http_status_code);
-            *request_ok = false;
+            outcome->ok = false;
         }
     }
 }
@@ -56,13 +73,45 @@ static void http_response_cb(
  ***********************************************/
 
 /**
- * @brief Create a new TCP socket and connect it to a server.
+ * @brief Perform an HTTP request using an HTTP client session.
+ *
+ * @param[inout] session Session to use for the request.
+ * @param[in] method HTTP method for the request.
+ * @param[in] timeout_ms Timeout to use for the HTTP operations in ms.
+ * @param[in] url Partial URL to use for the request.
+ * @param[in] header_fields NULL terminated list of headers for the request.
+ * @param[in] payload Payload to transmit, NULL for requests without a payload.
+ * @param[out] resp_buf Output buffer where to store the response from the server.
+ * @param[in] resp_buf_size Size of the response output buffer.
+ * @param[in] keep_alive True if the connection should be kept open after the request.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t session_request(astarte_http_session_t *session, enum http_method method,
+    int32_t timeout_ms, const char *url, const char **header_fields, const char *payload,
+    uint8_t *resp_buf, size_t resp_buf_size, bool keep_alive);
+/**
+ * @brief Connect the session to the Astarte host, resolving its address if required.
+ *
+ * @param[inout] session Session to connect.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t session_connect(astarte_http_session_t *session);
+/**
+ * @brief Resolve the address of the Astarte host.
+ *
+ * @param[inout] session Session where to store the resolved address.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t resolve_address(astarte_http_session_t *session);
+/**
+ * @brief Create a new TCP socket and connect it to the resolved address.
  *
  * @note The returned socket should be closed once its use has terminated.
  *
+ * @param[in] session Session containing the resolved address.
  * @return -1 upon failure, a file descriptor for the new socket otherwise.
  */
-static int create_and_connect_socket(void);
+static int create_and_connect_socket(const astarte_http_session_t *session);
 
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_HTTP_LOG_LEVEL_DBG)
 /**
@@ -80,109 +129,119 @@ static void dump_addrinfo(const struct zsock_addrinfo *input_addinfo);
 astarte_result_t astarte_http_post(int32_t timeout_ms, const char *url, const char **header_fields,
     const char *payload, uint8_t *resp_buf, size_t resp_buf_size)
 {
-    // Create and connect the socket to use
-    int sock = create_and_connect_socket();
-    if (sock < 0) {
-        return ASTARTE_RESULT_SOCKET_ERROR;
-    }
-
-    struct http_request req = { 0 };
-    uint8_t recv_buf[CONFIG_ASTARTE_DEVICE_SDK_ADVANCED_HTTP_RCV_BUFFER_SIZE];
-    memset(&recv_buf, 0, sizeof(recv_buf));
-
-    req.method = HTTP_POST;
-    req.host = CONFIG_ASTARTE_DEVICE_SDK_HOSTNAME;
-#if defined(CONFIG_ASTARTE_DEVICE_SDK_DEVELOP_USE_NON_TLS_HTTP)
-    req.port = "80";
-#else
-    req.port = "443";
-#endif
-    req.url = url;
-    req.content_type_value = "application/json";
-    req.header_fields = header_fields;
-    req.protocol = "HTTP/1.1";
-    req.response = http_response_cb;
-    req.payload = payload;
-    req.payload_len = strlen(payload);
-    req.recv_buf = recv_buf;
-    req.recv_buf_len = sizeof(recv_buf);
-
-    bool post_ok = true;
-
-    int http_rc = http_client_req(sock, &req, timeout_ms, &post_ok);
-    if ((http_rc < 0) || !post_ok) {
-        ASTARTE_LOG_ERR("HTTP post request failed: %d", http_rc);
-        ASTARTE_LOG_ERR("Receive buffer content:\n%s", recv_buf);
-        zsock_close(sock);
-        return ASTARTE_RESULT_HTTP_REQUEST_ERROR;
-    }
+    astarte_http_session_t session = { 0 };
+    astarte_http_session_init(&session);
+    return session_request(&session, HTTP_POST, timeout_ms, url, header_fields, payload, resp_buf,
+        resp_buf_size, false);
+}
 
-    // Close the used socket
-    zsock_close(sock);
+astarte_result_t astarte_http_get(int32_t timeout_ms, const char *url, const char **header_fields,
+    uint8_t *resp_buf, size_t resp_buf_size)
+{
+    astarte_http_session_t session = { 0 };
+    astarte_http_session_init(&session);
+    return session_request(
+        &session, HTTP_GET, timeout_ms, url, header_fields, NULL, resp_buf, resp_buf_size, false);
+}
 
-    // Find the two consecutive CRLF (string "\r\n\r\n") indicating the end of the headers section
-    uint8_t *http_recv_body = NULL;
-    const char two_crlf[] = "\r\n\r\n";
-    for (size_t i = 0; i < CONFIG_ASTARTE_DEVICE_SDK_ADVANCED_HTTP_RCV_BUFFER_SIZE - 4; i++) {
-        if (memcmp(recv_buf + i, two_crlf, 4) == 0) {
-            http_recv_body = recv_buf + i + 4;
-            break;
-        }
-    }
+void astarte_http_session_init(astarte_http_session_t *session)
+{
+    *session = (astarte_http_session_t) { 0 };
+    session->sock = -1;
+}
 
-    // Check that sufficient space is present in the response buffer
-    if (resp_buf_size <= strlen(http_recv_body)) {
-        ASTARTE_LOG_ERR("Insufficient output buffer for HTTP post function.");
-        ASTARTE_LOG_ERR("Requires %d bytes.", strlen(http_recv_body) + 1);
-        return ASTARTE_RESULT_INVALID_PARAM;
+void astarte_http_session_close(astarte_http_session_t *session)
+{
+    if (session->sock >= 0) {
+        zsock_close(session->sock);
+        session->sock = -1;
     }
+}
 
-    // Copy the received data to the response buffer
-    memcpy(resp_buf, http_recv_body, strlen(http_recv_body) + 1);
-
-    return ASTARTE_RESULT_OK;
+astarte_result_t astarte_http_session_post(astarte_http_session_t *session, int32_t timeout_ms,
+    const char *url, const char **header_fields, const char *payload, uint8_t *resp_buf,
+    size_t resp_buf_size)
+{
+    return session_request(session, HTTP_POST, timeout_ms, url, header_fields, payload, resp_buf,
+        resp_buf_size, true);
 }
 
-astarte_result_t astarte_http_get(int32_t timeout_ms, const char *url, const char **header_fields,
-    uint8_t *resp_buf, size_t resp_buf_size)
+astarte_result_t astarte_http_session_get(astarte_http_session_t *session, int32_t timeout_ms,
+    const char *url, const char **header_fields, uint8_t *resp_buf, size_t resp_buf_size)
 {
-    // Create and connect the socket to use
-    int sock = create_and_connect_socket();
-    if (sock < 0) {
-        return ASTARTE_RESULT_SOCKET_ERROR;
-    }
+    return session_request(
+        session, HTTP_GET, timeout_ms, url, header_fields, NULL, resp_buf, resp_buf_size, true);
+}
 
-    struct http_request req = { 0 };
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+static astarte_result_t session_request(astarte_http_session_t *session, enum http_method method,
+    int32_t timeout_ms, const char *url, const char **header_fields, const char *payload,
+    uint8_t *resp_buf, size_t resp_buf_size, bool keep_alive)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
     uint8_t recv_buf[CONFIG_ASTARTE_DEVICE_SDK_ADVANCED_HTTP_RCV_BUFFER_SIZE];
-    memset(&recv_buf, 0, sizeof(recv_buf));
+    const char *optional_headers[] = {
+        (keep_alive) ? "Connection: keep-alive\r\n" : "Connection: close\r\n",
+        NULL,
+    };
 
-    req.method = HTTP_GET;
-    req.host = CONFIG_ASTARTE_DEVICE_SDK_HOSTNAME;
+    // A connection kept open from a previous request might have been closed by the server
+    bool reused = (session->sock >= 0);
+    for (int attempt = 0; attempt < ((reused) ? 2 : 1); attempt++) {
+        if (session->sock < 0) {
+            ares = session_connect(session);
+            if (ares != ASTARTE_RESULT_OK) {
+                return ares;
+            }
+        }
+
+        struct http_request req = { 0 };
+        memset(&recv_buf, 0, sizeof(recv_buf));
+
+        req.method = method;
+        req.host = CONFIG_ASTARTE_DEVICE_SDK_HOSTNAME;
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_DEVELOP_USE_NON_TLS_HTTP)
-    req.port = "80";
+        req.port = "80";
 #else
-    req.port = "443";
+        req.port = "443";
 #endif
-    req.url = url;
-    req.content_type_value = "application/json";
-    req.header_fields = header_fields;
-    req.protocol = "HTTP/1.1";
-    req.response = http_response_cb;
-    req.recv_buf = recv_buf;
-    req.recv_buf_len = sizeof(recv_buf);
-
-    bool get_ok = true;
-
-    int http_rc = http_client_req(sock, &req, timeout_ms, &get_ok);
-    if ((http_rc < 0) || !get_ok) {
-        ASTARTE_LOG_ERR("HTTP request failed: %d", http_rc);
-        ASTARTE_LOG_ERR("Receive buffer content:\n%s", recv_buf);
-        zsock_close(sock);
-        return ASTARTE_RESULT_HTTP_REQUEST_ERROR;
+        req.url = url;
+        req.content_type_value = "application/json";
+        req.header_fields = header_fields;
+        req.optional_headers = optional_headers;
+        req.protocol = "HTTP/1.1";
+        req.response = http_response_cb;
+        if (payload) {
+            req.payload = payload;
+            req.payload_len = strlen(payload);
+        }
+        req.recv_buf = recv_buf;
+        req.recv_buf_len = sizeof(recv_buf);
+
+        struct http_request_outcome outcome = { .responded = false, .ok = true };
+
+        int http_rc = http_client_req(session->sock, &req, timeout_ms, &outcome);
+        // The server might close an idle connection with an error or with a clean end of stream
+        if (!outcome.responded && reused && (attempt == 0)) {
+            ASTARTE_LOG_DBG("Kept alive connection has been closed, reconnecting.");
+            astarte_http_session_close(session);
+            continue;
+        }
+        if ((http_rc < 0) || !outcome.ok) {
+            ASTARTE_LOG_ERR("HTTP request failed: %d", http_rc);
+            ASTARTE_LOG_ERR("Receive buffer content:\n%s", recv_buf);
+            astarte_http_session_close(session);
+            return ASTARTE_RESULT_HTTP_REQUEST_ERROR;
+        }
+        break;
     }
 
-    // Close the socket
-    zsock_close(sock);
+    if (!keep_alive) {
+        astarte_http_session_close(session);
+    }
 
     // Find the two consecutive CRLF (string "\r\n\r\n") indicating the end of the headers section
     uint8_t *http_recv_body = NULL;
@@ -193,10 +252,14 @@ astarte_result_t astarte_http_get(int32_t timeout_ms, const char *url, const cha
             break;
         }
     }
+    if (!http_recv_body) {
+        ASTARTE_LOG_ERR("Malformed HTTP response, missing end of headers.");
+        return ASTARTE_RESULT_HTTP_REQUEST_ERROR;
+    }
 
     // Check that sufficient space is present in the response buffer
     if (resp_buf_size <= strlen(http_recv_body)) {
-        ASTARTE_LOG_ERR("Insufficient output buffer for HTTP post function.");
+        ASTARTE_LOG_ERR("Insufficient output buffer for HTTP request.");
         ASTARTE_LOG_ERR("Requires %d bytes.", strlen(http_recv_body) + 1);
         return ASTARTE_RESULT_INVALID_PARAM;
     }
@@ -207,11 +270,25 @@ astarte_result_t astarte_http_get(int32_t timeout_ms, const char *url, const cha
     return ASTARTE_RESULT_OK;
 }
 
-/************************************************
- *         Static functions definitions         *
- ***********************************************/
+static astarte_result_t session_connect(astarte_http_session_t *session)
+{
+    if (session->addrlen == 0) {
+        astarte_result_t ares = resolve_address(session);
+        if (ares != ASTARTE_RESULT_OK) {
+            return ares;
+        }
+    }
 
-static int create_and_connect_socket(void)
+    session->sock = create_and_connect_socket(session);
+    if (session->sock < 0) {
+        // The host address might have changed, resolve it again on the next attempt
+        session->addrlen = 0;
+        return ASTARTE_RESULT_SOCKET_ERROR;
+    }
+    return ASTARTE_RESULT_OK;
+}
+
+static astarte_result_t resolve_address(astarte_http_session_t *session)
 {
     char hostname[] = CONFIG_ASTARTE_DEVICE_SDK_HOSTNAME;
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_DEVELOP_USE_NON_TLS_HTTP)
@@ -230,22 +307,30 @@ static int create_and_connect_socket(void)
         if (getaddrinfo_rc == DNS_EAI_SYSTEM) {
             ASTARTE_LOG_ERR("Errno: %s", strerror(errno));
         }
-        return -1;
+        return ASTARTE_RESULT_SOCKET_ERROR;
     }
 
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_HTTP_LOG_LEVEL_DBG)
     dump_addrinfo(broker_addrinfo);
 #endif
 
+    memcpy(&session->addr, broker_addrinfo->ai_addr, broker_addrinfo->ai_addrlen);
+    session->addrlen = broker_addrinfo->ai_addrlen;
+    zsock_freeaddrinfo(broker_addrinfo);
+    return ASTARTE_RESULT_OK;
+}
+
+static int create_and_connect_socket(const astarte_http_session_t *session)
+{
 #if defined(CONFIG_ASTARTE_DEVICE_SDK_DEVELOP_USE_NON_TLS_HTTP)
     int proto = IPPROTO_TCP;
 #else
+    char hostname[] = CONFIG_ASTARTE_DEVICE_SDK_HOSTNAME;
     int proto = IPPROTO_TLS_1_2;
 #endif
-    int sock = zsock_socket(broker_addrinfo->ai_family, broker_addrinfo->ai_socktype, proto);
+    int sock = zsock_socket(session->addr.sa_family, SOCK_STREAM, proto);
     if (sock == -1) {
         ASTARTE_LOG_ERR("Socket creation error: %d", sock);
-        zsock_freeaddrinfo(broker_addrinfo);
         return -1;
     }
 
@@ -258,7 +343,6 @@ static int create_and_connect_socket(void)
     if (sockopt_rc == -1) {
         ASTARTE_LOG_ERR("Socket options error: %d", sockopt_rc);
         zsock_close(sock);
-        zsock_freeaddrinfo(broker_addrinfo);
         return -1;
     }
 
@@ -266,22 +350,23 @@ static int create_and_connect_socket(void)
     if (sockopt_rc == -1) {
         ASTARTE_LOG_ERR("Socket options error: %d", sockopt_rc);
         zsock_close(sock);
-        zsock_freeaddrinfo(broker_addrinfo);
+        return -1;
+    }
+
+    if (astarte_tls_session_cache_enable(sock) != ASTARTE_RESULT_OK) {
+        zsock_close(sock);
         return -1;
     }
 #endif
 
-    int connect_rc = zsock_connect(sock, broker_addrinfo->ai_addr, broker_addrinfo->ai_addrlen);
+    int connect_rc = zsock_connect(sock, &session->addr, session->addrlen);
     if (connect_rc == -1) {
         ASTARTE_LOG_ERR("Connection error: %d", connect_rc);
         ASTARTE_LOG_ERR("Errno: (%d) %s", errno, strerror(errno));
         zsock_close(sock);
-        zsock_freeaddrinfo(broker_addrinfo);
         return -1;
     }
 
-    zsock_freeaddrinfo(broker_addrinfo);
-
     return sock;
 }
 
@@ -39,6 +39,22 @@
  */
 int ZEXPORT astarte_zlib_compress(
     Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourceLen);
+
+/**
+ * @brief Function equivalent to the `uncompress` function defined in zlib.h.
+ *
+ * @details The implementation is copied from `uncompress2` in zlib, without reporting back the
+ * consumed source length. As for #astarte_zlib_compress, zlib allocates its memory from the SDK
+ * allocator when CONFIG_ASTARTE_DEVICE_SDK_STATIC_ALLOCATION is enabled.
+ *
+ * @param dest See docstrings for `uncompress` in zlib.h
+ * @param destLen See docstrings for `uncompress` in zlib.h
+ * @param source See docstrings for `uncompress` in zlib.h
+ * @param sourceLen See docstrings for `uncompress` in zlib.h
+ * @return See docstrings for `uncompress` in zlib.h
+ */
+int ZEXPORT astarte_zlib_uncompress(
+    Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourceLen);
 // NOLINTEND
 
 #endif /* ASTARTE_ZLIB_H */
@@ -60,6 +60,18 @@ void astarte_bson_serializer_destroy(astarte_bson_serializer_t *bson);
  */
 const void *astarte_bson_serializer_get_serialized(astarte_bson_serializer_t bson, int *size);
 
+/**
+ * @brief Detach the BSON serializer internal buffer, transferring its ownership to the caller.
+ *
+ * @details This function might be used to take ownership of the serialized document without any
+ * data copy. The serializer is left empty, destroying it afterwards is still safe.
+ * The returned buffer should be freed using astarte_free().
+ * @param[in,out] bson a valid handle for the serializer instance.
+ * @param[out] size the size of the serialized document. Optional, pass NULL if not used.
+ * @return Reference to the detached buffer.
+ */
+void *astarte_bson_serializer_detach(astarte_bson_serializer_t *bson, size_t *size);
+
 /**
  * @brief Copy and return the BSON serializer internal buffer.
  *
@@ -58,6 +58,25 @@ astarte_result_t astarte_crypto_create_csr(
 astarte_result_t astarte_crypto_get_certificate_info(
     const char *cert_pem, char *cert_cn, size_t cert_cn_size);
 
+/**
+ * @brief Get the validity period for a PEM certificate.
+ *
+ * @param[in] cert_pem Certificate in the PEM format.
+ * @param[out] not_before Start of the validity period, in seconds since the Unix epoch.
+ * @param[out] not_after End of the validity period, in seconds since the Unix epoch.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_crypto_get_certificate_validity(
+    const char *cert_pem, int64_t *not_before, int64_t *not_after);
+
+/**
+ * @brief Get the current wall clock time as seen by the TLS stack.
+ *
+ * @param[out] now Current time, in seconds since the Unix epoch.
+ * @return ASTARTE_RESULT_OK if successful, ASTARTE_RESULT_NOT_FOUND if no wall clock is available.
+ */
+astarte_result_t astarte_crypto_get_current_time(int64_t *now);
+
 #ifdef __cplusplus
 }
 #endif
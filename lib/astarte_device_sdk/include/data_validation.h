@@ -49,6 +49,21 @@ astarte_result_t data_validation_aggregated_datastream(const astarte_interface_t
     const char *path, astarte_object_entry_t *entries, size_t entries_len,
     const int64_t *timestamp);
 
+/**
+ * @brief Validate the values of an aggregated datastream stored in the order of the mappings.
+ *
+ * @details No mapping is looked up, each value is checked against the mapping with the same index
+ * and the path is checked only once against the object path of the interface.
+ *
+ * @param[in] interface Interface to use for the operation.
+ * @param[in] path Path to validate.
+ * @param[in] values The object values to validate, one for each mapping of the interface.
+ * @param[in] timestamp Timestamp to validate, it might be NULL.
+ * @return ASTARTE_RESULT_OK when validation is successful, an error otherwise.
+ */
+astarte_result_t data_validation_object_values(const astarte_interface_t *interface,
+    const char *path, const astarte_data_t *values, const int64_t *timestamp);
+
 /**
  * @brief Validate data for setting a device property against the device introspection.
  *
@@ -18,6 +18,7 @@
 
 #include "introspection.h"
 #include "kv_storage.h"
+#include "tls_credentials.h"
 
 /** @brief Iterator struct for stored properties. */
 typedef struct
@@ -28,6 +29,18 @@ typedef struct
     astarte_kv_storage_iter_t kv_iter;
 } astarte_device_caching_property_iter_t;
 
+/**
+ * @brief Batch of stored properties changes, written in a single storage session.
+ *
+ * @note The changes are not applied atomically, a power failure during the batch can leave only
+ * some of them written.
+ */
+typedef struct
+{
+    /** @brief Key value storage instance used by the batch. */
+    astarte_kv_storage_t kv_storage;
+} astarte_device_caching_property_batch_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -51,22 +64,80 @@ astarte_result_t astarte_device_caching_synchronization_get(bool *sync);
 astarte_result_t astarte_device_caching_synchronization_set(bool sync);
 
 /**
- * @brief Cache in the introspection for this device.
+ * @brief Cache in the introspection digest for this device.
+ *
+ * @param[in] digest Digest of the device introspection, as returned by #introspection_get_digest.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_introspection_store(
+    const uint8_t digest[static INTROSPECTION_DIGEST_SIZE]);
+
+/**
+ * @brief Check if the cached introspection digest exists and it's identical to the input one.
+ *
+ * @param[in] digest Digest of the device introspection, as returned by #introspection_get_digest.
+ * @return ASTARTE_RESULT_OK if the cached digest matches,
+ * ASTARTE_RESULT_DEVICE_CACHING_OUTDATED_INTROSPECTION if it's missing or different, otherwise an
+ * error code.
+ */
+astarte_result_t astarte_device_caching_introspection_check(
+    const uint8_t digest[static INTROSPECTION_DIGEST_SIZE]);
+
+/**
+ * @brief Store the MQTT broker hostname and port for this device.
+ *
+ * @param[in] device_id Device ID owning the broker information.
+ * @param[in] hostname Null terminated broker hostname.
+ * @param[in] port Null terminated broker port.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_broker_store(
+    const char *device_id, const char *hostname, const char *port);
+
+/**
+ * @brief Load the stored MQTT broker hostname and port for this device.
+ *
+ * @param[in] device_id Device ID owning the broker information.
+ * @param[out] hostname Buffer where to store the broker hostname.
+ * @param[in] hostname_size Size of the @p hostname buffer.
+ * @param[out] port Buffer where to store the broker port.
+ * @param[in] port_size Size of the @p port buffer.
+ * @return ASTARTE_RESULT_OK if successful, ASTARTE_RESULT_NOT_FOUND if no information is stored
+ * for the device, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_broker_load(
+    const char *device_id, char *hostname, size_t hostname_size, char *port, size_t port_size);
+
+/**
+ * @brief Store the client certificate and private key for this device.
+ *
+ * @warning The private key is stored as is, the flash partition should be protected by the
+ * platform if encryption at rest is required.
  *
- * @param[in] intr Buffer containing the stringified version of the device introspection
- * @param[in] intr_size Size in chars of the @p buffer parameter.
+ * @param[in] device_id Device ID owning the client certificate.
+ * @param[in] client_crt Client certificate and private key to store.
  * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
  */
-astarte_result_t astarte_device_caching_introspection_store(const char *intr, size_t intr_size);
+astarte_result_t astarte_device_caching_client_crt_store(
+    const char *device_id, const astarte_tls_credentials_client_crt_t *client_crt);
 
 /**
- * @brief Check if the cached introspection exists and it's identical to the input one.
+ * @brief Load the stored client certificate and private key for this device.
+ *
+ * @param[in] device_id Device ID owning the client certificate.
+ * @param[out] client_crt Loaded client certificate and private key.
+ * @return ASTARTE_RESULT_OK if successful, ASTARTE_RESULT_NOT_FOUND if no certificate is stored
+ * for the device, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_client_crt_load(
+    const char *device_id, astarte_tls_credentials_client_crt_t *client_crt);
+
+/**
+ * @brief Delete the stored client certificate and private key.
  *
- * @param[in] intr Buffer containing the stringified version of the device introspection
- * @param[in] intr_size Size in chars of the @p buffer parameter.
  * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
  */
-astarte_result_t astarte_device_caching_introspection_check(const char *intr, size_t intr_size);
+astarte_result_t astarte_device_caching_client_crt_delete(void);
 
 /**
  * @brief Stores a property in permanent storage.
@@ -106,6 +177,27 @@ astarte_result_t astarte_device_caching_property_load(
  */
 void astarte_device_caching_property_destroy_loaded(astarte_data_t data);
 
+/**
+ * @brief Check if the value of a stored property has been acknowledged by Astarte.
+ *
+ * @param[in] interface_name Interface name
+ * @param[in] path Property path
+ * @param[out] acked Set to true if the stored value has been acknowledged by Astarte.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_property_is_acked(
+    const char *interface_name, const char *path, bool *acked);
+
+/**
+ * @brief Mark the value of a stored property as acknowledged by Astarte.
+ *
+ * @param[in] interface_name Interface name
+ * @param[in] path Property path
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_property_set_acked(
+    const char *interface_name, const char *path);
+
 /**
  * @brief Delete a cached property.
  *
@@ -116,6 +208,64 @@ void astarte_device_caching_property_destroy_loaded(astarte_data_t data);
 astarte_result_t astarte_device_caching_property_delete(
     const char *interface_name, const char *path);
 
+/**
+ * @brief Encode a property in the format used by the permanent storage.
+ *
+ * @details The encoded property is marked as not acknowledged by Astarte.
+ *
+ * @param[in] major Major version name
+ * @param[in] data Astarte data value to encode
+ * @param[out] value Set to the encoded property, to be freed with #astarte_free.
+ * @param[out] value_len Set to the length of @p value.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_property_encode(
+    uint32_t major, astarte_data_t data, uint8_t **value, size_t *value_len);
+
+/**
+ * @brief Start a batch of changes to the stored properties.
+ *
+ * @details The storage is opened once for the whole batch, which should be ended with
+ * #astarte_device_caching_property_batch_end.
+ *
+ * @param[out] batch Batch instance to initialize.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_property_batch_begin(
+    astarte_device_caching_property_batch_t *batch);
+
+/**
+ * @brief Store a property as part of a batch.
+ *
+ * @param[inout] batch Batch started with #astarte_device_caching_property_batch_begin.
+ * @param[in] interface_name Interface name
+ * @param[in] path Property path
+ * @param[in] value Property encoded with #astarte_device_caching_property_encode.
+ * @param[in] value_len Length of @p value.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_property_batch_store(
+    astarte_device_caching_property_batch_t *batch, const char *interface_name, const char *path,
+    const uint8_t *value, size_t value_len);
+
+/**
+ * @brief Delete a stored property as part of a batch.
+ *
+ * @param[inout] batch Batch started with #astarte_device_caching_property_batch_begin.
+ * @param[in] interface_name Interface name
+ * @param[in] path Property path
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_property_batch_delete(
+    astarte_device_caching_property_batch_t *batch, const char *interface_name, const char *path);
+
+/**
+ * @brief End a batch of changes to the stored properties, closing the storage.
+ *
+ * @param[in] batch Batch started with #astarte_device_caching_property_batch_begin.
+ */
+void astarte_device_caching_property_batch_end(astarte_device_caching_property_batch_t batch);
+
 /**
  * @brief Initialize a new iterator to be used to iterate over the stored properties.
  *
@@ -146,6 +296,21 @@ void astarte_device_caching_property_iterator_destroy(astarte_device_caching_pro
 astarte_result_t astarte_device_caching_property_iterator_next(
     astarte_device_caching_property_iter_t *iter);
 
+/**
+ * @brief Realign the iterator over the stored properties after the deletion of a property.
+ *
+ * @details The iterator is moved back to the property it pointed to before the deletion, or
+ * advanced of one position if such property has been deleted.
+ *
+ * @param[inout] iter Iterator initialized with #astarte_device_caching_property_iterator_new.
+ * @param[in] interface_name Interface name of the property pointed before the deletion.
+ * @param[in] path Path of the property pointed before the deletion.
+ * @return ASTARTE_RESULT_OK if successful, ASTARTE_RESULT_NOT_FOUND if no property is left to
+ * iterate over, otherwise an error code.
+ */
+astarte_result_t astarte_device_caching_property_iterator_realign(
+    astarte_device_caching_property_iter_t *iter, const char *interface_name, const char *path);
+
 /**
  * @brief Get the interface name and path for the property pointed by the iterator.
  *
@@ -0,0 +1,78 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DEVICE_CLIENT_CRT_H
+#define DEVICE_CLIENT_CRT_H
+
+/**
+ * @file device_client_crt.h
+ * @brief Device client certificate management header.
+ */
+
+#include "astarte_device_sdk/astarte.h"
+#include "astarte_device_sdk/device.h"
+#include "astarte_device_sdk/result.h"
+
+#include "device_private.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the client certificate management for a device.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_client_crt_init(astarte_device_handle_t device);
+
+/**
+ * @brief Deinitialize the client certificate management for a device.
+ *
+ * @details Waits for any ongoing key generation and wipes the pre-generated key material.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_client_crt_deinit(astarte_device_handle_t device);
+
+/**
+ * @brief Handler for a client certificate refresh request.
+ *
+ * @details This function can be used as a client certificate refresh handler for the Astarte MQTT
+ * client. The validity of an existing certificate is checked locally, using the validity window
+ * parsed when the certificate has been installed. The pairing APIs are used to verify the
+ * certificate only when the broker has rejected the previous TLS handshake.
+ *
+ * @param[in] astarte_mqtt Astarte MQTT client context.
+ * @param[in] tls_rejected True when the previous connection attempt failed the TLS handshake.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_client_crt_refresh_handler(
+    astarte_mqtt_t *astarte_mqtt, bool tls_rejected);
+
+/**
+ * @brief Renew the client certificate if its renewal timepoint has elapsed.
+ *
+ * @details The renewed certificate replaces the current one in the TLS credentials, the active
+ * connection is not affected and the new certificate will be used from the next connection.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_client_crt_renew(astarte_device_handle_t device);
+
+/**
+ * @brief Get the timeout until the next proactive renewal of the client certificate.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return Timeout until the renewal, K_FOREVER if no renewal is scheduled.
+ */
+k_timeout_t astarte_device_client_crt_get_renewal_deadline(astarte_device_handle_t device);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEVICE_CLIENT_CRT_H
@@ -73,10 +73,23 @@ void astarte_device_connection_on_disconnected_handler(astarte_mqtt_t *astarte_m
  *
  * @param[in] astarte_mqtt Astarte MQTT client context.
  * @param[in] message_id Message ID for the SUBACK message.
- * @param[in] return_code Return code of the SUBACK message.
+ * @param[in] topic_index Index of the topic filter within the SUBSCRIBE message.
+ * @param[in] return_code Return code for the topic filter.
  */
-void astarte_device_connection_on_subscribed_handler(
-    astarte_mqtt_t *astarte_mqtt, uint16_t message_id, enum mqtt_suback_return_code return_code);
+void astarte_device_connection_on_subscribed_handler(astarte_mqtt_t *astarte_mqtt,
+    uint16_t message_id, size_t topic_index, enum mqtt_suback_return_code return_code);
+
+/**
+ * @brief Build the topic filters for the device subscriptions.
+ *
+ * @details The topic filters are only rebuilt when the device introspection has changed since
+ * the last call.
+ *
+ * @param[in] device Device instance to use for the operation.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_connection_update_subscription_topics(
+    astarte_device_handle_t device);
 
 /**
  * @brief Poll the device connection status, it will also poll the Astarte MQTT client.
@@ -86,6 +99,117 @@ void astarte_device_connection_on_subscribed_handler(
  */
 astarte_result_t astarte_device_connection_poll(astarte_device_handle_t device);
 
+/**
+ * @brief Get the time left before the device connection has to be polled.
+ *
+ * @param[in] device Device instance to use for the operation.
+ * @return The time left before the next deadline, K_FOREVER if no deadline is present.
+ */
+k_timeout_t astarte_device_connection_get_next_deadline(astarte_device_handle_t device);
+
+/**
+ * @brief Initialize the handshake context of a device.
+ *
+ * @param[in] device Device instance to use for the operation.
+ */
+void astarte_device_connection_init_handshake(astarte_device_handle_t device);
+
+/**
+ * @brief Release the handshake context of a device, stopping any ongoing properties resync.
+ *
+ * @details The topic filters for the device subscriptions are also released.
+ *
+ * @param[in] device Device instance to use for the operation.
+ */
+void astarte_device_connection_deinit_handshake(astarte_device_handle_t device);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+/**
+ * @brief Lock the cached device properties against the background properties resync.
+ *
+ * @details Should be held while updating a cached property and transmitting the new value, so
+ * that an older value can't be resent after the new one.
+ *
+ * @param[in] device Device instance to use for the operation.
+ */
+void astarte_device_connection_lock_properties(astarte_device_handle_t device);
+
+/**
+ * @brief Unlock the cached device properties locked with #astarte_device_connection_lock_properties
+ *
+ * @param[in] device Device instance to use for the operation.
+ */
+void astarte_device_connection_unlock_properties(astarte_device_handle_t device);
+
+/**
+ * @brief Track the acknowledgment of a transmitted device owned property.
+ *
+ * @details Once acknowledged the cached property is marked as such, and it will not be resent to
+ * Astarte on the next reconnection. Any previous transmission of the same property is no longer
+ * tracked.
+ *
+ * @note Should be called with the properties locked.
+ *
+ * @param[in] device Device instance to use for the operation.
+ * @param[in] interface_name Interface name of the property.
+ * @param[in] path Path of the property.
+ * @param[in] message_id MQTT message ID of the transmission, zero to only stop tracking the
+ * previous transmissions.
+ */
+void astarte_device_connection_track_property(astarte_device_handle_t device,
+    const char *interface_name, const char *path, uint16_t message_id);
+
+/**
+ * @brief Handler for a delivered QoS 1 or 2 message.
+ *
+ * @details This function can be used as a delivered message handler for the Astarte MQTT client.
+ *
+ * @param[in] astarte_mqtt Astarte MQTT client context.
+ * @param[in] message_id Message ID of the delivered message.
+ */
+void astarte_device_connection_on_delivered_handler(
+    astarte_mqtt_t *astarte_mqtt, uint16_t message_id);
+
+/**
+ * @brief Notify the background properties resync of the deletion of a cached property.
+ *
+ * @details The resync is not restarted, its iterator is realigned with the cached properties
+ * shifted by the deletion.
+ *
+ * @note Should be called with the properties locked, once for each deleted property.
+ *
+ * @param[in] device Device instance to use for the operation.
+ */
+void astarte_device_connection_on_property_deleted(astarte_device_handle_t device);
+#endif
+
+/**
+ * @brief Initialize the poll signal and deadline timer for a device.
+ *
+ * @note This function is a no-op when CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL is disabled.
+ *
+ * @param[in] device Device instance to use for the operation.
+ */
+void astarte_device_connection_init_poll_signal(astarte_device_handle_t device);
+
+/**
+ * @brief Release the poll signal and deadline timer of a device.
+ *
+ * @note This function is a no-op when CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL is disabled.
+ *
+ * @param[in] device Device instance to use for the operation.
+ */
+void astarte_device_connection_deinit_poll_signal(astarte_device_handle_t device);
+
+/**
+ * @brief Signal that the device requires to be polled.
+ *
+ * @note This function is a no-op when CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL is disabled.
+ *
+ * @param[in] device Device instance to use for the operation.
+ */
+void astarte_device_connection_raise_poll_signal(astarte_device_handle_t device);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,9 +16,19 @@
 #include "astarte_device_sdk/device.h"
 #include "astarte_device_sdk/result.h"
 
+#include <zephyr/kernel.h>
+#include <zephyr/sys/mutex.h>
+#include <zephyr/sys/slist.h>
+
 #include "backoff.h"
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+#include "device_caching.h"
+#endif
 #include "introspection.h"
 #include "mqtt.h"
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+#include "stream_filter.h"
+#endif
 #include "tls_credentials.h"
 
 /** @brief Generic prefix to be used for all MQTT topics. */
@@ -76,6 +86,22 @@ enum connection_states
     DEVICE_CONNECTED,
 };
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+/** @brief Size in bytes of the digest of a device property value (SHA-256). */
+#define PROPERTY_DIGEST_SIZE 32
+
+/** @brief Digest of the last value set for a device owned property. */
+typedef struct
+{
+    /** @brief Set when the entry is tracking a property. */
+    bool used;
+    /** @brief Hash of the interface name and path, used to find the entry. */
+    uint32_t key_hash;
+    /** @brief Digest of the interface name, path, major version and value. */
+    uint8_t digest[PROPERTY_DIGEST_SIZE];
+} astarte_device_property_digest_t;
+#endif
+
 /**
  * @brief Internal struct for an instance of an Astarte device.
  *
@@ -87,6 +113,22 @@ struct astarte_device
     int32_t http_timeout_ms;
     /** @brief Private client key and certificate for mutual TLS authentication (PEM format). */
     astarte_tls_credentials_client_crt_t client_crt;
+    /** @brief Expiry of the client certificate, computed once when the certificate is installed. */
+    k_timepoint_t client_crt_expiry_timepoint;
+    /** @brief Proactive renewal timepoint for the client certificate. */
+    k_timepoint_t client_crt_renewal_timepoint;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_PREGENERATION)
+    /** @brief Work item generating the key and CSR for the next client certificate. */
+    struct k_work_delayable client_crt_pregen_work;
+    /** @brief Mutex protecting the pre-generated key and CSR. */
+    struct sys_mutex client_crt_pregen_mutex;
+    /** @brief Set when the pre-generated key and CSR are ready to be used. */
+    bool client_crt_pregen_ready;
+    /** @brief Pre-generated private key for the next client certificate (PEM format). */
+    char client_crt_pregen_privkey_pem[ASTARTE_CRYPTO_PRIVKEY_BUFFER_SIZE];
+    /** @brief Pre-generated CSR for the next client certificate (PEM format). */
+    unsigned char client_crt_pregen_csr_pem[ASTARTE_CRYPTO_CSR_BUFFER_SIZE];
+#endif
     /** @brief Unique 128 bits, base64 URL encoded, identifier to associate to a device instance. */
     char device_id[ASTARTE_DEVICE_ID_LEN + 1];
     /** @brief Device's credential secret. */
@@ -109,6 +151,8 @@ struct astarte_device
     astarte_device_property_set_cbk_t property_set_cbk;
     /** @brief (optional) User callback for incoming property unset events. */
     astarte_device_property_unset_cbk_t property_unset_cbk;
+    /** @brief (optional) User callback for chunks of data messages exceeding the max size. */
+    astarte_device_data_chunk_cbk_t data_chunk_cbk;
     /** @brief (optional) User data to pass to all the set callbacks. */
     void *cbk_user_data;
     /** @brief Connection state of the Astarte device. */
@@ -117,10 +161,85 @@ struct astarte_device
     bool synchronization_completed;
     /** @brief Flag signaling a subscription request has failed. */
     bool subscription_failure;
+    /** @brief Set while the device holds a pairing session, until its first MQTT connection. */
+    bool pairing_session_active;
+    /** @brief Topic filters for the device subscriptions, the control one first. */
+    const char **subscription_topics;
+    /** @brief Number of entries in #subscription_topics. */
+    size_t subscription_topics_count;
+    /** @brief Digest of the introspection used to build #subscription_topics. */
+    uint8_t subscription_topics_digest[INTROSPECTION_DIGEST_SIZE];
+    /** @brief SUBACK return code received for each entry of #subscription_topics. */
+    uint8_t *subscription_return_codes;
+    /** @brief Message ID of the SUBSCRIBE packet carrying each entry of #subscription_topics. */
+    uint16_t *subscription_msg_ids;
+    /** @brief Message IDs of the handshake messages to be acknowledged before connecting. */
+    uint16_t *handshake_msg_ids;
+    /** @brief Number of valid entries in #handshake_msg_ids. */
+    size_t handshake_msg_ids_len;
+    /** @brief Number of allocated entries in #handshake_msg_ids. */
+    size_t handshake_msg_ids_size;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    /** @brief Set while the cached device properties are being resent to Astarte. */
+    bool prop_resync_active;
+    /** @brief Set when all the cached device properties have been resent. */
+    bool prop_resync_sent;
+    /** @brief Set when the resync iterator should be created from scratch on the next run. */
+    bool prop_resync_restart;
+    /** @brief Iterator over the cached properties used by the resync. */
+    astarte_device_caching_property_iter_t prop_resync_iter;
+    /** @brief Interface name of the cached property pointed by #prop_resync_iter. */
+    char *prop_resync_interface_name;
+    /** @brief Path of the cached property pointed by #prop_resync_iter. */
+    char *prop_resync_path;
+    /** @brief Message IDs of the resent properties waiting for an acknowledgment. */
+    uint16_t prop_resync_in_flight[CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_RESYNC_WINDOW];
+    /** @brief Number of valid entries in #prop_resync_in_flight. */
+    size_t prop_resync_in_flight_len;
+    /** @brief Set when the resync only sends the properties not acknowledged by Astarte. */
+    bool prop_resync_delta;
+    /** @brief Transmitted device owned properties waiting for an acknowledgment. */
+    sys_slist_t prop_acks;
+    /** @brief Mutex serializing the properties resync and the user properties updates. */
+    struct sys_mutex prop_mutex;
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+    /** @brief Received server properties changes not yet written to the permanent storage. */
+    sys_slist_t prop_pending;
+    /** @brief Number of entries in #prop_pending. */
+    size_t prop_pending_count;
+    /** @brief Timepoint at which #prop_pending should be written, postponed by each change. */
+    k_timepoint_t prop_pending_timepoint;
+    /** @brief Latest value for #prop_pending_timepoint, set by the first buffered change. */
+    k_timepoint_t prop_pending_max_timepoint;
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+    /** @brief Digests of the last values set for the device owned properties. */
+    astarte_device_property_digest_t
+        prop_digests[CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE_ENTRIES];
+    /** @brief Next entry of #prop_digests replaced when all are used. */
+    size_t prop_digests_next;
+    /** @brief Mutex protecting #prop_digests, taken after the properties mutex when both are. */
+    struct sys_mutex prop_digests_mutex;
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+    /** @brief Deadband and rate filters of the individual datastreams. */
+    astarte_stream_filter_t stream_filter;
+#endif
     /** @brief Backoff context to be used in case of an handshake error with Astarte. */
     struct backoff_context backoff_ctx;
     /** @brief Reconnection timepoint to be used in case of an handshake error with Astarte. */
     k_timepoint_t reconnection_timepoint;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_POLL_SIGNAL)
+    /** @brief Signal raised when the device requires to be polled. */
+    struct k_poll_signal poll_signal;
+    /** @brief Timer raising the poll signal when the next device deadline expires. */
+    struct k_timer deadline_timer;
+#endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS)
+    /** @brief Uptime in ticks at the start of the current handshake. */
+    int64_t handshake_start_ticks;
+#endif
     /** @brief Base MQTT topic for the device. */
     char base_topic[MQTT_BASE_TOPIC_LEN + 1];
     /** @brief Base MQTT control topic for the device. */
@@ -36,6 +36,57 @@ extern "C" {
 void astarte_device_rx_on_incoming_handler(astarte_mqtt_t *astarte_mqtt, const char *topic,
     size_t topic_len, const char *data, size_t data_len);
 
+/**
+ * @brief Handler for a reception event of a message exceeding the maximum message size.
+ *
+ * @details This function can be used as a chunked reception event handler for the Astarte MQTT
+ * client. Chunks of data messages are forwarded to the user data chunk callback.
+ *
+ * @param[in] astarte_mqtt Astarte MQTT client context.
+ * @param[in] topic Topic for the event as a NULL terminated string.
+ * @param[in] topic_len Length in chars of the topic string (without the terminating NULL char).
+ * @param[in] offset Offset of the chunk in the complete message payload.
+ * @param[in] chunk Data buffer for the chunk.
+ * @param[in] chunk_len Number of bytes in the chunk buffer.
+ * @param[in] total_len Number of bytes of the complete message payload.
+ */
+void astarte_device_rx_on_incoming_chunk_handler(astarte_mqtt_t *astarte_mqtt, const char *topic,
+    size_t topic_len, size_t offset, const char *chunk, size_t chunk_len, size_t total_len);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING)
+/**
+ * @brief Initialize the buffer of the received server properties changes.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_rx_init_properties_coalescing(astarte_device_handle_t device);
+
+/**
+ * @brief Write the buffered server properties changes to the permanent storage.
+ *
+ * @details All the changes are written in a single storage session and then released, also when
+ * some of them fail to be written.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_rx_commit_properties(astarte_device_handle_t device);
+
+/**
+ * @brief Write the buffered server properties changes if their commit timepoint has expired.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_rx_commit_properties_if_due(astarte_device_handle_t device);
+
+/**
+ * @brief Get the time left before the buffered server properties changes should be written.
+ *
+ * @param[in] device Handle to the device instance.
+ * @return The time left, K_FOREVER if no commit is scheduled.
+ */
+k_timeout_t astarte_device_rx_get_properties_deadline(astarte_device_handle_t device);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,10 +30,12 @@ extern "C" {
  * @param[in] path Path where to publish data.
  * @param[in] data Astarte data value to stream.
  * @param[in] timestamp Timestamp of the message, ignored if set to NULL.
+ * @param[out] out_message_id Stores the MQTT message ID used for QoS 1 and 2, can be NULL.
  * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
  */
 astarte_result_t astarte_device_tx_stream_individual(astarte_device_handle_t device,
-    const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp);
+    const char *interface_name, const char *path, astarte_data_t data, const int64_t *timestamp,
+    uint16_t *out_message_id);
 
 /**
  * @brief Send an aggregated object through the device connection.
@@ -50,6 +52,20 @@ astarte_result_t astarte_device_tx_stream_aggregated(astarte_device_handle_t dev
     const char *interface_name, const char *path, astarte_object_entry_t *entries,
     size_t entries_len, const int64_t *timestamp);
 
+/**
+ * @brief Send an aggregated object stored in the order of the interface mappings.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] interface Interface where to publish data, must be part of the device introspection.
+ * @param[in] path Path where to publish data.
+ * @param[in] values The object values, one for each mapping of the @p interface.
+ * @param[in] timestamp Timestamp of the message, ignored if set to NULL.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_device_tx_stream_object_values(astarte_device_handle_t device,
+    const astarte_interface_t *interface, const char *path, const astarte_data_t *values,
+    const int64_t *timestamp);
+
 /**
  * @brief Set a device property to the provided data value.
  *
@@ -73,6 +89,35 @@ astarte_result_t astarte_device_tx_set_property(astarte_device_handle_t device,
 astarte_result_t astarte_device_tx_unset_property(
     astarte_device_handle_t device, const char *interface_name, const char *path);
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE)
+/**
+ * @brief Initialize the digests of the values last set for the device properties.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_tx_init_property_digests(astarte_device_handle_t device);
+
+/**
+ * @brief Forget the values last set for the device properties.
+ *
+ * @details The following updates of each property are sent to Astarte, even when unchanged.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_tx_clear_property_digests(astarte_device_handle_t device);
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS)
+/**
+ * @brief Send the datastream values held by the rate filters that can now be sent.
+ *
+ * @details Failures are logged and the corresponding values dropped.
+ *
+ * @param[in] device Handle to the device instance.
+ */
+void astarte_device_tx_flush_filtered(astarte_device_handle_t device);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
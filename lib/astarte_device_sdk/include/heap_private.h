@@ -0,0 +1,99 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HEAP_PRIVATE_H
+#define HEAP_PRIVATE_H
+
+/**
+ * @file heap_private.h
+ * @brief Private allocation functions for the Astarte device SDK.
+ *
+ * @details Each source file performing allocations should register its module with
+ * #ASTARTE_HEAP_MODULE_REGISTER and then use #astarte_calloc, #astarte_malloc and #astarte_free
+ * in place of the libc functions.
+ */
+
+#include "astarte_device_sdk/heap.h"
+
+#include "astarte_device_sdk/astarte.h"
+
+/**
+ * @brief Register the module to which the allocations of a source file are attributed.
+ *
+ * @param[in] module An #astarte_heap_module_t value.
+ */
+#define ASTARTE_HEAP_MODULE_REGISTER(module)                                                       \
+    static const astarte_heap_module_t astarte_heap_module __attribute__((unused)) = (module)
+
+/**
+ * @brief Allocate zero initialized memory for the registered module, same semantics as calloc.
+ *
+ * @param[in] num Number of elements.
+ * @param[in] size Size of each element.
+ */
+#define astarte_calloc(num, size) astarte_heap_calloc(astarte_heap_module, (num), (size))
+
+/**
+ * @brief Allocate memory for the registered module, same semantics as malloc.
+ *
+ * @param[in] size Size of the memory block.
+ */
+#define astarte_malloc(size) astarte_heap_malloc(astarte_heap_module, (size))
+
+/**
+ * @brief Free memory allocated by the SDK, same semantics as free.
+ *
+ * @param[in] ptr Memory block to free.
+ */
+#define astarte_free(ptr) astarte_heap_free(ptr)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Allocate zero initialized memory attributed to an SDK module.
+ *
+ * @param[in] module Module to which the memory is attributed.
+ * @param[in] num Number of elements.
+ * @param[in] size Size of each element.
+ * @return The allocated memory, NULL if out of memory.
+ */
+void *astarte_heap_calloc(astarte_heap_module_t module, size_t num, size_t size);
+
+/**
+ * @brief Allocate memory attributed to an SDK module.
+ *
+ * @param[in] module Module to which the memory is attributed.
+ * @param[in] size Size of the memory block.
+ * @return The allocated memory, NULL if out of memory.
+ */
+void *astarte_heap_malloc(astarte_heap_module_t module, size_t size);
+
+/**
+ * @brief Resize memory attributed to an SDK module, same semantics as realloc.
+ *
+ * @details A NULL @p ptr allocates a new block, while a zero @p size frees the block.
+ *
+ * @param[in] module Module to which the memory is attributed.
+ * @param[in] ptr Memory block to resize.
+ * @param[in] size New size of the memory block.
+ * @return The resized memory, NULL if out of memory or if the block has been freed.
+ */
+void *astarte_heap_realloc(astarte_heap_module_t module, void *ptr, size_t size);
+
+/**
+ * @brief Free memory allocated through one of the SDK allocation functions.
+ *
+ * @param[in] ptr Memory block to free, can be NULL.
+ */
+void astarte_heap_free(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEAP_PRIVATE_H */
@@ -0,0 +1,42 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+/**
+ * @file host_clock.h
+ * @brief Host monotonic clock for the timing measurements of the tracing, benchmarks and tests.
+ *
+ * @details Defined in host/host_clock.c, which is built with the host C library: by the native
+ * simulator for native_sim builds and directly for the host unit tests.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Get the time elapsed on the host monotonic clock.
+ *
+ * @return The host monotonic time in nanoseconds.
+ */
+uint64_t astarte_host_clock_get_ns(void);
+
+/**
+ * @brief Get the time elapsed on the host monotonic clock.
+ *
+ * @return The host monotonic time in microseconds.
+ */
+uint64_t astarte_host_clock_get_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_CLOCK_H */
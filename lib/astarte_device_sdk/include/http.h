@@ -15,10 +15,82 @@
 #include "astarte_device_sdk/astarte.h"
 #include "astarte_device_sdk/result.h"
 
+#include <zephyr/net/socket.h>
+
+/**
+ * @brief HTTP client session to the Astarte host.
+ *
+ * @details A session caches the resolved address of the Astarte host and keeps the connection
+ * open between requests, allowing a sequence of requests to share a single TCP/TLS connection.
+ */
+typedef struct
+{
+    /** @brief Connected socket, -1 when the session is not connected. */
+    int sock;
+    /** @brief Resolved address of the Astarte host. */
+    struct sockaddr addr;
+    /** @brief Length of the resolved address, zero when the address has not been resolved yet. */
+    socklen_t addrlen;
+} astarte_http_session_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Initialize an HTTP client session.
+ *
+ * @param[out] session Session to initialize.
+ */
+void astarte_http_session_init(astarte_http_session_t *session);
+
+/**
+ * @brief Close the connection of an HTTP client session.
+ *
+ * @details The resolved address is retained and will be reused by the following requests.
+ *
+ * @param[inout] session Session to close.
+ */
+void astarte_http_session_close(astarte_http_session_t *session);
+
+/**
+ * @brief Perform an HTTP POST request to Astarte using an HTTP client session.
+ *
+ * @details The connection is kept open after the request. A connection that has been closed by
+ * the server is transparently reopened.
+ *
+ * @param[inout] session Session to use for the request.
+ * @param[in] timeout_ms Timeout to use for the HTTP operations in ms.
+ * @param[in] url Partial URL to use for the POST request. Hostname and port are taken from the
+ * configuration.
+ * @param[in] header_fields NULL terminated list of headers for the request.
+ * @param[in] payload Payload to transmit.
+ * @param[out] resp_buf Output buffer where to store the response from the server.
+ * @param[in] resp_buf_size Size of the response output buffer.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_http_session_post(astarte_http_session_t *session, int32_t timeout_ms,
+    const char *url, const char **header_fields, const char *payload, uint8_t *resp_buf,
+    size_t resp_buf_size);
+
+/**
+ * @brief Perform an HTTP GET request to Astarte using an HTTP client session.
+ *
+ * @details The connection is kept open after the request. A connection that has been closed by
+ * the server is transparently reopened.
+ *
+ * @param[inout] session Session to use for the request.
+ * @param[in] timeout_ms Timeout to use for the HTTP operations in ms.
+ * @param[in] url Partial URL to use for the GET request. Hostname and port are taken from the
+ * configuration.
+ * @param[in] header_fields NULL terminated list of headers for the request.
+ * @param[out] resp_buf Output buffer where to store the response from the server.
+ * @param[in] resp_buf_size Size of the response output buffer.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_http_session_get(astarte_http_session_t *session, int32_t timeout_ms,
+    const char *url, const char **header_fields, uint8_t *resp_buf, size_t resp_buf_size);
+
 /**
  * @brief Perform an HTTP POST request to Astarte.
  *
@@ -13,27 +13,48 @@
  * https://docs.astarte-platform.org/astarte/latest/080-mqtt-v1-protocol.html#introspection
  */
 
-#include <zephyr/sys/dlist.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/mutex.h>
 
 #include "astarte_device_sdk/interface.h"
 #include "astarte_device_sdk/result.h"
 
-/** @brief Introspection struct. */
+/** @brief Size in bytes of the introspection digest (SHA-256). */
+#define INTROSPECTION_DIGEST_SIZE 32
+
+/**
+ * @brief Immutable table of the interfaces contained in the introspection.
+ *
+ * @details The interfaces are sorted by name. A table is never modified once published, each
+ * update of the introspection publishes a new table and releases the old one.
+ */
 typedef struct
 {
     /** @cond INTERNAL_HIDDEN */
-    sys_dlist_t *list;
+    atomic_t refcount;
     /** @endcond */
-} introspection_t;
+    /** @brief Digest of the names and versions of the interfaces, computed on table creation. */
+    uint8_t digest[INTROSPECTION_DIGEST_SIZE];
+    /** @brief Number of interfaces in the table. */
+    size_t count;
+    /** @brief Interfaces in the table, sorted by name. */
+    const astarte_interface_t *interfaces[];
+} introspection_table_t;
 
-/** @brief Introspection node, used internally. */
+/**
+ * @brief Introspection struct.
+ *
+ * @details Readers never lock, they only take a reference to the current table. Writers are
+ * serialized between them and atomically replace the current table.
+ */
 typedef struct
 {
     /** @cond INTERNAL_HIDDEN */
-    const astarte_interface_t *interface;
-    sys_dnode_t node;
+    atomic_ptr_t table;
+    atomic_t readers;
+    struct sys_mutex writer_mutex;
     /** @endcond */
-} introspection_node_t;
+} introspection_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -117,7 +138,7 @@ size_t introspection_get_string_size(introspection_t *introspection);
  * @brief Returns the introspection string as described in astarte documentation
  *
  * @details An empty string is returned if no interfaces got added with #introspection_add
- * The ordering of the interface names is not guaranteed and it should't be relied on
+ * The interfaces are ordered by name, however this should't be relied on
  * https://docs.astarte-platform.org/astarte/latest/080-mqtt-v1-protocol.html#introspection
  *
  * @param[in] introspection a pointer to an introspection struct initialized using
@@ -129,26 +150,38 @@ size_t introspection_get_string_size(introspection_t *introspection);
 void introspection_fill_string(introspection_t *introspection, char *buffer, size_t buffer_size);
 
 /**
- * @brief Returns the first node of the introspection that can be used to iterate the collection
+ * @brief Get the digest of the introspection
+ *
+ * @details The digest is computed once when the introspection is modified, two introspections
+ * containing the same interfaces with the same versions have the same digest.
+ * This function never blocks.
  *
  * @param[in] introspection a pointer to an introspection struct initialized using
  * #introspection_init
- * @return The first node that can be passed to #introspection_iter_next for iteration.
- * NULL if no introspection is empty.
+ * @param[out] digest buffer where to store the digest
  */
-introspection_node_t *introspection_iter(introspection_t *introspection);
+void introspection_get_digest(
+    introspection_t *introspection, uint8_t digest[static INTROSPECTION_DIGEST_SIZE]);
 
 /**
- * @brief Returns the next node of the introspection
+ * @brief Get a reference to the current table of the introspection
+ *
+ * @details The returned table will not change nor be deallocated until released with
+ * #introspection_release, even if the introspection gets concurrently updated.
+ * This function never blocks.
  *
  * @param[in] introspection a pointer to an introspection struct initialized using
  * #introspection_init
- * @param[in] current a pointer to the current introspection_node_t
- * @return The next node in the introspection. NULL if there are no more nodes in the introspection
- * or if a NULL pointer gets passed as the current parameter.
+ * @return The current introspection table, to be released with #introspection_release.
+ */
+const introspection_table_t *introspection_acquire(introspection_t *introspection);
+
+/**
+ * @brief Release a table obtained with #introspection_acquire
+ *
+ * @param[in] table a pointer to a table obtained with #introspection_acquire
  */
-introspection_node_t *introspection_iter_next(
-    introspection_t *introspection, introspection_node_t *current);
+void introspection_release(const introspection_table_t *table);
 
 /**
  * @brief Deallocates the introspection struct
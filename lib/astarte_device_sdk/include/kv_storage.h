@@ -185,6 +185,24 @@ astarte_result_t astarte_kv_storage_iterator_next(astarte_kv_storage_iter_t *ite
 astarte_result_t astarte_kv_storage_iterator_get(
     astarte_kv_storage_iter_t *iter, void *key, size_t *key_size);
 
+/**
+ * @brief Realign the iterator after the deletion of a key-value pair from storage.
+ *
+ * @details Deleting a pair shifts back all the pairs stored after it. The iterator is moved back to
+ * the pair with @p key, the one it pointed to before the deletion. If such pair has been deleted
+ * the iterator is advanced of one position.
+ *
+ * @note Each deletion should be followed by a realignment, as the position of a deleted pair is not
+ * known after the deletion.
+ *
+ * @param[inout] iter Iterator instance.
+ * @param[in] key Key of the pair pointed to by the iterator before the deletion.
+ * @return ASTARTE_RESULT_OK if successful, ASTARTE_RESULT_NOT_FOUND if no pair is left to iterate
+ * over, otherwise an error code.
+ */
+astarte_result_t astarte_kv_storage_iterator_realign(
+    astarte_kv_storage_iter_t *iter, const char *key);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,6 +41,36 @@ astarte_result_t astarte_mapping_array_to_scalar_type(
  */
 astarte_result_t astarte_mapping_check_path(astarte_mapping_t mapping, const char *path);
 
+/**
+ * @brief Check if a path corresponds to the object path of a mapping of an object interface.
+ *
+ * @note The object path is the mapping endpoint without its last segment.
+ *
+ * @param[in] mapping Mapping to use for the comparison.
+ * @param[in] path Path to use for comparison.
+ * @return ASTARTE_RESULT_OK on success, otherwise an error code.
+ */
+astarte_result_t astarte_mapping_check_object_path(astarte_mapping_t mapping, const char *path);
+
+/**
+ * @brief Get the key used for a mapping of an object interface inside the object.
+ *
+ * @param[in] mapping Mapping of an object interface.
+ * @return The last segment of the mapping endpoint.
+ */
+const char *astarte_mapping_get_object_key(astarte_mapping_t mapping);
+
+/**
+ * @brief Count the segments of a path.
+ *
+ * @details The result can be compared with the segments count precomputed for a mapping to
+ * discard it before checking the path.
+ *
+ * @param[in] path Path to use for the count.
+ * @return Number of segments in the path.
+ */
+size_t astarte_mapping_count_path_segments(const char *path);
+
 /**
  * @brief Check if some data is compatible to the type of a mapping.
  *
@@ -0,0 +1,169 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef METRICS_PRIVATE_H
+#define METRICS_PRIVATE_H
+
+/**
+ * @file metrics_private.h
+ * @brief Private functions used to collect the runtime metrics of the SDK.
+ *
+ * @details The SDK modules should only use the macros defined in this file, which expand to
+ * nothing when CONFIG_ASTARTE_DEVICE_SDK_METRICS is disabled.
+ */
+
+#include "astarte_device_sdk/metrics.h"
+
+#include "astarte_device_sdk/astarte.h"
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS)
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Increment a counter by one.
+ *
+ * @param[in] counter An #astarte_metrics_counter_t value.
+ */
+#define ASTARTE_METRICS_INC(counter) astarte_metrics_counter_add((counter), 1)
+
+/**
+ * @brief Increment a counter by an arbitrary amount.
+ *
+ * @param[in] counter An #astarte_metrics_counter_t value.
+ * @param[in] value Amount to add to the counter.
+ */
+#define ASTARTE_METRICS_ADD(counter, value) astarte_metrics_counter_add((counter), (value))
+
+/**
+ * @brief Add a positive or negative delta to a gauge.
+ *
+ * @param[in] gauge An #astarte_metrics_gauge_t value.
+ * @param[in] delta Amount to add to the gauge.
+ */
+#define ASTARTE_METRICS_GAUGE_ADD(gauge, delta) astarte_metrics_gauge_add((gauge), (delta))
+
+/**
+ * @brief Record a sample in a histogram.
+ *
+ * @param[in] histogram An #astarte_metrics_histogram_t value.
+ * @param[in] sample_us Sample to record, in microseconds.
+ */
+#define ASTARTE_METRICS_RECORD(histogram, sample_us)                                               \
+    astarte_metrics_histogram_record((histogram), (sample_us))
+
+/**
+ * @brief Declare and start a timer measuring a code section.
+ *
+ * @param[in] timer Name of the timer variable.
+ */
+#define ASTARTE_METRICS_TIMER_START(timer) uint32_t timer = k_cycle_get_32()
+
+/**
+ * @brief Pause a timer, the time elapsed until #ASTARTE_METRICS_TIMER_RESUME is not measured.
+ *
+ * @param[in] timer Name of the timer variable.
+ */
+#define ASTARTE_METRICS_TIMER_PAUSE(timer) timer = k_cycle_get_32() - (timer)
+
+/**
+ * @brief Resume a timer paused with #ASTARTE_METRICS_TIMER_PAUSE.
+ *
+ * @param[in] timer Name of the timer variable.
+ */
+#define ASTARTE_METRICS_TIMER_RESUME(timer) timer = k_cycle_get_32() - (timer)
+
+/**
+ * @brief Record the time elapsed since the start of a timer in a histogram.
+ *
+ * @param[in] histogram An #astarte_metrics_histogram_t value.
+ * @param[in] timer Name of the timer variable.
+ */
+#define ASTARTE_METRICS_TIMER_RECORD(histogram, timer)                                             \
+    astarte_metrics_histogram_record((histogram), k_cyc_to_us_floor32(k_cycle_get_32() - (timer)))
+
+/**
+ * @brief Record a message transmitted on an interface.
+ *
+ * @param[in] interface_name Name of the interface.
+ * @param[in] bytes Size of the message payload.
+ */
+#define ASTARTE_METRICS_INTERFACE_SENT(interface_name, bytes)                                      \
+    astarte_metrics_interface_sent((interface_name), (bytes))
+
+/**
+ * @brief Record a message received on an interface.
+ *
+ * @param[in] interface_name Name of the interface.
+ * @param[in] bytes Size of the message payload.
+ */
+#define ASTARTE_METRICS_INTERFACE_RECEIVED(interface_name, bytes)                                  \
+    astarte_metrics_interface_received((interface_name), (bytes))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Add a value to a counter.
+ *
+ * @param[in] counter Counter to update.
+ * @param[in] value Amount to add to the counter.
+ */
+void astarte_metrics_counter_add(astarte_metrics_counter_t counter, uint32_t value);
+
+/**
+ * @brief Add a delta to a gauge.
+ *
+ * @param[in] gauge Gauge to update.
+ * @param[in] delta Amount to add to the gauge, can be negative.
+ */
+void astarte_metrics_gauge_add(astarte_metrics_gauge_t gauge, int32_t delta);
+
+/**
+ * @brief Record a sample in a latency histogram.
+ *
+ * @param[in] histogram Histogram to update.
+ * @param[in] sample_us Sample to record, in microseconds.
+ */
+void astarte_metrics_histogram_record(astarte_metrics_histogram_t histogram, uint32_t sample_us);
+
+/**
+ * @brief Account a message transmitted on an interface.
+ *
+ * @param[in] interface_name Name of the interface.
+ * @param[in] bytes Size of the message payload.
+ */
+void astarte_metrics_interface_sent(const char *interface_name, size_t bytes);
+
+/**
+ * @brief Account a message received on an interface.
+ *
+ * @param[in] interface_name Name of the interface.
+ * @param[in] bytes Size of the message payload.
+ */
+void astarte_metrics_interface_received(const char *interface_name, size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else /* defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS) */
+
+#define ASTARTE_METRICS_INC(counter)
+#define ASTARTE_METRICS_ADD(counter, value)
+#define ASTARTE_METRICS_GAUGE_ADD(gauge, delta)
+#define ASTARTE_METRICS_RECORD(histogram, sample_us)
+#define ASTARTE_METRICS_TIMER_START(timer)
+#define ASTARTE_METRICS_TIMER_PAUSE(timer)
+#define ASTARTE_METRICS_TIMER_RESUME(timer)
+#define ASTARTE_METRICS_TIMER_RECORD(histogram, timer)
+#define ASTARTE_METRICS_INTERFACE_SENT(interface_name, bytes)
+#define ASTARTE_METRICS_INTERFACE_RECEIVED(interface_name, bytes)
+
+#endif /* defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS) */
+
+#endif /* METRICS_PRIVATE_H */
@@ -15,6 +15,7 @@
 #include "astarte_device_sdk/result.h"
 
 #include <zephyr/net/mqtt.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/hash_map.h>
 
 #include "astarte_device_sdk/device_id.h"
@@ -28,21 +29,63 @@
 /** @brief Exact length in chars for the MQTT client ID */
 #define ASTARTE_MQTT_CLIENT_ID_LEN                                                                 \
     (sizeof(CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "/") - 1 + ASTARTE_DEVICE_ID_LEN)
-/** @brief Size for the MQTT transmission and reception buffers */
-#define ASTARTE_MQTT_RX_TX_BUFFER_SIZE 256U
+/**
+ * @brief Size for the MQTT reception buffer
+ *
+ * @note Incoming publish payloads are not stored in this buffer, they are read separately in a
+ * reusable heap buffer. As such this buffer only needs to contain the packet headers and topics.
+ */
+#define ASTARTE_MQTT_RX_BUFFER_SIZE CONFIG_ASTARTE_DEVICE_SDK_ADVANCED_MQTT_RX_BUFFER_SIZE
+/**
+ * @brief Size for the MQTT transmission buffer
+ *
+ * @note Publish payloads are never copied in the transmission buffer, the MQTT library writes them
+ * to the socket directly following the fixed header and topic. As such this buffer only needs to
+ * contain the packet headers and the longest topic in use.
+ */
+#define ASTARTE_MQTT_TX_BUFFER_SIZE CONFIG_ASTARTE_DEVICE_SDK_ADVANCED_MQTT_TX_BUFFER_SIZE
 
 /** @brief Contains all the data related to a single MQTT client. */
 typedef struct astarte_mqtt astarte_mqtt_t;
 
-/** @brief Function pointer to be used for client certificate refresh. */
-typedef astarte_result_t (*astarte_mqtt_refresh_client_cert_cbk_t)(astarte_mqtt_t *astarte_mqtt);
+/**
+ * @brief Reference counted payload for an MQTT publish.
+ *
+ * @details A single payload instance is shared between the publisher and the retransmission cache
+ * for QoS 1 and 2 messages, avoiding any copy of the data between encoding and transmission.
+ * Use #astarte_mqtt_payload_wrap to create a new payload and #astarte_mqtt_payload_unref to
+ * release it.
+ */
+typedef struct
+{
+    /** @brief Number of owners of this payload. */
+    atomic_t refcount;
+    /** @brief Heap allocated data buffer, owned by the payload. Can be NULL for empty payloads. */
+    uint8_t *data;
+    /** @brief Size of the data buffer in bytes. */
+    size_t size;
+} astarte_mqtt_payload_t;
+
+/**
+ * @brief Function pointer to be used for client certificate refresh.
+ *
+ * @details The @p tls_rejected parameter is set when the previous connection attempt failed during
+ * the TLS handshake, for example because the broker refused the client certificate.
+ */
+typedef astarte_result_t (*astarte_mqtt_refresh_client_cert_cbk_t)(
+    astarte_mqtt_t *astarte_mqtt, bool tls_rejected);
 
 /** @brief Function pointer to be used for signaling a publish has been delivered. */
 typedef void (*astarte_mqtt_on_delivered_cbk_t)(astarte_mqtt_t *astarte_mqtt, uint16_t message_id);
 
-/** @brief Function pointer to be used for signaling a subscription has been delivered. */
-typedef void (*astarte_mqtt_on_subscribed_cbk_t)(
-    astarte_mqtt_t *astarte_mqtt, uint16_t message_id, enum mqtt_suback_return_code return_code);
+/**
+ * @brief Function pointer to be used for signaling a subscription has been delivered.
+ *
+ * @details Called once for each topic filter of the subscription, in the order used when
+ * subscribing.
+ */
+typedef void (*astarte_mqtt_on_subscribed_cbk_t)(astarte_mqtt_t *astarte_mqtt, uint16_t message_id,
+    size_t topic_index, enum mqtt_suback_return_code return_code);
 
 /** @brief Function pointer to notify the user that the MQTT connection has been established. */
 typedef void (*astarte_mqtt_on_connected_cbk_t)(
@@ -55,6 +98,18 @@ typedef void (*astarte_mqtt_on_disconnected_cbk_t)(astarte_mqtt_t *astarte_mqtt)
 typedef void (*astarte_mqtt_on_incoming_cbk_t)(astarte_mqtt_t *astarte_mqtt, const char *topic,
     size_t topic_len, const char *data, size_t data_len);
 
+/**
+ * @brief Function pointer to notify the user that a chunk of a large MQTT publish message has been
+ * received.
+ *
+ * @details Used for messages with a payload larger than
+ * CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE. Chunks are delivered in order, the last chunk is the
+ * one for which @p offset + @p chunk_len is equal to @p total_len.
+ */
+typedef void (*astarte_mqtt_on_incoming_chunk_cbk_t)(astarte_mqtt_t *astarte_mqtt,
+    const char *topic, size_t topic_len, size_t offset, const char *chunk, size_t chunk_len,
+    size_t total_len);
+
 /** @brief Connection statuses for the Astarte MQTT client. */
 typedef enum
 {
@@ -97,23 +152,37 @@ typedef struct
     astarte_mqtt_on_disconnected_cbk_t on_disconnected_cbk;
     /** @brief Callback used to notify the user that an MQTT message has been received. */
     astarte_mqtt_on_incoming_cbk_t on_incoming_cbk;
+    /** @brief Optional callback used to deliver in chunks messages exceeding the max size. */
+    astarte_mqtt_on_incoming_chunk_cbk_t on_incoming_chunk_cbk;
 } astarte_mqtt_config_t;
 
 /**
  * @brief Contains all the data related to a single MQTT client.
+ *
+ * @details Access to the client is protected by three mutexes, allowing transmission and
+ * reception to proceed concurrently. When more than one of them is required they are always
+ * locked in the following order: RX mutex, state mutex, TX mutex.
  */
 struct astarte_mqtt
 {
     /** @brief Clean session flag for connection. */
     bool clean_session;
-    /** Mutex to protect access to the client instance. */
-    struct sys_mutex mutex;
+    /** @brief Mutex serializing the reception from the client and protecting the RX buffers. */
+    struct sys_mutex rx_mutex;
+    /** @brief Mutex protecting the connection state, the timepoints and the backoff context. */
+    struct sys_mutex state_mutex;
+    /** @brief Mutex serializing the transmission to the client and protecting the caches. */
+    struct sys_mutex tx_mutex;
     /** @brief Zephyr MQTT client handle. */
     struct mqtt_client client;
     /** @brief Reception buffer to be used by the MQTT client. */
-    uint8_t rx_buffer[ASTARTE_MQTT_RX_TX_BUFFER_SIZE];
+    uint8_t rx_buffer[ASTARTE_MQTT_RX_BUFFER_SIZE];
     /** @brief Transmission buffer to be used by the MQTT client. */
-    uint8_t tx_buffer[ASTARTE_MQTT_RX_TX_BUFFER_SIZE];
+    uint8_t tx_buffer[ASTARTE_MQTT_TX_BUFFER_SIZE];
+    /** @brief Reusable heap buffer for the payloads of incoming messages, grown on demand. */
+    uint8_t *rx_payload_buffer;
+    /** @brief Size of the reusable buffer for the payloads of incoming messages. */
+    size_t rx_payload_buffer_size;
     /** @brief Timepoint to be used to check a connection timeout. */
     k_timepoint_t connection_timepoint;
     /** @brief Timeout for socket polls before connection to an MQTT broker. */
@@ -132,6 +201,8 @@ struct astarte_mqtt
     k_timepoint_t reconnection_timepoint;
     /** @brief Connection state. */
     astarte_mqtt_connection_states_t connection_state;
+    /** @brief Set when the last connection attempt failed during the TLS handshake. */
+    bool tls_rejected;
     /** @brief Callback used to check if the client certificate is valid. */
     astarte_mqtt_refresh_client_cert_cbk_t refresh_client_cert_cbk;
     /** @brief Callback used to check if transmitted publish have been delivered. */
@@ -156,6 +227,8 @@ struct astarte_mqtt
     astarte_mqtt_on_disconnected_cbk_t on_disconnected_cbk;
     /** @brief Callback used to notify the user that an MQTT message has been received. */
     astarte_mqtt_on_incoming_cbk_t on_incoming_cbk;
+    /** @brief Optional callback used to deliver in chunks messages exceeding the max size. */
+    astarte_mqtt_on_incoming_chunk_cbk_t on_incoming_chunk_cbk;
 };
 
 #ifdef __cplusplus
@@ -171,6 +244,16 @@ extern "C" {
  */
 astarte_result_t astarte_mqtt_init(astarte_mqtt_config_t *cfg, astarte_mqtt_t *astarte_mqtt);
 
+/**
+ * @brief Destroy an instance of the Astarte MQTT client.
+ *
+ * @details Clears all the pending messages and frees any resource owned by the client.
+ * The client should be disconnected before calling this function.
+ *
+ * @param[inout] astarte_mqtt Handle to the Astarte MQTT client instance.
+ */
+void astarte_mqtt_destroy(astarte_mqtt_t *astarte_mqtt);
+
 /**
  * @brief Start the connection procedure for the client to the MQTT broker.
  *
@@ -214,6 +297,23 @@ astarte_result_t astarte_mqtt_disconnect(astarte_mqtt_t *astarte_mqtt);
 void astarte_mqtt_subscribe(
     astarte_mqtt_t *astarte_mqtt, const char *topic, int max_qos, uint16_t *out_message_id);
 
+/**
+ * @brief Subscribe the client to multiple MQTT topics with a single SUBSCRIBE packet.
+ *
+ * @details Only the leading topics fitting in the MQTT TX buffer are added to the packet, at least
+ * one topic is always included. The function should be called again for the remaining topics.
+ *
+ * @param[inout] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @param[in] topics Topics to use for the subscription.
+ * @param[in] topics_count Number of elements in @p topics.
+ * @param[in] max_qos Maximum QoS level at which the server can send application messages.
+ * @param[out] out_message_id Stores the message ID used. Can be used in combination with the
+ * message delivered callback to wait for delivery of messages.
+ * @return Number of topics, from the start of @p topics, included in the packet. Zero on failure.
+ */
+size_t astarte_mqtt_subscribe_multiple(astarte_mqtt_t *astarte_mqtt, const char *const *topics,
+    size_t topics_count, int max_qos, uint16_t *out_message_id);
+
 /**
  * @brief Publish data to an MQTT topic.
  *
@@ -228,6 +328,49 @@ void astarte_mqtt_subscribe(
 void astarte_mqtt_publish(astarte_mqtt_t *astarte_mqtt, const char *topic, void *data,
     size_t data_size, int qos, uint16_t *out_message_id);
 
+/**
+ * @brief Publish a reference counted payload to an MQTT topic.
+ *
+ * @details The payload is transmitted without being copied. For QoS 1 and 2 the retransmission
+ * cache takes its own reference to the payload, the caller retains ownership of its reference.
+ *
+ * @param[inout] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @param[in] topic Topic to use for the publish.
+ * @param[in] payload Payload to publish, NULL for an empty payload.
+ * @param[in] qos QoS to be used for the publish.
+ * @param[out] out_message_id Stores the message ID used. Can be used in combination with the
+ * message delivered callback to wait for delivery of messages.
+ */
+void astarte_mqtt_publish_payload(astarte_mqtt_t *astarte_mqtt, const char *topic,
+    astarte_mqtt_payload_t *payload, int qos, uint16_t *out_message_id);
+
+/**
+ * @brief Create a reference counted payload taking ownership of a heap allocated buffer.
+ *
+ * @note On success the buffer will be freed when the last reference to the payload is released.
+ * On failure the ownership of the buffer remains to the caller.
+ *
+ * @param[in] data Heap allocated buffer, allocated with the SDK allocator.
+ * @param[in] size Size of the buffer in bytes.
+ * @return The new payload with a reference count of one, NULL when out of memory.
+ */
+astarte_mqtt_payload_t *astarte_mqtt_payload_wrap(void *data, size_t size);
+
+/**
+ * @brief Acquire a new reference to a payload.
+ *
+ * @param[inout] payload Payload to reference, can be NULL.
+ * @return The same payload passed as parameter.
+ */
+astarte_mqtt_payload_t *astarte_mqtt_payload_ref(astarte_mqtt_payload_t *payload);
+
+/**
+ * @brief Release a reference to a payload, freeing it when no references are left.
+ *
+ * @param[inout] payload Payload to release, can be NULL.
+ */
+void astarte_mqtt_payload_unref(astarte_mqtt_payload_t *payload);
+
 /**
  * @brief Poll the MQTT client.
  *
@@ -239,6 +382,25 @@ void astarte_mqtt_publish(astarte_mqtt_t *astarte_mqtt, const char *topic, void
  */
 astarte_result_t astarte_mqtt_poll(astarte_mqtt_t *astarte_mqtt);
 
+/**
+ * @brief Get the time left before the MQTT client has to be polled.
+ *
+ * @details Takes into account the connection timeout, the reconnection backoff, the keep alive
+ * and the retransmission of cached messages. Incoming data on the socket is not included.
+ *
+ * @param[in] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @return The time left before the next deadline, K_FOREVER if no deadline is present.
+ */
+k_timeout_t astarte_mqtt_get_next_deadline(astarte_mqtt_t *astarte_mqtt);
+
+/**
+ * @brief Get the socket used by the MQTT client.
+ *
+ * @param[in] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @return The socket file descriptor, or -1 if the client has no open connection.
+ */
+int astarte_mqtt_get_socket(astarte_mqtt_t *astarte_mqtt);
+
 /**
  * @brief Check if the MQTT client has any outgoing messages with QoS > 0 pending an acknoledgment.
  *
@@ -247,6 +409,15 @@ astarte_result_t astarte_mqtt_poll(astarte_mqtt_t *astarte_mqtt);
  */
 bool astarte_mqtt_has_pending_outgoing(astarte_mqtt_t *astarte_mqtt);
 
+/**
+ * @brief Check if a specific outgoing message with QoS > 0 is pending an acknoledgment.
+ *
+ * @param[in] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @param[in] message_id Message ID, as returned by the publish and subscribe functions.
+ * @return True if the message is pending, false otherwise.
+ */
+bool astarte_mqtt_is_pending_outgoing(astarte_mqtt_t *astarte_mqtt, uint16_t message_id);
+
 /**
  * @brief Clear all MQTT messages that are waiting to be acknoledged.
  *
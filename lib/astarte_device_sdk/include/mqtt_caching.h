@@ -36,10 +36,10 @@ typedef struct
     enum mqtt_caching_message_type type;
     /** @brief Topic of the message, can be NULL. */
     char *topic;
-    /** @brief Data of the message, can be NULL. */
-    void *data;
-    /** @brief Size of data of the message, can be zero. */
-    size_t data_size;
+    /** @brief Number of NUL separated topics stored in topic, zero is equivalent to one. */
+    size_t topic_count;
+    /** @brief Shared payload of the message, can be NULL. */
+    astarte_mqtt_payload_t *payload;
     /** @brief Quality of service or maximum allowed quality of service depending on message type */
     int qos;
 } mqtt_caching_message_t;
@@ -62,6 +62,8 @@ uint16_t mqtt_caching_get_available_message_id(struct sys_hashmap *map);
 /**
  * @brief Insert a message in an hashmap.
  *
+ * @note The topic is copied, while the payload is shared by acquiring a new reference to it.
+ *
  * @param[inout] map The map in which to insert the message.
  * @param[in] identifier Identifier for the message to cache.
  * @param[in] message Message to cache.
@@ -85,6 +87,14 @@ bool mqtt_caching_find_message(struct sys_hashmap *map, uint16_t message_id);
  */
 void mqtt_caching_check_message_expiry(struct sys_hashmap *map, astarte_mqtt_t *astarte_mqtt,
     mqtt_caching_retransmit_cbk_t retransmit_cbk);
+/**
+ * @brief Get the earliest expiration time among all the messages in the hashmap.
+ *
+ * @param[in] map The map to use for the operation.
+ * @return The earliest expiration timepoint, or a timepoint in the infinite future if the map is
+ * empty.
+ */
+k_timepoint_t mqtt_caching_get_next_expiry(struct sys_hashmap *map);
 /**
  * @brief Reset a message expiration time.
  *
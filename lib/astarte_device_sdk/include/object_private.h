@@ -34,6 +34,20 @@ extern "C" {
 astarte_result_t astarte_object_entries_serialize(
     astarte_bson_serializer_t *bson, astarte_object_entry_t *entries, size_t entries_length);
 
+/**
+ * @brief Appends to a BSON document the values of an object, stored in the order of the mappings.
+ *
+ * @details Each value is appended using as key the last segment of the corresponding mapping
+ * endpoint, without resolving any path.
+ *
+ * @param[in,out] bson a valid handle for the serializer instance.
+ * @param[in] interface Object interface the values belong to.
+ * @param[in] values Array of values, one for each mapping of the @p interface.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_object_values_serialize(astarte_bson_serializer_t *bson,
+    const astarte_interface_t *interface, const astarte_data_t *values);
+
 /**
  * @brief Deserialize a BSON element to an array of #astarte_object_entry_t.
  *
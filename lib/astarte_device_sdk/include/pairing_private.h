@@ -36,6 +36,20 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Begin a pairing session.
+ *
+ * @details Until the matching call to #astarte_pairing_session_end, all the requests to the
+ * pairing APIs share a single kept alive HTTP connection. Sessions can be nested, the connection
+ * is closed when the outermost session ends.
+ */
+void astarte_pairing_session_begin(void);
+
+/**
+ * @brief End a pairing session started with #astarte_pairing_session_begin.
+ */
+void astarte_pairing_session_end(void);
+
 /**
  * @brief Parse an MQTT broker URL into broker hostname and broker port.
  *
@@ -65,6 +79,23 @@ astarte_result_t astarte_pairing_get_mqtt_broker_hostname_and_port(int32_t http_
 astarte_result_t astarte_pairing_get_client_certificate(int32_t timeout_ms, const char *device_id,
     const char *cred_secr, astarte_tls_credentials_client_crt_t *client_crt);
 
+/**
+ * @brief Request a client x509 certificate to Astarte for an already generated key and CSR.
+ *
+ * @details Performs only the HTTP round-trip of #astarte_pairing_get_client_certificate, the key
+ * and CSR can be generated ahead of time with the crypto APIs.
+ *
+ * @param[in] timeout_ms Timeout to use for the HTTP operations in ms.
+ * @param[in] device_id Unique identifier to use to register the device instance.
+ * @param[in] cred_secr Credential secret to use as authorization token.
+ * @param[in] csr_pem CSR generated from the private key contained in @p client_crt, in PEM format.
+ * @param[inout] client_crt Client private key, used as input, and the resulting certificate.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_pairing_request_client_certificate(int32_t timeout_ms,
+    const char *device_id, const char *cred_secr, const unsigned char *csr_pem,
+    astarte_tls_credentials_client_crt_t *client_crt);
+
 /**
  * @brief Fetch the client x509 certificate from Astarte.
  *
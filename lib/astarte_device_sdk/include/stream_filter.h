@@ -0,0 +1,169 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STREAM_FILTER_H
+#define STREAM_FILTER_H
+
+/**
+ * @file stream_filter.h
+ * @brief Deadband and rate filters for the individual datastreams.
+ *
+ * @details The filters are defined per mapping by #astarte_mapping_filter_t, while their state is
+ * tracked per path. Each value to be sent is checked with #astarte_stream_filter_check, the held
+ * values are then collected with #astarte_stream_filter_pop_due once their deadline expires.
+ */
+
+#include "astarte_device_sdk/astarte.h"
+#include "astarte_device_sdk/data.h"
+#include "astarte_device_sdk/interface.h"
+#include "astarte_device_sdk/mapping.h"
+#include "astarte_device_sdk/result.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/mutex.h>
+
+/** @brief State of the filter for a single path. */
+typedef struct
+{
+    /** @brief Name of the interface, owned by the entry, NULL for an unused entry. */
+    char *interface_name;
+    /** @brief Path, owned by the entry. */
+    char *path;
+    /** @brief Set when a value has been sent on the path. */
+    bool has_last;
+    /** @brief Last value sent on the path. */
+    astarte_data_t last_value;
+    /** @brief Uptime in ticks at which the last value has been sent. */
+    int64_t last_ticks;
+    /** @brief Set when a value is held by the maximum rate. */
+    bool has_pending;
+    /** @brief Value held by the maximum rate. */
+    astarte_data_t pending_value;
+    /** @brief Set when the held value has an explicit timestamp. */
+    bool pending_has_timestamp;
+    /** @brief Explicit timestamp of the held value. */
+    int64_t pending_timestamp;
+    /** @brief Uptime in ticks at which the held value can be sent. */
+    int64_t pending_ticks;
+} astarte_stream_filter_entry_t;
+
+/** @brief Filter set at runtime, replacing the one of a mapping definition. */
+typedef struct
+{
+    /** @brief Mapping for which the filter is set, NULL for an unused override. */
+    const astarte_mapping_t *mapping;
+    /** @brief Filter to be used in place of the mapping one. */
+    astarte_mapping_filter_t filter;
+} astarte_stream_filter_override_t;
+
+/** @brief Filters of the individual datastreams of a device. */
+typedef struct
+{
+    /** @brief Mutex serializing the values checks from the user and the poll threads. */
+    struct sys_mutex mutex;
+    /** @brief State of the filtered paths. */
+    astarte_stream_filter_entry_t entries[CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS_PATHS];
+    /** @brief Next entry of #entries replaced when all are used. */
+    size_t entries_next;
+    /** @brief Filters set at runtime. */
+    astarte_stream_filter_override_t overrides[CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS_OVERRIDES];
+} astarte_stream_filter_t;
+
+/** @brief A held value that can now be sent. */
+typedef struct
+{
+    /** @brief Name of the interface, to be freed with #astarte_stream_filter_sample_destroy. */
+    char *interface_name;
+    /** @brief Path, to be freed with #astarte_stream_filter_sample_destroy. */
+    char *path;
+    /** @brief Value to send. */
+    astarte_data_t value;
+    /** @brief Set when the value has an explicit timestamp. */
+    bool has_timestamp;
+    /** @brief Explicit timestamp of the value. */
+    int64_t timestamp;
+} astarte_stream_filter_sample_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the filters of a device.
+ *
+ * @param[out] filter Filters to initialize.
+ */
+void astarte_stream_filter_init(astarte_stream_filter_t *filter);
+
+/**
+ * @brief Destroy the filters of a device, dropping any held value.
+ *
+ * @param[inout] filter Filters to destroy.
+ */
+void astarte_stream_filter_destroy(astarte_stream_filter_t *filter);
+
+/**
+ * @brief Set the filter of a mapping at runtime.
+ *
+ * @param[inout] filter Filters of the device.
+ * @param[in] interface Individual device owned datastream interface.
+ * @param[in] endpoint Endpoint of the mapping, as in the interface definition.
+ * @param[in] mapping_filter Filter to set, NULL to restore the one of the mapping definition.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_stream_filter_set(astarte_stream_filter_t *filter,
+    const astarte_interface_t *interface, const char *endpoint,
+    const astarte_mapping_filter_t *mapping_filter);
+
+/**
+ * @brief Check if a value should be sent now.
+ *
+ * @details When the value is not to be sent now it has either been dropped or held. Held values
+ * are returned by #astarte_stream_filter_pop_due once the maximum rate allows them.
+ *
+ * @param[inout] filter Filters of the device.
+ * @param[in] interface Interface of the value.
+ * @param[in] mapping Mapping of the value.
+ * @param[in] path Path of the value.
+ * @param[in] value Value to check.
+ * @param[in] timestamp Explicit timestamp of the value, NULL if not present.
+ * @return True if the value should be sent now, false otherwise.
+ */
+bool astarte_stream_filter_check(astarte_stream_filter_t *filter,
+    const astarte_interface_t *interface, const astarte_mapping_t *mapping, const char *path,
+    astarte_data_t value, const int64_t *timestamp);
+
+/**
+ * @brief Take a held value that can now be sent.
+ *
+ * @param[inout] filter Filters of the device.
+ * @param[out] sample Held value, to be destroyed with #astarte_stream_filter_sample_destroy.
+ * @return ASTARTE_RESULT_OK if a value has been returned, ASTARTE_RESULT_NOT_FOUND when no held
+ * value can be sent, otherwise an error code.
+ */
+astarte_result_t astarte_stream_filter_pop_due(
+    astarte_stream_filter_t *filter, astarte_stream_filter_sample_t *sample);
+
+/**
+ * @brief Destroy a held value returned by #astarte_stream_filter_pop_due.
+ *
+ * @param[in] sample Held value to destroy.
+ */
+void astarte_stream_filter_sample_destroy(astarte_stream_filter_sample_t sample);
+
+/**
+ * @brief Get the timeout until the next held value can be sent.
+ *
+ * @param[inout] filter Filters of the device.
+ * @return The timeout to the next held value, K_FOREVER when no value is held.
+ */
+k_timeout_t astarte_stream_filter_get_deadline(astarte_stream_filter_t *filter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STREAM_FILTER_H
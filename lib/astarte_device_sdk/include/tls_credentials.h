@@ -49,6 +49,26 @@ astarte_result_t astarte_tls_credential_add(astarte_tls_credentials_client_crt_t
  */
 astarte_result_t astarte_tls_credential_delete(void);
 
+/**
+ * @brief Enable TLS session resumption on a socket.
+ *
+ * @details The TLS session negotiated on the socket will be stored in the session cache of the
+ * socket layer, and reused for the following connections to the same peer.
+ * This function does nothing if TLS session resumption has been disabled in the configuration.
+ *
+ * @param[in] sock TLS socket, it should not be connected yet.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t astarte_tls_session_cache_enable(int sock);
+
+/**
+ * @brief Purge all the TLS sessions stored in the session cache.
+ *
+ * @details Should be called when the client credentials change, as sessions established with
+ * the old credentials should not be resumed.
+ */
+void astarte_tls_session_cache_purge(void);
+
 #ifdef __cplusplus
 }
 #endif
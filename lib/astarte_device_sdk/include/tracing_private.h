@@ -0,0 +1,61 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TRACING_PRIVATE_H
+#define TRACING_PRIVATE_H
+
+/**
+ * @file tracing_private.h
+ * @brief Private functions used to emit the trace points of the SDK hot paths.
+ *
+ * @details The SDK modules should only use the macros defined in this file, which expand to
+ * nothing when CONFIG_ASTARTE_DEVICE_SDK_TRACING is disabled.
+ */
+
+#include "astarte_device_sdk/tracing.h"
+
+#include "astarte_device_sdk/astarte.h"
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING)
+
+/**
+ * @brief Emit the trace point marking the beginning of a stage.
+ *
+ * @param[in] stage An #astarte_trace_stage_t value.
+ */
+#define ASTARTE_TRACE_BEGIN(stage) astarte_trace_emit((stage), true)
+
+/**
+ * @brief Emit the trace point marking the end of a stage.
+ *
+ * @param[in] stage An #astarte_trace_stage_t value.
+ */
+#define ASTARTE_TRACE_END(stage) astarte_trace_emit((stage), false)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Emit a trace point through the configured backend.
+ *
+ * @param[in] stage Stage delimited by the trace point.
+ * @param[in] begin True for the beginning of the stage, false for its end.
+ */
+void astarte_trace_emit(astarte_trace_stage_t stage, bool begin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else /* defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING) */
+
+#define ASTARTE_TRACE_BEGIN(stage)
+#define ASTARTE_TRACE_END(stage)
+
+#endif /* defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING) */
+
+#endif /* TRACING_PRIVATE_H */
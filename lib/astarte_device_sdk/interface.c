@@ -12,9 +12,11 @@
 
 #include "mapping_private.h"
 
+#include "heap_private.h"
 #include "log.h"
 
 ASTARTE_LOG_MODULE_REGISTER(astarte_interface, CONFIG_ASTARTE_DEVICE_SDK_INTROSPECTION_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_INTERFACE);
 
 astarte_result_t astarte_interface_validate(const astarte_interface_t *interface)
 {
@@ -33,7 +35,13 @@ astarte_result_t astarte_interface_validate(const astarte_interface_t *interface
 astarte_result_t astarte_interface_get_mapping_from_path(
     const astarte_interface_t *interface, const char *path, const astarte_mapping_t **mapping)
 {
+    size_t path_segments = astarte_mapping_count_path_segments(path);
     for (size_t i = 0; i < interface->mappings_length; i++) {
+        // Discard without parsing the endpoint the mappings with a different number of segments
+        uint8_t endpoint_segments = interface->mappings[i].endpoint_segments;
+        if ((endpoint_segments != 0) && (endpoint_segments != path_segments)) {
+            continue;
+        }
         astarte_result_t ares = astarte_mapping_check_path(interface->mappings[i], path);
         if (ares == ASTARTE_RESULT_OK) {
             *mapping = &interface->mappings[i];
@@ -53,7 +61,7 @@ astarte_result_t astarte_interface_get_mapping_from_paths(const astarte_interfac
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     const size_t fullpath_size = strlen(path1) + 1 + strlen(path2) + 1;
-    char *fullpath = calloc(fullpath_size, sizeof(char));
+    char *fullpath = astarte_calloc(fullpath_size, sizeof(char));
     if (!fullpath) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         return ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -72,7 +80,7 @@ astarte_result_t astarte_interface_get_mapping_from_paths(const astarte_interfac
     }
 
 exit:
-    free(fullpath);
+    astarte_free(fullpath);
     return ares;
 }
 
@@ -8,29 +8,53 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-#include <zephyr/sys/dlist.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/sys/util.h>
 
+#include <mbedtls/sha256.h>
+
 #include "astarte_device_sdk/interface.h"
 #include "astarte_device_sdk/result.h"
+#include "heap_private.h"
 #include "interface_private.h"
 #include "log.h"
 
 ASTARTE_LOG_MODULE_REGISTER(
     astarte_introspection, CONFIG_ASTARTE_DEVICE_SDK_INTROSPECTION_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_INTROSPECTION);
 
 /**
- * @brief Function used to find a `introspection_node_t` from an interface_name
- *
- * @details The passed interface_name is used as key to search in the inner structure
+ * @brief Search an interface in an introspection table using its name as key
  *
- * @param[in] introspection a pointer to an introspection struct
+ * @param[in] table a pointer to an introspection table
  * @param[in] interface_name Interface name used in the comparison
- * @return The node whose interface name matches the one passed, NULL if not such interface exists.
+ * @param[out] index Index of the matching interface, or of the position where it should be
+ * inserted if no matching interface exists.
+ * @return True if an interface with the passed name exists in the table, false otherwise.
  */
-static introspection_node_t *find_node_by_name(
-    introspection_t *introspection, const char *interface_name);
+static bool table_search(
+    const introspection_table_t *table, const char *interface_name, size_t *index);
+
+/**
+ * @brief Allocates a new introspection table
+ *
+ * @param[in] count Number of interfaces the table will contain
+ * @return The new table with a single reference, NULL if out of memory.
+ */
+static introspection_table_t *table_alloc(size_t count);
+
+/**
+ * @brief Computes the digest of an introspection table
+ *
+ * @details The digest covers the name, major and minor version of each interface in the table.
+ *
+ * @param[in,out] table a pointer to an introspection table, its digest will be set
+ * @return ASTARTE_RESULT_OK on success, otherwise an error code.
+ */
+static astarte_result_t table_compute_digest(introspection_table_t *table);
 
 /**
  * @brief Counts the number of digits of the passed paramter `num`
@@ -40,42 +64,57 @@ static introspection_node_t *find_node_by_name(
 static uint8_t get_digit_count(uint32_t num);
 
 /**
- * @brief Frees the node passed
- *
- * @details This function should be called only from a 'safe' context.
- * Nodes from the list should be freely removable
+ * @brief Check whether an interface is valid and compatible with an introspection table
  *
- * @param[in] alloc_node a pointer to a dynamically allocated introspection_node_t
+ * @param[in] table a pointer to the current introspection table
+ * @param[in] interface the pointer to an interface struct
+ * @param[out] present Set to true when an interface with the same name is present in the table
+ * @param[out] index Index of the interface with the same name in the table, or of the position
+ * where the new interface should be inserted.
+ * @return ASTARTE_RESULT_OK on success, otherwise an error code.
  */
-static inline void node_free(introspection_node_t *alloc_node);
+static astarte_result_t check_interface_update(const introspection_table_t *table,
+    const astarte_interface_t *interface, bool *present, size_t *index);
 
 /**
- * @brief Check whether an interface is valid and compatible with this introspection
+ * @brief Publish a new table for the introspection, releasing the old one
  *
- * @details The previous node gets returned in `introspection_node` parameter and should be
- * replaced with the new interface if it passes the check.
+ * @details Waits for all the readers that might be taking a reference to the old table to be
+ * done before releasing it. Should be called with the writer mutex locked.
  *
- * @param[in] introspection a pointer to an introspection struct initialized using
+ * @param[in,out] introspection a pointer to an introspection struct initialized using
  * #introspection_init
- * @param[in] interface the pointer to an interface struct
- * @param[out] introspection_node Output pointer that if not NULL will be set to the
- * to the location of the old node found, or NULL if there was no previous node matching
- * the passed interface->name
- * @return ASTARTE_RESULT_OK on success, otherwise an error code.
+ * @param[in] table the new table to publish, the introspection takes ownership of it
  */
-static astarte_result_t check_interface_update(introspection_t *introspection,
-    const astarte_interface_t *interface, introspection_node_t **introspection_node);
+static void publish_table(introspection_t *introspection, introspection_table_t *table);
 
 /**
- * @brief Allocates and append a new node to the introspection struct passed
+ * @brief Insert or replace an interface in the introspection
  *
  * @param[in,out] introspection a pointer to an introspection struct initialized using
  * #introspection_init
  * @param[in] interface the pointer to an interface struct
+ * @param[in] allow_update If false an interface with the same name is not replaced
  * @return ASTARTE_RESULT_OK on success, otherwise an error code.
  */
-static astarte_result_t append_introspection_node(
-    introspection_t *introspection, const astarte_interface_t *interface);
+static astarte_result_t insert_interface(
+    introspection_t *introspection, const astarte_interface_t *interface, bool allow_update);
+
+/**
+ * @brief Lock the writer mutex of the introspection
+ *
+ * @param[in,out] introspection a pointer to an introspection struct initialized using
+ * #introspection_init
+ */
+static void writer_lock(introspection_t *introspection);
+
+/**
+ * @brief Unlock the writer mutex of the introspection
+ *
+ * @param[in,out] introspection a pointer to an introspection struct initialized using
+ * #introspection_init
+ */
+static void writer_unlock(introspection_t *introspection);
 
 astarte_result_t introspection_init(introspection_t *introspection)
 {
@@ -84,18 +123,19 @@ astarte_result_t introspection_init(introspection_t *introspection)
         return ASTARTE_RESULT_INVALID_PARAM;
     }
 
-    *introspection = (introspection_t) {
-        .list = calloc(1, sizeof(sys_dlist_t)),
-    };
-
-    if (!introspection->list) {
+    introspection_table_t *table = table_alloc(0);
+    if (!table) {
         return ASTARTE_RESULT_OUT_OF_MEMORY;
     }
+    astarte_result_t ares = table_compute_digest(table);
+    if (ares != ASTARTE_RESULT_OK) {
+        introspection_release(table);
+        return ares;
+    }
 
-    // the list passed here has to be dynamically allocated
-    // inside this function the pointer of the list gets stored as a head and tail pointer
-    // and will be later used to check for list emptyness and other functionalities
-    sys_dlist_init(introspection->list);
+    atomic_ptr_set(&introspection->table, table);
+    atomic_set(&introspection->readers, 0);
+    sys_mutex_init(&introspection->writer_mutex);
 
     return ASTARTE_RESULT_OK;
 }
@@ -108,17 +148,7 @@ astarte_result_t introspection_add(
         return ares;
     }
 
-    introspection_node_t *check_alloc_node = find_node_by_name(introspection, interface->name);
-    if (check_alloc_node) {
-        return ASTARTE_RESULT_INTERFACE_ALREADY_PRESENT;
-    }
-
-    ares = append_introspection_node(introspection, interface);
-    if (ares != ASTARTE_RESULT_OK) {
-        return ares;
-    }
-
-    return ASTARTE_RESULT_OK;
+    return insert_interface(introspection, interface, false);
 }
 
 astarte_result_t introspection_update(
@@ -130,61 +160,70 @@ astarte_result_t introspection_update(
         return ares;
     }
 
-    introspection_node_t *old_node = NULL;
-    ares = check_interface_update(introspection, interface, &old_node);
-    if (ares != ASTARTE_RESULT_OK) {
-        return ares;
-    }
-
-    if (old_node) {
-        // we are updating an old node
-        old_node->interface = interface;
-    } else {
-        // no previous interface with the same name so we append a new node
-        ares = append_introspection_node(introspection, interface);
-        if (ares != ASTARTE_RESULT_OK) {
-            return ares;
-        }
-    }
-
-    return ASTARTE_RESULT_OK;
+    return insert_interface(introspection, interface, true);
 }
 
 const astarte_interface_t *introspection_get(
     introspection_t *introspection, const char *interface_name)
 {
-    introspection_node_t *alloc_node = find_node_by_name(introspection, interface_name);
+    const astarte_interface_t *interface = NULL;
+    const introspection_table_t *table = introspection_acquire(introspection);
 
-    if (!alloc_node) {
-        return NULL;
+    size_t index = 0;
+    if (table_search(table, interface_name, &index)) {
+        // Interfaces are owned by the user, they stay valid after releasing the table
+        interface = table->interfaces[index];
     }
 
-    return alloc_node->interface;
+    introspection_release(table);
+    return interface;
 }
 
 astarte_result_t introspection_remove(introspection_t *introspection, const char *interface_name)
 {
-    introspection_node_t *alloc_node = find_node_by_name(introspection, interface_name);
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    writer_lock(introspection);
+
+    // Writers are serialized, the current table can't be released while holding the mutex
+    const introspection_table_t *table = atomic_ptr_get(&introspection->table);
+
+    size_t index = 0;
+    if (!table_search(table, interface_name, &index)) {
+        ares = ASTARTE_RESULT_INTERFACE_NOT_FOUND;
+        goto exit;
+    }
 
-    if (!alloc_node) {
-        return ASTARTE_RESULT_INTERFACE_NOT_FOUND;
+    introspection_table_t *new_table = table_alloc(table->count - 1);
+    if (!new_table) {
+        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+        goto exit;
+    }
+    memcpy(new_table->interfaces, table->interfaces, index * sizeof(astarte_interface_t *));
+    memcpy(&new_table->interfaces[index], &table->interfaces[index + 1],
+        (table->count - index - 1) * sizeof(astarte_interface_t *));
+    ares = table_compute_digest(new_table);
+    if (ares != ASTARTE_RESULT_OK) {
+        introspection_release(new_table);
+        goto exit;
     }
 
-    node_free(alloc_node);
+    publish_table(introspection, new_table);
 
-    return ASTARTE_RESULT_OK;
+exit:
+    writer_unlock(introspection);
+    return ares;
 }
 
 size_t introspection_get_string_size(introspection_t *introspection)
 {
-    introspection_node_t *iter_node = NULL;
+    const introspection_table_t *table = introspection_acquire(introspection);
     size_t len = 0;
 
-    SYS_DLIST_FOR_EACH_CONTAINER(introspection->list, iter_node, node)
-    {
-        size_t name_len = strnlen(iter_node->interface->name, ASTARTE_INTERFACE_NAME_MAX_SIZE);
-        size_t major_len = get_digit_count(iter_node->interface->major_version);
-        size_t minor_len = get_digit_count(iter_node->interface->minor_version);
+    for (size_t i = 0; i < table->count; i++) {
+        const astarte_interface_t *interface = table->interfaces[i];
+        size_t name_len = strnlen(interface->name, ASTARTE_INTERFACE_NAME_MAX_SIZE);
+        size_t major_len = get_digit_count(interface->major_version);
+        size_t minor_len = get_digit_count(interface->minor_version);
         // size of the separators 3 (name:1:0; 2 ':' and 1 ';')
         // the separator ';' of the last interface is not present in an introspection
         // but we use it in the count as the byte needed for the null terminator char
@@ -193,6 +232,8 @@ size_t introspection_get_string_size(introspection_t *introspection)
         len += name_len + major_len + minor_len + separator_len;
     }
 
+    introspection_release(table);
+
     // MAX to correctly handle the case of no interfaces
     len = MAX(1, len);
 
@@ -207,67 +248,128 @@ size_t introspection_get_string_size(introspection_t *introspection)
 
 void introspection_fill_string(introspection_t *introspection, char *buffer, size_t buffer_size)
 {
-    introspection_node_t *iter_node = NULL;
+    const introspection_table_t *table = introspection_acquire(introspection);
     size_t result_len = 0;
 
-    SYS_DLIST_FOR_EACH_CONTAINER(introspection->list, iter_node, node)
-    {
+    for (size_t i = 0; (i < table->count) && (result_len < buffer_size); i++) {
+        const astarte_interface_t *interface = table->interfaces[i];
         result_len += snprintf(buffer + result_len, buffer_size - result_len, "%s:%u:%u;",
-            iter_node->interface->name, iter_node->interface->major_version,
-            iter_node->interface->minor_version);
+            interface->name, interface->major_version, interface->minor_version);
     }
 
+    introspection_release(table);
+
     // to ensure that even the case of an empty collection gets handled correctly
     buffer[buffer_size - 1] = '\0';
 }
 
-introspection_node_t *introspection_iter(introspection_t *introspection)
+void introspection_get_digest(
+    introspection_t *introspection, uint8_t digest[static INTROSPECTION_DIGEST_SIZE])
 {
-    // this is just used in the successive macro call to extract the type of the container
-    introspection_node_t *iter_node = NULL;
+    const introspection_table_t *table = introspection_acquire(introspection);
+    memcpy(digest, table->digest, INTROSPECTION_DIGEST_SIZE);
+    introspection_release(table);
+}
 
-    return SYS_DLIST_PEEK_HEAD_CONTAINER(introspection->list, iter_node, node);
+const introspection_table_t *introspection_acquire(introspection_t *introspection)
+{
+    // Signal to writers that a reference is being taken, the table loaded here can't be
+    // released until the reference is owned
+    atomic_inc(&introspection->readers);
+    introspection_table_t *table = atomic_ptr_get(&introspection->table);
+    atomic_inc(&table->refcount);
+    atomic_dec(&introspection->readers);
+    return table;
 }
 
-introspection_node_t *introspection_iter_next(
-    introspection_t *introspection, introspection_node_t *current)
+void introspection_release(const introspection_table_t *table)
 {
-    return SYS_DLIST_PEEK_NEXT_CONTAINER(introspection->list, current, node);
+    introspection_table_t *mut_table = (introspection_table_t *) table;
+    // atomic_dec returns the value before the decrement
+    if (atomic_dec(&mut_table->refcount) == 1) {
+        astarte_free(mut_table);
+    }
 }
 
 void introspection_free(introspection_t introspection)
 {
-    if (introspection.list) {
-        introspection_node_t *alloc_node = NULL;
-        introspection_node_t *next = NULL;
-        SYS_DLIST_FOR_EACH_CONTAINER_SAFE(introspection.list, alloc_node, next, node)
-        {
-            node_free(alloc_node);
-        }
+    introspection_table_t *table = atomic_ptr_get(&introspection.table);
+    if (table) {
+        introspection_release(table);
     }
-    free(introspection.list);
 }
 
-static inline void node_free(introspection_node_t *alloc_node)
+static bool table_search(
+    const introspection_table_t *table, const char *interface_name, size_t *index)
 {
-    sys_dlist_remove(&alloc_node->node);
-    free((void *) alloc_node);
+    size_t low = 0;
+    size_t high = table->count;
+
+    while (low < high) {
+        size_t mid = low + ((high - low) / 2);
+        int cmp = strncmp(
+            interface_name, table->interfaces[mid]->name, ASTARTE_INTERFACE_NAME_MAX_SIZE);
+        if (cmp == 0) {
+            *index = mid;
+            return true;
+        }
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    *index = low;
+    return false;
 }
 
-static introspection_node_t *find_node_by_name(
-    introspection_t *introspection, const char *interface_name)
+static introspection_table_t *table_alloc(size_t count)
 {
-    introspection_node_t *iter_node = NULL;
+    size_t table_size = sizeof(introspection_table_t) + (count * sizeof(astarte_interface_t *));
+    introspection_table_t *table = astarte_calloc(1, table_size);
+    if (!table) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return NULL;
+    }
+    atomic_set(&table->refcount, 1);
+    table->count = count;
+    return table;
+}
 
-    SYS_DLIST_FOR_EACH_CONTAINER(introspection->list, iter_node, node)
-    {
-        if (strncmp(interface_name, iter_node->interface->name, ASTARTE_INTERFACE_NAME_MAX_SIZE)
-            == 0) {
-            return iter_node;
+static astarte_result_t table_compute_digest(introspection_table_t *table)
+{
+    astarte_result_t ares = ASTARTE_RESULT_MBEDTLS_ERROR;
+    mbedtls_sha256_context ctx = { 0 };
+    mbedtls_sha256_init(&ctx);
+
+    int ret = mbedtls_sha256_starts(&ctx, 0);
+    for (size_t i = 0; (ret == 0) && (i < table->count); i++) {
+        const astarte_interface_t *interface = table->interfaces[i];
+        // The name terminator separates the name from the versions
+        size_t name_size = strnlen(interface->name, ASTARTE_INTERFACE_NAME_MAX_SIZE) + 1;
+        uint8_t versions[2 * sizeof(uint32_t)] = { 0 };
+        sys_put_be32(interface->major_version, &versions[0]);
+        sys_put_be32(interface->minor_version, &versions[sizeof(uint32_t)]);
+
+        ret = mbedtls_sha256_update(&ctx, (const unsigned char *) interface->name, name_size);
+        if (ret == 0) {
+            ret = mbedtls_sha256_update(&ctx, versions, sizeof(versions));
         }
     }
+    if (ret == 0) {
+        ret = mbedtls_sha256_finish(&ctx, table->digest);
+    }
+    if (ret != 0) {
+        ASTARTE_LOG_ERR("Introspection digest computation failed: %d", ret);
+        goto exit;
+    }
 
-    return NULL;
+    ares = ASTARTE_RESULT_OK;
+
+exit:
+    mbedtls_sha256_free(&ctx);
+    return ares;
 }
 
 static uint8_t get_digit_count(uint32_t num)
@@ -285,13 +387,13 @@ static uint8_t get_digit_count(uint32_t num)
     return count;
 }
 
-static astarte_result_t check_interface_update(introspection_t *introspection,
-    const astarte_interface_t *interface, introspection_node_t **introspection_node)
+static astarte_result_t check_interface_update(const introspection_table_t *table,
+    const astarte_interface_t *interface, bool *present, size_t *index)
 {
-    introspection_node_t *old_node = find_node_by_name(introspection, interface->name);
+    *present = table_search(table, interface->name, index);
 
-    if (old_node) {
-        const astarte_interface_t *old_interface = old_node->interface;
+    if (*present) {
+        const astarte_interface_t *old_interface = table->interfaces[*index];
 
         ASTARTE_LOG_WRN("Trying to add an interface already present in introspection");
 
@@ -321,31 +423,80 @@ static astarte_result_t check_interface_update(introspection_t *introspection,
             interface->name, interface->major_version, interface->minor_version);
     }
 
-    // in the case of no old node this will be set to NULL and that is expected
-    if (introspection_node) {
-        *introspection_node = old_node;
+    return ASTARTE_RESULT_OK;
+}
+
+static void publish_table(introspection_t *introspection, introspection_table_t *table)
+{
+    introspection_table_t *old_table = atomic_ptr_set(&introspection->table, table);
+
+    // Readers that loaded the old table might still be taking a reference to it
+    while (atomic_get(&introspection->readers) != 0) {
+        k_sleep(K_TICKS(1));
     }
 
-    return ASTARTE_RESULT_OK;
+    // Readers holding a reference keep the old table alive until they release it
+    introspection_release(old_table);
 }
 
-static astarte_result_t append_introspection_node(
-    introspection_t *introspection, const astarte_interface_t *interface)
+static astarte_result_t insert_interface(
+    introspection_t *introspection, const astarte_interface_t *interface, bool allow_update)
 {
-    introspection_node_t *alloc_node = calloc(1, sizeof(introspection_node_t));
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    writer_lock(introspection);
+
+    // Writers are serialized, the current table can't be released while holding the mutex
+    const introspection_table_t *table = atomic_ptr_get(&introspection->table);
+
+    bool present = false;
+    size_t index = 0;
+    if (!allow_update) {
+        present = table_search(table, interface->name, &index);
+        if (present) {
+            ares = ASTARTE_RESULT_INTERFACE_ALREADY_PRESENT;
+            goto exit;
+        }
+    } else {
+        ares = check_interface_update(table, interface, &present, &index);
+        if (ares != ASTARTE_RESULT_OK) {
+            goto exit;
+        }
+    }
 
-    if (!alloc_node) {
-        return ASTARTE_RESULT_OUT_OF_MEMORY;
+    introspection_table_t *new_table = table_alloc((present) ? table->count : table->count + 1);
+    if (!new_table) {
+        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+        goto exit;
+    }
+    // Copy the old table leaving a slot for the interface at the sorted position
+    size_t tail_index = (present) ? index + 1 : index;
+    memcpy(new_table->interfaces, table->interfaces, index * sizeof(astarte_interface_t *));
+    new_table->interfaces[index] = interface;
+    memcpy(&new_table->interfaces[index + 1], &table->interfaces[tail_index],
+        (table->count - tail_index) * sizeof(astarte_interface_t *));
+    ares = table_compute_digest(new_table);
+    if (ares != ASTARTE_RESULT_OK) {
+        introspection_release(new_table);
+        goto exit;
     }
 
-    *alloc_node = (introspection_node_t) {
-        .interface = interface,
-        .node = {},
-    };
+    publish_table(introspection, new_table);
 
-    sys_dnode_init(&alloc_node->node);
+exit:
+    writer_unlock(introspection);
+    return ares;
+}
 
-    sys_dlist_append(introspection->list, &alloc_node->node);
+static void writer_lock(introspection_t *introspection)
+{
+    int mutex_rc = sys_mutex_lock(&introspection->writer_mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
 
-    return ASTARTE_RESULT_OK;
+static void writer_unlock(introspection_t *introspection)
+{
+    int mutex_rc = sys_mutex_unlock(&introspection->writer_mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
 }
@@ -10,9 +10,12 @@
 
 #include <zephyr/sys/mutex.h>
 
+#include "heap_private.h"
 #include "log.h"
+#include "metrics_private.h"
 
 ASTARTE_LOG_MODULE_REGISTER(astarte_kv_storage, CONFIG_ASTARTE_DEVICE_SDK_KV_STORAGE_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_KV_STORAGE);
 
 /************************************************
  *        Defines, constants and typedef        *
@@ -122,7 +125,7 @@ astarte_result_t astarte_kv_storage_new(
     size_t namespace_cpy_size = 0U;
 
     namespace_cpy_size = strlen(namespace) + 1;
-    namespace_cpy = calloc(namespace_cpy_size, sizeof(char));
+    namespace_cpy = astarte_calloc(namespace_cpy_size, sizeof(char));
     if (!namespace_cpy) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -139,14 +142,14 @@ astarte_result_t astarte_kv_storage_new(
     return ASTARTE_RESULT_OK;
 
 error:
-    free(namespace_cpy);
+    astarte_free(namespace_cpy);
 
     return ares;
 }
 
 void astarte_kv_storage_destroy(astarte_kv_storage_t kv_storage)
 {
-    free(kv_storage.namespace);
+    astarte_free(kv_storage.namespace);
 }
 
 astarte_result_t astarte_kv_storage_insert(
@@ -162,6 +165,7 @@ astarte_result_t astarte_kv_storage_insert(
     int mutex_rc = sys_mutex_lock(&astarte_kv_storage_mutex, K_FOREVER);
     ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
     __ASSERT_NO_MSG(mutex_rc == 0);
+    ASTARTE_METRICS_TIMER_START(op_timer);
 
     nvs_fs.flash_device = kv_storage->flash_device;
     nvs_fs.offset = kv_storage->flash_offset;
@@ -230,6 +234,8 @@ astarte_result_t astarte_kv_storage_insert(
     }
 
 exit:
+    ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_KV_STORAGE_WRITES);
+    ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_KV_STORAGE, op_timer);
 
     // Unlock the mutex for the key-value storage
     mutex_rc = sys_mutex_unlock(&astarte_kv_storage_mutex);
@@ -251,6 +257,7 @@ astarte_result_t astarte_kv_storage_find(
     int mutex_rc = sys_mutex_lock(&astarte_kv_storage_mutex, K_FOREVER);
     ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
     __ASSERT_NO_MSG(mutex_rc == 0);
+    ASTARTE_METRICS_TIMER_START(op_timer);
 
     nvs_fs.flash_device = kv_storage->flash_device;
     nvs_fs.offset = kv_storage->flash_offset;
@@ -290,6 +297,8 @@ astarte_result_t astarte_kv_storage_find(
     }
 
 exit:
+    ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_KV_STORAGE_READS);
+    ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_KV_STORAGE, op_timer);
 
     // Unlock the mutex for the key-value storage
     mutex_rc = sys_mutex_unlock(&astarte_kv_storage_mutex);
@@ -310,6 +319,7 @@ astarte_result_t astarte_kv_storage_delete(astarte_kv_storage_t *kv_storage, con
     int mutex_rc = sys_mutex_lock(&astarte_kv_storage_mutex, K_FOREVER);
     ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
     __ASSERT_NO_MSG(mutex_rc == 0);
+    ASTARTE_METRICS_TIMER_START(op_timer);
 
     nvs_fs.flash_device = kv_storage->flash_device;
     nvs_fs.offset = kv_storage->flash_offset;
@@ -364,6 +374,8 @@ astarte_result_t astarte_kv_storage_delete(astarte_kv_storage_t *kv_storage, con
     }
 
 exit:
+    ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_KV_STORAGE_DELETES);
+    ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_KV_STORAGE, op_timer);
 
     // Unlock the mutex for the key-value storage
     mutex_rc = sys_mutex_unlock(&astarte_kv_storage_mutex);
@@ -428,7 +440,7 @@ astarte_result_t astarte_kv_storage_iterator_init(
             goto exit;
         }
 
-        free(namespace);
+        astarte_free(namespace);
         namespace = NULL;
     }
 
@@ -441,7 +453,7 @@ exit:
     ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
     __ASSERT_NO_MSG(mutex_rc == 0);
 
-    free(namespace);
+    astarte_free(namespace);
     return ares;
 }
 
@@ -490,7 +502,7 @@ astarte_result_t astarte_kv_storage_iterator_next(astarte_kv_storage_iter_t *ite
             goto exit;
         }
 
-        free(namespace);
+        astarte_free(namespace);
         namespace = NULL;
     }
 
@@ -503,7 +515,7 @@ exit:
     ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
     __ASSERT_NO_MSG(mutex_rc == 0);
 
-    free(namespace);
+    astarte_free(namespace);
     return ares;
 }
 
@@ -562,6 +574,60 @@ exit:
     return ares;
 }
 
+astarte_result_t astarte_kv_storage_iterator_realign(
+    astarte_kv_storage_iter_t *iter, const char *key)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    struct nvs_fs nvs_fs = { 0 };
+    uint16_t stored_pairs = 0U;
+    uint16_t base_id = 0U;
+
+    // Lock the mutex for the key-value storage
+    int mutex_rc = sys_mutex_lock(&astarte_kv_storage_mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+
+    nvs_fs.flash_device = iter->kv_storage->flash_device;
+    nvs_fs.offset = iter->kv_storage->flash_offset;
+    nvs_fs.sector_size = iter->kv_storage->flash_sector_size;
+    nvs_fs.sector_count = iter->kv_storage->flash_sector_count;
+    ASTARTE_LOG_DBG("Mounting NVS.");
+    int nvs_rc = nvs_mount(&nvs_fs);
+    if (nvs_rc) {
+        ASTARTE_LOG_ERR("NVS mount error: %s (%d).", strerror(-nvs_rc), nvs_rc);
+        ares = ASTARTE_RESULT_NVS_ERROR;
+        goto exit;
+    }
+
+    ASTARTE_LOG_DBG("Fetching the number of stored pairs.");
+    ares = get_stored_pairs(&nvs_fs, &stored_pairs);
+    if (ares != ASTARTE_RESULT_OK) {
+        ASTARTE_LOG_ERR("Get total stored pairs failed %s.", astarte_result_to_name(ares));
+        goto exit;
+    }
+
+    ASTARTE_LOG_DBG("Searching for the pair pointed by the iterator: '%s'.", key);
+    ares = find_pair_base_id(&nvs_fs, iter->kv_storage->namespace, stored_pairs, key, &base_id);
+    if (ares == ASTARTE_RESULT_OK) {
+        iter->current_pair = (base_id - 1) / NVS_ENTRIES_FOR_PAIR;
+        ASTARTE_LOG_DBG("Realigned iterator. Current pair: %d", iter->current_pair);
+    }
+
+exit:
+
+    // Unlock the mutex for the key-value storage
+    mutex_rc = sys_mutex_unlock(&astarte_kv_storage_mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+
+    // The pointed pair has been deleted, the pairs stored before it have not been shifted
+    if (ares == ASTARTE_RESULT_NOT_FOUND) {
+        ares = astarte_kv_storage_iterator_next(iter);
+    }
+
+    return ares;
+}
+
 /************************************************
  *         Static functions definitions         *
  ***********************************************/
@@ -640,11 +706,11 @@ static astarte_result_t find_pair_base_id(struct nvs_fs *nvs_fs, const char *nam
                 break;
             }
 
-            free(tmp_key);
+            astarte_free(tmp_key);
             tmp_key = NULL;
         }
 
-        free(tmp_namespace);
+        astarte_free(tmp_namespace);
         tmp_namespace = NULL;
     }
     if (!found) {
@@ -654,8 +720,8 @@ static astarte_result_t find_pair_base_id(struct nvs_fs *nvs_fs, const char *nam
     *base_id = (uint16_t) (1 + (pair_number * NVS_ENTRIES_FOR_PAIR));
 
 exit:
-    free(tmp_namespace);
-    free(tmp_key);
+    astarte_free(tmp_namespace);
+    astarte_free(tmp_key);
     return ares;
 }
 
@@ -701,9 +767,9 @@ static astarte_result_t relocate_pair(
     }
 
 exit:
-    free(namespace);
-    free(key);
-    free(value);
+    astarte_free(namespace);
+    astarte_free(key);
+    astarte_free(value);
 
     return ares;
 }
@@ -722,7 +788,7 @@ static astarte_result_t get_nvs_entry_with_alloc(
         goto error;
     }
 
-    buff = calloc(buff_size, sizeof(uint8_t));
+    buff = astarte_calloc(buff_size, sizeof(uint8_t));
     if (!buff) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -741,7 +807,7 @@ static astarte_result_t get_nvs_entry_with_alloc(
     return ASTARTE_RESULT_OK;
 
 error:
-    free(buff);
+    astarte_free(buff);
     return ares;
 }
 
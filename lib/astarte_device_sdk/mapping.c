@@ -18,6 +18,17 @@ ASTARTE_LOG_MODULE_REGISTER(astarte_mapping, CONFIG_ASTARTE_DEVICE_SDK_MAPPING_L
  *         Static functions declaration         *
  ***********************************************/
 
+/**
+ * @brief Check if a path corresponds to the first part of the endpoint of a mapping.
+ *
+ * @param[in] mapping Mapping to use for the comparison.
+ * @param[in] endpoint_len Length of the part of the endpoint to compare, should end at the end of
+ * a segment.
+ * @param[in] path Path to use for comparison.
+ * @return ASTARTE_RESULT_OK on success, otherwise an error code.
+ */
+static astarte_result_t check_path(
+    astarte_mapping_t mapping, size_t endpoint_len, const char *path);
 /**
  * @brief Check a single path segment against an endpoint segment.
  *
@@ -27,10 +38,20 @@ ASTARTE_LOG_MODULE_REGISTER(astarte_mapping, CONFIG_ASTARTE_DEVICE_SDK_MAPPING_L
  * @param[in] path_start The start of the path segment.
  * @param[in] path_end The end of the path segment. This points to the char after the last valid
  * char of the segment.
+ * @param[in] parametric True if the endpoint segment is a parameter.
  * @return True if the segments match, false otherwise.
  */
 static bool check_path_segment(const char *endpoint_start, const char *endpoint_end,
-    const char *path_start, const char *path_end);
+    const char *path_start, const char *path_end, bool parametric);
+/**
+ * @brief Check if an endpoint segment is a parameter.
+ *
+ * @param[in] endpoint_start The start of the endpoint segment.
+ * @param[in] endpoint_end The end of the endpoint segment. This points to the char after the last
+ * valid char of the segment.
+ * @return True if the segment is in the form `%{...}`, false otherwise.
+ */
+static bool is_parametric_segment(const char *endpoint_start, const char *endpoint_end);
 
 /************************************************
  *         Global functions definitions         *
@@ -71,14 +92,78 @@ astarte_result_t astarte_mapping_array_to_scalar_type(
 }
 
 astarte_result_t astarte_mapping_check_path(astarte_mapping_t mapping, const char *path)
+{
+    return check_path(mapping, strlen(mapping.endpoint), path);
+}
+
+astarte_result_t astarte_mapping_check_object_path(astarte_mapping_t mapping, const char *path)
+{
+    // The object path is the mapping endpoint without its last segment
+    const char *last_segment = strrchr(mapping.endpoint, '/');
+    if (!last_segment || (last_segment == mapping.endpoint)) {
+        return ASTARTE_RESULT_MAPPING_PATH_MISMATCH;
+    }
+    return check_path(mapping, last_segment - mapping.endpoint, path);
+}
+
+const char *astarte_mapping_get_object_key(astarte_mapping_t mapping)
+{
+    const char *last_segment = strrchr(mapping.endpoint, '/');
+    return (last_segment) ? last_segment + 1 : mapping.endpoint;
+}
+
+size_t astarte_mapping_count_path_segments(const char *path)
+{
+    size_t segments = 0;
+    for (const char *chr = strchr(path, '/'); chr; chr = strchr(chr + 1, '/')) {
+        segments++;
+    }
+    return segments;
+}
+
+astarte_result_t astarte_mapping_check_data(const astarte_mapping_t *mapping, astarte_data_t data)
+{
+    if (mapping->type != data.tag) {
+        ASTARTE_LOG_ERR("Astarte data type and mapping type do not match.");
+        return ASTARTE_RESULT_MAPPING_DATA_INCOMPATIBLE;
+    }
+
+    if ((mapping->type == ASTARTE_MAPPING_TYPE_DOUBLE) && (isfinite(data.data.dbl) == 0)) {
+        ASTARTE_LOG_ERR("Astarte data double is not a number.");
+        return ASTARTE_RESULT_MAPPING_DATA_INCOMPATIBLE;
+    }
+
+    if (mapping->type == ASTARTE_MAPPING_TYPE_DOUBLEARRAY) {
+        for (size_t i = 0; i < data.data.double_array.len; i++) {
+            if (isfinite(data.data.double_array.buf[i]) == 0) {
+                ASTARTE_LOG_ERR("Astarte data double is not a number.");
+                return ASTARTE_RESULT_MAPPING_DATA_INCOMPATIBLE;
+            }
+        }
+    }
+
+    return ASTARTE_RESULT_OK;
+}
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+static astarte_result_t check_path(
+    astarte_mapping_t mapping, size_t endpoint_len, const char *path)
 {
     // The endpoint is in the format "/segment1/%{param1}/%{param2}/segment2/segment3/..."
     const char *endpoint_segment_start = mapping.endpoint;
     const char *endpoint_segment_end = NULL;
+    const char *endpoint_end = mapping.endpoint + endpoint_len;
 
     const char *path_segment_start = path;
     const char *path_segment_end = NULL;
 
+    // Use the matcher precomputed by the interfaces generator when available
+    bool precomputed = (mapping.endpoint_segments != 0);
+    size_t segment_index = 0;
+
     // Check minimum path length
     size_t path_len = strlen(path);
     if (path_len < 2) {
@@ -100,24 +185,32 @@ astarte_result_t astarte_mapping_check_path(astarte_mapping_t mapping, const cha
     path_segment_start++;
 
     // Iterate over each segment
-    while ((*endpoint_segment_start != '\0') && (*path_segment_start != '\0')) {
+    while ((endpoint_segment_start < endpoint_end) && (*path_segment_start != '\0')) {
         endpoint_segment_end = strchr(endpoint_segment_start, '/');
-        if (endpoint_segment_end == NULL) {
-            endpoint_segment_end = endpoint_segment_start + strlen(endpoint_segment_start);
+        if ((endpoint_segment_end == NULL) || (endpoint_segment_end > endpoint_end)) {
+            endpoint_segment_end = endpoint_end;
         }
         path_segment_end = strchr(path_segment_start, '/');
         if (path_segment_end == NULL) {
             path_segment_end = path_segment_start + strlen(path_segment_start);
         }
 
+        bool parametric = false;
+        if (precomputed) {
+            parametric = (segment_index < 32U)
+                && ((mapping.endpoint_parameters & (1U << segment_index)) != 0U);
+        } else {
+            parametric = is_parametric_segment(endpoint_segment_start, endpoint_segment_end);
+        }
         if (!check_path_segment(endpoint_segment_start, endpoint_segment_end, path_segment_start,
-                path_segment_end)) {
+                path_segment_end, parametric)) {
             return ASTARTE_RESULT_MAPPING_PATH_MISMATCH;
         }
+        segment_index++;
 
         // Move to the start of the next segment
         endpoint_segment_start = endpoint_segment_end;
-        if (*endpoint_segment_start == '/') {
+        if ((endpoint_segment_start < endpoint_end) && (*endpoint_segment_start == '/')) {
             endpoint_segment_start++;
         }
         path_segment_start = path_segment_end;
@@ -126,48 +219,19 @@ astarte_result_t astarte_mapping_check_path(astarte_mapping_t mapping, const cha
         }
     }
 
-    if ((*endpoint_segment_start != '\0') || (*path_segment_start != '\0')) {
+    if ((endpoint_segment_start < endpoint_end) || (*path_segment_start != '\0')) {
         return ASTARTE_RESULT_MAPPING_PATH_MISMATCH;
     }
     return ASTARTE_RESULT_OK;
 }
 
-astarte_result_t astarte_mapping_check_data(const astarte_mapping_t *mapping, astarte_data_t data)
-{
-    if (mapping->type != data.tag) {
-        ASTARTE_LOG_ERR("Astarte data type and mapping type do not match.");
-        return ASTARTE_RESULT_MAPPING_DATA_INCOMPATIBLE;
-    }
-
-    if ((mapping->type == ASTARTE_MAPPING_TYPE_DOUBLE) && (isfinite(data.data.dbl) == 0)) {
-        ASTARTE_LOG_ERR("Astarte data double is not a number.");
-        return ASTARTE_RESULT_MAPPING_DATA_INCOMPATIBLE;
-    }
-
-    if (mapping->type == ASTARTE_MAPPING_TYPE_DOUBLEARRAY) {
-        for (size_t i = 0; i < data.data.double_array.len; i++) {
-            if (isfinite(data.data.double_array.buf[i]) == 0) {
-                ASTARTE_LOG_ERR("Astarte data double is not a number.");
-                return ASTARTE_RESULT_MAPPING_DATA_INCOMPATIBLE;
-            }
-        }
-    }
-
-    return ASTARTE_RESULT_OK;
-}
-
-/************************************************
- *         Static functions definitions         *
- ***********************************************/
-
 static bool check_path_segment(const char *endpoint_start, const char *endpoint_end,
-    const char *path_start, const char *path_end)
+    const char *path_start, const char *path_end, bool parametric)
 {
     size_t endpoint_segment_len = endpoint_end - endpoint_start;
     size_t path_segment_len = path_end - path_start;
     // The check will differ is the segment is a parameter or not
-    if ((strncmp(endpoint_start, "%{", 2) == 0)
-        && (endpoint_start[endpoint_segment_len - 1] == '}')) {
+    if (parametric) {
         if (path_segment_len == 0) {
             return false;
         }
@@ -182,3 +246,10 @@ static bool check_path_segment(const char *endpoint_start, const char *endpoint_
     }
     return true;
 }
+
+static bool is_parametric_segment(const char *endpoint_start, const char *endpoint_end)
+{
+    size_t endpoint_segment_len = endpoint_end - endpoint_start;
+    return (strncmp(endpoint_start, "%{", 2) == 0)
+        && (endpoint_start[endpoint_segment_len - 1] == '}');
+}
@@ -0,0 +1,372 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "astarte_device_sdk/metrics.h"
+#include "metrics_private.h"
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "astarte_device_sdk/interface.h"
+
+/************************************************
+ *        Defines, constants and typedef        *
+ ***********************************************/
+
+/** @brief Latency histogram, updated concurrently by the SDK modules. */
+struct histogram
+{
+    /** @brief Number of recorded samples */
+    atomic_t count;
+    /** @brief Sum of the recorded samples in microseconds */
+    atomic_t sum_us;
+    /** @brief Longest recorded sample in microseconds */
+    atomic_t max_us;
+    /** @brief Number of samples in each bucket */
+    atomic_t buckets[ASTARTE_METRICS_HISTOGRAM_BUCKETS];
+};
+
+/** @brief Traffic of a single interface. */
+struct interface_traffic
+{
+    /** @brief Interface name, written once before the entry is published */
+    char name[ASTARTE_INTERFACE_NAME_MAX_SIZE];
+    /** @brief Data messages transmitted on the interface */
+    atomic_t messages_sent;
+    /** @brief Payload bytes transmitted on the interface */
+    atomic_t bytes_sent;
+    /** @brief Data messages received on the interface */
+    atomic_t messages_received;
+    /** @brief Payload bytes received on the interface */
+    atomic_t bytes_received;
+};
+
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+static atomic_t counters[ASTARTE_METRICS_COUNTER_COUNT];
+static atomic_t gauges[ASTARTE_METRICS_GAUGE_COUNT];
+static struct histogram histograms[ASTARTE_METRICS_HISTOGRAM_COUNT];
+
+static struct interface_traffic
+    tracked_interfaces[CONFIG_ASTARTE_DEVICE_SDK_METRICS_MAX_INTERFACES];
+/** @brief Number of published entries of #tracked_interfaces, entries are never removed. */
+static atomic_t tracked_interfaces_len;
+/** @brief Serializes the registration of new interfaces, lookups are lock free. */
+static struct k_spinlock interfaces_lock;
+
+static const char *const counter_names[ASTARTE_METRICS_COUNTER_COUNT] = {
+    [ASTARTE_METRICS_COUNTER_MESSAGES_SENT] = "MESSAGES_SENT",
+    [ASTARTE_METRICS_COUNTER_BYTES_SENT] = "BYTES_SENT",
+    [ASTARTE_METRICS_COUNTER_MESSAGES_RECEIVED] = "MESSAGES_RECEIVED",
+    [ASTARTE_METRICS_COUNTER_BYTES_RECEIVED] = "BYTES_RECEIVED",
+    [ASTARTE_METRICS_COUNTER_PUBLISH_QOS0] = "PUBLISH_QOS0",
+    [ASTARTE_METRICS_COUNTER_PUBLISH_QOS1] = "PUBLISH_QOS1",
+    [ASTARTE_METRICS_COUNTER_PUBLISH_QOS2] = "PUBLISH_QOS2",
+    [ASTARTE_METRICS_COUNTER_RETRANSMISSIONS] = "RETRANSMISSIONS",
+    [ASTARTE_METRICS_COUNTER_DROPS] = "DROPS",
+    [ASTARTE_METRICS_COUNTER_RECONNECTS] = "RECONNECTS",
+    [ASTARTE_METRICS_COUNTER_KV_STORAGE_READS] = "KV_STORAGE_READS",
+    [ASTARTE_METRICS_COUNTER_KV_STORAGE_WRITES] = "KV_STORAGE_WRITES",
+    [ASTARTE_METRICS_COUNTER_KV_STORAGE_DELETES] = "KV_STORAGE_DELETES",
+    [ASTARTE_METRICS_COUNTER_PROPERTIES_SUPPRESSED] = "PROPERTIES_SUPPRESSED",
+    [ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED] = "DATASTREAMS_FILTERED",
+};
+
+static const char *const gauge_names[ASTARTE_METRICS_GAUGE_COUNT] = {
+    [ASTARTE_METRICS_GAUGE_IN_FLIGHT] = "IN_FLIGHT",
+};
+
+static const char *const histogram_names[ASTARTE_METRICS_HISTOGRAM_COUNT] = {
+    [ASTARTE_METRICS_HISTOGRAM_HANDSHAKE] = "HANDSHAKE",
+    [ASTARTE_METRICS_HISTOGRAM_MQTT_POLL] = "MQTT_POLL",
+    [ASTARTE_METRICS_HISTOGRAM_KV_STORAGE] = "KV_STORAGE",
+    [ASTARTE_METRICS_HISTOGRAM_BSON_ENCODE] = "BSON_ENCODE",
+    [ASTARTE_METRICS_HISTOGRAM_BSON_DECODE] = "BSON_DECODE",
+};
+
+/************************************************
+ *         Static functions declaration         *
+ ***********************************************/
+
+/**
+ * @brief Get the traffic entry of an interface, registering the interface if required.
+ *
+ * @param[in] interface_name Name of the interface.
+ * @return The traffic entry, NULL if the table of the tracked interfaces is full.
+ */
+static struct interface_traffic *get_interface_traffic(const char *interface_name);
+
+/************************************************
+ *     Global public functions definitions      *
+ ***********************************************/
+
+uint32_t astarte_metrics_get_counter(astarte_metrics_counter_t counter)
+{
+    if ((unsigned int) counter >= ASTARTE_METRICS_COUNTER_COUNT) {
+        return 0;
+    }
+    return (uint32_t) atomic_get(&counters[counter]);
+}
+
+int32_t astarte_metrics_get_gauge(astarte_metrics_gauge_t gauge)
+{
+    if ((unsigned int) gauge >= ASTARTE_METRICS_GAUGE_COUNT) {
+        return 0;
+    }
+    return (int32_t) atomic_get(&gauges[gauge]);
+}
+
+void astarte_metrics_get_histogram(
+    astarte_metrics_histogram_t histogram, astarte_metrics_histogram_data_t *data)
+{
+    memset(data, 0, sizeof(astarte_metrics_histogram_data_t));
+    if ((unsigned int) histogram >= ASTARTE_METRICS_HISTOGRAM_COUNT) {
+        return;
+    }
+
+    struct histogram *hist = &histograms[histogram];
+    data->count = (uint32_t) atomic_get(&hist->count);
+    data->sum_us = (uint32_t) atomic_get(&hist->sum_us);
+    data->max_us = (uint32_t) atomic_get(&hist->max_us);
+    for (size_t i = 0; i < ASTARTE_METRICS_HISTOGRAM_BUCKETS; i++) {
+        data->buckets[i] = (uint32_t) atomic_get(&hist->buckets[i]);
+    }
+}
+
+size_t astarte_metrics_get_interfaces(
+    astarte_metrics_interface_t *interfaces, size_t interfaces_len)
+{
+    size_t tracked = (size_t) atomic_get(&tracked_interfaces_len);
+    for (size_t i = 0; i < MIN(tracked, interfaces_len); i++) {
+        interfaces[i].name = tracked_interfaces[i].name;
+        interfaces[i].messages_sent = (uint32_t) atomic_get(&tracked_interfaces[i].messages_sent);
+        interfaces[i].bytes_sent = (uint32_t) atomic_get(&tracked_interfaces[i].bytes_sent);
+        interfaces[i].messages_received
+            = (uint32_t) atomic_get(&tracked_interfaces[i].messages_received);
+        interfaces[i].bytes_received = (uint32_t) atomic_get(&tracked_interfaces[i].bytes_received);
+    }
+    return tracked;
+}
+
+void astarte_metrics_reset(void)
+{
+    for (size_t i = 0; i < ASTARTE_METRICS_COUNTER_COUNT; i++) {
+        atomic_clear(&counters[i]);
+    }
+
+    for (size_t i = 0; i < ASTARTE_METRICS_HISTOGRAM_COUNT; i++) {
+        atomic_clear(&histograms[i].count);
+        atomic_clear(&histograms[i].sum_us);
+        atomic_clear(&histograms[i].max_us);
+        for (size_t j = 0; j < ASTARTE_METRICS_HISTOGRAM_BUCKETS; j++) {
+            atomic_clear(&histograms[i].buckets[j]);
+        }
+    }
+
+    size_t tracked = (size_t) atomic_get(&tracked_interfaces_len);
+    for (size_t i = 0; i < tracked; i++) {
+        atomic_clear(&tracked_interfaces[i].messages_sent);
+        atomic_clear(&tracked_interfaces[i].bytes_sent);
+        atomic_clear(&tracked_interfaces[i].messages_received);
+        atomic_clear(&tracked_interfaces[i].bytes_received);
+    }
+}
+
+const char *astarte_metrics_counter_to_name(astarte_metrics_counter_t counter)
+{
+    if ((unsigned int) counter >= ASTARTE_METRICS_COUNTER_COUNT) {
+        return "UNKNOWN";
+    }
+    return counter_names[counter];
+}
+
+const char *astarte_metrics_gauge_to_name(astarte_metrics_gauge_t gauge)
+{
+    if ((unsigned int) gauge >= ASTARTE_METRICS_GAUGE_COUNT) {
+        return "UNKNOWN";
+    }
+    return gauge_names[gauge];
+}
+
+const char *astarte_metrics_histogram_to_name(astarte_metrics_histogram_t histogram)
+{
+    if ((unsigned int) histogram >= ASTARTE_METRICS_HISTOGRAM_COUNT) {
+        return "UNKNOWN";
+    }
+    return histogram_names[histogram];
+}
+
+/************************************************
+ *     Global private functions definitions     *
+ ***********************************************/
+
+void astarte_metrics_counter_add(astarte_metrics_counter_t counter, uint32_t value)
+{
+    __ASSERT_NO_MSG((unsigned int) counter < ASTARTE_METRICS_COUNTER_COUNT);
+    atomic_add(&counters[counter], (atomic_val_t) value);
+}
+
+void astarte_metrics_gauge_add(astarte_metrics_gauge_t gauge, int32_t delta)
+{
+    __ASSERT_NO_MSG((unsigned int) gauge < ASTARTE_METRICS_GAUGE_COUNT);
+    atomic_add(&gauges[gauge], (atomic_val_t) delta);
+}
+
+void astarte_metrics_histogram_record(astarte_metrics_histogram_t histogram, uint32_t sample_us)
+{
+    __ASSERT_NO_MSG((unsigned int) histogram < ASTARTE_METRICS_HISTOGRAM_COUNT);
+    struct histogram *hist = &histograms[histogram];
+
+    // Bucket N holds the samples in [2^(N-1), 2^N), the last one also holds all longer samples
+    size_t bucket = 32U - u32_count_leading_zeros(sample_us);
+    bucket = MIN(bucket, ASTARTE_METRICS_HISTOGRAM_BUCKETS - 1);
+
+    atomic_inc(&hist->count);
+    atomic_add(&hist->sum_us, (atomic_val_t) sample_us);
+    atomic_inc(&hist->buckets[bucket]);
+
+    atomic_val_t max_us = atomic_get(&hist->max_us);
+    while ((sample_us > (uint32_t) max_us)
+        && !atomic_cas(&hist->max_us, max_us, (atomic_val_t) sample_us)) {
+        max_us = atomic_get(&hist->max_us);
+    }
+}
+
+void astarte_metrics_interface_sent(const char *interface_name, size_t bytes)
+{
+    atomic_inc(&counters[ASTARTE_METRICS_COUNTER_MESSAGES_SENT]);
+    atomic_add(&counters[ASTARTE_METRICS_COUNTER_BYTES_SENT], (atomic_val_t) bytes);
+
+    struct interface_traffic *traffic = get_interface_traffic(interface_name);
+    if (traffic) {
+        atomic_inc(&traffic->messages_sent);
+        atomic_add(&traffic->bytes_sent, (atomic_val_t) bytes);
+    }
+}
+
+void astarte_metrics_interface_received(const char *interface_name, size_t bytes)
+{
+    atomic_inc(&counters[ASTARTE_METRICS_COUNTER_MESSAGES_RECEIVED]);
+    atomic_add(&counters[ASTARTE_METRICS_COUNTER_BYTES_RECEIVED], (atomic_val_t) bytes);
+
+    struct interface_traffic *traffic = get_interface_traffic(interface_name);
+    if (traffic) {
+        atomic_inc(&traffic->messages_received);
+        atomic_add(&traffic->bytes_received, (atomic_val_t) bytes);
+    }
+}
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+static struct interface_traffic *get_interface_traffic(const char *interface_name)
+{
+    size_t tracked = (size_t) atomic_get(&tracked_interfaces_len);
+    for (size_t i = 0; i < tracked; i++) {
+        if (strcmp(tracked_interfaces[i].name, interface_name) == 0) {
+            return &tracked_interfaces[i];
+        }
+    }
+
+    if ((tracked == ARRAY_SIZE(tracked_interfaces))
+        || (strlen(interface_name) >= ASTARTE_INTERFACE_NAME_MAX_SIZE)) {
+        return NULL;
+    }
+
+    struct interface_traffic *traffic = NULL;
+    k_spinlock_key_t key = k_spin_lock(&interfaces_lock);
+    // Another thread could have registered new interfaces since the lookup
+    size_t registered = (size_t) atomic_get(&tracked_interfaces_len);
+    for (size_t i = tracked; i < registered; i++) {
+        if (strcmp(tracked_interfaces[i].name, interface_name) == 0) {
+            traffic = &tracked_interfaces[i];
+            break;
+        }
+    }
+    if (!traffic && (registered < ARRAY_SIZE(tracked_interfaces))) {
+        traffic = &tracked_interfaces[registered];
+        strcpy(traffic->name, interface_name);
+        // Publish the entry only once its name has been written
+        atomic_inc(&tracked_interfaces_len);
+    }
+    k_spin_unlock(&interfaces_lock, key);
+
+    return traffic;
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS_SHELL)
+
+static int cmd_metrics_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "Counters:");
+    for (size_t i = 0; i < ASTARTE_METRICS_COUNTER_COUNT; i++) {
+        shell_print(sh, "  %-20s %u", counter_names[i], astarte_metrics_get_counter(i));
+    }
+
+    shell_print(sh, "Gauges:");
+    for (size_t i = 0; i < ASTARTE_METRICS_GAUGE_COUNT; i++) {
+        shell_print(sh, "  %-20s %d", gauge_names[i], astarte_metrics_get_gauge(i));
+    }
+
+    shell_print(sh, "Histograms (us):");
+    for (size_t i = 0; i < ASTARTE_METRICS_HISTOGRAM_COUNT; i++) {
+        astarte_metrics_histogram_data_t data = { 0 };
+        astarte_metrics_get_histogram(i, &data);
+        shell_print(sh, "  %-20s count %u avg %u max %u", histogram_names[i], data.count,
+            (data.count > 0) ? data.sum_us / data.count : 0, data.max_us);
+        for (size_t j = 0; j < ASTARTE_METRICS_HISTOGRAM_BUCKETS; j++) {
+            if (data.buckets[j] > 0) {
+                shell_print(sh, "    < %-10u %u", (uint32_t) BIT64(j), data.buckets[j]);
+            }
+        }
+    }
+
+    shell_print(sh, "Interfaces (messages/bytes sent, messages/bytes received):");
+    size_t tracked = (size_t) atomic_get(&tracked_interfaces_len);
+    for (size_t i = 0; i < tracked; i++) {
+        shell_print(sh, "  %s %u/%u %u/%u", tracked_interfaces[i].name,
+            (uint32_t) atomic_get(&tracked_interfaces[i].messages_sent),
+            (uint32_t) atomic_get(&tracked_interfaces[i].bytes_sent),
+            (uint32_t) atomic_get(&tracked_interfaces[i].messages_received),
+            (uint32_t) atomic_get(&tracked_interfaces[i].bytes_received));
+    }
+
+    return 0;
+}
+
+static int cmd_metrics_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    astarte_metrics_reset();
+    shell_print(sh, "Metrics reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(astarte_metrics_cmds,
+    SHELL_CMD(show, NULL, "Print the Astarte device SDK metrics.", cmd_metrics_show),
+    SHELL_CMD(reset, NULL, "Reset the Astarte device SDK counters and histograms.",
+        cmd_metrics_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(astarte_metrics, &astarte_metrics_cmds, "Astarte device SDK metrics", NULL);
+
+#endif /* defined(CONFIG_ASTARTE_DEVICE_SDK_METRICS_SHELL) */
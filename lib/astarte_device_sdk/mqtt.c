@@ -9,9 +9,13 @@
 #include <zephyr/net/socket.h>
 #include <zephyr/net/tls_credentials.h>
 
+#include "heap_private.h"
 #include "log.h"
+#include "metrics_private.h"
+#include "tracing_private.h"
 
 ASTARTE_LOG_MODULE_REGISTER(astarte_mqtt, CONFIG_ASTARTE_DEVICE_SDK_MQTT_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_MQTT);
 
 /************************************************
  *       Checks over configuration values       *
@@ -21,10 +25,70 @@ ASTARTE_LOG_MODULE_REGISTER(astarte_mqtt, CONFIG_ASTARTE_DEVICE_SDK_MQTT_LOG_LEV
 #warning "TLS has been disabled (unsafe)!"
 #endif /* defined(CONFIG_ASTARTE_DEVICE_SDK_DEVELOP_USE_NON_TLS_MQTT) */
 
+/************************************************
+ *        Defines, constants and typedef        *
+ ***********************************************/
+
+/** @brief Size of the stack buffer used to drain the payloads of discarded incoming messages. */
+#define RX_DRAIN_BUFFER_SIZE 64U
+/** @brief Space reserved by the MQTT library for the fixed header of an outgoing packet. */
+#define SUBSCRIBE_FIXED_HEADER_SIZE 5U
+/** @brief Size of the message ID of a SUBSCRIBE packet. */
+#define SUBSCRIBE_MESSAGE_ID_SIZE 2U
+/** @brief Size of the length prefix and of the requested QoS of a topic filter. */
+#define SUBSCRIBE_TOPIC_OVERHEAD 3U
+
 /************************************************
  *         Static functions declaration         *
  ***********************************************/
 
+/**
+ * @brief Lock one of the mutexes of the client.
+ *
+ * @param[inout] mutex Mutex to lock.
+ */
+static void lock_mutex(struct sys_mutex *mutex);
+/**
+ * @brief Unlock one of the mutexes of the client.
+ *
+ * @param[inout] mutex Mutex to unlock.
+ */
+static void unlock_mutex(struct sys_mutex *mutex);
+/**
+ * @brief Allocator for the caching hashmaps, routing their allocations to the SDK heap.
+ *
+ * @param[in] ptr Memory to resize, NULL to allocate new memory.
+ * @param[in] new_size New size of the memory, zero to free it.
+ * @return The resized memory, NULL on failure or when the memory has been freed.
+ */
+static void *hashmap_alloc(void *ptr, size_t new_size);
+/**
+ * @brief Check if the client is idle, meaning a new connection can be requested.
+ *
+ * @note This function should be called with the state mutex locked.
+ *
+ * @param[in] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @return True if the client is disconnected or in the connection error state, false otherwise.
+ */
+static bool is_idle(astarte_mqtt_t *astarte_mqtt);
+/**
+ * @brief Check the reconnection timepoint, updating it to the next backoff value when elapsed.
+ *
+ * @note This function should be called with the state mutex locked.
+ *
+ * @param[inout] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @return True if a reconnection should be attempted, false otherwise.
+ */
+static bool check_reconnection_timepoint(astarte_mqtt_t *astarte_mqtt);
+/**
+ * @brief Check the connection timepoint, updating the connection state.
+ *
+ * @note This function should be called with the RX and state mutexes locked.
+ *
+ * @param[inout] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @return True if the client socket should be polled, false otherwise.
+ */
+static bool check_connection_timepoints(astarte_mqtt_t *astarte_mqtt);
 /**
  * @brief Handle a CONNACK reception event.
  *
@@ -45,6 +109,41 @@ static void handle_disconnection_event(astarte_mqtt_t *astarte_mqtt);
  * @param[in] publish Received PUBLISH data in the MQTT client format.
  */
 static void handle_publish_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_publish_param publish);
+/**
+ * @brief Read the payload of a received PUBLISH.
+ *
+ * @details When the payload fits in CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE it is read in the
+ * reusable reception buffer. Larger payloads are delivered in chunks through the incoming chunk
+ * callback. Payloads that should not be delivered are drained from the socket and discarded.
+ *
+ * @param[in] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @param[in] topic Topic of the received PUBLISH, NULL terminated.
+ * @param[in] topic_len Length of the topic.
+ * @param[in] payload_len Length of the payload of the received PUBLISH.
+ * @param[in] deliver True if the payload should be delivered, false if it should be discarded.
+ * @param[out] payload Set to the complete payload if it should be delivered in a single piece,
+ * NULL otherwise.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t read_publish_payload(astarte_mqtt_t *astarte_mqtt, const char *topic,
+    size_t topic_len, size_t payload_len, bool deliver, uint8_t **payload);
+/**
+ * @brief Get the reusable reception buffer, growing it when required.
+ *
+ * @param[in] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @param[in] size Minimum required size for the buffer.
+ * @return The reception buffer, NULL when out of memory.
+ */
+static uint8_t *get_rx_payload_buffer(astarte_mqtt_t *astarte_mqtt, size_t size);
+/**
+ * @brief Compute the next timepoint at which the MQTT client should be polled.
+ *
+ * @note This function should be called with the state and TX mutexes locked.
+ *
+ * @param[in] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @return The timepoint for the next deadline, in the infinite future if none is present.
+ */
+static k_timepoint_t get_next_deadline(astarte_mqtt_t *astarte_mqtt);
 /**
  * @brief Handle a PUBREL reception event.
  *
@@ -73,6 +172,19 @@ static void handle_pubrec_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_pubrec
  * @param[in] pubcomp Received PUBCOMP data in the MQTT client format.
  */
 static void handle_pubcomp_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_pubcomp_param pubcomp);
+/**
+ * @brief Transmit a SUBSCRIBE packet for one or more topics.
+ *
+ * @note This function should be called with the TX mutex locked.
+ *
+ * @param[in] astarte_mqtt Handle to the Astarte MQTT client instance.
+ * @param[in] message_id Message ID to use for the SUBSCRIBE packet.
+ * @param[in] topics Buffer containing @p topics_count NUL separated topics.
+ * @param[in] topics_count Number of topics contained in @p topics.
+ * @param[in] max_qos Maximum QoS level at which the server can send application messages.
+ */
+static void send_subscribe(astarte_mqtt_t *astarte_mqtt, uint16_t message_id, const char *topics,
+    size_t topics_count, int max_qos);
 /**
  * @brief Handle a SUBACK reception event.
  *
@@ -89,12 +201,16 @@ static void mqtt_evt_handler(struct mqtt_client *const client, const struct mqtt
 {
     astarte_mqtt_t *astarte_mqtt = CONTAINER_OF(client, astarte_mqtt_t, client);
 
-    if ((astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTING)
-        && (evt->type != MQTT_EVT_CONNACK) && (evt->type != MQTT_EVT_DISCONNECT)) {
+    lock_mutex(&astarte_mqtt->state_mutex);
+    astarte_mqtt_connection_states_t connection_state = astarte_mqtt->connection_state;
+    unlock_mutex(&astarte_mqtt->state_mutex);
+
+    if ((connection_state == ASTARTE_MQTT_CONNECTING) && (evt->type != MQTT_EVT_CONNACK)
+        && (evt->type != MQTT_EVT_DISCONNECT)) {
         ASTARTE_LOG_ERR("Received MQTT packet before CONNACK during connection.");
         return;
     }
-    if ((astarte_mqtt->connection_state == ASTARTE_MQTT_DISCONNECTING)
+    if ((connection_state == ASTARTE_MQTT_DISCONNECTING)
         && (evt->type != MQTT_EVT_DISCONNECT)) {
         ASTARTE_LOG_ERR("Received MQTT packet before disconnection event during disconnection.");
         return;
@@ -180,8 +296,8 @@ static void mqtt_caching_retransmit_out_msg_handler(
             msg.message.topic.topic.utf8 = message.topic;
             msg.message.topic.topic.size = strlen(message.topic);
             msg.message.topic.qos = message.qos;
-            msg.message.payload.data = message.data;
-            msg.message.payload.len = message.data_size;
+            msg.message.payload.data = (message.payload) ? message.payload->data : NULL;
+            msg.message.payload.len = (message.payload) ? message.payload->size : 0;
             msg.message_id = message_id;
             msg.dup_flag = 1U;
             ret = mqtt_publish(&astarte_mqtt->client, &msg);
@@ -189,27 +305,16 @@ static void mqtt_caching_retransmit_out_msg_handler(
                 ASTARTE_LOG_ERR("MQTT publish failed (message ID %d), err: %d", message_id, ret);
             } else {
                 ASTARTE_LOG_DBG("PUBLISHED on topic \"%s\" [ id: %u qos: %u ], payload: %u B",
-                    message.topic, msg.message_id, msg.message.topic.qos, message.data_size);
-                ASTARTE_LOG_HEXDUMP_DBG(message.data, message.data_size, "Published payload:");
+                    message.topic, msg.message_id, msg.message.topic.qos,
+                    msg.message.payload.len);
+                ASTARTE_LOG_HEXDUMP_DBG(
+                    msg.message.payload.data, msg.message.payload.len, "Published payload:");
             }
             break;
         case MQTT_CACHING_SUBSCRIPTION_ENTRY:
             ASTARTE_LOG_DBG("Retransmitting MQTT subscribe message: %d", message_id);
-            struct mqtt_topic topics[] = { {
-                .topic = { .utf8 = message.topic, .size = strlen(message.topic) },
-                .qos = message.qos,
-            } };
-            const struct mqtt_subscription_list ctrl_sub_list = {
-                .list = topics,
-                .list_count = ARRAY_SIZE(topics),
-                .message_id = message_id,
-            };
-            int ret = mqtt_subscribe(&astarte_mqtt->client, &ctrl_sub_list);
-            if (ret != 0) {
-                ASTARTE_LOG_ERR("MQTT subscription failed: %s, %d", strerror(-ret), ret);
-            } else {
-                ASTARTE_LOG_DBG("SUBSCRIBED to %s", message.topic);
-            }
+            send_subscribe(astarte_mqtt, message_id, message.topic, MAX(message.topic_count, 1),
+                message.qos);
             break;
 
         default:
@@ -253,6 +358,7 @@ astarte_result_t astarte_mqtt_init(astarte_mqtt_config_t *cfg, astarte_mqtt_t *a
     astarte_mqtt->on_connected_cbk = cfg->on_connected_cbk;
     astarte_mqtt->on_disconnected_cbk = cfg->on_disconnected_cbk;
     astarte_mqtt->on_incoming_cbk = cfg->on_incoming_cbk;
+    astarte_mqtt->on_incoming_chunk_cbk = cfg->on_incoming_chunk_cbk;
 
     // Initialize the timepoint to an infinite future date
     astarte_mqtt->connection_timepoint = sys_timepoint_calc(K_FOREVER);
@@ -275,7 +381,7 @@ astarte_result_t astarte_mqtt_init(astarte_mqtt_config_t *cfg, astarte_mqtt_t *a
         .config = &astarte_mqtt->out_msg_map_config,
         .data = &astarte_mqtt->out_msg_map_data,
         .hash_func = sys_hash32,
-        .alloc_func = SYS_HASHMAP_DEFAULT_ALLOCATOR,
+        .alloc_func = hashmap_alloc,
     };
     // NOLINTNEXTLINE
     astarte_mqtt->in_msg_map_config = (const struct sys_hashmap_config) SYS_HASHMAP_CONFIG(
@@ -286,37 +392,59 @@ astarte_result_t astarte_mqtt_init(astarte_mqtt_config_t *cfg, astarte_mqtt_t *a
         .config = &astarte_mqtt->in_msg_map_config,
         .data = &astarte_mqtt->in_msg_map_data,
         .hash_func = sys_hash32,
-        .alloc_func = SYS_HASHMAP_DEFAULT_ALLOCATOR,
+        .alloc_func = hashmap_alloc,
     };
 
-    // Initialize the mutex
-    sys_mutex_init(&astarte_mqtt->mutex);
+    // Initialize the mutexes
+    sys_mutex_init(&astarte_mqtt->rx_mutex);
+    sys_mutex_init(&astarte_mqtt->state_mutex);
+    sys_mutex_init(&astarte_mqtt->tx_mutex);
 
     return ASTARTE_RESULT_OK;
 }
 
+void astarte_mqtt_destroy(astarte_mqtt_t *astarte_mqtt)
+{
+    astarte_mqtt_clear_all_pending(astarte_mqtt);
+    astarte_free(astarte_mqtt->rx_payload_buffer);
+    astarte_mqtt->rx_payload_buffer = NULL;
+    astarte_mqtt->rx_payload_buffer_size = 0;
+}
+
 astarte_result_t astarte_mqtt_connect(astarte_mqtt_t *astarte_mqtt)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
     struct zsock_addrinfo *broker_addrinfo = NULL;
 
-    // Lock the mutex for the Astarte MQTT wrapper
-    int mutex_rc = sys_mutex_lock(&astarte_mqtt->mutex, K_FOREVER);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    lock_mutex(&astarte_mqtt->state_mutex);
+    bool idle = is_idle(astarte_mqtt);
+    bool tls_rejected = astarte_mqtt->tls_rejected;
+    unlock_mutex(&astarte_mqtt->state_mutex);
 
-    if ((astarte_mqtt->connection_state != ASTARTE_MQTT_DISCONNECTED)
-        && (astarte_mqtt->connection_state != ASTARTE_MQTT_CONNECTION_ERROR)) {
+    if (!idle) {
         ASTARTE_LOG_ERR("Connection request while the client is non idle will be ignored.");
-        ares = ASTARTE_RESULT_MQTT_CLIENT_NOT_READY;
-        goto exit;
+        return ASTARTE_RESULT_MQTT_CLIENT_NOT_READY;
     }
 
-    ares = astarte_mqtt->refresh_client_cert_cbk(astarte_mqtt);
+    // Refreshing the certificate can perform HTTPS requests, no client mutex should be held
+    ares = astarte_mqtt->refresh_client_cert_cbk(astarte_mqtt, tls_rejected);
     if (ares != ASTARTE_RESULT_OK) {
         ASTARTE_LOG_ERR("Refreshing client certificate failed");
+        return ares;
+    }
+
+    // The client gets reinitialized, no other operation can be performed on it concurrently
+    lock_mutex(&astarte_mqtt->rx_mutex);
+    lock_mutex(&astarte_mqtt->state_mutex);
+    lock_mutex(&astarte_mqtt->tx_mutex);
+
+    // Another connection might have been requested while refreshing the certificate
+    if (!is_idle(astarte_mqtt)) {
+        ASTARTE_LOG_ERR("Connection request while the client is non idle will be ignored.");
+        ares = ASTARTE_RESULT_MQTT_CLIENT_NOT_READY;
         goto exit;
     }
+    astarte_mqtt->tls_rejected = false;
 
     // Get broker address info
     struct zsock_addrinfo hints = { 0 };
@@ -363,6 +491,11 @@ astarte_result_t astarte_mqtt_connect(astarte_mqtt_t *astarte_mqtt)
     tls_config->sec_tag_list = sec_tag_list;
     tls_config->sec_tag_count = ARRAY_SIZE(sec_tag_list);
     tls_config->hostname = astarte_mqtt->broker_hostname;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TLS_SESSION_RESUMPTION)
+    tls_config->session_cache = TLS_SESSION_CACHE_ENABLED;
+#else
+    tls_config->session_cache = TLS_SESSION_CACHE_DISABLED;
+#endif
 
     // MQTT buffers configuration
     astarte_mqtt->client.rx_buf = astarte_mqtt->rx_buffer;
@@ -374,6 +507,8 @@ astarte_result_t astarte_mqtt_connect(astarte_mqtt_t *astarte_mqtt)
     int mqtt_rc = mqtt_connect(&astarte_mqtt->client);
     if (mqtt_rc != 0) {
         ASTARTE_LOG_ERR("MQTT connection error (%d)", mqtt_rc);
+        // TLS handshake failures are reported by the socket layer as aborted connections
+        astarte_mqtt->tls_rejected = (mqtt_rc == -ECONNABORTED);
         ares = ASTARTE_RESULT_MQTT_ERROR;
         goto exit;
     }
@@ -390,26 +525,26 @@ exit:
     if (broker_addrinfo) {
         zsock_freeaddrinfo(broker_addrinfo);
     }
-    // Unlock the mutex
-    mutex_rc = sys_mutex_unlock(&astarte_mqtt->mutex);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
+    unlock_mutex(&astarte_mqtt->state_mutex);
+    unlock_mutex(&astarte_mqtt->rx_mutex);
     return ares;
 }
 
 bool astarte_mqtt_is_connected(astarte_mqtt_t *astarte_mqtt)
 {
-    return astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTED;
+    lock_mutex(&astarte_mqtt->state_mutex);
+    bool res = (astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTED);
+    unlock_mutex(&astarte_mqtt->state_mutex);
+    return res;
 }
 
 astarte_result_t astarte_mqtt_disconnect(astarte_mqtt_t *astarte_mqtt)
 {
     astarte_result_t ares = ASTARTE_RESULT_OK;
 
-    // Lock the mutex for the Astarte MQTT wrapper
-    int mutex_rc = sys_mutex_lock(&astarte_mqtt->mutex, K_FOREVER);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    // Lock the connection state of the client
+    lock_mutex(&astarte_mqtt->state_mutex);
 
     switch (astarte_mqtt->connection_state) {
         case ASTARTE_MQTT_CONNECTION_ERROR:
@@ -437,66 +572,122 @@ astarte_result_t astarte_mqtt_disconnect(astarte_mqtt_t *astarte_mqtt)
     astarte_mqtt->connection_state = ASTARTE_MQTT_DISCONNECTING;
 
 exit:
-    // Unlock the mutex
-    mutex_rc = sys_mutex_unlock(&astarte_mqtt->mutex);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    unlock_mutex(&astarte_mqtt->state_mutex);
     return ares;
 }
 
 void astarte_mqtt_subscribe(
     astarte_mqtt_t *astarte_mqtt, const char *topic, int max_qos, uint16_t *out_message_id)
 {
-    // Lock the mutex for the Astarte MQTT wrapper
-    int mutex_rc = sys_mutex_lock(&astarte_mqtt->mutex, K_FOREVER);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    astarte_mqtt_subscribe_multiple(astarte_mqtt, &topic, 1, max_qos, out_message_id);
+}
+
+size_t astarte_mqtt_subscribe_multiple(astarte_mqtt_t *astarte_mqtt, const char *const *topics,
+    size_t topics_count, int max_qos, uint16_t *out_message_id)
+{
+    if (topics_count == 0) {
+        return 0;
+    }
+
+    // Only the leading topics fitting in the transmission buffer are added to the packet, a topic
+    // too long to fit alone is still sent in its own packet
+    size_t packet_size = SUBSCRIBE_FIXED_HEADER_SIZE + SUBSCRIBE_MESSAGE_ID_SIZE;
+    size_t packed_size = 0U;
+    size_t fitting_count = 0U;
+    while (fitting_count < topics_count) {
+        size_t topic_len = strlen(topics[fitting_count]);
+        size_t topic_size = topic_len + SUBSCRIBE_TOPIC_OVERHEAD;
+        if ((fitting_count > 0) && (packet_size + topic_size > ASTARTE_MQTT_TX_BUFFER_SIZE)) {
+            break;
+        }
+        packet_size += topic_size;
+        packed_size += topic_len + 1;
+        fitting_count++;
+    }
+    if (packet_size > ASTARTE_MQTT_TX_BUFFER_SIZE) {
+        ASTARTE_LOG_ERR("Topic filter too long for the MQTT TX buffer: %s", topics[0]);
+    }
+    topics_count = fitting_count;
+
+    // Pack the topics in a single buffer, the same format used by the retransmission cache
+    char *packed = astarte_calloc(packed_size, sizeof(char));
+    if (!packed) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return 0;
+    }
+    char *packed_end = packed;
+    for (size_t i = 0; i < topics_count; i++) {
+        size_t topic_size = strlen(topics[i]) + 1;
+        memcpy(packed_end, topics[i], topic_size);
+        packed_end += topic_size;
+    }
+
+    // Lock the transmission path of the client
+    lock_mutex(&astarte_mqtt->tx_mutex);
 
     uint16_t message_id = mqtt_caching_get_available_message_id(&astarte_mqtt->out_msg_map);
 
     mqtt_caching_message_t message = {
         .type = MQTT_CACHING_SUBSCRIPTION_ENTRY,
-        .topic = (char *) topic,
-        .data = NULL,
-        .data_size = 0,
+        .topic = packed,
+        .topic_count = topics_count,
+        .payload = NULL,
         .qos = max_qos,
     };
     mqtt_caching_insert_message(&astarte_mqtt->out_msg_map, message_id, message);
 
-    struct mqtt_topic topics[] = { {
-        .topic = { .utf8 = topic, .size = strlen(topic) },
-        .qos = max_qos,
-    } };
-    const struct mqtt_subscription_list ctrl_sub_list = {
-        .list = topics,
-        .list_count = ARRAY_SIZE(topics),
-        .message_id = message_id,
-    };
-
     if (out_message_id) {
         *out_message_id = message_id;
     }
 
-    int ret = mqtt_subscribe(&astarte_mqtt->client, &ctrl_sub_list);
-    if (ret != 0) {
-        ASTARTE_LOG_ERR("MQTT subscription failed: %s, %d", strerror(-ret), ret);
-    } else {
-        ASTARTE_LOG_DBG("SUBSCRIBED to %s", topic);
-    }
+    send_subscribe(astarte_mqtt, message_id, packed, topics_count, max_qos);
 
-    // Unlock the mutex
-    mutex_rc = sys_mutex_unlock(&astarte_mqtt->mutex);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
+
+    astarte_free(packed);
+    return topics_count;
 }
 
 void astarte_mqtt_publish(astarte_mqtt_t *astarte_mqtt, const char *topic, void *data,
     size_t data_size, int qos, uint16_t *out_message_id)
 {
-    // Lock the mutex for the Astarte MQTT wrapper
-    int mutex_rc = sys_mutex_lock(&astarte_mqtt->mutex, K_FOREVER);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    // QoS 0 messages and empty payloads are not cached, transmit the caller buffer directly
+    if ((qos == 0) || (data_size == 0)) {
+        astarte_mqtt_payload_t payload = {
+            .refcount = ATOMIC_INIT(1),
+            .data = data,
+            .size = data_size,
+        };
+        astarte_mqtt_publish_payload(
+            astarte_mqtt, topic, (data_size == 0) ? NULL : &payload, qos, out_message_id);
+        return;
+    }
+
+    // The caller buffer is not owned by the SDK, a single copy is required to share it with the
+    // retransmission cache
+    uint8_t *data_cpy = astarte_calloc(data_size, sizeof(uint8_t));
+    if (!data_cpy) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return;
+    }
+    memcpy(data_cpy, data, data_size);
+
+    astarte_mqtt_payload_t *payload = astarte_mqtt_payload_wrap(data_cpy, data_size);
+    if (!payload) {
+        astarte_free(data_cpy);
+        return;
+    }
+
+    astarte_mqtt_publish_payload(astarte_mqtt, topic, payload, qos, out_message_id);
+    astarte_mqtt_payload_unref(payload);
+}
+
+void astarte_mqtt_publish_payload(astarte_mqtt_t *astarte_mqtt, const char *topic,
+    astarte_mqtt_payload_t *payload, int qos, uint16_t *out_message_id)
+{
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_MQTT_PUBLISH);
+    // Lock the transmission path of the client
+    lock_mutex(&astarte_mqtt->tx_mutex);
 
     uint16_t message_id = 0;
     if (qos > 0) {
@@ -507,8 +698,7 @@ void astarte_mqtt_publish(astarte_mqtt_t *astarte_mqtt, const char *topic, void
         mqtt_caching_message_t message = {
             .type = MQTT_CACHING_PUBLISH_ENTRY,
             .topic = (char *) topic,
-            .data = data,
-            .data_size = data_size,
+            .payload = payload,
             .qos = qos,
         };
         mqtt_caching_insert_message(&astarte_mqtt->out_msg_map, message_id, message);
@@ -518,142 +708,306 @@ void astarte_mqtt_publish(astarte_mqtt_t *astarte_mqtt, const char *topic, void
         *out_message_id = message_id;
     }
 
+    // The MQTT library encodes the fixed header and topic in the TX buffer, while the payload is
+    // written to the socket directly from the shared buffer using a scatter-gather write
     struct mqtt_publish_param msg = { 0 };
     msg.retain_flag = 0U;
     msg.message.topic.topic.utf8 = topic;
     msg.message.topic.topic.size = strlen(topic);
     msg.message.topic.qos = qos;
-    msg.message.payload.data = data;
-    msg.message.payload.len = data_size;
+    msg.message.payload.data = (payload) ? payload->data : NULL;
+    msg.message.payload.len = (payload) ? payload->size : 0;
     msg.message_id = message_id;
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_SOCKET_WRITE);
     int ret = mqtt_publish(&astarte_mqtt->client, &msg);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_SOCKET_WRITE);
     if (ret != 0) {
         ASTARTE_LOG_ERR("MQTT publish failed: %s, %d", strerror(-ret), ret);
+        // Messages with QoS 1 and 2 are cached and will be retransmitted
+        if (qos == 0) {
+            ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_DROPS);
+        }
     } else {
+        ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_PUBLISH_QOS0 + qos);
         ASTARTE_LOG_DBG("PUBLISHED on topic \"%s\" [ id: %u qos: %u ], payload: %u B", topic,
-            msg.message_id, msg.message.topic.qos, data_size);
-        ASTARTE_LOG_HEXDUMP_DBG(data, data_size, "Published payload:");
+            msg.message_id, msg.message.topic.qos, msg.message.payload.len);
+        ASTARTE_LOG_HEXDUMP_DBG(
+            msg.message.payload.data, msg.message.payload.len, "Published payload:");
     }
 
-    // Unlock the mutex
-    mutex_rc = sys_mutex_unlock(&astarte_mqtt->mutex);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_MQTT_PUBLISH);
 }
 
-astarte_result_t astarte_mqtt_poll(astarte_mqtt_t *astarte_mqtt)
+astarte_mqtt_payload_t *astarte_mqtt_payload_wrap(void *data, size_t size)
 {
-    astarte_result_t ares = ASTARTE_RESULT_OK;
+    astarte_mqtt_payload_t *payload = astarte_calloc(1, sizeof(astarte_mqtt_payload_t));
+    if (!payload) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return NULL;
+    }
+    atomic_set(&payload->refcount, 1);
+    payload->data = data;
+    payload->size = size;
+    return payload;
+}
 
-    // Lock the mutex for the Astarte MQTT wrapper
-    int mutex_rc = sys_mutex_lock(&astarte_mqtt->mutex, K_FOREVER);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+astarte_mqtt_payload_t *astarte_mqtt_payload_ref(astarte_mqtt_payload_t *payload)
+{
+    if (payload) {
+        atomic_inc(&payload->refcount);
+    }
+    return payload;
+}
 
-    // If in the connecting phase check that the connection timeout has not elapsed
-    if ((astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTING)
-        && K_TIMEOUT_EQ(sys_timepoint_timeout(astarte_mqtt->connection_timepoint), K_NO_WAIT)) {
-        astarte_mqtt->connection_state = ASTARTE_MQTT_CONNECTION_ERROR;
-        mqtt_disconnect(&astarte_mqtt->client);
-        ASTARTE_LOG_ERR("Connection attempt has timed out!");
-        goto exit;
+void astarte_mqtt_payload_unref(astarte_mqtt_payload_t *payload)
+{
+    if (!payload) {
+        return;
+    }
+    // atomic_dec returns the value before the decrement
+    if (atomic_dec(&payload->refcount) == 1) {
+        astarte_free(payload->data);
+        astarte_free(payload);
     }
+}
 
-    // If the device is recovering from an unexpected disconnection and backoff time has elapsed
-    // try to reconnect
-    if ((astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTION_ERROR)
-        && K_TIMEOUT_EQ(sys_timepoint_timeout(astarte_mqtt->reconnection_timepoint), K_NO_WAIT)) {
+astarte_result_t astarte_mqtt_poll(astarte_mqtt_t *astarte_mqtt)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    ASTARTE_METRICS_TIMER_START(poll_timer);
 
-        // Update reconnection timepoint to the next backoff value
-        uint32_t next_backoff_ms = 0;
-        backoff_get_next(&astarte_mqtt->backoff_ctx, &next_backoff_ms);
-        astarte_mqtt->reconnection_timepoint = sys_timepoint_calc(K_MSEC(next_backoff_ms));
+    lock_mutex(&astarte_mqtt->state_mutex);
+    bool reconnect = check_reconnection_timepoint(astarte_mqtt);
+    unlock_mutex(&astarte_mqtt->state_mutex);
 
-        // Attempt reconnection
+    // The reconnection refreshes the client certificate, it can't be attempted holding any mutex
+    if (reconnect) {
         ASTARTE_LOG_INF("Attempting a reconnection");
+        ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_RECONNECTS);
         if (astarte_mqtt_connect(astarte_mqtt) != ASTARTE_RESULT_OK) {
             ASTARTE_LOG_ERR("Failed establishing a new connection!");
-            goto exit; // Exit with ASTARTE_RESULT_OK.
         }
     }
 
+    // Only one thread at a time can receive from the client
+    lock_mutex(&astarte_mqtt->rx_mutex);
+
+    lock_mutex(&astarte_mqtt->state_mutex);
+    bool poll_socket = check_connection_timepoints(astarte_mqtt);
+    astarte_mqtt_connection_states_t connection_state = astarte_mqtt->connection_state;
+    unlock_mutex(&astarte_mqtt->state_mutex);
+
     // Only poll if device is connecting, disconnecting or connected
-    if ((astarte_mqtt->connection_state != ASTARTE_MQTT_CONNECTION_ERROR)
-        && (astarte_mqtt->connection_state != ASTARTE_MQTT_DISCONNECTED)) {
-
-        if (astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTED) {
-            mqtt_caching_retransmit_cbk_t retransmit_out_msg_cbk
-                = mqtt_caching_retransmit_out_msg_handler;
-            mqtt_caching_check_message_expiry(
-                &astarte_mqtt->out_msg_map, astarte_mqtt, retransmit_out_msg_cbk);
-            mqtt_caching_retransmit_cbk_t retransmit_in_msg_cbk
-                = mqtt_caching_retransmit_in_msg_handler;
-            mqtt_caching_check_message_expiry(
-                &astarte_mqtt->in_msg_map, astarte_mqtt, retransmit_in_msg_cbk);
-        }
+    if (!poll_socket) {
+        goto exit;
+    }
 
-        // Check connection and ensure to periodically ping the broker using mqtt_live
-        int mqtt_rc = mqtt_live(&astarte_mqtt->client);
-        if ((mqtt_rc != 0) && (mqtt_rc != -EAGAIN)) {
-            ASTARTE_LOG_WRN("Fail keep alive MQTT connection: %s, %d", strerror(-mqtt_rc), mqtt_rc);
-        }
+    if (connection_state == ASTARTE_MQTT_CONNECTED) {
+        lock_mutex(&astarte_mqtt->tx_mutex);
+        mqtt_caching_retransmit_cbk_t retransmit_out_msg_cbk
+            = mqtt_caching_retransmit_out_msg_handler;
+        mqtt_caching_check_message_expiry(
+            &astarte_mqtt->out_msg_map, astarte_mqtt, retransmit_out_msg_cbk);
+        mqtt_caching_retransmit_cbk_t retransmit_in_msg_cbk
+            = mqtt_caching_retransmit_in_msg_handler;
+        mqtt_caching_check_message_expiry(
+            &astarte_mqtt->in_msg_map, astarte_mqtt, retransmit_in_msg_cbk);
+        unlock_mutex(&astarte_mqtt->tx_mutex);
+    }
 
-        // Poll the socket (unlocking the mutex)
-        struct zsock_pollfd socket_fd
-            = { .fd = astarte_mqtt->client.transport.tls.sock, .events = ZSOCK_POLLIN };
-        int32_t keepalive = mqtt_keepalive_time_left(&astarte_mqtt->client);
-        int32_t timeout = MIN(astarte_mqtt->poll_timeout_ms, keepalive);
-        mutex_rc = sys_mutex_unlock(&astarte_mqtt->mutex);
-        ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
-        __ASSERT_NO_MSG(mutex_rc == 0);
-        int socket_rc = zsock_poll(&socket_fd, 1, timeout);
-        mutex_rc = sys_mutex_lock(&astarte_mqtt->mutex, K_FOREVER);
-        ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
-        __ASSERT_NO_MSG(mutex_rc == 0);
-        if (socket_rc < 0) {
-            ASTARTE_LOG_ERR("Poll error: %d", errno);
-            astarte_mqtt->connection_state = ASTARTE_MQTT_CONNECTION_ERROR;
-            ares = ASTARTE_RESULT_SOCKET_ERROR;
+    // Check connection and ensure to periodically ping the broker using mqtt_live
+    int mqtt_rc = mqtt_live(&astarte_mqtt->client);
+    if ((mqtt_rc != 0) && (mqtt_rc != -EAGAIN)) {
+        ASTARTE_LOG_WRN("Fail keep alive MQTT connection: %s, %d", strerror(-mqtt_rc), mqtt_rc);
+    }
+
+    // Poll the socket (unlocking the RX mutex) until the next deadline
+    struct zsock_pollfd socket_fd
+        = { .fd = astarte_mqtt->client.transport.tls.sock, .events = ZSOCK_POLLIN };
+    lock_mutex(&astarte_mqtt->state_mutex);
+    lock_mutex(&astarte_mqtt->tx_mutex);
+    k_timeout_t deadline = sys_timepoint_timeout(get_next_deadline(astarte_mqtt));
+    unlock_mutex(&astarte_mqtt->tx_mutex);
+    unlock_mutex(&astarte_mqtt->state_mutex);
+    int32_t timeout = astarte_mqtt->poll_timeout_ms;
+    if (!K_TIMEOUT_EQ(deadline, K_FOREVER)) {
+        timeout = MIN(timeout, (int32_t) k_ticks_to_ms_ceil32(deadline.ticks));
+    }
+    unlock_mutex(&astarte_mqtt->rx_mutex);
+    ASTARTE_METRICS_TIMER_PAUSE(poll_timer);
+    int socket_rc = zsock_poll(&socket_fd, 1, timeout);
+    ASTARTE_METRICS_TIMER_RESUME(poll_timer);
+    lock_mutex(&astarte_mqtt->rx_mutex);
+    if (socket_rc < 0) {
+        ASTARTE_LOG_ERR("Poll error: %d", errno);
+        lock_mutex(&astarte_mqtt->state_mutex);
+        astarte_mqtt->connection_state = ASTARTE_MQTT_CONNECTION_ERROR;
+        unlock_mutex(&astarte_mqtt->state_mutex);
+        ares = ASTARTE_RESULT_SOCKET_ERROR;
+        goto exit;
+    }
+    if (socket_rc != 0) {
+        // Process the MQTT response, callbacks are called with only the RX mutex locked
+        ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_RX_MQTT_INPUT);
+        mqtt_rc = mqtt_input(&astarte_mqtt->client);
+        ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_RX_MQTT_INPUT);
+        if ((mqtt_rc != 0) && (mqtt_rc != -ENOTCONN)) {
+            ASTARTE_LOG_ERR("MQTT input failed (%d)", mqtt_rc);
+            ares = ASTARTE_RESULT_MQTT_ERROR;
             goto exit;
         }
-        if (socket_rc != 0) {
-            // Process the MQTT response
-            int mqtt_rc = mqtt_input(&astarte_mqtt->client);
-            if ((mqtt_rc != 0) && (mqtt_rc != -ENOTCONN)) {
-                ASTARTE_LOG_ERR("MQTT input failed (%d)", mqtt_rc);
-                ares = ASTARTE_RESULT_MQTT_ERROR;
-                goto exit;
-            }
-        }
     }
 
 exit:
-    // Unlock the mutex
-    mutex_rc = sys_mutex_unlock(&astarte_mqtt->mutex);
-    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
-    __ASSERT_NO_MSG(mutex_rc == 0);
+    unlock_mutex(&astarte_mqtt->rx_mutex);
+    ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_MQTT_POLL, poll_timer);
     return ares;
 }
 
+k_timeout_t astarte_mqtt_get_next_deadline(astarte_mqtt_t *astarte_mqtt)
+{
+    lock_mutex(&astarte_mqtt->state_mutex);
+    lock_mutex(&astarte_mqtt->tx_mutex);
+
+    k_timeout_t deadline = sys_timepoint_timeout(get_next_deadline(astarte_mqtt));
+
+    unlock_mutex(&astarte_mqtt->tx_mutex);
+    unlock_mutex(&astarte_mqtt->state_mutex);
+    return deadline;
+}
+int astarte_mqtt_get_socket(astarte_mqtt_t *astarte_mqtt)
+{
+    int sock = -1;
+
+    // The socket is replaced by a (re)connection, which is performed with the state mutex locked
+    lock_mutex(&astarte_mqtt->state_mutex);
+    if (!is_idle(astarte_mqtt)) {
+        sock = astarte_mqtt->client.transport.tls.sock;
+    }
+    unlock_mutex(&astarte_mqtt->state_mutex);
+
+    return sock;
+}
+
 bool astarte_mqtt_has_pending_outgoing(astarte_mqtt_t *astarte_mqtt)
 {
-    return !sys_hashmap_is_empty(&astarte_mqtt->out_msg_map);
+    lock_mutex(&astarte_mqtt->tx_mutex);
+    bool res = !sys_hashmap_is_empty(&astarte_mqtt->out_msg_map);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
+    return res;
+}
+
+bool astarte_mqtt_is_pending_outgoing(astarte_mqtt_t *astarte_mqtt, uint16_t message_id)
+{
+    lock_mutex(&astarte_mqtt->tx_mutex);
+    bool res = sys_hashmap_contains_key(&astarte_mqtt->out_msg_map, message_id);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
+    return res;
 }
 
 void astarte_mqtt_clear_all_pending(astarte_mqtt_t *astarte_mqtt)
 {
+    lock_mutex(&astarte_mqtt->tx_mutex);
+    ASTARTE_METRICS_ADD(
+        ASTARTE_METRICS_COUNTER_DROPS, sys_hashmap_size(&astarte_mqtt->out_msg_map));
     mqtt_caching_clear_messages(&astarte_mqtt->in_msg_map);
     mqtt_caching_clear_messages(&astarte_mqtt->out_msg_map);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
 }
 
 /************************************************
  *         Static functions definitions         *
  ***********************************************/
 
+static void lock_mutex(struct sys_mutex *mutex)
+{
+    int mutex_rc = sys_mutex_lock(mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+static void unlock_mutex(struct sys_mutex *mutex)
+{
+    int mutex_rc = sys_mutex_unlock(mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+static void *hashmap_alloc(void *ptr, size_t new_size)
+{
+    return astarte_heap_realloc(ASTARTE_HEAP_MODULE_MQTT_CACHING, ptr, new_size);
+}
+
+static bool is_idle(astarte_mqtt_t *astarte_mqtt)
+{
+    return (astarte_mqtt->connection_state == ASTARTE_MQTT_DISCONNECTED)
+        || (astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTION_ERROR);
+}
+
+static bool check_reconnection_timepoint(astarte_mqtt_t *astarte_mqtt)
+{
+    // If the device is recovering from an unexpected disconnection check if the backoff time has
+    // elapsed
+    if ((astarte_mqtt->connection_state != ASTARTE_MQTT_CONNECTION_ERROR)
+        || !K_TIMEOUT_EQ(sys_timepoint_timeout(astarte_mqtt->reconnection_timepoint), K_NO_WAIT)) {
+        return false;
+    }
+
+    // Update reconnection timepoint to the next backoff value
+    uint32_t next_backoff_ms = 0;
+    backoff_get_next(&astarte_mqtt->backoff_ctx, &next_backoff_ms);
+    astarte_mqtt->reconnection_timepoint = sys_timepoint_calc(K_MSEC(next_backoff_ms));
+    return true;
+}
+
+static bool check_connection_timepoints(astarte_mqtt_t *astarte_mqtt)
+{
+    // If in the connecting phase check that the connection timeout has not elapsed
+    if ((astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTING)
+        && K_TIMEOUT_EQ(sys_timepoint_timeout(astarte_mqtt->connection_timepoint), K_NO_WAIT)) {
+        astarte_mqtt->connection_state = ASTARTE_MQTT_CONNECTION_ERROR;
+        mqtt_disconnect(&astarte_mqtt->client);
+        ASTARTE_LOG_ERR("Connection attempt has timed out!");
+        return false;
+    }
+
+    return !is_idle(astarte_mqtt);
+}
+static k_timepoint_t get_next_deadline(astarte_mqtt_t *astarte_mqtt)
+{
+    k_timepoint_t deadline = sys_timepoint_calc(K_FOREVER);
+
+    switch (astarte_mqtt->connection_state) {
+        case ASTARTE_MQTT_CONNECTING:
+            deadline = astarte_mqtt->connection_timepoint;
+            break;
+        case ASTARTE_MQTT_CONNECTION_ERROR:
+            deadline = astarte_mqtt->reconnection_timepoint;
+            break;
+        case ASTARTE_MQTT_CONNECTED: {
+            k_timepoint_t out_expiry = mqtt_caching_get_next_expiry(&astarte_mqtt->out_msg_map);
+            k_timepoint_t in_expiry = mqtt_caching_get_next_expiry(&astarte_mqtt->in_msg_map);
+            deadline = (sys_timepoint_cmp(out_expiry, in_expiry) < 0) ? out_expiry : in_expiry;
+        }
+            __fallthrough;
+        case ASTARTE_MQTT_DISCONNECTING: {
+            int32_t keepalive = mqtt_keepalive_time_left(&astarte_mqtt->client);
+            k_timepoint_t keepalive_timepoint = sys_timepoint_calc(K_MSEC(keepalive));
+            if (sys_timepoint_cmp(keepalive_timepoint, deadline) < 0) {
+                deadline = keepalive_timepoint;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return deadline;
+}
 static void handle_connack_event(
     astarte_mqtt_t *astarte_mqtt, const struct mqtt_connack_param connack)
 {
     ASTARTE_LOG_DBG("Received CONNACK packet, session present: %d", connack.session_present_flag);
+    lock_mutex(&astarte_mqtt->state_mutex);
     // Reset the backoff context for the next connection failure
     backoff_context_init(&astarte_mqtt->backoff_ctx,
         CONFIG_ASTARTE_DEVICE_SDK_RECONNECTION_MQTT_BACKOFF_INITIAL_MS,
@@ -662,10 +1016,10 @@ static void handle_connack_event(
     if (astarte_mqtt->connection_state == ASTARTE_MQTT_CONNECTING) {
         astarte_mqtt->connection_state = ASTARTE_MQTT_CONNECTED;
     }
+    unlock_mutex(&astarte_mqtt->state_mutex);
 
     if (connack.session_present_flag == 0) {
-        mqtt_caching_clear_messages(&astarte_mqtt->in_msg_map);
-        mqtt_caching_clear_messages(&astarte_mqtt->out_msg_map);
+        astarte_mqtt_clear_all_pending(astarte_mqtt);
     }
 
     astarte_mqtt->on_connected_cbk(astarte_mqtt, connack);
@@ -674,6 +1028,7 @@ static void handle_disconnection_event(astarte_mqtt_t *astarte_mqtt)
 {
     ASTARTE_LOG_DBG("MQTT client disconnected");
 
+    lock_mutex(&astarte_mqtt->state_mutex);
     switch (astarte_mqtt->connection_state) {
         case ASTARTE_MQTT_CONNECTING:
         case ASTARTE_MQTT_CONNECTED:
@@ -685,94 +1040,178 @@ static void handle_disconnection_event(astarte_mqtt_t *astarte_mqtt)
         default:
             break;
     }
+    unlock_mutex(&astarte_mqtt->state_mutex);
+
     astarte_mqtt->on_disconnected_cbk(astarte_mqtt);
 }
 static void handle_publish_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_publish_param publish)
 {
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_RX_PUBLISH_EVENT);
     uint16_t message_id = publish.message_id;
     ASTARTE_LOG_DBG("Received PUBLISH packet (%u)", message_id);
     int ret = 0U;
-    size_t received = 0U;
     uint32_t message_size = publish.message.payload.len;
-    char msg_buffer[CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE] = { 0 };
-    const bool discarded = message_size > CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE;
+    uint8_t qos = publish.message.topic.qos;
+    bool deliver = true;
 
     ASTARTE_LOG_DBG("RECEIVED on topic \"%.*s\" [ id: %u qos: %u ] payload: %u / %u B",
         publish.message.topic.topic.size, (const char *) publish.message.topic.topic.utf8,
-        message_id, publish.message.topic.qos, message_size,
-        CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE);
+        message_id, qos, message_size, CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE);
+
+    // A duplicated QoS 2 message should be acknowledged but not delivered a second time
+    lock_mutex(&astarte_mqtt->tx_mutex);
+    bool duplicated = (qos == MQTT_QOS_2_EXACTLY_ONCE)
+        && mqtt_caching_find_message(&astarte_mqtt->in_msg_map, message_id);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
+    if (duplicated) {
+        ASTARTE_LOG_WRN("Received duplicated PUBLISH QoS 2 with message ID (%d).", message_id);
+        deliver = false;
+    }
 
-    while (received < message_size) {
-        char *pkt = discarded ? msg_buffer : &msg_buffer[received];
+    if ((message_size > CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE)
+        && !astarte_mqtt->on_incoming_chunk_cbk) {
+        ASTARTE_LOG_ERR("Insufficient space in the Astarte MQTT reception buffer.");
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        deliver = false;
+    }
 
-        ret = mqtt_read_publish_payload_blocking(
-            &astarte_mqtt->client, pkt, CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE);
-        if (ret < 0) {
-            ASTARTE_LOG_ERR("Error reading payload of PUBLISH packet %s", strerror(ret));
-            return;
-        }
+    // This copy is necessary due to the Zephyr MQTT library not null terminating the topic.
+    size_t topic_len = publish.message.topic.topic.size;
+    char *topic = astarte_calloc(topic_len + 1, sizeof(char));
+    if (!topic) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        deliver = false;
+    } else {
+        memcpy(topic, publish.message.topic.topic.utf8, topic_len);
+    }
 
-        received += ret;
+    if (!deliver && !duplicated) {
+        ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_DROPS);
     }
 
-    if (publish.message.topic.qos == MQTT_QOS_1_AT_LEAST_ONCE) {
+    uint8_t *payload = NULL;
+    astarte_result_t ares
+        = read_publish_payload(astarte_mqtt, topic, topic_len, message_size, deliver, &payload);
+    if (ares != ASTARTE_RESULT_OK) {
+        goto exit;
+    }
+
+    lock_mutex(&astarte_mqtt->tx_mutex);
+    if (qos == MQTT_QOS_1_AT_LEAST_ONCE) {
         struct mqtt_puback_param puback = { .message_id = message_id };
         ret = mqtt_publish_qos1_ack(&astarte_mqtt->client, &puback);
         if (ret != 0) {
             ASTARTE_LOG_ERR("MQTT PUBACK transmission error %d", ret);
         }
     }
-    if (publish.message.topic.qos == MQTT_QOS_2_EXACTLY_ONCE) {
+    if (qos == MQTT_QOS_2_EXACTLY_ONCE) {
         struct mqtt_pubrec_param pubrec = { .message_id = message_id };
         ret = mqtt_publish_qos2_receive(&astarte_mqtt->client, &pubrec);
         if (ret != 0) {
             ASTARTE_LOG_ERR("MQTT PUBREC transmission error %d", ret);
         }
 
-        if (mqtt_caching_find_message(&astarte_mqtt->in_msg_map, message_id)) {
-            ASTARTE_LOG_WRN("Received duplicated PUBLISH QoS 2 with message ID (%d).", message_id);
-            return;
+        if (!duplicated) {
+            mqtt_caching_message_t message = {
+                .type = MQTT_CACHING_PUBREC_ENTRY,
+                .topic = NULL,
+                .payload = NULL,
+                .qos = 2,
+            };
+            mqtt_caching_insert_message(&astarte_mqtt->in_msg_map, message_id, message);
         }
+    }
+    unlock_mutex(&astarte_mqtt->tx_mutex);
 
-        mqtt_caching_message_t message = {
-            .type = MQTT_CACHING_PUBREC_ENTRY,
-            .topic = NULL,
-            .data = NULL,
-            .data_size = 0,
-            .qos = 2,
-        };
-        mqtt_caching_insert_message(&astarte_mqtt->in_msg_map, message_id, message);
+    // The user callbacks are called with only the RX mutex locked, transmission is not blocked
+    if (payload) {
+        ASTARTE_LOG_HEXDUMP_DBG(payload, MIN(message_size, 256U), "Received payload:");
+        astarte_mqtt->on_incoming_cbk(
+            astarte_mqtt, topic, topic_len, (const char *) payload, message_size);
     }
 
-    if (received != publish.message.payload.len) {
-        ASTARTE_LOG_ERR("Incoherent expected and read MQTT publish payload lengths.");
-        return;
+exit:
+    astarte_free(topic);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_RX_PUBLISH_EVENT);
+}
+static astarte_result_t read_publish_payload(astarte_mqtt_t *astarte_mqtt, const char *topic,
+    size_t topic_len, size_t payload_len, bool deliver, uint8_t **payload)
+{
+    uint8_t drain_buffer[RX_DRAIN_BUFFER_SIZE];
+    uint8_t *buffer = drain_buffer;
+    size_t buffer_size = sizeof(drain_buffer);
+
+    *payload = NULL;
+
+    if (deliver) {
+        // Allocate at least one byte so that empty payloads can also be delivered
+        size_t required_size = CLAMP(payload_len, 1, CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE);
+        buffer = get_rx_payload_buffer(astarte_mqtt, required_size);
+        buffer_size = required_size;
+        if (!buffer) {
+            ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+            ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_DROPS);
+            buffer = drain_buffer;
+            buffer_size = sizeof(drain_buffer);
+            deliver = false;
+        }
     }
+    bool chunked = deliver && (payload_len > CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE);
 
-    if (discarded) {
-        ASTARTE_LOG_ERR("Insufficient space in the Astarte MQTT reception buffer.");
-        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-        return;
+    size_t received = 0U;
+    size_t chunk_offset = 0U;
+    size_t chunk_len = 0U;
+    while (received < payload_len) {
+        int ret = mqtt_read_publish_payload_blocking(
+            &astarte_mqtt->client, &buffer[chunk_len], buffer_size - chunk_len);
+        if (ret < 0) {
+            ASTARTE_LOG_ERR("Error reading payload of PUBLISH packet %s", strerror(-ret));
+            return ASTARTE_RESULT_MQTT_ERROR;
+        }
+        received += ret;
+        chunk_len += ret;
+
+        if (!deliver) {
+            // Discarded data, the buffer can be overwritten on the next read
+            chunk_len = 0U;
+        } else if (chunked && ((chunk_len == buffer_size) || (received == payload_len))) {
+            astarte_mqtt->on_incoming_chunk_cbk(astarte_mqtt, topic, topic_len, chunk_offset,
+                (const char *) buffer, chunk_len, payload_len);
+            chunk_offset += chunk_len;
+            chunk_len = 0U;
+        }
     }
 
-    ASTARTE_LOG_HEXDUMP_DBG(msg_buffer, MIN(message_size, 256U), "Received payload:");
+    if (received != payload_len) {
+        ASTARTE_LOG_ERR("Incoherent expected and read MQTT publish payload lengths.");
+        return ASTARTE_RESULT_MQTT_ERROR;
+    }
 
-    // This copy is necessary due to the Zephyr MQTT library not null terminating the topic.
-    size_t topic_len = publish.message.topic.topic.size;
-    char *topic = calloc(topic_len + 1, sizeof(char));
-    if (!topic) {
-        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-        return;
+    if (deliver && !chunked) {
+        *payload = buffer;
     }
-    memcpy(topic, publish.message.topic.topic.utf8, topic_len);
-    astarte_mqtt->on_incoming_cbk(astarte_mqtt, topic, topic_len, msg_buffer, message_size);
-    free(topic);
+    return ASTARTE_RESULT_OK;
+}
+static uint8_t *get_rx_payload_buffer(astarte_mqtt_t *astarte_mqtt, size_t size)
+{
+    if (astarte_mqtt->rx_payload_buffer_size >= size) {
+        return astarte_mqtt->rx_payload_buffer;
+    }
+
+    // Grow geometrically to limit the number of reallocations, up to the maximum message size
+    size_t new_size = MAX(size, 2 * astarte_mqtt->rx_payload_buffer_size);
+    new_size = MIN(new_size, CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE);
+    astarte_free(astarte_mqtt->rx_payload_buffer);
+    astarte_mqtt->rx_payload_buffer = astarte_calloc(new_size, sizeof(uint8_t));
+    astarte_mqtt->rx_payload_buffer_size = (astarte_mqtt->rx_payload_buffer) ? new_size : 0;
+    return astarte_mqtt->rx_payload_buffer;
 }
 static void handle_pubrel_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_pubrel_param pubrel)
 {
     uint16_t message_id = pubrel.message_id;
     ASTARTE_LOG_DBG("Received PUBREL packet (%u)", message_id);
 
+    lock_mutex(&astarte_mqtt->tx_mutex);
     mqtt_caching_remove_message(&astarte_mqtt->in_msg_map, message_id);
 
     struct mqtt_pubcomp_param pubcomp = { .message_id = message_id };
@@ -780,13 +1219,16 @@ static void handle_pubrel_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_pubrel
     if (res != 0) {
         ASTARTE_LOG_ERR("MQTT PUBCOMP transmission error %d", res);
     }
+    unlock_mutex(&astarte_mqtt->tx_mutex);
 }
 static void handle_puback_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_puback_param puback)
 {
     uint16_t message_id = puback.message_id;
     ASTARTE_LOG_DBG("Received PUBACK packet (%u)", message_id);
 
+    lock_mutex(&astarte_mqtt->tx_mutex);
     mqtt_caching_remove_message(&astarte_mqtt->out_msg_map, message_id);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
 
     if (astarte_mqtt->on_delivered_cbk) {
         astarte_mqtt->on_delivered_cbk(astarte_mqtt, message_id);
@@ -797,6 +1239,7 @@ static void handle_pubrec_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_pubrec
     uint16_t message_id = pubrec.message_id;
     ASTARTE_LOG_DBG("Received PUBREC packet (%u)", message_id);
 
+    lock_mutex(&astarte_mqtt->tx_mutex);
     mqtt_caching_update_message_expiry(&astarte_mqtt->out_msg_map, message_id);
 
     // Transmit a PUBREL
@@ -805,13 +1248,16 @@ static void handle_pubrec_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_pubrec
     if (err != 0) {
         ASTARTE_LOG_ERR("Failed to send MQTT PUBREL: %d", err);
     }
+    unlock_mutex(&astarte_mqtt->tx_mutex);
 }
 static void handle_pubcomp_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_pubcomp_param pubcomp)
 {
     uint16_t message_id = pubcomp.message_id;
     ASTARTE_LOG_DBG("Received PUBCOMP packet (%u)", message_id);
 
+    lock_mutex(&astarte_mqtt->tx_mutex);
     mqtt_caching_remove_message(&astarte_mqtt->out_msg_map, message_id);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
 
     if (astarte_mqtt->on_delivered_cbk) {
         astarte_mqtt->on_delivered_cbk(astarte_mqtt, message_id);
@@ -822,15 +1268,54 @@ static void handle_suback_event(astarte_mqtt_t *astarte_mqtt, struct mqtt_suback
     uint16_t message_id = suback.message_id;
     ASTARTE_LOG_DBG("Received SUBACK packet (%u)", message_id);
 
+    lock_mutex(&astarte_mqtt->tx_mutex);
     mqtt_caching_remove_message(&astarte_mqtt->out_msg_map, message_id);
+    unlock_mutex(&astarte_mqtt->tx_mutex);
 
     if (astarte_mqtt->on_subscribed_cbk) {
-        enum mqtt_suback_return_code return_code = MQTT_SUBACK_FAILURE;
         if (suback.return_codes.len == 0) {
             ASTARTE_LOG_ERR("Missing return code for SUBACK message (%u)", message_id);
-        } else {
-            return_code = (enum mqtt_suback_return_code) * suback.return_codes.data;
+            astarte_mqtt->on_subscribed_cbk(astarte_mqtt, message_id, 0, MQTT_SUBACK_FAILURE);
+            return;
         }
-        astarte_mqtt->on_subscribed_cbk(astarte_mqtt, message_id, return_code);
+        // One return code is present for each topic filter of the SUBSCRIBE packet
+        for (size_t i = 0; i < suback.return_codes.len; i++) {
+            enum mqtt_suback_return_code return_code
+                = (enum mqtt_suback_return_code) suback.return_codes.data[i];
+            astarte_mqtt->on_subscribed_cbk(astarte_mqtt, message_id, i, return_code);
+        }
+    }
+}
+
+static void send_subscribe(astarte_mqtt_t *astarte_mqtt, uint16_t message_id, const char *topics,
+    size_t topics_count, int max_qos)
+{
+    struct mqtt_topic *list = astarte_calloc(topics_count, sizeof(struct mqtt_topic));
+    if (!list) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        return;
+    }
+
+    const char *topic = topics;
+    for (size_t i = 0; i < topics_count; i++) {
+        list[i].topic.utf8 = (const uint8_t *) topic;
+        list[i].topic.size = strlen(topic);
+        list[i].qos = max_qos;
+        topic += list[i].topic.size + 1;
     }
+
+    const struct mqtt_subscription_list sub_list = {
+        .list = list,
+        .list_count = topics_count,
+        .message_id = message_id,
+    };
+
+    int ret = mqtt_subscribe(&astarte_mqtt->client, &sub_list);
+    if (ret != 0) {
+        ASTARTE_LOG_ERR("MQTT subscription failed: %s, %d", strerror(-ret), ret);
+    } else {
+        ASTARTE_LOG_DBG("SUBSCRIBED to %zu topics, first: %s", topics_count, topics);
+    }
+
+    astarte_free(list);
 }
@@ -5,9 +5,14 @@
  */
 #include "mqtt_caching.h"
 
+#include <zephyr/sys/util.h>
+
+#include "heap_private.h"
 #include "log.h"
+#include "metrics_private.h"
 
 ASTARTE_LOG_MODULE_DECLARE(astarte_mqtt, CONFIG_ASTARTE_DEVICE_SDK_MQTT_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_MQTT_CACHING);
 
 /************************************************
  *        Defines, constants and typedef        *
@@ -45,7 +50,6 @@ void mqtt_caching_insert_message(
     struct sys_hashmap *map, uint16_t identifier, mqtt_caching_message_t message)
 {
     char *topic_cpy = NULL;
-    uint8_t *data_cpy = NULL;
     struct mqtt_caching_map_entry *map_entry = NULL;
     ASTARTE_LOG_DBG("Adding message to map, id: %d.", identifier);
 
@@ -54,35 +58,31 @@ void mqtt_caching_insert_message(
         goto error;
     }
 
-    map_entry = calloc(1, sizeof(struct mqtt_caching_map_entry));
+    map_entry = astarte_calloc(1, sizeof(struct mqtt_caching_map_entry));
     if (!map_entry) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         goto error;
     }
 
     if (message.topic) {
-        topic_cpy = calloc(strlen(message.topic) + 1, sizeof(char));
-        if (!topic_cpy) {
-            ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
-            goto error;
+        // Subscriptions can store multiple NUL separated topics
+        size_t topic_size = 0U;
+        for (size_t i = 0; i < MAX(message.topic_count, 1); i++) {
+            topic_size += strlen(message.topic + topic_size) + 1;
         }
-        strncpy(topic_cpy, message.topic, strlen(message.topic) + 1);
-    }
-
-    if (message.data && (message.data_size != 0)) {
-        data_cpy = calloc(message.data_size, sizeof(uint8_t));
-        if (!data_cpy) {
+        topic_cpy = astarte_calloc(topic_size, sizeof(char));
+        if (!topic_cpy) {
             ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
             goto error;
         }
-        memcpy(data_cpy, message.data, message.data_size);
+        memcpy(topic_cpy, message.topic, topic_size);
     }
 
     map_entry->end_of_validity = sys_timepoint_calc(K_SECONDS(CONFIG_MQTT_KEEPALIVE));
     map_entry->message.type = message.type;
     map_entry->message.topic = topic_cpy;
-    map_entry->message.data = data_cpy;
-    map_entry->message.data_size = message.data_size;
+    map_entry->message.topic_count = message.topic_count;
+    map_entry->message.payload = NULL;
     map_entry->message.qos = message.qos;
 
     int ret = sys_hashmap_insert(map, identifier, POINTER_TO_UINT(map_entry), NULL);
@@ -91,12 +91,15 @@ void mqtt_caching_insert_message(
         goto error;
     }
 
+    // Only take a reference to the payload once the entry is owned by the map
+    map_entry->message.payload = astarte_mqtt_payload_ref(message.payload);
+    ASTARTE_METRICS_GAUGE_ADD(ASTARTE_METRICS_GAUGE_IN_FLIGHT, 1);
+
     return;
 
 error:
-    free(topic_cpy);
-    free(data_cpy);
-    free(map_entry);
+    astarte_free(topic_cpy);
+    astarte_free(map_entry);
 }
 
 bool mqtt_caching_find_message(struct sys_hashmap *map, uint16_t message_id)
@@ -121,11 +124,31 @@ void mqtt_caching_check_message_expiry(struct sys_hashmap *map, astarte_mqtt_t *
             // Update end of validity for this message
             map_entry->end_of_validity = sys_timepoint_calc(K_SECONDS(CONFIG_MQTT_KEEPALIVE));
             // Re-send the message
+            ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_RETRANSMISSIONS);
             retransmit_cbk(astarte_mqtt, message_id, map_entry->message);
         }
     }
 }
 
+k_timepoint_t mqtt_caching_get_next_expiry(struct sys_hashmap *map)
+{
+    k_timepoint_t next_expiry = sys_timepoint_calc(K_FOREVER);
+
+    // Loop over all the messages in the hashmap
+    struct sys_hashmap_iterator iter = { 0 };
+    map->api->iter(map, &iter);
+    while (sys_hashmap_iterator_has_next(&iter)) {
+        iter.next(&iter);
+        // NOLINTNEXTLINE(performance-no-int-to-ptr) Unavoidable due to the hashmap structure
+        struct mqtt_caching_map_entry *map_entry = UINT_TO_POINTER(iter.value);
+        if (sys_timepoint_cmp(map_entry->end_of_validity, next_expiry) < 0) {
+            next_expiry = map_entry->end_of_validity;
+        }
+    }
+
+    return next_expiry;
+}
+
 void mqtt_caching_update_message_expiry(struct sys_hashmap *map, uint16_t message_id)
 {
     ASTARTE_LOG_DBG("Updating message expiration in hashmap, id: %d.", message_id);
@@ -150,9 +173,10 @@ void mqtt_caching_remove_message(struct sys_hashmap *map, uint16_t message_id)
     if (sys_hashmap_remove(map, message_id, &value)) {
         // NOLINTNEXTLINE(performance-no-int-to-ptr) Unavoidable due to the hashmap structure
         struct mqtt_caching_map_entry *map_entry = UINT_TO_POINTER(value);
-        free(map_entry->message.topic);
-        free(map_entry->message.data);
-        free(map_entry);
+        astarte_free(map_entry->message.topic);
+        astarte_mqtt_payload_unref(map_entry->message.payload);
+        astarte_free(map_entry);
+        ASTARTE_METRICS_GAUGE_ADD(ASTARTE_METRICS_GAUGE_IN_FLIGHT, -1);
     } else {
         ASTARTE_LOG_ERR("Message ID (%d) not found in hashmap.", message_id);
     }
@@ -161,6 +185,7 @@ void mqtt_caching_remove_message(struct sys_hashmap *map, uint16_t message_id)
 void mqtt_caching_clear_messages(struct sys_hashmap *map)
 {
     ASTARTE_LOG_DBG("Removing all messages from hashmap.");
+    ASTARTE_METRICS_GAUGE_ADD(ASTARTE_METRICS_GAUGE_IN_FLIGHT, -(int32_t) sys_hashmap_size(map));
 
     // Loop over all the messages in the hashmap
     struct sys_hashmap_iterator iter = { 0 };
@@ -169,9 +194,9 @@ void mqtt_caching_clear_messages(struct sys_hashmap *map)
         iter.next(&iter);
         // NOLINTNEXTLINE(performance-no-int-to-ptr) Unavoidable due to the hashmap structure
         struct mqtt_caching_map_entry *map_entry = UINT_TO_POINTER(iter.value);
-        free(map_entry->message.topic);
-        free(map_entry->message.data);
-        free(map_entry);
+        astarte_free(map_entry->message.topic);
+        astarte_mqtt_payload_unref(map_entry->message.payload);
+        astarte_free(map_entry);
     }
 
     // Clear the internal structures of the map
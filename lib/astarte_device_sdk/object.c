@@ -11,11 +11,14 @@
 
 #include "bson_types.h"
 #include "data_private.h"
+#include "heap_private.h"
 #include "interface_private.h"
+#include "mapping_private.h"
 
 #include "log.h"
 
 ASTARTE_LOG_MODULE_REGISTER(astarte_object, CONFIG_ASTARTE_DEVICE_SDK_OBJECT_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_OBJECT);
 
 /************************************************
  *     Global public functions definitions      *
@@ -59,6 +62,21 @@ astarte_result_t astarte_object_entries_serialize(
     return ares;
 }
 
+astarte_result_t astarte_object_values_serialize(astarte_bson_serializer_t *bson,
+    const astarte_interface_t *interface, const astarte_data_t *values)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    for (size_t i = 0; i < interface->mappings_length; i++) {
+        const char *key = astarte_mapping_get_object_key(interface->mappings[i]);
+        ares = astarte_data_serialize(bson, key, values[i]);
+        if (ares != ASTARTE_RESULT_OK) {
+            break;
+        }
+    }
+
+    return ares;
+}
+
 astarte_result_t astarte_object_entries_deserialize(astarte_bson_element_t bson_elem,
     const astarte_interface_t *interface, const char *path, astarte_object_entry_t **entries,
     size_t *entries_length)
@@ -87,7 +105,7 @@ astarte_result_t astarte_object_entries_deserialize(astarte_bson_element_t bson_
     }
 
     // Step 2: Allocate sufficient memory for all the astarte object entries
-    tmp_entries = calloc(bson_doc_length, sizeof(astarte_object_entry_t));
+    tmp_entries = astarte_calloc(bson_doc_length, sizeof(astarte_object_entry_t));
     if (!tmp_entries) {
         ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
         ares = ASTARTE_RESULT_OUT_OF_MEMORY;
@@ -130,7 +148,7 @@ failure:
     for (size_t j = 0; j < deserialize_idx; j++) {
         astarte_data_destroy_deserialized(tmp_entries[j].data);
     }
-    free(tmp_entries);
+    astarte_free(tmp_entries);
 
     return ares;
 }
@@ -141,5 +159,5 @@ void astarte_object_entries_destroy_deserialized(
     for (size_t i = 0; i < entries_length; i++) {
         astarte_data_destroy_deserialized(entries[i].data);
     }
-    free(entries);
+    astarte_free(entries);
 }
@@ -12,6 +12,7 @@
 
 #include <zephyr/data/json.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/mutex.h>
 
 #include "crypto.h"
 #include "http.h"
@@ -106,10 +107,55 @@ BUILD_ASSERT(sizeof(JSON_NULL) == sizeof(JSON_NULL_REPLACEMENT),
     (PAIRING_DEVICE_MGMT_URL_PREFIX_LEN + ASTARTE_DEVICE_ID_LEN                                    \
         + PAIRING_DEVICE_CERT_CHECK_URL_SUFFIX_LEN)
 
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+/** @brief HTTP session shared by all the requests to the pairing APIs. */
+static astarte_http_session_t pairing_http_session = { .sock = -1 };
+/** @brief Number of active pairing sessions, the HTTP connection is kept open while not zero. */
+static size_t pairing_session_count;
+/** @brief Mutex protecting the shared HTTP session. */
+static SYS_MUTEX_DEFINE(pairing_session_mutex);
+
 /************************************************
  *         Static functions declaration         *
  ***********************************************/
 
+/**
+ * @brief Perform an HTTP POST request to the pairing APIs using the shared HTTP session.
+ *
+ * @param[in] timeout_ms Timeout to use for the HTTP operations in ms.
+ * @param[in] url Partial URL to use for the request.
+ * @param[in] header_fields NULL terminated list of headers for the request.
+ * @param[in] payload Payload to transmit.
+ * @param[out] resp_buf Output buffer where to store the response from the server.
+ * @param[in] resp_buf_size Size of the response output buffer.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t pairing_http_post(int32_t timeout_ms, const char *url,
+    const char **header_fields, const char *payload, char *resp_buf, size_t resp_buf_size);
+/**
+ * @brief Perform an HTTP GET request to the pairing APIs using the shared HTTP session.
+ *
+ * @param[in] timeout_ms Timeout to use for the HTTP operations in ms.
+ * @param[in] url Partial URL to use for the request.
+ * @param[in] header_fields NULL terminated list of headers for the request.
+ * @param[out] resp_buf Output buffer where to store the response from the server.
+ * @param[in] resp_buf_size Size of the response output buffer.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+static astarte_result_t pairing_http_get(int32_t timeout_ms, const char *url,
+    const char **header_fields, char *resp_buf, size_t resp_buf_size);
+/**
+ * @brief Lock the mutex protecting the shared HTTP session.
+ */
+static void lock_session(void);
+/**
+ * @brief Unlock the mutex protecting the shared HTTP session.
+ */
+static void unlock_session(void);
+
 /**
  * @brief Fetch the MQTT broker URL from Astarte.
  *
@@ -201,6 +247,24 @@ static astarte_result_t parse_verify_client_certificate_response(char *resp_buf)
  *         Global functions definitions         *
  ***********************************************/
 
+void astarte_pairing_session_begin(void)
+{
+    lock_session();
+    pairing_session_count++;
+    unlock_session();
+}
+
+void astarte_pairing_session_end(void)
+{
+    lock_session();
+    __ASSERT_NO_MSG(pairing_session_count > 0);
+    pairing_session_count--;
+    if (pairing_session_count == 0) {
+        astarte_http_session_close(&pairing_http_session);
+    }
+    unlock_session();
+}
+
 astarte_result_t astarte_pairing_register_device(
     int32_t timeout_ms, const char *device_id, char *out_cred_secr, size_t out_cred_secr_size)
 {
@@ -232,7 +296,7 @@ astarte_result_t astarte_pairing_register_device(
     }
     char resp_buf[REGISTER_DEVICE_RESPONSE_MAX_SIZE] = { 0 };
 
-    ares = astarte_http_post(timeout_ms, url, header_fields, payload, resp_buf, sizeof(resp_buf));
+    ares = pairing_http_post(timeout_ms, url, header_fields, payload, resp_buf, sizeof(resp_buf));
     if (ares != ASTARTE_RESULT_OK) {
         return ares;
     }
@@ -309,6 +373,23 @@ astarte_result_t astarte_pairing_get_client_certificate(int32_t timeout_ms, cons
     }
 
     // Step 3: get the client certificate from the server
+    return astarte_pairing_request_client_certificate(
+        timeout_ms, device_id, cred_secr, csr_buf, client_crt);
+}
+
+astarte_result_t astarte_pairing_request_client_certificate(int32_t timeout_ms,
+    const char *device_id, const char *cred_secr, const unsigned char *csr_pem,
+    astarte_tls_credentials_client_crt_t *client_crt)
+{
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    // Step 1: check the input parameters
+    if (strlen(device_id) != ASTARTE_DEVICE_ID_LEN) {
+        ASTARTE_LOG_ERR(
+            "Device ID has incorrect length, should be %d chars.", ASTARTE_DEVICE_ID_LEN);
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+
+    // Step 2: get the client certificate from the server
     char auth_header[AUTH_HEADER_CRED_SECRET_SIZE] = { 0 };
     int snprintf_rc = snprintf(auth_header, AUTH_HEADER_CRED_SECRET_SIZE,
         AUTH_HEADER_BEARER_STR_START "%s" AUTH_HEADER_BEARER_STR_END, cred_secr);
@@ -318,7 +399,7 @@ astarte_result_t astarte_pairing_get_client_certificate(int32_t timeout_ms, cons
     }
     const char *header_fields[] = { auth_header, NULL };
     char payload[GET_CLIENT_CRT_PAYLOAD_MAX_SIZE] = { 0 };
-    ares = encode_get_client_certificate_payload(csr_buf, payload, GET_CLIENT_CRT_PAYLOAD_MAX_SIZE);
+    ares = encode_get_client_certificate_payload(csr_pem, payload, GET_CLIENT_CRT_PAYLOAD_MAX_SIZE);
     if (ares != ASTARTE_RESULT_OK) {
         return ares;
     }
@@ -332,19 +413,19 @@ astarte_result_t astarte_pairing_get_client_certificate(int32_t timeout_ms, cons
         return ASTARTE_RESULT_INTERNAL_ERROR;
     }
 
-    ares = astarte_http_post(timeout_ms, url, header_fields, payload, resp_buf, sizeof(resp_buf));
+    ares = pairing_http_post(timeout_ms, url, header_fields, payload, resp_buf, sizeof(resp_buf));
     if (ares != ASTARTE_RESULT_OK) {
         return ares;
     }
 
-    // Step 4: process the result
+    // Step 3: process the result
     ares = parse_get_client_certificate_response(
         resp_buf, client_crt->crt_pem, ARRAY_SIZE(client_crt->crt_pem));
     if (ares != ASTARTE_RESULT_OK) {
         return ares;
     }
 
-    // Step 5: convert the received certificate to a valid PEM certificate
+    // Step 4: convert the received certificate to a valid PEM certificate
     // Replace "\n" with newlines chars
     char *tmp = NULL;
     while ((tmp = strstr(client_crt->crt_pem, "\\n")) != NULL) {
@@ -392,7 +473,7 @@ astarte_result_t astarte_pairing_verify_client_certificate(
     }
 
     char resp_buf[VERIFY_CLIENT_CRT_RESPONSE_MAX_SIZE] = { 0 };
-    ares = astarte_http_post(timeout_ms, url, header_fields, payload, resp_buf, sizeof(resp_buf));
+    ares = pairing_http_post(timeout_ms, url, header_fields, payload, resp_buf, sizeof(resp_buf));
     if (ares != ASTARTE_RESULT_OK) {
         return ares;
     }
@@ -439,7 +520,7 @@ static astarte_result_t get_broker_info(int32_t timeout_ms, const char *device_i
     }
 
     char resp_buf[GET_BROKER_INFO_RESPONSE_MAX_SIZE] = { 0 };
-    ares = astarte_http_get(timeout_ms, url, header_fields, resp_buf, sizeof(resp_buf));
+    ares = pairing_http_get(timeout_ms, url, header_fields, resp_buf, sizeof(resp_buf));
     if (ares != ASTARTE_RESULT_OK) {
         return ares;
     }
@@ -785,3 +866,43 @@ static astarte_result_t parse_verify_client_certificate_response(char *resp_buf)
     }
     return ASTARTE_RESULT_OK;
 }
+
+static astarte_result_t pairing_http_post(int32_t timeout_ms, const char *url,
+    const char **header_fields, const char *payload, char *resp_buf, size_t resp_buf_size)
+{
+    lock_session();
+    astarte_result_t ares = astarte_http_session_post(&pairing_http_session, timeout_ms, url,
+        header_fields, payload, (uint8_t *) resp_buf, resp_buf_size);
+    if (pairing_session_count == 0) {
+        astarte_http_session_close(&pairing_http_session);
+    }
+    unlock_session();
+    return ares;
+}
+
+static astarte_result_t pairing_http_get(int32_t timeout_ms, const char *url,
+    const char **header_fields, char *resp_buf, size_t resp_buf_size)
+{
+    lock_session();
+    astarte_result_t ares = astarte_http_session_get(
+        &pairing_http_session, timeout_ms, url, header_fields, (uint8_t *) resp_buf, resp_buf_size);
+    if (pairing_session_count == 0) {
+        astarte_http_session_close(&pairing_http_session);
+    }
+    unlock_session();
+    return ares;
+}
+
+static void lock_session(void)
+{
+    int mutex_rc = sys_mutex_lock(&pairing_session_mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+
+static void unlock_session(void)
+{
+    int mutex_rc = sys_mutex_unlock(&pairing_session_mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
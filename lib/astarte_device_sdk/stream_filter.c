@@ -0,0 +1,456 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "stream_filter.h"
+
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "heap_private.h"
+#include "log.h"
+#include "metrics_private.h"
+ASTARTE_LOG_MODULE_REGISTER(
+    astarte_stream_filter, CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTER_LOG_LEVEL);
+ASTARTE_HEAP_MODULE_REGISTER(ASTARTE_HEAP_MODULE_STREAM_FILTER);
+
+/************************************************
+ *         Static functions declaration         *
+ ***********************************************/
+
+/**
+ * @brief Lock the filters of a device.
+ *
+ * @param[inout] filter Filters of the device.
+ */
+static void lock_filter(astarte_stream_filter_t *filter);
+/**
+ * @brief Unlock the filters of a device.
+ *
+ * @param[inout] filter Filters of the device.
+ */
+static void unlock_filter(astarte_stream_filter_t *filter);
+/**
+ * @brief Get the filter in use for a mapping, either set at runtime or from its definition.
+ *
+ * @note Should be called with the filters locked.
+ *
+ * @param[in] filter Filters of the device.
+ * @param[in] mapping Mapping for which to get the filter.
+ * @return The filter of the mapping, NULL if the mapping values are not filtered.
+ */
+static const astarte_mapping_filter_t *get_mapping_filter(
+    const astarte_stream_filter_t *filter, const astarte_mapping_t *mapping);
+/**
+ * @brief Check if the values of a mapping type can be filtered.
+ *
+ * @details Only scalar values are filtered, as they can be held without copying their content.
+ *
+ * @param[in] type Type of the mapping.
+ * @return True if the values can be filtered, false otherwise.
+ */
+static bool is_filterable_type(astarte_mapping_type_t type);
+/**
+ * @brief Get the entry tracking a path, creating it when not present.
+ *
+ * @note Should be called with the filters locked.
+ *
+ * @param[inout] filter Filters of the device.
+ * @param[in] interface_name Name of the interface.
+ * @param[in] path Path of the value.
+ * @return The entry for the path, NULL if it could not be created.
+ */
+static astarte_stream_filter_entry_t *get_entry(
+    astarte_stream_filter_t *filter, const char *interface_name, const char *path);
+/**
+ * @brief Allocate a copy of a string.
+ *
+ * @param[in] string String to copy.
+ * @return The copy, to be freed with astarte_free, NULL if it could not be allocated.
+ */
+static char *copy_string(const char *string);
+/**
+ * @brief Check if a value is within the deadbands from the last sent value.
+ *
+ * @param[in] mapping_filter Filter of the mapping.
+ * @param[in] last Last sent value.
+ * @param[in] value New value.
+ * @return True if the value should be dropped, false otherwise.
+ */
+static bool within_deadband(
+    const astarte_mapping_filter_t *mapping_filter, astarte_data_t last, astarte_data_t value);
+/**
+ * @brief Convert a numeric value to a double.
+ *
+ * @param[in] value Value to convert.
+ * @param[out] number Converted value.
+ * @return True if the value is numeric, false otherwise.
+ */
+static bool to_number(astarte_data_t value, double *number);
+
+/************************************************
+ *         Global functions definitions         *
+ ***********************************************/
+
+void astarte_stream_filter_init(astarte_stream_filter_t *filter)
+{
+    memset(filter, 0, sizeof(astarte_stream_filter_t));
+    sys_mutex_init(&filter->mutex);
+}
+
+void astarte_stream_filter_destroy(astarte_stream_filter_t *filter)
+{
+    lock_filter(filter);
+    for (size_t i = 0; i < ARRAY_SIZE(filter->entries); i++) {
+        astarte_free(filter->entries[i].interface_name);
+        astarte_free(filter->entries[i].path);
+        memset(&filter->entries[i], 0, sizeof(astarte_stream_filter_entry_t));
+    }
+    unlock_filter(filter);
+}
+
+astarte_result_t astarte_stream_filter_set(astarte_stream_filter_t *filter,
+    const astarte_interface_t *interface, const char *endpoint,
+    const astarte_mapping_filter_t *mapping_filter)
+{
+    if ((interface->type != ASTARTE_INTERFACE_TYPE_DATASTREAM)
+        || (interface->aggregation != ASTARTE_INTERFACE_AGGREGATION_INDIVIDUAL)
+        || (interface->ownership != ASTARTE_INTERFACE_OWNERSHIP_DEVICE)) {
+        ASTARTE_LOG_ERR("Filters require an individual device owned datastream (%s).",
+            interface->name);
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+
+    const astarte_mapping_t *mapping = NULL;
+    for (size_t i = 0; i < interface->mappings_length; i++) {
+        if (strcmp(interface->mappings[i].endpoint, endpoint) == 0) {
+            mapping = &interface->mappings[i];
+            break;
+        }
+    }
+    if (!mapping) {
+        ASTARTE_LOG_ERR("Endpoint %s not found in interface %s.", endpoint, interface->name);
+        return ASTARTE_RESULT_MAPPING_NOT_IN_INTERFACE;
+    }
+    if (mapping_filter
+        && (!is_filterable_type(mapping->type) || (mapping_filter->deadband_absolute < 0.0)
+            || (mapping_filter->deadband_relative < 0.0) || (mapping_filter->max_rate < 0.0))) {
+        ASTARTE_LOG_ERR("Invalid filter for the endpoint %s.", endpoint);
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+
+    astarte_result_t ares = ASTARTE_RESULT_OK;
+    lock_filter(filter);
+    astarte_stream_filter_override_t *override = NULL;
+    astarte_stream_filter_override_t *unused = NULL;
+    for (size_t i = 0; i < ARRAY_SIZE(filter->overrides); i++) {
+        if (filter->overrides[i].mapping == mapping) {
+            override = &filter->overrides[i];
+            break;
+        }
+        if (!unused && !filter->overrides[i].mapping) {
+            unused = &filter->overrides[i];
+        }
+    }
+
+    if (!mapping_filter) {
+        if (override) {
+            override->mapping = NULL;
+        }
+        goto exit;
+    }
+
+    if (!override) {
+        override = unused;
+    }
+    if (!override) {
+        ASTARTE_LOG_ERR("No space left for the mapping filters, increase "
+                        "CONFIG_ASTARTE_DEVICE_SDK_STREAM_FILTERS_OVERRIDES.");
+        ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+        goto exit;
+    }
+    override->mapping = mapping;
+    override->filter = *mapping_filter;
+
+exit:
+    unlock_filter(filter);
+    return ares;
+}
+
+bool astarte_stream_filter_check(astarte_stream_filter_t *filter,
+    const astarte_interface_t *interface, const astarte_mapping_t *mapping, const char *path,
+    astarte_data_t value, const int64_t *timestamp)
+{
+    bool send = true;
+
+    lock_filter(filter);
+    const astarte_mapping_filter_t *mapping_filter = get_mapping_filter(filter, mapping);
+    if (!mapping_filter || !is_filterable_type(mapping->type)) {
+        goto exit;
+    }
+
+    // Without an entry the value is sent unfiltered
+    astarte_stream_filter_entry_t *entry = get_entry(filter, interface->name, path);
+    if (!entry) {
+        goto exit;
+    }
+
+    int64_t now = k_uptime_ticks();
+    if (entry->has_last) {
+        int64_t elapsed = now - entry->last_ticks;
+        int64_t interval_ticks = (int64_t) k_ms_to_ticks_ceil64(mapping_filter->min_interval_ms);
+        int64_t rate_ticks = (mapping_filter->max_rate > 0.0)
+            ? (int64_t) (CONFIG_SYS_CLOCK_TICKS_PER_SEC / mapping_filter->max_rate)
+            : 0;
+
+        if (within_deadband(mapping_filter, entry->last_value, value)) {
+            // The last sent value represents the current one, a held value would be outdated
+            ASTARTE_LOG_DBG("Dropping the value for %s%s.", interface->name, path);
+            ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED);
+            entry->has_pending = false;
+            send = false;
+            goto exit;
+        }
+        if (elapsed < interval_ticks) {
+            ASTARTE_LOG_DBG("Dropping the value for %s%s.", interface->name, path);
+            ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED);
+            send = false;
+            goto exit;
+        }
+        if (elapsed < rate_ticks) {
+            // Only the latest value is held, replacing any previous one
+            if (entry->has_pending) {
+                ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED);
+            }
+            ASTARTE_LOG_DBG("Holding the value for %s%s.", interface->name, path);
+            entry->has_pending = true;
+            entry->pending_value = value;
+            entry->pending_has_timestamp = (timestamp != NULL);
+            entry->pending_timestamp = (timestamp) ? *timestamp : 0;
+            entry->pending_ticks = entry->last_ticks + rate_ticks;
+            send = false;
+            goto exit;
+        }
+    }
+
+    entry->has_last = true;
+    entry->last_value = value;
+    entry->last_ticks = now;
+    entry->has_pending = false;
+
+exit:
+    unlock_filter(filter);
+    return send;
+}
+
+astarte_result_t astarte_stream_filter_pop_due(
+    astarte_stream_filter_t *filter, astarte_stream_filter_sample_t *sample)
+{
+    astarte_result_t ares = ASTARTE_RESULT_NOT_FOUND;
+
+    lock_filter(filter);
+    int64_t now = k_uptime_ticks();
+    for (size_t i = 0; i < ARRAY_SIZE(filter->entries); i++) {
+        astarte_stream_filter_entry_t *entry = &filter->entries[i];
+        if (!entry->interface_name || !entry->has_pending || (entry->pending_ticks > now)) {
+            continue;
+        }
+
+        entry->has_pending = false;
+        char *interface_name = copy_string(entry->interface_name);
+        char *path = copy_string(entry->path);
+        if (!interface_name || !path) {
+            ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+            astarte_free(interface_name);
+            astarte_free(path);
+            ares = ASTARTE_RESULT_OUT_OF_MEMORY;
+            break;
+        }
+
+        *sample = (astarte_stream_filter_sample_t) {
+            .interface_name = interface_name,
+            .path = path,
+            .value = entry->pending_value,
+            .has_timestamp = entry->pending_has_timestamp,
+            .timestamp = entry->pending_timestamp,
+        };
+        entry->last_value = entry->pending_value;
+        entry->last_ticks = now;
+        ares = ASTARTE_RESULT_OK;
+        break;
+    }
+    unlock_filter(filter);
+
+    return ares;
+}
+
+void astarte_stream_filter_sample_destroy(astarte_stream_filter_sample_t sample)
+{
+    astarte_free(sample.interface_name);
+    astarte_free(sample.path);
+}
+
+k_timeout_t astarte_stream_filter_get_deadline(astarte_stream_filter_t *filter)
+{
+    bool has_pending = false;
+    int64_t next_ticks = INT64_MAX;
+
+    lock_filter(filter);
+    for (size_t i = 0; i < ARRAY_SIZE(filter->entries); i++) {
+        const astarte_stream_filter_entry_t *entry = &filter->entries[i];
+        if (entry->interface_name && entry->has_pending) {
+            has_pending = true;
+            next_ticks = MIN(next_ticks, entry->pending_ticks);
+        }
+    }
+    unlock_filter(filter);
+
+    if (!has_pending) {
+        return K_FOREVER;
+    }
+    int64_t remaining = next_ticks - k_uptime_ticks();
+    return (remaining > 0) ? K_TICKS(remaining) : K_NO_WAIT;
+}
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+static void lock_filter(astarte_stream_filter_t *filter)
+{
+    int mutex_rc = sys_mutex_lock(&filter->mutex, K_FOREVER);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex lock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+
+static void unlock_filter(astarte_stream_filter_t *filter)
+{
+    int mutex_rc = sys_mutex_unlock(&filter->mutex);
+    ASTARTE_LOG_COND_ERR(mutex_rc != 0, "System mutex unlock failed with %d", mutex_rc);
+    __ASSERT_NO_MSG(mutex_rc == 0);
+}
+
+static const astarte_mapping_filter_t *get_mapping_filter(
+    const astarte_stream_filter_t *filter, const astarte_mapping_t *mapping)
+{
+    const astarte_mapping_filter_t *mapping_filter = mapping->filter;
+    for (size_t i = 0; i < ARRAY_SIZE(filter->overrides); i++) {
+        if (filter->overrides[i].mapping == mapping) {
+            mapping_filter = &filter->overrides[i].filter;
+            break;
+        }
+    }
+
+    // A zero initialized filter disables the filtering
+    if (!mapping_filter
+        || ((mapping_filter->deadband_absolute <= 0.0) && (mapping_filter->deadband_relative <= 0.0)
+            && (mapping_filter->min_interval_ms == 0) && (mapping_filter->max_rate <= 0.0))) {
+        return NULL;
+    }
+    return mapping_filter;
+}
+
+static bool is_filterable_type(astarte_mapping_type_t type)
+{
+    switch (type) {
+        case ASTARTE_MAPPING_TYPE_BOOLEAN:
+        case ASTARTE_MAPPING_TYPE_DATETIME:
+        case ASTARTE_MAPPING_TYPE_DOUBLE:
+        case ASTARTE_MAPPING_TYPE_INTEGER:
+        case ASTARTE_MAPPING_TYPE_LONGINTEGER:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static astarte_stream_filter_entry_t *get_entry(
+    astarte_stream_filter_t *filter, const char *interface_name, const char *path)
+{
+    astarte_stream_filter_entry_t *unused = NULL;
+    for (size_t i = 0; i < ARRAY_SIZE(filter->entries); i++) {
+        astarte_stream_filter_entry_t *entry = &filter->entries[i];
+        if (!entry->interface_name) {
+            unused = (unused) ? unused : entry;
+            continue;
+        }
+        if ((strcmp(entry->interface_name, interface_name) == 0)
+            && (strcmp(entry->path, path) == 0)) {
+            return entry;
+        }
+    }
+
+    astarte_stream_filter_entry_t *entry = unused;
+    if (!entry) {
+        entry = &filter->entries[filter->entries_next];
+        filter->entries_next = (filter->entries_next + 1) % ARRAY_SIZE(filter->entries);
+        if (entry->has_pending) {
+            ASTARTE_LOG_WRN(
+                "Dropping the held value for %s%s.", entry->interface_name, entry->path);
+            ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED);
+        }
+        astarte_free(entry->interface_name);
+        astarte_free(entry->path);
+        memset(entry, 0, sizeof(astarte_stream_filter_entry_t));
+    }
+
+    // The interface can be removed while the entry is in use, both the strings are owned by it
+    entry->interface_name = copy_string(interface_name);
+    entry->path = copy_string(path);
+    if (!entry->interface_name || !entry->path) {
+        ASTARTE_LOG_ERR("Out of memory %s: %d", __FILE__, __LINE__);
+        astarte_free(entry->interface_name);
+        astarte_free(entry->path);
+        memset(entry, 0, sizeof(astarte_stream_filter_entry_t));
+        return NULL;
+    }
+    return entry;
+}
+
+static char *copy_string(const char *string)
+{
+    size_t string_size = strlen(string) + 1;
+    char *copy = astarte_calloc(string_size, sizeof(char));
+    if (copy) {
+        memcpy(copy, string, string_size);
+    }
+    return copy;
+}
+
+static bool within_deadband(
+    const astarte_mapping_filter_t *mapping_filter, astarte_data_t last, astarte_data_t value)
+{
+    double last_number = 0.0;
+    double number = 0.0;
+    if (!to_number(last, &last_number) || !to_number(value, &number)) {
+        return false;
+    }
+
+    double delta = (number > last_number) ? number - last_number : last_number - number;
+    double magnitude = (last_number < 0.0) ? -last_number : last_number;
+    // A value is sent only when it exceeds all the configured deadbands
+    bool within_absolute = (mapping_filter->deadband_absolute > 0.0)
+        && (delta <= mapping_filter->deadband_absolute);
+    bool within_relative = (mapping_filter->deadband_relative > 0.0)
+        && (delta <= mapping_filter->deadband_relative * magnitude);
+    return within_absolute || within_relative;
+}
+
+static bool to_number(astarte_data_t value, double *number)
+{
+    switch (value.tag) {
+        case ASTARTE_MAPPING_TYPE_DOUBLE:
+            *number = value.data.dbl;
+            return true;
+        case ASTARTE_MAPPING_TYPE_INTEGER:
+            *number = (double) value.data.integer;
+            return true;
+        case ASTARTE_MAPPING_TYPE_LONGINTEGER:
+            *number = (double) value.data.longinteger;
+            return true;
+        default:
+            return false;
+    }
+}
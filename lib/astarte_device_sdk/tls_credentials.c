@@ -6,6 +6,7 @@
 #include "tls_credentials.h"
 
 #include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
 #include <zephyr/net/tls_credentials.h>
 
 #include "log.h"
@@ -58,5 +59,40 @@ astarte_result_t astarte_tls_credential_delete(void)
         return ASTARTE_RESULT_TLS_ERROR;
     }
 
+    astarte_tls_session_cache_purge();
+
+    return ASTARTE_RESULT_OK;
+}
+
+astarte_result_t astarte_tls_session_cache_enable(int sock)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TLS_SESSION_RESUMPTION)
+    int session_cache = TLS_SESSION_CACHE_ENABLED;
+    int sockopt_rc
+        = zsock_setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE, &session_cache, sizeof(session_cache));
+    if (sockopt_rc == -1) {
+        ASTARTE_LOG_ERR("Failed enabling the TLS session cache: %d.", errno);
+        return ASTARTE_RESULT_TLS_ERROR;
+    }
+#else
+    ARG_UNUSED(sock);
+#endif
     return ASTARTE_RESULT_OK;
 }
+
+void astarte_tls_session_cache_purge(void)
+{
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TLS_SESSION_RESUMPTION)
+    // The session cache is global, any TLS socket can be used to purge it
+    int sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+    if (sock == -1) {
+        ASTARTE_LOG_WRN("Failed creating a socket to purge the TLS session cache: %d.", errno);
+        return;
+    }
+    int sockopt_rc = zsock_setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE_PURGE, NULL, 0);
+    if (sockopt_rc == -1) {
+        ASTARTE_LOG_WRN("Failed purging the TLS session cache: %d.", errno);
+    }
+    zsock_close(sock);
+#endif
+}
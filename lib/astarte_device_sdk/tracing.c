@@ -0,0 +1,200 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "astarte_device_sdk/tracing.h"
+#include "tracing_private.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_NATIVE_LIBRARY)
+#include "host_clock.h"
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_ZEPHYR)
+#include <zephyr/tracing/tracing.h>
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+static const char *const stage_names[ASTARTE_TRACE_STAGE_COUNT] = {
+    [ASTARTE_TRACE_STAGE_TX_SEND] = "TX_SEND",
+    [ASTARTE_TRACE_STAGE_TX_VALIDATION] = "TX_VALIDATION",
+    [ASTARTE_TRACE_STAGE_TX_BSON_ENCODE] = "TX_BSON_ENCODE",
+    [ASTARTE_TRACE_STAGE_TX_MQTT_PUBLISH] = "TX_MQTT_PUBLISH",
+    [ASTARTE_TRACE_STAGE_TX_SOCKET_WRITE] = "TX_SOCKET_WRITE",
+    [ASTARTE_TRACE_STAGE_RX_MQTT_INPUT] = "RX_MQTT_INPUT",
+    [ASTARTE_TRACE_STAGE_RX_PUBLISH_EVENT] = "RX_PUBLISH_EVENT",
+    [ASTARTE_TRACE_STAGE_RX_DATA_MESSAGE] = "RX_DATA_MESSAGE",
+    [ASTARTE_TRACE_STAGE_RX_USER_CALLBACK] = "RX_USER_CALLBACK",
+};
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER)
+static astarte_trace_event_t ring[CONFIG_ASTARTE_DEVICE_SDK_TRACING_BUFFER_SIZE];
+/** @brief Index of the oldest trace point in #ring. */
+static size_t ring_tail;
+/** @brief Number of trace points stored in #ring. */
+static size_t ring_len;
+/** @brief Number of trace points overwritten because #ring was full. */
+static uint32_t ring_overwritten;
+/** @brief Protects the ring buffer, held only for the copy of a single trace point on emission. */
+static struct k_spinlock ring_lock;
+#endif
+
+/************************************************
+ *         Static functions declaration         *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER)
+/**
+ * @brief Get the timestamp of a trace point.
+ *
+ * @details On native_sim the host monotonic clock is used, as the simulated clock does not advance
+ * while the CPU is busy. On hardware the cycle counter is used when it does not wrap, the system
+ * clock otherwise.
+ *
+ * @return The timestamp in microseconds.
+ */
+static uint64_t get_timestamp_us(void);
+#endif
+
+/************************************************
+ *     Global public functions definitions      *
+ ***********************************************/
+
+const char *astarte_trace_stage_to_name(astarte_trace_stage_t stage)
+{
+    if ((unsigned int) stage >= ASTARTE_TRACE_STAGE_COUNT) {
+        return "UNKNOWN";
+    }
+    return stage_names[stage];
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER)
+
+size_t astarte_trace_read(astarte_trace_event_t *events, size_t events_len)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+    size_t read = MIN(ring_len, events_len);
+    for (size_t i = 0; i < read; i++) {
+        events[i] = ring[ring_tail];
+        ring_tail = (ring_tail + 1) % ARRAY_SIZE(ring);
+    }
+    ring_len -= read;
+    k_spin_unlock(&ring_lock, key);
+    return read;
+}
+
+uint32_t astarte_trace_get_overwritten(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+    uint32_t overwritten = ring_overwritten;
+    k_spin_unlock(&ring_lock, key);
+    return overwritten;
+}
+
+void astarte_trace_clear(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+    ring_tail = 0;
+    ring_len = 0;
+    ring_overwritten = 0;
+    k_spin_unlock(&ring_lock, key);
+}
+
+#endif /* defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER) */
+
+/************************************************
+ *     Global private functions definitions     *
+ ***********************************************/
+
+void astarte_trace_emit(astarte_trace_stage_t stage, bool begin)
+{
+    __ASSERT_NO_MSG((unsigned int) stage < ASTARTE_TRACE_STAGE_COUNT);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_ZEPHYR)
+    sys_trace_named_event(stage_names[stage], (uint32_t) stage, begin ? 1U : 0U);
+#else
+    astarte_trace_event_t event = {
+        .timestamp_us = get_timestamp_us(),
+        .thread_id = (uintptr_t) k_current_get(),
+        .stage = stage,
+        .begin = begin,
+    };
+
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+    if (ring_len == ARRAY_SIZE(ring)) {
+        // Drop the oldest trace point to make room for the new one
+        ring_tail = (ring_tail + 1) % ARRAY_SIZE(ring);
+        ring_len--;
+        ring_overwritten++;
+    }
+    ring[(ring_tail + ring_len) % ARRAY_SIZE(ring)] = event;
+    ring_len++;
+    k_spin_unlock(&ring_lock, key);
+#endif
+}
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER)
+static uint64_t get_timestamp_us(void)
+{
+#if defined(CONFIG_NATIVE_LIBRARY)
+    return astarte_host_clock_get_us();
+#elif defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+    return k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+#endif
+}
+#endif
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_SHELL)
+
+static int cmd_trace_dump(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "Overwritten trace points: %u", astarte_trace_get_overwritten());
+
+    astarte_trace_event_t event = { 0 };
+    while (astarte_trace_read(&event, 1) == 1) {
+        shell_print(sh, "%12llu %#lx %-5s %s", (unsigned long long) event.timestamp_us,
+            (unsigned long) event.thread_id, event.begin ? "BEGIN" : "END",
+            stage_names[event.stage]);
+    }
+
+    return 0;
+}
+
+static int cmd_trace_clear(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    astarte_trace_clear();
+    shell_print(sh, "Trace points cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(astarte_trace_cmds,
+    SHELL_CMD(dump, NULL, "Print and remove the Astarte device SDK trace points.", cmd_trace_dump),
+    SHELL_CMD(clear, NULL, "Remove the Astarte device SDK trace points.", cmd_trace_clear),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(astarte_trace, &astarte_trace_cmds, "Astarte device SDK tracing", NULL);
+
+#endif /* defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_SHELL) */
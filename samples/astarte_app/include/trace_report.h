@@ -0,0 +1,18 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TRACE_REPORT_H
+#define TRACE_REPORT_H
+
+/**
+ * @brief Drain the SDK trace points and log the latency breakdown of each hot path stage.
+ *
+ * @details Each begin trace point is paired with the following end trace point of the same stage
+ * emitted by the same thread. Stages without an end trace point, which failed, are not accounted.
+ */
+void sample_trace_report(void);
+
+#endif // TRACE_REPORT_H
@@ -7,6 +7,9 @@
 
 #include "generated_interfaces.h"
 
+#include <stdint.h>
+#include <string.h>
+
 // Interface names should resemble as closely as possible their respective .json file names.
 // NOLINTBEGIN(readability-identifier-naming)
 
@@ -18,6 +21,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/integer_endpoint",
@@ -25,6 +30,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/boolean_endpoint",
@@ -32,6 +39,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/longinteger_endpoint",
@@ -39,6 +48,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/string_endpoint",
@@ -46,6 +57,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/binaryblob_endpoint",
@@ -53,6 +66,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/datetime_endpoint",
@@ -60,6 +75,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/doublearray_endpoint",
@@ -67,6 +84,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/integerarray_endpoint",
@@ -74,6 +93,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/booleanarray_endpoint",
@@ -81,6 +102,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/longintegerarray_endpoint",
@@ -88,6 +111,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/stringarray_endpoint",
@@ -95,6 +120,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/binaryblobarray_endpoint",
@@ -102,6 +129,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/datetimearray_endpoint",
@@ -109,6 +138,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
 };
 
@@ -131,6 +162,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/binaryblobarray_endpoint",
@@ -138,6 +171,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/boolean_endpoint",
@@ -145,6 +180,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/booleanarray_endpoint",
@@ -152,6 +189,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/datetime_endpoint",
@@ -159,6 +198,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/datetimearray_endpoint",
@@ -166,6 +207,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/double_endpoint",
@@ -173,6 +216,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/doublearray_endpoint",
@@ -180,6 +225,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/integer_endpoint",
@@ -187,6 +234,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/integerarray_endpoint",
@@ -194,6 +243,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/longinteger_endpoint",
@@ -201,6 +252,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/longintegerarray_endpoint",
@@ -208,6 +261,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/string_endpoint",
@@ -215,6 +270,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/stringarray_endpoint",
@@ -222,6 +279,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DeviceDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
 };
 
@@ -244,6 +303,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/integer_endpoint",
@@ -251,6 +312,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/boolean_endpoint",
@@ -258,6 +321,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/longinteger_endpoint",
@@ -265,6 +330,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/string_endpoint",
@@ -272,6 +339,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/binaryblob_endpoint",
@@ -279,6 +348,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/datetime_endpoint",
@@ -286,6 +357,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/doublearray_endpoint",
@@ -293,6 +366,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/integerarray_endpoint",
@@ -300,6 +375,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/booleanarray_endpoint",
@@ -307,6 +384,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/longintegerarray_endpoint",
@@ -314,6 +393,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/stringarray_endpoint",
@@ -321,6 +402,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/binaryblobarray_endpoint",
@@ -328,6 +411,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/datetimearray_endpoint",
@@ -335,6 +420,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_DevicePropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
 };
 
@@ -357,6 +444,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/integer_endpoint",
@@ -364,6 +453,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/boolean_endpoint",
@@ -371,6 +462,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/longinteger_endpoint",
@@ -378,6 +471,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/string_endpoint",
@@ -385,6 +480,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/binaryblob_endpoint",
@@ -392,6 +489,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/datetime_endpoint",
@@ -399,6 +498,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/doublearray_endpoint",
@@ -406,6 +507,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/integerarray_endpoint",
@@ -413,6 +516,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/booleanarray_endpoint",
@@ -420,6 +525,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/longintegerarray_endpoint",
@@ -427,6 +534,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/stringarray_endpoint",
@@ -434,6 +543,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/binaryblobarray_endpoint",
@@ -441,6 +552,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/datetimearray_endpoint",
@@ -448,6 +561,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerAggrega
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
 };
 
@@ -470,6 +585,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/binaryblobarray_endpoint",
@@ -477,6 +594,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/boolean_endpoint",
@@ -484,6 +603,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/booleanarray_endpoint",
@@ -491,6 +612,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/datetime_endpoint",
@@ -498,6 +621,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/datetimearray_endpoint",
@@ -505,6 +630,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/double_endpoint",
@@ -512,6 +639,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/doublearray_endpoint",
@@ -519,6 +648,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = true,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/integer_endpoint",
@@ -526,6 +657,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/integerarray_endpoint",
@@ -533,6 +666,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/longinteger_endpoint",
@@ -540,6 +675,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/longintegerarray_endpoint",
@@ -547,6 +684,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/string_endpoint",
@@ -554,6 +693,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
     {
         .endpoint = "/stringarray_endpoint",
@@ -561,6 +702,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerDatastr
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
         .explicit_timestamp = false,
         .allow_unset = false,
+        .endpoint_segments = 1U,
+        .endpoint_parameters = 0x00000000U,
     },
 };
 
@@ -583,6 +726,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/integer_endpoint",
@@ -590,6 +735,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/boolean_endpoint",
@@ -597,6 +744,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/longinteger_endpoint",
@@ -604,6 +753,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/string_endpoint",
@@ -611,6 +762,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/binaryblob_endpoint",
@@ -618,6 +771,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/datetime_endpoint",
@@ -625,6 +780,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/doublearray_endpoint",
@@ -632,6 +789,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/integerarray_endpoint",
@@ -639,6 +798,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/booleanarray_endpoint",
@@ -646,6 +807,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/longintegerarray_endpoint",
@@ -653,6 +816,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/stringarray_endpoint",
@@ -660,6 +825,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/binaryblobarray_endpoint",
@@ -667,6 +834,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
     {
         .endpoint = "/%{sensor_id}/datetimearray_endpoint",
@@ -674,6 +843,8 @@ static const astarte_mapping_t org_astarteplatform_zephyr_examples_ServerPropert
         .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
         .explicit_timestamp = false,
         .allow_unset = true,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
     },
 };
 
@@ -688,4 +859,138 @@ const astarte_interface_t org_astarteplatform_zephyr_examples_ServerProperty = {
     .mappings_length = 14U,
 };
 
+astarte_result_t org_astarteplatform_zephyr_examples_DeviceAggregate_send(
+    astarte_device_handle_t device, const char *path,
+    const org_astarteplatform_zephyr_examples_DeviceAggregate_object_t *object,
+    const int64_t *timestamp)
+{
+    if (!object) {
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+    const astarte_data_t values[14] = {
+        astarte_data_from_double(object->double_endpoint),
+        astarte_data_from_integer(object->integer_endpoint),
+        astarte_data_from_boolean(object->boolean_endpoint),
+        astarte_data_from_longinteger(object->longinteger_endpoint),
+        astarte_data_from_string(object->string_endpoint),
+        astarte_data_from_binaryblob(object->binaryblob_endpoint, object->binaryblob_endpoint_len),
+        astarte_data_from_datetime(object->datetime_endpoint),
+        astarte_data_from_double_array(object->doublearray_endpoint,
+            object->doublearray_endpoint_len),
+        astarte_data_from_integer_array(object->integerarray_endpoint,
+            object->integerarray_endpoint_len),
+        astarte_data_from_boolean_array(object->booleanarray_endpoint,
+            object->booleanarray_endpoint_len),
+        astarte_data_from_longinteger_array(object->longintegerarray_endpoint,
+            object->longintegerarray_endpoint_len),
+        astarte_data_from_string_array(object->stringarray_endpoint,
+            object->stringarray_endpoint_len),
+        astarte_data_from_binaryblob_array(object->binaryblobarray_endpoint,
+            object->binaryblobarray_endpoint_sizes, object->binaryblobarray_endpoint_count),
+        astarte_data_from_datetime_array(object->datetimearray_endpoint,
+            object->datetimearray_endpoint_len),
+    };
+    return astarte_device_send_object_values(device,
+        &org_astarteplatform_zephyr_examples_DeviceAggregate, path, values, timestamp);
+}
+
+astarte_result_t org_astarteplatform_zephyr_examples_ServerAggregate_decode(
+    const astarte_object_entry_t *entries, size_t entries_len,
+    org_astarteplatform_zephyr_examples_ServerAggregate_object_t *object)
+{
+    if (!object || (!entries && (entries_len != 0))) {
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+    for (size_t i = 0; i < entries_len; i++) {
+        astarte_result_t ares = ASTARTE_RESULT_MAPPING_NOT_IN_INTERFACE;
+        if (strcmp(entries[i].path, "double_endpoint") == 0) {
+            ares = astarte_data_to_double(entries[i].data, &object->double_endpoint);
+        } else if (strcmp(entries[i].path, "integer_endpoint") == 0) {
+            ares = astarte_data_to_integer(entries[i].data, &object->integer_endpoint);
+        } else if (strcmp(entries[i].path, "boolean_endpoint") == 0) {
+            ares = astarte_data_to_boolean(entries[i].data, &object->boolean_endpoint);
+        } else if (strcmp(entries[i].path, "longinteger_endpoint") == 0) {
+            ares = astarte_data_to_longinteger(entries[i].data, &object->longinteger_endpoint);
+        } else if (strcmp(entries[i].path, "string_endpoint") == 0) {
+            ares = astarte_data_to_string(entries[i].data, &object->string_endpoint);
+        } else if (strcmp(entries[i].path, "binaryblob_endpoint") == 0) {
+            ares = astarte_data_to_binaryblob(entries[i].data, &object->binaryblob_endpoint,
+                &object->binaryblob_endpoint_len);
+        } else if (strcmp(entries[i].path, "datetime_endpoint") == 0) {
+            ares = astarte_data_to_datetime(entries[i].data, &object->datetime_endpoint);
+        } else if (strcmp(entries[i].path, "doublearray_endpoint") == 0) {
+            ares = astarte_data_to_double_array(entries[i].data, &object->doublearray_endpoint,
+                &object->doublearray_endpoint_len);
+        } else if (strcmp(entries[i].path, "integerarray_endpoint") == 0) {
+            ares = astarte_data_to_integer_array(entries[i].data, &object->integerarray_endpoint,
+                &object->integerarray_endpoint_len);
+        } else if (strcmp(entries[i].path, "booleanarray_endpoint") == 0) {
+            ares = astarte_data_to_boolean_array(entries[i].data, &object->booleanarray_endpoint,
+                &object->booleanarray_endpoint_len);
+        } else if (strcmp(entries[i].path, "longintegerarray_endpoint") == 0) {
+            ares = astarte_data_to_longinteger_array(entries[i].data,
+                &object->longintegerarray_endpoint, &object->longintegerarray_endpoint_len);
+        } else if (strcmp(entries[i].path, "stringarray_endpoint") == 0) {
+            ares = astarte_data_to_string_array(entries[i].data, &object->stringarray_endpoint,
+                &object->stringarray_endpoint_len);
+        } else if (strcmp(entries[i].path, "binaryblobarray_endpoint") == 0) {
+            ares = astarte_data_to_binaryblob_array(entries[i].data,
+                &object->binaryblobarray_endpoint, &object->binaryblobarray_endpoint_sizes,
+                &object->binaryblobarray_endpoint_count);
+        } else if (strcmp(entries[i].path, "datetimearray_endpoint") == 0) {
+            ares = astarte_data_to_datetime_array(entries[i].data, &object->datetimearray_endpoint,
+                &object->datetimearray_endpoint_len);
+        }
+        if (ares != ASTARTE_RESULT_OK) {
+            return ares;
+        }
+    }
+    return ASTARTE_RESULT_OK;
+}
+
+const astarte_interface_t *const generated_interfaces[GENERATED_INTERFACES_COUNT] = {
+    &org_astarteplatform_zephyr_examples_ServerDatastream,
+    &org_astarteplatform_zephyr_examples_DeviceAggregate,
+    &org_astarteplatform_zephyr_examples_DeviceDatastream,
+    &org_astarteplatform_zephyr_examples_ServerAggregate,
+    &org_astarteplatform_zephyr_examples_ServerProperty,
+    &org_astarteplatform_zephyr_examples_DeviceProperty,
+};
+
+static const uint32_t generated_interfaces_seeds[GENERATED_INTERFACES_COUNT] = {
+    0U,
+    2U,
+    0U,
+    1U,
+    2U,
+    2U,
+};
+
+static uint32_t generated_interfaces_hash(const char *name, uint32_t seed)
+{
+    // 32 bits FNV-1a, the seed is mixed in the offset basis
+    uint32_t hash = 0x811C9DC5U ^ seed;
+    for (; *name != '\0'; name++) {
+        hash ^= (uint8_t) *name;
+        hash *= 0x01000193U;
+    }
+    // Final avalanche, otherwise the low bits of the hash would depend only on the seed low bits
+    hash ^= hash >> 16U;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 16U;
+    return hash;
+}
+
+const astarte_interface_t *generated_interfaces_find(const char *name)
+{
+    uint32_t bucket = generated_interfaces_hash(name, 0U) % GENERATED_INTERFACES_COUNT;
+    uint32_t slot = generated_interfaces_hash(name, generated_interfaces_seeds[bucket])
+        % GENERATED_INTERFACES_COUNT;
+    const astarte_interface_t *interface = generated_interfaces[slot];
+    if (strcmp(interface->name, name) != 0) {
+        return NULL;
+    }
+    return interface;
+}
+
 // NOLINTEND(readability-identifier-naming)
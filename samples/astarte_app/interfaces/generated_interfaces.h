@@ -12,8 +12,10 @@
 #ifndef GENERATED_INTERFACES_H
 #define GENERATED_INTERFACES_H
 
+#include <astarte_device_sdk/device.h>
 #include <astarte_device_sdk/interface.h>
 #include <astarte_device_sdk/mapping.h>
+#include <astarte_device_sdk/object.h>
 
 // Interface names should resemble as closely as possible their respective .json file names.
 // NOLINTBEGIN(readability-identifier-naming)
@@ -23,6 +25,112 @@ extern const astarte_interface_t org_astarteplatform_zephyr_examples_DevicePrope
 extern const astarte_interface_t org_astarteplatform_zephyr_examples_ServerAggregate;
 extern const astarte_interface_t org_astarteplatform_zephyr_examples_ServerDatastream;
 extern const astarte_interface_t org_astarteplatform_zephyr_examples_ServerProperty;
+
+/** @brief Typed object of the org.astarteplatform.zephyr.examples.DeviceAggregate interface. */
+typedef struct
+{
+    double double_endpoint;
+    int32_t integer_endpoint;
+    bool boolean_endpoint;
+    int64_t longinteger_endpoint;
+    const char *string_endpoint;
+    void *binaryblob_endpoint;
+    size_t binaryblob_endpoint_len;
+    int64_t datetime_endpoint;
+    double *doublearray_endpoint;
+    size_t doublearray_endpoint_len;
+    int32_t *integerarray_endpoint;
+    size_t integerarray_endpoint_len;
+    bool *booleanarray_endpoint;
+    size_t booleanarray_endpoint_len;
+    int64_t *longintegerarray_endpoint;
+    size_t longintegerarray_endpoint_len;
+    const char **stringarray_endpoint;
+    size_t stringarray_endpoint_len;
+    const void **binaryblobarray_endpoint;
+    size_t *binaryblobarray_endpoint_sizes;
+    size_t binaryblobarray_endpoint_count;
+    int64_t *datetimearray_endpoint;
+    size_t datetimearray_endpoint_len;
+} org_astarteplatform_zephyr_examples_DeviceAggregate_object_t;
+
+/**
+ * @brief Send an object of the org.astarteplatform.zephyr.examples.DeviceAggregate interface.
+ *
+ * @details The values are serialized in the order of the mappings, without resolving any path.
+ * The interface should have been added to the device introspection.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] path Path where to publish the object.
+ * @param[in] object Object to send.
+ * @param[in] timestamp Timestamp of the message, ignored if set to NULL.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t org_astarteplatform_zephyr_examples_DeviceAggregate_send(
+    astarte_device_handle_t device, const char *path,
+    const org_astarteplatform_zephyr_examples_DeviceAggregate_object_t *object,
+    const int64_t *timestamp);
+
+/** @brief Typed object of the org.astarteplatform.zephyr.examples.ServerAggregate interface. */
+typedef struct
+{
+    double double_endpoint;
+    int32_t integer_endpoint;
+    bool boolean_endpoint;
+    int64_t longinteger_endpoint;
+    const char *string_endpoint;
+    void *binaryblob_endpoint;
+    size_t binaryblob_endpoint_len;
+    int64_t datetime_endpoint;
+    double *doublearray_endpoint;
+    size_t doublearray_endpoint_len;
+    int32_t *integerarray_endpoint;
+    size_t integerarray_endpoint_len;
+    bool *booleanarray_endpoint;
+    size_t booleanarray_endpoint_len;
+    int64_t *longintegerarray_endpoint;
+    size_t longintegerarray_endpoint_len;
+    const char **stringarray_endpoint;
+    size_t stringarray_endpoint_len;
+    const void **binaryblobarray_endpoint;
+    size_t *binaryblobarray_endpoint_sizes;
+    size_t binaryblobarray_endpoint_count;
+    int64_t *datetimearray_endpoint;
+    size_t datetimearray_endpoint_len;
+} org_astarteplatform_zephyr_examples_ServerAggregate_object_t;
+
+/**
+ * @brief Decode the entries of a received object of the
+ * org.astarteplatform.zephyr.examples.ServerAggregate interface.
+ *
+ * @note Strings, binary blobs and arrays of the decoded object point to the data of the entries.
+ *
+ * @param[in] entries Entries of the received object.
+ * @param[in] entries_len Number of elements in the @p entries array.
+ * @param[out] object Decoded object.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+astarte_result_t org_astarteplatform_zephyr_examples_ServerAggregate_decode(
+    const astarte_object_entry_t *entries, size_t entries_len,
+    org_astarteplatform_zephyr_examples_ServerAggregate_object_t *object);
+
+/** @brief Number of generated interfaces. */
+#define GENERATED_INTERFACES_COUNT 6U
+
+/** @brief All the generated interfaces, ordered by their perfect hash. */
+extern const astarte_interface_t *const generated_interfaces[GENERATED_INTERFACES_COUNT];
+
+/**
+ * @brief Find a generated interface from its name.
+ *
+ * @details Uses a minimal perfect hash over the names of the generated interfaces, computed at
+ * generation time. The lookup hashes the name twice and performs a single string comparison.
+ *
+ * @param[in] name Name of the interface to find.
+ * @return The generated interface, NULL when no generated interface has the given name.
+ */
+const astarte_interface_t *generated_interfaces_find(const char *name);
+
 // NOLINTEND(readability-identifier-naming)
 
 #endif /* GENERATED_INTERFACES_H */
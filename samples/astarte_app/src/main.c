@@ -45,6 +45,9 @@
 #if defined(CONFIG_DEVICE_REGISTRATION)
 #include "register.h"
 #endif
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING)
+#include "trace_report.h"
+#endif
 
 /************************************************
  *       Checks over configuration values       *
@@ -192,6 +195,10 @@ int main(void)
         LOG_ERR("Failed in waiting for the Astarte rx threads to terminate."); // NOLINT
     }
 
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING)
+    sample_trace_report();
+#endif
+
     LOG_INF("Astarte device sample finished."); // NOLINT
     k_sleep(K_MSEC(MSEC_PER_SEC));
 
@@ -0,0 +1,135 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "trace_report.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+#include <astarte_device_sdk/tracing.h>
+
+LOG_MODULE_REGISTER(trace_report, CONFIG_TRACE_REPORT_LOG_LEVEL); // NOLINT
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER)
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+// Number of trace points read from the SDK ring buffer at once
+#define TRACE_READ_CHUNK 32
+// Maximum number of threads emitting trace points that can be told apart
+#define TRACE_MAX_THREADS 4
+
+struct stage_stats
+{
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t min_us;
+    uint32_t max_us;
+};
+
+struct thread_stages
+{
+    uintptr_t thread_id;
+    uint32_t pending;
+    uint64_t begin_us[ASTARTE_TRACE_STAGE_COUNT];
+};
+
+BUILD_ASSERT(ASTARTE_TRACE_STAGE_COUNT <= 32, "The pending stages do not fit the bitmask");
+
+static struct stage_stats stats[ASTARTE_TRACE_STAGE_COUNT];
+static struct thread_stages threads[TRACE_MAX_THREADS];
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static struct thread_stages *get_thread_stages(uintptr_t thread_id);
+static void account_event(astarte_trace_event_t event);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+void sample_trace_report(void)
+{
+    uint32_t overwritten = astarte_trace_get_overwritten();
+    astarte_trace_event_t events[TRACE_READ_CHUNK];
+    size_t read = 0;
+    do {
+        read = astarte_trace_read(events, ARRAY_SIZE(events));
+        for (size_t i = 0; i < read; i++) {
+            account_event(events[i]);
+        }
+    } while (read == ARRAY_SIZE(events));
+
+    LOG_INF("Per stage latency breakdown (us):"); // NOLINT
+    for (size_t i = 0; i < ASTARTE_TRACE_STAGE_COUNT; i++) {
+        if (stats[i].count == 0) {
+            continue;
+        }
+        LOG_INF("%-18s count %u min %u avg %u max %u", // NOLINT
+            astarte_trace_stage_to_name(i), stats[i].count, stats[i].min_us,
+            (uint32_t) (stats[i].sum_us / stats[i].count), stats[i].max_us);
+    }
+    if (overwritten > 0) {
+        LOG_WRN("%u trace points were overwritten, increase the ring buffer size.", // NOLINT
+            overwritten);
+    }
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static struct thread_stages *get_thread_stages(uintptr_t thread_id)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(threads); i++) {
+        if ((threads[i].thread_id == thread_id) || (threads[i].thread_id == 0)) {
+            threads[i].thread_id = thread_id;
+            return &threads[i];
+        }
+    }
+    return NULL;
+}
+
+static void account_event(astarte_trace_event_t event)
+{
+    struct thread_stages *thread = get_thread_stages(event.thread_id);
+    if (!thread) {
+        return;
+    }
+
+    if (event.begin) {
+        thread->begin_us[event.stage] = event.timestamp_us;
+        WRITE_BIT(thread->pending, event.stage, 1);
+        return;
+    }
+
+    if (!(thread->pending & BIT(event.stage))) {
+        // The begin trace point has been overwritten in the ring buffer
+        return;
+    }
+    WRITE_BIT(thread->pending, event.stage, 0);
+
+    uint32_t elapsed_us = (uint32_t) (event.timestamp_us - thread->begin_us[event.stage]);
+    struct stage_stats *stage = &stats[event.stage];
+    stage->min_us = (stage->count == 0) ? elapsed_us : MIN(stage->min_us, elapsed_us);
+    stage->max_us = MAX(stage->max_us, elapsed_us);
+    stage->sum_us += elapsed_us;
+    stage->count++;
+}
+
+#else /* defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER) */
+
+void sample_trace_report(void)
+{
+    LOG_DBG("Tracing to the ring buffer is disabled, no latency breakdown."); // NOLINT
+}
+
+#endif /* defined(CONFIG_ASTARTE_DEVICE_SDK_TRACING_BACKEND_RING_BUFFER) */
@@ -86,6 +86,8 @@ class WestCommandFormat(WestCommand):
                 "tests/lib/astarte_device_sdk/**/**/src/*.c",
                 "e2e/include/*.h",
                 "e2e/src/*.c",
+                "benchmarks/include/*.h",
+                "benchmarks/src/*.c",
             )
         ]
         for header_or_source in headers_and_sources:
@@ -16,6 +16,7 @@ import json
 import os
 import re
 import sys
+import textwrap
 from pathlib import Path
 from string import Template
 
@@ -119,12 +120,15 @@ interface_header_template = Template(
 #ifndef ${output_filename_cap}_H
 #define ${output_filename_cap}_H
 
+#include <astarte_device_sdk/device.h>
 #include <astarte_device_sdk/interface.h>
 #include <astarte_device_sdk/mapping.h>
+#include <astarte_device_sdk/object.h>
 
 // Interface names should resemble as closely as possible their respective .json file names.
 // NOLINTBEGIN(readability-identifier-naming)
 ${interfaces_declarations}
+${objects_declarations}${lookup_declarations}
 // NOLINTEND(readability-identifier-naming)
 
 #endif /* ${output_filename_cap}_H */
@@ -141,10 +145,13 @@ interface_source_template = Template(
 
 #include "${output_filename}.h"
 
+#include <stdint.h>
+#include <string.h>
+
 // Interface names should resemble as closely as possible their respective .json file names.
 // NOLINTBEGIN(readability-identifier-naming)
 ${interfaces_declarations}
-
+${objects_definitions}${lookup_definitions}
 // NOLINTEND(readability-identifier-naming)
 """
 )
@@ -154,7 +161,7 @@ interface_declaration_template = Template(
 )
 
 interface_definition_template = Template(
-    r"""
+    r"""${filters}
 static const astarte_mapping_t ${interface_name_sc}_mappings[${mappings_number}] = {
 ${mappings}
 };
@@ -179,9 +186,501 @@ mapping_definition_template = Template(
         .reliability = ${reliability},
         .explicit_timestamp = ${explicit_timestamp},
         .allow_unset = ${allow_unset},
+        .endpoint_segments = ${endpoint_segments}U,
+        .endpoint_parameters = ${endpoint_parameters}U,${filter}
     },"""
 )
 
+filter_definition_template = Template(
+    r"""
+static const astarte_mapping_filter_t ${filter_name} = {
+    .deadband_absolute = ${deadband_absolute},
+    .deadband_relative = ${deadband_relative},
+    .min_interval_ms = ${min_interval_ms}U,
+    .max_rate = ${max_rate},
+};
+"""
+)
+
+object_struct_template = Template(
+    r"""
+/** @brief Typed object of the ${interface_name} interface. */
+typedef struct
+{
+${fields}
+} ${interface_name_sc}_object_t;
+"""
+)
+
+object_send_declaration_template = Template(
+    r"""
+/**
+${brief}
+ *
+ * @details The values are serialized in the order of the mappings, without resolving any path.
+ * The interface should have been added to the device introspection.
+ *
+ * @param[in] device Handle to the device instance.
+ * @param[in] path Path where to publish the object.
+ * @param[in] object Object to send.
+ * @param[in] timestamp Timestamp of the message, ignored if set to NULL.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+${prototype};
+"""
+)
+
+object_decode_declaration_template = Template(
+    r"""
+/**
+${brief}
+ *
+ * @note Strings, binary blobs and arrays of the decoded object point to the data of the entries.
+ *
+ * @param[in] entries Entries of the received object.
+ * @param[in] entries_len Number of elements in the @p entries array.
+ * @param[out] object Decoded object.
+ * @return ASTARTE_RESULT_OK if successful, otherwise an error code.
+ */
+${prototype};
+"""
+)
+
+object_send_definition_template = Template(
+    r"""
+${prototype}
+{
+    if (!object) {
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+    const astarte_data_t values[${mappings_number}] = {
+${values}
+    };
+${send_call}
+}
+"""
+)
+
+object_decode_definition_template = Template(
+    r"""
+${prototype}
+{
+    if (!object || (!entries && (entries_len != 0))) {
+        return ASTARTE_RESULT_INVALID_PARAM;
+    }
+    for (size_t i = 0; i < entries_len; i++) {
+        astarte_result_t ares = ASTARTE_RESULT_MAPPING_NOT_IN_INTERFACE;
+        ${decoders}
+        if (ares != ASTARTE_RESULT_OK) {
+            return ares;
+        }
+    }
+    return ASTARTE_RESULT_OK;
+}
+"""
+)
+
+object_decoder_template = Template(
+    r"""if (strcmp(entries[i].path, "${key}") == 0) {
+${decode_call}
+        }"""
+)
+
+# For each mapping type the typed fields, as (C type, field name suffix) pairs
+object_fields_lookup = {
+    "binaryblob": [("void *", ""), ("size_t ", "_len")],
+    "boolean": [("bool ", "")],
+    "datetime": [("int64_t ", "")],
+    "double": [("double ", "")],
+    "integer": [("int32_t ", "")],
+    "longinteger": [("int64_t ", "")],
+    "string": [("const char *", "")],
+    "binaryblobarray": [("const void **", ""), ("size_t *", "_sizes"), ("size_t ", "_count")],
+    "booleanarray": [("bool *", ""), ("size_t ", "_len")],
+    "datetimearray": [("int64_t *", ""), ("size_t ", "_len")],
+    "doublearray": [("double *", ""), ("size_t ", "_len")],
+    "integerarray": [("int32_t *", ""), ("size_t ", "_len")],
+    "longintegerarray": [("int64_t *", ""), ("size_t ", "_len")],
+    "stringarray": [("const char **", ""), ("size_t ", "_len")],
+}
+
+lookup_declaration_template = Template(
+    r"""
+/** @brief Number of generated interfaces. */
+#define ${output_filename_cap}_COUNT ${interfaces_number}U
+
+/** @brief All the generated interfaces, ordered by their perfect hash. */
+extern const astarte_interface_t *const ${output_filename}[${output_filename_cap}_COUNT];
+
+/**
+ * @brief Find a generated interface from its name.
+ *
+ * @details Uses a minimal perfect hash over the names of the generated interfaces, computed at
+ * generation time. The lookup hashes the name twice and performs a single string comparison.
+ *
+ * @param[in] name Name of the interface to find.
+ * @return The generated interface, NULL when no generated interface has the given name.
+ */
+const astarte_interface_t *${output_filename}_find(const char *name);
+"""
+)
+
+lookup_definition_template = Template(
+    r"""
+const astarte_interface_t *const ${output_filename}[${output_filename_cap}_COUNT] = {
+${lookup_slots}
+};
+
+static const uint32_t ${output_filename}_seeds[${output_filename_cap}_COUNT] = {
+${lookup_seeds}
+};
+
+static uint32_t ${output_filename}_hash(const char *name, uint32_t seed)
+{
+    // 32 bits FNV-1a, the seed is mixed in the offset basis
+    uint32_t hash = ${hash_offset_basis}U ^ seed;
+    for (; *name != '\0'; name++) {
+        hash ^= (uint8_t) *name;
+        hash *= ${hash_prime}U;
+    }
+    // Final avalanche, otherwise the low bits of the hash would depend only on the seed low bits
+    hash ^= hash >> 16U;
+    hash *= ${hash_mix}U;
+    hash ^= hash >> 16U;
+    return hash;
+}
+
+const astarte_interface_t *${output_filename}_find(const char *name)
+{
+    uint32_t bucket = ${output_filename}_hash(name, 0U) % ${output_filename_cap}_COUNT;
+    uint32_t slot = ${output_filename}_hash(name, ${output_filename}_seeds[bucket])
+        % ${output_filename_cap}_COUNT;
+    const astarte_interface_t *interface = ${output_filename}[slot];
+    if (strcmp(interface->name, name) != 0) {
+        return NULL;
+    }
+    return interface;
+}
+"""
+)
+
+fnv_offset_basis = 0x811C9DC5
+fnv_prime = 0x01000193
+fnv_mix = 0x85EBCA6B
+# The parametric segments of an endpoint are stored as a 32 bits mask
+max_precomputed_segments = 32
+max_seed_attempts = 1 << 20
+# Fields of the "x-zephyr-filter" extension of a mapping, matching astarte_mapping_filter_t
+filter_keys = ["deadband_absolute", "deadband_relative", "min_interval_ms", "max_rate"]
+# Column limit of the generated code, as enforced by the repository clang-format configuration
+max_line_len = 100
+# Indentation of the continuation lines of the generated code
+continuation_indent = 4
+
+
+def wrap_call(head: str, args: list[str], tail: str, indent: int) -> str:
+    """
+    Format a function call or prototype within the column limit, packing the arguments on
+    continuation lines as clang-format does.
+
+    Parameters
+    ----------
+    head : str
+        Code preceding the opening parenthesis.
+    args : list[str]
+        Arguments or parameters of the function.
+    tail : str
+        Code following the closing parenthesis.
+    indent : int
+        Indentation of the first line.
+
+    Returns
+    -------
+    str
+        The formatted code, without a trailing newline.
+    """
+    continuation = " " * (indent + continuation_indent)
+    lines = []
+    current = " " * indent + head + "("
+    separator = ""
+    for index, arg in enumerate(args):
+        token = arg + (")" + tail if index == len(args) - 1 else ",")
+        if len(current + separator + token) > max_line_len and current != continuation:
+            lines.append(current)
+            current, separator = continuation, ""
+        current += separator + token
+        separator = " "
+    lines.append(current)
+    return "\n".join(lines)
+
+
+def wrap_brief(brief: str) -> str:
+    """
+    Format the brief description of a doxygen comment within the column limit.
+
+    Parameters
+    ----------
+    brief : str
+        Text of the brief description.
+
+    Returns
+    -------
+    str
+        The formatted comment lines, without a trailing newline.
+    """
+    return textwrap.fill(
+        "@brief " + brief, width=max_line_len, initial_indent=" * ", subsequent_indent=" * "
+    )
+
+
+def fnv1a_hash(name: str, seed: int) -> int:
+    """
+    Compute the seeded 32 bits FNV-1a hash of a string followed by a final avalanche step, as
+    done by the generated C code.
+
+    Parameters
+    ----------
+    name : str
+        String to hash.
+    seed : int
+        Seed to mix in the offset basis.
+
+    Returns
+    -------
+    int
+        The computed hash.
+    """
+    value = (fnv_offset_basis ^ seed) & 0xFFFFFFFF
+    for byte in name.encode("utf-8"):
+        value ^= byte
+        value = (value * fnv_prime) & 0xFFFFFFFF
+    value ^= value >> 16
+    value = (value * fnv_mix) & 0xFFFFFFFF
+    value ^= value >> 16
+    return value
+
+
+def perfect_hash(names: list[str]) -> tuple[list[int], list[int]]:
+    """
+    Build a minimal perfect hash over a set of names using the hash and displace algorithm.
+
+    Each name is placed in a bucket using the unseeded hash. Then, starting from the largest
+    bucket, a seed is searched that places all the names of the bucket in free slots.
+
+    Parameters
+    ----------
+    names : list[str]
+        Unique names to hash.
+
+    Returns
+    -------
+    tuple[list[int], list[int]]
+        The seed for each bucket and the index of the name stored in each slot.
+    """
+    size = len(names)
+    buckets = [[] for _ in range(size)]
+    for index, name in enumerate(names):
+        buckets[fnv1a_hash(name, 0) % size].append(index)
+
+    seeds = [0] * size
+    slots = [None] * size
+    for bucket_index in sorted(range(size), key=lambda b: len(buckets[b]), reverse=True):
+        bucket = buckets[bucket_index]
+        if not bucket:
+            break
+        for seed in range(1, max_seed_attempts):
+            candidates = [fnv1a_hash(names[i], seed) % size for i in bucket]
+            if len(set(candidates)) == len(candidates) and all(
+                slots[c] is None for c in candidates
+            ):
+                break
+        else:
+            log.die(f"Could not compute a perfect hash for the interface names: {names}")
+        seeds[bucket_index] = seed
+        for index, candidate in zip(bucket, candidates):
+            slots[candidate] = index
+
+    return seeds, slots
+
+
+def object_stubs(interface: Interface, interface_name_sc: str) -> tuple[str, str]:
+    """
+    Generate the typed object and its send or decode function for an object interface.
+
+    Parameters
+    ----------
+    interface : Interface
+        Object interface for which to generate the stubs.
+    interface_name_sc : str
+        Name of the interface converted to a valid C identifier.
+
+    Returns
+    -------
+    tuple[str, str]
+        The declarations for the header and the definitions for the source.
+    """
+    fields = []
+    values = []
+    decoders = []
+    for mapping in interface.mappings:
+        key = mapping.endpoint.split("/")[-1]
+        name = re.sub(r"[^a-zA-Z0-9_]", "_", key)
+        if name[0].isdigit():
+            name = "_" + name
+        members = [name + suffix for _, suffix in object_fields_lookup[mapping.type]]
+        # The data functions use an underscore to separate the array suffix
+        data_type = re.sub(r"array$", "_array", mapping.type)
+        fields.extend(
+            f"    {ctype}{member};"
+            for (ctype, _), member in zip(object_fields_lookup[mapping.type], members)
+        )
+        values.append(
+            wrap_call(
+                f"astarte_data_from_{data_type}",
+                [f"object->{member}" for member in members],
+                ",",
+                8,
+            )
+        )
+        decoders.append(
+            object_decoder_template.substitute(
+                key=key,
+                decode_call=wrap_call(
+                    f"ares = astarte_data_to_{data_type}",
+                    ["entries[i].data"] + [f"&object->{member}" for member in members],
+                    ";",
+                    12,
+                ),
+            )
+        )
+
+    declarations = object_struct_template.substitute(
+        interface_name=interface.name,
+        interface_name_sc=interface_name_sc,
+        fields="\n".join(fields),
+    )
+    if interface.is_server_owned():
+        prototype = wrap_call(
+            f"astarte_result_t {interface_name_sc}_decode",
+            [
+                "const astarte_object_entry_t *entries",
+                "size_t entries_len",
+                f"{interface_name_sc}_object_t *object",
+            ],
+            "",
+            0,
+        )
+        declarations += object_decode_declaration_template.substitute(
+            brief=wrap_brief(
+                f"Decode the entries of a received object of the {interface.name} interface."
+            ),
+            prototype=prototype,
+        )
+        definitions = object_decode_definition_template.substitute(
+            prototype=prototype, decoders=" else ".join(decoders)
+        )
+    else:
+        prototype = wrap_call(
+            f"astarte_result_t {interface_name_sc}_send",
+            [
+                "astarte_device_handle_t device",
+                "const char *path",
+                f"const {interface_name_sc}_object_t *object",
+                "const int64_t *timestamp",
+            ],
+            "",
+            0,
+        )
+        declarations += object_send_declaration_template.substitute(
+            brief=wrap_brief(f"Send an object of the {interface.name} interface."),
+            prototype=prototype,
+        )
+        definitions = object_send_definition_template.substitute(
+            prototype=prototype,
+            mappings_number=len(interface.mappings),
+            values="\n".join(values),
+            send_call=wrap_call(
+                "return astarte_device_send_object_values",
+                ["device", f"&{interface_name_sc}", "path", "values", "timestamp"],
+                ";",
+                4,
+            ),
+        )
+    return declarations, definitions
+
+
+def mapping_filter(interface: Interface, mapping_json: dict, filter_name: str) -> str:
+    """
+    Generate the filter definition of a mapping from its "x-zephyr-filter" field.
+
+    Parameters
+    ----------
+    interface : Interface
+        Interface containing the mapping.
+    mapping_json : dict
+        Mapping definition, as found in the .json file.
+    filter_name : str
+        Name of the generated filter variable.
+
+    Returns
+    -------
+    str
+        The filter definition, empty when the mapping has no filter.
+    """
+    filter_json = mapping_json.get("x-zephyr-filter")
+    if filter_json is None:
+        return ""
+    endpoint = mapping_json["endpoint"]
+    if (
+        interface.is_type_properties()
+        or interface.is_server_owned()
+        or interface.is_aggregation_object()
+    ):
+        log.die(f"Filter of {endpoint} requires an individual device owned datastream.")
+    if mapping_json["type"] not in ["double", "integer", "longinteger", "boolean", "datetime"]:
+        log.die(f"Filter of {endpoint} requires a scalar mapping type.")
+    unknown = set(filter_json) - set(filter_keys)
+    if unknown:
+        log.die(f"Unknown filter fields for {endpoint}: {sorted(unknown)}")
+    values = {key: filter_json.get(key, 0) for key in filter_keys}
+    for key, value in values.items():
+        if not isinstance(value, (int, float)) or isinstance(value, bool) or value < 0:
+            log.die(f"Filter field {key} of {endpoint} must be a non negative number.")
+    if not isinstance(values["min_interval_ms"], int):
+        log.die(f"Filter field min_interval_ms of {endpoint} must be an integer.")
+    return filter_definition_template.substitute(
+        filter_name=filter_name,
+        deadband_absolute=float(values["deadband_absolute"]),
+        deadband_relative=float(values["deadband_relative"]),
+        min_interval_ms=values["min_interval_ms"],
+        max_rate=float(values["max_rate"]),
+    )
+
+
+def endpoint_matcher(endpoint: str) -> tuple[int, int]:
+    """
+    Precompute the segments count and the parametric segments mask of a mapping endpoint.
+
+    Parameters
+    ----------
+    endpoint : str
+        Mapping endpoint, in the form "/segment/%{param}/...".
+
+    Returns
+    -------
+    tuple[int, int]
+        The number of segments and the mask of parametric segments. Both are zero when the
+        endpoint has too many segments to be precomputed.
+    """
+    segments = endpoint.split("/")[1:]
+    if len(segments) > max_precomputed_segments:
+        return 0, 0
+    parameters = 0
+    for index, segment in enumerate(segments):
+        if re.fullmatch(r"%\{[a-zA-Z_][a-zA-Z0-9_]*\}", segment):
+            parameters |= 1 << index
+    return len(segments), parameters
+
 
 # pylint: disable-next=too-many-locals
 def generate_interfaces(interfaces_dir: Path, output_dir: Path, output_fn: str, check: bool):
@@ -203,14 +702,26 @@ def generate_interfaces(interfaces_dir: Path, output_dir: Path, output_fn: str,
     # Iterate over all the interfaces
     interfaces_declarations = []
     interfaces_structs = []
+    interfaces_names = []
+    objects_declarations = []
+    objects_definitions = []
     for interface_file in sorted([i for i in interfaces_dir.iterdir() if i.suffix == ".json"]):
         with open(interface_file, "r", encoding="utf-8") as interface_fp:
             interface_json = json.load(interface_fp)
             interface = Interface(interface_json)
 
             # Iterate over each mapping
+            interface_name_sc = interface.name.replace(".", "_").replace("-", "_")
+            mappings_json = {m["endpoint"]: m for m in interface_json["mappings"]}
+            filters_struct = []
             mappings_struct = []
-            for mapping in interface.mappings:
+            for index, mapping in enumerate(interface.mappings):
+                endpoint_segments, endpoint_parameters = endpoint_matcher(mapping.endpoint)
+                filter_name = f"{interface_name_sc}_filter_{index}"
+                filter_struct = mapping_filter(
+                    interface, mappings_json[mapping.endpoint], filter_name
+                )
+                filters_struct.append(filter_struct)
                 # Fill in the mapping information in the template
                 mapping_struct = mapping_definition_template.substitute(
                     endpoint=mapping.endpoint,
@@ -219,6 +730,9 @@ def generate_interfaces(interfaces_dir: Path, output_dir: Path, output_fn: str,
                     + reliability_lookup[mapping.reliability],
                     explicit_timestamp="true" if mapping.explicit_timestamp else "false",
                     allow_unset="true" if mapping.allow_unset else "false",
+                    endpoint_segments=endpoint_segments,
+                    endpoint_parameters=f"0x{endpoint_parameters:08X}",
+                    filter=f"\n        .filter = &{filter_name}," if filter_struct else "",
                 )
                 mappings_struct.append(mapping_struct)
 
@@ -244,8 +758,18 @@ def generate_interfaces(interfaces_dir: Path, output_dir: Path, output_fn: str,
                 ownership=iownership,
                 aggregation=iaggregation,
                 mappings="".join(mappings_struct),
+                filters="".join(filters_struct),
             )
             interfaces_structs.append(interface_struct)
+            interfaces_names.append(interface.name)
+
+            # Fill in the typed object stubs
+            if interface.is_aggregation_object():
+                object_declarations, object_definitions = object_stubs(
+                    interface, interface.name.replace(".", "_").replace("-", "_")
+                )
+                objects_declarations.append(object_declarations)
+                objects_definitions.append(object_definitions)
 
             # Fill in the extern definition
             interface_declaration = interface_declaration_template.substitute(
@@ -253,15 +777,43 @@ def generate_interfaces(interfaces_dir: Path, output_dir: Path, output_fn: str,
             )
             interfaces_declarations.append(interface_declaration)
 
+    # Fill in the perfect hash lookup, only when at least one interface has been generated
+    lookup_declarations = ""
+    lookup_definitions = ""
+    if interfaces_names:
+        seeds, slots = perfect_hash(interfaces_names)
+        lookup_declarations = lookup_declaration_template.substitute(
+            output_filename=output_fn,
+            output_filename_cap=output_fn.upper(),
+            interfaces_number=len(interfaces_names),
+        )
+        lookup_definitions = lookup_definition_template.substitute(
+            output_filename=output_fn,
+            output_filename_cap=output_fn.upper(),
+            lookup_slots="\n".join(
+                "    &" + interfaces_names[i].replace(".", "_").replace("-", "_") + ","
+                for i in slots
+            ),
+            lookup_seeds="\n".join(f"    {seed}U," for seed in seeds),
+            hash_offset_basis=f"0x{fnv_offset_basis:08X}",
+            hash_prime=f"0x{fnv_prime:08X}",
+            hash_mix=f"0x{fnv_mix:08X}",
+        )
+
     # Fill in the header
     interfaces_header = interface_header_template.substitute(
         output_filename=output_fn,
         output_filename_cap=output_fn.upper(),
         interfaces_declarations="\n".join(interfaces_declarations),
+        objects_declarations="".join(objects_declarations),
+        lookup_declarations=lookup_declarations,
     )
 
     interfaces_source = interface_source_template.substitute(
-        output_filename=output_fn, interfaces_declarations="\n".join(interfaces_structs)
+        output_filename=output_fn,
+        interfaces_declarations="\n".join(interfaces_structs),
+        objects_definitions="".join(objects_definitions),
+        lookup_definitions=lookup_definitions,
     )
 
     # Write the output files if required
@@ -0,0 +1,62 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+/**
+ * @file microbench.h
+ * @brief Timing and allocation accounting for the micro-benchmarks.
+ *
+ * @details The micro-benchmarks are built for the host, where the time is read from the monotonic
+ * clock and, on x86, the cycles from the time stamp counter. Allocations are counted through a
+ * custom SDK allocator installed by the test suite.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Iterations for the cheap operations, such as lookups and single appends. */
+#define MICROBENCH_ITERATIONS 10000
+/** @brief Iterations for the operations scaling with their input, such as array coding. */
+#define MICROBENCH_ITERATIONS_SCALED 1000
+
+/** @brief State of a running micro-benchmark. */
+typedef struct
+{
+    /** @brief Monotonic time in nanoseconds at the start */
+    uint64_t start_ns;
+    /** @brief Cycle counter at the start, zero when not available */
+    uint64_t start_cycles;
+    /** @brief Allocations counter at the start */
+    size_t start_allocs;
+} microbench_t;
+
+/**
+ * @brief Install the allocations counting allocator, to be called before any SDK allocation.
+ */
+void microbench_setup(void);
+
+/**
+ * @brief Start measuring a micro-benchmark.
+ *
+ * @param[out] bench Micro-benchmark state.
+ */
+void microbench_start(microbench_t *bench);
+
+/**
+ * @brief Stop measuring a micro-benchmark and report its per operation cost.
+ *
+ * @details Prints a single line prefixed by BENCHMARK_RESULT and followed by a JSON object with
+ * the nanoseconds, cycles and allocations per operation.
+ *
+ * @param[in] bench Micro-benchmark state, as filled by #microbench_start.
+ * @param[in] ops Number of operations run since the start.
+ * @param[in] name Name of the benchmark, as a printf format string followed by its arguments.
+ */
+void microbench_stop(const microbench_t *bench, size_t ops, const char *name, ...);
+
+#endif /* MICROBENCH_H */
@@ -0,0 +1,146 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "bson_deserializer.h"
+#include "bson_serializer.h"
+
+#include "microbench.h"
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+// Appends are measured on documents of this many elements, the document is rebuilt afterwards
+#define APPENDS_PER_DOCUMENT 16
+#define KEY_SIZE 16
+
+enum append_kind
+{
+    APPEND_DOUBLE = 0,
+    APPEND_INT32,
+    APPEND_INT64,
+    APPEND_BOOLEAN,
+    APPEND_DATETIME,
+    APPEND_STRING,
+    APPEND_BINARY,
+    APPEND_KIND_COUNT,
+};
+
+static const char *const append_names[APPEND_KIND_COUNT] = {
+    [APPEND_DOUBLE] = "double",
+    [APPEND_INT32] = "int32",
+    [APPEND_INT64] = "int64",
+    [APPEND_BOOLEAN] = "boolean",
+    [APPEND_DATETIME] = "datetime",
+    [APPEND_STRING] = "string",
+    [APPEND_BINARY] = "binary",
+};
+
+static const uint8_t binary_value[] = { 0xde, 0xad, 0xbe, 0xef, 0x00, 0x01, 0x02, 0x03 };
+static const size_t lookup_document_sizes[] = { 1, 8, 32, 128 };
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static void append_one(astarte_bson_serializer_t *bson, enum append_kind kind);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+ZTEST(astarte_device_sdk_microbench, test_bson_serializer_append)
+{
+    for (int kind = 0; kind < APPEND_KIND_COUNT; kind++) {
+        microbench_t bench = { 0 };
+        microbench_start(&bench);
+        for (size_t i = 0; i < MICROBENCH_ITERATIONS / APPENDS_PER_DOCUMENT; i++) {
+            astarte_bson_serializer_t bson = { 0 };
+            zassert_equal(astarte_bson_serializer_init(&bson), ASTARTE_RESULT_OK);
+            for (size_t j = 0; j < APPENDS_PER_DOCUMENT; j++) {
+                append_one(&bson, kind);
+            }
+            astarte_bson_serializer_append_end_of_document(&bson);
+            astarte_bson_serializer_destroy(&bson);
+        }
+        microbench_stop(&bench,
+            (MICROBENCH_ITERATIONS / APPENDS_PER_DOCUMENT) * APPENDS_PER_DOCUMENT,
+            "bson_append_%s", append_names[kind]);
+    }
+}
+
+ZTEST(astarte_device_sdk_microbench, test_bson_deserializer_element_lookup)
+{
+    for (size_t s = 0; s < ARRAY_SIZE(lookup_document_sizes); s++) {
+        size_t document_size = lookup_document_sizes[s];
+        char key[KEY_SIZE] = { 0 };
+
+        astarte_bson_serializer_t bson = { 0 };
+        zassert_equal(astarte_bson_serializer_init(&bson), ASTARTE_RESULT_OK);
+        for (size_t i = 0; i < document_size; i++) {
+            snprintf(key, sizeof(key), "key%zu", i);
+            astarte_bson_serializer_append_int32(&bson, key, (int32_t) i);
+        }
+        astarte_bson_serializer_append_end_of_document(&bson);
+        int len = 0;
+        const void *serialized = astarte_bson_serializer_get_serialized(bson, &len);
+        zassert_not_null(serialized);
+        astarte_bson_document_t document = astarte_bson_deserializer_init_doc(serialized);
+
+        // The last key is the worst case for the linear scan of the document
+        snprintf(key, sizeof(key), "key%zu", document_size - 1);
+        microbench_t bench = { 0 };
+        microbench_start(&bench);
+        for (size_t i = 0; i < MICROBENCH_ITERATIONS; i++) {
+            astarte_bson_element_t element = { 0 };
+            zassert_equal(astarte_bson_deserializer_element_lookup(document, key, &element),
+                ASTARTE_RESULT_OK);
+        }
+        microbench_stop(&bench, MICROBENCH_ITERATIONS, "bson_lookup_last_of_%zu", document_size);
+
+        astarte_bson_serializer_destroy(&bson);
+    }
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static void append_one(astarte_bson_serializer_t *bson, enum append_kind kind)
+{
+    switch (kind) {
+        case APPEND_DOUBLE:
+            astarte_bson_serializer_append_double(bson, "v", 42.5);
+            break;
+        case APPEND_INT32:
+            astarte_bson_serializer_append_int32(bson, "v", 42);
+            break;
+        case APPEND_INT64:
+            astarte_bson_serializer_append_int64(bson, "v", 3147483647);
+            break;
+        case APPEND_BOOLEAN:
+            astarte_bson_serializer_append_boolean(bson, "v", true);
+            break;
+        case APPEND_DATETIME:
+            astarte_bson_serializer_append_datetime(bson, "v", 1669111881000);
+            break;
+        case APPEND_STRING:
+            astarte_bson_serializer_append_string(bson, "v", "this is a test string");
+            break;
+        case APPEND_BINARY:
+            astarte_bson_serializer_append_binary(bson, "v", binary_value, sizeof(binary_value));
+            break;
+        default:
+            break;
+    }
+}
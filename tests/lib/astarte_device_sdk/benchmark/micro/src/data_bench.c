@@ -0,0 +1,191 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/data.h"
+#include "data_private.h"
+
+#include "bson_deserializer.h"
+#include "bson_serializer.h"
+
+#include "microbench.h"
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+#define ARRAY_MAX_SIZE 128
+#define DATA_KEY "v"
+
+static const size_t array_sizes[] = { 1, 16, ARRAY_MAX_SIZE };
+
+static const char *const type_names[] = {
+    [ASTARTE_MAPPING_TYPE_BINARYBLOB] = "binaryblob",
+    [ASTARTE_MAPPING_TYPE_BOOLEAN] = "boolean",
+    [ASTARTE_MAPPING_TYPE_DATETIME] = "datetime",
+    [ASTARTE_MAPPING_TYPE_DOUBLE] = "double",
+    [ASTARTE_MAPPING_TYPE_INTEGER] = "integer",
+    [ASTARTE_MAPPING_TYPE_LONGINTEGER] = "longinteger",
+    [ASTARTE_MAPPING_TYPE_STRING] = "string",
+    [ASTARTE_MAPPING_TYPE_BINARYBLOBARRAY] = "binaryblobarray",
+    [ASTARTE_MAPPING_TYPE_BOOLEANARRAY] = "booleanarray",
+    [ASTARTE_MAPPING_TYPE_DATETIMEARRAY] = "datetimearray",
+    [ASTARTE_MAPPING_TYPE_DOUBLEARRAY] = "doublearray",
+    [ASTARTE_MAPPING_TYPE_INTEGERARRAY] = "integerarray",
+    [ASTARTE_MAPPING_TYPE_LONGINTEGERARRAY] = "longintegerarray",
+    [ASTARTE_MAPPING_TYPE_STRINGARRAY] = "stringarray",
+};
+
+static uint8_t blob[] = { 0x41, 0x53, 0x54, 0x41, 0x52, 0x54, 0x45, 0x00 };
+static const char string[] = "this is a test string";
+
+static const void *blob_array[ARRAY_MAX_SIZE];
+static size_t blob_sizes[ARRAY_MAX_SIZE];
+static bool boolean_array[ARRAY_MAX_SIZE];
+static int64_t datetime_array[ARRAY_MAX_SIZE];
+static double double_array[ARRAY_MAX_SIZE];
+static int32_t integer_array[ARRAY_MAX_SIZE];
+static int64_t longinteger_array[ARRAY_MAX_SIZE];
+static const char *string_array[ARRAY_MAX_SIZE];
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static void fill_arrays(void);
+static astarte_data_t make_data(astarte_mapping_type_t type, size_t array_size);
+static void bench_data(astarte_mapping_type_t type, size_t array_size);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+ZTEST(astarte_device_sdk_microbench, test_data_serialize_deserialize_scalar)
+{
+    for (astarte_mapping_type_t type = ASTARTE_MAPPING_TYPE_BINARYBLOB;
+        type <= ASTARTE_MAPPING_TYPE_STRING; type++) {
+        bench_data(type, 0);
+    }
+}
+
+ZTEST(astarte_device_sdk_microbench, test_data_serialize_deserialize_array)
+{
+    fill_arrays();
+    for (astarte_mapping_type_t type = ASTARTE_MAPPING_TYPE_BINARYBLOBARRAY;
+        type <= ASTARTE_MAPPING_TYPE_STRINGARRAY; type++) {
+        for (size_t s = 0; s < ARRAY_SIZE(array_sizes); s++) {
+            bench_data(type, array_sizes[s]);
+        }
+    }
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static void fill_arrays(void)
+{
+    for (size_t i = 0; i < ARRAY_MAX_SIZE; i++) {
+        blob_array[i] = blob;
+        blob_sizes[i] = sizeof(blob);
+        boolean_array[i] = (i % 2) == 0;
+        datetime_array[i] = 1669111881000 + (int64_t) i;
+        double_array[i] = 21.5 * (double) i;
+        integer_array[i] = (int32_t) i;
+        longinteger_array[i] = 3147483647 + (int64_t) i;
+        string_array[i] = string;
+    }
+}
+
+static astarte_data_t make_data(astarte_mapping_type_t type, size_t array_size)
+{
+    switch (type) {
+        case ASTARTE_MAPPING_TYPE_BINARYBLOB:
+            return astarte_data_from_binaryblob(blob, sizeof(blob));
+        case ASTARTE_MAPPING_TYPE_BOOLEAN:
+            return astarte_data_from_boolean(true);
+        case ASTARTE_MAPPING_TYPE_DATETIME:
+            return astarte_data_from_datetime(1669111881000);
+        case ASTARTE_MAPPING_TYPE_DOUBLE:
+            return astarte_data_from_double(432.4324);
+        case ASTARTE_MAPPING_TYPE_INTEGER:
+            return astarte_data_from_integer(42);
+        case ASTARTE_MAPPING_TYPE_LONGINTEGER:
+            return astarte_data_from_longinteger(3147483647);
+        case ASTARTE_MAPPING_TYPE_STRING:
+            return astarte_data_from_string(string);
+        case ASTARTE_MAPPING_TYPE_BINARYBLOBARRAY:
+            return astarte_data_from_binaryblob_array(blob_array, blob_sizes, array_size);
+        case ASTARTE_MAPPING_TYPE_BOOLEANARRAY:
+            return astarte_data_from_boolean_array(boolean_array, array_size);
+        case ASTARTE_MAPPING_TYPE_DATETIMEARRAY:
+            return astarte_data_from_datetime_array(datetime_array, array_size);
+        case ASTARTE_MAPPING_TYPE_DOUBLEARRAY:
+            return astarte_data_from_double_array(double_array, array_size);
+        case ASTARTE_MAPPING_TYPE_INTEGERARRAY:
+            return astarte_data_from_integer_array(integer_array, array_size);
+        case ASTARTE_MAPPING_TYPE_LONGINTEGERARRAY:
+            return astarte_data_from_longinteger_array(longinteger_array, array_size);
+        case ASTARTE_MAPPING_TYPE_STRINGARRAY:
+        default:
+            return astarte_data_from_string_array(string_array, array_size);
+    }
+}
+
+static void bench_data(astarte_mapping_type_t type, size_t array_size)
+{
+    astarte_data_t data = make_data(type, array_size);
+    size_t iterations = (array_size > 1) ? MICROBENCH_ITERATIONS_SCALED : MICROBENCH_ITERATIONS;
+
+    microbench_t bench = { 0 };
+    microbench_start(&bench);
+    for (size_t i = 0; i < iterations; i++) {
+        astarte_bson_serializer_t bson = { 0 };
+        zassert_equal(astarte_bson_serializer_init(&bson), ASTARTE_RESULT_OK);
+        zassert_equal(astarte_data_serialize(&bson, DATA_KEY, data), ASTARTE_RESULT_OK);
+        astarte_bson_serializer_append_end_of_document(&bson);
+        astarte_bson_serializer_destroy(&bson);
+    }
+    if (array_size == 0) {
+        microbench_stop(&bench, iterations, "data_serialize_%s", type_names[type]);
+    } else {
+        microbench_stop(
+            &bench, iterations, "data_serialize_%s_%zu", type_names[type], array_size);
+    }
+
+    // The same document is deserialized at each iteration
+    astarte_bson_serializer_t bson = { 0 };
+    zassert_equal(astarte_bson_serializer_init(&bson), ASTARTE_RESULT_OK);
+    zassert_equal(astarte_data_serialize(&bson, DATA_KEY, data), ASTARTE_RESULT_OK);
+    astarte_bson_serializer_append_end_of_document(&bson);
+    int len = 0;
+    const void *serialized = astarte_bson_serializer_get_serialized(bson, &len);
+    zassert_not_null(serialized);
+    astarte_bson_document_t document = astarte_bson_deserializer_init_doc(serialized);
+    astarte_bson_element_t element = { 0 };
+    zassert_equal(
+        astarte_bson_deserializer_element_lookup(document, DATA_KEY, &element), ASTARTE_RESULT_OK);
+
+    microbench_start(&bench);
+    for (size_t i = 0; i < iterations; i++) {
+        astarte_data_t deserialized = { 0 };
+        zassert_equal(astarte_data_deserialize(element, type, &deserialized), ASTARTE_RESULT_OK);
+        astarte_data_destroy_deserialized(deserialized);
+    }
+    if (array_size == 0) {
+        microbench_stop(&bench, iterations, "data_deserialize_%s", type_names[type]);
+    } else {
+        microbench_stop(
+            &bench, iterations, "data_deserialize_%s_%zu", type_names[type], array_size);
+    }
+
+    astarte_bson_serializer_destroy(&bson);
+}
@@ -0,0 +1,28 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * @file astarte-device-sdk-zephyr/tests/lib/astarte_device_sdk/benchmark/micro/src/main.c
+ *
+ * @details This suite measures the cost per operation of the BSON, data, mapping and object
+ * modules. Each test prints one BENCHMARK_RESULT line per measured case.
+ */
+
+#include <zephyr/ztest.h>
+
+#include "microbench.h"
+
+static void *microbench_suite_setup(void)
+{
+    microbench_setup();
+    return NULL;
+}
+
+ZTEST_SUITE(astarte_device_sdk_microbench, NULL, microbench_suite_setup, NULL, NULL, NULL);
+
+// Define a minimal_log function to resolve the `undefined reference to z_log_minimal_printk` error,
+// because the log environment is missing in the unit_testing platform.
+void z_log_minimal_printk(const char *fmt, ...) {}
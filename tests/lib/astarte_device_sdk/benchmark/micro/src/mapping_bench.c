@@ -0,0 +1,162 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/interface.h"
+#include "astarte_device_sdk/mapping.h"
+#include "interface_private.h"
+#include "mapping_private.h"
+
+#include "microbench.h"
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+#define MAPPINGS_MAX_COUNT 128
+#define ENDPOINT_SIZE 32
+#define ENDPOINT_FORMAT "/%%{sensor_id}/m%zu"
+#define PATH_FORMAT "/sensor_1/m%zu"
+// Segments and parameters of the endpoints above, as precomputed by the interfaces generator
+#define ENDPOINT_SEGMENTS 2U
+#define ENDPOINT_PARAMETERS BIT(0)
+
+typedef struct
+{
+    const char *name;
+    astarte_mapping_t mapping;
+    const char *path;
+} check_path_case_t;
+
+static const check_path_case_t check_path_cases[] = {
+    {
+        .name = "literal",
+        .mapping = { .endpoint = "/sensors/room_1/temperature" },
+        .path = "/sensors/room_1/temperature",
+    },
+    {
+        .name = "literal_precomputed",
+        .mapping = { .endpoint = "/sensors/room_1/temperature", .endpoint_segments = 3U },
+        .path = "/sensors/room_1/temperature",
+    },
+    {
+        .name = "one_parameter",
+        .mapping = { .endpoint = "/%{sensor_id}/temperature" },
+        .path = "/sensor_1/temperature",
+    },
+    {
+        .name = "one_parameter_precomputed",
+        .mapping = { .endpoint = "/%{sensor_id}/temperature",
+            .endpoint_segments = 2U,
+            .endpoint_parameters = BIT(0) },
+        .path = "/sensor_1/temperature",
+    },
+    {
+        .name = "three_parameters",
+        .mapping = { .endpoint = "/%{building}/%{room}/%{sensor_id}/temperature" },
+        .path = "/building_1/room_1/sensor_1/temperature",
+    },
+    {
+        .name = "three_parameters_precomputed",
+        .mapping = { .endpoint = "/%{building}/%{room}/%{sensor_id}/temperature",
+            .endpoint_segments = 4U,
+            .endpoint_parameters = BIT(0) | BIT(1) | BIT(2) },
+        .path = "/building_1/room_1/sensor_1/temperature",
+    },
+};
+
+static const size_t mapping_counts[] = { 1, 8, 32, MAPPINGS_MAX_COUNT };
+
+static char endpoints[MAPPINGS_MAX_COUNT][ENDPOINT_SIZE];
+static astarte_mapping_t mappings[MAPPINGS_MAX_COUNT];
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static void fill_mappings(bool precomputed);
+static void bench_get_mapping_from_path(bool precomputed);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+ZTEST(astarte_device_sdk_microbench, test_mapping_check_path)
+{
+    for (size_t c = 0; c < ARRAY_SIZE(check_path_cases); c++) {
+        const check_path_case_t *test_case = &check_path_cases[c];
+        microbench_t bench = { 0 };
+        microbench_start(&bench);
+        for (size_t i = 0; i < MICROBENCH_ITERATIONS; i++) {
+            zassert_equal(astarte_mapping_check_path(test_case->mapping, test_case->path),
+                ASTARTE_RESULT_OK);
+        }
+        microbench_stop(&bench, MICROBENCH_ITERATIONS, "mapping_check_path_%s", test_case->name);
+    }
+}
+
+ZTEST(astarte_device_sdk_microbench, test_interface_get_mapping_from_path)
+{
+    bench_get_mapping_from_path(false);
+    bench_get_mapping_from_path(true);
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static void fill_mappings(bool precomputed)
+{
+    for (size_t i = 0; i < MAPPINGS_MAX_COUNT; i++) {
+        snprintf(endpoints[i], sizeof(endpoints[i]), ENDPOINT_FORMAT, i);
+        mappings[i] = (astarte_mapping_t) {
+            .endpoint = endpoints[i],
+            .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+            .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+            .endpoint_segments = (precomputed) ? ENDPOINT_SEGMENTS : 0U,
+            .endpoint_parameters = (precomputed) ? ENDPOINT_PARAMETERS : 0U,
+        };
+    }
+}
+
+static void bench_get_mapping_from_path(bool precomputed)
+{
+    fill_mappings(precomputed);
+
+    for (size_t c = 0; c < ARRAY_SIZE(mapping_counts); c++) {
+        size_t mapping_count = mapping_counts[c];
+        const astarte_interface_t interface = {
+            .name = "org.astarteplatform.zephyr.benchmark",
+            .major_version = 0,
+            .minor_version = 1,
+            .ownership = ASTARTE_INTERFACE_OWNERSHIP_DEVICE,
+            .type = ASTARTE_INTERFACE_TYPE_DATASTREAM,
+            .aggregation = ASTARTE_INTERFACE_AGGREGATION_INDIVIDUAL,
+            .mappings = mappings,
+            .mappings_length = mapping_count,
+        };
+
+        // The last mapping is the worst case for the linear scan of the interface
+        char path[ENDPOINT_SIZE] = { 0 };
+        snprintf(path, sizeof(path), PATH_FORMAT, mapping_count - 1);
+
+        microbench_t bench = { 0 };
+        microbench_start(&bench);
+        for (size_t i = 0; i < MICROBENCH_ITERATIONS; i++) {
+            const astarte_mapping_t *mapping = NULL;
+            zassert_equal(astarte_interface_get_mapping_from_path(&interface, path, &mapping),
+                ASTARTE_RESULT_OK);
+        }
+        microbench_stop(&bench, MICROBENCH_ITERATIONS, "interface_get_mapping_last_of_%zu%s",
+            mapping_count, (precomputed) ? "_precomputed" : "");
+    }
+}
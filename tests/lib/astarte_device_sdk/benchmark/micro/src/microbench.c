@@ -0,0 +1,90 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "microbench.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/heap.h"
+
+#include "host_clock.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MICROBENCH_HAS_CYCLES 1
+#endif
+
+#define RESULT_PREFIX "BENCHMARK_RESULT "
+#define NAME_SIZE 64
+
+static size_t allocs_count;
+
+static void *counting_alloc(size_t size, void *user_data)
+{
+    ARG_UNUSED(user_data);
+    allocs_count++;
+    return malloc(size);
+}
+
+static void counting_free(void *ptr, void *user_data)
+{
+    ARG_UNUSED(user_data);
+    free(ptr);
+}
+
+static uint64_t get_cycles(void)
+{
+#if defined(MICROBENCH_HAS_CYCLES)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+void microbench_setup(void)
+{
+    const astarte_heap_allocator_t allocator = {
+        .alloc = counting_alloc,
+        .free = counting_free,
+        .user_data = NULL,
+    };
+    zassert_equal(astarte_heap_set_allocator(&allocator), ASTARTE_RESULT_OK);
+}
+
+void microbench_start(microbench_t *bench)
+{
+    bench->start_allocs = allocs_count;
+    bench->start_ns = astarte_host_clock_get_ns();
+    bench->start_cycles = get_cycles();
+}
+
+void microbench_stop(const microbench_t *bench, size_t ops, const char *name, ...)
+{
+    uint64_t cycles = get_cycles() - bench->start_cycles;
+    uint64_t elapsed_ns = astarte_host_clock_get_ns() - bench->start_ns;
+    size_t allocs = allocs_count - bench->start_allocs;
+
+    char formatted_name[NAME_SIZE] = { 0 };
+    va_list args;
+    va_start(args, name);
+    vsnprintf(formatted_name, sizeof(formatted_name), name, args);
+    va_end(args);
+
+    printf(RESULT_PREFIX "{\"name\":\"%s\",\"type\":\"micro\",\"ops\":%zu,\"ns_per_op\":%.1f,",
+        formatted_name, ops, (double) elapsed_ns / (double) ops);
+#if defined(MICROBENCH_HAS_CYCLES)
+    printf("\"cycles_per_op\":%.1f,", (double) cycles / (double) ops);
+#else
+    ARG_UNUSED(cycles);
+    printf("\"cycles_per_op\":null,");
+#endif
+    printf("\"allocs_per_op\":%.2f}\n", (double) allocs / (double) ops);
+}
@@ -0,0 +1,128 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/interface.h"
+#include "astarte_device_sdk/mapping.h"
+#include "astarte_device_sdk/object.h"
+#include "object_private.h"
+
+#include "bson_deserializer.h"
+#include "bson_serializer.h"
+
+#include "microbench.h"
+
+/************************************************
+ * Constants, static variables and defines
+ ***********************************************/
+
+#define FIELDS_MAX_COUNT 64
+#define ENDPOINT_SIZE 32
+#define KEY_SIZE 16
+#define OBJECT_PATH "/sensor_1"
+
+static const size_t field_counts[] = { 1, 4, 16, FIELDS_MAX_COUNT };
+
+static char endpoints[FIELDS_MAX_COUNT][ENDPOINT_SIZE];
+static astarte_mapping_t mappings[FIELDS_MAX_COUNT];
+
+/************************************************
+ * Static functions declaration
+ ***********************************************/
+
+static void fill_mappings(void);
+static void serialize_object(astarte_bson_serializer_t *bson, size_t field_count);
+
+/************************************************
+ * Global functions definition
+ ***********************************************/
+
+ZTEST(astarte_device_sdk_microbench, test_object_entries_deserialize)
+{
+    fill_mappings();
+
+    for (size_t c = 0; c < ARRAY_SIZE(field_counts); c++) {
+        size_t field_count = field_counts[c];
+        const astarte_interface_t interface = {
+            .name = "org.astarteplatform.zephyr.benchmark.Object",
+            .major_version = 0,
+            .minor_version = 1,
+            .ownership = ASTARTE_INTERFACE_OWNERSHIP_SERVER,
+            .type = ASTARTE_INTERFACE_TYPE_DATASTREAM,
+            .aggregation = ASTARTE_INTERFACE_AGGREGATION_OBJECT,
+            .mappings = mappings,
+            .mappings_length = field_count,
+        };
+
+        astarte_bson_serializer_t bson = { 0 };
+        serialize_object(&bson, field_count);
+        int len = 0;
+        const void *serialized = astarte_bson_serializer_get_serialized(bson, &len);
+        zassert_not_null(serialized);
+        astarte_bson_document_t document = astarte_bson_deserializer_init_doc(serialized);
+        astarte_bson_element_t v_elem = { 0 };
+        zassert_equal(
+            astarte_bson_deserializer_element_lookup(document, "v", &v_elem), ASTARTE_RESULT_OK);
+
+        microbench_t bench = { 0 };
+        microbench_start(&bench);
+        for (size_t i = 0; i < MICROBENCH_ITERATIONS_SCALED; i++) {
+            astarte_object_entry_t *entries = NULL;
+            size_t entries_length = 0;
+            zassert_equal(astarte_object_entries_deserialize(
+                              v_elem, &interface, OBJECT_PATH, &entries, &entries_length),
+                ASTARTE_RESULT_OK);
+            zassert_equal(entries_length, field_count);
+            astarte_object_entries_destroy_deserialized(entries, entries_length);
+        }
+        microbench_stop(&bench, MICROBENCH_ITERATIONS_SCALED, "object_entries_deserialize_%zu",
+            field_count);
+
+        astarte_bson_serializer_destroy(&bson);
+    }
+}
+
+/************************************************
+ * Static functions definitions
+ ***********************************************/
+
+static void fill_mappings(void)
+{
+    for (size_t i = 0; i < FIELDS_MAX_COUNT; i++) {
+        snprintf(endpoints[i], sizeof(endpoints[i]), "/%%{sensor_id}/f%zu", i);
+        mappings[i] = (astarte_mapping_t) {
+            .endpoint = endpoints[i],
+            .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+            .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+        };
+    }
+}
+
+static void serialize_object(astarte_bson_serializer_t *bson, size_t field_count)
+{
+    astarte_bson_serializer_t inner_bson = { 0 };
+    zassert_equal(astarte_bson_serializer_init(&inner_bson), ASTARTE_RESULT_OK);
+    for (size_t i = 0; i < field_count; i++) {
+        char key[KEY_SIZE] = { 0 };
+        snprintf(key, sizeof(key), "f%zu", i);
+        astarte_bson_serializer_append_double(&inner_bson, key, 21.5 * (double) i);
+    }
+    astarte_bson_serializer_append_end_of_document(&inner_bson);
+    int inner_len = 0;
+    const void *inner_serialized = astarte_bson_serializer_get_serialized(inner_bson, &inner_len);
+    zassert_not_null(inner_serialized);
+
+    zassert_equal(astarte_bson_serializer_init(bson), ASTARTE_RESULT_OK);
+    astarte_bson_serializer_append_document(bson, "v", inner_serialized);
+    astarte_bson_serializer_append_end_of_document(bson);
+
+    astarte_bson_serializer_destroy(&inner_bson);
+}
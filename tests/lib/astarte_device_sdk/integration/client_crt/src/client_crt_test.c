@@ -0,0 +1,251 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/device.h"
+#include "astarte_device_sdk/result.h"
+
+#include "device_client_crt.h"
+#include "device_private.h"
+#include "pairing_private.h"
+#include "test_pairing.h"
+
+LOG_MODULE_REGISTER(client_crt_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+// Certificates issued in the future, as seen by a device without a synchronized wall clock their
+// validity starts when they are received
+// Valid from 2100-01-01 00:00:00 for 100 seconds, renewed after 80 seconds
+static const char crt_lifetime_100s_pem[] =
+    "-----BEGIN CERTIFICATE-----\n"
+    "MIIBJDCByqADAgECAgIETDAKBggqhkjOPQQDAjAZMRcwFQYDVQQDDA50ZXN0L2Rl\n"
+    "dmljZV9pZDAiGA8yMTAwMDEwMTAwMDAwMFoYDzIxMDAwMTAxMDAwMTQwWjAZMRcw\n"
+    "FQYDVQQDDA50ZXN0L2RldmljZV9pZDBZMBMGByqGSM49AgEGCCqGSM49AwEHA0IA\n"
+    "BEpZ5x+roTVrPq0plHDE4guIkKvAmIViV/9DouOvJvB54VsSs5OWLUw+k8N8eaL8\n"
+    "6TAP1SAXZLUMlreZckesS+kwCgYIKoZIzj0EAwIDSQAwRgIhAKdEQUgs2V5D4oHA\n"
+    "PBRx4uKpbiWUVbxB+ZF717e1q4LSAiEAzFZ5MwH0+NH8bMhZRSpIzFw1FwYMTpj7\n"
+    "PuJO/SLSr/w=\n"
+    "-----END CERTIFICATE-----\n";
+// Valid from 2100-01-01 00:00:00 for 0 seconds, past its renewal threshold as soon as received
+static const char crt_lifetime_0s_pem[] =
+    "-----BEGIN CERTIFICATE-----\n"
+    "MIIBJDCByqADAgECAgID6DAKBggqhkjOPQQDAjAZMRcwFQYDVQQDDA50ZXN0L2Rl\n"
+    "dmljZV9pZDAiGA8yMTAwMDEwMTAwMDAwMFoYDzIxMDAwMTAxMDAwMDAwWjAZMRcw\n"
+    "FQYDVQQDDA50ZXN0L2RldmljZV9pZDBZMBMGByqGSM49AgEGCCqGSM49AwEHA0IA\n"
+    "BEpZ5x+roTVrPq0plHDE4guIkKvAmIViV/9DouOvJvB54VsSs5OWLUw+k8N8eaL8\n"
+    "6TAP1SAXZLUMlreZckesS+kwCgYIKoZIzj0EAwIDSQAwRgIhAJI6Ak5t0TfIEirn\n"
+    "k3Vpl68UZ9fNkKqvU3+cz6wMsL98AiEA6B4aDx1WvHuRr3n5y3Y54oWKneLOg9mm\n"
+    "+AQdVyn/5dM=\n"
+    "-----END CERTIFICATE-----\n";
+
+#define CRT_LIFETIME_100S_RENEWAL_MS                                                               \
+    (100 * MSEC_PER_SEC * CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_RENEWAL_PERCENT / 100)
+// Tolerance on the renewal deadline for the time spent in the pairing request
+#define DEADLINE_TOLERANCE_MS 1000
+
+static astarte_device_handle_t device;
+
+static void *client_crt_test_setup(void)
+{
+    zassert_ok(test_pairing_start());
+    return NULL;
+}
+
+static void client_crt_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    test_pairing_reset();
+
+    astarte_device_config_t cfg = {
+        .http_timeout_ms = 3000,
+        .mqtt_connection_timeout_ms = 3000,
+        .mqtt_poll_timeout_ms = 100,
+        .device_id = "GwUgUK4BRqCdRDWNM1WkwA",
+        .cred_secr = "CxOHlDnwSGKtq5CQWIMPjs2sOqBTG0JrTfHNDpHiyGk=",
+    };
+    zassert_equal(astarte_device_new(&cfg, &device), ASTARTE_RESULT_OK);
+    zassert_equal(test_pairing_count(TEST_PAIRING_BROKER_INFO), 1);
+}
+
+static void client_crt_test_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_equal(astarte_device_destroy(device), ASTARTE_RESULT_OK);
+    device = NULL;
+}
+
+static void client_crt_test_teardown(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_equal(test_pairing_stop(), 0, "Loopback pairing APIs failures");
+}
+
+ZTEST_SUITE(astarte_device_sdk_client_crt, NULL, client_crt_test_setup, client_crt_test_before,
+    client_crt_test_after, client_crt_test_teardown); // NOLINT
+
+static astarte_result_t refresh(bool tls_rejected)
+{
+    return astarte_device_client_crt_refresh_handler(&device->astarte_mqtt, tls_rejected);
+}
+
+static astarte_result_t get_broker_info(void)
+{
+    char hostname[ASTARTE_MQTT_MAX_BROKER_HOSTNAME_LEN + 1] = { 0 };
+    char port[ASTARTE_MQTT_MAX_BROKER_PORT_LEN + 1] = { 0 };
+    return astarte_pairing_get_mqtt_broker_hostname_and_port(
+        device->http_timeout_ms, device->device_id, device->cred_secr, hostname, port);
+}
+
+static void assert_renewal_deadline_ms(int64_t expected_ms)
+{
+    k_timeout_t deadline = astarte_device_client_crt_get_renewal_deadline(device);
+    zassert_false(K_TIMEOUT_EQ(deadline, K_FOREVER));
+    int64_t deadline_ms = k_ticks_to_ms_ceil64(deadline.ticks);
+    zassert_true(deadline_ms <= expected_ms, "Deadline %lld ms, expected %lld ms", deadline_ms,
+        expected_ms);
+    zassert_true(deadline_ms > expected_ms - DEADLINE_TOLERANCE_MS,
+        "Deadline %lld ms, expected %lld ms", deadline_ms, expected_ms);
+}
+
+ZTEST(astarte_device_sdk_client_crt, test_client_crt_renewal_without_crt)
+{
+    zassert_true(K_TIMEOUT_EQ(astarte_device_client_crt_get_renewal_deadline(device), K_FOREVER));
+
+    // Nothing to renew before the first certificate has been obtained
+    astarte_device_client_crt_renew(device);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 0);
+    zassert_true(K_TIMEOUT_EQ(astarte_device_client_crt_get_renewal_deadline(device), K_FOREVER));
+}
+
+ZTEST(astarte_device_sdk_client_crt, test_client_crt_renewal_deadline)
+{
+    test_pairing_set_client_crt(crt_lifetime_100s_pem);
+    zassert_equal(refresh(false), ASTARTE_RESULT_OK);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 1);
+    zassert_str_equal(device->client_crt.crt_pem, crt_lifetime_100s_pem);
+    assert_renewal_deadline_ms(CRT_LIFETIME_100S_RENEWAL_MS);
+
+    // A certificate within its validity window is neither requested again nor renewed
+    zassert_equal(refresh(false), ASTARTE_RESULT_OK);
+    astarte_device_client_crt_renew(device);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 1);
+    zassert_equal(test_pairing_count(TEST_PAIRING_VERIFY_CRT), 0);
+}
+
+ZTEST(astarte_device_sdk_client_crt, test_client_crt_renewal_near_threshold)
+{
+    test_pairing_set_client_crt(crt_lifetime_100s_pem);
+    zassert_equal(refresh(false), ASTARTE_RESULT_OK);
+
+    // Just before the renewal threshold
+    k_sleep(K_MSEC(CRT_LIFETIME_100S_RENEWAL_MS - DEADLINE_TOLERANCE_MS));
+    k_timeout_t deadline = astarte_device_client_crt_get_renewal_deadline(device);
+    zassert_false(K_TIMEOUT_EQ(deadline, K_NO_WAIT));
+    zassert_true(k_ticks_to_ms_ceil64(deadline.ticks) <= DEADLINE_TOLERANCE_MS);
+    astarte_device_client_crt_renew(device);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 1);
+
+    // Past the renewal threshold, the certificate is renewed and the deadline restarts
+    k_sleep(deadline);
+    zassert_true(K_TIMEOUT_EQ(astarte_device_client_crt_get_renewal_deadline(device), K_NO_WAIT));
+    astarte_device_client_crt_renew(device);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 2);
+    zassert_str_equal(device->client_crt.crt_pem, crt_lifetime_100s_pem);
+    assert_renewal_deadline_ms(CRT_LIFETIME_100S_RENEWAL_MS);
+
+    // The renewed certificate is still valid for the connection
+    zassert_equal(refresh(false), ASTARTE_RESULT_OK);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 2);
+}
+
+ZTEST(astarte_device_sdk_client_crt, test_client_crt_renewal_past_threshold)
+{
+    test_pairing_set_client_crt(crt_lifetime_0s_pem);
+    zassert_equal(refresh(false), ASTARTE_RESULT_OK);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 1);
+    zassert_true(K_TIMEOUT_EQ(astarte_device_client_crt_get_renewal_deadline(device), K_NO_WAIT));
+
+    // An expired certificate is replaced before connecting
+    zassert_equal(refresh(false), ASTARTE_RESULT_OK);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 2);
+    zassert_equal(test_pairing_count(TEST_PAIRING_VERIFY_CRT), 0);
+
+    // A certificate past its renewal threshold is renewed right away
+    test_pairing_set_client_crt(crt_lifetime_100s_pem);
+    astarte_device_client_crt_renew(device);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 3);
+    zassert_str_equal(device->client_crt.crt_pem, crt_lifetime_100s_pem);
+    assert_renewal_deadline_ms(CRT_LIFETIME_100S_RENEWAL_MS);
+}
+
+ZTEST(astarte_device_sdk_client_crt, test_client_crt_renewal_failure)
+{
+    test_pairing_set_client_crt(crt_lifetime_0s_pem);
+    zassert_equal(refresh(false), ASTARTE_RESULT_OK);
+
+    // A failed renewal keeps the current certificate and is retried after the maximum backoff
+    test_pairing_fail_requests(true);
+    astarte_device_client_crt_renew(device);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 2);
+    zassert_str_equal(device->client_crt.crt_pem, crt_lifetime_0s_pem);
+    assert_renewal_deadline_ms(CONFIG_ASTARTE_DEVICE_SDK_RECONNECTION_ASTARTE_BACKOFF_MAX_MS);
+    astarte_device_client_crt_renew(device);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 2);
+
+    test_pairing_fail_requests(false);
+    test_pairing_set_client_crt(crt_lifetime_100s_pem);
+    k_sleep(astarte_device_client_crt_get_renewal_deadline(device));
+    astarte_device_client_crt_renew(device);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 3);
+    zassert_str_equal(device->client_crt.crt_pem, crt_lifetime_100s_pem);
+    assert_renewal_deadline_ms(CRT_LIFETIME_100S_RENEWAL_MS);
+}
+
+ZTEST(astarte_device_sdk_client_crt, test_client_crt_rejected)
+{
+    test_pairing_set_client_crt(crt_lifetime_100s_pem);
+    zassert_equal(refresh(false), ASTARTE_RESULT_OK);
+
+    // A certificate rejected by the broker is verified, and kept when still valid
+    zassert_equal(refresh(true), ASTARTE_RESULT_OK);
+    zassert_equal(test_pairing_count(TEST_PAIRING_VERIFY_CRT), 1);
+    zassert_equal(test_pairing_count(TEST_PAIRING_CLIENT_CRT), 1);
+    assert_renewal_deadline_ms(CRT_LIFETIME_100S_RENEWAL_MS);
+}
+
+ZTEST(astarte_device_sdk_client_crt, test_client_crt_session_reuse)
+{
+    size_t connections = test_pairing_count_connections();
+
+    // The requests of a pairing session share the same connection, closed when the session ends
+    astarte_pairing_session_begin();
+    zassert_equal(get_broker_info(), ASTARTE_RESULT_OK);
+    zassert_equal(get_broker_info(), ASTARTE_RESULT_OK);
+    astarte_pairing_session_end();
+    zassert_equal(test_pairing_count(TEST_PAIRING_BROKER_INFO), 3);
+    zassert_equal(test_pairing_count_connections(), connections + 1);
+
+    zassert_equal(get_broker_info(), ASTARTE_RESULT_OK);
+    zassert_equal(test_pairing_count_connections(), connections + 2);
+}
+
+ZTEST(astarte_device_sdk_client_crt, test_client_crt_session_stale_connection)
+{
+    size_t connections = test_pairing_count_connections();
+
+    // A kept alive connection closed by the server is reopened once, without failing the request
+    astarte_pairing_session_begin();
+    zassert_equal(get_broker_info(), ASTARTE_RESULT_OK);
+    test_pairing_close_connection();
+    zassert_equal(get_broker_info(), ASTARTE_RESULT_OK);
+    astarte_pairing_session_end();
+    zassert_equal(test_pairing_count(TEST_PAIRING_BROKER_INFO), 3);
+    zassert_equal(test_pairing_count_connections(), connections + 2);
+}
@@ -0,0 +1,750 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_broker.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/tls_credentials.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include "test_credentials.h"
+
+LOG_MODULE_REGISTER(test_broker, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+#define BROKER_PORT 8883
+#define BROKER_CRT_TAG 20
+#define BROKER_STACK_SIZE 8192
+#define BROKER_PRIORITY 5
+#define BROKER_POLL_PERIOD_MS 5
+#define BROKER_WAIT_PERIOD K_MSEC(5)
+#define BROKER_MAX_RECORDS 512
+#define BROKER_RX_BUFFER_SIZE 2048
+#define BROKER_HELD_ACKS_SIZE 1024
+
+// Failures are counted and reported to the test thread when stopping the broker
+#define BROKER_FAIL(...)                                                                           \
+    do {                                                                                           \
+        LOG_ERR(__VA_ARGS__); /* NOLINT */                                                         \
+        atomic_inc(&broker_failures);                                                              \
+    } while (0)
+
+/** @brief Message queued by the test thread, published by the broker thread. */
+struct publish_request
+{
+    char topic[TEST_BROKER_MAX_TOPIC_LEN + 1];
+    uint8_t payload[TEST_BROKER_MAX_PUBLISH_LEN];
+    size_t payload_len;
+    int qos;
+};
+
+K_THREAD_STACK_DEFINE(broker_stack, BROKER_STACK_SIZE);
+static struct k_thread broker_thread;
+static bool broker_running;
+static atomic_t broker_stop_flag;
+static atomic_t broker_failures;
+
+static int listen_sock = -1;
+static int client_sock = -1;
+static uint8_t rx_buffer[BROKER_RX_BUFFER_SIZE];
+static uint16_t next_message_id;
+
+// The following state is shared between the test and broker threads
+static K_MUTEX_DEFINE(broker_lock);
+static test_broker_packet_t records[BROKER_MAX_RECORDS];
+static size_t records_count;
+static bool session_present;
+static char reject_match[TEST_BROKER_MAX_TOPIC_LEN + 1];
+static bool hold_acks;
+static bool release_acks;
+static uint8_t held_acks[BROKER_HELD_ACKS_SIZE];
+static size_t held_acks_len;
+static bool drop_requested;
+static bool mqtt_connected;
+static struct publish_request publish_request;
+static bool publish_pending;
+
+/************************************************
+ *         Static functions declaration         *
+ ***********************************************/
+
+static void broker_thread_entry(void *arg1, void *arg2, void *arg3);
+static void accept_client(void);
+static void close_client(void);
+static void serve_requests(void);
+static int handle_packet(void);
+static int handle_publish(uint8_t flags, size_t packet_len, size_t remaining_len);
+static int handle_subscribe(size_t packet_len, size_t remaining_len);
+static int send_ack(uint8_t type_flags, uint16_t message_id, bool holdable);
+static int send_publish(const struct publish_request *request);
+static int send_all(const void *buf, size_t len);
+static int recv_all(void *buf, size_t len);
+static int discard(size_t len);
+static size_t encode_remaining_length(uint8_t *buf, size_t len);
+static void record(const test_broker_packet_t *packet);
+static bool has_suffix(const char *str, const char *suffix);
+
+/************************************************
+ *         Global functions definitions         *
+ ***********************************************/
+
+int test_broker_start(void)
+{
+    int ret = tls_credential_add(BROKER_CRT_TAG, TLS_CREDENTIAL_SERVER_CERTIFICATE,
+        test_credentials_crt_pem, strlen(test_credentials_crt_pem) + 1);
+    if ((ret != 0) && (ret != -EEXIST)) {
+        return ret;
+    }
+    ret = tls_credential_add(BROKER_CRT_TAG, TLS_CREDENTIAL_PRIVATE_KEY, test_credentials_key_pem,
+        strlen(test_credentials_key_pem) + 1);
+    if ((ret != 0) && (ret != -EEXIST)) {
+        return ret;
+    }
+
+    listen_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+    if (listen_sock < 0) {
+        return -errno;
+    }
+    int reuse = 1;
+    sec_tag_t sec_tag_list[] = { BROKER_CRT_TAG };
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(BROKER_PORT) };
+    zsock_inet_pton(AF_INET, TEST_BROKER_HOSTNAME, &addr.sin_addr);
+    if ((zsock_setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0)
+        || (zsock_setsockopt(
+                listen_sock, SOL_TLS, TLS_SEC_TAG_LIST, sec_tag_list, sizeof(sec_tag_list))
+            != 0)
+        || (zsock_bind(listen_sock, (struct sockaddr *) &addr, sizeof(addr)) != 0)
+        || (zsock_listen(listen_sock, 1) != 0)) {
+        ret = -errno;
+        zsock_close(listen_sock);
+        listen_sock = -1;
+        return ret;
+    }
+
+    test_broker_reset();
+    atomic_clear(&broker_stop_flag);
+    atomic_clear(&broker_failures);
+    k_thread_create(&broker_thread, broker_stack, K_THREAD_STACK_SIZEOF(broker_stack),
+        broker_thread_entry, NULL, NULL, NULL, BROKER_PRIORITY, 0, K_NO_WAIT);
+    broker_running = true;
+    return 0;
+}
+
+int test_broker_add_client_credentials(void)
+{
+    int ret = tls_credential_add(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_TAG,
+        TLS_CREDENTIAL_SERVER_CERTIFICATE, test_credentials_crt_pem,
+        strlen(test_credentials_crt_pem) + 1);
+    if ((ret != 0) && (ret != -EEXIST)) {
+        return ret;
+    }
+    ret = tls_credential_add(CONFIG_ASTARTE_DEVICE_SDK_CLIENT_CERT_TAG, TLS_CREDENTIAL_PRIVATE_KEY,
+        test_credentials_key_pem, strlen(test_credentials_key_pem) + 1);
+    return ((ret != 0) && (ret != -EEXIST)) ? ret : 0;
+}
+
+int test_broker_stop(void)
+{
+    if (broker_running) {
+        atomic_set(&broker_stop_flag, 1);
+        if (k_thread_join(&broker_thread, K_SECONDS(10)) != 0) {
+            BROKER_FAIL("The broker thread did not terminate.");
+            k_thread_abort(&broker_thread);
+        }
+        broker_running = false;
+    }
+    close_client();
+    if (listen_sock >= 0) {
+        zsock_close(listen_sock);
+        listen_sock = -1;
+    }
+    return (int) atomic_get(&broker_failures);
+}
+
+void test_broker_reset(void)
+{
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    records_count = 0;
+    session_present = false;
+    memset(reject_match, 0, sizeof(reject_match));
+    hold_acks = false;
+    // Acknowledgments held by a previous test are dropped
+    release_acks = false;
+    held_acks_len = 0;
+    k_mutex_unlock(&broker_lock);
+}
+
+void test_broker_set_session_present(bool present)
+{
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    session_present = present;
+    k_mutex_unlock(&broker_lock);
+}
+
+void test_broker_reject_subscriptions(const char *match)
+{
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    memset(reject_match, 0, sizeof(reject_match));
+    if (match) {
+        strncpy(reject_match, match, sizeof(reject_match) - 1);
+    }
+    k_mutex_unlock(&broker_lock);
+}
+
+void test_broker_hold_acks(bool hold)
+{
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    hold_acks = hold;
+    if (!hold) {
+        release_acks = true;
+    }
+    k_mutex_unlock(&broker_lock);
+}
+
+void test_broker_drop_connection(void)
+{
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    drop_requested = true;
+    k_mutex_unlock(&broker_lock);
+    while (test_broker_is_connected()) {
+        k_sleep(BROKER_WAIT_PERIOD);
+    }
+}
+
+bool test_broker_is_connected(void)
+{
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    bool connected = mqtt_connected;
+    k_mutex_unlock(&broker_lock);
+    return connected;
+}
+
+int test_broker_publish(const char *topic, const void *payload, size_t payload_len, int qos)
+{
+    if ((strlen(topic) > TEST_BROKER_MAX_TOPIC_LEN) || (payload_len > TEST_BROKER_MAX_PUBLISH_LEN)
+        || (qos < 0) || (qos > 2)) {
+        return -EINVAL;
+    }
+    if (!test_broker_is_connected()) {
+        return -ENOTCONN;
+    }
+
+    // A single message at a time is queued, wait for the previous one to be sent
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    while (publish_pending) {
+        k_mutex_unlock(&broker_lock);
+        k_sleep(BROKER_WAIT_PERIOD);
+        k_mutex_lock(&broker_lock, K_FOREVER);
+    }
+    strcpy(publish_request.topic, topic);
+    if (payload_len != 0) {
+        memcpy(publish_request.payload, payload, payload_len);
+    }
+    publish_request.payload_len = payload_len;
+    publish_request.qos = qos;
+    publish_pending = true;
+    k_mutex_unlock(&broker_lock);
+    return 0;
+}
+
+size_t test_broker_count(enum test_broker_packet_type type)
+{
+    size_t count = 0;
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    for (size_t i = 0; i < records_count; i++) {
+        if (records[i].type == type) {
+            count++;
+        }
+    }
+    k_mutex_unlock(&broker_lock);
+    return count;
+}
+
+size_t test_broker_count_published(const char *topic_suffix)
+{
+    size_t count = 0;
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    for (size_t i = 0; i < records_count; i++) {
+        if ((records[i].type == TEST_BROKER_PUBLISH)
+            && has_suffix(records[i].topic, topic_suffix)) {
+            count++;
+        }
+    }
+    k_mutex_unlock(&broker_lock);
+    return count;
+}
+
+bool test_broker_wait_published(const char *topic_suffix, size_t count, k_timeout_t timeout)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(timeout);
+    while (test_broker_count_published(topic_suffix) < count) {
+        if (sys_timepoint_expired(timepoint)) {
+            return false;
+        }
+        k_sleep(BROKER_WAIT_PERIOD);
+    }
+    return true;
+}
+
+bool test_broker_get(enum test_broker_packet_type type, size_t index, test_broker_packet_t *packet)
+{
+    bool found = false;
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    for (size_t i = 0; i < records_count; i++) {
+        if (records[i].type != type) {
+            continue;
+        }
+        if (index-- == 0) {
+            memcpy(packet, &records[i], sizeof(test_broker_packet_t));
+            found = true;
+            break;
+        }
+    }
+    k_mutex_unlock(&broker_lock);
+    return found;
+}
+
+bool test_broker_wait(enum test_broker_packet_type type, size_t count, k_timeout_t timeout)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(timeout);
+    while (test_broker_count(type) < count) {
+        if (sys_timepoint_expired(timepoint)) {
+            return false;
+        }
+        k_sleep(BROKER_WAIT_PERIOD);
+    }
+    return true;
+}
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+static void broker_thread_entry(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    while (!atomic_get(&broker_stop_flag)) {
+        serve_requests();
+
+        struct zsock_pollfd fds[2] = {
+            { .fd = listen_sock, .events = ZSOCK_POLLIN },
+            { .fd = client_sock, .events = ZSOCK_POLLIN },
+        };
+        int nfds = (client_sock >= 0) ? 2 : 1;
+        int ret = zsock_poll(fds, nfds, BROKER_POLL_PERIOD_MS);
+        if (ret < 0) {
+            BROKER_FAIL("Broker poll failed: %d", errno);
+            k_sleep(K_MSEC(BROKER_POLL_PERIOD_MS));
+            continue;
+        }
+        // A new connection replaces the current one, the client has reconnected
+        if (fds[0].revents & ZSOCK_POLLIN) {
+            accept_client();
+            continue;
+        }
+        if ((client_sock >= 0) && (fds[1].revents != 0)) {
+            if (handle_packet() != 0) {
+                close_client();
+            }
+        }
+    }
+}
+
+static void accept_client(void)
+{
+    close_client();
+    // The TLS handshake is performed while accepting the connection
+    int sock = zsock_accept(listen_sock, NULL, NULL);
+    if (sock < 0) {
+        // Not a failure of the broker, the client might have aborted the handshake on purpose
+        LOG_WRN("Accepting the client connection failed: %d", errno); // NOLINT
+        return;
+    }
+    client_sock = sock;
+}
+
+static void close_client(void)
+{
+    if (client_sock >= 0) {
+        zsock_close(client_sock);
+        client_sock = -1;
+    }
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    mqtt_connected = false;
+    drop_requested = false;
+    k_mutex_unlock(&broker_lock);
+}
+
+static void serve_requests(void)
+{
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    bool drop = drop_requested;
+    size_t release_len = 0;
+    uint8_t release[BROKER_HELD_ACKS_SIZE];
+    if (release_acks) {
+        memcpy(release, held_acks, held_acks_len);
+        release_len = held_acks_len;
+        held_acks_len = 0;
+        release_acks = false;
+    }
+    k_mutex_unlock(&broker_lock);
+
+    if (drop) {
+        close_client();
+    }
+    if ((release_len != 0) && (client_sock >= 0) && (send_all(release, release_len) != 0)) {
+        BROKER_FAIL("Failed sending the held acknowledgments.");
+    }
+
+    // The request is not modified by the test thread until the pending flag is cleared
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    bool publish = publish_pending;
+    k_mutex_unlock(&broker_lock);
+    if (publish) {
+        if ((client_sock < 0) || (send_publish(&publish_request) != 0)) {
+            BROKER_FAIL("Failed publishing on %s.", publish_request.topic);
+        }
+        k_mutex_lock(&broker_lock, K_FOREVER);
+        publish_pending = false;
+        k_mutex_unlock(&broker_lock);
+    }
+}
+
+static int handle_packet(void)
+{
+    uint8_t header = 0;
+    int ret = recv_all(&header, 1);
+    if (ret != 0) {
+        return ret;
+    }
+
+    size_t remaining_len = 0;
+    size_t header_len = 1;
+    for (size_t shift = 0; shift < 28; shift += 7) {
+        uint8_t byte = 0;
+        ret = recv_all(&byte, 1);
+        if (ret != 0) {
+            return ret;
+        }
+        header_len++;
+        remaining_len |= (size_t) (byte & 0x7FU) << shift;
+        if ((byte & 0x80U) == 0) {
+            break;
+        }
+    }
+    size_t packet_len = header_len + remaining_len;
+
+    uint8_t type = header >> 4;
+    if (type == TEST_BROKER_PUBLISH) {
+        return handle_publish(header & 0x0FU, packet_len, remaining_len);
+    }
+    if (type == TEST_BROKER_SUBSCRIBE) {
+        return handle_subscribe(packet_len, remaining_len);
+    }
+
+    if (remaining_len > sizeof(rx_buffer)) {
+        BROKER_FAIL("Packet of type %u too large: %zu bytes.", type, remaining_len);
+        return -ENOMEM;
+    }
+    ret = recv_all(rx_buffer, remaining_len);
+    if (ret != 0) {
+        return ret;
+    }
+
+    test_broker_packet_t packet = { .type = type, .packet_len = packet_len };
+    if ((type != TEST_BROKER_CONNECT) && (remaining_len >= 2)) {
+        packet.message_id = sys_get_be16(rx_buffer);
+    }
+    record(&packet);
+
+    switch (type) {
+        case TEST_BROKER_CONNECT: {
+            k_mutex_lock(&broker_lock, K_FOREVER);
+            uint8_t connack[] = { 0x20, 0x02, session_present ? 1U : 0U, 0x00 };
+            mqtt_connected = true;
+            k_mutex_unlock(&broker_lock);
+            return send_all(connack, sizeof(connack));
+        }
+        case TEST_BROKER_PUBREL:
+            return send_ack(0x70, packet.message_id, false);
+        case TEST_BROKER_PUBREC:
+            // Reception of a QoS 2 publish of the broker
+            return send_ack(0x62, packet.message_id, false);
+        case TEST_BROKER_PUBACK:
+        case TEST_BROKER_PUBCOMP:
+            return 0;
+        case TEST_BROKER_UNSUBSCRIBE:
+            return send_ack(0xB0, packet.message_id, false);
+        case TEST_BROKER_PINGREQ: {
+            uint8_t pingresp[] = { 0xD0, 0x00 };
+            return send_all(pingresp, sizeof(pingresp));
+        }
+        case TEST_BROKER_DISCONNECT:
+            return -ECONNRESET;
+        default:
+            BROKER_FAIL("Unexpected packet of type %u.", type);
+            return -EINVAL;
+    }
+}
+
+static int handle_publish(uint8_t flags, size_t packet_len, size_t remaining_len)
+{
+    test_broker_packet_t packet = {
+        .type = TEST_BROKER_PUBLISH,
+        .packet_len = packet_len,
+        .qos = (flags >> 1) & 0x03U,
+        .dup = (flags & 0x08U) != 0,
+    };
+
+    uint8_t topic_len_buf[2] = { 0 };
+    int ret = recv_all(topic_len_buf, sizeof(topic_len_buf));
+    if (ret != 0) {
+        return ret;
+    }
+    size_t topic_len = sys_get_be16(topic_len_buf);
+    size_t variable_header_len = 2 + topic_len + ((packet.qos > 0) ? 2 : 0);
+    if ((topic_len > sizeof(rx_buffer)) || (variable_header_len > remaining_len)) {
+        BROKER_FAIL("Malformed PUBLISH packet.");
+        return -EINVAL;
+    }
+    ret = recv_all(rx_buffer, topic_len);
+    if (ret != 0) {
+        return ret;
+    }
+    memcpy(packet.topic, rx_buffer, MIN(topic_len, TEST_BROKER_MAX_TOPIC_LEN));
+    if (packet.qos > 0) {
+        uint8_t message_id_buf[2] = { 0 };
+        ret = recv_all(message_id_buf, sizeof(message_id_buf));
+        if (ret != 0) {
+            return ret;
+        }
+        packet.message_id = sys_get_be16(message_id_buf);
+    }
+
+    // Only the first bytes of the payload are recorded
+    packet.payload_len = remaining_len - variable_header_len;
+    size_t recorded_len = MIN(packet.payload_len, TEST_BROKER_MAX_PAYLOAD_LEN);
+    ret = recv_all(packet.payload, recorded_len);
+    if (ret == 0) {
+        ret = discard(packet.payload_len - recorded_len);
+    }
+    if (ret != 0) {
+        return ret;
+    }
+    record(&packet);
+
+    switch (packet.qos) {
+        case 1:
+            return send_ack(0x40, packet.message_id, true);
+        case 2:
+            return send_ack(0x50, packet.message_id, true);
+        default:
+            return 0;
+    }
+}
+
+static int handle_subscribe(size_t packet_len, size_t remaining_len)
+{
+    if ((remaining_len > sizeof(rx_buffer)) || (remaining_len < 2)) {
+        BROKER_FAIL("Malformed SUBSCRIBE packet of %zu bytes.", remaining_len);
+        return -EINVAL;
+    }
+    int ret = recv_all(rx_buffer, remaining_len);
+    if (ret != 0) {
+        return ret;
+    }
+
+    test_broker_packet_t packet = {
+        .type = TEST_BROKER_SUBSCRIBE,
+        .packet_len = packet_len,
+        .message_id = sys_get_be16(rx_buffer),
+    };
+
+    // SUBACK fixed header, message ID and one return code for each topic filter
+    uint8_t suback[8 + BROKER_RX_BUFFER_SIZE / 4] = { 0 };
+    uint8_t codes[BROKER_RX_BUFFER_SIZE / 4] = { 0 };
+    size_t offset = 2;
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    while (offset + 2 < remaining_len) {
+        size_t filter_len = sys_get_be16(&rx_buffer[offset]);
+        if ((offset + 2 + filter_len + 1 > remaining_len)
+            || (packet.topics_count >= ARRAY_SIZE(codes))) {
+            break;
+        }
+        char *filter = (char *) &rx_buffer[offset + 2];
+        uint8_t requested_qos = rx_buffer[offset + 2 + filter_len];
+        // Terminate the filter string in place, the QoS byte has already been read
+        filter[filter_len] = '\0';
+        if (packet.topics_count == 0) {
+            strncpy(packet.topic, filter, TEST_BROKER_MAX_TOPIC_LEN);
+        }
+        bool rejected = (strlen(reject_match) != 0) && strstr(filter, reject_match);
+        codes[packet.topics_count++] = (rejected) ? 0x80U : MIN(requested_qos, 2U);
+        offset += 2 + filter_len + 1;
+    }
+    k_mutex_unlock(&broker_lock);
+
+    if ((offset != remaining_len) || (packet.topics_count == 0)) {
+        BROKER_FAIL("Malformed topic filters in SUBSCRIBE packet.");
+        return -EINVAL;
+    }
+    record(&packet);
+
+    suback[0] = 0x90;
+    size_t len = 1 + encode_remaining_length(&suback[1], 2 + packet.topics_count);
+    sys_put_be16(packet.message_id, &suback[len]);
+    len += 2;
+    memcpy(&suback[len], codes, packet.topics_count);
+    len += packet.topics_count;
+
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    if (hold_acks) {
+        if (held_acks_len + len > sizeof(held_acks)) {
+            k_mutex_unlock(&broker_lock);
+            BROKER_FAIL("Too many held acknowledgments.");
+            return -ENOMEM;
+        }
+        memcpy(&held_acks[held_acks_len], suback, len);
+        held_acks_len += len;
+        k_mutex_unlock(&broker_lock);
+        return 0;
+    }
+    k_mutex_unlock(&broker_lock);
+    return send_all(suback, len);
+}
+
+static int send_ack(uint8_t type_flags, uint16_t message_id, bool holdable)
+{
+    uint8_t ack[4] = { type_flags, 0x02 };
+    sys_put_be16(message_id, &ack[2]);
+
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    if (holdable && hold_acks) {
+        if (held_acks_len + sizeof(ack) > sizeof(held_acks)) {
+            k_mutex_unlock(&broker_lock);
+            BROKER_FAIL("Too many held acknowledgments.");
+            return -ENOMEM;
+        }
+        memcpy(&held_acks[held_acks_len], ack, sizeof(ack));
+        held_acks_len += sizeof(ack);
+        k_mutex_unlock(&broker_lock);
+        return 0;
+    }
+    k_mutex_unlock(&broker_lock);
+    return send_all(ack, sizeof(ack));
+}
+
+static int send_publish(const struct publish_request *request)
+{
+    size_t topic_len = strlen(request->topic);
+    size_t remaining_len = 2 + topic_len + ((request->qos > 0) ? 2 : 0) + request->payload_len;
+
+    uint8_t header[8 + TEST_BROKER_MAX_TOPIC_LEN] = { 0 };
+    header[0] = 0x30 | ((request->qos & 0x03) << 1);
+    size_t len = 1 + encode_remaining_length(&header[1], remaining_len);
+    sys_put_be16(topic_len, &header[len]);
+    len += 2;
+    memcpy(&header[len], request->topic, topic_len);
+    len += topic_len;
+    if (request->qos > 0) {
+        next_message_id = (next_message_id == UINT16_MAX) ? 1 : next_message_id + 1;
+        sys_put_be16(next_message_id, &header[len]);
+        len += 2;
+    }
+
+    int ret = send_all(header, len);
+    if ((ret == 0) && (request->payload_len != 0)) {
+        ret = send_all(request->payload, request->payload_len);
+    }
+    return ret;
+}
+
+static int send_all(const void *buf, size_t len)
+{
+    const uint8_t *data = buf;
+    while (len > 0) {
+        ssize_t sent = zsock_send(client_sock, data, len, 0);
+        if (sent < 0) {
+            LOG_WRN("Broker send failed: %d", errno); // NOLINT
+            return -errno;
+        }
+        data += sent;
+        len -= sent;
+    }
+    return 0;
+}
+
+static int recv_all(void *buf, size_t len)
+{
+    uint8_t *data = buf;
+    while (len > 0) {
+        ssize_t received = zsock_recv(client_sock, data, len, 0);
+        if (received == 0) {
+            return -ECONNRESET;
+        }
+        if (received < 0) {
+            return -errno;
+        }
+        data += received;
+        len -= received;
+    }
+    return 0;
+}
+
+static int discard(size_t len)
+{
+    while (len > 0) {
+        size_t chunk_len = MIN(len, sizeof(rx_buffer));
+        int ret = recv_all(rx_buffer, chunk_len);
+        if (ret != 0) {
+            return ret;
+        }
+        len -= chunk_len;
+    }
+    return 0;
+}
+
+static size_t encode_remaining_length(uint8_t *buf, size_t len)
+{
+    size_t encoded = 0;
+    do {
+        uint8_t byte = len & 0x7FU;
+        len >>= 7;
+        buf[encoded++] = (len > 0) ? (byte | 0x80U) : byte;
+    } while (len > 0);
+    return encoded;
+}
+
+static void record(const test_broker_packet_t *packet)
+{
+    k_mutex_lock(&broker_lock, K_FOREVER);
+    if (records_count < ARRAY_SIZE(records)) {
+        memcpy(&records[records_count++], packet, sizeof(test_broker_packet_t));
+    } else {
+        LOG_WRN("Broker records full, packet of type %u not recorded.", packet->type); // NOLINT
+    }
+    k_mutex_unlock(&broker_lock);
+}
+
+static bool has_suffix(const char *str, const char *suffix)
+{
+    size_t str_len = strlen(str);
+    size_t suffix_len = strlen(suffix);
+    return (str_len >= suffix_len) && (strcmp(&str[str_len - suffix_len], suffix) == 0);
+}
@@ -0,0 +1,101 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_device.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+#include <zephyr/drivers/flash.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/storage/flash_map.h>
+#endif
+
+LOG_MODULE_REGISTER(test_device, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+// Polls return right away while the MQTT client is not connected, sleeping lets time advance
+#define POLL_PERIOD_MS 1
+
+/************************************************
+ *         Global functions definitions         *
+ ***********************************************/
+
+void test_device_config_init(astarte_device_config_t *cfg)
+{
+    memset(cfg, 0, sizeof(astarte_device_config_t));
+    cfg->http_timeout_ms = 3000;
+    cfg->mqtt_connection_timeout_ms = 3000;
+    cfg->mqtt_poll_timeout_ms = 10;
+    memcpy(cfg->device_id, TEST_DEVICE_ID, sizeof(TEST_DEVICE_ID));
+    memcpy(cfg->cred_secr, TEST_DEVICE_CRED_SECR, sizeof(TEST_DEVICE_CRED_SECR));
+}
+
+bool test_device_poll_until(
+    astarte_device_handle_t device, test_device_condition_t condition, k_timeout_t timeout)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(timeout);
+    while (!condition(device)) {
+        if (sys_timepoint_expired(timepoint)) {
+            return false;
+        }
+        astarte_result_t ares = astarte_device_poll(device);
+        if (ares != ASTARTE_RESULT_OK) {
+            LOG_ERR("Device poll failed: %s", astarte_result_to_name(ares)); // NOLINT
+            return false;
+        }
+        k_msleep(POLL_PERIOD_MS);
+    }
+    return true;
+}
+
+bool test_device_poll_for(astarte_device_handle_t device, k_timeout_t duration)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(duration);
+    while (!sys_timepoint_expired(timepoint)) {
+        astarte_result_t ares = astarte_device_poll(device);
+        if (ares != ASTARTE_RESULT_OK) {
+            LOG_ERR("Device poll failed: %s", astarte_result_to_name(ares)); // NOLINT
+            return false;
+        }
+        k_msleep(POLL_PERIOD_MS);
+    }
+    return true;
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+int test_device_clear_storage(void)
+{
+    struct flash_pages_info fp_info = { 0 };
+    const struct device *flash_device = FIXED_PARTITION_DEVICE(astarte_partition);
+    off_t flash_offset = FIXED_PARTITION_OFFSET(astarte_partition);
+    if (!device_is_ready(flash_device)) {
+        return -ENODEV;
+    }
+    int ret = flash_get_page_info_by_offs(flash_device, flash_offset, &fp_info);
+    if (ret != 0) {
+        return ret;
+    }
+
+    struct nvs_fs nvs_fs = {
+        .flash_device = flash_device,
+        .offset = flash_offset,
+        .sector_size = fp_info.size,
+        .sector_count = FIXED_PARTITION_SIZE(astarte_partition) / fp_info.size,
+    };
+    ret = nvs_mount(&nvs_fs);
+    if (ret != 0) {
+        return ret;
+    }
+    return nvs_clear(&nvs_fs);
+}
+#endif
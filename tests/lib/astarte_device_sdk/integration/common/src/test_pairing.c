@@ -0,0 +1,441 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_pairing.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include "test_credentials.h"
+
+LOG_MODULE_REGISTER(test_pairing, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+/************************************************
+ *       Static variables and definitions       *
+ ***********************************************/
+
+#define PAIRING_PORT 80
+#define PAIRING_STACK_SIZE 8192
+#define PAIRING_PRIORITY 5
+#define PAIRING_POLL_PERIOD_MS 5
+#define PAIRING_REQUEST_SIZE 4096
+#define PAIRING_RESPONSE_SIZE 4096
+
+#define CRT_URL_SUFFIX "/protocols/astarte_mqtt_v1/credentials"
+#define VERIFY_URL_SUFFIX CRT_URL_SUFFIX "/verify"
+
+// Failures are counted and reported to the test thread when stopping the server
+#define PAIRING_FAIL(...)                                                                          \
+    do {                                                                                           \
+        LOG_ERR(__VA_ARGS__); /* NOLINT */                                                         \
+        atomic_inc(&pairing_failures);                                                             \
+    } while (0)
+
+K_THREAD_STACK_DEFINE(pairing_stack, PAIRING_STACK_SIZE);
+static struct k_thread pairing_thread;
+static bool pairing_running;
+static atomic_t pairing_stop_flag;
+static atomic_t pairing_failures;
+
+static int listen_sock = -1;
+static int client_sock = -1;
+static char request_buf[PAIRING_REQUEST_SIZE + 1];
+static char response_buf[PAIRING_RESPONSE_SIZE];
+static char body_buf[PAIRING_RESPONSE_SIZE];
+
+// The following state is shared between the test and server threads
+static K_MUTEX_DEFINE(pairing_lock);
+static const char *client_crt_pem;
+static bool fail_requests;
+static size_t requests_count[TEST_PAIRING_REQUESTS_COUNT];
+static size_t connections_count;
+static bool close_requested;
+
+/************************************************
+ *         Static functions declaration         *
+ ***********************************************/
+
+static void pairing_thread_entry(void *arg1, void *arg2, void *arg3);
+static void accept_client(void);
+static void close_client(void);
+static int handle_request(void);
+static int recv_request(size_t *headers_len, size_t *content_len);
+static int send_response(int status, const char *body, bool keep_alive);
+static int encode_client_crt(const char *crt_pem, char *buf, size_t buf_size);
+static int send_all(const void *buf, size_t len);
+static bool has_suffix(const char *str, const char *suffix);
+
+/************************************************
+ *         Global functions definitions         *
+ ***********************************************/
+
+int test_pairing_start(void)
+{
+    listen_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_sock < 0) {
+        return -errno;
+    }
+    int reuse = 1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(PAIRING_PORT) };
+    zsock_inet_pton(AF_INET, TEST_BROKER_HOSTNAME, &addr.sin_addr);
+    if ((zsock_setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0)
+        || (zsock_bind(listen_sock, (struct sockaddr *) &addr, sizeof(addr)) != 0)
+        || (zsock_listen(listen_sock, 1) != 0)) {
+        int ret = -errno;
+        zsock_close(listen_sock);
+        listen_sock = -1;
+        return ret;
+    }
+
+    test_pairing_reset();
+    atomic_clear(&pairing_stop_flag);
+    atomic_clear(&pairing_failures);
+    k_thread_create(&pairing_thread, pairing_stack, K_THREAD_STACK_SIZEOF(pairing_stack),
+        pairing_thread_entry, NULL, NULL, NULL, PAIRING_PRIORITY, 0, K_NO_WAIT);
+    pairing_running = true;
+    return 0;
+}
+
+int test_pairing_stop(void)
+{
+    if (pairing_running) {
+        atomic_set(&pairing_stop_flag, 1);
+        if (k_thread_join(&pairing_thread, K_SECONDS(10)) != 0) {
+            PAIRING_FAIL("The pairing thread did not terminate.");
+            k_thread_abort(&pairing_thread);
+        }
+        pairing_running = false;
+    }
+    close_client();
+    if (listen_sock >= 0) {
+        zsock_close(listen_sock);
+        listen_sock = -1;
+    }
+    return (int) atomic_get(&pairing_failures);
+}
+
+void test_pairing_reset(void)
+{
+    k_mutex_lock(&pairing_lock, K_FOREVER);
+    client_crt_pem = test_credentials_crt_pem;
+    fail_requests = false;
+    memset(requests_count, 0, sizeof(requests_count));
+    connections_count = 0;
+    k_mutex_unlock(&pairing_lock);
+}
+
+void test_pairing_set_client_crt(const char *crt_pem)
+{
+    k_mutex_lock(&pairing_lock, K_FOREVER);
+    client_crt_pem = crt_pem;
+    k_mutex_unlock(&pairing_lock);
+}
+
+void test_pairing_fail_requests(bool fail)
+{
+    k_mutex_lock(&pairing_lock, K_FOREVER);
+    fail_requests = fail;
+    k_mutex_unlock(&pairing_lock);
+}
+
+size_t test_pairing_count(enum test_pairing_request request)
+{
+    k_mutex_lock(&pairing_lock, K_FOREVER);
+    size_t count = requests_count[request];
+    k_mutex_unlock(&pairing_lock);
+    return count;
+}
+
+size_t test_pairing_count_connections(void)
+{
+    k_mutex_lock(&pairing_lock, K_FOREVER);
+    size_t count = connections_count;
+    k_mutex_unlock(&pairing_lock);
+    return count;
+}
+
+void test_pairing_close_connection(void)
+{
+    k_mutex_lock(&pairing_lock, K_FOREVER);
+    close_requested = true;
+    k_mutex_unlock(&pairing_lock);
+    while (true) {
+        k_mutex_lock(&pairing_lock, K_FOREVER);
+        bool closing = close_requested;
+        k_mutex_unlock(&pairing_lock);
+        if (!closing) {
+            break;
+        }
+        k_sleep(K_MSEC(PAIRING_POLL_PERIOD_MS));
+    }
+}
+
+/************************************************
+ *         Static functions definitions         *
+ ***********************************************/
+
+static void pairing_thread_entry(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    while (!atomic_get(&pairing_stop_flag)) {
+        k_mutex_lock(&pairing_lock, K_FOREVER);
+        if (close_requested) {
+            close_client();
+            close_requested = false;
+        }
+        k_mutex_unlock(&pairing_lock);
+
+        struct zsock_pollfd fds[2] = {
+            { .fd = listen_sock, .events = ZSOCK_POLLIN },
+            { .fd = client_sock, .events = ZSOCK_POLLIN },
+        };
+        int nfds = (client_sock >= 0) ? 2 : 1;
+        int ret = zsock_poll(fds, nfds, PAIRING_POLL_PERIOD_MS);
+        if (ret < 0) {
+            PAIRING_FAIL("Pairing poll failed: %d", errno);
+            k_sleep(K_MSEC(PAIRING_POLL_PERIOD_MS));
+            continue;
+        }
+        // A new connection replaces the kept alive one, the client has started a new session
+        if (fds[0].revents & ZSOCK_POLLIN) {
+            accept_client();
+            continue;
+        }
+        if ((client_sock >= 0) && (fds[1].revents != 0)) {
+            if (handle_request() != 0) {
+                close_client();
+            }
+        }
+    }
+}
+
+static void accept_client(void)
+{
+    close_client();
+    int sock = zsock_accept(listen_sock, NULL, NULL);
+    if (sock < 0) {
+        PAIRING_FAIL("Accepting the client connection failed: %d", errno);
+        return;
+    }
+    client_sock = sock;
+    k_mutex_lock(&pairing_lock, K_FOREVER);
+    connections_count++;
+    k_mutex_unlock(&pairing_lock);
+}
+
+static void close_client(void)
+{
+    if (client_sock >= 0) {
+        zsock_close(client_sock);
+        client_sock = -1;
+    }
+}
+
+static int handle_request(void)
+{
+    size_t headers_len = 0;
+    size_t content_len = 0;
+    int ret = recv_request(&headers_len, &content_len);
+    if (ret != 0) {
+        // The client closing a kept alive connection is not a failure
+        return ret;
+    }
+
+    char method[8] = { 0 };
+    char url[128] = { 0 };
+    if (sscanf(request_buf, "%7s %127s", method, url) != 2) {
+        PAIRING_FAIL("Malformed request line: %s", request_buf);
+        return -EINVAL;
+    }
+    bool keep_alive = (strstr(request_buf, "Connection: keep-alive") != NULL);
+
+    enum test_pairing_request request = TEST_PAIRING_REQUESTS_COUNT;
+    if ((strcmp(method, "POST") == 0) && has_suffix(url, VERIFY_URL_SUFFIX)) {
+        request = TEST_PAIRING_VERIFY_CRT;
+    } else if ((strcmp(method, "POST") == 0) && has_suffix(url, CRT_URL_SUFFIX)) {
+        request = TEST_PAIRING_CLIENT_CRT;
+    } else if ((strcmp(method, "GET") == 0) && strstr(url, "/devices/")) {
+        request = TEST_PAIRING_BROKER_INFO;
+    } else {
+        PAIRING_FAIL("Unexpected request: %s %s", method, url);
+        return send_response(404, "{}", keep_alive);
+    }
+    const char *expected_body = NULL;
+    if (request == TEST_PAIRING_CLIENT_CRT) {
+        expected_body = "{\"data\":{\"csr\":\"-----BEGIN CERTIFICATE REQUEST-----";
+    } else if (request == TEST_PAIRING_VERIFY_CRT) {
+        expected_body = "{\"data\":{\"client_crt\":\"-----BEGIN CERTIFICATE-----";
+    }
+    if (expected_body && !strstr(&request_buf[headers_len], expected_body)) {
+        PAIRING_FAIL("Malformed request body: %s", &request_buf[headers_len]);
+        return send_response(422, "{}", keep_alive);
+    }
+
+    k_mutex_lock(&pairing_lock, K_FOREVER);
+    requests_count[request]++;
+    bool fail = fail_requests;
+    const char *crt_pem = client_crt_pem;
+    k_mutex_unlock(&pairing_lock);
+
+    if (fail) {
+        return send_response(
+            500, "{\"errors\":{\"detail\":\"Internal Server Error\"}}", keep_alive);
+    }
+    switch (request) {
+        case TEST_PAIRING_BROKER_INFO:
+            return send_response(200,
+                "{\"data\":{\"protocols\":{\"astarte_mqtt_v1\":{\"broker_url\":\""
+                TEST_PAIRING_BROKER_URL "\"}}}}",
+                keep_alive);
+        case TEST_PAIRING_CLIENT_CRT:
+            ret = encode_client_crt(crt_pem, body_buf, sizeof(body_buf));
+            if (ret != 0) {
+                PAIRING_FAIL("The client certificate is too long.");
+                return ret;
+            }
+            return send_response(201, body_buf, keep_alive);
+        default:
+            return send_response(200,
+                "{\"data\":{\"timestamp\":\"2100-01-01 00:00:00.000Z\","
+                "\"until\":\"2100-01-01 00:01:40.000Z\",\"valid\":true}}",
+                keep_alive);
+    }
+}
+
+static int recv_request(size_t *headers_len, size_t *content_len)
+{
+    size_t received_len = 0;
+    char *body = NULL;
+    while (!body || (received_len < (*headers_len + *content_len))) {
+        if (received_len == PAIRING_REQUEST_SIZE) {
+            PAIRING_FAIL("The request does not fit the receive buffer.");
+            return -ENOMEM;
+        }
+        ssize_t received = zsock_recv(
+            client_sock, &request_buf[received_len], PAIRING_REQUEST_SIZE - received_len, 0);
+        if (received == 0) {
+            return -ECONNRESET;
+        }
+        if (received < 0) {
+            return -errno;
+        }
+        received_len += received;
+        request_buf[received_len] = '\0';
+
+        if (!body) {
+            body = strstr(request_buf, "\r\n\r\n");
+            if (body) {
+                body += strlen("\r\n\r\n");
+                *headers_len = body - request_buf;
+                const char *content_length = strstr(request_buf, "Content-Length:");
+                *content_len = (content_length)
+                    ? strtoul(&content_length[strlen("Content-Length:")], NULL, 10)
+                    : 0;
+            }
+        }
+    }
+    return 0;
+}
+
+static int send_response(int status, const char *body, bool keep_alive)
+{
+    const char *reason = "OK";
+    switch (status) {
+        case 200:
+            break;
+        case 201:
+            reason = "Created";
+            break;
+        case 404:
+            reason = "Not Found";
+            break;
+        case 422:
+            reason = "Unprocessable Entity";
+            break;
+        default:
+            reason = "Internal Server Error";
+            break;
+    }
+    int len = snprintf(response_buf, sizeof(response_buf),
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: %s\r\n"
+        "\r\n"
+        "%s",
+        status, reason, strlen(body), (keep_alive) ? "keep-alive" : "close", body);
+    if ((len < 0) || ((size_t) len >= sizeof(response_buf))) {
+        PAIRING_FAIL("The response does not fit the transmit buffer.");
+        return -ENOMEM;
+    }
+    int ret = send_all(response_buf, len);
+    if ((ret == 0) && !keep_alive) {
+        // The connection is closed by the caller
+        return -ECONNRESET;
+    }
+    return ret;
+}
+
+static int encode_client_crt(const char *crt_pem, char *buf, size_t buf_size)
+{
+    const char prefix[] = "{\"data\":{\"client_crt\":\"";
+    const char suffix[] = "\"}}";
+    size_t len = strlen(prefix);
+    if (len >= buf_size) {
+        return -ENOMEM;
+    }
+    memcpy(buf, prefix, len);
+    // The new lines of the PEM certificate are escaped in the JSON string
+    for (const char *c = crt_pem; *c != '\0'; c++) {
+        if ((len + 2) >= buf_size) {
+            return -ENOMEM;
+        }
+        if (*c == '\n') {
+            buf[len++] = '\\';
+            buf[len++] = 'n';
+        } else {
+            buf[len++] = *c;
+        }
+    }
+    if ((len + sizeof(suffix)) > buf_size) {
+        return -ENOMEM;
+    }
+    memcpy(&buf[len], suffix, sizeof(suffix));
+    return 0;
+}
+
+static int send_all(const void *buf, size_t len)
+{
+    const uint8_t *data = buf;
+    while (len > 0) {
+        ssize_t sent = zsock_send(client_sock, data, len, 0);
+        if (sent < 0) {
+            LOG_WRN("Pairing send failed: %d", errno); // NOLINT
+            return -errno;
+        }
+        data += sent;
+        len -= sent;
+    }
+    return 0;
+}
+
+static bool has_suffix(const char *str, const char *suffix)
+{
+    size_t str_len = strlen(str);
+    size_t suffix_len = strlen(suffix);
+    return (str_len >= suffix_len) && (strcmp(&str[str_len - suffix_len], suffix) == 0);
+}
@@ -0,0 +1,12 @@
+# (C) Copyright 2024, SECO Mind Srl
+#
+# SPDX-License-Identifier: Apache-2.0
+
+# Shared helpers of the integration tests: loopback MQTT broker and pairing APIs, TLS credentials,
+# test device configuration.
+set(TEST_COMMON_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+target_include_directories(app PRIVATE ${TEST_COMMON_DIR}/../include)
+
+FILE(GLOB test_common_sources ${TEST_COMMON_DIR}/src/*.c)
+target_sources(app PRIVATE ${test_common_sources})
@@ -0,0 +1,324 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/data.h"
+#include "astarte_device_sdk/device.h"
+#include "astarte_device_sdk/result.h"
+
+#include "device_caching.h"
+#include "device_connection.h"
+#include "device_private.h"
+#include "generated_interfaces.h"
+#include "test_broker.h"
+#include "test_device.h"
+#include "test_pairing.h"
+
+LOG_MODULE_REGISTER(device_connection_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+#define CONNECTION_TIMEOUT K_SECONDS(10)
+// Time given to the device to make progress when checking that it is blocked
+#define SETTLE_TIME K_MSEC(500)
+
+#define RESYNC_WINDOW CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_RESYNC_WINDOW
+#define DEVICE_PROPERTY (&org_astarteplatform_zephyr_examples_DeviceProperty)
+#define SERVER_PROPERTY (&org_astarteplatform_zephyr_examples_ServerProperty)
+#define SERVER_PROPERTY_TOPIC(path)                                                                \
+    CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "/" TEST_DEVICE_ID                                        \
+                                         "/org.astarteplatform.zephyr.examples.ServerProperty" path
+
+struct cached_property
+{
+    const astarte_interface_t *interface;
+    const char *path;
+};
+
+// Stored in this order, the resync goes through the cache from the last stored property
+static const struct cached_property cached_properties[] = {
+    { DEVICE_PROPERTY, "/sensor1/integer_endpoint" },
+    { SERVER_PROPERTY, "/sensor1/integer_endpoint" },
+    { DEVICE_PROPERTY, "/sensor2/integer_endpoint" },
+    { SERVER_PROPERTY, "/sensor2/integer_endpoint" },
+    { DEVICE_PROPERTY, "/sensor3/integer_endpoint" },
+    { SERVER_PROPERTY, "/sensor3/integer_endpoint" },
+    { DEVICE_PROPERTY, "/sensor4/integer_endpoint" },
+};
+static const char *const device_property_topics[] = {
+    "DeviceProperty/sensor1/integer_endpoint",
+    "DeviceProperty/sensor2/integer_endpoint",
+    "DeviceProperty/sensor3/integer_endpoint",
+    "DeviceProperty/sensor4/integer_endpoint",
+};
+
+static astarte_device_handle_t device;
+static atomic_t connections;
+static atomic_t disconnections;
+static atomic_t unsets;
+
+static void connection_cbk(astarte_device_connection_event_t event)
+{
+    ARG_UNUSED(event);
+    atomic_inc(&connections);
+}
+
+static void disconnection_cbk(astarte_device_disconnection_event_t event)
+{
+    ARG_UNUSED(event);
+    atomic_inc(&disconnections);
+}
+
+static void property_unset_cbk(astarte_device_data_event_t event)
+{
+    ARG_UNUSED(event);
+    atomic_inc(&unsets);
+}
+
+static size_t count_resent_properties(void)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(device_property_topics); i++) {
+        count += test_broker_count_published(device_property_topics[i]);
+    }
+    return count;
+}
+
+static bool is_handshake_ending(astarte_device_handle_t device)
+{
+    return device->connection_state == DEVICE_END_HANDSHAKE;
+}
+
+static bool is_connected(astarte_device_handle_t device)
+{
+    return device->connection_state == DEVICE_CONNECTED;
+}
+
+static bool is_disconnected(astarte_device_handle_t device)
+{
+    ARG_UNUSED(device);
+    return atomic_get(&disconnections) > 0;
+}
+
+static bool is_synchronized(astarte_device_handle_t device)
+{
+    return device->synchronization_completed;
+}
+
+static bool is_resync_window_full(astarte_device_handle_t device)
+{
+    ARG_UNUSED(device);
+    return count_resent_properties() >= RESYNC_WINDOW;
+}
+
+static bool are_server_properties_unset(astarte_device_handle_t device)
+{
+    ARG_UNUSED(device);
+    return atomic_get(&unsets) == 3;
+}
+
+static void assert_properties_resent_once(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(device_property_topics); i++) {
+        zassert_equal(test_broker_count_published(device_property_topics[i]), 1,
+            "Property %s resent %zu times", device_property_topics[i],
+            test_broker_count_published(device_property_topics[i]));
+    }
+}
+
+static void *device_connection_test_setup(void)
+{
+    zassert_ok(test_broker_start());
+    zassert_ok(test_pairing_start());
+    return NULL;
+}
+
+static void device_connection_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    test_broker_reset();
+    test_pairing_reset();
+    atomic_clear(&connections);
+    atomic_clear(&disconnections);
+    atomic_clear(&unsets);
+
+    zassert_ok(test_device_clear_storage());
+    for (size_t i = 0; i < ARRAY_SIZE(cached_properties); i++) {
+        const struct cached_property *property = &cached_properties[i];
+        astarte_data_t data = astarte_data_from_integer((int32_t) i);
+        zassert_equal(astarte_device_caching_property_store(property->interface->name,
+                          property->path, property->interface->major_version, data),
+            ASTARTE_RESULT_OK);
+    }
+
+    const astarte_interface_t *interfaces[] = { DEVICE_PROPERTY, SERVER_PROPERTY };
+    astarte_device_config_t cfg = { 0 };
+    test_device_config_init(&cfg);
+    cfg.connection_cbk = connection_cbk;
+    cfg.disconnection_cbk = disconnection_cbk;
+    cfg.property_unset_cbk = property_unset_cbk;
+    cfg.interfaces = interfaces;
+    cfg.interfaces_size = ARRAY_SIZE(interfaces);
+    zassert_equal(astarte_device_new(&cfg, &device), ASTARTE_RESULT_OK);
+}
+
+static void device_connection_test_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    test_broker_hold_acks(false);
+    zassert_equal(astarte_device_destroy(device), ASTARTE_RESULT_OK);
+    device = NULL;
+}
+
+static void device_connection_test_teardown(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_equal(test_pairing_stop(), 0, "Loopback pairing APIs failures");
+    zassert_equal(test_broker_stop(), 0, "Loopback broker failures");
+}
+
+ZTEST_SUITE(astarte_device_sdk_device_connection, NULL, device_connection_test_setup,
+    device_connection_test_before, device_connection_test_after,
+    device_connection_test_teardown); // NOLINT
+
+ZTEST(astarte_device_sdk_device_connection, test_device_connection_handshake_acks) // NOLINT
+{
+    test_broker_hold_acks(true);
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_handshake_ending, CONNECTION_TIMEOUT));
+
+    // Subscriptions, introspection, emptyCache and purge properties are sent but not acked
+    zassert_true(test_device_poll_for(device, SETTLE_TIME));
+    zassert_true(test_broker_count(TEST_BROKER_SUBSCRIBE) > 0);
+    zassert_true(test_broker_count_published(TEST_DEVICE_ID) > 0);
+    zassert_true(test_broker_count_published("/control/emptyCache") > 0);
+    zassert_true(test_broker_count_published("/control/producer/properties") > 0);
+    zassert_equal(device->connection_state, DEVICE_END_HANDSHAKE);
+    zassert_equal(atomic_get(&connections), 0);
+
+    test_broker_hold_acks(false);
+    zassert_true(test_device_poll_until(device, is_connected, CONNECTION_TIMEOUT));
+    zassert_equal(atomic_get(&connections), 1);
+    zassert_true(test_device_poll_until(device, is_synchronized, CONNECTION_TIMEOUT));
+    assert_properties_resent_once();
+}
+
+ZTEST(astarte_device_sdk_device_connection, test_device_connection_resync_window) // NOLINT
+{
+    test_broker_hold_acks(true);
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_resync_window_full, CONNECTION_TIMEOUT));
+
+    // No more properties are sent until the ones in flight are acked
+    zassert_true(test_device_poll_for(device, SETTLE_TIME));
+    zassert_equal(count_resent_properties(), RESYNC_WINDOW);
+    zassert_false(device->synchronization_completed);
+
+    test_broker_hold_acks(false);
+    zassert_true(test_device_poll_until(device, is_synchronized, CONNECTION_TIMEOUT));
+    zassert_equal(atomic_get(&connections), 1);
+    assert_properties_resent_once();
+}
+
+ZTEST(astarte_device_sdk_device_connection, test_device_connection_resync_deletions) // NOLINT
+{
+    test_broker_hold_acks(true);
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_resync_window_full, CONNECTION_TIMEOUT));
+
+    // The resync is waiting on the second server property, unset one property already gone
+    // through, the pointed one and one still to go through
+    zassert_ok(test_broker_publish(SERVER_PROPERTY_TOPIC("/sensor3/integer_endpoint"), NULL, 0, 1));
+    zassert_ok(test_broker_publish(SERVER_PROPERTY_TOPIC("/sensor2/integer_endpoint"), NULL, 0, 1));
+    zassert_ok(test_broker_publish(SERVER_PROPERTY_TOPIC("/sensor1/integer_endpoint"), NULL, 0, 1));
+    zassert_true(
+        test_device_poll_until(device, are_server_properties_unset, CONNECTION_TIMEOUT));
+    zassert_equal(count_resent_properties(), RESYNC_WINDOW);
+
+    // The resync continues from where it stopped, without sending any property twice
+    test_broker_hold_acks(false);
+    zassert_true(test_device_poll_until(device, is_synchronized, CONNECTION_TIMEOUT));
+    assert_properties_resent_once();
+
+    uint32_t major = 0U;
+    astarte_data_t data = { 0 };
+    zassert_equal(astarte_device_caching_property_load(
+                      SERVER_PROPERTY->name, "/sensor2/integer_endpoint", &major, &data),
+        ASTARTE_RESULT_NOT_FOUND);
+}
+
+ZTEST(astarte_device_sdk_device_connection, test_device_connection_session_present) // NOLINT
+{
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_synchronized, CONNECTION_TIMEOUT));
+    zassert_equal(astarte_device_disconnect(device, CONNECTION_TIMEOUT), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_disconnected, CONNECTION_TIMEOUT));
+
+    // A synchronized device reconnecting to its session skips the handshake
+    test_broker_reset();
+    test_broker_set_session_present(true);
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_connected, CONNECTION_TIMEOUT));
+    zassert_true(test_device_poll_for(device, SETTLE_TIME));
+    zassert_equal(atomic_get(&connections), 2);
+    zassert_equal(test_broker_count(TEST_BROKER_SUBSCRIBE), 0);
+    zassert_equal(count_resent_properties(), 0);
+    zassert_true(device->synchronization_completed);
+}
+
+ZTEST(astarte_device_sdk_device_connection, test_device_connection_subscriptions) // NOLINT
+{
+    const astarte_interface_t *interfaces[] = {
+        &org_astarteplatform_zephyr_examples_ServerAggregate,
+        &org_astarteplatform_zephyr_examples_ServerDatastream,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(interfaces); i++) {
+        zassert_equal(astarte_device_add_interface(device, interfaces[i]), ASTARTE_RESULT_OK);
+    }
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_connected, CONNECTION_TIMEOUT));
+
+    // The filters are split in packets fitting the MQTT TX buffer
+    size_t packets = test_broker_count(TEST_BROKER_SUBSCRIBE);
+    zassert_true(packets > 1);
+    size_t filters = 0;
+    test_broker_packet_t packet = { 0 };
+    for (size_t i = 0; i < packets; i++) {
+        zassert_true(test_broker_get(TEST_BROKER_SUBSCRIBE, i, &packet));
+        zassert_true(packet.packet_len <= CONFIG_ASTARTE_DEVICE_SDK_ADVANCED_MQTT_TX_BUFFER_SIZE);
+        zassert_str_equal(packet.topic, device->subscription_topics[filters]);
+        for (size_t j = filters; j < filters + packet.topics_count; j++) {
+            zassert_equal(device->subscription_msg_ids[j], packet.message_id);
+            zassert_not_equal(device->subscription_return_codes[j], MQTT_SUBACK_FAILURE);
+        }
+        filters += packet.topics_count;
+    }
+    zassert_equal(filters, device->subscription_topics_count);
+
+    // A return code is stored for the filter at its index within its own packet
+    size_t last_filter = filters - 1;
+    astarte_device_connection_on_subscribed_handler(&device->astarte_mqtt, packet.message_id,
+        packet.topics_count - 1, MQTT_SUBACK_FAILURE);
+    for (size_t i = 0; i < filters; i++) {
+        zassert_equal(device->subscription_return_codes[i] == MQTT_SUBACK_FAILURE,
+            i == last_filter, "Unexpected return code for %s", device->subscription_topics[i]);
+    }
+
+    // Return codes of unknown packets or past the filters of a packet are ignored
+    device->subscription_return_codes[last_filter] = MQTT_SUBACK_SUCCESS_QoS_2;
+    astarte_device_connection_on_subscribed_handler(
+        &device->astarte_mqtt, packet.message_id + 1, 0, MQTT_SUBACK_FAILURE);
+    astarte_device_connection_on_subscribed_handler(
+        &device->astarte_mqtt, packet.message_id, packet.topics_count, MQTT_SUBACK_FAILURE);
+    for (size_t i = 0; i < filters; i++) {
+        zassert_not_equal(device->subscription_return_codes[i], MQTT_SUBACK_FAILURE);
+    }
+}
@@ -0,0 +1,297 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/heap.h"
+#include "astarte_device_sdk/interface.h"
+#include "astarte_device_sdk/object.h"
+#include "astarte_device_sdk/result.h"
+
+#include "bson_deserializer.h"
+#include "bson_serializer.h"
+#include "data_private.h"
+#include "heap_private.h"
+#include "introspection.h"
+#include "mqtt.h"
+#include "object_private.h"
+
+LOG_MODULE_REGISTER(heap_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+/** @brief Number of TX/RX rounds performed by the mixed workload. */
+#define WORKLOAD_ITERATIONS 100
+/** @brief Maximum number of bytes the mixed workload is allowed to allocate at the same time. */
+#define WORKLOAD_HEAP_BUDGET 4096
+
+static void heap_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    astarte_heap_reset_peak();
+}
+
+ZTEST_SUITE(astarte_device_sdk_heap, NULL, NULL, heap_test_before, NULL, NULL); // NOLINT
+
+static const astarte_mapping_t individual_mappings[] = {
+    {
+        .endpoint = "/%{sensor_id}/value",
+        .type = ASTARTE_MAPPING_TYPE_STRINGARRAY,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+    },
+};
+
+static const astarte_interface_t individual_interface = {
+    .name = "org.astarteplatform.zephyr.test.Individual",
+    .major_version = 0,
+    .minor_version = 1,
+    .type = ASTARTE_INTERFACE_TYPE_DATASTREAM,
+    .ownership = ASTARTE_INTERFACE_OWNERSHIP_DEVICE,
+    .aggregation = ASTARTE_INTERFACE_AGGREGATION_INDIVIDUAL,
+    .mappings = individual_mappings,
+    .mappings_length = ARRAY_SIZE(individual_mappings),
+};
+
+static const astarte_mapping_t object_mappings[] = {
+    {
+        .endpoint = "/%{sensor_id}/double_endpoint",
+        .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+    },
+    {
+        .endpoint = "/%{sensor_id}/binaryblob_endpoint",
+        .type = ASTARTE_MAPPING_TYPE_BINARYBLOB,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+    },
+};
+
+static const astarte_interface_t object_interface = {
+    .name = "org.astarteplatform.zephyr.test.Object",
+    .major_version = 0,
+    .minor_version = 1,
+    .type = ASTARTE_INTERFACE_TYPE_DATASTREAM,
+    .ownership = ASTARTE_INTERFACE_OWNERSHIP_SERVER,
+    .aggregation = ASTARTE_INTERFACE_AGGREGATION_OBJECT,
+    .mappings = object_mappings,
+    .mappings_length = ARRAY_SIZE(object_mappings),
+};
+
+static const char *string_array[] = { "hello", "astarte", "heap" };
+static const uint8_t binaryblob[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0x00, 0x01, 0x02, 0x03 };
+
+/**
+ * @brief Serialize a BSON payload as it would be transmitted, wrapping it in an MQTT payload.
+ */
+static astarte_mqtt_payload_t *transmit_individual(void)
+{
+    astarte_bson_serializer_t bson = { 0 };
+    astarte_data_t data = astarte_data_from_string_array(string_array, ARRAY_SIZE(string_array));
+
+    zassert_equal(astarte_bson_serializer_init(&bson), ASTARTE_RESULT_OK);
+    zassert_equal(astarte_data_serialize(&bson, "v", data), ASTARTE_RESULT_OK);
+    astarte_bson_serializer_append_end_of_document(&bson);
+
+    size_t size = 0;
+    void *buf = astarte_bson_serializer_detach(&bson, &size);
+    zassert_not_null(buf);
+    astarte_mqtt_payload_t *payload = astarte_mqtt_payload_wrap(buf, size);
+    zassert_not_null(payload);
+    return payload;
+}
+
+/**
+ * @brief Serialize an object BSON payload, wrapping it in an MQTT payload.
+ */
+static astarte_mqtt_payload_t *transmit_object(void)
+{
+    astarte_object_entry_t entries[] = {
+        astarte_object_entry_new("double_endpoint", astarte_data_from_double(42.3)),
+        astarte_object_entry_new("binaryblob_endpoint",
+            astarte_data_from_binaryblob((void *) binaryblob, ARRAY_SIZE(binaryblob))),
+    };
+    astarte_bson_serializer_t inner_bson = { 0 };
+    astarte_bson_serializer_t outer_bson = { 0 };
+
+    zassert_equal(astarte_bson_serializer_init(&inner_bson), ASTARTE_RESULT_OK);
+    zassert_equal(
+        astarte_object_entries_serialize(&inner_bson, entries, ARRAY_SIZE(entries)),
+        ASTARTE_RESULT_OK);
+    astarte_bson_serializer_append_end_of_document(&inner_bson);
+
+    zassert_equal(astarte_bson_serializer_init(&outer_bson), ASTARTE_RESULT_OK);
+    int inner_size = 0;
+    const void *inner_data = astarte_bson_serializer_get_serialized(inner_bson, &inner_size);
+    astarte_bson_serializer_append_document(&outer_bson, "v", inner_data);
+    astarte_bson_serializer_append_end_of_document(&outer_bson);
+    astarte_bson_serializer_destroy(&inner_bson);
+
+    size_t size = 0;
+    void *buf = astarte_bson_serializer_detach(&outer_bson, &size);
+    zassert_not_null(buf);
+    astarte_mqtt_payload_t *payload = astarte_mqtt_payload_wrap(buf, size);
+    zassert_not_null(payload);
+    return payload;
+}
+
+/**
+ * @brief Deserialize a payload as the reception path of the device would.
+ */
+static void receive_payload(astarte_mqtt_payload_t *payload, bool object)
+{
+    zassert_true(astarte_bson_deserializer_check_validity(payload->data, payload->size));
+    astarte_bson_document_t doc = astarte_bson_deserializer_init_doc(payload->data);
+    astarte_bson_element_t v_elem = { 0 };
+    zassert_equal(astarte_bson_deserializer_element_lookup(doc, "v", &v_elem), ASTARTE_RESULT_OK);
+
+    if (object) {
+        astarte_object_entry_t *entries = NULL;
+        size_t entries_len = 0;
+        astarte_result_t ares = astarte_object_entries_deserialize(
+            v_elem, &object_interface, "/sensor11", &entries, &entries_len);
+        zassert_equal(ares, ASTARTE_RESULT_OK, "%s", astarte_result_to_name(ares));
+        zassert_equal(entries_len, ARRAY_SIZE(object_mappings));
+        astarte_object_entries_destroy_deserialized(entries, entries_len);
+    } else {
+        astarte_data_t data = { 0 };
+        astarte_result_t ares
+            = astarte_data_deserialize(v_elem, ASTARTE_MAPPING_TYPE_STRINGARRAY, &data);
+        zassert_equal(ares, ASTARTE_RESULT_OK, "%s", astarte_result_to_name(ares));
+        zassert_equal(data.data.string_array.len, ARRAY_SIZE(string_array));
+        astarte_data_destroy_deserialized(data);
+    }
+}
+
+/**
+ * @brief Run a mixed workload of introspection updates, transmissions and receptions.
+ */
+static void run_mixed_workload(void)
+{
+    introspection_t introspection = { 0 };
+    zassert_equal(introspection_init(&introspection), ASTARTE_RESULT_OK);
+
+    for (size_t i = 0; i < WORKLOAD_ITERATIONS; i++) {
+        zassert_equal(introspection_add(&introspection, &individual_interface), ASTARTE_RESULT_OK);
+        zassert_equal(introspection_add(&introspection, &object_interface), ASTARTE_RESULT_OK);
+
+        // Keep an extra reference as the retransmission cache would do for QoS 1 and 2 messages
+        astarte_mqtt_payload_t *individual = transmit_individual();
+        astarte_mqtt_payload_ref(individual);
+        astarte_mqtt_payload_t *object = transmit_object();
+
+        receive_payload(individual, false);
+        receive_payload(object, true);
+
+        astarte_mqtt_payload_unref(individual);
+        astarte_mqtt_payload_unref(object);
+        astarte_mqtt_payload_unref(individual);
+
+        zassert_equal(
+            introspection_remove(&introspection, individual_interface.name), ASTARTE_RESULT_OK);
+        zassert_equal(
+            introspection_remove(&introspection, object_interface.name), ASTARTE_RESULT_OK);
+    }
+
+    introspection_free(introspection);
+}
+
+ZTEST(astarte_device_sdk_heap, test_heap_mixed_workload_budget)
+{
+    astarte_heap_stats_t stats = { 0 };
+    astarte_heap_get_stats(&stats);
+    zassert_equal(stats.live_bytes, 0);
+    zassert_equal(stats.live_blocks, 0);
+
+    run_mixed_workload();
+
+    astarte_heap_get_stats(&stats);
+    for (size_t i = 0; i < ASTARTE_HEAP_MODULE_COUNT; i++) {
+        LOG_INF("Module %s peak: %zu bytes", // NOLINT
+            astarte_heap_module_to_name(i), stats.modules[i].peak_bytes);
+    }
+    LOG_INF("Total peak: %zu bytes", stats.peak_bytes); // NOLINT
+
+    zassert_equal(stats.live_bytes, 0, "Leaked %zu bytes", stats.live_bytes);
+    zassert_equal(stats.live_blocks, 0, "Leaked %zu blocks", stats.live_blocks);
+    zassert_equal(stats.failed_allocations, 0);
+    zassert_true(stats.peak_bytes <= WORKLOAD_HEAP_BUDGET, "Peak of %zu bytes over budget",
+        stats.peak_bytes);
+
+    zassert_true(stats.modules[ASTARTE_HEAP_MODULE_BSON].peak_bytes > 0);
+    zassert_true(stats.modules[ASTARTE_HEAP_MODULE_DATA].peak_bytes > 0);
+    zassert_true(stats.modules[ASTARTE_HEAP_MODULE_INTROSPECTION].peak_bytes > 0);
+    zassert_true(stats.modules[ASTARTE_HEAP_MODULE_MQTT].peak_bytes > 0);
+    zassert_true(stats.modules[ASTARTE_HEAP_MODULE_OBJECT].peak_bytes > 0);
+    zassert_equal(stats.modules[ASTARTE_HEAP_MODULE_KV_STORAGE].peak_bytes, 0);
+}
+
+ZTEST(astarte_device_sdk_heap, test_heap_exhaustion)
+{
+    astarte_heap_stats_t stats = { 0 };
+    astarte_heap_get_stats(&stats);
+    size_t failed_allocations = stats.failed_allocations;
+
+    void *ptr = astarte_heap_malloc(ASTARTE_HEAP_MODULE_DATA, CONFIG_ASTARTE_DEVICE_SDK_HEAP_SIZE);
+    zassert_is_null(ptr, "The dedicated heap should not fit its own size plus the bookkeeping");
+
+    astarte_heap_get_stats(&stats);
+    zassert_equal(stats.failed_allocations, failed_allocations + 1);
+    zassert_equal(stats.live_bytes, 0);
+}
+
+struct counting_allocator
+{
+    size_t allocs;
+    size_t frees;
+};
+
+static void *counting_alloc(size_t size, void *user_data)
+{
+    struct counting_allocator *counter = user_data;
+    counter->allocs++;
+    return malloc(size);
+}
+
+static void counting_free(void *ptr, void *user_data)
+{
+    struct counting_allocator *counter = user_data;
+    counter->frees++;
+    free(ptr);
+}
+
+ZTEST(astarte_device_sdk_heap, test_heap_custom_allocator)
+{
+    struct counting_allocator counter = { 0 };
+    astarte_heap_allocator_t allocator = {
+        .alloc = counting_alloc,
+        .free = counting_free,
+        .user_data = &counter,
+    };
+    astarte_heap_allocator_t incomplete_allocator = { .alloc = counting_alloc };
+
+    zassert_equal(
+        astarte_heap_set_allocator(&incomplete_allocator), ASTARTE_RESULT_INVALID_PARAM);
+
+    // The allocator can't be replaced while some memory is allocated
+    void *ptr = astarte_heap_malloc(ASTARTE_HEAP_MODULE_DATA, 16);
+    zassert_not_null(ptr);
+    zassert_equal(astarte_heap_set_allocator(&allocator), ASTARTE_RESULT_INVALID_CONFIGURATION);
+    astarte_heap_free(ptr);
+
+    zassert_equal(astarte_heap_set_allocator(&allocator), ASTARTE_RESULT_OK);
+    run_mixed_workload();
+    zassert_equal(astarte_heap_set_allocator(NULL), ASTARTE_RESULT_OK);
+
+    zassert_true(counter.allocs > 0);
+    zassert_equal(counter.allocs, counter.frees);
+}
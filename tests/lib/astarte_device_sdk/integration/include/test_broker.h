@@ -0,0 +1,206 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TEST_BROKER_H
+#define TEST_BROKER_H
+
+/**
+ * @file test_broker.h
+ * @brief Minimal MQTT 3.1.1 broker over TLS, running in the test image on the loopback interface.
+ *
+ * @details A single client connection is served at a time. All the packets received from the
+ * client are recorded and can be inspected by the test. Failures of the broker thread are counted
+ * and reported to the test thread by #test_broker_stop.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+/** @brief Hostname to configure in the MQTT client. */
+#define TEST_BROKER_HOSTNAME "127.0.0.1"
+/** @brief Port to configure in the MQTT client. */
+#define TEST_BROKER_PORT "8883"
+/** @brief Maximum length of a recorded topic, longer topics are truncated. */
+#define TEST_BROKER_MAX_TOPIC_LEN 191
+/** @brief Maximum payload length of the messages published by the broker. */
+#define TEST_BROKER_MAX_PUBLISH_LEN 8192
+/** @brief Maximum number of recorded payload bytes, longer payloads are truncated. */
+#define TEST_BROKER_MAX_PAYLOAD_LEN 256
+
+/** @brief MQTT control packet types, as encoded in the fixed header. */
+enum test_broker_packet_type
+{
+    TEST_BROKER_CONNECT = 1,
+    TEST_BROKER_PUBLISH = 3,
+    TEST_BROKER_PUBACK = 4,
+    TEST_BROKER_PUBREC = 5,
+    TEST_BROKER_PUBREL = 6,
+    TEST_BROKER_PUBCOMP = 7,
+    TEST_BROKER_SUBSCRIBE = 8,
+    TEST_BROKER_UNSUBSCRIBE = 10,
+    TEST_BROKER_PINGREQ = 12,
+    TEST_BROKER_DISCONNECT = 14,
+};
+
+/** @brief Packet received by the broker. */
+typedef struct
+{
+    /** @brief Packet type. */
+    enum test_broker_packet_type type;
+    /** @brief Size of the whole packet in bytes, fixed header included. */
+    size_t packet_len;
+    /** @brief QoS of a PUBLISH packet. */
+    uint8_t qos;
+    /** @brief Set for a retransmitted PUBLISH packet. */
+    bool dup;
+    /** @brief Message ID of the packet, zero when not present. */
+    uint16_t message_id;
+    /** @brief Topic of a PUBLISH packet, or first topic filter of a SUBSCRIBE packet. */
+    char topic[TEST_BROKER_MAX_TOPIC_LEN + 1];
+    /** @brief Number of topic filters of a SUBSCRIBE packet. */
+    size_t topics_count;
+    /** @brief Full payload length of a PUBLISH packet. */
+    size_t payload_len;
+    /** @brief First bytes of the payload of a PUBLISH packet. */
+    uint8_t payload[TEST_BROKER_MAX_PAYLOAD_LEN];
+} test_broker_packet_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Install the broker TLS credentials and start the broker thread.
+ *
+ * @return Zero if successful, a negative errno value otherwise.
+ */
+int test_broker_start(void);
+
+/**
+ * @brief Install the certificate of the broker as the client certificate of the SDK.
+ *
+ * @details Used by the tests driving the MQTT client directly, without going through the pairing.
+ *
+ * @return Zero if successful, a negative errno value otherwise.
+ */
+int test_broker_add_client_credentials(void);
+
+/**
+ * @brief Stop the broker thread and wait for it to terminate.
+ *
+ * @return Number of failures encountered by the broker since it has been started.
+ */
+int test_broker_stop(void);
+
+/**
+ * @brief Forget all the recorded packets and restore the default broker behavior.
+ */
+void test_broker_reset(void);
+
+/**
+ * @brief Set the session present flag returned in the following CONNACK packets.
+ *
+ * @param[in] session_present Value of the session present flag.
+ */
+void test_broker_set_session_present(bool session_present);
+
+/**
+ * @brief Refuse the subscriptions to the topic filters containing a string.
+ *
+ * @param[in] match String to search in the topic filters, NULL to grant all the subscriptions.
+ */
+void test_broker_reject_subscriptions(const char *match);
+
+/**
+ * @brief Hold the acknowledgments (PUBACK, PUBREC and SUBACK) for the packets of the client.
+ *
+ * @details When released, the acknowledgments held until then are sent in order.
+ *
+ * @param[in] hold True to hold the acknowledgments, false to release them.
+ */
+void test_broker_hold_acks(bool hold);
+
+/**
+ * @brief Close the connection with the client, as a broker going away would do.
+ */
+void test_broker_drop_connection(void);
+
+/**
+ * @brief Check if a client is connected to the broker.
+ *
+ * @return True if an MQTT session is established with a client, false otherwise.
+ */
+bool test_broker_is_connected(void);
+
+/**
+ * @brief Publish a message to the connected client.
+ *
+ * @details The message is copied and sent by the broker thread, this function does not wait for its
+ * transmission. The client can be polled right after this call to receive the message.
+ *
+ * @param[in] topic Topic of the message.
+ * @param[in] payload Payload of the message, can be NULL for empty payloads.
+ * @param[in] payload_len Length of the payload.
+ * @param[in] qos QoS of the message.
+ * @return Zero if the message has been queued, a negative errno value otherwise.
+ */
+int test_broker_publish(const char *topic, const void *payload, size_t payload_len, int qos);
+
+/**
+ * @brief Count the recorded packets of a type.
+ *
+ * @param[in] type Type of the packets to count.
+ * @return Number of packets recorded.
+ */
+size_t test_broker_count(enum test_broker_packet_type type);
+
+/**
+ * @brief Count the recorded PUBLISH packets on a topic ending with a suffix.
+ *
+ * @param[in] topic_suffix Suffix of the topic of the packets to count.
+ * @return Number of packets recorded.
+ */
+size_t test_broker_count_published(const char *topic_suffix);
+
+/**
+ * @brief Wait until at least a number of PUBLISH packets on a topic ending with a suffix have been
+ * recorded.
+ *
+ * @param[in] topic_suffix Suffix of the topic of the packets to wait for.
+ * @param[in] count Number of packets to wait for.
+ * @param[in] timeout Maximum time to wait.
+ * @return True if the packets have been recorded in time, false otherwise.
+ */
+bool test_broker_wait_published(const char *topic_suffix, size_t count, k_timeout_t timeout);
+
+/**
+ * @brief Get a recorded packet of a type.
+ *
+ * @param[in] type Type of the packet.
+ * @param[in] index Index of the packet among the recorded packets of the same type.
+ * @param[out] packet Copy of the recorded packet.
+ * @return True if the packet has been found, false otherwise.
+ */
+bool test_broker_get(enum test_broker_packet_type type, size_t index, test_broker_packet_t *packet);
+
+/**
+ * @brief Wait until at least a number of packets of a type have been recorded.
+ *
+ * @param[in] type Type of the packets to wait for.
+ * @param[in] count Number of packets to wait for.
+ * @param[in] timeout Maximum time to wait.
+ * @return True if the packets have been recorded in time, false otherwise.
+ */
+bool test_broker_wait(enum test_broker_packet_type type, size_t count, k_timeout_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_BROKER_H */
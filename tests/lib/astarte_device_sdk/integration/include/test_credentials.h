@@ -0,0 +1,28 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TEST_CREDENTIALS_H
+#define TEST_CREDENTIALS_H
+
+/**
+ * @file test_credentials.h
+ * @brief TLS credentials shared by the servers and clients of the loopback tests.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Self signed certificate for 'localhost', used as server, client and CA certificate. */
+extern const char test_credentials_crt_pem[];
+/** @brief Private key of #test_credentials_crt_pem. */
+extern const char test_credentials_key_pem[];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_CREDENTIALS_H */
@@ -0,0 +1,74 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TEST_DEVICE_H
+#define TEST_DEVICE_H
+
+/**
+ * @file test_device.h
+ * @brief Helpers driving an Astarte device connected to the loopback broker and pairing APIs.
+ */
+
+#include <stdbool.h>
+
+#include <zephyr/kernel.h>
+
+#include "astarte_device_sdk/device.h"
+#include "astarte_device_sdk/result.h"
+
+/** @brief Device ID of the tested device, any ID is accepted by the loopback pairing APIs. */
+#define TEST_DEVICE_ID "GwUgUK4BRqCdRDWNM1WkwA"
+/** @brief Credential secret of the tested device. */
+#define TEST_DEVICE_CRED_SECR "CxOHlDnwSGKtq5CQWIMPjs2sOqBTG0JrTfHNDpHiyGk="
+
+/** @brief Condition checked by #test_device_poll_until after each poll. */
+typedef bool (*test_device_condition_t)(astarte_device_handle_t device);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize a device configuration with the test credentials and short timeouts.
+ *
+ * @param[out] cfg Configuration to initialize, the callbacks and interfaces are left empty.
+ */
+void test_device_config_init(astarte_device_config_t *cfg);
+
+/**
+ * @brief Poll a device until a condition is met.
+ *
+ * @param[in] device Device to poll.
+ * @param[in] condition Condition to wait for.
+ * @param[in] timeout Maximum time to wait.
+ * @return True if the condition has been met in time, false on timeout or poll failure.
+ */
+bool test_device_poll_until(
+    astarte_device_handle_t device, test_device_condition_t condition, k_timeout_t timeout);
+
+/**
+ * @brief Poll a device for a fixed amount of time.
+ *
+ * @param[in] device Device to poll.
+ * @param[in] duration Time to spend polling.
+ * @return True if all the polls succeeded, false otherwise.
+ */
+bool test_device_poll_for(astarte_device_handle_t device, k_timeout_t duration);
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+/**
+ * @brief Erase the permanent storage of the device.
+ *
+ * @return Zero if successful, a negative errno value otherwise.
+ */
+int test_device_clear_storage(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_DEVICE_H */
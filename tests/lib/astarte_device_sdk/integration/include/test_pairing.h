@@ -0,0 +1,106 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TEST_PAIRING_H
+#define TEST_PAIRING_H
+
+/**
+ * @file test_pairing.h
+ * @brief Minimal Astarte pairing APIs over plain HTTP, running in the test image on the loopback
+ * interface.
+ *
+ * @details Serves the broker information, the client certificate and the certificate verification
+ * requests of the device. Connections are kept alive when requested by the client. Failures of the
+ * server thread are counted and reported to the test thread by #test_pairing_stop.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "test_broker.h"
+
+/** @brief Broker URL returned to the device, pointing to the loopback broker. */
+#define TEST_PAIRING_BROKER_URL "mqtts://" TEST_BROKER_HOSTNAME ":" TEST_BROKER_PORT "/"
+
+/** @brief Requests served by the pairing APIs. */
+enum test_pairing_request
+{
+    /** @brief GET of the broker information. */
+    TEST_PAIRING_BROKER_INFO = 0,
+    /** @brief POST of a CSR, for a new client certificate. */
+    TEST_PAIRING_CLIENT_CRT,
+    /** @brief POST of a client certificate, for its verification. */
+    TEST_PAIRING_VERIFY_CRT,
+    /** @brief Number of request types. */
+    TEST_PAIRING_REQUESTS_COUNT,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the pairing APIs thread.
+ *
+ * @return Zero if successful, a negative errno value otherwise.
+ */
+int test_pairing_start(void);
+
+/**
+ * @brief Stop the pairing APIs thread and wait for it to terminate.
+ *
+ * @return Number of failures encountered by the server since it has been started.
+ */
+int test_pairing_stop(void);
+
+/**
+ * @brief Reset the request counters and restore the default behavior.
+ *
+ * @details By default all the requests succeed and the client certificate is
+ * #test_credentials_crt_pem.
+ */
+void test_pairing_reset(void);
+
+/**
+ * @brief Set the certificate returned for the following client certificate requests.
+ *
+ * @param[in] crt_pem PEM certificate, must stay valid until replaced or reset.
+ */
+void test_pairing_set_client_crt(const char *crt_pem);
+
+/**
+ * @brief Fail the following requests with an internal server error.
+ *
+ * @param[in] fail True to fail the requests, false to serve them.
+ */
+void test_pairing_fail_requests(bool fail);
+
+/**
+ * @brief Count the requests of a type served since the last reset, failed ones included.
+ *
+ * @param[in] request Type of the requests to count.
+ * @return Number of requests received.
+ */
+size_t test_pairing_count(enum test_pairing_request request);
+
+/**
+ * @brief Count the client connections accepted since the last reset.
+ *
+ * @return Number of connections accepted.
+ */
+size_t test_pairing_count_connections(void);
+
+/**
+ * @brief Close the connection kept alive with the client, as a server closing an idle connection
+ * would do.
+ */
+void test_pairing_close_connection(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_PAIRING_H */
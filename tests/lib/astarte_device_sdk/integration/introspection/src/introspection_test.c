@@ -220,41 +220,42 @@ ZTEST(astarte_device_sdk_introspection, test_introspection_remove_twice) // NOLI
     introspection_free(introspection);
 }
 
-ZTEST(astarte_device_sdk_introspection, test_introspection_iter) // NOLINT
+ZTEST(astarte_device_sdk_introspection, test_introspection_table) // NOLINT
 {
     LOG_INF("Creating introspection"); // NOLINT
     introspection_t introspection;
     introspection_init(&introspection);
 
     LOG_INF("Adding interfaces"); // NOLINT
+    check_add_interface_ok(&introspection, &test_interface_c);
     check_add_interface_ok(&introspection, &test_interface_a);
     check_add_interface_ok(&introspection, &test_interface_b);
-    check_add_interface_ok(&introspection, &test_interface_c);
-
-    LOG_INF("Creating introspection iterator"); // NOLINT
-    introspection_node_t *introspection_iterator = introspection_iter(&introspection);
-    LOG_INF("First interface '%s'", introspection_iterator->interface); // NOLINT
-    zassert_equal_ptr(&test_interface_a, introspection_iterator->interface);
-
-    LOG_INF("Advancing iterator"); // NOLINT
-    introspection_iterator = introspection_iter_next(&introspection, introspection_iterator);
-    LOG_INF("Second interface '%s'", introspection_iterator->interface); // NOLINT
-    zassert_equal_ptr(&test_interface_b, introspection_iterator->interface);
 
-    LOG_INF("Advancing iterator"); // NOLINT
-    introspection_iterator = introspection_iter_next(&introspection, introspection_iterator);
-    LOG_INF("Third interface '%s'", introspection_iterator->interface); // NOLINT
-    zassert_equal_ptr(&test_interface_c, introspection_iterator->interface);
-
-    LOG_INF("Advancing iterator"); // NOLINT
-    introspection_iterator = introspection_iter_next(&introspection, introspection_iterator);
-    LOG_INF("No fourth interface %p", introspection_iterator); // NOLINT
-    zassert_equal_ptr(NULL, introspection_iterator);
-
-    LOG_INF("Advancing iterator"); // NOLINT
-    introspection_iterator = introspection_iter_next(&introspection, introspection_iterator);
-    LOG_INF("No fourth interface %p", introspection_iterator); // NOLINT
-    zassert_equal_ptr(NULL, introspection_iterator);
+    LOG_INF("Acquiring introspection table"); // NOLINT
+    const introspection_table_t *table = introspection_acquire(&introspection);
+    zassert_equal(3, table->count);
+    LOG_INF("First interface '%s'", table->interfaces[0]->name); // NOLINT
+    zassert_equal_ptr(&test_interface_a, table->interfaces[0]);
+    LOG_INF("Second interface '%s'", table->interfaces[1]->name); // NOLINT
+    zassert_equal_ptr(&test_interface_b, table->interfaces[1]);
+    LOG_INF("Third interface '%s'", table->interfaces[2]->name); // NOLINT
+    zassert_equal_ptr(&test_interface_c, table->interfaces[2]);
+
+    LOG_INF("Removing interface '%s' with the table acquired", test_interface_b.name); // NOLINT
+    check_remove_interface_ok(&introspection, (char *) test_interface_b.name);
+    zassert_equal_ptr(NULL, introspection_get(&introspection, (char *) test_interface_b.name));
+
+    LOG_INF("Checking the acquired table is unchanged"); // NOLINT
+    zassert_equal(3, table->count);
+    zassert_equal_ptr(&test_interface_b, table->interfaces[1]);
+    introspection_release(table);
+
+    LOG_INF("Acquiring the updated introspection table"); // NOLINT
+    table = introspection_acquire(&introspection);
+    zassert_equal(2, table->count);
+    zassert_equal_ptr(&test_interface_a, table->interfaces[0]);
+    zassert_equal_ptr(&test_interface_c, table->interfaces[1]);
+    introspection_release(table);
 
     LOG_INF("Freeing introspection"); // NOLINT
     introspection_free(introspection);
@@ -302,6 +303,50 @@ ZTEST(astarte_device_sdk_introspection, test_introspection_update_ok) // NOLINT
     introspection_free(introspection);
 }
 
+ZTEST(astarte_device_sdk_introspection, test_introspection_digest) // NOLINT
+{
+    uint8_t digest_empty[INTROSPECTION_DIGEST_SIZE] = { 0 };
+    uint8_t digest_abc[INTROSPECTION_DIGEST_SIZE] = { 0 };
+    uint8_t digest_cba[INTROSPECTION_DIGEST_SIZE] = { 0 };
+    uint8_t digest[INTROSPECTION_DIGEST_SIZE] = { 0 };
+
+    LOG_INF("Creating introspections"); // NOLINT
+    introspection_t introspection;
+    introspection_init(&introspection);
+    introspection_t introspection_reversed;
+    introspection_init(&introspection_reversed);
+    introspection_get_digest(&introspection, digest_empty);
+
+    LOG_INF("Adding interfaces in different orders"); // NOLINT
+    check_add_interface_ok(&introspection, &test_interface_a);
+    check_add_interface_ok(&introspection, &test_interface_b);
+    check_add_interface_ok(&introspection, &test_interface_c);
+    check_add_interface_ok(&introspection_reversed, &test_interface_c);
+    check_add_interface_ok(&introspection_reversed, &test_interface_b);
+    check_add_interface_ok(&introspection_reversed, &test_interface_a);
+
+    introspection_get_digest(&introspection, digest_abc);
+    introspection_get_digest(&introspection_reversed, digest_cba);
+    zassert_mem_equal(digest_abc, digest_cba, INTROSPECTION_DIGEST_SIZE);
+    zassert_true(memcmp(digest_abc, digest_empty, INTROSPECTION_DIGEST_SIZE) != 0);
+
+    LOG_INF("Updating the interface '%s'", test_interface_a_v2_valid.name); // NOLINT
+    check_update_interface_ok(&introspection, &test_interface_a_v2_valid);
+    introspection_get_digest(&introspection, digest);
+    zassert_true(memcmp(digest, digest_abc, INTROSPECTION_DIGEST_SIZE) != 0);
+
+    LOG_INF("Removing all the interfaces"); // NOLINT
+    check_remove_interface_ok(&introspection, (char *) test_interface_a.name);
+    check_remove_interface_ok(&introspection, (char *) test_interface_b.name);
+    check_remove_interface_ok(&introspection, (char *) test_interface_c.name);
+    introspection_get_digest(&introspection, digest);
+    zassert_mem_equal(digest, digest_empty, INTROSPECTION_DIGEST_SIZE);
+
+    LOG_INF("Freeing introspections"); // NOLINT
+    introspection_free(introspection);
+    introspection_free(introspection_reversed);
+}
+
 ZTEST(astarte_device_sdk_introspection, test_introspection_update_invalid_version) // NOLINT
 {
     LOG_INF("Creating introspection"); // NOLINT
@@ -5,6 +5,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <zephyr/drivers/flash.h>
 #include <zephyr/storage/flash_map.h>
@@ -612,3 +613,101 @@ ZTEST_F(astarte_device_sdk_kv_storage, test_kv_storage_multiple_namespaces) // N
     astarte_kv_storage_destroy(kv_storage_1);
     astarte_kv_storage_destroy(kv_storage_2);
 }
+
+ZTEST_F(astarte_device_sdk_kv_storage, test_kv_storage_iteration_realign) // NOLINT
+{
+    astarte_result_t ret = ASTARTE_RESULT_OK;
+    size_t value_size = 0U;
+
+    // Initialize first storage driver
+    astarte_kv_storage_t kv_storage_1 = { 0 };
+    const char namespace_1[] = "first namespace";
+    astarte_kv_storage_cfg_t storage_1_cfg = {
+        .flash_device = fixture->flash_device,
+        .flash_offset = fixture->flash_offset,
+        .flash_sector_count = fixture->flash_sector_count,
+        .flash_sector_size = fixture->flash_sector_size,
+    };
+    ret = astarte_kv_storage_new(storage_1_cfg, namespace_1, &kv_storage_1);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+
+    // Initialize second storage driver
+    astarte_kv_storage_t kv_storage_2 = { 0 };
+    const char namespace_2[] = "second namespace";
+    astarte_kv_storage_cfg_t storage_2_cfg = {
+        .flash_device = fixture->flash_device,
+        .flash_offset = fixture->flash_offset,
+        .flash_sector_count = fixture->flash_sector_count,
+        .flash_sector_size = fixture->flash_sector_size,
+    };
+    ret = astarte_kv_storage_new(storage_2_cfg, namespace_2, &kv_storage_2);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+
+    // Insert some key-value pairs, with a pair of another namespace in the middle
+    ret = astarte_kv_storage_insert(&kv_storage_1, key1, value1, ARRAY_SIZE(value1));
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_insert(&kv_storage_1, key2, value2, ARRAY_SIZE(value2));
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_insert(&kv_storage_2, key3, value3, ARRAY_SIZE(value3));
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_insert(&kv_storage_1, key4, value4, ARRAY_SIZE(value4));
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_insert(&kv_storage_1, key5, value5, ARRAY_SIZE(value5));
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+
+    // Iterate over first storage up to the fourth key
+    astarte_kv_storage_iter_t iter = { 0 };
+    ret = astarte_kv_storage_iterator_init(&kv_storage_1, &iter);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_iterator_next(&iter);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+
+    // Deleting an already iterated pair does not move the iterator
+    ret = astarte_kv_storage_delete(&kv_storage_1, key5);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_iterator_realign(&iter, key4);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+
+    value_size = ARRAY_SIZE(res_key4);
+    ret = astarte_kv_storage_iterator_get(&iter, res_key4, &value_size);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    zassert_equal(value_size, ARRAY_SIZE(key4), "Incorrect value size:%s", value_size);
+    zassert_mem_equal(res_key4, key4, ARRAY_SIZE(key4), "Mismatched values", res_key4);
+
+    // Deleting a pair not yet iterated shifts back the pointed pair
+    ret = astarte_kv_storage_delete(&kv_storage_2, key3);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_iterator_realign(&iter, key4);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+
+    memset(res_key4, 0, ARRAY_SIZE(res_key4));
+    value_size = ARRAY_SIZE(res_key4);
+    ret = astarte_kv_storage_iterator_get(&iter, res_key4, &value_size);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    zassert_equal(value_size, ARRAY_SIZE(key4), "Incorrect value size:%s", value_size);
+    zassert_mem_equal(res_key4, key4, ARRAY_SIZE(key4), "Mismatched values", res_key4);
+
+    // Deleting the pointed pair advances the iterator
+    ret = astarte_kv_storage_delete(&kv_storage_1, key4);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_iterator_realign(&iter, key4);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+
+    value_size = ARRAY_SIZE(res_key2);
+    ret = astarte_kv_storage_iterator_get(&iter, res_key2, &value_size);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    zassert_equal(value_size, ARRAY_SIZE(key2), "Incorrect value size:%s", value_size);
+    zassert_mem_equal(res_key2, key2, ARRAY_SIZE(key2), "Mismatched values", res_key2);
+
+    ret = astarte_kv_storage_iterator_next(&iter);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+
+    // Deleting the last pointed pair ends the iteration
+    ret = astarte_kv_storage_delete(&kv_storage_1, key1);
+    zassert_equal(ret, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ret));
+    ret = astarte_kv_storage_iterator_realign(&iter, key1);
+    zassert_equal(ret, ASTARTE_RESULT_NOT_FOUND, "Res:%s", astarte_result_to_name(ret));
+
+    astarte_kv_storage_destroy(kv_storage_1);
+    astarte_kv_storage_destroy(kv_storage_2);
+}
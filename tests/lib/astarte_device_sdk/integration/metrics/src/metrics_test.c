@@ -0,0 +1,133 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/hash_map.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/metrics.h"
+
+#include "metrics_private.h"
+#include "mqtt_caching.h"
+
+LOG_MODULE_REGISTER(metrics_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+SYS_HASHMAP_DEFINE_STATIC(in_flight_map);
+
+static void metrics_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    astarte_metrics_reset();
+}
+
+ZTEST_SUITE(astarte_device_sdk_metrics, NULL, NULL, metrics_test_before, NULL, NULL); // NOLINT
+
+ZTEST(astarte_device_sdk_metrics, test_metrics_counters)
+{
+    ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_RETRANSMISSIONS);
+    ASTARTE_METRICS_ADD(ASTARTE_METRICS_COUNTER_DROPS, 3);
+    ASTARTE_METRICS_INC(ASTARTE_METRICS_COUNTER_PUBLISH_QOS0 + 2);
+
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_RETRANSMISSIONS), 1);
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_DROPS), 3);
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_PUBLISH_QOS2), 1);
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_COUNT), 0);
+    zassert_str_equal(astarte_metrics_counter_to_name(ASTARTE_METRICS_COUNTER_DROPS), "DROPS");
+    zassert_str_equal(astarte_metrics_counter_to_name(ASTARTE_METRICS_COUNTER_COUNT), "UNKNOWN");
+
+    astarte_metrics_reset();
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_DROPS), 0);
+}
+
+ZTEST(astarte_device_sdk_metrics, test_metrics_histogram)
+{
+    const uint32_t samples[] = { 0, 1, 3, 1000, UINT32_MAX };
+    for (size_t i = 0; i < ARRAY_SIZE(samples); i++) {
+        astarte_metrics_histogram_record(ASTARTE_METRICS_HISTOGRAM_BSON_DECODE, samples[i]);
+    }
+
+    astarte_metrics_histogram_data_t data = { 0 };
+    astarte_metrics_get_histogram(ASTARTE_METRICS_HISTOGRAM_BSON_DECODE, &data);
+    zassert_equal(data.count, ARRAY_SIZE(samples));
+    zassert_equal(data.max_us, UINT32_MAX);
+    zassert_equal(data.buckets[0], 1);
+    zassert_equal(data.buckets[1], 1);
+    zassert_equal(data.buckets[2], 1);
+    // 1000 us is in [512, 1024)
+    zassert_equal(data.buckets[10], 1);
+    zassert_equal(data.buckets[ASTARTE_METRICS_HISTOGRAM_BUCKETS - 1], 1);
+
+    // Timed sections are recorded in the selected histogram
+    ASTARTE_METRICS_TIMER_START(timer);
+    k_busy_wait(100);
+    ASTARTE_METRICS_TIMER_PAUSE(timer);
+    k_busy_wait(5000);
+    ASTARTE_METRICS_TIMER_RESUME(timer);
+    ASTARTE_METRICS_TIMER_RECORD(ASTARTE_METRICS_HISTOGRAM_KV_STORAGE, timer);
+    astarte_metrics_get_histogram(ASTARTE_METRICS_HISTOGRAM_KV_STORAGE, &data);
+    zassert_equal(data.count, 1);
+    zassert_true(data.max_us >= 100);
+    zassert_true(data.max_us < 5000, "The paused section has been measured: %u", data.max_us);
+}
+
+ZTEST(astarte_device_sdk_metrics, test_metrics_interfaces)
+{
+    ASTARTE_METRICS_INTERFACE_SENT("org.astarteplatform.zephyr.test.First", 10);
+    ASTARTE_METRICS_INTERFACE_SENT("org.astarteplatform.zephyr.test.First", 20);
+    ASTARTE_METRICS_INTERFACE_RECEIVED("org.astarteplatform.zephyr.test.Second", 5);
+    // Exceeds CONFIG_ASTARTE_DEVICE_SDK_METRICS_MAX_INTERFACES
+    ASTARTE_METRICS_INTERFACE_SENT("org.astarteplatform.zephyr.test.Third", 100);
+
+    astarte_metrics_interface_t interfaces[3] = { 0 };
+    size_t tracked = astarte_metrics_get_interfaces(interfaces, ARRAY_SIZE(interfaces));
+    zassert_equal(tracked, 2);
+    zassert_str_equal(interfaces[0].name, "org.astarteplatform.zephyr.test.First");
+    zassert_equal(interfaces[0].messages_sent, 2);
+    zassert_equal(interfaces[0].bytes_sent, 30);
+    zassert_equal(interfaces[0].messages_received, 0);
+    zassert_str_equal(interfaces[1].name, "org.astarteplatform.zephyr.test.Second");
+    zassert_equal(interfaces[1].messages_received, 1);
+    zassert_equal(interfaces[1].bytes_received, 5);
+
+    // Global counters account for all the interfaces
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_MESSAGES_SENT), 3);
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_BYTES_SENT), 130);
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_MESSAGES_RECEIVED), 1);
+
+    // Reset keeps the tracked interfaces
+    astarte_metrics_reset();
+    tracked = astarte_metrics_get_interfaces(interfaces, ARRAY_SIZE(interfaces));
+    zassert_equal(tracked, 2);
+    zassert_equal(interfaces[0].messages_sent, 0);
+}
+
+ZTEST(astarte_device_sdk_metrics, test_metrics_in_flight)
+{
+    int32_t in_flight = astarte_metrics_get_gauge(ASTARTE_METRICS_GAUGE_IN_FLIGHT);
+    mqtt_caching_message_t message = {
+        .type = MQTT_CACHING_PUBREC_ENTRY,
+        .topic = NULL,
+        .payload = NULL,
+        .qos = 2,
+    };
+
+    mqtt_caching_insert_message(&in_flight_map, 1, message);
+    mqtt_caching_insert_message(&in_flight_map, 2, message);
+    mqtt_caching_insert_message(&in_flight_map, 3, message);
+    zassert_equal(astarte_metrics_get_gauge(ASTARTE_METRICS_GAUGE_IN_FLIGHT), in_flight + 3);
+
+    mqtt_caching_remove_message(&in_flight_map, 2);
+    zassert_equal(astarte_metrics_get_gauge(ASTARTE_METRICS_GAUGE_IN_FLIGHT), in_flight + 2);
+
+    // Gauges are not affected by a reset
+    astarte_metrics_reset();
+    zassert_equal(astarte_metrics_get_gauge(ASTARTE_METRICS_GAUGE_IN_FLIGHT), in_flight + 2);
+
+    mqtt_caching_clear_messages(&in_flight_map);
+    zassert_equal(astarte_metrics_get_gauge(ASTARTE_METRICS_GAUGE_IN_FLIGHT), in_flight);
+}
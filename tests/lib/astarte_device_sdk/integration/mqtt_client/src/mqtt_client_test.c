@@ -0,0 +1,448 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/result.h"
+
+#include "mqtt.h"
+#include "mqtt_caching.h"
+#include "test_broker.h"
+
+LOG_MODULE_REGISTER(mqtt_client_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+#define MAX_MSG_SIZE CONFIG_ASTARTE_DEVICE_SDK_MQTT_MAX_MSG_SIZE
+#define MAX_CHUNKS 8
+#define POLL_TIMEOUT K_SECONDS(10)
+#define TEST_TOPIC "test/device_id/org.astarteplatform.test.ServerDatastream/sensor"
+#define MAX_SUBACKS 8
+// Topic filters of this length fill the TX buffer two at a time, the SUBSCRIBE packet has 7 bytes
+// of headers and each filter has a length prefix and a QoS byte
+#define SPLIT_TOPIC_LEN (((ASTARTE_MQTT_TX_BUFFER_SIZE - 7) / 2) - 3)
+#define SPLIT_TOPICS 5
+
+static astarte_mqtt_t astarte_mqtt;
+static uint8_t tx_payload[TEST_BROKER_MAX_PUBLISH_LEN];
+
+static struct
+{
+    bool connected;
+    size_t messages;
+    size_t message_len;
+    bool message_valid;
+    size_t chunks;
+    size_t chunk_offsets[MAX_CHUNKS];
+    size_t chunk_lens[MAX_CHUNKS];
+    size_t chunks_total_len;
+    bool chunks_valid;
+    size_t subacks;
+    uint16_t suback_message_ids[MAX_SUBACKS];
+    size_t suback_topic_indexes[MAX_SUBACKS];
+    enum mqtt_suback_return_code suback_return_codes[MAX_SUBACKS];
+} rx;
+
+static uint8_t pattern_byte(size_t index)
+{
+    return (uint8_t) ((index * 7U) + 1U);
+}
+
+static bool check_pattern(const char *data, size_t offset, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if ((uint8_t) data[i] != pattern_byte(offset + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static astarte_result_t refresh_client_cert_cbk(astarte_mqtt_t *astarte_mqtt, bool tls_rejected)
+{
+    (void) astarte_mqtt;
+    (void) tls_rejected;
+    return ASTARTE_RESULT_OK;
+}
+
+static void on_connected_cbk(astarte_mqtt_t *astarte_mqtt, struct mqtt_connack_param connack_param)
+{
+    (void) astarte_mqtt;
+    (void) connack_param;
+    rx.connected = true;
+}
+
+static void on_disconnected_cbk(astarte_mqtt_t *astarte_mqtt)
+{
+    (void) astarte_mqtt;
+    rx.connected = false;
+}
+
+static void on_incoming_cbk(astarte_mqtt_t *astarte_mqtt, const char *topic, size_t topic_len,
+    const char *data, size_t data_len)
+{
+    (void) astarte_mqtt;
+    rx.messages++;
+    rx.message_len = data_len;
+    rx.message_valid = (strcmp(topic, TEST_TOPIC) == 0) && (topic_len == strlen(TEST_TOPIC))
+        && check_pattern(data, 0, data_len);
+}
+
+static void on_incoming_chunk_cbk(astarte_mqtt_t *astarte_mqtt, const char *topic,
+    size_t topic_len, size_t offset, const char *chunk, size_t chunk_len, size_t total_len)
+{
+    (void) astarte_mqtt;
+    (void) topic_len;
+    if (rx.chunks < MAX_CHUNKS) {
+        rx.chunk_offsets[rx.chunks] = offset;
+        rx.chunk_lens[rx.chunks] = chunk_len;
+    }
+    rx.chunks++;
+    rx.chunks_total_len = total_len;
+    rx.chunks_valid = rx.chunks_valid && (strcmp(topic, TEST_TOPIC) == 0)
+        && check_pattern(chunk, offset, chunk_len);
+}
+
+static void on_subscribed_cbk(astarte_mqtt_t *astarte_mqtt, uint16_t message_id,
+    size_t topic_index, enum mqtt_suback_return_code return_code)
+{
+    (void) astarte_mqtt;
+    if (rx.subacks < MAX_SUBACKS) {
+        rx.suback_message_ids[rx.subacks] = message_id;
+        rx.suback_topic_indexes[rx.subacks] = topic_index;
+        rx.suback_return_codes[rx.subacks] = return_code;
+    }
+    rx.subacks++;
+}
+
+static bool poll_until_subscribed(size_t subacks)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(POLL_TIMEOUT);
+    while (rx.subacks < subacks) {
+        if (sys_timepoint_expired(timepoint)
+            || (astarte_mqtt_poll(&astarte_mqtt) != ASTARTE_RESULT_OK)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool poll_until_received(size_t messages, size_t chunks)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(POLL_TIMEOUT);
+    while ((rx.messages < messages) || (rx.chunks < chunks)) {
+        if (sys_timepoint_expired(timepoint)
+            || (astarte_mqtt_poll(&astarte_mqtt) != ASTARTE_RESULT_OK)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool poll_until_broker_received(enum test_broker_packet_type type, size_t count)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(POLL_TIMEOUT);
+    while (test_broker_count(type) < count) {
+        if (sys_timepoint_expired(timepoint)
+            || (astarte_mqtt_poll(&astarte_mqtt) != ASTARTE_RESULT_OK)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool poll_until_connection(bool connected)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(POLL_TIMEOUT);
+    while (rx.connected != connected) {
+        if (sys_timepoint_expired(timepoint)
+            || (astarte_mqtt_poll(&astarte_mqtt) != ASTARTE_RESULT_OK)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void receive_message(size_t len)
+{
+    size_t messages = rx.messages;
+    zassert_ok(test_broker_publish(TEST_TOPIC, tx_payload, len, 1));
+    zassert_true(poll_until_received(messages + 1, 0), "Message of %zu bytes not received", len);
+    zassert_equal(rx.message_len, len);
+    zassert_true(rx.message_valid, "Corrupted message of %zu bytes", len);
+}
+
+static void *mqtt_client_test_setup(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(tx_payload); i++) {
+        tx_payload[i] = pattern_byte(i);
+    }
+    zassert_ok(test_broker_start());
+    zassert_ok(test_broker_add_client_credentials());
+
+    astarte_mqtt_config_t cfg = {
+        .clean_session = true,
+        .connection_timeout_ms = 5000,
+        .poll_timeout_ms = 100,
+        .broker_hostname = TEST_BROKER_HOSTNAME,
+        .broker_port = TEST_BROKER_PORT,
+        .client_id = "test/device_id",
+        .refresh_client_cert_cbk = refresh_client_cert_cbk,
+        .on_connected_cbk = on_connected_cbk,
+        .on_disconnected_cbk = on_disconnected_cbk,
+        .on_incoming_cbk = on_incoming_cbk,
+        .on_incoming_chunk_cbk = on_incoming_chunk_cbk,
+        .on_subscribed_cbk = on_subscribed_cbk,
+    };
+    zassert_equal(astarte_mqtt_init(&cfg, &astarte_mqtt), ASTARTE_RESULT_OK);
+    zassert_equal(astarte_mqtt_connect(&astarte_mqtt), ASTARTE_RESULT_OK);
+    zassert_true(poll_until_connection(true), "Connection timed out");
+    return NULL;
+}
+
+static void mqtt_client_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    bool connected = rx.connected;
+    memset(&rx, 0, sizeof(rx));
+    rx.connected = connected;
+    rx.chunks_valid = true;
+    test_broker_reset();
+}
+
+static void mqtt_client_test_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    test_broker_hold_acks(false);
+}
+
+static void mqtt_client_test_teardown(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    (void) astarte_mqtt_disconnect(&astarte_mqtt);
+    (void) poll_until_connection(false);
+    astarte_mqtt_destroy(&astarte_mqtt);
+    zassert_equal(test_broker_stop(), 0, "Loopback broker failures");
+}
+
+ZTEST_SUITE(astarte_device_sdk_mqtt_client, NULL, mqtt_client_test_setup, mqtt_client_test_before,
+    mqtt_client_test_after, mqtt_client_test_teardown); // NOLINT
+
+ZTEST(astarte_device_sdk_mqtt_client, test_mqtt_client_rx_buffer_growth) // NOLINT
+{
+    astarte_mqtt_destroy(&astarte_mqtt);
+    zassert_is_null(astarte_mqtt.rx_payload_buffer);
+
+    // The buffer grows at least to twice its size, to the exact size of larger messages
+    receive_message(10);
+    zassert_equal(astarte_mqtt.rx_payload_buffer_size, 10);
+    receive_message(15);
+    zassert_equal(astarte_mqtt.rx_payload_buffer_size, 20);
+    receive_message(300);
+    zassert_equal(astarte_mqtt.rx_payload_buffer_size, 300);
+    receive_message(700);
+    zassert_equal(astarte_mqtt.rx_payload_buffer_size, 700);
+
+    // Smaller messages reuse the current buffer
+    uint8_t *buffer = astarte_mqtt.rx_payload_buffer;
+    receive_message(18);
+    receive_message(0);
+    zassert_equal(astarte_mqtt.rx_payload_buffer, buffer);
+    zassert_equal(astarte_mqtt.rx_payload_buffer_size, 700);
+
+    // The growth is capped to the maximum message size
+    receive_message(MAX_MSG_SIZE - 1);
+    zassert_equal(astarte_mqtt.rx_payload_buffer_size, MAX_MSG_SIZE);
+    receive_message(MAX_MSG_SIZE);
+    zassert_equal(astarte_mqtt.rx_payload_buffer_size, MAX_MSG_SIZE);
+    zassert_equal(rx.chunks, 0);
+}
+
+ZTEST(astarte_device_sdk_mqtt_client, test_mqtt_client_rx_chunks) // NOLINT
+{
+    const size_t len = (3 * MAX_MSG_SIZE) - 72;
+    zassert_ok(test_broker_publish(TEST_TOPIC, tx_payload, len, 1));
+    zassert_true(poll_until_received(0, 3));
+
+    // Large messages are delivered in order in chunks of the maximum message size
+    zassert_equal(rx.chunks, 3);
+    zassert_equal(rx.messages, 0);
+    zassert_true(rx.chunks_valid);
+    zassert_equal(rx.chunks_total_len, len);
+    zassert_equal(rx.chunk_offsets[0], 0);
+    zassert_equal(rx.chunk_lens[0], MAX_MSG_SIZE);
+    zassert_equal(rx.chunk_offsets[1], MAX_MSG_SIZE);
+    zassert_equal(rx.chunk_lens[1], MAX_MSG_SIZE);
+    zassert_equal(rx.chunk_offsets[2], 2 * MAX_MSG_SIZE);
+    zassert_equal(rx.chunk_lens[2], MAX_MSG_SIZE - 72);
+    zassert_equal(astarte_mqtt.rx_payload_buffer_size, MAX_MSG_SIZE);
+
+    // The reception of the following messages is not affected
+    receive_message(MAX_MSG_SIZE);
+    zassert_true(test_broker_wait(TEST_BROKER_PUBACK, 2, POLL_TIMEOUT));
+    zassert_equal(rx.chunks, 3);
+
+    // A chunked message of exactly a multiple of the maximum size has no empty trailing chunk
+    rx.chunks = 0;
+    zassert_ok(test_broker_publish(TEST_TOPIC, tx_payload, 2 * MAX_MSG_SIZE, 2));
+    zassert_true(poll_until_received(rx.messages, 2));
+    zassert_true(poll_until_broker_received(TEST_BROKER_PUBCOMP, 1));
+    zassert_equal(rx.chunks, 2);
+    zassert_equal(rx.chunk_lens[1], MAX_MSG_SIZE);
+    zassert_true(rx.chunks_valid);
+}
+
+ZTEST(astarte_device_sdk_mqtt_client, test_mqtt_client_socket) // NOLINT
+{
+    // The socket of an open connection becomes readable when the broker sends data
+    int sock = astarte_mqtt_get_socket(&astarte_mqtt);
+    zassert_true(sock >= 0);
+    struct zsock_pollfd socket_fd = { .fd = sock, .events = ZSOCK_POLLIN };
+    zassert_equal(zsock_poll(&socket_fd, 1, 0), 0);
+    zassert_ok(test_broker_publish(TEST_TOPIC, tx_payload, 10, 0));
+    zassert_equal(zsock_poll(&socket_fd, 1, 10 * MSEC_PER_SEC), 1);
+    zassert_true(socket_fd.revents & ZSOCK_POLLIN);
+    zassert_true(poll_until_received(1, 0));
+
+    // The deadline of an idle connection is the keep alive
+    k_timeout_t deadline = astarte_mqtt_get_next_deadline(&astarte_mqtt);
+    zassert_false(K_TIMEOUT_EQ(deadline, K_FOREVER));
+    zassert_true(k_ticks_to_ms_ceil32(deadline.ticks) <= CONFIG_MQTT_KEEPALIVE * MSEC_PER_SEC);
+
+    // A closed connection has no socket and no deadline
+    zassert_equal(astarte_mqtt_disconnect(&astarte_mqtt), ASTARTE_RESULT_OK);
+    zassert_true(poll_until_connection(false));
+    zassert_equal(astarte_mqtt_get_socket(&astarte_mqtt), -1);
+    zassert_true(K_TIMEOUT_EQ(astarte_mqtt_get_next_deadline(&astarte_mqtt), K_FOREVER));
+
+    // A new connection opens a new socket
+    zassert_equal(astarte_mqtt_connect(&astarte_mqtt), ASTARTE_RESULT_OK);
+    zassert_true(astarte_mqtt_get_socket(&astarte_mqtt) >= 0);
+    zassert_true(poll_until_connection(true));
+    zassert_true(astarte_mqtt_get_socket(&astarte_mqtt) >= 0);
+}
+
+ZTEST(astarte_device_sdk_mqtt_client, test_mqtt_client_socket_reconnection) // NOLINT
+{
+    // The socket follows the connection state when the broker drops the connection
+    for (size_t i = 0; i < 3; i++) {
+        test_broker_drop_connection();
+        zassert_true(poll_until_connection(false));
+        zassert_equal(astarte_mqtt_get_socket(&astarte_mqtt), -1);
+        // The reconnection is performed by the poll once the backoff has elapsed
+        zassert_true(poll_until_connection(true));
+        zassert_true(astarte_mqtt_get_socket(&astarte_mqtt) >= 0);
+    }
+}
+
+ZTEST(astarte_device_sdk_mqtt_client, test_mqtt_client_subscribe_multiple) // NOLINT
+{
+    const char *const topics[] = {
+        "test/device_id/org.astarteplatform.test.ServerDatastream/#",
+        "test/device_id/org.astarteplatform.test.Rejected/#",
+        "test/device_id/org.astarteplatform.test.ServerProperty/#",
+    };
+    test_broker_reject_subscriptions("Rejected");
+
+    // All the filters fit in a single packet
+    uint16_t message_id = 0U;
+    zassert_equal(astarte_mqtt_subscribe_multiple(
+                      &astarte_mqtt, topics, ARRAY_SIZE(topics), 1, &message_id),
+        ARRAY_SIZE(topics));
+    zassert_not_equal(message_id, 0U);
+    zassert_true(poll_until_subscribed(ARRAY_SIZE(topics)));
+
+    test_broker_packet_t packet = { 0 };
+    zassert_equal(test_broker_count(TEST_BROKER_SUBSCRIBE), 1);
+    zassert_true(test_broker_get(TEST_BROKER_SUBSCRIBE, 0, &packet));
+    zassert_equal(packet.message_id, message_id);
+    zassert_equal(packet.topics_count, ARRAY_SIZE(topics));
+    zassert_str_equal(packet.topic, topics[0]);
+
+    // One callback for each return code of the SUBACK, in the order of the filters
+    const enum mqtt_suback_return_code expected_codes[] = {
+        MQTT_SUBACK_SUCCESS_QoS_1,
+        MQTT_SUBACK_FAILURE,
+        MQTT_SUBACK_SUCCESS_QoS_1,
+    };
+    zassert_equal(rx.subacks, ARRAY_SIZE(topics));
+    for (size_t i = 0; i < ARRAY_SIZE(topics); i++) {
+        zassert_equal(rx.suback_message_ids[i], message_id);
+        zassert_equal(rx.suback_topic_indexes[i], i);
+        zassert_equal(rx.suback_return_codes[i], expected_codes[i], "Filter %zu", i);
+    }
+    zassert_false(mqtt_caching_find_message(&astarte_mqtt.out_msg_map, message_id));
+}
+
+ZTEST(astarte_device_sdk_mqtt_client, test_mqtt_client_subscribe_split) // NOLINT
+{
+    static char topic_buffers[SPLIT_TOPICS][SPLIT_TOPIC_LEN + 1];
+    const char *topics[SPLIT_TOPICS] = { 0 };
+    for (size_t i = 0; i < SPLIT_TOPICS; i++) {
+        memset(topic_buffers[i], 'a', SPLIT_TOPIC_LEN);
+        topic_buffers[i][SPLIT_TOPIC_LEN - 1] = (char) ('0' + i);
+        topics[i] = topic_buffers[i];
+    }
+
+    // Each packet carries the leading filters fitting in the TX buffer
+    size_t expected_counts[] = { 2, 2, 1 };
+    size_t topic_idx = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(expected_counts); i++) {
+        uint16_t message_id = 0U;
+        size_t sent = astarte_mqtt_subscribe_multiple(
+            &astarte_mqtt, &topics[topic_idx], SPLIT_TOPICS - topic_idx, 0, &message_id);
+        zassert_equal(sent, expected_counts[i], "Packet %zu", i);
+        zassert_true(poll_until_subscribed(topic_idx + sent));
+
+        test_broker_packet_t packet = { 0 };
+        zassert_true(test_broker_get(TEST_BROKER_SUBSCRIBE, i, &packet));
+        zassert_equal(packet.message_id, message_id);
+        zassert_equal(packet.topics_count, sent);
+        zassert_true(packet.packet_len <= ASTARTE_MQTT_TX_BUFFER_SIZE);
+        zassert_mem_equal(
+            packet.topic, topics[topic_idx], MIN(SPLIT_TOPIC_LEN, TEST_BROKER_MAX_TOPIC_LEN));
+        topic_idx += sent;
+    }
+    zassert_equal(topic_idx, SPLIT_TOPICS);
+    zassert_equal(rx.subacks, SPLIT_TOPICS);
+}
+
+ZTEST(astarte_device_sdk_mqtt_client, test_mqtt_client_subscribe_retransmission) // NOLINT
+{
+    const char *const topics[] = {
+        "test/device_id/org.astarteplatform.test.ServerDatastream/#",
+        "test/device_id/org.astarteplatform.test.ServerAggregate/#",
+        "test/device_id/org.astarteplatform.test.ServerProperty/#",
+    };
+    test_broker_hold_acks(true);
+
+    uint16_t message_id = 0U;
+    zassert_equal(astarte_mqtt_subscribe_multiple(
+                      &astarte_mqtt, topics, ARRAY_SIZE(topics), 2, &message_id),
+        ARRAY_SIZE(topics));
+    zassert_true(mqtt_caching_find_message(&astarte_mqtt.out_msg_map, message_id));
+
+    // The unacknowledged SUBSCRIBE is retransmitted from the cache with all its filters
+    k_timepoint_t timepoint = sys_timepoint_calc(K_SECONDS(2 * CONFIG_MQTT_KEEPALIVE));
+    while (test_broker_count(TEST_BROKER_SUBSCRIBE) < 2) {
+        zassert_false(sys_timepoint_expired(timepoint), "SUBSCRIBE not retransmitted");
+        zassert_equal(astarte_mqtt_poll(&astarte_mqtt), ASTARTE_RESULT_OK);
+    }
+    test_broker_packet_t packet = { 0 };
+    zassert_true(test_broker_get(TEST_BROKER_SUBSCRIBE, 1, &packet));
+    zassert_equal(packet.message_id, message_id);
+    zassert_equal(packet.topics_count, ARRAY_SIZE(topics));
+    zassert_str_equal(packet.topic, topics[0]);
+
+    test_broker_hold_acks(false);
+    zassert_true(poll_until_subscribed(ARRAY_SIZE(topics)));
+    zassert_equal(rx.suback_topic_indexes[ARRAY_SIZE(topics) - 1], ARRAY_SIZE(topics) - 1);
+    zassert_false(mqtt_caching_find_message(&astarte_mqtt.out_msg_map, message_id));
+}
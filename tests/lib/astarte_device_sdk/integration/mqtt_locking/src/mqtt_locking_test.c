@@ -0,0 +1,215 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/result.h"
+
+#include "host_clock.h"
+#include "mqtt.h"
+#include "test_broker.h"
+
+LOG_MODULE_REGISTER(mqtt_locking_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+#define SENDER_THREADS 4
+#define SENDS_PER_THREAD 32
+#define THREAD_STACK_SIZE 4096
+#define THREAD_PRIORITY 5
+#define CONNECTION_TIMEOUT K_SECONDS(10)
+#define RX_PAYLOAD_SIZE 64
+// Duration of a slow reception callback, during which the RX mutex is locked
+#define SLOW_RX_CALLBACK_MS 20
+#define TX_TOPIC "test/device_id/org.astarteplatform.test.DeviceDatastream/sensor"
+#define RX_TOPIC "test/device_id/org.astarteplatform.test.ServerDatastream/sensor"
+
+K_THREAD_STACK_ARRAY_DEFINE(sender_stacks, SENDER_THREADS, THREAD_STACK_SIZE);
+K_THREAD_STACK_DEFINE(receiver_stack, THREAD_STACK_SIZE);
+
+static struct k_thread sender_threads[SENDER_THREADS];
+static struct k_thread receiver_thread;
+
+static astarte_mqtt_t astarte_mqtt;
+static uint32_t latencies_us[SENDER_THREADS * SENDS_PER_THREAD];
+static atomic_t senders_done;
+static atomic_t connected;
+static atomic_t received;
+static atomic_t receiving;
+static atomic_t poll_failures;
+
+static astarte_result_t refresh_client_cert_cbk(astarte_mqtt_t *astarte_mqtt, bool tls_rejected)
+{
+    (void) astarte_mqtt;
+    (void) tls_rejected;
+    return ASTARTE_RESULT_OK;
+}
+
+static void on_connected_cbk(astarte_mqtt_t *astarte_mqtt, struct mqtt_connack_param connack_param)
+{
+    (void) astarte_mqtt;
+    (void) connack_param;
+    atomic_set(&connected, 1);
+}
+
+static void on_disconnected_cbk(astarte_mqtt_t *astarte_mqtt)
+{
+    (void) astarte_mqtt;
+    atomic_clear(&connected);
+}
+
+static void on_incoming_cbk(astarte_mqtt_t *astarte_mqtt, const char *topic, size_t topic_len,
+    const char *data, size_t data_len)
+{
+    (void) astarte_mqtt;
+    (void) topic;
+    (void) topic_len;
+    (void) data;
+    (void) data_len;
+
+    // Simulate a slow (blocking) user callback, these run with the RX mutex locked
+    atomic_set(&receiving, 1);
+    k_sleep(K_MSEC(SLOW_RX_CALLBACK_MS));
+    atomic_clear(&receiving);
+    atomic_inc(&received);
+}
+
+static void sender_entry(void *p1, void *p2, void *p3)
+{
+    uint32_t *thread_latencies = p1;
+    (void) p2;
+    (void) p3;
+
+    uint8_t payload[32] = { 0 };
+    for (size_t i = 0; i < SENDS_PER_THREAD; i++) {
+        // Send while the receiver is in the middle of a reception callback
+        k_timepoint_t timepoint = sys_timepoint_calc(K_MSEC(10 * SLOW_RX_CALLBACK_MS));
+        while (!atomic_get(&receiving) && !sys_timepoint_expired(timepoint)) {
+            k_sleep(K_MSEC(1));
+        }
+        uint64_t start = astarte_host_clock_get_us();
+        astarte_mqtt_publish(&astarte_mqtt, TX_TOPIC, payload, sizeof(payload), 1, NULL);
+        thread_latencies[i] = (uint32_t) (astarte_host_clock_get_us() - start);
+    }
+    atomic_inc(&senders_done);
+}
+
+static void receiver_entry(void *p1, void *p2, void *p3)
+{
+    (void) p1;
+    (void) p2;
+    (void) p3;
+
+    // Process the incoming messages and the acknowledgments of the published ones, failures are
+    // checked by the test thread
+    while (atomic_get(&senders_done) < SENDER_THREADS) {
+        if (astarte_mqtt_poll(&astarte_mqtt) != ASTARTE_RESULT_OK) {
+            atomic_inc(&poll_failures);
+        }
+    }
+}
+
+static int compare_latencies(const void *a, const void *b)
+{
+    uint32_t latency_a = *(const uint32_t *) a;
+    uint32_t latency_b = *(const uint32_t *) b;
+    return (latency_a > latency_b) - (latency_a < latency_b);
+}
+
+static uint32_t get_percentile(const uint32_t *sorted, size_t len, size_t percentile)
+{
+    return sorted[MIN((len * percentile) / 100, len - 1)];
+}
+
+static void *mqtt_locking_setup(void)
+{
+    zassert_ok(test_broker_start());
+    zassert_ok(test_broker_add_client_credentials());
+
+    astarte_mqtt_config_t cfg = {
+        .clean_session = true,
+        .connection_timeout_ms = 5000,
+        .poll_timeout_ms = 10,
+        .broker_hostname = TEST_BROKER_HOSTNAME,
+        .broker_port = TEST_BROKER_PORT,
+        .client_id = "test/device_id",
+        .refresh_client_cert_cbk = refresh_client_cert_cbk,
+        .on_connected_cbk = on_connected_cbk,
+        .on_disconnected_cbk = on_disconnected_cbk,
+        .on_incoming_cbk = on_incoming_cbk,
+    };
+    zassert_equal(astarte_mqtt_init(&cfg, &astarte_mqtt), ASTARTE_RESULT_OK);
+    zassert_equal(astarte_mqtt_connect(&astarte_mqtt), ASTARTE_RESULT_OK);
+    k_timepoint_t timepoint = sys_timepoint_calc(CONNECTION_TIMEOUT);
+    while (!atomic_get(&connected)) {
+        zassert_false(sys_timepoint_expired(timepoint), "Connection timed out");
+        zassert_equal(astarte_mqtt_poll(&astarte_mqtt), ASTARTE_RESULT_OK);
+    }
+    return NULL;
+}
+
+static void mqtt_locking_teardown(void *fixture)
+{
+    (void) fixture;
+    (void) astarte_mqtt_disconnect(&astarte_mqtt);
+    k_timepoint_t timepoint = sys_timepoint_calc(CONNECTION_TIMEOUT);
+    while (atomic_get(&connected) && !sys_timepoint_expired(timepoint)) {
+        (void) astarte_mqtt_poll(&astarte_mqtt);
+    }
+    astarte_mqtt_destroy(&astarte_mqtt);
+    zassert_equal(test_broker_stop(), 0, "Loopback broker failures");
+}
+
+ZTEST_SUITE(astarte_device_sdk_mqtt_locking, NULL, mqtt_locking_setup, NULL, NULL,
+    mqtt_locking_teardown); // NOLINT
+
+ZTEST(astarte_device_sdk_mqtt_locking, test_mqtt_locking_send_latency_under_rx_load) // NOLINT
+{
+    atomic_set(&senders_done, 0);
+    atomic_set(&received, 0);
+    atomic_set(&poll_failures, 0);
+
+    k_thread_create(&receiver_thread, receiver_stack, K_THREAD_STACK_SIZEOF(receiver_stack),
+        receiver_entry, NULL, NULL, NULL, THREAD_PRIORITY, 0, K_NO_WAIT);
+    for (size_t i = 0; i < SENDER_THREADS; i++) {
+        k_thread_create(&sender_threads[i], sender_stacks[i],
+            K_THREAD_STACK_SIZEOF(sender_stacks[i]), sender_entry,
+            &latencies_us[i * SENDS_PER_THREAD], NULL, NULL, THREAD_PRIORITY, 0, K_NO_WAIT);
+    }
+
+    // The broker keeps the receiver busy until all the senders are done
+    uint8_t payload[RX_PAYLOAD_SIZE] = { 0 };
+    while (atomic_get(&senders_done) < SENDER_THREADS) {
+        zassert_ok(test_broker_publish(RX_TOPIC, payload, sizeof(payload), 1));
+        k_sleep(K_MSEC(SLOW_RX_CALLBACK_MS));
+    }
+
+    for (size_t i = 0; i < SENDER_THREADS; i++) {
+        zassert_ok(k_thread_join(&sender_threads[i], K_FOREVER));
+    }
+    zassert_ok(k_thread_join(&receiver_thread, K_FOREVER));
+    zassert_equal(atomic_get(&poll_failures), 0);
+
+    // All the messages have been sent over the connection while receiving
+    zassert_true(test_broker_wait_published(TX_TOPIC, ARRAY_SIZE(latencies_us), K_SECONDS(10)));
+    zassert_true(atomic_get(&received) > 0, "No message received during the test");
+
+    size_t len = ARRAY_SIZE(latencies_us);
+    qsort(latencies_us, len, sizeof(uint32_t), compare_latencies);
+    uint32_t p50 = get_percentile(latencies_us, len, 50);
+    uint32_t p90 = get_percentile(latencies_us, len, 90);
+    uint32_t p99 = get_percentile(latencies_us, len, 99);
+    LOG_INF("Send latency with %d senders under RX load: p50 %u us, p90 %u us, p99 %u us, max "
+            "%u us, %ld messages received",
+        SENDER_THREADS, p50, p90, p99, latencies_us[len - 1], atomic_get(&received)); // NOLINT
+
+    // Senders should never wait for a reception callback to complete
+    zassert_true(p99 < (SLOW_RX_CALLBACK_MS * USEC_PER_MSEC),
+        "Send latency p99 %u us is not lower than the RX callback duration", p99);
+}
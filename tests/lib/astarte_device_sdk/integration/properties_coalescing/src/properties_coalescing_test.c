@@ -0,0 +1,392 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/data.h"
+#include "astarte_device_sdk/device.h"
+#include "astarte_device_sdk/result.h"
+
+#include "astarte_zlib.h"
+#include "bson_serializer.h"
+#include "device_caching.h"
+#include "device_private.h"
+#include "generated_interfaces.h"
+#include "test_broker.h"
+#include "test_device.h"
+#include "test_pairing.h"
+
+LOG_MODULE_REGISTER(properties_coalescing_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+#define CONNECTION_TIMEOUT K_SECONDS(10)
+// Time given to the device to make progress when checking that it is blocked
+#define SETTLE_TIME K_MSEC(500)
+
+#define MAX_ENTRIES CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_MAX_ENTRIES
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_QUIET_PERIOD)
+#define QUIET_PERIOD_MS CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_QUIET_PERIOD_MS
+#define MAX_DELAY_MS CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_MAX_DELAY_MS
+#else
+// The tests relying on the quiet period are skipped
+#define QUIET_PERIOD_MS 0
+#define MAX_DELAY_MS 0
+#endif
+
+BUILD_ASSERT(MAX_ENTRIES == 3, "The tests change one property more than the buffer fits");
+
+#define SERVER_PROPERTY (&org_astarteplatform_zephyr_examples_ServerProperty)
+#define SENSOR_PATH(sensor) "/sensor" #sensor "/integer_endpoint"
+
+static astarte_device_handle_t device;
+static atomic_t changes;
+
+static void property_set_cbk(astarte_device_property_set_event_t event)
+{
+    ARG_UNUSED(event);
+    atomic_inc(&changes);
+}
+
+static void property_unset_cbk(astarte_device_data_event_t event)
+{
+    ARG_UNUSED(event);
+    atomic_inc(&changes);
+}
+
+static void property_loader_cbk(astarte_device_property_loader_event_t event)
+{
+    zassert_equal(astarte_data_to_integer(event.data, (int32_t *) event.user_data),
+        ASTARTE_RESULT_OK);
+}
+
+static bool is_handshake_ending(astarte_device_handle_t device)
+{
+    return device->connection_state == DEVICE_END_HANDSHAKE;
+}
+
+static bool is_connected(astarte_device_handle_t device)
+{
+    return device->connection_state == DEVICE_CONNECTED;
+}
+
+static bool is_synchronized(astarte_device_handle_t device)
+{
+    return is_connected(device) && device->synchronization_completed;
+}
+
+static bool is_committed(astarte_device_handle_t device)
+{
+    return device->prop_pending_count == 0;
+}
+
+static void publish_property(const char *path, const int32_t *value)
+{
+    char topic[128] = { 0 };
+    int ret = snprintf(topic, sizeof(topic), "%s/%s/%s%s", CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME,
+        TEST_DEVICE_ID, SERVER_PROPERTY->name, path);
+    zassert_true((ret > 0) && ((size_t) ret < sizeof(topic)));
+
+    // An empty payload unsets the property
+    if (!value) {
+        zassert_ok(test_broker_publish(topic, NULL, 0, 1));
+        return;
+    }
+
+    astarte_bson_serializer_t bson = { 0 };
+    zassert_equal(astarte_bson_serializer_init(&bson), ASTARTE_RESULT_OK);
+    astarte_bson_serializer_append_int32(&bson, "v", *value);
+    astarte_bson_serializer_append_end_of_document(&bson);
+    int bson_size = 0;
+    const void *bson_buf = astarte_bson_serializer_get_serialized(bson, &bson_size);
+    zassert_ok(test_broker_publish(topic, bson_buf, bson_size, 1));
+    astarte_bson_serializer_destroy(&bson);
+}
+
+static void set_property(const char *path, int32_t value)
+{
+    publish_property(path, &value);
+}
+
+static void unset_property(const char *path)
+{
+    publish_property(path, NULL);
+}
+
+static void wait_changes(atomic_val_t count)
+{
+    k_timepoint_t timepoint = sys_timepoint_calc(CONNECTION_TIMEOUT);
+    while (atomic_get(&changes) < count) {
+        zassert_false(sys_timepoint_expired(timepoint), "Received %ld of %ld changes",
+            atomic_get(&changes), count);
+        zassert_true(test_device_poll_for(device, K_MSEC(1)));
+    }
+}
+
+static void store_property(const char *path, int32_t value)
+{
+    zassert_equal(astarte_device_caching_property_store(SERVER_PROPERTY->name, path,
+                      SERVER_PROPERTY->major_version, astarte_data_from_integer(value)),
+        ASTARTE_RESULT_OK);
+}
+
+static void assert_stored_property(const char *path, int32_t expected)
+{
+    uint32_t major = 0U;
+    astarte_data_t data = { 0 };
+    int32_t value = 0;
+    astarte_result_t ares
+        = astarte_device_caching_property_load(SERVER_PROPERTY->name, path, &major, &data);
+    zassert_equal(ares, ASTARTE_RESULT_OK, "Property %s: %s", path, astarte_result_to_name(ares));
+    zassert_equal(astarte_data_to_integer(data, &value), ASTARTE_RESULT_OK);
+    astarte_device_caching_property_destroy_loaded(data);
+    zassert_equal(value, expected, "Property %s stored as %d", path, value);
+}
+
+static void assert_missing_property(const char *path)
+{
+    uint32_t major = 0U;
+    astarte_data_t data = { 0 };
+    astarte_result_t ares
+        = astarte_device_caching_property_load(SERVER_PROPERTY->name, path, &major, &data);
+    if (ares == ASTARTE_RESULT_OK) {
+        astarte_device_caching_property_destroy_loaded(data);
+    }
+    zassert_equal(ares, ASTARTE_RESULT_NOT_FOUND, "Property %s: %s", path,
+        astarte_result_to_name(ares));
+}
+
+static void connect_device(void)
+{
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_synchronized, CONNECTION_TIMEOUT));
+    zassert_equal(device->prop_pending_count, 0);
+}
+
+static void *properties_coalescing_test_setup(void)
+{
+    zassert_ok(test_broker_start());
+    zassert_ok(test_pairing_start());
+    return NULL;
+}
+
+static void properties_coalescing_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    test_broker_reset();
+    test_pairing_reset();
+    atomic_clear(&changes);
+    zassert_ok(test_device_clear_storage());
+
+    const astarte_interface_t *interfaces[] = { SERVER_PROPERTY };
+    astarte_device_config_t cfg = { 0 };
+    test_device_config_init(&cfg);
+    cfg.property_set_cbk = property_set_cbk;
+    cfg.property_unset_cbk = property_unset_cbk;
+    cfg.interfaces = interfaces;
+    cfg.interfaces_size = ARRAY_SIZE(interfaces);
+    zassert_equal(astarte_device_new(&cfg, &device), ASTARTE_RESULT_OK);
+}
+
+static void properties_coalescing_test_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    test_broker_hold_acks(false);
+    zassert_equal(astarte_device_destroy(device), ASTARTE_RESULT_OK);
+    device = NULL;
+}
+
+static void properties_coalescing_test_teardown(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_equal(test_pairing_stop(), 0, "Loopback pairing APIs failures");
+    zassert_equal(test_broker_stop(), 0, "Loopback broker failures");
+}
+
+ZTEST_SUITE(astarte_device_sdk_properties_coalescing, NULL, properties_coalescing_test_setup,
+    properties_coalescing_test_before, properties_coalescing_test_after,
+    properties_coalescing_test_teardown); // NOLINT
+
+ZTEST(astarte_device_sdk_properties_coalescing, test_properties_coalescing_last_writer) // NOLINT
+{
+    Z_TEST_SKIP_IFNDEF(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_QUIET_PERIOD);
+
+    store_property(SENSOR_PATH(2), 20);
+    store_property(SENSOR_PATH(3), 30);
+    connect_device();
+
+    // Only the last change of each property is kept: set -> set, set -> unset, unset -> set
+    set_property(SENSOR_PATH(1), 11);
+    set_property(SENSOR_PATH(1), 12);
+    set_property(SENSOR_PATH(2), 21);
+    unset_property(SENSOR_PATH(2));
+    unset_property(SENSOR_PATH(3));
+    set_property(SENSOR_PATH(3), 31);
+    wait_changes(6);
+    zassert_equal(device->prop_pending_count, 3);
+
+    // The user callbacks are called right away, the storage is written later
+    assert_missing_property(SENSOR_PATH(1));
+    assert_stored_property(SENSOR_PATH(2), 20);
+    assert_stored_property(SENSOR_PATH(3), 30);
+
+    zassert_true(test_device_poll_until(device, is_committed, CONNECTION_TIMEOUT));
+    assert_stored_property(SENSOR_PATH(1), 12);
+    assert_missing_property(SENSOR_PATH(2));
+    assert_stored_property(SENSOR_PATH(3), 31);
+}
+
+ZTEST(astarte_device_sdk_properties_coalescing, test_properties_coalescing_quiet_period) // NOLINT
+{
+    Z_TEST_SKIP_IFNDEF(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_QUIET_PERIOD);
+    connect_device();
+
+    set_property(SENSOR_PATH(1), 11);
+    wait_changes(1);
+    zassert_true(test_device_poll_for(device, K_MSEC(QUIET_PERIOD_MS / 2)));
+    zassert_equal(device->prop_pending_count, 1);
+
+    // A new change postpones the commit by a whole quiet period
+    int64_t last_change_ms = k_uptime_get();
+    set_property(SENSOR_PATH(1), 12);
+    wait_changes(2);
+    zassert_true(test_device_poll_for(device, K_MSEC(QUIET_PERIOD_MS / 2)));
+    zassert_equal(device->prop_pending_count, 1);
+    assert_missing_property(SENSOR_PATH(1));
+
+    zassert_true(test_device_poll_until(device, is_committed, K_MSEC(QUIET_PERIOD_MS)));
+    zassert_true(k_uptime_get() - last_change_ms >= QUIET_PERIOD_MS);
+    assert_stored_property(SENSOR_PATH(1), 12);
+}
+
+ZTEST(astarte_device_sdk_properties_coalescing, test_properties_coalescing_max_delay) // NOLINT
+{
+    Z_TEST_SKIP_IFNDEF(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_QUIET_PERIOD);
+    connect_device();
+
+    // Changes received more often than the quiet period are committed after the maximum delay
+    int64_t first_change_ms = k_uptime_get();
+    int32_t value = 0;
+    do {
+        zassert_true(k_uptime_get() - first_change_ms < 2 * MAX_DELAY_MS, "Never committed");
+        value++;
+        set_property(SENSOR_PATH(1), value);
+        wait_changes(value);
+        zassert_true(test_device_poll_for(device, K_MSEC(QUIET_PERIOD_MS / 2)));
+    } while (device->prop_pending_count != 0);
+    int64_t commit_delay_ms = k_uptime_get() - first_change_ms;
+    zassert_true(commit_delay_ms >= MAX_DELAY_MS, "Committed after %lld ms", commit_delay_ms);
+    zassert_true(commit_delay_ms < MAX_DELAY_MS + QUIET_PERIOD_MS, "Committed after %lld ms",
+        commit_delay_ms);
+    assert_stored_property(SENSOR_PATH(1), value);
+}
+
+ZTEST(astarte_device_sdk_properties_coalescing, test_properties_coalescing_max_entries) // NOLINT
+{
+    Z_TEST_SKIP_IFNDEF(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_QUIET_PERIOD);
+    connect_device();
+
+    // A change for a new property beyond the maximum entries writes the buffered ones
+    set_property(SENSOR_PATH(1), 11);
+    set_property(SENSOR_PATH(2), 21);
+    set_property(SENSOR_PATH(3), 31);
+    wait_changes(3);
+    zassert_equal(device->prop_pending_count, MAX_ENTRIES);
+    assert_missing_property(SENSOR_PATH(1));
+
+    set_property(SENSOR_PATH(4), 41);
+    wait_changes(4);
+    zassert_equal(device->prop_pending_count, 1);
+    assert_stored_property(SENSOR_PATH(1), 11);
+    assert_stored_property(SENSOR_PATH(2), 21);
+    assert_stored_property(SENSOR_PATH(3), 31);
+    assert_missing_property(SENSOR_PATH(4));
+}
+
+ZTEST(astarte_device_sdk_properties_coalescing, test_properties_coalescing_purge) // NOLINT
+{
+    Z_TEST_SKIP_IFNDEF(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_QUIET_PERIOD);
+    connect_device();
+
+    set_property(SENSOR_PATH(1), 11);
+    set_property(SENSOR_PATH(2), 21);
+    wait_changes(2);
+    zassert_equal(device->prop_pending_count, 2);
+
+    // The buffered changes are written before the purge, which then removes the second one
+    static const char allow_list[]
+        = "org.astarteplatform.zephyr.examples.ServerProperty" SENSOR_PATH(1);
+    uint8_t purge[sizeof(uint32_t) + 2 * sizeof(allow_list)] = { 0 };
+    uLongf compressed_len = sizeof(purge) - sizeof(uint32_t);
+    zassert_equal(astarte_zlib_compress(&purge[sizeof(uint32_t)], &compressed_len,
+                      (const Bytef *) allow_list, strlen(allow_list)),
+        Z_OK);
+    sys_put_be32(strlen(allow_list), purge);
+    zassert_ok(test_broker_publish(
+        CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "/" TEST_DEVICE_ID "/control/consumer/properties",
+        purge, sizeof(uint32_t) + compressed_len, 2));
+
+    // Well before the quiet period, only the purge can have written the changes
+    zassert_true(test_device_poll_until(device, is_committed, K_MSEC(QUIET_PERIOD_MS / 2)));
+    assert_stored_property(SENSOR_PATH(1), 11);
+    assert_missing_property(SENSOR_PATH(2));
+}
+
+ZTEST(astarte_device_sdk_properties_coalescing, test_properties_coalescing_get_property) // NOLINT
+{
+    Z_TEST_SKIP_IFNDEF(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_QUIET_PERIOD);
+    connect_device();
+
+    set_property(SENSOR_PATH(1), 11);
+    wait_changes(1);
+    zassert_equal(device->prop_pending_count, 1);
+
+    // Reading a property back writes the buffered changes first
+    int32_t value = 0;
+    zassert_equal(astarte_device_get_property(device, SERVER_PROPERTY->name, SENSOR_PATH(1),
+                      property_loader_cbk, &value),
+        ASTARTE_RESULT_OK);
+    zassert_equal(value, 11);
+    zassert_equal(device->prop_pending_count, 0);
+}
+
+ZTEST(astarte_device_sdk_properties_coalescing, test_properties_coalescing_handshake) // NOLINT
+{
+    Z_TEST_SKIP_IFNDEF(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_COALESCING_COMMIT_HANDSHAKE);
+
+    store_property(SENSOR_PATH(2), 20);
+    test_broker_hold_acks(true);
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_handshake_ending, CONNECTION_TIMEOUT));
+
+    // The changes received during the handshake are buffered until its end
+    set_property(SENSOR_PATH(1), 11);
+    set_property(SENSOR_PATH(1), 12);
+    unset_property(SENSOR_PATH(2));
+    wait_changes(3);
+    zassert_true(test_device_poll_for(device, SETTLE_TIME));
+    zassert_equal(device->prop_pending_count, 2);
+    assert_missing_property(SENSOR_PATH(1));
+    assert_stored_property(SENSOR_PATH(2), 20);
+
+    test_broker_hold_acks(false);
+    zassert_true(test_device_poll_until(device, is_connected, CONNECTION_TIMEOUT));
+    zassert_equal(device->prop_pending_count, 0);
+    assert_stored_property(SENSOR_PATH(1), 12);
+    assert_missing_property(SENSOR_PATH(2));
+
+    // Once connected, each change is written as soon as it is received
+    set_property(SENSOR_PATH(3), 31);
+    wait_changes(4);
+    zassert_equal(device->prop_pending_count, 0);
+    assert_stored_property(SENSOR_PATH(3), 31);
+}
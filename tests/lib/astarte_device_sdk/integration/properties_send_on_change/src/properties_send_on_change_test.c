@@ -0,0 +1,296 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/data.h"
+#include "astarte_device_sdk/device.h"
+#include "astarte_device_sdk/metrics.h"
+#include "astarte_device_sdk/result.h"
+
+#include "device_private.h"
+#include "generated_interfaces.h"
+#include "kv_storage.h"
+#include "mqtt.h"
+#include "test_broker.h"
+#include "test_device.h"
+#include "test_pairing.h"
+
+LOG_MODULE_REGISTER(properties_send_on_change_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+#define CONNECTION_TIMEOUT K_SECONDS(10)
+// Time given to the device to publish any update before counting the published ones
+#define SETTLE_TIME K_MSEC(500)
+
+BUILD_ASSERT(CONFIG_ASTARTE_DEVICE_SDK_PROPERTIES_SEND_ON_CHANGE_ENTRIES == 2,
+    "The tests set one property more than the tracked digests fit");
+
+#define DEVICE_PROPERTY (&org_astarteplatform_zephyr_examples_DeviceProperty)
+#define SENSOR_PATH(sensor) "/sensor" #sensor "/integer_endpoint"
+#define SENSOR_TOPIC(sensor) "DeviceProperty" SENSOR_PATH(sensor)
+
+static astarte_device_handle_t device;
+static atomic_t disconnections;
+static volatile bool fail_storage;
+static volatile bool fail_publish;
+
+// NOLINTBEGIN(bugprone-reserved-identifier) Symbols required by the linker --wrap option
+astarte_mqtt_payload_t *__real_astarte_mqtt_payload_wrap(void *data, size_t size);
+
+astarte_mqtt_payload_t *__wrap_astarte_mqtt_payload_wrap(void *data, size_t size)
+{
+    if (fail_publish) {
+        return NULL;
+    }
+    return __real_astarte_mqtt_payload_wrap(data, size);
+}
+
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+astarte_result_t __real_astarte_kv_storage_insert(
+    astarte_kv_storage_t *kv_storage, const char *key, const void *value, size_t value_size);
+
+astarte_result_t __wrap_astarte_kv_storage_insert(
+    astarte_kv_storage_t *kv_storage, const char *key, const void *value, size_t value_size)
+{
+    if (fail_storage) {
+        return ASTARTE_RESULT_NVS_ERROR;
+    }
+    return __real_astarte_kv_storage_insert(kv_storage, key, value, value_size);
+}
+#endif
+// NOLINTEND(bugprone-reserved-identifier)
+
+static void disconnection_cbk(astarte_device_disconnection_event_t event)
+{
+    ARG_UNUSED(event);
+    atomic_inc(&disconnections);
+}
+
+static bool is_synchronized(astarte_device_handle_t device)
+{
+    return (device->connection_state == DEVICE_CONNECTED) && device->synchronization_completed;
+}
+
+static bool is_disconnected(astarte_device_handle_t device)
+{
+    ARG_UNUSED(device);
+    return atomic_get(&disconnections) > 0;
+}
+
+static void connect_device(void)
+{
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_synchronized, CONNECTION_TIMEOUT));
+    astarte_metrics_reset();
+}
+
+static astarte_result_t set_property(const char *path, int32_t value)
+{
+    return astarte_device_set_property(
+        device, DEVICE_PROPERTY->name, path, astarte_data_from_integer(value));
+}
+
+static void assert_published(const char *topic, size_t expected)
+{
+    zassert_true(test_device_poll_for(device, SETTLE_TIME));
+    zassert_equal(test_broker_count_published(topic), expected, "Property %s published %zu times",
+        topic, test_broker_count_published(topic));
+}
+
+static void assert_suppressed(uint32_t expected)
+{
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_PROPERTIES_SUPPRESSED),
+        expected);
+}
+
+static void *properties_send_on_change_test_setup(void)
+{
+    zassert_ok(test_broker_start());
+    zassert_ok(test_pairing_start());
+    return NULL;
+}
+
+static void properties_send_on_change_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    test_broker_reset();
+    test_pairing_reset();
+    atomic_clear(&disconnections);
+    fail_storage = false;
+    fail_publish = false;
+#if defined(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE)
+    zassert_ok(test_device_clear_storage());
+#endif
+
+    const astarte_interface_t *interfaces[] = { DEVICE_PROPERTY };
+    astarte_device_config_t cfg = { 0 };
+    test_device_config_init(&cfg);
+    cfg.disconnection_cbk = disconnection_cbk;
+    cfg.interfaces = interfaces;
+    cfg.interfaces_size = ARRAY_SIZE(interfaces);
+    zassert_equal(astarte_device_new(&cfg, &device), ASTARTE_RESULT_OK);
+}
+
+static void properties_send_on_change_test_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    fail_storage = false;
+    fail_publish = false;
+    zassert_equal(astarte_device_destroy(device), ASTARTE_RESULT_OK);
+    device = NULL;
+}
+
+static void properties_send_on_change_test_teardown(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_equal(test_pairing_stop(), 0, "Loopback pairing APIs failures");
+    zassert_equal(test_broker_stop(), 0, "Loopback broker failures");
+}
+
+ZTEST_SUITE(astarte_device_sdk_properties_send_on_change, NULL,
+    properties_send_on_change_test_setup, properties_send_on_change_test_before,
+    properties_send_on_change_test_after, properties_send_on_change_test_teardown); // NOLINT
+
+ZTEST(astarte_device_sdk_properties_send_on_change, test_send_on_change_identical) // NOLINT
+{
+    connect_device();
+
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 1);
+    assert_suppressed(0);
+
+    // Setting the same value again is reported as successful but nothing is sent
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 1);
+    assert_suppressed(2);
+}
+
+ZTEST(astarte_device_sdk_properties_send_on_change, test_send_on_change_changed) // NOLINT
+{
+    connect_device();
+
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    zassert_equal(set_property(SENSOR_PATH(1), 11), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+
+    // The tracked value is the last one sent, not the first one
+    zassert_equal(set_property(SENSOR_PATH(1), 11), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 3);
+    assert_suppressed(1);
+}
+
+ZTEST(astarte_device_sdk_properties_send_on_change, test_send_on_change_unset) // NOLINT
+{
+    connect_device();
+
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    zassert_equal(astarte_device_unset_property(device, DEVICE_PROPERTY->name, SENSOR_PATH(1)),
+        ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+
+    // The value set before the unset is not tracked anymore
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 3);
+    assert_suppressed(0);
+}
+
+ZTEST(astarte_device_sdk_properties_send_on_change, test_send_on_change_failed_store) // NOLINT
+{
+    Z_TEST_SKIP_IFNDEF(CONFIG_ASTARTE_DEVICE_SDK_PERMANENT_STORAGE);
+
+    connect_device();
+
+    // The update is still sent, but the stored value can not be trusted to match it
+    fail_storage = true;
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    fail_storage = false;
+    assert_published(SENSOR_TOPIC(1), 1);
+
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+    assert_suppressed(1);
+}
+
+ZTEST(astarte_device_sdk_properties_send_on_change, test_send_on_change_failed_publish) // NOLINT
+{
+    connect_device();
+
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 1);
+
+    // The update fails before the new value is sent
+    fail_publish = true;
+    zassert_not_equal(set_property(SENSOR_PATH(1), 11), ASTARTE_RESULT_OK);
+    fail_publish = false;
+    assert_published(SENSOR_TOPIC(1), 1);
+
+    zassert_equal(set_property(SENSOR_PATH(1), 11), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+    zassert_equal(set_property(SENSOR_PATH(1), 11), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+    assert_suppressed(1);
+}
+
+ZTEST(astarte_device_sdk_properties_send_on_change, test_send_on_change_handshake) // NOLINT
+{
+    connect_device();
+
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 1);
+    zassert_equal(astarte_device_disconnect(device, CONNECTION_TIMEOUT), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_disconnected, CONNECTION_TIMEOUT));
+
+    // Without a session the full handshake runs again and the tracked digests are dropped
+    test_broker_reset();
+    connect_device();
+    for (size_t i = 0; i < ARRAY_SIZE(device->prop_digests); i++) {
+        zassert_false(device->prop_digests[i].used);
+    }
+    size_t resent = test_broker_count_published(SENSOR_TOPIC(1));
+
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), resent + 1);
+    assert_suppressed(0);
+}
+
+ZTEST(astarte_device_sdk_properties_send_on_change, test_send_on_change_eviction) // NOLINT
+{
+    connect_device();
+
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    zassert_equal(set_property(SENSOR_PATH(2), 20), ASTARTE_RESULT_OK);
+    zassert_equal(set_property(SENSOR_PATH(3), 30), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 1);
+    assert_published(SENSOR_TOPIC(2), 1);
+    assert_published(SENSOR_TOPIC(3), 1);
+
+    // The third property replaced the first one, the update of a tracked property replaces none
+    zassert_equal(set_property(SENSOR_PATH(3), 30), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(3), 1);
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+
+    // Tracking the first property again replaced the second one, next in round robin order
+    zassert_equal(set_property(SENSOR_PATH(1), 10), ASTARTE_RESULT_OK);
+    zassert_equal(set_property(SENSOR_PATH(3), 30), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(1), 2);
+    assert_published(SENSOR_TOPIC(3), 1);
+    zassert_equal(set_property(SENSOR_PATH(2), 20), ASTARTE_RESULT_OK);
+    assert_published(SENSOR_TOPIC(2), 2);
+    assert_suppressed(3);
+}
@@ -0,0 +1,413 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/data.h"
+#include "astarte_device_sdk/device.h"
+#include "astarte_device_sdk/heap.h"
+#include "astarte_device_sdk/interface.h"
+#include "astarte_device_sdk/object.h"
+#include "astarte_device_sdk/result.h"
+
+#include "astarte_zlib.h"
+#include "bson_deserializer.h"
+#include "bson_serializer.h"
+#include "data_private.h"
+#include "device_caching.h"
+#include "device_private.h"
+#include "generated_interfaces.h"
+#include "heap_private.h"
+#include "introspection.h"
+#include "mqtt.h"
+#include "object_private.h"
+#include "test_broker.h"
+#include "test_device.h"
+#include "test_pairing.h"
+
+LOG_MODULE_REGISTER(static_allocation_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+/** @brief Number of TX/RX rounds performed by the workload. */
+#define WORKLOAD_ITERATIONS 10
+
+#define CONNECTION_TIMEOUT K_SECONDS(10)
+
+#define DEVICE_DATASTREAM (&org_astarteplatform_zephyr_examples_DeviceDatastream)
+#define DEVICE_PROPERTY (&org_astarteplatform_zephyr_examples_DeviceProperty)
+#define SERVER_DATASTREAM (&org_astarteplatform_zephyr_examples_ServerDatastream)
+#define SERVER_PROPERTY (&org_astarteplatform_zephyr_examples_ServerProperty)
+#define DEVICE_TOPIC(suffix) CONFIG_ASTARTE_DEVICE_SDK_REALM_NAME "/" TEST_DEVICE_ID suffix
+
+/** @brief Number of calls to the libc allocation functions, which always fail in this test. */
+static size_t libc_allocations;
+/** @brief Set while the network stack resolver runs, its results are allocated with calloc. */
+static bool resolving;
+
+static astarte_device_handle_t device;
+static atomic_t disconnections;
+static atomic_t received_datastreams;
+
+// NOLINTBEGIN(bugprone-reserved-identifier) Symbols required by the linker --wrap option
+void *__real_calloc(size_t num, size_t size);
+int __real_zsock_getaddrinfo(const char *host, const char *service,
+    const struct zsock_addrinfo *hints, struct zsock_addrinfo **res);
+
+int __wrap_zsock_getaddrinfo(const char *host, const char *service,
+    const struct zsock_addrinfo *hints, struct zsock_addrinfo **res)
+{
+    resolving = true;
+    int ret = __real_zsock_getaddrinfo(host, service, hints, res);
+    resolving = false;
+    return ret;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    ARG_UNUSED(size);
+    libc_allocations++;
+    return NULL;
+}
+
+void *__wrap_calloc(size_t num, size_t size)
+{
+    if (resolving) {
+        return __real_calloc(num, size);
+    }
+    libc_allocations++;
+    return NULL;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    ARG_UNUSED(ptr);
+    ARG_UNUSED(size);
+    libc_allocations++;
+    return NULL;
+}
+// NOLINTEND(bugprone-reserved-identifier)
+
+static void disconnection_cbk(astarte_device_disconnection_event_t event)
+{
+    ARG_UNUSED(event);
+    atomic_inc(&disconnections);
+}
+
+static void datastream_individual_cbk(astarte_device_datastream_individual_event_t event)
+{
+    int32_t value = 0;
+    if ((astarte_data_to_integer(event.data, &value) == ASTARTE_RESULT_OK) && (value == 42)) {
+        atomic_inc(&received_datastreams);
+    }
+}
+
+static bool is_synchronized(astarte_device_handle_t device)
+{
+    return (device->connection_state == DEVICE_CONNECTED) && device->synchronization_completed;
+}
+
+static bool is_disconnected(astarte_device_handle_t device)
+{
+    ARG_UNUSED(device);
+    return atomic_get(&disconnections) > 0;
+}
+
+static bool is_datastream_received(astarte_device_handle_t device)
+{
+    ARG_UNUSED(device);
+    return atomic_get(&received_datastreams) > 0;
+}
+
+static astarte_result_t load_server_property(const char *path)
+{
+    uint32_t major = 0U;
+    astarte_data_t data = { 0 };
+    astarte_result_t ares
+        = astarte_device_caching_property_load(SERVER_PROPERTY->name, path, &major, &data);
+    if (ares == ASTARTE_RESULT_OK) {
+        astarte_device_caching_property_destroy_loaded(data);
+    }
+    return ares;
+}
+
+static bool is_server_property_purged(astarte_device_handle_t device)
+{
+    ARG_UNUSED(device);
+    return load_server_property("/sensor2/integer_endpoint") == ASTARTE_RESULT_NOT_FOUND;
+}
+
+static void set_zlib_header_window(uint8_t *header)
+{
+    // Astarte compresses with the default 32 KiB window, the stream is valid for any larger window
+    header[0] = (uint8_t) ((MAX_WBITS - 8) << 4 | Z_DEFLATED);
+    header[1] &= 0xE0U;
+    header[1] |= (31U - ((header[0] << 8 | header[1]) % 31U)) % 31U;
+}
+
+static void *static_allocation_setup(void)
+{
+    zassert_ok(test_broker_start());
+    zassert_ok(test_pairing_start());
+    return NULL;
+}
+
+static void static_allocation_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    test_broker_reset();
+    test_pairing_reset();
+    atomic_clear(&disconnections);
+    atomic_clear(&received_datastreams);
+    libc_allocations = 0;
+}
+
+static void static_allocation_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    if (device) {
+        zassert_equal(astarte_device_destroy(device), ASTARTE_RESULT_OK);
+        device = NULL;
+    }
+    astarte_heap_stats_t stats = { 0 };
+    astarte_heap_get_stats(&stats);
+    zassert_equal(libc_allocations, 0, "The SDK performed %zu libc allocations", libc_allocations);
+    zassert_equal(stats.live_blocks, 0, "Leaked %zu blocks", stats.live_blocks);
+}
+
+static void static_allocation_teardown(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_equal(test_pairing_stop(), 0, "Loopback pairing APIs failures");
+    zassert_equal(test_broker_stop(), 0, "Loopback broker failures");
+}
+
+ZTEST_SUITE(astarte_device_sdk_static_allocation, NULL, static_allocation_setup,
+    static_allocation_before, static_allocation_after, static_allocation_teardown); // NOLINT
+
+static const astarte_mapping_t object_mappings[] = {
+    {
+        .endpoint = "/%{sensor_id}/double_endpoint",
+        .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+    },
+    {
+        .endpoint = "/%{sensor_id}/stringarray_endpoint",
+        .type = ASTARTE_MAPPING_TYPE_STRINGARRAY,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+    },
+};
+
+static const astarte_interface_t object_interface = {
+    .name = "org.astarteplatform.zephyr.test.Object",
+    .major_version = 0,
+    .minor_version = 1,
+    .type = ASTARTE_INTERFACE_TYPE_DATASTREAM,
+    .ownership = ASTARTE_INTERFACE_OWNERSHIP_SERVER,
+    .aggregation = ASTARTE_INTERFACE_AGGREGATION_OBJECT,
+    .mappings = object_mappings,
+    .mappings_length = ARRAY_SIZE(object_mappings),
+};
+
+static const char *string_array[] = { "hello", "static", "pools" };
+static const char purge_properties[]
+    = "org.astarteplatform.zephyr.test.Property/sensor1/value;"
+      "org.astarteplatform.zephyr.test.Property/sensor2/value";
+
+ZTEST(astarte_device_sdk_static_allocation, test_static_allocation_workload)
+{
+    introspection_t introspection = { 0 };
+    zassert_equal(introspection_init(&introspection), ASTARTE_RESULT_OK);
+
+    for (size_t i = 0; i < WORKLOAD_ITERATIONS; i++) {
+        zassert_equal(introspection_add(&introspection, &object_interface), ASTARTE_RESULT_OK);
+
+        // Transmission
+        astarte_object_entry_t entries[] = {
+            astarte_object_entry_new("double_endpoint", astarte_data_from_double(12.5)),
+            astarte_object_entry_new("stringarray_endpoint",
+                astarte_data_from_string_array(string_array, ARRAY_SIZE(string_array))),
+        };
+        astarte_bson_serializer_t inner_bson = { 0 };
+        astarte_bson_serializer_t outer_bson = { 0 };
+        zassert_equal(astarte_bson_serializer_init(&inner_bson), ASTARTE_RESULT_OK);
+        zassert_equal(astarte_object_entries_serialize(&inner_bson, entries, ARRAY_SIZE(entries)),
+            ASTARTE_RESULT_OK);
+        astarte_bson_serializer_append_end_of_document(&inner_bson);
+        zassert_equal(astarte_bson_serializer_init(&outer_bson), ASTARTE_RESULT_OK);
+        int inner_size = 0;
+        astarte_bson_serializer_append_document(
+            &outer_bson, "v", astarte_bson_serializer_get_serialized(inner_bson, &inner_size));
+        astarte_bson_serializer_append_end_of_document(&outer_bson);
+        astarte_bson_serializer_destroy(&inner_bson);
+
+        size_t size = 0;
+        void *buf = astarte_bson_serializer_detach(&outer_bson, &size);
+        zassert_not_null(buf);
+        astarte_mqtt_payload_t *payload = astarte_mqtt_payload_wrap(buf, size);
+        zassert_not_null(payload);
+
+        // Reception
+        astarte_bson_document_t doc = astarte_bson_deserializer_init_doc(payload->data);
+        astarte_bson_element_t v_elem = { 0 };
+        zassert_equal(
+            astarte_bson_deserializer_element_lookup(doc, "v", &v_elem), ASTARTE_RESULT_OK);
+        astarte_object_entry_t *rx_entries = NULL;
+        size_t rx_entries_len = 0;
+        astarte_result_t ares = astarte_object_entries_deserialize(
+            v_elem, &object_interface, "/sensor7", &rx_entries, &rx_entries_len);
+        zassert_equal(ares, ASTARTE_RESULT_OK, "%s", astarte_result_to_name(ares));
+        zassert_equal(rx_entries_len, ARRAY_SIZE(entries));
+        astarte_object_entries_destroy_deserialized(rx_entries, rx_entries_len);
+        astarte_mqtt_payload_unref(payload);
+
+        zassert_equal(
+            introspection_remove(&introspection, object_interface.name), ASTARTE_RESULT_OK);
+    }
+
+    introspection_free(introspection);
+}
+
+ZTEST(astarte_device_sdk_static_allocation, test_static_allocation_zlib)
+{
+    uint8_t compressed[2 * sizeof(purge_properties)] = { 0 };
+    uLongf compressed_len = sizeof(compressed);
+    char decompressed[sizeof(purge_properties)] = { 0 };
+    uLongf decompressed_len = sizeof(decompressed);
+
+    int zlib_res = astarte_zlib_compress(
+        compressed, &compressed_len, (const Bytef *) purge_properties, sizeof(purge_properties));
+    zassert_equal(zlib_res, Z_OK);
+    zlib_res = astarte_zlib_uncompress(
+        (Bytef *) decompressed, &decompressed_len, compressed, compressed_len);
+    zassert_equal(zlib_res, Z_OK);
+    zassert_equal(decompressed_len, sizeof(purge_properties));
+    zassert_mem_equal(decompressed, purge_properties, sizeof(purge_properties));
+
+    astarte_heap_stats_t stats = { 0 };
+    astarte_heap_get_stats(&stats);
+    zassert_true(stats.modules[ASTARTE_HEAP_MODULE_ZLIB].peak_bytes > 0);
+}
+
+ZTEST(astarte_device_sdk_static_allocation, test_static_allocation_pool_exhaustion)
+{
+    void *blocks[CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_SMALL_BLOCK_COUNT] = { 0 };
+    astarte_heap_stats_t stats = { 0 };
+    astarte_heap_get_stats(&stats);
+    size_t failed_allocations = stats.failed_allocations;
+
+    for (size_t i = 0; i < ARRAY_SIZE(blocks); i++) {
+        blocks[i] = astarte_heap_malloc(
+            ASTARTE_HEAP_MODULE_DATA, CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_SMALL_BLOCK_SIZE);
+        zassert_not_null(blocks[i]);
+    }
+    // Requests are never served by a larger pool
+    zassert_is_null(astarte_heap_malloc(ASTARTE_HEAP_MODULE_DATA, 1));
+    // Requests larger than the large blocks always fail
+    zassert_is_null(astarte_heap_malloc(
+        ASTARTE_HEAP_MODULE_DATA, CONFIG_ASTARTE_DEVICE_SDK_STATIC_POOL_LARGE_BLOCK_SIZE + 1));
+
+    for (size_t i = 0; i < ARRAY_SIZE(blocks); i++) {
+        astarte_heap_free(blocks[i]);
+    }
+    void *block = astarte_heap_malloc(ASTARTE_HEAP_MODULE_DATA, 1);
+    zassert_not_null(block);
+    astarte_heap_free(block);
+
+    astarte_heap_get_stats(&stats);
+    zassert_equal(stats.failed_allocations, failed_allocations + 2);
+}
+
+ZTEST(astarte_device_sdk_static_allocation, test_static_allocation_device) // NOLINT
+{
+    // Server properties cached from a previous session, the second one is purged by Astarte
+    zassert_ok(test_device_clear_storage());
+    zassert_equal(astarte_device_caching_property_store(SERVER_PROPERTY->name,
+                      "/sensor1/integer_endpoint", SERVER_PROPERTY->major_version,
+                      astarte_data_from_integer(1)),
+        ASTARTE_RESULT_OK);
+    zassert_equal(astarte_device_caching_property_store(SERVER_PROPERTY->name,
+                      "/sensor2/integer_endpoint", SERVER_PROPERTY->major_version,
+                      astarte_data_from_integer(2)),
+        ASTARTE_RESULT_OK);
+
+    // Creation, pairing and handshake
+    const astarte_interface_t *interfaces[] = {
+        DEVICE_DATASTREAM,
+        DEVICE_PROPERTY,
+        SERVER_DATASTREAM,
+        SERVER_PROPERTY,
+    };
+    astarte_device_config_t cfg = { 0 };
+    test_device_config_init(&cfg);
+    cfg.disconnection_cbk = disconnection_cbk;
+    cfg.datastream_individual_cbk = datastream_individual_cbk;
+    cfg.interfaces = interfaces;
+    cfg.interfaces_size = ARRAY_SIZE(interfaces);
+    zassert_equal(astarte_device_new(&cfg, &device), ASTARTE_RESULT_OK);
+    zassert_equal(astarte_device_connect(device), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_synchronized, CONNECTION_TIMEOUT));
+
+    // Transmission, the property is stored in the key-value storage
+    zassert_equal(astarte_device_send_individual(device, DEVICE_DATASTREAM->name,
+                      "/integer_endpoint", astarte_data_from_integer(42), NULL),
+        ASTARTE_RESULT_OK);
+    zassert_equal(astarte_device_set_property(device, DEVICE_PROPERTY->name,
+                      "/sensor1/integer_endpoint", astarte_data_from_integer(42)),
+        ASTARTE_RESULT_OK);
+    zassert_true(test_broker_wait_published("DeviceDatastream/integer_endpoint", 1,
+        CONNECTION_TIMEOUT));
+    zassert_true(test_broker_wait_published("DeviceProperty/sensor1/integer_endpoint", 1,
+        CONNECTION_TIMEOUT));
+
+    // Reception of a datastream
+    astarte_bson_serializer_t bson = { 0 };
+    zassert_equal(astarte_bson_serializer_init(&bson), ASTARTE_RESULT_OK);
+    astarte_bson_serializer_append_int32(&bson, "v", 42);
+    astarte_bson_serializer_append_end_of_document(&bson);
+    int bson_size = 0;
+    const void *bson_buf = astarte_bson_serializer_get_serialized(bson, &bson_size);
+    zassert_ok(test_broker_publish(
+        DEVICE_TOPIC("/org.astarteplatform.zephyr.examples.ServerDatastream/integer_endpoint"),
+        bson_buf, bson_size, 0));
+    astarte_bson_serializer_destroy(&bson);
+    zassert_true(test_device_poll_until(device, is_datastream_received, CONNECTION_TIMEOUT));
+
+    // Reception of a compressed purge properties message, inflated with the large pool blocks
+    static const char allow_list[]
+        = "org.astarteplatform.zephyr.examples.ServerProperty/sensor1/integer_endpoint";
+    uint8_t purge[sizeof(uint32_t) + 2 * sizeof(allow_list)] = { 0 };
+    uLongf compressed_len = sizeof(purge) - sizeof(uint32_t);
+    zassert_equal(astarte_zlib_compress(&purge[sizeof(uint32_t)], &compressed_len,
+                      (const Bytef *) allow_list, strlen(allow_list)),
+        Z_OK);
+    sys_put_be32(strlen(allow_list), purge);
+    set_zlib_header_window(&purge[sizeof(uint32_t)]);
+    zassert_ok(test_broker_publish(DEVICE_TOPIC("/control/consumer/properties"), purge,
+        sizeof(uint32_t) + compressed_len, 2));
+    zassert_true(test_device_poll_until(device, is_server_property_purged, CONNECTION_TIMEOUT));
+    zassert_equal(load_server_property("/sensor1/integer_endpoint"), ASTARTE_RESULT_OK);
+
+    // Disconnection and destruction
+    zassert_equal(astarte_device_disconnect(device, CONNECTION_TIMEOUT), ASTARTE_RESULT_OK);
+    zassert_true(test_device_poll_until(device, is_disconnected, CONNECTION_TIMEOUT));
+    zassert_equal(astarte_device_destroy(device), ASTARTE_RESULT_OK);
+    device = NULL;
+
+    astarte_heap_stats_t stats = { 0 };
+    astarte_heap_get_stats(&stats);
+    zassert_true(stats.modules[ASTARTE_HEAP_MODULE_ZLIB].peak_bytes >= (1U << MAX_WBITS));
+}
@@ -0,0 +1,218 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/metrics.h"
+
+#include "metrics_private.h"
+#include "stream_filter.h"
+
+LOG_MODULE_REGISTER(stream_filter_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+enum test_mapping
+{
+    TEST_MAPPING_DEADBAND = 0,
+    TEST_MAPPING_INTERVAL,
+    TEST_MAPPING_RATE,
+    TEST_MAPPING_STRING,
+};
+
+static const astarte_mapping_filter_t deadband_filter = {
+    .deadband_absolute = 0.5,
+};
+static const astarte_mapping_filter_t interval_filter = {
+    .min_interval_ms = 100U,
+};
+static const astarte_mapping_filter_t rate_filter = {
+    .max_rate = 10.0,
+};
+
+static const astarte_mapping_t test_mappings[] = {
+    [TEST_MAPPING_DEADBAND] = {
+        .endpoint = "/deadband",
+        .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+        .filter = &deadband_filter,
+    },
+    [TEST_MAPPING_INTERVAL] = {
+        .endpoint = "/interval",
+        .type = ASTARTE_MAPPING_TYPE_INTEGER,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+        .filter = &interval_filter,
+    },
+    [TEST_MAPPING_RATE] = {
+        .endpoint = "/rate",
+        .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+        .explicit_timestamp = true,
+        .allow_unset = false,
+        .filter = &rate_filter,
+    },
+    [TEST_MAPPING_STRING] = {
+        .endpoint = "/string",
+        .type = ASTARTE_MAPPING_TYPE_STRING,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+    },
+};
+
+static const astarte_interface_t test_interface = {
+    .name = "org.astarteplatform.zephyr.test.Filtered",
+    .major_version = 0,
+    .minor_version = 1,
+    .type = ASTARTE_INTERFACE_TYPE_DATASTREAM,
+    .ownership = ASTARTE_INTERFACE_OWNERSHIP_DEVICE,
+    .aggregation = ASTARTE_INTERFACE_AGGREGATION_INDIVIDUAL,
+    .mappings = test_mappings,
+    .mappings_length = ARRAY_SIZE(test_mappings),
+};
+
+static astarte_stream_filter_t stream_filter;
+
+static bool check(enum test_mapping mapping, astarte_data_t value, const int64_t *timestamp)
+{
+    return astarte_stream_filter_check(&stream_filter, &test_interface, &test_mappings[mapping],
+        test_mappings[mapping].endpoint, value, timestamp);
+}
+
+static void stream_filter_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    astarte_metrics_reset();
+    astarte_stream_filter_init(&stream_filter);
+}
+
+static void stream_filter_test_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    astarte_stream_filter_destroy(&stream_filter);
+}
+
+ZTEST_SUITE(astarte_device_sdk_stream_filter, NULL, NULL, stream_filter_test_before,
+    stream_filter_test_after, NULL); // NOLINT
+
+ZTEST(astarte_device_sdk_stream_filter, test_stream_filter_deadband)
+{
+    zassert_true(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(10.0), NULL));
+    zassert_false(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(10.4), NULL));
+    zassert_false(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(9.5), NULL));
+    // The deadband is relative to the last sent value, not to the last checked one
+    zassert_true(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(10.6), NULL));
+    zassert_false(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(10.2), NULL));
+
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED), 3);
+}
+
+ZTEST(astarte_device_sdk_stream_filter, test_stream_filter_min_interval)
+{
+    zassert_true(check(TEST_MAPPING_INTERVAL, astarte_data_from_integer(1), NULL));
+    zassert_false(check(TEST_MAPPING_INTERVAL, astarte_data_from_integer(2), NULL));
+    k_sleep(K_MSEC(150));
+    zassert_true(check(TEST_MAPPING_INTERVAL, astarte_data_from_integer(3), NULL));
+
+    // Dropped values are not held
+    astarte_stream_filter_sample_t sample = { 0 };
+    zassert_equal(astarte_stream_filter_pop_due(&stream_filter, &sample), ASTARTE_RESULT_NOT_FOUND);
+    zassert_true(K_TIMEOUT_EQ(astarte_stream_filter_get_deadline(&stream_filter), K_FOREVER));
+}
+
+ZTEST(astarte_device_sdk_stream_filter, test_stream_filter_max_rate)
+{
+    int64_t timestamp = 1000;
+    zassert_true(check(TEST_MAPPING_RATE, astarte_data_from_double(1.0), NULL));
+    zassert_false(check(TEST_MAPPING_RATE, astarte_data_from_double(2.0), NULL));
+    zassert_false(check(TEST_MAPPING_RATE, astarte_data_from_double(3.0), &timestamp));
+
+    // Only the last value is held, until the rate allows it
+    astarte_stream_filter_sample_t sample = { 0 };
+    zassert_equal(astarte_stream_filter_pop_due(&stream_filter, &sample), ASTARTE_RESULT_NOT_FOUND);
+    zassert_false(K_TIMEOUT_EQ(astarte_stream_filter_get_deadline(&stream_filter), K_FOREVER));
+    k_sleep(K_MSEC(150));
+    zassert_true(K_TIMEOUT_EQ(astarte_stream_filter_get_deadline(&stream_filter), K_NO_WAIT));
+
+    zassert_equal(astarte_stream_filter_pop_due(&stream_filter, &sample), ASTARTE_RESULT_OK);
+    zassert_str_equal(sample.interface_name, test_interface.name);
+    zassert_str_equal(sample.path, "/rate");
+    zassert_equal(sample.value.data.dbl, 3.0);
+    zassert_true(sample.has_timestamp);
+    zassert_equal(sample.timestamp, timestamp);
+    astarte_stream_filter_sample_destroy(sample);
+
+    zassert_equal(astarte_stream_filter_pop_due(&stream_filter, &sample), ASTARTE_RESULT_NOT_FOUND);
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED), 1);
+}
+
+ZTEST(astarte_device_sdk_stream_filter, test_stream_filter_removed_interface)
+{
+    char interface_name[] = "org.astarteplatform.zephyr.test.Removed";
+    astarte_interface_t interface = test_interface;
+    interface.name = interface_name;
+    const astarte_mapping_t *mapping = &test_mappings[TEST_MAPPING_RATE];
+
+    zassert_true(astarte_stream_filter_check(&stream_filter, &interface, mapping,
+        mapping->endpoint, astarte_data_from_double(1.0), NULL));
+    zassert_false(astarte_stream_filter_check(&stream_filter, &interface, mapping,
+        mapping->endpoint, astarte_data_from_double(2.0), NULL));
+
+    // The held value outlives the interface name it has been checked with
+    memset(interface_name, 0, sizeof(interface_name));
+    k_sleep(K_MSEC(150));
+
+    astarte_stream_filter_sample_t sample = { 0 };
+    zassert_equal(astarte_stream_filter_pop_due(&stream_filter, &sample), ASTARTE_RESULT_OK);
+    zassert_str_equal(sample.interface_name, "org.astarteplatform.zephyr.test.Removed");
+    zassert_str_equal(sample.path, "/rate");
+    astarte_stream_filter_sample_destroy(sample);
+}
+
+ZTEST(astarte_device_sdk_stream_filter, test_stream_filter_set)
+{
+    const astarte_mapping_filter_t filter = { .deadband_absolute = 5.0 };
+
+    // Non scalar and unknown mappings are rejected
+    zassert_equal(astarte_stream_filter_set(&stream_filter, &test_interface, "/string", &filter),
+        ASTARTE_RESULT_INVALID_PARAM);
+    zassert_equal(astarte_stream_filter_set(&stream_filter, &test_interface, "/unknown", &filter),
+        ASTARTE_RESULT_MAPPING_NOT_IN_INTERFACE);
+
+    zassert_equal(astarte_stream_filter_set(&stream_filter, &test_interface, "/deadband", &filter),
+        ASTARTE_RESULT_OK);
+    zassert_true(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(0.0), NULL));
+    zassert_false(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(4.0), NULL));
+
+    // A single override is configured
+    zassert_equal(astarte_stream_filter_set(&stream_filter, &test_interface, "/rate", &filter),
+        ASTARTE_RESULT_OUT_OF_MEMORY);
+
+    // Removing the override restores the filter of the mapping definition
+    zassert_equal(astarte_stream_filter_set(&stream_filter, &test_interface, "/deadband", NULL),
+        ASTARTE_RESULT_OK);
+    zassert_true(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(4.0), NULL));
+
+    // A zeroed filter disables the filtering
+    const astarte_mapping_filter_t disabled = { 0 };
+    zassert_equal(
+        astarte_stream_filter_set(&stream_filter, &test_interface, "/deadband", &disabled),
+        ASTARTE_RESULT_OK);
+    zassert_true(check(TEST_MAPPING_DEADBAND, astarte_data_from_double(4.0), NULL));
+}
+
+ZTEST(astarte_device_sdk_stream_filter, test_stream_filter_unfiltered)
+{
+    astarte_data_t value = astarte_data_from_string("value");
+    zassert_true(check(TEST_MAPPING_STRING, value, NULL));
+    zassert_true(check(TEST_MAPPING_STRING, value, NULL));
+    zassert_equal(astarte_metrics_get_counter(ASTARTE_METRICS_COUNTER_DATASTREAMS_FILTERED), 0);
+}
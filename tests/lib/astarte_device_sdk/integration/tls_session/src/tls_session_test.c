@@ -0,0 +1,372 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/tls_credentials.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/result.h"
+
+#include "host_clock.h"
+#include "test_credentials.h"
+#include "tls_credentials.h"
+
+LOG_MODULE_REGISTER(tls_session_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+#define SERVER_CRT_TAG 10
+#define CA_CRT_TAG 11
+#define SERVER_PORT 4443
+#define RELAY_PORT 4444
+#define SERVER_HOSTNAME "localhost"
+#define CONNECTIONS 4
+#define THREAD_STACK_SIZE 8192
+#define THREAD_PRIORITY 5
+#define POLL_PERIOD_MS 10
+#define RELAY_BUFFER_SIZE 1024
+
+#define TLS_RECORD_HEADER_LEN 5
+#define TLS_RECORD_CHANGE_CIPHER_SPEC 20
+#define TLS_RECORD_HANDSHAKE 22
+#define TLS_HANDSHAKE_CERTIFICATE 11
+
+// Failures of the server and relay threads are counted and checked by the test thread
+#define THREAD_FAIL(...)                                                                           \
+    do {                                                                                           \
+        LOG_ERR(__VA_ARGS__); /* NOLINT */                                                         \
+        atomic_inc(&thread_failures);                                                              \
+    } while (0)
+
+/**
+ * @brief Parser for the TLS records sent by the server, up to its first ChangeCipherSpec.
+ *
+ * @details In a full handshake the server sends its certificate before the ChangeCipherSpec, while
+ * in an abbreviated (resumed) handshake the ChangeCipherSpec directly follows the ServerHello.
+ */
+struct server_flight
+{
+    uint8_t header[TLS_RECORD_HEADER_LEN];
+    size_t header_len;
+    size_t body_len;
+    size_t body_offset;
+    bool certificate;
+    bool change_cipher_spec;
+};
+
+K_THREAD_STACK_DEFINE(server_stack, THREAD_STACK_SIZE);
+K_THREAD_STACK_DEFINE(relay_stack, THREAD_STACK_SIZE);
+static struct k_thread server_thread;
+static struct k_thread relay_thread;
+static atomic_t threads_stop_flag;
+static atomic_t thread_failures;
+static atomic_t full_handshakes;
+static atomic_t resumed_handshakes;
+
+static int listen_socket(int proto, uint16_t port)
+{
+    int sock = zsock_socket(AF_INET, SOCK_STREAM, proto);
+    if (sock < 0) {
+        THREAD_FAIL("Socket creation failed: %d", errno);
+        return -1;
+    }
+    int reuse = 1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    zsock_inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (zsock_setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0) {
+        THREAD_FAIL("Socket option failed: %d", errno);
+        goto failure;
+    }
+    if (proto == IPPROTO_TLS_1_2) {
+        sec_tag_t sec_tag_list[] = { SERVER_CRT_TAG };
+        int session_cache = TLS_SESSION_CACHE_ENABLED;
+        if ((zsock_setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST, sec_tag_list, sizeof(sec_tag_list))
+                != 0)
+            || (zsock_setsockopt(
+                    sock, SOL_TLS, TLS_SESSION_CACHE, &session_cache, sizeof(session_cache))
+                != 0)) {
+            THREAD_FAIL("TLS socket option failed: %d", errno);
+            goto failure;
+        }
+    }
+    if ((zsock_bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0)
+        || (zsock_listen(sock, 1) != 0)) {
+        THREAD_FAIL("Socket listen failed: %d", errno);
+        goto failure;
+    }
+    return sock;
+
+failure:
+    zsock_close(sock);
+    return -1;
+}
+
+static bool wait_readable(int sock)
+{
+    struct zsock_pollfd fds[1] = { { .fd = sock, .events = ZSOCK_POLLIN } };
+    while (!atomic_get(&threads_stop_flag)) {
+        int ret = zsock_poll(fds, ARRAY_SIZE(fds), POLL_PERIOD_MS);
+        if (ret < 0) {
+            THREAD_FAIL("Socket poll failed: %d", errno);
+            return false;
+        }
+        if (ret > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void server_thread_entry(void *arg1, void *arg2, void *arg3)
+{
+    int server_sock = POINTER_TO_INT(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    while (wait_readable(server_sock)) {
+        // The TLS handshake is performed while accepting the connection
+        int client_sock = zsock_accept(server_sock, NULL, NULL);
+        if (client_sock < 0) {
+            THREAD_FAIL("Server accept failed: %d", errno);
+            continue;
+        }
+        char byte = 0;
+        if ((zsock_recv(client_sock, &byte, 1, 0) != 1)
+            || (zsock_send(client_sock, &byte, 1, 0) != 1)) {
+            THREAD_FAIL("Server echo failed: %d", errno);
+        }
+        zsock_close(client_sock);
+    }
+    zsock_close(server_sock);
+}
+
+static void parse_server_flight(struct server_flight *flight, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; (i < len) && !flight->change_cipher_spec; i++) {
+        if (flight->header_len < TLS_RECORD_HEADER_LEN) {
+            flight->header[flight->header_len++] = data[i];
+            if (flight->header_len == TLS_RECORD_HEADER_LEN) {
+                flight->body_len = ((size_t) flight->header[3] << 8) | flight->header[4];
+                flight->body_offset = 0;
+                flight->change_cipher_spec
+                    = (flight->header[0] == TLS_RECORD_CHANGE_CIPHER_SPEC);
+            }
+            continue;
+        }
+        // Each handshake message of the server is sent in its own record
+        if ((flight->header[0] == TLS_RECORD_HANDSHAKE) && (flight->body_offset == 0)
+            && (data[i] == TLS_HANDSHAKE_CERTIFICATE)) {
+            flight->certificate = true;
+        }
+        if (++flight->body_offset == flight->body_len) {
+            flight->header_len = 0;
+        }
+    }
+}
+
+static int relay(int from, int to, struct server_flight *flight)
+{
+    uint8_t buf[RELAY_BUFFER_SIZE];
+    ssize_t received = zsock_recv(from, buf, sizeof(buf), 0);
+    if (received <= 0) {
+        return -1;
+    }
+    if (flight) {
+        parse_server_flight(flight, buf, received);
+    }
+    for (ssize_t sent = 0; sent < received;) {
+        ssize_t ret = zsock_send(to, &buf[sent], received - sent, 0);
+        if (ret < 0) {
+            return -1;
+        }
+        sent += ret;
+    }
+    return 0;
+}
+
+static void relay_connection(int client_sock)
+{
+    struct server_flight flight = { 0 };
+    int server_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(SERVER_PORT) };
+    zsock_inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if ((server_sock < 0)
+        || (zsock_connect(server_sock, (struct sockaddr *) &addr, sizeof(addr)) != 0)) {
+        THREAD_FAIL("Relay connection to the server failed: %d", errno);
+        goto exit;
+    }
+
+    struct zsock_pollfd fds[2] = {
+        { .fd = client_sock, .events = ZSOCK_POLLIN },
+        { .fd = server_sock, .events = ZSOCK_POLLIN },
+    };
+    while (!atomic_get(&threads_stop_flag)) {
+        int ret = zsock_poll(fds, ARRAY_SIZE(fds), POLL_PERIOD_MS);
+        if (ret < 0) {
+            THREAD_FAIL("Relay poll failed: %d", errno);
+            break;
+        }
+        // The connection ends when either side closes it
+        if ((fds[0].revents != 0) && (relay(client_sock, server_sock, NULL) != 0)) {
+            break;
+        }
+        if ((fds[1].revents != 0) && (relay(server_sock, client_sock, &flight) != 0)) {
+            break;
+        }
+    }
+
+    if (!flight.change_cipher_spec) {
+        THREAD_FAIL("The handshake has not been completed.");
+    } else if (flight.certificate) {
+        atomic_inc(&full_handshakes);
+    } else {
+        atomic_inc(&resumed_handshakes);
+    }
+
+exit:
+    if (server_sock >= 0) {
+        zsock_close(server_sock);
+    }
+    zsock_close(client_sock);
+}
+
+static void relay_thread_entry(void *arg1, void *arg2, void *arg3)
+{
+    int relay_sock = POINTER_TO_INT(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    // Forward the connections to the server, observing the handshakes on the wire
+    while (wait_readable(relay_sock)) {
+        int client_sock = zsock_accept(relay_sock, NULL, NULL);
+        if (client_sock < 0) {
+            THREAD_FAIL("Relay accept failed: %d", errno);
+            continue;
+        }
+        relay_connection(client_sock);
+    }
+    zsock_close(relay_sock);
+}
+
+static void *tls_session_test_setup(void)
+{
+    zassert_ok(tls_credential_add(SERVER_CRT_TAG, TLS_CREDENTIAL_SERVER_CERTIFICATE,
+        test_credentials_crt_pem, strlen(test_credentials_crt_pem) + 1));
+    zassert_ok(tls_credential_add(SERVER_CRT_TAG, TLS_CREDENTIAL_PRIVATE_KEY,
+        test_credentials_key_pem, strlen(test_credentials_key_pem) + 1));
+    zassert_ok(tls_credential_add(CA_CRT_TAG, TLS_CREDENTIAL_CA_CERTIFICATE,
+        test_credentials_crt_pem, strlen(test_credentials_crt_pem) + 1));
+
+    atomic_clear(&threads_stop_flag);
+    atomic_clear(&thread_failures);
+    int server_sock = listen_socket(IPPROTO_TLS_1_2, SERVER_PORT);
+    zassert_true(server_sock >= 0);
+    int relay_sock = listen_socket(IPPROTO_TCP, RELAY_PORT);
+    zassert_true(relay_sock >= 0);
+    k_thread_create(&server_thread, server_stack, K_THREAD_STACK_SIZEOF(server_stack),
+        server_thread_entry, INT_TO_POINTER(server_sock), NULL, NULL, THREAD_PRIORITY, 0,
+        K_NO_WAIT);
+    k_thread_create(&relay_thread, relay_stack, K_THREAD_STACK_SIZEOF(relay_stack),
+        relay_thread_entry, INT_TO_POINTER(relay_sock), NULL, NULL, THREAD_PRIORITY, 0, K_NO_WAIT);
+    return NULL;
+}
+
+static void tls_session_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    atomic_clear(&full_handshakes);
+    atomic_clear(&resumed_handshakes);
+}
+
+static void tls_session_test_teardown(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    atomic_set(&threads_stop_flag, 1);
+    zassert_ok(k_thread_join(&relay_thread, K_SECONDS(10)));
+    zassert_ok(k_thread_join(&server_thread, K_SECONDS(10)));
+    zassert_equal(atomic_get(&thread_failures), 0, "Server or relay failures");
+}
+
+static uint64_t timed_connection(bool resumption)
+{
+    int sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+    zassert_true(sock >= 0, "Client socket creation failed: %d", errno);
+
+    sec_tag_t sec_tag_list[] = { CA_CRT_TAG };
+    zassert_ok(
+        zsock_setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST, sec_tag_list, sizeof(sec_tag_list)));
+    zassert_ok(zsock_setsockopt(
+        sock, SOL_TLS, TLS_HOSTNAME, SERVER_HOSTNAME, sizeof(SERVER_HOSTNAME)));
+    if (resumption) {
+        astarte_result_t ares = astarte_tls_session_cache_enable(sock);
+        zassert_equal(ares, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(ares));
+    }
+
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(RELAY_PORT) };
+    zsock_inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    // The simulated time does not advance while computing, measure the handshake on the host
+    uint64_t start = astarte_host_clock_get_us();
+    zassert_ok(zsock_connect(sock, (struct sockaddr *) &addr, sizeof(addr)), "errno %d", errno);
+    char byte = 'a';
+    zassert_equal(zsock_send(sock, &byte, 1, 0), 1);
+    zassert_equal(zsock_recv(sock, &byte, 1, 0), 1);
+    uint64_t elapsed = astarte_host_clock_get_us() - start;
+
+    zsock_close(sock);
+    return elapsed;
+}
+
+static void wait_handshakes(size_t count)
+{
+    // The relay records the handshake once the connection has been closed on both sides
+    k_timepoint_t timepoint = sys_timepoint_calc(K_SECONDS(10));
+    while ((size_t) (atomic_get(&full_handshakes) + atomic_get(&resumed_handshakes)) < count) {
+        zassert_false(sys_timepoint_expired(timepoint), "Handshakes not observed by the relay");
+        k_sleep(K_MSEC(POLL_PERIOD_MS));
+    }
+}
+
+ZTEST_SUITE(astarte_device_sdk_tls_session, NULL, tls_session_test_setup, tls_session_test_before,
+    NULL, tls_session_test_teardown); // NOLINT
+
+ZTEST(astarte_device_sdk_tls_session, test_tls_session_resumption) // NOLINT
+{
+    uint64_t full_us = 0;
+    for (size_t i = 0; i < CONNECTIONS; i++) {
+        full_us += timed_connection(false);
+    }
+    full_us /= CONNECTIONS;
+    wait_handshakes(CONNECTIONS);
+    zassert_equal(atomic_get(&full_handshakes), CONNECTIONS);
+    zassert_equal(atomic_get(&resumed_handshakes), 0);
+
+    // The first connection performs a full handshake and populates the session cache
+    astarte_tls_session_cache_purge();
+    uint64_t first_us = timed_connection(true);
+    uint64_t resumed_us = 0;
+    for (size_t i = 0; i < CONNECTIONS; i++) {
+        resumed_us += timed_connection(true);
+    }
+    resumed_us /= CONNECTIONS;
+    wait_handshakes(2 * CONNECTIONS + 1);
+    zassert_equal(atomic_get(&full_handshakes), CONNECTIONS + 1);
+    zassert_equal(atomic_get(&resumed_handshakes), CONNECTIONS, "Sessions have not been resumed");
+
+    LOG_INF("Full handshake: %llu us, first cached: %llu us, resumed: %llu us", // NOLINT
+        full_us, first_us, resumed_us);
+    zassert_true(resumed_us < full_us, "Resumed handshakes not faster than full ones");
+
+    // Purging the cache forces a new full handshake, which should still succeed
+    astarte_tls_session_cache_purge();
+    (void) timed_connection(true);
+    wait_handshakes(2 * CONNECTIONS + 2);
+    zassert_equal(atomic_get(&full_handshakes), CONNECTIONS + 2);
+    zassert_equal(atomic_get(&resumed_handshakes), CONNECTIONS);
+    zassert_equal(atomic_get(&thread_failures), 0, "Server or relay failures");
+}
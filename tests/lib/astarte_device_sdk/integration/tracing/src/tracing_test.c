@@ -0,0 +1,94 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/tracing.h"
+
+#include "host_clock.h"
+#include "tracing_private.h"
+
+LOG_MODULE_REGISTER(tracing_test, CONFIG_LOG_DEFAULT_LEVEL); // NOLINT
+
+// Duration of the stage traced while keeping the CPU busy
+#define BUSY_STAGE_US 10000U
+
+static void tracing_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    astarte_trace_clear();
+}
+
+ZTEST_SUITE(astarte_device_sdk_tracing, NULL, NULL, tracing_test_before, NULL, NULL); // NOLINT
+
+ZTEST(astarte_device_sdk_tracing, test_tracing_ring_buffer)
+{
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_SEND);
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_VALIDATION);
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_VALIDATION);
+
+    astarte_trace_event_t events[CONFIG_ASTARTE_DEVICE_SDK_TRACING_BUFFER_SIZE] = { 0 };
+    // Reading drains the trace points from the oldest one
+    zassert_equal(astarte_trace_read(events, 1), 1);
+    zassert_equal(events[0].stage, ASTARTE_TRACE_STAGE_TX_SEND);
+    zassert_true(events[0].begin);
+    zassert_equal(events[0].thread_id, (uintptr_t) k_current_get());
+
+    zassert_equal(astarte_trace_read(events, ARRAY_SIZE(events)), 2);
+    zassert_equal(events[0].stage, ASTARTE_TRACE_STAGE_TX_VALIDATION);
+    zassert_true(events[0].begin);
+    zassert_equal(events[1].stage, ASTARTE_TRACE_STAGE_TX_VALIDATION);
+    zassert_false(events[1].begin);
+    zassert_true(events[1].timestamp_us - events[0].timestamp_us < USEC_PER_SEC);
+
+    zassert_equal(astarte_trace_read(events, ARRAY_SIZE(events)), 0);
+    zassert_equal(astarte_trace_get_overwritten(), 0);
+}
+
+ZTEST(astarte_device_sdk_tracing, test_tracing_busy_stage)
+{
+    // The native_sim clock does not advance while the CPU is busy, the timestamps do
+    ASTARTE_TRACE_BEGIN(ASTARTE_TRACE_STAGE_TX_BSON_ENCODE);
+    uint64_t start = astarte_host_clock_get_us();
+    while (astarte_host_clock_get_us() - start < BUSY_STAGE_US) {
+        // Busy loop
+    }
+    ASTARTE_TRACE_END(ASTARTE_TRACE_STAGE_TX_BSON_ENCODE);
+
+    astarte_trace_event_t events[2] = { 0 };
+    zassert_equal(astarte_trace_read(events, ARRAY_SIZE(events)), 2);
+    zassert_true(events[1].timestamp_us - events[0].timestamp_us >= BUSY_STAGE_US);
+}
+
+ZTEST(astarte_device_sdk_tracing, test_tracing_overwrite)
+{
+    // The oldest trace points are overwritten when the ring buffer is full
+    for (int i = 0; i < ASTARTE_TRACE_STAGE_COUNT; i++) {
+        ASTARTE_TRACE_BEGIN((astarte_trace_stage_t) i);
+    }
+
+    astarte_trace_event_t events[CONFIG_ASTARTE_DEVICE_SDK_TRACING_BUFFER_SIZE + 1] = { 0 };
+    size_t read = astarte_trace_read(events, ARRAY_SIZE(events));
+    zassert_equal(read, CONFIG_ASTARTE_DEVICE_SDK_TRACING_BUFFER_SIZE);
+    zassert_equal(astarte_trace_get_overwritten(),
+        ASTARTE_TRACE_STAGE_COUNT - CONFIG_ASTARTE_DEVICE_SDK_TRACING_BUFFER_SIZE);
+    zassert_equal(events[0].stage,
+        ASTARTE_TRACE_STAGE_COUNT - CONFIG_ASTARTE_DEVICE_SDK_TRACING_BUFFER_SIZE);
+    zassert_equal(events[read - 1].stage, ASTARTE_TRACE_STAGE_RX_USER_CALLBACK);
+
+    astarte_trace_clear();
+    zassert_equal(astarte_trace_get_overwritten(), 0);
+}
+
+ZTEST(astarte_device_sdk_tracing, test_tracing_stage_names)
+{
+    zassert_str_equal(astarte_trace_stage_to_name(ASTARTE_TRACE_STAGE_TX_SEND), "TX_SEND");
+    zassert_str_equal(
+        astarte_trace_stage_to_name(ASTARTE_TRACE_STAGE_RX_USER_CALLBACK), "RX_USER_CALLBACK");
+    zassert_str_equal(astarte_trace_stage_to_name(ASTARTE_TRACE_STAGE_COUNT), "UNKNOWN");
+}
@@ -97,6 +97,31 @@ ZTEST(astarte_device_sdk_bson, test_bson_serializer_empty_document)
     astarte_bson_serializer_destroy(&bson);
 }
 
+ZTEST(astarte_device_sdk_bson, test_bson_serializer_detach)
+{
+    astarte_bson_serializer_t bson = { 0 };
+    zassert_equal(astarte_bson_serializer_init(&bson), ASTARTE_RESULT_OK, "Initialization failure");
+
+    astarte_bson_serializer_append_end_of_document(&bson);
+
+    const void *internal_buf = astarte_bson_serializer_get_serialized(bson, NULL);
+    size_t ser_bson_size = 0;
+    void *ser_bson = astarte_bson_serializer_detach(&bson, &ser_bson_size);
+
+    zassert_equal(internal_buf, ser_bson, "Detached buffer is not the serializer buffer");
+    zassert_equal(sizeof(serialized_bson_empty_document), ser_bson_size,
+        "serialized_bson_empty_document size != from expected ser_bson_size");
+    zassert_mem_equal(serialized_bson_empty_document, (const uint8_t *) ser_bson,
+        sizeof(serialized_bson_empty_document),
+        "serialized_bson_empty_document and ser_bson not have same contents");
+    zassert_is_null(bson.buf, "Serializer still references the detached buffer");
+    zassert_equal(bson.size, 0, "Serializer size has not been reset");
+
+    // Destroying the serializer after a detach should not affect the detached buffer
+    astarte_bson_serializer_destroy(&bson);
+    astarte_free(ser_bson);
+}
+
 ZTEST(astarte_device_sdk_bson, test_bson_serializer_complete_document)
 {
     astarte_bson_serializer_t bson = { 0 };
@@ -250,6 +250,69 @@ ZTEST(astarte_device_sdk_mapping, test_astarte_mapping_check_path_multiple_segme
     zassert_equal(res, ASTARTE_RESULT_MAPPING_PATH_MISMATCH, "Res:%s", astarte_result_to_name(res));
 }
 
+ZTEST(astarte_device_sdk_mapping, test_astarte_mapping_check_path_precomputed_matcher)
+{
+    astarte_result_t res = ASTARTE_RESULT_OK;
+    astarte_mapping_t mapping = {
+        .endpoint = "/%{first_param}/first_segment/%{second_param}/second_segment/%{third_param}",
+        .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
+        .explicit_timestamp = false,
+        .allow_unset = true,
+        .endpoint_segments = 5U,
+        .endpoint_parameters = 0x00000015U,
+    };
+
+    const char correct_path[] = "/sensor_42/first_segment/sens.or_11/second_segment/sensor_54";
+    zassert_equal(astarte_mapping_count_path_segments(correct_path), mapping.endpoint_segments);
+    res = astarte_mapping_check_path(mapping, correct_path);
+    zassert_equal(res, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(res));
+
+    const char mispelled_path[] = "/sensor_42/first_egment/sens.or_11/second_segment/sensor_54";
+    res = astarte_mapping_check_path(mapping, mispelled_path);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_PATH_MISMATCH, "Res:%s", astarte_result_to_name(res));
+
+    const char missing_third_param_path[] = "/sensor_42/first_segment/sens.or_11/second_segment";
+    zassert_not_equal(
+        astarte_mapping_count_path_segments(missing_third_param_path), mapping.endpoint_segments);
+    res = astarte_mapping_check_path(mapping, missing_third_param_path);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_PATH_MISMATCH, "Res:%s", astarte_result_to_name(res));
+
+    const char non_allowed_char_second_param_path[] = "/s42/first_segment/#s11/second_segment/s54";
+    res = astarte_mapping_check_path(mapping, non_allowed_char_second_param_path);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_PATH_MISMATCH, "Res:%s", astarte_result_to_name(res));
+}
+
+ZTEST(astarte_device_sdk_mapping, test_astarte_mapping_check_object_path)
+{
+    astarte_result_t res = ASTARTE_RESULT_OK;
+    astarte_mapping_t mapping = {
+        .endpoint = "/%{sensor_id}/first_segment/double_endpoint",
+        .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNIQUE,
+        .explicit_timestamp = false,
+        .allow_unset = false,
+    };
+
+    zassert_equal(strcmp(astarte_mapping_get_object_key(mapping), "double_endpoint"), 0);
+
+    const char correct_path[] = "/sensor_42/first_segment";
+    res = astarte_mapping_check_object_path(mapping, correct_path);
+    zassert_equal(res, ASTARTE_RESULT_OK, "Res:%s", astarte_result_to_name(res));
+
+    const char full_path[] = "/sensor_42/first_segment/double_endpoint";
+    res = astarte_mapping_check_object_path(mapping, full_path);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_PATH_MISMATCH, "Res:%s", astarte_result_to_name(res));
+
+    const char shorter_path[] = "/sensor_42";
+    res = astarte_mapping_check_object_path(mapping, shorter_path);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_PATH_MISMATCH, "Res:%s", astarte_result_to_name(res));
+
+    const char non_allowed_param_path[] = "/sensor#42/first_segment";
+    res = astarte_mapping_check_object_path(mapping, non_allowed_param_path);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_PATH_MISMATCH, "Res:%s", astarte_result_to_name(res));
+}
+
 ZTEST(astarte_device_sdk_mapping, test_astarte_mapping_check_data_double)
 {
     astarte_result_t res = ASTARTE_RESULT_OK;
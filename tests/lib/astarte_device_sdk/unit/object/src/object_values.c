@@ -0,0 +1,204 @@
+/*
+ * (C) Copyright 2024, SECO Mind Srl
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * @file astarte-device-sdk-zephyr/tests/lib/astarte_device_sdk/unit/object/src/object_values.c
+ *
+ * @details This test suite verifies that an object stored in the order of the interface mappings
+ * is validated and serialized as an object built from path and data entries. It also compares the
+ * time spent by the two approaches.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <zephyr/ztest.h>
+
+#include "astarte_device_sdk/object.h"
+#include "data_validation.h"
+#include "object_private.h"
+
+#include "bson_serializer.h"
+
+#define BENCHMARK_ITERATIONS 10000
+
+ZTEST_SUITE(astarte_device_sdk_object_values, NULL, NULL, NULL, NULL, NULL);
+
+static const astarte_mapping_t benchmark_mappings[3] = {
+    {
+        .endpoint = "/%{sensor_id}/double_endpoint",
+        .type = ASTARTE_MAPPING_TYPE_DOUBLE,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+        .explicit_timestamp = true,
+        .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
+    },
+    {
+        .endpoint = "/%{sensor_id}/integer_endpoint",
+        .type = ASTARTE_MAPPING_TYPE_INTEGER,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+        .explicit_timestamp = true,
+        .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
+    },
+    {
+        .endpoint = "/%{sensor_id}/stringarray_endpoint",
+        .type = ASTARTE_MAPPING_TYPE_STRINGARRAY,
+        .reliability = ASTARTE_MAPPING_RELIABILITY_UNRELIABLE,
+        .explicit_timestamp = true,
+        .allow_unset = false,
+        .endpoint_segments = 2U,
+        .endpoint_parameters = 0x00000001U,
+    },
+};
+
+static const astarte_interface_t benchmark_interface = {
+    .name = "org.astarteplatform.zephyr.test",
+    .major_version = 0,
+    .minor_version = 1,
+    .type = ASTARTE_INTERFACE_TYPE_DATASTREAM,
+    .ownership = ASTARTE_INTERFACE_OWNERSHIP_DEVICE,
+    .aggregation = ASTARTE_INTERFACE_AGGREGATION_OBJECT,
+    .mappings = benchmark_mappings,
+    .mappings_length = ARRAY_SIZE(benchmark_mappings),
+};
+
+static const char benchmark_path[] = "/sensor33";
+static const int64_t benchmark_timestamp = 1710940988328;
+static const char *benchmark_stringarray[] = { "hello", "world" };
+
+static void fill_values(astarte_data_t values[3])
+{
+    values[0] = astarte_data_from_double(32.1);
+    values[1] = astarte_data_from_integer(42);
+    values[2] = astarte_data_from_string_array(
+        benchmark_stringarray, ARRAY_SIZE(benchmark_stringarray));
+}
+
+static void fill_entries(astarte_object_entry_t entries[3])
+{
+    astarte_data_t values[3] = { 0 };
+    fill_values(values);
+    entries[0] = astarte_object_entry_new("double_endpoint", values[0]);
+    entries[1] = astarte_object_entry_new("integer_endpoint", values[1]);
+    entries[2] = astarte_object_entry_new("stringarray_endpoint", values[2]);
+}
+
+static astarte_result_t serialize_entries(astarte_object_entry_t *entries, size_t entries_len,
+    astarte_bson_serializer_t *bson)
+{
+    astarte_result_t ares = data_validation_aggregated_datastream(
+        &benchmark_interface, benchmark_path, entries, entries_len, &benchmark_timestamp);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+    ares = astarte_bson_serializer_init(bson);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+    ares = astarte_object_entries_serialize(bson, entries, entries_len);
+    astarte_bson_serializer_append_end_of_document(bson);
+    return ares;
+}
+
+static astarte_result_t serialize_values(
+    const astarte_data_t *values, astarte_bson_serializer_t *bson)
+{
+    astarte_result_t ares = data_validation_object_values(
+        &benchmark_interface, benchmark_path, values, &benchmark_timestamp);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+    ares = astarte_bson_serializer_init(bson);
+    if (ares != ASTARTE_RESULT_OK) {
+        return ares;
+    }
+    ares = astarte_object_values_serialize(bson, &benchmark_interface, values);
+    astarte_bson_serializer_append_end_of_document(bson);
+    return ares;
+}
+
+ZTEST(astarte_device_sdk_object_values, test_object_values_serialize_as_entries)
+{
+    astarte_object_entry_t entries[3] = { 0 };
+    astarte_data_t values[3] = { 0 };
+    astarte_bson_serializer_t entries_bson = { 0 };
+    astarte_bson_serializer_t values_bson = { 0 };
+    fill_entries(entries);
+    fill_values(values);
+
+    astarte_result_t res = serialize_entries(entries, ARRAY_SIZE(entries), &entries_bson);
+    zassert_equal(res, ASTARTE_RESULT_OK, "%s", astarte_result_to_name(res));
+    res = serialize_values(values, &values_bson);
+    zassert_equal(res, ASTARTE_RESULT_OK, "%s", astarte_result_to_name(res));
+
+    int entries_len = 0;
+    const void *entries_data = astarte_bson_serializer_get_serialized(entries_bson, &entries_len);
+    int values_len = 0;
+    const void *values_data = astarte_bson_serializer_get_serialized(values_bson, &values_len);
+    zassert_equal(entries_len, values_len);
+    zassert_mem_equal(entries_data, values_data, values_len);
+
+    astarte_bson_serializer_destroy(&entries_bson);
+    astarte_bson_serializer_destroy(&values_bson);
+}
+
+ZTEST(astarte_device_sdk_object_values, test_object_values_validation)
+{
+    astarte_data_t values[3] = { 0 };
+    fill_values(values);
+
+    astarte_result_t res = data_validation_object_values(
+        &benchmark_interface, benchmark_path, values, &benchmark_timestamp);
+    zassert_equal(res, ASTARTE_RESULT_OK, "%s", astarte_result_to_name(res));
+
+    res = data_validation_object_values(
+        &benchmark_interface, "/sensor33/double_endpoint", values, &benchmark_timestamp);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_NOT_IN_INTERFACE, "%s", astarte_result_to_name(res));
+
+    res = data_validation_object_values(&benchmark_interface, benchmark_path, values, NULL);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_EXPLICIT_TIMESTAMP_REQUIRED, "%s",
+        astarte_result_to_name(res));
+
+    values[1] = astarte_data_from_longinteger(42);
+    res = data_validation_object_values(
+        &benchmark_interface, benchmark_path, values, &benchmark_timestamp);
+    zassert_equal(res, ASTARTE_RESULT_MAPPING_DATA_INCOMPATIBLE, "%s", astarte_result_to_name(res));
+}
+
+ZTEST(astarte_device_sdk_object_values, test_object_values_benchmark)
+{
+    astarte_object_entry_t entries[3] = { 0 };
+    astarte_data_t values[3] = { 0 };
+    astarte_bson_serializer_t bson = { 0 };
+    fill_entries(entries);
+    fill_values(values);
+
+    clock_t start = clock();
+    for (size_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        astarte_result_t res = serialize_entries(entries, ARRAY_SIZE(entries), &bson);
+        astarte_bson_serializer_destroy(&bson);
+        zassert_equal(res, ASTARTE_RESULT_OK, "%s", astarte_result_to_name(res));
+    }
+    clock_t entries_ticks = clock() - start;
+
+    start = clock();
+    for (size_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        astarte_result_t res = serialize_values(values, &bson);
+        astarte_bson_serializer_destroy(&bson);
+        zassert_equal(res, ASTARTE_RESULT_OK, "%s", astarte_result_to_name(res));
+    }
+    clock_t values_ticks = clock() - start;
+
+    TC_PRINT("Object from entries: %lld us for %d iterations\n",
+        (long long) entries_ticks * 1000000 / CLOCKS_PER_SEC, BENCHMARK_ITERATIONS);
+    TC_PRINT("Object from values: %lld us for %d iterations\n",
+        (long long) values_ticks * 1000000 / CLOCKS_PER_SEC, BENCHMARK_ITERATIONS);
+}